@@ -0,0 +1,138 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2018 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Checks that the batched validity checks of GvlOmplPlannerHelper give
+ * the same results as checking the states one by one.
+ *
+ */
+//----------------------------------------------------------------------/*
+#include <iostream>
+using namespace std;
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+#define IC_PERFORMANCE_MONITOR
+#include <icl_core_performance_monitor/PerformanceMonitor.h>
+
+#include <ompl/util/RandomNumbers.h>
+
+#include "gvl_ompl_planner_helper.h"
+
+#include <cmath>
+#include <memory>
+
+namespace ob = ompl::base;
+
+int main(int argc, char **argv)
+{
+    icl_core::logging::initialize(argc, argv);
+
+    PERF_MON_INITIALIZE(100, 1000);
+
+    ompl::RNG::setSeed(42);
+
+    // the same state space as the planner example
+    auto space(std::make_shared<ob::RealVectorStateSpace>(6));
+    ob::RealVectorBounds bounds(6);
+    bounds.setLow(-3.14159265);
+    bounds.setHigh(3.14159265);
+    bounds.setHigh(1, 0.0);
+    space->setBounds(bounds);
+
+    auto si(std::make_shared<ob::SpaceInformation>(space));
+    std::shared_ptr<GvlOmplPlannerHelper> my_class_ptr(std::make_shared<GvlOmplPlannerHelper>(si));
+    si->setStateValidityChecker(my_class_ptr->getptr());
+    si->setMotionValidator(my_class_ptr->getptr());
+    si->setup();
+
+    my_class_ptr->moveObstacle();
+
+    bool error = false;
+
+    // areValid() has to agree with isValid() for every state
+    const size_t num_states = 600; // more than one chunk of swept volume bits
+    ob::StateSamplerPtr sampler = si->allocStateSampler();
+    std::vector<ob::State*> states(num_states);
+    std::vector<const ob::State*> const_states(num_states);
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        states[i] = si->allocState();
+        sampler->sampleUniform(states[i]);
+        const_states[i] = states[i];
+    }
+
+    std::vector<bool> valid;
+    my_class_ptr->areValid(const_states, valid);
+
+    size_t num_valid = 0;
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        const bool expected = my_class_ptr->isValid(states[i]);
+        num_valid += expected ? 1 : 0;
+        if (valid[i] != expected)
+        {
+            error = true;
+            std::cout << "Error! areValid() says " << valid[i] << " for state " << i << ", isValid() says " << expected << std::endl;
+        }
+    }
+    std::cout << num_valid << " of " << num_states << " states are valid." << std::endl;
+
+    // checkMotion() has to report the fraction of the last state which isValid() accepts
+    ob::State *last_valid_state = si->allocState();
+    ob::State *test = si->allocState();
+    for (size_t i = 0; i + 1 < num_states; ++i)
+    {
+        if (!my_class_ptr->isValid(states[i]))
+        {
+            continue;
+        }
+        const ob::State *s1 = states[i];
+        const ob::State *s2 = states[i + 1];
+
+        const int nd = space->validSegmentCount(s1, s2);
+        bool expected_result = true;
+        double expected_fraction = 0.0;
+        for (int j = 1; j <= nd; ++j)
+        {
+            space->interpolate(s1, s2, (double)j / (double)nd, test);
+            if (!my_class_ptr->isValid(test))
+            {
+                expected_result = false;
+                expected_fraction = (double)(j - 1) / (double)nd;
+                break;
+            }
+        }
+
+        std::pair<ob::State*, double> last_valid(last_valid_state, -1.0);
+        const bool result = my_class_ptr->checkMotion(s1, s2, last_valid);
+        if (result != expected_result || (!result && std::fabs(last_valid.second - expected_fraction) > 1e-9))
+        {
+            error = true;
+            std::cout << "Error! checkMotion() from state " << i << " returned " << result << " with last valid fraction "
+                      << last_valid.second << ", expected " << expected_result << " with " << expected_fraction << std::endl;
+        }
+    }
+    si->freeState(test);
+    si->freeState(last_valid_state);
+
+    for (size_t i = 0; i < num_states; ++i)
+    {
+        si->freeState(states[i]);
+    }
+
+    std::cout << (error ? "Batch check test finished with ERRORS" : "Batch check test finished") << std::endl;
+    return error ? 1 : 0;
+}
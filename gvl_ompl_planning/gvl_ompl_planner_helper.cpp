@@ -30,6 +30,7 @@
 #include <gpu_voxels/robot/urdf_robot/urdf_robot.h>
 #include <gpu_voxels/logging/logging_gpu_voxels.h>
 #include <thread>
+#include <algorithm>
 
 #define IC_PERFORMANCE_MONITOR
 #include <icl_core_performance_monitor/PerformanceMonitor.h>
@@ -39,6 +40,20 @@ namespace og = ompl::geometric;
 using namespace gpu_voxels;
 namespace bfs = boost::filesystem;
 
+namespace {
+
+// occupancy threshold of all collision checks, as fraction of the range from MIN_PROBABILITY to MAX_PROBABILITY
+const float cCOLLISION_THRESHOLD = 1.0f;
+
+// ProbVoxelMap::collideWith() scales its threshold to the occupancy range like DefaultCollider,
+// while the voxellists compare the occupancy with the threshold directly
+float toOccupancy(const float threshold)
+{
+    return float(Probability(threshold * (float(MAX_PROBABILITY) - float(MIN_PROBABILITY)) + float(MIN_PROBABILITY)));
+}
+
+} // end of anonymous namespace
+
 GvlOmplPlannerHelper::GvlOmplPlannerHelper(const ob::SpaceInformationPtr &si)
     : ob::StateValidityChecker(si)
     , ob::MotionValidator(si)
@@ -56,6 +71,7 @@ GvlOmplPlannerHelper::GvlOmplPlannerHelper(const ob::SpaceInformationPtr &si)
     gvl->addMap(MT_PROBAB_VOXELMAP,"myEnvironmentMap");
     gvl->addMap(MT_BITVECTOR_VOXELLIST,"mySolutionMap");
     gvl->addMap(MT_PROBAB_VOXELMAP,"myQueryMap");
+    gvl->addMap(MT_BITVECTOR_VOXELLIST,"myRobotBatchList");
 
     gvl->addRobot("myUrdfRobot", "ur10_coarse/ur10_joint_limited_robot.urdf", true);
 
@@ -64,6 +80,7 @@ GvlOmplPlannerHelper::GvlOmplPlannerHelper(const ob::SpaceInformationPtr &si)
     PERF_MON_ENABLE("pose_check");
     PERF_MON_ENABLE("motion_check");
     PERF_MON_ENABLE("motion_check_lv");
+    PERF_MON_ENABLE("batch_check");
 }
 
 
@@ -106,6 +123,7 @@ void GvlOmplPlannerHelper::visualizeSolution(ob::PathPtr path)
     PERF_MON_SUMMARY_PREFIX_INFO("pose_check");
     PERF_MON_SUMMARY_PREFIX_INFO("motion_check");
     PERF_MON_SUMMARY_PREFIX_INFO("motion_check_lv");
+    PERF_MON_SUMMARY_PREFIX_INFO("batch_check");
 
     std::cout << "Robot consists of " << gvl->getRobot("myUrdfRobot")->getTransformedClouds()->getAccumulatedPointcloudSize() << " points" << std::endl;
 
@@ -193,7 +211,7 @@ bool GvlOmplPlannerHelper::isValid(const ompl::base::State *state) const
     PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("insert", "Pose Insertion", "pose_check");
 
     PERF_MON_START("coll_test");
-    size_t num_colls_pc = gvl->getMap("myRobotMap")->as<voxelmap::ProbVoxelMap>()->collideWith(gvl->getMap("myEnvironmentMap")->as<voxelmap::ProbVoxelMap>());
+    size_t num_colls_pc = gvl->getMap("myRobotMap")->as<voxelmap::ProbVoxelMap>()->collideWith(gvl->getMap("myEnvironmentMap")->as<voxelmap::ProbVoxelMap>(), cCOLLISION_THRESHOLD);
     PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("coll_test", "Pose Collsion", "pose_check");
 
     //std::cout << "Validity check on state ["  << values[0] << ", " << values[1] << ", " << values[2] << ", " << values[3] << ", " << values[4] << ", " << values[5] << "] resulting in " <<  num_colls_pc << " colls." << std::endl;
@@ -211,7 +229,6 @@ bool GvlOmplPlannerHelper::checkMotion(const ompl::base::State *s1, const ompl::
 
 
     std::lock_guard<std::mutex> lock(g_j_mutex);
-    gvl->clearMap("myRobotMap");
 
     /* assume motion starts in a valid configuration so s1 is valid */
 
@@ -221,38 +238,38 @@ bool GvlOmplPlannerHelper::checkMotion(const ompl::base::State *s1, const ompl::
     //std::cout << "Called interpolating motion_check_lv to evaluate " << nd << " segments" << std::endl;
 
     PERF_MON_ADD_DATA_NONTIME_P("Num poses in motion", float(nd), "motion_check_lv");
-    if (nd > 1)
+
+    /* all interpolated states and s2 are checked in one batch */
+    std::vector<ob::State*> test_states;
+    std::vector<const ob::State*> batch;
+    for (int j = 1; j < nd; ++j)
     {
-        /* temporary storage for the checked state */
         ob::State *test = si_->allocState();
-
-        for (int j = 1; j < nd; ++j)
-        {
-            stateSpace_->interpolate(s1, s2, (double)j / (double)nd, test);
-            if (!si_->isValid(test))
-
-            {
-                lastValid.second = (double)(j - 1) / (double)nd;
-                if (lastValid.first != nullptr)
-                    stateSpace_->interpolate(s1, s2, lastValid.second, lastValid.first);
-                result = false;
-                break;
-
-            }
-        }
-
-        si_->freeState(test);
-
+        stateSpace_->interpolate(s1, s2, (double)j / (double)nd, test);
+        test_states.push_back(test);
+        batch.push_back(test);
     }
+    batch.push_back(s2);
 
-    if (result)
-        if (!si_->isValid(s2))
+    std::vector<bool> valid;
+    areValid(batch, valid);
+
+    for (size_t i = 0; i < valid.size(); ++i)
+    {
+        if (!valid[i])
         {
-            lastValid.second = (double)(nd - 1) / (double)nd;
+            lastValid.second = (double)i / (double)nd;
             if (lastValid.first != nullptr)
                 stateSpace_->interpolate(s1, s2, lastValid.second, lastValid.first);
             result = false;
+            break;
         }
+    }
+
+    for (size_t i = 0; i < test_states.size(); ++i)
+    {
+        si_->freeState(test_states[i]);
+    }
 
 
     if (result)
@@ -324,7 +341,7 @@ bool GvlOmplPlannerHelper::checkMotion(const ompl::base::State *s1, const ompl::
 
         //gvl->visualizeMap("myRobotMap");
         PERF_MON_START("coll_test");
-        size_t num_colls_pc = gvl->getMap("myRobotMap")->as<voxelmap::ProbVoxelMap>()->collideWith(gvl->getMap("myEnvironmentMap")->as<voxelmap::ProbVoxelMap>());
+        size_t num_colls_pc = gvl->getMap("myRobotMap")->as<voxelmap::ProbVoxelMap>()->collideWith(gvl->getMap("myEnvironmentMap")->as<voxelmap::ProbVoxelMap>(), cCOLLISION_THRESHOLD);
         //std::cout << "CheckMotion1 for " << nd << " segments. Resulting in " << num_colls_pc << " colls." << std::endl;
         PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("coll_test", "Pose Collsion", "motion_check");
 
@@ -343,3 +360,54 @@ bool GvlOmplPlannerHelper::checkMotion(const ompl::base::State *s1, const ompl::
 
 
 }
+
+void GvlOmplPlannerHelper::areValid(const std::vector<const ompl::base::State*> &states, std::vector<bool> &valid) const
+{
+    std::lock_guard<std::mutex> lock(g_i_mutex);
+
+    valid.assign(states.size(), true);
+
+    // every state of a chunk gets its own swept volume bit
+    const size_t chunk_size = eBVM_SWEPT_VOLUME_END - eBVM_SWEPT_VOLUME_START;
+
+    voxellist::BitVectorVoxelList* robot_list = gvl->getMap("myRobotBatchList")->as<voxellist::BitVectorVoxelList>();
+    voxelmap::ProbVoxelMap* env_map = gvl->getMap("myEnvironmentMap")->as<voxelmap::ProbVoxelMap>();
+
+    for (size_t chunk_start = 0; chunk_start < states.size(); chunk_start += chunk_size)
+    {
+        const size_t chunk_end = std::min(states.size(), chunk_start + chunk_size);
+
+        PERF_MON_START("inserting");
+        gvl->clearMap("myRobotBatchList");
+
+        for (size_t i = chunk_start; i < chunk_end; ++i)
+        {
+            const double *values = states[i]->as<ob::RealVectorStateSpace::StateType>()->values;
+
+            robot::JointValueMap state_joint_values;
+            state_joint_values["shoulder_pan_joint"] = values[0];
+            state_joint_values["shoulder_lift_joint"] = values[1];
+            state_joint_values["elbow_joint"] = values[2];
+            state_joint_values["wrist_1_joint"] = values[3];
+            state_joint_values["wrist_2_joint"] = values[4];
+            state_joint_values["wrist_3_joint"] = values[5];
+
+            // update the robot joints:
+            gvl->setRobotConfiguration("myUrdfRobot", state_joint_values);
+            // insert the robot into the list, tagged with the index of the state in this chunk:
+            gvl->insertRobotIntoMap("myUrdfRobot", "myRobotBatchList", BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + (i - chunk_start)));
+        }
+        PERF_MON_ADD_DATA_NONTIME_P("Num poses in batch", float(chunk_end - chunk_start), "batch_check");
+        PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("insert", "Batch Insertion", "batch_check");
+
+        PERF_MON_START("coll_test");
+        BitVectorVoxel colliding_states;
+        robot_list->collideWithTypes(env_map, colliding_states, toOccupancy(cCOLLISION_THRESHOLD));
+        PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("coll_test", "Batch Collision", "batch_check");
+
+        for (size_t i = chunk_start; i < chunk_end; ++i)
+        {
+            valid[i] = !colliding_states.bitVector().getBit(eBVM_SWEPT_VOLUME_START + (i - chunk_start));
+        }
+    }
+}
@@ -47,6 +47,16 @@ public:
                              std::pair< ompl::base::State*, double > & lastValid) const;
     virtual bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const;
 
+    /*!
+     * \brief areValid Checks a batch of states with a single map clear and collision check.
+     * Every state is inserted into a bitvector voxellist with its own swept volume bit,
+     * so that the colliding bits identify the colliding states. The same occupancy threshold as
+     * in isValid() is used.
+     * \param states The states to check
+     * \param valid Resized to the number of states. Entry i is true if states[i] is collision free.
+     */
+    void areValid(const std::vector<const ompl::base::State*> &states, std::vector<bool> &valid) const;
+
     void plan();
 
     std::shared_ptr<GvlOmplPlannerHelper> getptr() {
@@ -0,0 +1,130 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program measures the distance transforms of the DistanceVoxelMap
+* with the obstacle encoding the library was built with. Build it with
+* and without GVL_DISTANCE_VOXEL_64BIT to compare the 32 bit and the
+* 64 bit DistanceVoxels. The program reports the voxel size and the
+* number of voxels per second of the parallel banding algorithm, the
+* jump flooding algorithm and the distance extraction.
+*
+* Usage: distance_encoding_benchmark [-r repetitions] [-s map side]
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <thrust/device_vector.h>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/voxelmap/DistanceVoxelMap.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxelmap::DistanceVoxelMap;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+void printThroughput(const char* name, const size_t num_voxels, const double ms)
+{
+  std::cout << name << ": " << ms << " ms, " << num_voxels / (ms * 1e-3) << " voxels/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 10;
+  int map_side = 256;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      // the parallel banding algorithm needs multiples of 64
+      map_side = std::max(64, atoi(argv[++i]) / 64 * 64);
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r repetitions] [-s map side]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "DistanceVoxel: " << sizeof(DistanceVoxel) << " bytes, " << PBA_COORD_BITS
+            << " bits per coordinate, up to " << PBA_UNINITIALISED_COORD << " voxels per axis" << std::endl;
+  if (uint32_t(map_side) >= uint32_t(PBA_UNINITIALISED_COORD))
+  {
+    std::cout << "The map side exceeds the encoding, build with GVL_DISTANCE_VOXEL_64BIT" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.01f;
+  const float side = map_side * voxel_side_length;
+  const size_t num_voxels = size_t(map_side) * map_side * map_side;
+  GpuVoxelsSharedPtr gvl = GpuVoxels::getInstance();
+  gvl->initialize(map_side, map_side, map_side, voxel_side_length);
+  gvl->addMap(MT_DISTANCE_VOXELMAP, "distances");
+  DistanceVoxelMap* dist_map = gvl->getMap("distances")->as<DistanceVoxelMap>();
+
+  srand(42);
+  std::vector<Vector3f> obstacles;
+  for (int i = 0; i < 1000; ++i)
+  {
+    obstacles.push_back(Vector3f(randomCoordinate(side), randomCoordinate(side), randomCoordinate(side)));
+  }
+
+  thrust::device_vector<voxelmap::free_space_t> dev_distances(num_voxels);
+  double pba_ms = 0.0;
+  double jfa_ms = 0.0;
+  double extract_ms = 0.0;
+  for (int r = 0; r < repetitions; ++r)
+  {
+    dist_map->clearMap();
+    dist_map->insertPointCloud(obstacles, eBVM_OCCUPIED);
+    icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    dist_map->parallelBanding3D();
+    pba_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    start = icl_core::TimeStamp::now();
+    dist_map->extract_distances(thrust::raw_pointer_cast(dev_distances.data()), 0);
+    extract_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    dist_map->clearMap();
+    dist_map->insertPointCloud(obstacles, eBVM_OCCUPIED);
+    start = icl_core::TimeStamp::now();
+    dist_map->jumpFlood3D();
+    jfa_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+  }
+  printThroughput("parallel banding", num_voxels, pba_ms / repetitions);
+  printThroughput("jump flooding", num_voxels, jfa_ms / repetitions);
+  printThroughput("distance extraction", num_voxels, extract_ms / repetitions);
+
+  gvl.reset();
+  return EXIT_SUCCESS;
+}
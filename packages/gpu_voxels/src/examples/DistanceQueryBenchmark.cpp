@@ -0,0 +1,154 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program measures the throughput of the batched distance queries
+* of the DistanceVoxelMap. It compares the single voxel queries with the
+* batched queries on the device and on the host mirror and reports the
+* number of queries per second.
+*
+* Usage: distance_query_benchmark [-r repetitions] [-n points] [-s map side]
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <thrust/device_vector.h>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/voxelmap/DistanceVoxelMap.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxelmap::DistanceVoxelMap;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+void printThroughput(const char* name, const size_t num_queries, const double ms)
+{
+  std::cout << name << ": " << ms << " ms, " << num_queries / (ms * 1e-3) << " queries/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 10;
+  int num_points = 500000;
+  int map_side = 128;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      num_points = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      // the parallel banding algorithm needs multiples of 64
+      map_side = std::max(64, atoi(argv[++i]) / 64 * 64);
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r repetitions] [-n points] [-s map side]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.01f;
+  const float side = map_side * voxel_side_length;
+  GpuVoxelsSharedPtr gvl = GpuVoxels::getInstance();
+  gvl->initialize(map_side, map_side, map_side, voxel_side_length);
+  gvl->addMap(MT_DISTANCE_VOXELMAP, "distances");
+  DistanceVoxelMap* dist_map = gvl->getMap("distances")->as<DistanceVoxelMap>();
+
+  srand(42);
+  std::vector<Vector3f> obstacles;
+  for (int i = 0; i < 200; ++i)
+  {
+    obstacles.push_back(Vector3f(randomCoordinate(side), randomCoordinate(side), randomCoordinate(side)));
+  }
+  dist_map->insertPointCloud(obstacles, eBVM_OCCUPIED);
+  dist_map->parallelBanding3D();
+
+  std::vector<Vector3f> points(num_points);
+  for (int i = 0; i < num_points; ++i)
+  {
+    points[i] = Vector3f(randomCoordinate(side), randomCoordinate(side), randomCoordinate(side));
+  }
+
+  // single voxel queries copy one voxel per call, so only a fraction of the points is used
+  const int num_single = std::min(num_points, 10000);
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  for (int i = 0; i < num_single; ++i)
+  {
+    dist_map->getObstacleDistance(Vector3ui(points[i].x / voxel_side_length, points[i].y / voxel_side_length,
+                                            points[i].z / voxel_side_length));
+  }
+  printThroughput("single voxel queries", num_single, (icl_core::TimeStamp::now() - start).toNSec() * 1e-6);
+
+  std::vector<float> distances;
+  std::vector<float> interpolated_distances;
+  std::vector<Vector3f> gradients;
+  double batch_ms = 0.0;
+  double full_ms = 0.0;
+  double device_ms = 0.0;
+  double host_ms = 0.0;
+  thrust::device_vector<Vector3f> dev_points(points.begin(), points.end());
+  thrust::device_vector<float> dev_distances(num_points);
+  thrust::device_vector<float> dev_interpolated_distances(num_points);
+  thrust::device_vector<Vector3f> dev_gradients(num_points);
+  dist_map->updateHostMirror();
+  for (int r = 0; r < repetitions; ++r)
+  {
+    start = icl_core::TimeStamp::now();
+    dist_map->queryObstacleDistances(points, &distances);
+    batch_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    start = icl_core::TimeStamp::now();
+    dist_map->queryObstacleDistances(points, &distances, &interpolated_distances, &gradients);
+    full_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    start = icl_core::TimeStamp::now();
+    dist_map->queryObstacleDistancesOnDevice(thrust::raw_pointer_cast(dev_points.data()), num_points,
+                                             thrust::raw_pointer_cast(dev_distances.data()),
+                                             thrust::raw_pointer_cast(dev_interpolated_distances.data()),
+                                             thrust::raw_pointer_cast(dev_gradients.data()));
+    device_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    start = icl_core::TimeStamp::now();
+    dist_map->queryObstacleDistancesOnHost(points, &distances, &interpolated_distances, &gradients);
+    host_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+  }
+  printThroughput("batched distances", num_points, batch_ms / repetitions);
+  printThroughput("batched distances, interpolation and gradients", num_points, full_ms / repetitions);
+  printThroughput("device memory distances, interpolation and gradients", num_points, device_ms / repetitions);
+  printThroughput("host mirror distances, interpolation and gradients", num_points, host_ms / repetitions);
+
+  gvl.reset();
+  return EXIT_SUCCESS;
+}
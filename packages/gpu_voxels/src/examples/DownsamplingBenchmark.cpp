@@ -0,0 +1,216 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program compares the insertion of dense point clouds with and
+* without the voxel grid downsampling. The clouds are depth frames of
+* a wall, so many points fall into the same voxel. Each cloud is
+* inserted into a voxelmap, a probabilistic voxelmap, a voxellist and,
+* on the device, a counting voxellist. The program reports the average
+* insertion times and whether both variants deliver the same voxels.
+*
+* Usage: downsampling_benchmark [-r repetitions] [-n points per frame] [-v voxel side length] [-h]
+*   -h  use the host backend instead of the device backend
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxelmap::BitVectorVoxelMap;
+using gpu_voxels::voxelmap::ProbVoxelMap;
+using gpu_voxels::voxellist::BitVectorVoxelList;
+using gpu_voxels::voxellist::CountingVoxelList;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+//! A frame of a camera that looks along the x axis onto a slightly uneven wall
+std::vector<Vector3f> createFrame(const size_t num_points, const float side)
+{
+  std::vector<Vector3f> frame(num_points);
+  for (size_t i = 0; i < num_points; ++i)
+  {
+    frame[i] = Vector3f(side * 0.5f + randomCoordinate(side * 0.05f), side * 0.1f + randomCoordinate(side * 0.8f),
+                        side * 0.1f + randomCoordinate(side * 0.8f));
+  }
+  return frame;
+}
+
+template<class Map>
+Map* createMap(const Vector3ui& map_dim, const float voxel_side_length, const MapType map_type, const MapBackend backend)
+{
+  return new Map(map_dim, voxel_side_length, map_type, backend);
+}
+
+//! Counting voxellists only exist on the device
+template<>
+CountingVoxelList* createMap<CountingVoxelList>(const Vector3ui& map_dim, const float voxel_side_length,
+                                                const MapType map_type, const MapBackend backend)
+{
+  return new CountingVoxelList(map_dim, voxel_side_length, map_type);
+}
+
+//! Returns the average time of \a repetitions insertions of \a cloud into new maps of type \a Map in ms
+template<class Map>
+double timeInsertion(const Vector3ui& map_dim, const float voxel_side_length, const MapType map_type,
+                     const MapBackend backend, const std::vector<Vector3f>& cloud, const bool downsample,
+                     const int repetitions, Map** result)
+{
+  double total_ms = 0.0;
+  for (int r = 0; r < repetitions; ++r)
+  {
+    Map* map = createMap<Map>(map_dim, voxel_side_length, map_type, backend);
+    icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    if (downsample)
+    {
+      map->insertDownsampledPointCloud(cloud, eBVM_OCCUPIED);
+    }
+    else
+    {
+      map->insertPointCloud(cloud, eBVM_OCCUPIED);
+    }
+    total_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+    if (r + 1 < repetitions)
+    {
+      delete map;
+    }
+    else
+    {
+      *result = map;
+    }
+  }
+  return total_ms / repetitions;
+}
+
+void printTimes(const char* name, const double raw_ms, const double downsampled_ms)
+{
+  std::cout << "  " << name << ": all points " << raw_ms << " ms, downsampled " << downsampled_ms
+            << " ms, speedup " << raw_ms / downsampled_ms << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 10;
+  int num_points = 640 * 480;
+  float voxel_side_length = 0.02f;
+  MapBackend backend = MB_DEVICE;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      num_points = std::max(1000, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc)
+    {
+      voxel_side_length = std::max(0.001f, float(atof(argv[++i])));
+    }
+    else if (strcmp(argv[i], "-h") == 0)
+    {
+      backend = MB_HOST;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r repetitions] [-n points per frame] [-v voxel side length] [-h]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float side = 4.0f;
+  const uint32_t map_side = uint32_t(side / voxel_side_length);
+  const Vector3ui map_dim(map_side, map_side, map_side);
+  srand(42);
+  const std::vector<Vector3f> cloud = createFrame(num_points, side);
+
+  BitVectorVoxelMap* map = NULL;
+  BitVectorVoxelMap* downsampled_map = NULL;
+  const double map_ms = timeInsertion(map_dim, voxel_side_length, MT_BITVECTOR_VOXELMAP, backend, cloud, false,
+                                      repetitions, &map);
+  const double downsampled_map_ms = timeInsertion(map_dim, voxel_side_length, MT_BITVECTOR_VOXELMAP, backend, cloud,
+                                                  true, repetitions, &downsampled_map);
+
+  ProbVoxelMap* prob_map = NULL;
+  ProbVoxelMap* downsampled_prob_map = NULL;
+  const double prob_map_ms = timeInsertion(map_dim, voxel_side_length, MT_PROBAB_VOXELMAP, backend, cloud, false,
+                                           repetitions, &prob_map);
+  const double downsampled_prob_map_ms = timeInsertion(map_dim, voxel_side_length, MT_PROBAB_VOXELMAP, backend, cloud,
+                                                       true, repetitions, &downsampled_prob_map);
+
+  BitVectorVoxelList* list = NULL;
+  BitVectorVoxelList* downsampled_list = NULL;
+  const double list_ms = timeInsertion(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, backend, cloud, false,
+                                       repetitions, &list);
+  const double downsampled_list_ms = timeInsertion(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, backend, cloud,
+                                                   true, repetitions, &downsampled_list);
+
+  CountingVoxelList* counting_list = NULL;
+  CountingVoxelList* downsampled_counting_list = NULL;
+  double counting_list_ms = 0.0;
+  double downsampled_counting_list_ms = 0.0;
+  if (backend == MB_DEVICE)
+  {
+    counting_list_ms = timeInsertion(map_dim, voxel_side_length, MT_COUNTING_VOXELLIST, backend, cloud, false,
+                                     repetitions, &counting_list);
+    downsampled_counting_list_ms = timeInsertion(map_dim, voxel_side_length, MT_COUNTING_VOXELLIST, backend, cloud,
+                                                 true, repetitions, &downsampled_counting_list);
+  }
+
+  // every voxel of the lists has to be occupied in all maps
+  const size_t num_voxels = list->getDimensions().x;
+  bool equal = downsampled_list->equals(*list);
+  equal &= !downsampled_counting_list || downsampled_counting_list->getDimensions().x == num_voxels;
+  equal &= list->collideWith(map) == num_voxels && list->collideWith(downsampled_map) == num_voxels;
+  equal &= list->collideWith(prob_map, 0.1f) == num_voxels && list->collideWith(downsampled_prob_map, 0.1f) == num_voxels;
+
+  std::cout << num_points << " points in " << num_voxels << " voxels of " << map_side << "^3 on the "
+            << (backend == MB_HOST ? "host" : "device") << ", " << float(num_points) / num_voxels
+            << " points per voxel" << std::endl;
+  printTimes("voxelmap", map_ms, downsampled_map_ms);
+  printTimes("probabilistic voxelmap", prob_map_ms, downsampled_prob_map_ms);
+  printTimes("voxellist", list_ms, downsampled_list_ms);
+  if (backend == MB_DEVICE)
+  {
+    printTimes("counting voxellist", counting_list_ms, downsampled_counting_list_ms);
+  }
+  std::cout << (equal ? "All results are equal" : "RESULTS DIFFER") << std::endl;
+
+  delete map;
+  delete downsampled_map;
+  delete prob_map;
+  delete downsampled_prob_map;
+  delete list;
+  delete downsampled_list;
+  delete counting_list;
+  delete downsampled_counting_list;
+
+  return equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
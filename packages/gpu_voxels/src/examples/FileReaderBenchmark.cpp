@@ -0,0 +1,169 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program compares the memory mapped pointcloud file readers,
+* which are used by the PointcloudFileHandler, with the stream based
+* readers. It loads every given file with both readers and reports
+* the average load times and whether both readers returned the same points.
+*
+* Usage: file_reader_benchmark [-r repetitions] file1.xyz file2.pcd file3.binvox ...
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/helpers/BinvoxFileReader.h>
+#include <gpu_voxels/helpers/XyzFileReader.h>
+#include <gpu_voxels/helpers/MappedBinvoxFileReader.h>
+#include <gpu_voxels/helpers/MappedPcdFileReader.h>
+#include <gpu_voxels/helpers/MappedXyzFileReader.h>
+#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
+  #include <gpu_voxels/helpers/PcdFileReader.h>
+#endif
+
+using namespace gpu_voxels;
+using namespace gpu_voxels::file_handling;
+
+/*!
+ * \brief timeReader Loads \a filename \a repetitions times
+ * \return average load time in ms, or a negative value if reading failed
+ */
+double timeReader(FileReaderInterface& reader, const std::string& filename, const int repetitions,
+                  std::vector<Vector3f>& points)
+{
+  double total_ms = 0.0;
+  for (int i = 0; i < repetitions; ++i)
+  {
+    points.clear();
+    icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    if (!reader.readPointCloud(filename, points))
+    {
+      return -1.0;
+    }
+    total_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+  }
+  return total_ms / repetitions;
+}
+
+bool equalPoints(const std::vector<Vector3f>& a, const std::vector<Vector3f>& b)
+{
+  if (a.size() != b.size())
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    // compare bitwise, so that NaN points of PCD files compare equal
+    if (memcmp(&a[i], &b[i], sizeof(Vector3f)) != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 5;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else
+    {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty())
+  {
+    std::cout << "Usage: " << argv[0] << " [-r repetitions] file1.xyz file2.pcd file3.binvox ..." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  XyzFileReader xyz_reader;
+  BinvoxFileReader binvox_reader;
+  MappedXyzFileReader mapped_xyz_reader;
+  MappedPcdFileReader mapped_pcd_reader;
+  MappedBinvoxFileReader mapped_binvox_reader;
+#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
+  PcdFileReader pcd_reader;
+#endif
+
+  bool all_equal = true;
+  for (std::size_t f = 0; f < files.size(); ++f)
+  {
+    const std::string& filename = files[f];
+    FileReaderInterface* reader = NULL;
+    FileReaderInterface* mapped_reader = NULL;
+    if (filename.find("xyz") != std::string::npos)
+    {
+      reader = &xyz_reader;
+      mapped_reader = &mapped_xyz_reader;
+    }
+    else if (filename.find("pcd") != std::string::npos)
+    {
+#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
+      reader = &pcd_reader;
+#endif
+      mapped_reader = &mapped_pcd_reader;
+    }
+    else if (filename.find("binvox") != std::string::npos)
+    {
+      reader = &binvox_reader;
+      mapped_reader = &mapped_binvox_reader;
+    }
+    else
+    {
+      std::cout << filename << ": unknown file format, skipping" << std::endl;
+      continue;
+    }
+
+    std::vector<Vector3f> points;
+    std::vector<Vector3f> mapped_points;
+    const double mapped_ms = timeReader(*mapped_reader, filename, repetitions, mapped_points);
+    if (mapped_ms < 0.0)
+    {
+      std::cout << filename << ": mapped reader failed" << std::endl;
+      all_equal = false;
+      continue;
+    }
+    std::cout << filename << ": " << mapped_points.size() << " points, mapped reader " << mapped_ms << " ms";
+    if (reader)
+    {
+      const double ms = timeReader(*reader, filename, repetitions, points);
+      const bool equal = ms >= 0.0 && equalPoints(points, mapped_points);
+      all_equal = all_equal && equal;
+      std::cout << ", stream reader " << ms << " ms, speedup " << ms / mapped_ms
+                << (equal ? ", equal points" : ", POINTS DIFFER");
+    }
+    else
+    {
+      std::cout << ", no stream reader (built without PCL)";
+    }
+    std::cout << std::endl;
+  }
+  return all_equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
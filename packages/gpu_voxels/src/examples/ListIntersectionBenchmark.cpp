@@ -0,0 +1,141 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program measures the collision of two voxellists, which
+* intersects their sorted keys. A big list is collided with small lists
+* of size ratios from 1:1 to 1:10^4, in both directions and with and
+* without the colliding types. The program reports the average times
+* on the device and on the host and whether both backends deliver the
+* same results.
+*
+* Usage: list_intersection_benchmark [-r repetitions] [-n voxels of the big list] [-s map side]
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxellist::BitVectorVoxelList;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+std::vector<Vector3f> randomCloud(const size_t num_points, const float side)
+{
+  std::vector<Vector3f> cloud(num_points);
+  for (size_t i = 0; i < num_points; ++i)
+  {
+    cloud[i] = Vector3f(randomCoordinate(side), randomCoordinate(side), randomCoordinate(side));
+  }
+  return cloud;
+}
+
+//! Returns the average time of \a repetitions calls of \a this_list->collideWith(other_list) in ms
+double timeCollision(BitVectorVoxelList* this_list, BitVectorVoxelList* other_list, const int repetitions,
+                     const bool with_types, size_t* num_collisions, BitVectorVoxel* types)
+{
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  for (int r = 0; r < repetitions; ++r)
+  {
+    *num_collisions = with_types ? this_list->collideWithTypes(other_list, *types) : this_list->collideWith(other_list);
+  }
+  return (icl_core::TimeStamp::now() - start).toNSec() * 1e-6 / repetitions;
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 20;
+  int num_voxels = 1000000;
+  int map_side = 256;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      num_voxels = std::max(10000, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      map_side = std::max(64, atoi(argv[++i]));
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r repetitions] [-n voxels of the big list] [-s map side]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.01f;
+  const float side = map_side * voxel_side_length;
+  const Vector3ui map_dim(map_side, map_side, map_side);
+  srand(42);
+
+  const std::vector<Vector3f> big_cloud = randomCloud(num_voxels, side);
+  BitVectorVoxelList big_list(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST);
+  BitVectorVoxelList host_big_list(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+  big_list.insertPointCloud(big_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+  host_big_list.insertPointCloud(big_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+
+  bool equal = true;
+  for (int ratio = 1; ratio <= 10000; ratio *= 10)
+  {
+    const std::vector<Vector3f> small_cloud = randomCloud(std::max(1, num_voxels / ratio), side);
+    BitVectorVoxelList small_list(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList host_small_list(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    small_list.insertPointCloud(small_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+    host_small_list.insertPointCloud(small_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+
+    for (int with_types = 0; with_types < 2; ++with_types)
+    {
+      size_t num_collisions[4];
+      BitVectorVoxel types[4];
+      const double big_ms = timeCollision(&big_list, &small_list, repetitions, with_types, &num_collisions[0], &types[0]);
+      const double small_ms = timeCollision(&small_list, &big_list, repetitions, with_types, &num_collisions[1], &types[1]);
+      const double host_big_ms = timeCollision(&host_big_list, &host_small_list, repetitions, with_types,
+                                               &num_collisions[2], &types[2]);
+      const double host_small_ms = timeCollision(&host_small_list, &host_big_list, repetitions, with_types,
+                                                 &num_collisions[3], &types[3]);
+      for (int i = 1; i < 4; ++i)
+      {
+        equal &= num_collisions[i] == num_collisions[0];
+        equal &= !with_types || types[i].bitVector() == types[0].bitVector();
+      }
+
+      std::cout << "1:" << ratio << (with_types ? " with types" : "") << ", " << num_collisions[0] << " collisions"
+                << ": big with small " << big_ms << " ms, small with big " << small_ms << " ms, host big with small "
+                << host_big_ms << " ms, host small with big " << host_small_ms << " ms" << std::endl;
+    }
+  }
+  std::cout << (equal ? "All results are equal" : "RESULTS DIFFER") << std::endl;
+
+  return equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
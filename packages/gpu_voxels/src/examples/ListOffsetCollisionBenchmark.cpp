@@ -0,0 +1,140 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program sweeps an object list over a grid of placements in an
+* environment list. Every placement is checked once with the offset
+* of the list collision and once by inserting the translated object
+* into a new list. The program reports the average times per placement
+* and whether both variants deliver the same results.
+*
+* Usage: list_offset_collision_benchmark [-n placements per axis] [-s map side] [-h]
+*   -h  use the host backend instead of the device backend
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/helpers/GeometryGeneration.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxellist::BitVectorVoxelList;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+int main(int argc, char* argv[])
+{
+  int placements_per_axis = 8;
+  int map_side = 128;
+  MapBackend backend = MB_DEVICE;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      placements_per_axis = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      map_side = std::max(32, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-h") == 0)
+    {
+      backend = MB_HOST;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-n placements per axis] [-s map side] [-h]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.01f;
+  const float side = map_side * voxel_side_length;
+  const Vector3ui map_dim(map_side, map_side, map_side);
+  srand(42);
+
+  // the object fills a quarter of the map side and is swept over the rest of the map.
+  // Its points are voxel centers, so the translated points fall into the shifted voxels.
+  const float object_side = side * 0.25f;
+  std::vector<Vector3f> object_cloud = geometry_generation::createBoxOfPoints(
+      Vector3f(voxel_side_length * 0.5f, voxel_side_length * 0.5f, voxel_side_length * 0.5f),
+      Vector3f(object_side, object_side, object_side), voxel_side_length);
+  BitVectorVoxelList object(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, backend);
+  object.insertPointCloud(object_cloud, eBVM_OCCUPIED);
+
+  BitVectorVoxelList environment(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, backend);
+  std::vector<Vector3f> environment_cloud;
+  for (int i = 0; i < 200000; ++i)
+  {
+    environment_cloud.push_back(Vector3f(randomCoordinate(side), randomCoordinate(side), randomCoordinate(side)));
+  }
+  environment.insertPointCloud(environment_cloud, eBVM_OCCUPIED);
+
+  const int max_shift = map_side - int(object_side / voxel_side_length) - 2;
+  double offset_ms = 0.0;
+  double insertion_ms = 0.0;
+  bool equal = true;
+  int num_placements = 0;
+  for (int x = 0; x < placements_per_axis; ++x)
+  {
+    for (int y = 0; y < placements_per_axis; ++y)
+    {
+      for (int z = 0; z < placements_per_axis; ++z)
+      {
+        const Vector3i offset(x * max_shift / placements_per_axis, y * max_shift / placements_per_axis,
+                              z * max_shift / placements_per_axis);
+        icl_core::TimeStamp start = icl_core::TimeStamp::now();
+        const size_t offset_collisions = object.collideWith(&environment, 1.0, offset);
+        offset_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+        start = icl_core::TimeStamp::now();
+        std::vector<Vector3f> translated_cloud(object_cloud);
+        const Vector3f translation(offset.x * voxel_side_length, offset.y * voxel_side_length,
+                                   offset.z * voxel_side_length);
+        for (size_t i = 0; i < translated_cloud.size(); ++i)
+        {
+          translated_cloud[i] += translation;
+        }
+        BitVectorVoxelList translated(map_dim, voxel_side_length, MT_BITVECTOR_VOXELLIST, backend);
+        translated.insertPointCloud(translated_cloud, eBVM_OCCUPIED);
+        const size_t insertion_collisions = translated.collideWith(&environment);
+        insertion_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+        equal &= offset_collisions == insertion_collisions;
+        ++num_placements;
+      }
+    }
+  }
+
+  std::cout << num_placements << " placements in " << map_side << "^3 voxels on the "
+            << (backend == MB_HOST ? "host" : "device") << ": offset collision " << offset_ms / num_placements
+            << " ms, re-insertion " << insertion_ms / num_placements << " ms, speedup " << insertion_ms / offset_ms
+            << (equal ? ", equal results" : ", RESULTS DIFFER") << std::endl;
+
+  return equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
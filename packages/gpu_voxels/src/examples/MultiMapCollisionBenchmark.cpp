@@ -0,0 +1,179 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program compares the multi map collision query with one
+* collideWithTypes() call per map. A swept volume map is collided with
+* several bit vector and probabilistic environment maps, which are
+* filled with random boxes. The program reports the average times of
+* both variants and whether they deliver the same results.
+*
+* Usage: multi_map_collision_benchmark [-r repetitions] [-n maps] [-s map side] [-h]
+*   -h  use the host backend instead of the device backend
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+void insertRandomBoxes(GpuVoxelsSharedPtr gvl, const std::string& map_name, const BitVoxelMeaning meaning,
+                       const float map_side, const int num_boxes)
+{
+  for (int i = 0; i < num_boxes; ++i)
+  {
+    const Vector3f corner_min(randomCoordinate(map_side * 0.9f), randomCoordinate(map_side * 0.9f),
+                              randomCoordinate(map_side * 0.9f));
+    const Vector3f corner_max = corner_min + Vector3f(map_side * 0.1f, map_side * 0.1f, map_side * 0.1f);
+    gvl->insertBoxIntoMap(corner_min, corner_max, map_name, meaning, 2);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int repetitions = 20;
+  int num_maps = 8;
+  int map_side = 128;
+  MapBackend backend = MB_DEVICE;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      repetitions = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      num_maps = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      map_side = std::max(16, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-h") == 0)
+    {
+      backend = MB_HOST;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r repetitions] [-n maps] [-s map side] [-h]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.01f;
+  const float side = map_side * voxel_side_length;
+  GpuVoxelsSharedPtr gvl = GpuVoxels::getInstance();
+  gvl->initialize(map_side, map_side, map_side, voxel_side_length);
+  srand(42);
+
+  // the robot sweeps through the map, every pose has its own meaning
+  gvl->addMap(MT_BITVECTOR_VOXELMAP, "robot", backend);
+  for (int i = 0; i < 20; ++i)
+  {
+    const Vector3f corner_min(side * (0.1f + 0.035f * i), side * 0.3f, side * 0.2f);
+    const Vector3f corner_max = corner_min + Vector3f(side * 0.1f, side * 0.4f, side * 0.6f);
+    gvl->insertBoxIntoMap(corner_min, corner_max, "robot", BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + i));
+  }
+
+  std::vector<std::string> map_names;
+  for (int m = 0; m < num_maps; ++m)
+  {
+    std::stringstream name;
+    name << "environment_" << m;
+    map_names.push_back(name.str());
+    if (m % 2 == 0)
+    {
+      gvl->addMap(MT_PROBAB_VOXELMAP, name.str(), backend);
+      insertRandomBoxes(gvl, name.str(), eBVM_OCCUPIED, side, 20);
+    }
+    else
+    {
+      gvl->addMap(MT_BITVECTOR_VOXELMAP, name.str(), backend);
+      insertRandomBoxes(gvl, name.str(), BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + m % 20), side, 20);
+    }
+  }
+
+  voxelmap::BitVectorVoxelMap* robot = gvl->getMap("robot")->as<voxelmap::BitVectorVoxelMap>();
+  const float threshold = 0.1f;
+  double single_ms = 0.0;
+  double query_ms = 0.0;
+  std::vector<CollisionQueryResult> single_results(num_maps);
+  std::vector<CollisionQueryResult> query_results;
+  for (int r = 0; r < repetitions; ++r)
+  {
+    gvl->clearMap("robot", eBVM_COLLISION);
+    icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    for (int m = 0; m < num_maps; ++m)
+    {
+      GpuVoxelsMapSharedPtr map = gvl->getMap(map_names[m]);
+      single_results[m].types_in_collision = BitVectorVoxel();
+      if (map->getMapType() == MT_PROBAB_VOXELMAP)
+      {
+        single_results[m].num_collisions = robot->collideWithTypes(map->as<voxelmap::ProbVoxelMap>(),
+                                                                   single_results[m].types_in_collision, threshold);
+      }
+      else
+      {
+        single_results[m].num_collisions = robot->collideWithTypes(map->as<voxelmap::BitVectorVoxelMap>(),
+                                                                   single_results[m].types_in_collision, threshold);
+      }
+    }
+    single_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+    gvl->clearMap("robot", eBVM_COLLISION);
+    start = icl_core::TimeStamp::now();
+    if (!gvl->collideWithMaps("robot", map_names, query_results, threshold))
+    {
+      std::cout << "The multi map query failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    query_ms += (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+  }
+
+  // the single checks see the collision flags that the previous checks inserted
+  bool equal = query_results.size() == single_results.size();
+  for (size_t m = 0; equal && m < single_results.size(); ++m)
+  {
+    single_results[m].types_in_collision.bitVector().clearBit(eBVM_COLLISION);
+    query_results[m].types_in_collision.bitVector().clearBit(eBVM_COLLISION);
+    equal = single_results[m].num_collisions == query_results[m].num_collisions
+        && single_results[m].types_in_collision.bitVector() == query_results[m].types_in_collision.bitVector();
+  }
+
+  std::cout << num_maps << " maps of " << map_side << "^3 voxels on the " << (backend == MB_HOST ? "host" : "device")
+            << ": single checks " << single_ms / repetitions << " ms, multi map query " << query_ms / repetitions
+            << " ms, speedup " << single_ms / query_ms << (equal ? ", equal results" : ", RESULTS DIFFER") << std::endl;
+
+  gvl.reset();
+  return equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,180 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+*
+* This program compares the synchronous insertSensorData() with the
+* streaming SensorIntegrationPipeline. Several simulated depth cameras
+* look into a map from different poses. Their frames are inserted one
+* after another and then pushed by one producer thread per camera.
+* The program reports the frame rates, the dropped frames and the
+* latencies of the pipeline stages.
+*
+* Usage: sensor_pipeline_benchmark [-r frames per camera] [-n cameras] [-s map side] [-b]
+*   -b  block the producers instead of dropping the oldest frames
+*
+*/
+//----------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/GpuVoxels.h>
+#include <gpu_voxels/voxelmap/SensorIntegrationPipeline.h>
+#include <gpu_voxels/logging/logging_gpu_voxels.h>
+
+using namespace gpu_voxels;
+using gpu_voxels::voxelmap::ProbVoxelMap;
+using gpu_voxels::voxelmap::SensorIntegrationPipeline;
+
+static const uint32_t cFRAME_WIDTH = 320;
+static const uint32_t cFRAME_HEIGHT = 240;
+
+//! Returns a random number in [0, max)
+float randomCoordinate(const float max)
+{
+  return max * (rand() / (RAND_MAX + 1.0f));
+}
+
+//! A frame of a camera that looks along its x axis onto a wall at a random depth
+std::vector<Vector3f> createFrame(const float max_depth)
+{
+  std::vector<Vector3f> frame(cFRAME_WIDTH * cFRAME_HEIGHT);
+  for (uint32_t v = 0; v < cFRAME_HEIGHT; ++v)
+  {
+    for (uint32_t u = 0; u < cFRAME_WIDTH; ++u)
+    {
+      const float depth = max_depth * 0.5f + randomCoordinate(max_depth * 0.5f);
+      frame[v * cFRAME_WIDTH + u] = Vector3f(depth, depth * (float(u) / cFRAME_WIDTH - 0.5f),
+                                             depth * (float(v) / cFRAME_HEIGHT - 0.5f));
+    }
+  }
+  return frame;
+}
+
+void pushFrames(SensorIntegrationPipeline* pipeline, const Sensor* sensor, const std::vector<Vector3f>* frame,
+                const int num_frames)
+{
+  for (int f = 0; f < num_frames; ++f)
+  {
+    pipeline->pushFrame(*sensor, *frame);
+  }
+}
+
+void printStage(const char* name, const voxelmap::SensorPipelineStageStatistics& stage)
+{
+  std::cout << "  " << name << ": average " << stage.averageMs() << " ms, max " << stage.max_ms << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int num_frames = 50;
+  int num_cameras = 3;
+  int map_side = 256;
+  voxelmap::SensorBackPressure back_pressure = voxelmap::eSBP_DROP_OLDEST;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      num_frames = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      num_cameras = std::max(1, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      map_side = std::max(64, atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-b") == 0)
+    {
+      back_pressure = voxelmap::eSBP_BLOCK;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [-r frames per camera] [-n cameras] [-s map side] [-b]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  icl_core::logging::initialize(argc, argv);
+  const float voxel_side_length = 0.02f;
+  const float side = map_side * voxel_side_length;
+  const Vector3ui map_dim(map_side, map_side, map_side);
+  srand(42);
+
+  // the cameras stand on a circle around the center of the map and look at it
+  std::vector<Sensor> sensors;
+  std::vector<std::vector<Vector3f> > frames;
+  for (int c = 0; c < num_cameras; ++c)
+  {
+    const float angle = 2.0f * float(M_PI) * c / num_cameras;
+    const Vector3f position(side * (0.5f - 0.4f * cos(angle)), side * (0.5f - 0.4f * sin(angle)), side * 0.5f);
+    sensors.push_back(Sensor(position, Matrix3f::createFromRPY(Vector3f(0.0f, 0.0f, angle)), cFRAME_WIDTH,
+                             cFRAME_HEIGHT));
+    frames.push_back(createFrame(side * 0.8f));
+  }
+
+  // all cameras have the same resolution, so they only differ in the pose
+  ProbVoxelMap sync_map(map_dim, voxel_side_length, MT_PROBAB_VOXELMAP);
+  sync_map.initSensorSettings(sensors[0]);
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  for (int f = 0; f < num_frames; ++f)
+  {
+    for (int c = 0; c < num_cameras; ++c)
+    {
+      sync_map.updateSensorPose(sensors[c]);
+      sync_map.insertSensorData<BIT_VECTOR_LENGTH>(&frames[c][0], true, false, eBVM_OCCUPIED, NULL);
+    }
+  }
+  const double sync_ms = (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+  ProbVoxelMap pipeline_map(map_dim, voxel_side_length, MT_PROBAB_VOXELMAP);
+  voxelmap::SensorPipelineParameters parameters;
+  parameters.max_points = cFRAME_WIDTH * cFRAME_HEIGHT;
+  parameters.back_pressure = back_pressure;
+  SensorIntegrationPipeline pipeline(&pipeline_map, parameters);
+  start = icl_core::TimeStamp::now();
+  boost::thread_group producers;
+  for (int c = 0; c < num_cameras; ++c)
+  {
+    producers.create_thread(boost::bind(&pushFrames, &pipeline, &sensors[c], &frames[c], num_frames));
+  }
+  producers.join_all();
+  pipeline.flush();
+  const double pipeline_ms = (icl_core::TimeStamp::now() - start).toNSec() * 1e-6;
+
+  const voxelmap::SensorPipelineStatistics statistics = pipeline.getStatistics();
+  const int total_frames = num_frames * num_cameras;
+  std::cout << total_frames << " frames of " << num_cameras << " cameras in " << map_side << "^3 voxels" << std::endl;
+  std::cout << "synchronous insertion: " << total_frames / (sync_ms * 1e-3) << " frames/s" << std::endl;
+  std::cout << "pipeline: " << statistics.frames_integrated / (pipeline_ms * 1e-3) << " integrated frames/s, "
+            << total_frames / (pipeline_ms * 1e-3) << " accepted frames/s, " << statistics.frames_dropped
+            << " dropped frames" << std::endl;
+  printStage("waiting", statistics.waiting);
+  printStage("preprocessing", statistics.preprocessing);
+  printStage("upload", statistics.upload);
+  printStage("integration", statistics.integration);
+  printStage("total", statistics.total);
+
+  return EXIT_SUCCESS;
+}
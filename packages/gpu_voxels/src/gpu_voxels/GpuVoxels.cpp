@@ -37,7 +37,7 @@ GpuVoxels::GpuVoxels()
   // Check for valid GPU:
   if(!cuTestAndInitDevice())
   {
-    exit(123);
+    LOGGING_WARNING_C(Gpu_voxels, GpuVoxels, "No usable GPU found. Only maps with the MB_HOST backend will work!" << endl);
   }
 }
 
@@ -161,7 +161,7 @@ bool GpuVoxels::modifyPrimitives(const std::string &array_name, const std::vecto
   return true;
 }
 
-GpuVoxelsMapSharedPtr GpuVoxels::addMap(const MapType map_type, const std::string &map_name)
+GpuVoxelsMapSharedPtr GpuVoxels::addMap(const MapType map_type, const std::string &map_name, const MapBackend backend)
 {
   GpuVoxelsMapSharedPtr map_shared_ptr;
   VisProviderSharedPtr vis_map_shared_ptr;
@@ -175,23 +175,35 @@ GpuVoxelsMapSharedPtr GpuVoxels::addMap(const MapType map_type, const std::strin
     return map_shared_ptr;  // null-initialized shared_ptr!
   }
 
+  if (backend == MB_HOST && map_type != MT_PROBAB_VOXELMAP && map_type != MT_BITVECTOR_VOXELMAP
+      && map_type != MT_BITVECTOR_VOXELLIST)
+  {
+    LOGGING_ERROR_C(Gpu_voxels, GpuVoxels, "The host backend is only available for probabilistic and bitvector "
+                    "voxelmaps and bitvector voxellists. Map '" << map_name << "' was not added." << endl);
+    return map_shared_ptr;  // null-initialized shared_ptr!
+  }
+
   switch (map_type)
   {
     case MT_PROBAB_VOXELMAP:
     {
-      voxelmap::ProbVoxelMap* orig_map = new voxelmap::ProbVoxelMap(m_dim, m_voxel_side_length, MT_PROBAB_VOXELMAP);
-      VisVoxelMap* vis_map = new VisVoxelMap(orig_map, map_name);
+      voxelmap::ProbVoxelMap* orig_map = new voxelmap::ProbVoxelMap(m_dim, m_voxel_side_length, MT_PROBAB_VOXELMAP, backend);
       map_shared_ptr = GpuVoxelsMapSharedPtr(orig_map);
-      vis_map_shared_ptr = VisProviderSharedPtr(vis_map);
+      if (backend == MB_DEVICE)
+      {
+        vis_map_shared_ptr = VisProviderSharedPtr(new VisVoxelMap(orig_map, map_name));
+      }
       break;
     }
 
     case MT_BITVECTOR_VOXELLIST:
     {
-      voxellist::BitVectorVoxelList* orig_list = new voxellist::BitVectorVoxelList(m_dim, m_voxel_side_length, MT_BITVECTOR_VOXELLIST);
-      VisTemplateVoxelList<BitVectorVoxel, uint32_t>* vis_list = new VisTemplateVoxelList<BitVectorVoxel, uint32_t>(orig_list, map_name);
+      voxellist::BitVectorVoxelList* orig_list = new voxellist::BitVectorVoxelList(m_dim, m_voxel_side_length, MT_BITVECTOR_VOXELLIST, backend);
       map_shared_ptr = GpuVoxelsMapSharedPtr(orig_list);
-      vis_map_shared_ptr = VisProviderSharedPtr(vis_list);
+      if (backend == MB_DEVICE)
+      {
+        vis_map_shared_ptr = VisProviderSharedPtr(new VisTemplateVoxelList<BitVectorVoxel, uint32_t>(orig_list, map_name));
+      }
       break;
     }
 
@@ -213,11 +225,12 @@ GpuVoxelsMapSharedPtr GpuVoxels::addMap(const MapType map_type, const std::strin
 
     case MT_BITVECTOR_VOXELMAP:
     {
-      voxelmap::BitVectorVoxelMap* orig_map = new voxelmap::BitVectorVoxelMap(m_dim, m_voxel_side_length, MT_BITVECTOR_VOXELMAP);
-      VisVoxelMap* vis_map = new VisVoxelMap(orig_map, map_name);
-
+      voxelmap::BitVectorVoxelMap* orig_map = new voxelmap::BitVectorVoxelMap(m_dim, m_voxel_side_length, MT_BITVECTOR_VOXELMAP, backend);
       map_shared_ptr = GpuVoxelsMapSharedPtr(orig_map);
-      vis_map_shared_ptr = VisProviderSharedPtr(vis_map);
+      if (backend == MB_DEVICE)
+      {
+        vis_map_shared_ptr = VisProviderSharedPtr(new VisVoxelMap(orig_map, map_name));
+      }
       break;
     }
 
@@ -440,7 +453,8 @@ bool GpuVoxels::insertPointCloudFromFile(const std::string map_name, const std::
 
 }
 
-bool GpuVoxels::insertPointCloudIntoMap(const PointCloud &cloud, std::string map_name, const BitVoxelMeaning voxel_meaning)
+bool GpuVoxels::insertPointCloudIntoMap(const PointCloud &cloud, std::string map_name, const BitVoxelMeaning voxel_meaning,
+                                        const bool downsample)
 {
   ManagedMapsIterator map_it = m_managed_maps.find(map_name);
   if (map_it == m_managed_maps.end())
@@ -449,12 +463,20 @@ bool GpuVoxels::insertPointCloudIntoMap(const PointCloud &cloud, std::string map
     return false;
   }
 
-  map_it->second.map_shared_ptr->insertPointCloud(cloud, voxel_meaning);
+  if (downsample)
+  {
+    map_it->second.map_shared_ptr->insertDownsampledPointCloud(cloud, voxel_meaning);
+  }
+  else
+  {
+    map_it->second.map_shared_ptr->insertPointCloud(cloud, voxel_meaning);
+  }
 
   return true;
 }
 
-bool GpuVoxels::insertPointCloudIntoMap(const std::vector<Vector3f> &cloud, std::string map_name, const BitVoxelMeaning voxel_meaning)
+bool GpuVoxels::insertPointCloudIntoMap(const std::vector<Vector3f> &cloud, std::string map_name, const BitVoxelMeaning voxel_meaning,
+                                        const bool downsample)
 {
   ManagedMapsIterator map_it = m_managed_maps.find(map_name);
   if (map_it == m_managed_maps.end())
@@ -463,7 +485,14 @@ bool GpuVoxels::insertPointCloudIntoMap(const std::vector<Vector3f> &cloud, std:
     return false;
   }
 
-  map_it->second.map_shared_ptr->insertPointCloud(cloud, voxel_meaning);
+  if (downsample)
+  {
+    map_it->second.map_shared_ptr->insertDownsampledPointCloud(cloud, voxel_meaning);
+  }
+  else
+  {
+    map_it->second.map_shared_ptr->insertPointCloud(cloud, voxel_meaning);
+  }
 
   return true;
 }
@@ -534,6 +563,38 @@ bool GpuVoxels::insertBoxIntoMap(const Vector3f &corner_min, const Vector3f &cor
   return true;
 }
 
+bool GpuVoxels::collideWithMaps(const std::string &robot_map_name, const std::vector<std::string> &map_names,
+                                std::vector<CollisionQueryResult> &results, float coll_threshold)
+{
+  results.clear();
+  ManagedMapsIterator robot_it = m_managed_maps.find(robot_map_name);
+  if (robot_it == m_managed_maps.end())
+  {
+    LOGGING_ERROR_C(Gpu_voxels, GpuVoxels, "Could not find map '" << robot_map_name << "'" << endl);
+    return false;
+  }
+  CollidableWithMultipleMaps* robot_map = dynamic_cast<CollidableWithMultipleMaps*>(robot_it->second.map_shared_ptr.get());
+  if (robot_map == NULL)
+  {
+    LOGGING_ERROR_C(Gpu_voxels, GpuVoxels, "Map '" << robot_map_name << "' can not be collided with multiple maps." << endl);
+    return false;
+  }
+
+  std::vector<GpuVoxelsMap*> maps;
+  for (size_t i = 0; i < map_names.size(); ++i)
+  {
+    ManagedMapsIterator map_it = m_managed_maps.find(map_names[i]);
+    if (map_it == m_managed_maps.end())
+    {
+      LOGGING_ERROR_C(Gpu_voxels, GpuVoxels, "Could not find map '" << map_names[i] << "'" << endl);
+      return false;
+    }
+    maps.push_back(map_it->second.map_shared_ptr.get());
+  }
+
+  return robot_map->collideWithMaps(maps, results, coll_threshold);
+}
+
 bool GpuVoxels::clearMap(const std::string &map_name)
 {
   ManagedMapsIterator it = m_managed_maps.find(map_name);
@@ -566,6 +627,12 @@ bool GpuVoxels::visualizeMap(const std::string &map_name, const bool force_repai
     LOGGING_ERROR_C(Gpu_voxels, GpuVoxels, "Map with name '" << map_name << "' not found." << endl);
     return false;
   }
+  if (!it->second.vis_provider_shared_ptr)
+  {
+    // maps in host memory can not be shared with the visualizer
+    LOGGING_WARNING_C(Gpu_voxels, GpuVoxels, "Map with name '" << map_name << "' can not be visualized." << endl);
+    return false;
+  }
   return it->second.vis_provider_shared_ptr.get()->visualize(force_repaint);
 }
 
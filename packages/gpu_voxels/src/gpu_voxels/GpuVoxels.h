@@ -48,6 +48,7 @@
 #include <gpu_voxels/GpuVoxelsMap.h>
 #include <gpu_voxels/ManagedMap.h>
 #include <gpu_voxels/ManagedPrimitiveArray.h>
+#include <gpu_voxels/helpers/CollisionQuery.h>
 #include <gpu_voxels/helpers/MetaPointCloud.h>
 #include <gpu_voxels/helpers/PointCloud.h>
 #include <gpu_voxels/octree/Octree.h>
@@ -116,9 +117,12 @@ public:
    * \param map_type Choose between a representation: Octree, Voxelmap,
    * Voxellist are possible
    * \param map_name The name of the map for later identification
+   * \param backend MB_DEVICE keeps the map in GPU memory. MB_HOST keeps it in host memory
+   * and processes it on the CPU, which is only supported for MT_PROBAB_VOXELMAP,
+   * MT_BITVECTOR_VOXELMAP and MT_BITVECTOR_VOXELLIST. Host maps can not be visualized.
    * \return Returns shared_ptr to the added map if adding was successful, otherwise returns empty shared_ptr
    */
-  GpuVoxelsMapSharedPtr addMap(const MapType map_type, const std::string &map_name);
+  GpuVoxelsMapSharedPtr addMap(const MapType map_type, const std::string &map_name, const MapBackend backend = MB_DEVICE);
 
   /*!
    * \brief delMap Remove a map from GVL.
@@ -263,17 +267,21 @@ public:
    * @brief insertPointCloudIntoMap Inserts a PointCloud into the map.
    * @param cloud The PointCloud to insert
    * @param voxel_meaning Voxel meaning of all voxels
+   * @param downsample If true, the cloud is reduced to one point per voxel before the insertion,
+   * see GpuVoxelsMap::insertDownsampledPointCloud()
    */
   bool insertPointCloudIntoMap(const PointCloud &cloud, std::string map_name,
-                               const BitVoxelMeaning voxel_meaning);
+                               const BitVoxelMeaning voxel_meaning, const bool downsample = false);
 
   /*!
    * @brief insertPointCloudIntoMap Inserts a PointCloud into the map.
    * @param cloud The PointCloud to insert
    * @param voxel_meaning Voxel meaning of all voxels
+   * @param downsample If true, the cloud is reduced to one point per voxel before the insertion,
+   * see GpuVoxelsMap::insertDownsampledPointCloud()
    */
   bool insertPointCloudIntoMap(const std::vector<Vector3f> &cloud, std::string map_name,
-                               const BitVoxelMeaning voxel_meaning);
+                               const BitVoxelMeaning voxel_meaning, const bool downsample = false);
 
   /*!
    * @brief insertMetaPointCloudIntoMap Inserts a MetaPointCloud into the map. Each pointcloud
@@ -314,6 +322,19 @@ public:
   */
   bool insertBoxIntoMap(const Vector3f &corner_min, const Vector3f &corner_max, std::string map_name, const BitVoxelMeaning voxel_meaning, uint16_t points_per_voxel = 1);
 
+  /*!
+   * \brief collideWithMaps Collides a robot map with several maps in one query.
+   * Voxel maps of the same dimensions and backend as the robot map are checked in a single
+   * pass over the robot voxels, all other maps (e.g. octrees) are checked one after another.
+   * \param robot_map_name Name of the BitVectorVoxelMap or BitVectorVoxelList to check
+   * \param map_names Names of the maps to check against
+   * \param results Number of collisions and types in collision per map, in the order of \a map_names
+   * \param coll_threshold The threshold when a collision is counted. Only valid for probabilistic maps.
+   * \return true if all maps were found and checked, false otherwise
+   */
+  bool collideWithMaps(const std::string &robot_map_name, const std::vector<std::string> &map_names,
+                       std::vector<CollisionQueryResult> &results, float coll_threshold = 1.0);
+
   /*!
    * \brief addPrimitives
    * \param prim_type Cubes or Spheres
@@ -23,10 +23,12 @@
 
 #include "GpuVoxelsMap.h"
 #include <gpu_voxels/helpers/PointcloudFileHandler.h>
+#include <algorithm>
 
 namespace gpu_voxels {
 
 GpuVoxelsMap::GpuVoxelsMap()
+  : m_backend(MB_DEVICE)
 {
 }
 GpuVoxelsMap::~GpuVoxelsMap()
@@ -47,6 +49,16 @@ bool GpuVoxelsMap::insertPointCloudFromFile(const std::string path, const bool u
   return false;
 }
 
+void GpuVoxelsMap::insertDownsampledPointCloud(const std::vector<Vector3f> &point_cloud, const BitVoxelMeaning voxel_meaning)
+{
+  insertPointCloud(point_cloud, voxel_meaning);
+}
+
+void GpuVoxelsMap::insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning)
+{
+  insertPointCloud(pointcloud, voxel_meaning);
+}
+
 void GpuVoxelsMap::generateVisualizerData()
 {
 }
@@ -67,5 +79,32 @@ MapType GpuVoxelsMap::getMapType() const
   return m_map_type;
 }
 
+MapBackend GpuVoxelsMap::getBackend() const
+{
+  return m_backend;
+}
+
+MultiMapLock::MultiMapLock(const std::vector<const GpuVoxelsMap*>& maps)
+{
+  for (size_t i = 0; i < maps.size(); ++i)
+  {
+    m_mutexes.push_back(&maps[i]->m_mutex);
+  }
+  std::sort(m_mutexes.begin(), m_mutexes.end());
+  m_mutexes.erase(std::unique(m_mutexes.begin(), m_mutexes.end()), m_mutexes.end());
+  for (size_t i = 0; i < m_mutexes.size(); ++i)
+  {
+    m_mutexes[i]->lock();
+  }
+}
+
+MultiMapLock::~MultiMapLock()
+{
+  for (size_t i = m_mutexes.size(); i > 0; --i)
+  {
+    m_mutexes[i - 1]->unlock();
+  }
+}
+
 } // end of ns
 
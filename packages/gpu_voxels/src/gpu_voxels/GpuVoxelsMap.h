@@ -106,6 +106,12 @@ public:
    */
   MapType getMapType() const;
 
+  /*!
+   * \brief getBackend returns where the data of the map lives and where its operations are executed
+   * \return MB_DEVICE for maps in GPU memory, MB_HOST for maps in host memory
+   */
+  MapBackend getBackend() const;
+
   /*!
    * \brief insertPointCloud Inserts a pointcloud with global coordinates
    * \param point_cloud The pointcloud to insert
@@ -114,6 +120,16 @@ public:
 
   virtual void insertPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning) = 0;
 
+  /*!
+   * \brief insertDownsampledPointCloud Inserts a pointcloud with global coordinates after reducing
+   * it to one point per voxel. Dense clouds then write each voxel only once. Counting voxel lists
+   * receive the number of points per voxel. Maps without a downsampling stage insert all points.
+   * \param point_cloud The pointcloud to insert
+   */
+  virtual void insertDownsampledPointCloud(const std::vector<Vector3f> &point_cloud, const BitVoxelMeaning voxel_meaning);
+
+  virtual void insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning);
+
   virtual bool insertRobotConfiguration(const MetaPointCloud *robot_links, bool with_self_collision_test) = 0;
 
   /**
@@ -270,9 +286,28 @@ public:
 
 protected:
   MapType m_map_type;
+  MapBackend m_backend;
+
+private:
+
+};
+
+/*!
+ * \brief The MultiMapLock class locks the mutexes of several maps for its lifetime.
+ * The mutexes are locked in the order of their addresses, so that threads which
+ * lock overlapping sets of maps can not deadlock. Maps may appear more than once.
+ */
+class MultiMapLock
+{
+public:
+  explicit MultiMapLock(const std::vector<const GpuVoxelsMap*>& maps);
+  ~MultiMapLock();
 
 private:
+  MultiMapLock(const MultiMapLock&);
+  const MultiMapLock& operator=(const MultiMapLock&);
 
+  std::vector<boost::recursive_timed_mutex*> m_mutexes;
 };
 
 } // end of namespace
@@ -0,0 +1,93 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Interface and data types of the multi map collision query, which
+ * collides one robot map or list with several environment maps.
+ * Environment voxel maps that share the dimensions and the backend of
+ * the robot are checked in a single traversal of the robot voxels,
+ * all other maps are checked one after another through the
+ * interfaces in CollisionInterfaces.h.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_COLLISION_QUERY_H_INCLUDED
+#define GPU_VOXELS_HELPERS_COLLISION_QUERY_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/voxel/BitVoxel.h>
+#include <gpu_voxels/voxel/ProbabilisticVoxel.h>
+
+namespace gpu_voxels {
+
+class GpuVoxelsMap;
+
+//! Number of voxel maps that are checked in one traversal, more maps are processed in batches
+static const uint32_t cMAX_COLLISION_QUERY_MAPS = 16;
+
+//! Launch configuration of the query kernels, every thread keeps the results of all maps
+static const uint32_t cCOLLISION_QUERY_THREADS_PER_BLOCK = 128;
+static const uint32_t cCOLLISION_QUERY_MAX_BLOCKS = 1024;
+
+/*!
+ * \brief The CollisionQueryTargets struct holds the voxel data of the maps that
+ * are checked in one traversal. Exactly one of \a bit_maps[i] and \a prob_maps[i]
+ * is set for every map i. It is passed by value to the device kernels.
+ */
+template<std::size_t length>
+struct CollisionQueryTargets
+{
+  uint32_t num_maps;
+  const BitVoxel<length>* bit_maps[cMAX_COLLISION_QUERY_MAPS];
+  const ProbabilisticVoxel* prob_maps[cMAX_COLLISION_QUERY_MAPS];
+};
+
+/*!
+ * \brief The CollisionQueryResult struct holds the result of one map of the query.
+ * \a num_collisions is SSIZE_MAX if the map could not be checked.
+ */
+struct CollisionQueryResult
+{
+  CollisionQueryResult()
+    : num_collisions(0)
+  {
+  }
+
+  size_t num_collisions;
+  BitVectorVoxel types_in_collision;
+};
+
+class CollidableWithMultipleMaps
+{
+public:
+  /*!
+   * \brief collideWithMaps Collides this map with all \a maps and delivers the results per map.
+   * Maps of the same dimensions and backend are checked in one pass, so the voxel meanings
+   * are taken from the robot voxels before eBVM_COLLISION is inserted into them.
+   * \param maps The maps to do a collision check with.
+   * \param results One result per map, in the order of \a maps
+   * \param coll_threshold The threshold when a collision is counted. Only valid for probabilistic maps.
+   * \return true if all maps could be checked, false otherwise
+   */
+  virtual bool collideWithMaps(const std::vector<GpuVoxelsMap*>& maps, std::vector<CollisionQueryResult>& results,
+                               float coll_threshold = 1.0) = 0;
+};
+
+} // end of namespace
+#endif
@@ -0,0 +1,327 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the host ray caster, see FreeSpaceRayCaster.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/FreeSpaceRayCaster.h>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace gpu_voxels {
+
+namespace {
+
+//! Rays of one batch are handed out to the threads in chunks of this size
+const int64_t cRAYS_PER_TASK = 256;
+
+inline bool isValidPoint(const Vector3f& point)
+{
+  return !(isnan(point.x) || isnan(point.y) || isnan(point.z) || isinf(point.x) || isinf(point.y)
+      || isinf(point.z));
+}
+
+/*!
+ * Clips the ray parameter range [t_enter, t_exit] of one axis against the slab [0, size).
+ * Returns false if the range gets empty.
+ */
+inline bool clipSlab(const float origin, const float delta, const uint32_t size, float& t_enter, float& t_exit)
+{
+  if (delta == 0.0f)
+  {
+    return origin >= 0.0f && origin < float(size);
+  }
+  float t_lower = -origin / delta;
+  float t_upper = (float(size) - origin) / delta;
+  if (t_lower > t_upper)
+  {
+    std::swap(t_lower, t_upper);
+  }
+  t_enter = std::max(t_enter, t_lower);
+  t_exit = std::min(t_exit, t_upper);
+  return t_enter < t_exit;
+}
+
+//! Setup of the traversal along one axis
+inline void initAxis(const float origin, const float delta, const int32_t voxel, int32_t& step, float& t_max,
+                     float& t_delta)
+{
+  if (delta > 0.0f)
+  {
+    step = 1;
+    t_max = (float(voxel + 1) - origin) / delta;
+    t_delta = 1.0f / delta;
+  }
+  else if (delta < 0.0f)
+  {
+    step = -1;
+    t_max = (float(voxel) - origin) / delta;
+    t_delta = -1.0f / delta;
+  }
+  else
+  {
+    step = 0;
+    t_max = std::numeric_limits<float>::infinity();
+    t_delta = std::numeric_limits<float>::infinity();
+  }
+}
+
+inline int32_t clampVoxel(const float value, const uint32_t size)
+{
+  return std::min(std::max(int32_t(floor(value)), 0), int32_t(size) - 1);
+}
+
+std::size_t getNumThreads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+std::size_t getThreadNum()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+} // end of anonymous namespace
+
+FreeSpaceRayCaster::FreeSpaceRayCaster(const Vector3ui& dim, const float voxel_side_length, const float max_range,
+                                       const Vector3ui& offset) :
+    m_dim(dim),
+    m_offset(offset),
+    m_voxel_side_length(voxel_side_length),
+    m_max_range(max_range),
+    m_num_words((std::size_t(dim.x) * dim.y * dim.z + 63) / 64),
+    m_num_traversed_voxels(0)
+{
+}
+
+void FreeSpaceRayCaster::addRays(const Vector3f& origin, const Vector3f* points, const std::size_t num_points)
+{
+  m_batches.push_back(RayBatch());
+  m_batches.back().origin = origin;
+  m_batches.back().points.assign(points, points + num_points);
+}
+
+void FreeSpaceRayCaster::clear()
+{
+  m_batches.clear();
+  m_free_voxels.clear();
+  m_occupied_voxels.clear();
+  m_num_traversed_voxels = 0;
+}
+
+void FreeSpaceRayCaster::castRays()
+{
+  m_free_voxels.clear();
+  m_occupied_voxels.clear();
+  m_free_bitmap.assign(m_num_words, 0);
+  m_occupied_bitmap.assign(m_num_words, 0);
+
+  // the bitmaps of the threads are cleared by mergeBitmaps(), so they only have to be set up once
+  m_thread_bitmaps.resize(getNumThreads());
+  for (std::size_t t = 0; t < m_thread_bitmaps.size(); ++t)
+  {
+    m_thread_bitmaps[t].resize(m_num_words, 0);
+  }
+
+  uint64_t num_traversed_voxels = 0;
+#pragma omp parallel reduction(+:num_traversed_voxels)
+  {
+    uint64_t* free_bitmap = &m_thread_bitmaps[getThreadNum()][0];
+    for (std::size_t b = 0; b < m_batches.size(); ++b)
+    {
+      const Vector3f origin = toVolumeUnits(m_batches[b].origin);
+      const Vector3f* points = &m_batches[b].points[0];
+      const int64_t num_points = m_batches[b].points.size();
+
+      // the bitmaps are private, so the threads may continue with the next batch right away
+#pragma omp for schedule(dynamic, cRAYS_PER_TASK) nowait
+      for (int64_t i = 0; i < num_points; ++i)
+      {
+        if (isValidPoint(points[i]))
+        {
+          num_traversed_voxels += castRay(origin, toVolumeUnits(points[i]), free_bitmap);
+        }
+      }
+    }
+  }
+  m_num_traversed_voxels = num_traversed_voxels;
+
+  markEndPoints();
+  mergeBitmaps();
+  extractVoxels(m_free_bitmap, m_free_voxels);
+  extractVoxels(m_occupied_bitmap, m_occupied_voxels);
+  m_batches.clear();
+}
+
+uint32_t FreeSpaceRayCaster::castRay(const Vector3f& origin, const Vector3f& point, uint64_t* free_bitmap) const
+{
+  const float delta_x = point.x - origin.x;
+  const float delta_y = point.y - origin.y;
+  const float delta_z = point.z - origin.z;
+
+  // the ray is parametrized as origin + t * delta, rays longer than the maximum range end early
+  float t_exit = 1.0f;
+  if (m_max_range > 0.0f)
+  {
+    const float length = sqrt(delta_x * delta_x + delta_y * delta_y + delta_z * delta_z);
+    const float max_length = m_max_range / m_voxel_side_length;
+    if (length > max_length)
+    {
+      t_exit = max_length / length;
+    }
+  }
+  const int32_t end_x = int32_t(floor(std::max(std::min(origin.x + t_exit * delta_x, float(m_dim.x)), -1.0f)));
+  const int32_t end_y = int32_t(floor(std::max(std::min(origin.y + t_exit * delta_y, float(m_dim.y)), -1.0f)));
+  const int32_t end_z = int32_t(floor(std::max(std::min(origin.z + t_exit * delta_z, float(m_dim.z)), -1.0f)));
+
+  // only the part of the ray inside of the map is traversed, so the origin may lie outside
+  float t_enter = 0.0f;
+  if (!clipSlab(origin.x, delta_x, m_dim.x, t_enter, t_exit) || !clipSlab(origin.y, delta_y, m_dim.y, t_enter, t_exit)
+      || !clipSlab(origin.z, delta_z, m_dim.z, t_enter, t_exit))
+  {
+    return 0;
+  }
+
+  int32_t x = clampVoxel(origin.x + t_enter * delta_x, m_dim.x);
+  int32_t y = clampVoxel(origin.y + t_enter * delta_y, m_dim.y);
+  int32_t z = clampVoxel(origin.z + t_enter * delta_z, m_dim.z);
+
+  int32_t step_x, step_y, step_z;
+  float t_max_x, t_max_y, t_max_z;
+  float t_delta_x, t_delta_y, t_delta_z;
+  initAxis(origin.x, delta_x, x, step_x, t_max_x, t_delta_x);
+  initAxis(origin.y, delta_y, y, step_y, t_max_y, t_delta_y);
+  initAxis(origin.z, delta_z, z, step_z, t_max_z, t_delta_z);
+
+  uint32_t num_voxels = 0;
+  while (x != end_x || y != end_y || z != end_z)
+  {
+    const uint64_t index = getIndex(x, y, z);
+    free_bitmap[index >> 6] |= uint64_t(1) << (index & 63);
+    ++num_voxels;
+
+    // step into the neighbor whose boundary the ray crosses first
+    if (t_max_x < t_max_y && t_max_x < t_max_z)
+    {
+      x += step_x;
+      if (t_max_x >= t_exit || x < 0 || x >= int32_t(m_dim.x))
+        break;
+      t_max_x += t_delta_x;
+    }
+    else if (t_max_y < t_max_z)
+    {
+      y += step_y;
+      if (t_max_y >= t_exit || y < 0 || y >= int32_t(m_dim.y))
+        break;
+      t_max_y += t_delta_y;
+    }
+    else
+    {
+      z += step_z;
+      if (t_max_z >= t_exit || z < 0 || z >= int32_t(m_dim.z))
+        break;
+      t_max_z += t_delta_z;
+    }
+  }
+  return num_voxels;
+}
+
+void FreeSpaceRayCaster::markEndPoints()
+{
+  const float max_length = m_max_range / m_voxel_side_length;
+  for (std::size_t b = 0; b < m_batches.size(); ++b)
+  {
+    const Vector3f origin = toVolumeUnits(m_batches[b].origin);
+    const std::vector<Vector3f>& points = m_batches[b].points;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      if (!isValidPoint(points[i]))
+      {
+        continue;
+      }
+      const Vector3f point = toVolumeUnits(points[i]);
+      const float delta_x = point.x - origin.x;
+      const float delta_y = point.y - origin.y;
+      const float delta_z = point.z - origin.z;
+      if (m_max_range > 0.0f && sqrt(delta_x * delta_x + delta_y * delta_y + delta_z * delta_z) > max_length)
+      {
+        continue;
+      }
+      if (point.x >= 0.0f && point.y >= 0.0f && point.z >= 0.0f && point.x < float(m_dim.x)
+          && point.y < float(m_dim.y) && point.z < float(m_dim.z))
+      {
+        const uint64_t index = getIndex(uint32_t(floor(point.x)), uint32_t(floor(point.y)), uint32_t(floor(point.z)));
+        m_occupied_bitmap[index >> 6] |= uint64_t(1) << (index & 63);
+      }
+    }
+  }
+}
+
+void FreeSpaceRayCaster::mergeBitmaps()
+{
+  const std::size_t num_threads = m_thread_bitmaps.size();
+
+#pragma omp parallel for schedule(static)
+  for (int64_t w = 0; w < int64_t(m_num_words); ++w)
+  {
+    uint64_t word = 0;
+    for (std::size_t t = 0; t < num_threads; ++t)
+    {
+      word |= m_thread_bitmaps[t][w];
+      m_thread_bitmaps[t][w] = 0;
+    }
+    // measured end points override the free space of other rays
+    m_free_bitmap[w] = word & ~m_occupied_bitmap[w];
+  }
+}
+
+void FreeSpaceRayCaster::extractVoxels(const std::vector<uint64_t>& bitmap, std::vector<uint64_t>& voxels) const
+{
+  for (std::size_t w = 0; w < bitmap.size(); ++w)
+  {
+    uint64_t word = bitmap[w];
+    while (word != 0)
+    {
+      voxels.push_back(uint64_t(w) * 64 + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+}
+
+Vector3f FreeSpaceRayCaster::toVolumeUnits(const Vector3f& point) const
+{
+  // the offset is subtracted in double precision, as the map coordinates of large maps are not exact in float
+  return Vector3f(float(double(point.x) / m_voxel_side_length - m_offset.x),
+                  float(double(point.y) / m_voxel_side_length - m_offset.y),
+                  float(double(point.z) / m_voxel_side_length - m_offset.z));
+}
+
+} // end of namespace gpu_voxels
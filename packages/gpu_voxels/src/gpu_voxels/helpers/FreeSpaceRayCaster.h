@@ -0,0 +1,167 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Host ray caster that computes the free space of sensor frames. The
+ * rays are traversed with the exact 3D-DDA of Amanatides and Woo, so
+ * every voxel that a ray touches is visited once. Each thread marks the
+ * free voxels in its own bitmap, the bitmaps are merged by OR and the
+ * voxels holding a measured end point are removed. So every voxel is
+ * reported once per frame, no matter how many rays pass it, and the
+ * cost of the map update scales with the number of touched voxels
+ * instead of the number of ray steps. The caster may cover only a
+ * sub-volume of the map, so the bitmaps stay small for large maps like
+ * the NTree.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_HELPERS_FREE_SPACE_RAY_CASTER_H_INCLUDED
+#define GPU_VOXELS_HELPERS_FREE_SPACE_RAY_CASTER_H_INCLUDED
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+
+namespace gpu_voxels {
+
+class FreeSpaceRayCaster
+{
+public:
+  /*!
+   * \param dim Dimensions of the traversed volume in voxels. Each thread holds a bitmap of it.
+   * \param voxel_side_length Side length of a voxel in meters
+   * \param max_range Rays are cut at this length in meters and their end points are
+   * not inserted then. 0 disables the limit.
+   * \param offset Map coordinates of the lower corner of the volume in voxels
+   */
+  FreeSpaceRayCaster(const Vector3ui& dim, const float voxel_side_length, const float max_range = 0.0f,
+                     const Vector3ui& offset = Vector3ui(0));
+
+  /*!
+   * \brief addRays Adds the rays from \a origin to all \a points of one sensor frame.
+   * Origin and points are given in metric map coordinates, the points are copied.
+   * Points with NaN coordinates are skipped. Rays of several sensors can be added
+   * as separate batches before calling castRays().
+   */
+  void addRays(const Vector3f& origin, const Vector3f* points, const std::size_t num_points);
+
+  /*!
+   * \brief castRays Casts all rays that were added since the last call and computes
+   * the free and occupied voxels of them. The rays are removed afterwards.
+   */
+  void castRays();
+
+  //! Removes the added rays and the results
+  void clear();
+
+  //! Linear indices in the volume of the voxels that are passed by a ray but hold no end point, sorted and unique
+  const std::vector<uint64_t>& getFreeVoxels() const
+  {
+    return m_free_voxels;
+  }
+
+  //! Linear indices in the volume of the voxels that hold an end point, sorted and unique
+  const std::vector<uint64_t>& getOccupiedVoxels() const
+  {
+    return m_occupied_voxels;
+  }
+
+  //! Number of voxel steps of all rays of the last castRays(), including duplicates
+  uint64_t getNumTraversedVoxels() const
+  {
+    return m_num_traversed_voxels;
+  }
+
+  //! Map coordinates of the voxel with the given linear index in the volume
+  Vector3ui getVoxelCoordinates(const uint64_t index) const
+  {
+    const uint64_t plane = uint64_t(m_dim.x) * m_dim.y;
+    return Vector3ui(uint32_t(index % m_dim.x) + m_offset.x, uint32_t((index % plane) / m_dim.x) + m_offset.y,
+                     uint32_t(index / plane) + m_offset.z);
+  }
+
+  //! Dimensions of the volume in voxels
+  const Vector3ui& getDimensions() const
+  {
+    return m_dim;
+  }
+
+  //! Map coordinates of the lower corner of the volume in voxels
+  const Vector3ui& getOffset() const
+  {
+    return m_offset;
+  }
+
+  float getVoxelSideLength() const
+  {
+    return m_voxel_side_length;
+  }
+
+  float getMaxRange() const
+  {
+    return m_max_range;
+  }
+
+private:
+  //! Rays that start at the same origin
+  struct RayBatch
+  {
+    Vector3f origin;
+    std::vector<Vector3f> points;
+  };
+
+  //! Marks the voxels of a ray in \a free_bitmap and returns the number of them
+  uint32_t castRay(const Vector3f& origin, const Vector3f& point, uint64_t* free_bitmap) const;
+
+  //! Marks the voxels of the end points of all rays that are not cut by the range limit
+  void markEndPoints();
+
+  //! Merges the bitmaps of all threads into m_free_bitmap and clears them
+  void mergeBitmaps();
+
+  //! Collects the set bits of \a bitmap in ascending order
+  void extractVoxels(const std::vector<uint64_t>& bitmap, std::vector<uint64_t>& voxels) const;
+
+  //! Converts metric map coordinates into continuous voxel coordinates of the volume
+  Vector3f toVolumeUnits(const Vector3f& point) const;
+
+  //! Linear index in the volume of the voxel with the given coordinates of the volume
+  uint64_t getIndex(const uint32_t x, const uint32_t y, const uint32_t z) const
+  {
+    return (uint64_t(z) * m_dim.y + y) * m_dim.x + x;
+  }
+
+  Vector3ui m_dim;
+  Vector3ui m_offset;
+  float m_voxel_side_length;
+  float m_max_range;
+  std::size_t m_num_words;
+
+  std::vector<RayBatch> m_batches;
+  //! Free space bitmap of each thread, kept between frames
+  std::vector<std::vector<uint64_t> > m_thread_bitmaps;
+  std::vector<uint64_t> m_free_bitmap;
+  std::vector<uint64_t> m_occupied_bitmap;
+
+  std::vector<uint64_t> m_free_voxels;
+  std::vector<uint64_t> m_occupied_voxels;
+  uint64_t m_num_traversed_voxels;
+};
+
+} // end of namespace gpu_voxels
+
+#endif
@@ -0,0 +1,562 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Versioned on-disk format for voxel maps, see MapFile.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/MapFile.h>
+#include <gpu_voxels/logging/logging_gpu_voxels_helpers.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+namespace {
+
+//! Checksum of the header with a zeroed checksum field and the chunk table
+uint64_t computeHeaderChecksum(const MapFileHeader& header, const MapFileChunk* chunks)
+{
+  MapFileHeader tmp = header;
+  tmp.checksum = 0;
+  const uint64_t seed = computeChecksum((const char*) &tmp, sizeof(MapFileHeader));
+  return computeChecksum((const char*) chunks, header.num_chunks * sizeof(MapFileChunk), seed);
+}
+
+}
+
+uint64_t computeChecksum(const char* data, const uint64_t size, uint64_t seed)
+{
+  const uint64_t prime = 1099511628211ULL;
+  uint64_t hash = seed;
+  uint64_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+  {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(uint64_t));
+    hash = (hash ^ word) * prime;
+  }
+  for (; i < size; ++i)
+  {
+    hash = (hash ^ uint8_t(data[i])) * prime;
+  }
+  return hash;
+}
+
+void encodeRunLength(const char* data, const uint64_t size, const uint32_t element_size, std::vector<char>& encoded)
+{
+  const uint32_t cRUN_FLAG = 0x80000000;
+  const uint64_t num_elements = size / element_size;
+  encoded.clear();
+  encoded.reserve(size / 16 + 64);
+
+  uint64_t i = 0;
+  while (i < num_elements)
+  {
+    // length of the run of elements equal to element i
+    const char* element = data + i * element_size;
+    uint64_t run = 1;
+    while (i + run < num_elements && run < ~cRUN_FLAG
+           && memcmp(element, data + (i + run) * element_size, element_size) == 0)
+    {
+      ++run;
+    }
+
+    uint32_t token;
+    if (run > 1)
+    {
+      token = cRUN_FLAG | uint32_t(run);
+      encoded.insert(encoded.end(), (const char*) &token, (const char*) &token + sizeof(uint32_t));
+      encoded.insert(encoded.end(), element, element + element_size);
+      i += run;
+    }
+    else
+    {
+      // literal elements until the next run starts
+      uint64_t literals = 1;
+      while (i + literals < num_elements && literals < ~cRUN_FLAG
+             && (i + literals + 1 >= num_elements
+                 || memcmp(data + (i + literals) * element_size, data + (i + literals + 1) * element_size,
+                           element_size) != 0))
+      {
+        ++literals;
+      }
+      token = uint32_t(literals);
+      encoded.insert(encoded.end(), (const char*) &token, (const char*) &token + sizeof(uint32_t));
+      encoded.insert(encoded.end(), element, element + literals * element_size);
+      i += literals;
+    }
+  }
+  encoded.insert(encoded.end(), data + num_elements * element_size, data + size);
+}
+
+bool decodeRunLength(const char* encoded, const uint64_t encoded_size, const uint32_t element_size,
+                     char* data, const uint64_t size)
+{
+  const uint32_t cRUN_FLAG = 0x80000000;
+  const uint64_t elements_size = (size / element_size) * element_size;
+  uint64_t in = 0;
+  uint64_t out = 0;
+  while (out < elements_size)
+  {
+    uint32_t token;
+    if (in + sizeof(uint32_t) > encoded_size)
+    {
+      return false;
+    }
+    memcpy(&token, encoded + in, sizeof(uint32_t));
+    in += sizeof(uint32_t);
+    const uint64_t count = token & ~cRUN_FLAG;
+    const uint64_t bytes = count * element_size;
+    if (out + bytes > elements_size)
+    {
+      return false;
+    }
+    if (token & cRUN_FLAG)
+    {
+      if (in + element_size > encoded_size)
+      {
+        return false;
+      }
+      for (uint64_t j = 0; j < count; ++j)
+      {
+        memcpy(data + out + j * element_size, encoded + in, element_size);
+      }
+      in += element_size;
+    }
+    else
+    {
+      if (in + bytes > encoded_size)
+      {
+        return false;
+      }
+      memcpy(data + out, encoded + in, bytes);
+      in += bytes;
+    }
+    out += bytes;
+  }
+  if (in + (size - out) != encoded_size)
+  {
+    return false;
+  }
+  memcpy(data + out, encoded + in, size - out);
+  return true;
+}
+
+MapFileWriter::MapFileWriter()
+  : m_next_chunk(0),
+    m_bytes_written(0)
+{
+  memset(&m_header, 0, sizeof(MapFileHeader));
+}
+
+MapFileWriter::~MapFileWriter()
+{
+  if (m_out.is_open())
+  {
+    m_out.close();
+  }
+}
+
+bool MapFileWriter::open(const std::string& path, const MapType map_type, const uint32_t voxel_size,
+                         const float voxel_side_length, const Vector3ui& dim, const uint64_t data_size,
+                         const MapFileEncoding encoding, const uint64_t chunk_size)
+{
+  m_path = path;
+  m_start_time = icl_core::TimeStamp::now();
+  m_out.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_out.is_open())
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Could not create file " << path << " !" << endl);
+    return false;
+  }
+
+  // chunks have to consist of whole voxels
+  const uint64_t requested_chunk_size = chunk_size != 0 ? chunk_size :
+      (encoding == eMFE_RAW ? cMAP_FILE_CHUNK_SIZE : cMAP_FILE_ENCODED_CHUNK_SIZE);
+  const uint64_t voxels_per_chunk = std::max<uint64_t>(1, requested_chunk_size / voxel_size);
+  const uint64_t bytes_per_chunk = voxels_per_chunk * voxel_size;
+
+  m_chunks.clear();
+  for (uint64_t raw_offset = 0; raw_offset < data_size; raw_offset += bytes_per_chunk)
+  {
+    MapFileChunk chunk;
+    chunk.offset = 0;
+    chunk.size = 0;
+    chunk.raw_offset = raw_offset;
+    chunk.raw_size = std::min(bytes_per_chunk, data_size - raw_offset);
+    chunk.checksum = 0;
+    m_chunks.push_back(chunk);
+  }
+  m_next_chunk = 0;
+  m_bytes_written = 0;
+
+  memcpy(m_header.magic, cMAP_FILE_MAGIC, sizeof(cMAP_FILE_MAGIC));
+  m_header.version = cMAP_FILE_VERSION;
+  m_header.byte_order_mark = cMAP_FILE_BYTE_ORDER_MARK;
+  m_header.map_type = map_type;
+  m_header.voxel_size = voxel_size;
+  m_header.voxel_side_length = voxel_side_length;
+  m_header.dim_x = dim.x;
+  m_header.dim_y = dim.y;
+  m_header.dim_z = dim.z;
+  m_header.num_chunks = m_chunks.size();
+  m_header.encoding = encoding;
+  const uint64_t table_end = sizeof(MapFileHeader) + m_chunks.size() * sizeof(MapFileChunk);
+  // only raw data is used in place and needs page alignment
+  const uint64_t alignment = encoding == eMFE_RAW ? cMAP_FILE_DATA_ALIGNMENT : sizeof(uint64_t);
+  m_header.data_offset = ((table_end + alignment - 1) / alignment) * alignment;
+  m_header.data_size = data_size;
+  m_header.checksum = 0;
+
+  // header and table are written on close(), when all checksums are known
+  m_out.seekp(m_header.data_offset);
+  return m_out.good();
+}
+
+bool MapFileWriter::writeChunk(const char* data)
+{
+  return writeChunks(data, 1);
+}
+
+bool MapFileWriter::writeChunks(const char* data, const uint32_t num_chunks)
+{
+  if (m_next_chunk + num_chunks > m_chunks.size())
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Only " << m_chunks.size() - m_next_chunk << " chunks of " <<
+                  m_path << " are left to write!" << endl);
+    return false;
+  }
+  const uint64_t base_offset = m_chunks[m_next_chunk].raw_offset;
+  std::vector<std::vector<char> > encoded(m_header.encoding == eMFE_RAW ? 0 : num_chunks);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int32_t i = 0; i < int32_t(num_chunks); ++i)
+  {
+    MapFileChunk& chunk = m_chunks[m_next_chunk + i];
+    const char* raw = data + (chunk.raw_offset - base_offset);
+    chunk.checksum = computeChecksum(raw, chunk.raw_size);
+    if (m_header.encoding != eMFE_RAW)
+    {
+      encodeRunLength(raw, chunk.raw_size, m_header.voxel_size, encoded[i]);
+    }
+  }
+
+  // the chunks are stored in order, so a raw file stays one contiguous array
+  for (uint32_t i = 0; i < num_chunks; ++i)
+  {
+    MapFileChunk& chunk = m_chunks[m_next_chunk + i];
+    const uint64_t previous_end = m_next_chunk + i == 0 ? 0 :
+        m_chunks[m_next_chunk + i - 1].offset + m_chunks[m_next_chunk + i - 1].size;
+    chunk.offset = previous_end;
+    if (m_header.encoding == eMFE_RAW)
+    {
+      chunk.size = chunk.raw_size;
+      m_out.write(data + (chunk.raw_offset - base_offset), chunk.size);
+    }
+    else
+    {
+      chunk.size = encoded[i].size();
+      if (chunk.size > 0)
+      {
+        m_out.write(&encoded[i][0], chunk.size);
+      }
+    }
+  }
+  m_next_chunk += num_chunks;
+  return m_out.good();
+}
+
+bool MapFileWriter::close()
+{
+  if (m_next_chunk != m_chunks.size())
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Only " << m_next_chunk << " of " << m_chunks.size() <<
+                  " chunks were written to " << m_path << " !" << endl);
+    m_out.close();
+    return false;
+  }
+
+  m_header.checksum = computeHeaderChecksum(m_header, m_chunks.empty() ? NULL : &m_chunks[0]);
+  m_bytes_written = m_chunks.empty() ? m_header.data_offset : m_header.data_offset + m_chunks.back().offset + m_chunks.back().size;
+  m_out.seekp(0);
+  m_out.write((const char*) &m_header, sizeof(MapFileHeader));
+  if (!m_chunks.empty())
+  {
+    m_out.write((const char*) &m_chunks[0], m_chunks.size() * sizeof(MapFileChunk));
+  }
+  const bool success = m_out.good();
+  m_out.close();
+  if (!success)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Writing to " << m_path << " failed!" << endl);
+    return false;
+  }
+
+  const double seconds = std::max<double>(1e-9, (icl_core::TimeStamp::now() - m_start_time).toNSec() * 1e-9);
+  LOGGING_INFO(Gpu_voxels_helpers, "MapFile: Wrote " << m_bytes_written << " Bytes for " << m_header.data_size <<
+               " Bytes of voxel data to " << m_path << " (ratio " <<
+               double(m_bytes_written) / std::max<uint64_t>(1, m_header.data_size) << ") with " <<
+               m_header.data_size * cBYTE2MBYTE / seconds << " MB/s." << endl);
+  return true;
+}
+
+MapFileReader::MapFileReader()
+  : m_mapping(NULL),
+    m_mapping_size(0),
+    m_header(NULL),
+    m_chunks(NULL)
+{
+}
+
+MapFileReader::~MapFileReader()
+{
+  close();
+}
+
+bool MapFileReader::isMapFile(const std::string& path)
+{
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  char magic[sizeof(cMAP_FILE_MAGIC)];
+  in.read(magic, sizeof(magic));
+  return in.good() && memcmp(magic, cMAP_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool MapFileReader::open(const std::string& path)
+{
+  close();
+  m_path = path;
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Could not open file " << path << " !" << endl);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || std::size_t(file_stat.st_size) < sizeof(MapFileHeader))
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << path << " is too small to be a map file!" << endl);
+    ::close(fd);
+    return false;
+  }
+
+  // private mapping: the voxels may be modified without writing them back to the file
+  m_mapping_size = file_stat.st_size;
+  void* mapping = mmap(NULL, m_mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Could not map file " << path << " !" << endl);
+    m_mapping_size = 0;
+    return false;
+  }
+  m_mapping = (char*) mapping;
+  m_header = (const MapFileHeader*) m_mapping;
+
+  if (memcmp(m_header->magic, cMAP_FILE_MAGIC, sizeof(cMAP_FILE_MAGIC)) != 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << path << " is not a map file!" << endl);
+    close();
+    return false;
+  }
+  if (m_header->byte_order_mark != cMAP_FILE_BYTE_ORDER_MARK)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << path << " was written on a machine with different byte order!" << endl);
+    close();
+    return false;
+  }
+  if (m_header->version != cMAP_FILE_VERSION)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Version " << m_header->version << " of " << path <<
+                  " is not supported, expected version " << cMAP_FILE_VERSION << "!" << endl);
+    close();
+    return false;
+  }
+  const uint64_t table_end = sizeof(MapFileHeader) + uint64_t(m_header->num_chunks) * sizeof(MapFileChunk);
+  if (table_end > m_header->data_offset || m_header->data_offset > m_mapping_size
+      || (m_header->encoding == eMFE_RAW && m_header->data_offset % cMAP_FILE_DATA_ALIGNMENT != 0)
+      || (m_header->encoding != eMFE_RAW && m_header->encoding != eMFE_RUN_LENGTH))
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << path << " is truncated or corrupted!" << endl);
+    close();
+    return false;
+  }
+  m_chunks = (const MapFileChunk*) (m_mapping + sizeof(MapFileHeader));
+  if (computeHeaderChecksum(*m_header, m_chunks) != m_header->checksum)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Header checksum of " << path << " does not match!" << endl);
+    close();
+    return false;
+  }
+  uint64_t raw_end = 0;
+  for (uint32_t i = 0; i < m_header->num_chunks; ++i)
+  {
+    const MapFileChunk& chunk = m_chunks[i];
+    if (chunk.raw_offset != raw_end || m_header->data_offset + chunk.offset + chunk.size > m_mapping_size
+        || (m_header->encoding == eMFE_RAW && (chunk.size != chunk.raw_size || chunk.offset != chunk.raw_offset)))
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Chunk " << i << " of " << path << " is corrupted!" << endl);
+      close();
+      return false;
+    }
+    raw_end += chunk.raw_size;
+  }
+  if (raw_end != m_header->data_size)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << path << " is truncated or corrupted!" << endl);
+    close();
+    return false;
+  }
+  // the data is read front to back in most cases
+  madvise(m_mapping, m_mapping_size, MADV_SEQUENTIAL);
+  return true;
+}
+
+bool MapFileReader::checkMetaData(const MapType map_type, const uint32_t voxel_size, const float voxel_side_length,
+                                  const Vector3ui& dim) const
+{
+  if (m_header->map_type != uint32_t(map_type))
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Map type of " << m_path << " does not match!" << endl);
+    return false;
+  }
+  if (m_header->voxel_size != voxel_size)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Voxel size of " << m_path << " (" << m_header->voxel_size <<
+                  " Bytes) does not match current object (" << voxel_size << " Bytes)!" << endl);
+    return false;
+  }
+  const Vector3ui file_dim(m_header->dim_x, m_header->dim_y, m_header->dim_z);
+  if (file_dim != dim)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Map dimension of " << m_path << " (" << file_dim <<
+                  ") does not match current object (" << dim << ")!" << endl);
+    return false;
+  }
+  if (m_header->voxel_side_length != voxel_side_length)
+  {
+    LOGGING_WARNING(Gpu_voxels_helpers, "MapFile: Voxel side length of " << m_path << " (" << m_header->voxel_side_length <<
+                    ") does not match current object (" << voxel_side_length << ")! Continuing though..." << endl);
+  }
+  return true;
+}
+
+bool MapFileReader::verifyChecksums() const
+{
+  const char* data = m_mapping + m_header->data_offset;
+  bool valid = true;
+
+#pragma omp parallel for schedule(dynamic) reduction(&&:valid)
+  for (int64_t i = 0; i < int64_t(m_header->num_chunks); ++i)
+  {
+    const MapFileChunk& chunk = m_chunks[i];
+    if (m_header->encoding == eMFE_RAW)
+    {
+      valid = valid && computeChecksum(data + chunk.offset, chunk.size) == chunk.checksum;
+    }
+    else
+    {
+      std::vector<char> decoded(chunk.raw_size);
+      valid = valid && decodeRunLength(data + chunk.offset, chunk.size, m_header->voxel_size,
+                                       decoded.empty() ? NULL : &decoded[0], chunk.raw_size)
+          && computeChecksum(decoded.empty() ? NULL : &decoded[0], chunk.raw_size) == chunk.checksum;
+    }
+  }
+
+  if (!valid)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Data checksum of " << m_path << " does not match!" << endl);
+  }
+  return valid;
+}
+
+bool MapFileReader::readChunks(char* data, const uint32_t first_chunk, const uint32_t num_chunks) const
+{
+  if (first_chunk + num_chunks > m_header->num_chunks)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: " << m_path << " only has " << m_header->num_chunks << " chunks!" << endl);
+    return false;
+  }
+  const char* stored = m_mapping + m_header->data_offset;
+  const uint64_t base_offset = num_chunks > 0 ? m_chunks[first_chunk].raw_offset : 0;
+  bool valid = true;
+
+#pragma omp parallel for schedule(dynamic) reduction(&&:valid)
+  for (int32_t i = 0; i < int32_t(num_chunks); ++i)
+  {
+    const MapFileChunk& chunk = m_chunks[first_chunk + i];
+    char* raw = data + (chunk.raw_offset - base_offset);
+    if (m_header->encoding == eMFE_RAW)
+    {
+      memcpy(raw, stored + chunk.offset, chunk.size);
+    }
+    else
+    {
+      valid = valid && decodeRunLength(stored + chunk.offset, chunk.size, m_header->voxel_size, raw, chunk.raw_size);
+    }
+    valid = valid && computeChecksum(raw, chunk.raw_size) == chunk.checksum;
+  }
+
+  if (!valid)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Data checksum of " << m_path << " does not match!" << endl);
+  }
+  return valid;
+}
+
+void* MapFileReader::releaseMapping(std::size_t& mapping_size)
+{
+  // the new owner accesses the voxels in any order, the read ahead of open() would only waste memory
+  madvise(m_mapping, m_mapping_size, MADV_NORMAL);
+  void* mapping = m_mapping;
+  mapping_size = m_mapping_size;
+  m_mapping = NULL;
+  m_mapping_size = 0;
+  m_header = NULL;
+  m_chunks = NULL;
+  return mapping;
+}
+
+void MapFileReader::close()
+{
+  if (m_mapping)
+  {
+    unmapMapFile(m_mapping, m_mapping_size);
+  }
+  m_mapping = NULL;
+  m_mapping_size = 0;
+  m_header = NULL;
+  m_chunks = NULL;
+}
+
+void unmapMapFile(void* mapping, const std::size_t mapping_size)
+{
+  if (munmap(mapping, mapping_size) != 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "MapFile: Could not unmap file!" << endl);
+  }
+}
+
+}  // end of namespace
+}  // end of namespace
@@ -0,0 +1,249 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Versioned on-disk format for voxel maps.
+ *
+ * Layout of a file:
+ *  - MapFileHeader
+ *  - MapFileChunk table with header.num_chunks entries
+ *  - padding up to header.data_offset, a multiple of cMAP_FILE_DATA_ALIGNMENT for raw files
+ *  - the chunks of the voxel data, header.data_size bytes when decoded
+ *
+ * All values are stored in the byte order of the writing machine, which
+ * is detected by the byte order mark. As the voxel data of raw files is
+ * page aligned, such a file can be memory mapped and used as voxel storage
+ * without copying. Run length encoded files have to be decoded, which is
+ * done in parallel for all chunks.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_MAP_FILE_H_INCLUDED
+#define GPU_VOXELS_HELPERS_MAP_FILE_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+//! Magic bytes at the beginning of every map file
+static const char cMAP_FILE_MAGIC[8] = { 'G', 'V', 'L', 'M', 'A', 'P', '\0', '\0' };
+//! Version of the format that is written
+static const uint32_t cMAP_FILE_VERSION = 1;
+//! Written in native byte order to detect files from machines with different endianness
+static const uint32_t cMAP_FILE_BYTE_ORDER_MARK = 0x01020304;
+//! The voxel data of raw files starts at a multiple of this offset
+static const uint64_t cMAP_FILE_DATA_ALIGNMENT = 4096;
+//! Default size of the chunks in which the voxel data is checksummed and transferred
+static const uint64_t cMAP_FILE_CHUNK_SIZE = 64 * 1024 * 1024;
+//! Default size of encoded chunks, which are smaller to encode and decode more of them in parallel
+static const uint64_t cMAP_FILE_ENCODED_CHUNK_SIZE = 4 * 1024 * 1024;
+
+enum MapFileEncoding
+{
+  eMFE_RAW = 0,
+  //! runs of equal voxels are stored once, see encodeRunLength()
+  eMFE_RUN_LENGTH = 1
+};
+
+struct MapFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  uint32_t map_type;
+  //! sizeof() of a voxel, which also covers the length of bitvectors
+  uint32_t voxel_size;
+  float voxel_side_length;
+  uint32_t dim_x;
+  uint32_t dim_y;
+  uint32_t dim_z;
+  uint32_t num_chunks;
+  //! MapFileEncoding of all chunks
+  uint32_t encoding;
+  //! offset of the first chunk from the beginning of the file
+  uint64_t data_offset;
+  //! size of the decoded voxel data
+  uint64_t data_size;
+  //! checksum of the header (with this field set to zero) and the chunk table
+  uint64_t checksum;
+};
+
+struct MapFileChunk
+{
+  //! offset of the stored chunk relative to MapFileHeader::data_offset
+  uint64_t offset;
+  //! number of stored bytes
+  uint64_t size;
+  //! offset of the decoded chunk within the voxel data
+  uint64_t raw_offset;
+  uint64_t raw_size;
+  //! checksum of the decoded chunk data, see computeChecksum()
+  uint64_t checksum;
+};
+
+/*!
+ * \brief computeChecksum FNV-1a style hash that consumes 64 bit words
+ * \param data Start of the data
+ * \param size Number of bytes
+ */
+uint64_t computeChecksum(const char* data, const uint64_t size, uint64_t seed = 14695981039346656037ULL);
+
+/*!
+ * \brief encodeRunLength Encodes \a data as runs of elements of \a element_size bytes.
+ * Each run starts with a 32 bit word. If its highest bit is set, the lower bits hold the
+ * number of repetitions of the single element that follows. Otherwise they hold the number
+ * of literal elements that follow. Trailing bytes that do not form a whole element are
+ * appended unencoded.
+ * \param encoded Is overwritten with the encoded data
+ */
+void encodeRunLength(const char* data, const uint64_t size, const uint32_t element_size, std::vector<char>& encoded);
+
+/*!
+ * \brief decodeRunLength Decodes data written by encodeRunLength()
+ * \return false if the encoded data does not decode to exactly \a size bytes
+ */
+bool decodeRunLength(const char* encoded, const uint64_t encoded_size, const uint32_t element_size,
+                     char* data, const uint64_t size);
+
+/*!
+ * Writes a map file chunk by chunk, so that device maps can be written
+ * through a staging buffer of some chunks.
+ */
+class MapFileWriter
+{
+public:
+  MapFileWriter();
+  ~MapFileWriter();
+
+  /*!
+   * \brief open Creates the file and reserves space for the header and the chunk table
+   * \param voxel_size Size of the elements that are run length encoded
+   * \param chunk_size Size of the decoded chunks, 0 selects the default of the encoding
+   * \return false if the file could not be created
+   */
+  bool open(const std::string& path, const MapType map_type, const uint32_t voxel_size,
+            const float voxel_side_length, const Vector3ui& dim, const uint64_t data_size,
+            const MapFileEncoding encoding = eMFE_RAW, const uint64_t chunk_size = 0);
+
+  uint32_t getNumberOfChunks() const { return m_chunks.size(); }
+  uint64_t getChunkRawOffset(const uint32_t chunk) const { return m_chunks[chunk].raw_offset; }
+  uint64_t getChunkRawSize(const uint32_t chunk) const { return m_chunks[chunk].raw_size; }
+
+  /*!
+   * \brief writeChunk Appends the next chunk. \a data has to hold getChunkRawSize() bytes.
+   */
+  bool writeChunk(const char* data);
+
+  /*!
+   * \brief writeChunks Encodes the next \a num_chunks chunks in parallel and appends them.
+   * \a data has to hold the decoded data of all of them.
+   */
+  bool writeChunks(const char* data, const uint32_t num_chunks);
+
+  /*!
+   * \brief close Writes header and chunk table after all chunks were written
+   * and logs the number of written bytes and the throughput.
+   * \return false if not all chunks were written or writing failed
+   */
+  bool close();
+
+  //! Size of the file, valid after close()
+  uint64_t getBytesWritten() const { return m_bytes_written; }
+
+private:
+  std::ofstream m_out;
+  std::string m_path;
+  MapFileHeader m_header;
+  std::vector<MapFileChunk> m_chunks;
+  uint32_t m_next_chunk;
+  uint64_t m_bytes_written;
+  icl_core::TimeStamp m_start_time;
+};
+
+/*!
+ * Memory maps a map file. The mapping is private, so the data may be
+ * modified without changing the file.
+ */
+class MapFileReader
+{
+public:
+  MapFileReader();
+
+  //! Unmaps the file, unless the mapping was released
+  ~MapFileReader();
+
+  //! Checks the magic bytes of \a path
+  static bool isMapFile(const std::string& path);
+
+  /*!
+   * \brief open Maps the file and checks magic, version, byte order and the header checksum
+   */
+  bool open(const std::string& path);
+
+  /*!
+   * \brief checkMetaData Compares the header with the map that should be loaded.
+   * A different voxel side length only causes a warning.
+   */
+  bool checkMetaData(const MapType map_type, const uint32_t voxel_size, const float voxel_side_length,
+                     const Vector3ui& dim) const;
+
+  //! Compares the checksums of all chunks, the chunks are processed in parallel
+  bool verifyChecksums() const;
+
+  const MapFileHeader& getHeader() const { return *m_header; }
+  const MapFileChunk& getChunk(const uint32_t chunk) const { return m_chunks[chunk]; }
+
+  //! Voxel data inside of the mapping, only usable for files with eMFE_RAW encoding
+  char* getData() { return m_mapping + m_header->data_offset; }
+
+  /*!
+   * \brief readChunks Decodes \a num_chunks chunks in parallel and verifies their checksums
+   * \param data Destination of the decoded data of the chunk \a first_chunk
+   */
+  bool readChunks(char* data, const uint32_t first_chunk, const uint32_t num_chunks) const;
+
+  /*!
+   * \brief releaseMapping Hands the ownership of the mapping over to the caller,
+   * who has to call unmapMapFile() with the returned values. The sequential access
+   * advice of open() is reset to the default.
+   */
+  void* releaseMapping(std::size_t& mapping_size);
+
+private:
+  void close();
+
+  char* m_mapping;
+  std::size_t m_mapping_size;
+  const MapFileHeader* m_header;
+  const MapFileChunk* m_chunks;
+  std::string m_path;
+};
+
+//! Unmaps a mapping returned by MapFileReader::releaseMapping()
+void unmapMapFile(void* mapping, const std::size_t mapping_size);
+
+}  // end of namespace
+}  // end of namespace
+#endif
@@ -0,0 +1,180 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parser for the Binvox file format, see MappedBinvoxFileReader.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/MappedBinvoxFileReader.h>
+#include <gpu_voxels/helpers/MappedFile.h>
+#include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/logging/logging_gpu_voxels_helpers.h>
+
+#include <sstream>
+#include <stdint.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+namespace {
+
+//! A run of occupied voxels
+struct BinvoxRun
+{
+  uint64_t first_voxel;
+  uint64_t first_point;
+  uint32_t length;
+};
+
+}
+
+bool MappedBinvoxFileReader::readPointCloud(const std::string filename, std::vector<Vector3f> &points)
+{
+  MappedFile file;
+  if (!file.open(filename))
+  {
+    return false;
+  }
+  const char* pos = file.getData();
+  const char* end = pos + file.getSize();
+
+  // the header consists of text lines up to the line "data"
+  int depth = -1;
+  int height = 0;
+  int width = 0;
+  float tx = 0.0f;
+  float ty = 0.0f;
+  float tz = 0.0f;
+  float scale = 1.0f;
+  bool done = false;
+  bool first_line = true;
+  while (pos < end && !done)
+  {
+    const char* line_end = nextLine(pos, end);
+    std::istringstream line(std::string(pos, line_end));
+    pos = line_end;
+
+    std::string keyword;
+    line >> keyword;
+    if (first_line)
+    {
+      if (keyword != "#binvox")
+      {
+        LOGGING_ERROR(Gpu_voxels_helpers, "Binvox: First line reads [" << keyword << "] instead of [#binvox]" << endl);
+        return false;
+      }
+      int version;
+      line >> version;
+      LOGGING_DEBUG(Gpu_voxels_helpers, "Binvox: Reading version " << version << endl);
+      first_line = false;
+    }
+    else if (keyword == "data")
+    {
+      done = true;
+    }
+    else if (keyword == "dim")
+    {
+      line >> depth >> height >> width;
+    }
+    else if (keyword == "translate")
+    {
+      line >> tx >> ty >> tz;
+    }
+    else if (keyword == "scale")
+    {
+      line >> scale;
+    }
+    else
+    {
+      LOGGING_WARNING(Gpu_voxels_helpers, "Binvox: unrecognized keyword [" << keyword << "], skipping" << endl);
+    }
+  }
+  if (!done)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "Binvox: Error reading header" << endl);
+    return false;
+  }
+  if (depth <= 0 || height <= 0 || width <= 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "Binvox: Missing dimensions in header" << endl);
+    return false;
+  }
+  scale = scale / width;
+
+  // collect the occupied runs, which gives the exact number of points
+  const uint64_t size = uint64_t(width) * height * depth;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(pos);
+  const uint64_t num_pairs = (end - pos) / 2;
+  std::vector<BinvoxRun> runs;
+  uint64_t index = 0;
+  uint64_t nr_voxels = 0;
+  for (uint64_t i = 0; i < num_pairs && index < size; ++i)
+  {
+    const uint8_t value = data[2 * i];
+    const uint8_t count = data[2 * i + 1];
+    if (index + count > size)
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "Binvox: Voxel data exceeds the dimensions" << endl);
+      return false;
+    }
+    if (value == 1 && count > 0)
+    {
+      // merge with the previous run, as long runs are split into pairs of at most 255 voxels
+      if (!runs.empty() && runs.back().first_voxel + runs.back().length == index)
+      {
+        runs.back().length += count;
+      }
+      else
+      {
+        BinvoxRun run;
+        run.first_voxel = index;
+        run.first_point = nr_voxels;
+        run.length = count;
+        runs.push_back(run);
+      }
+      nr_voxels += count;
+    }
+    index += count;
+  }
+  LOGGING_DEBUG(Gpu_voxels_helpers, "Binvox: Generating pointcloud from " << nr_voxels << " occupied Voxels" << endl);
+
+  // The x-axis is the most significant axis, then the z-axis, then the y-axis.
+  const std::size_t first_point = points.size();
+  points.resize(first_point + nr_voxels);
+  const uint64_t slice_size = uint64_t(width) * height;
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int64_t r = 0; r < int64_t(runs.size()); ++r)
+  {
+    const BinvoxRun& run = runs[r];
+    Vector3f* out = &points[first_point + run.first_point];
+    for (uint64_t voxel = run.first_voxel; voxel < run.first_voxel + run.length; ++voxel)
+    {
+      const uint64_t x = voxel / slice_size;
+      const uint64_t z = (voxel / width) % height;
+      const uint64_t y = voxel % width;
+      *out++ = Vector3f(scale * x + tx, scale * y + ty, scale * z + tz);
+    }
+  }
+
+  LOGGING_DEBUG(
+      Gpu_voxels_helpers,
+      "Binvox Handler: loaded " << points.size() << " points ("<< (points.size()*sizeof(Vector3f)) * cBYTE2MBYTE << " MB on CPU) from "<< filename.c_str() << "." << endl);
+  return true;
+}
+
+} // end of namespace
+} // end of namespace
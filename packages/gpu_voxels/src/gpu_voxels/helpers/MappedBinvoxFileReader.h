@@ -0,0 +1,51 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parser for the Binvox file format that memory maps the file and
+ * generates the points of the occupied runs in parallel. Creates the
+ * same points as the BinvoxFileReader.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_MAPPED_BINVOX_FILE_READER_H_INCLUDED
+#define GPU_VOXELS_HELPERS_MAPPED_BINVOX_FILE_READER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <gpu_voxels/helpers/FileReaderInterface.h>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+class MappedBinvoxFileReader : public FileReaderInterface
+{
+public:
+  /*!
+   * \brief readPointCloud is the file specific parsing function that has to be implemented
+   * \param filename Filename
+   * \param points points are appended to this vector
+   * \return true if succeeded, false otherwise
+   */
+  virtual bool readPointCloud(const std::string filename, std::vector<Vector3f> &points);
+};
+
+}  // end of namespace
+}  // end of namespace
+#endif
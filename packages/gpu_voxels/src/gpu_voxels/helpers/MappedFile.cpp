@@ -0,0 +1,280 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Read only memory mapping of whole files, see MappedFile.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/MappedFile.h>
+#include <gpu_voxels/logging/logging_gpu_voxels_helpers.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace gpu_voxels {
+namespace file_handling {
+
+namespace {
+
+inline bool isBlank(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(const char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+//! Case insensitive comparison with a lower case word
+inline bool matchesWord(const char* pos, const char* end, const char* word)
+{
+  for (; *word; ++word, ++pos)
+  {
+    if (pos >= end || (*pos | 0x20) != *word)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+MappedFile::MappedFile()
+  : m_data(NULL),
+    m_size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "Could not open file " << path << " !" << endl);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "Could not stat file " << path << " !" << endl);
+    ::close(fd);
+    return false;
+  }
+  if (file_stat.st_size == 0)
+  {
+    ::close(fd);
+    return true;
+  }
+
+  void* mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "Could not map file " << path << " !" << endl);
+    return false;
+  }
+  madvise(mapping, file_stat.st_size, MADV_SEQUENTIAL);
+  m_data = static_cast<const char*>(mapping);
+  m_size = file_stat.st_size;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (m_data)
+  {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+  m_data = NULL;
+  m_size = 0;
+}
+
+std::size_t getNumberOfParserThreads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void splitAtLines(const char* data, const std::size_t size, const std::size_t num_parts,
+                  std::vector<std::size_t>& bounds)
+{
+  bounds.resize(num_parts + 1);
+  bounds[0] = 0;
+  for (std::size_t i = 1; i < num_parts; ++i)
+  {
+    // start at the line following the even split position
+    const std::size_t split = std::max(bounds[i - 1], size / num_parts * i);
+    bounds[i] = split == 0 ? 0 : nextLine(data + split - 1, data + size) - data;
+  }
+  bounds[num_parts] = size;
+}
+
+bool parseFloat(const char*& pos, const char* end, float& value)
+{
+  static const double cPOWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  const char* p = pos;
+  while (p < end && isBlank(*p))
+  {
+    ++p;
+  }
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  double result;
+  if (matchesWord(p, end, "nan"))
+  {
+    result = std::numeric_limits<double>::quiet_NaN();
+    p += 3;
+  }
+  else if (matchesWord(p, end, "inf"))
+  {
+    result = std::numeric_limits<double>::infinity();
+    p += matchesWord(p, end, "infinity") ? 8 : 3;
+  }
+  else
+  {
+    // at most 19 significant digits fit into the mantissa, the others only scale it
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; p < end && isDigit(*p); ++p)
+    {
+      has_digits = true;
+      if (significant_digits < 19)
+      {
+        mantissa = mantissa * 10 + (*p - '0');
+        significant_digits += (mantissa != 0);
+      }
+      else
+      {
+        ++exponent;
+      }
+    }
+    if (p < end && *p == '.')
+    {
+      for (++p; p < end && isDigit(*p); ++p)
+      {
+        has_digits = true;
+        if (significant_digits < 19)
+        {
+          mantissa = mantissa * 10 + (*p - '0');
+          significant_digits += (mantissa != 0);
+          --exponent;
+        }
+      }
+    }
+    if (!has_digits)
+    {
+      return false;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      const char* e = p + 1;
+      bool negative_exponent = false;
+      if (e < end && (*e == '-' || *e == '+'))
+      {
+        negative_exponent = (*e == '-');
+        ++e;
+      }
+      if (e < end && isDigit(*e))
+      {
+        int explicit_exponent = 0;
+        for (; e < end && isDigit(*e); ++e)
+        {
+          explicit_exponent = std::min(explicit_exponent * 10 + (*e - '0'), 100000);
+        }
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        p = e;
+      }
+    }
+
+    result = double(mantissa);
+    if (mantissa == 0)
+    {
+      result = 0.0;
+    }
+    else if (exponent >= 0 && exponent <= 22)
+    {
+      result *= cPOWERS_OF_TEN[exponent];
+    }
+    else if (exponent < 0 && exponent >= -22)
+    {
+      result /= cPOWERS_OF_TEN[-exponent];
+    }
+    else
+    {
+      result *= std::pow(10.0, exponent);
+    }
+  }
+
+  if (p < end && !isBlank(*p) && *p != '\n')
+  {
+    return false;
+  }
+  value = float(negative ? -result : result);
+  pos = p;
+  return true;
+}
+
+bool skipToken(const char*& pos, const char* end)
+{
+  const char* p = pos;
+  while (p < end && isBlank(*p))
+  {
+    ++p;
+  }
+  if (p >= end || *p == '\n')
+  {
+    return false;
+  }
+  while (p < end && !isBlank(*p) && *p != '\n')
+  {
+    ++p;
+  }
+  pos = p;
+  return true;
+}
+
+}  // end of namespace
+}  // end of namespace
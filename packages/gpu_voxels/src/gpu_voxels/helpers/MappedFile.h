@@ -0,0 +1,94 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Read only memory mapping of whole files and the parsing helpers
+ * that are shared by the memory mapped point cloud readers.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_MAPPED_FILE_H_INCLUDED
+#define GPU_VOXELS_HELPERS_MAPPED_FILE_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+/*!
+ * Maps a file read only into memory for the lifetime of the object.
+ */
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  //! Maps the whole file, empty files can be opened but have no data
+  bool open(const std::string& path);
+  void close();
+
+  const char* getData() const { return m_data; }
+  std::size_t getSize() const { return m_size; }
+
+private:
+  //! Not copyable, as the mapping is owned
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  const char* m_data;
+  std::size_t m_size;
+};
+
+//! Number of threads that are used by the parsers
+std::size_t getNumberOfParserThreads();
+
+/*!
+ * \brief splitAtLines Splits the text into \a num_parts ranges that all start at the beginning of a line
+ * \param bounds Is filled with num_parts + 1 offsets, range i is [bounds[i], bounds[i+1])
+ */
+void splitAtLines(const char* data, const std::size_t size, const std::size_t num_parts,
+                  std::vector<std::size_t>& bounds);
+
+/*!
+ * \brief parseFloat Parses a decimal floating point number, "nan" or "inf".
+ * Leading blanks are skipped, newlines are not. The number has to be followed by
+ * whitespace or \a end.
+ * \param pos Is advanced behind the number on success
+ * \return false if there is no number at \a pos
+ */
+bool parseFloat(const char*& pos, const char* end, float& value);
+
+/*!
+ * \brief skipToken Skips leading blanks and the following token of the current line
+ * \return false if the line has no more tokens
+ */
+bool skipToken(const char*& pos, const char* end);
+
+//! Returns the beginning of the next line or \a end
+inline const char* nextLine(const char* pos, const char* end)
+{
+  const char* line_end = static_cast<const char*>(memchr(pos, '\n', end - pos));
+  return line_end ? line_end + 1 : end;
+}
+
+}  // end of namespace
+}  // end of namespace
+#endif
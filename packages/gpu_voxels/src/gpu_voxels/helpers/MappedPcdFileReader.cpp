@@ -0,0 +1,424 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parser for PCD files, see MappedPcdFileReader.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/MappedPcdFileReader.h>
+#include <gpu_voxels/helpers/MappedFile.h>
+#include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/logging/logging_gpu_voxels_helpers.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+namespace {
+
+struct PcdField
+{
+  std::string name;
+  uint32_t size;
+  char type;
+  uint32_t count;
+};
+
+struct PcdHeader
+{
+  std::vector<PcdField> fields;
+  uint64_t width;
+  uint64_t height;
+  uint64_t points;
+  std::string data;
+  //! offset of the first byte after the DATA line
+  std::size_t data_offset;
+};
+
+//! Reads one of the x, y or z fields, which may be float or double
+inline float readCoordinate(const char* pos, const uint32_t size)
+{
+  if (size == sizeof(double))
+  {
+    double value;
+    memcpy(&value, pos, sizeof(double));
+    return float(value);
+  }
+  float value;
+  memcpy(&value, pos, sizeof(float));
+  return value;
+}
+
+inline bool isEmptyLine(const char* pos, const char* line_end)
+{
+  for (; pos < line_end; ++pos)
+  {
+    if (*pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n')
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parseHeader(const char* data, const std::size_t size, const std::string& filename, PcdHeader& header)
+{
+  header.width = header.height = header.points = 0;
+  bool has_points = false;
+  const char* end = data + size;
+  const char* pos = data;
+  while (pos < end)
+  {
+    const char* line_end = nextLine(pos, end);
+    std::istringstream line(std::string(pos, line_end));
+    pos = line_end;
+
+    std::string keyword;
+    if (!(line >> keyword) || keyword[0] == '#')
+    {
+      continue;
+    }
+    if (keyword == "FIELDS")
+    {
+      std::string name;
+      while (line >> name)
+      {
+        PcdField field;
+        field.name = name;
+        field.size = 4;
+        field.type = 'F';
+        field.count = 1;
+        header.fields.push_back(field);
+      }
+    }
+    else if (keyword == "SIZE" || keyword == "TYPE" || keyword == "COUNT")
+    {
+      for (std::size_t i = 0; i < header.fields.size(); ++i)
+      {
+        if (keyword == "SIZE")
+        {
+          line >> header.fields[i].size;
+        }
+        else if (keyword == "TYPE")
+        {
+          line >> header.fields[i].type;
+        }
+        else
+        {
+          line >> header.fields[i].count;
+        }
+      }
+      if (line.fail())
+      {
+        LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Line " << keyword << " of " << filename << " does not match FIELDS!" << endl);
+        return false;
+      }
+    }
+    else if (keyword == "WIDTH")
+    {
+      line >> header.width;
+    }
+    else if (keyword == "HEIGHT")
+    {
+      line >> header.height;
+    }
+    else if (keyword == "POINTS")
+    {
+      line >> header.points;
+      has_points = true;
+    }
+    else if (keyword == "DATA")
+    {
+      line >> header.data;
+      header.data_offset = pos - data;
+      if (!has_points)
+      {
+        header.points = header.width * header.height;
+      }
+      return true;
+    }
+    // VERSION and VIEWPOINT are not needed
+  }
+  LOGGING_ERROR(Gpu_voxels_helpers, "PCD: " << filename << " has no DATA line!" << endl);
+  return false;
+}
+
+//! Parses the ascii data lines of [pos, end) into \a points
+bool parseAsciiRange(const char* pos, const char* end, const uint32_t* coordinate_tokens,
+                     const uint32_t num_tokens, Vector3f* points)
+{
+  while (pos < end)
+  {
+    const char* line_end = nextLine(pos, end);
+    if (!isEmptyLine(pos, line_end))
+    {
+      float values[3];
+      for (uint32_t token = 0; token < num_tokens; ++token)
+      {
+        bool parsed = false;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+          if (coordinate_tokens[c] == token)
+          {
+            parsed = parseFloat(pos, line_end, values[c]);
+            if (!parsed)
+            {
+              return false;
+            }
+          }
+        }
+        if (!parsed && !skipToken(pos, line_end))
+        {
+          return false;
+        }
+      }
+      *points++ = Vector3f(values[0], values[1], values[2]);
+    }
+    pos = line_end;
+  }
+  return true;
+}
+
+}
+
+bool decompressLzf(const char* in, const std::size_t in_size, char* out, const std::size_t out_size)
+{
+  const uint8_t* ip = reinterpret_cast<const uint8_t*>(in);
+  const uint8_t* const in_end = ip + in_size;
+  uint8_t* op = reinterpret_cast<uint8_t*>(out);
+  uint8_t* const out_begin = op;
+  uint8_t* const out_end = op + out_size;
+
+  while (ip < in_end)
+  {
+    std::size_t ctrl = *ip++;
+    if (ctrl < 32)
+    {
+      // literal run of ctrl + 1 bytes
+      ++ctrl;
+      if (op + ctrl > out_end || ip + ctrl > in_end)
+      {
+        return false;
+      }
+      memcpy(op, ip, ctrl);
+      op += ctrl;
+      ip += ctrl;
+    }
+    else
+    {
+      // back reference, which may overlap with the output
+      std::size_t length = ctrl >> 5;
+      if (length == 7)
+      {
+        if (ip >= in_end)
+        {
+          return false;
+        }
+        length += *ip++;
+      }
+      length += 2;
+      if (ip >= in_end)
+      {
+        return false;
+      }
+      const std::size_t distance = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+      if (op + length > out_end || distance > std::size_t(op - out_begin))
+      {
+        return false;
+      }
+      const uint8_t* ref = op - distance;
+      for (std::size_t i = 0; i < length; ++i)
+      {
+        *op++ = *ref++;
+      }
+    }
+  }
+  return op == out_end;
+}
+
+bool MappedPcdFileReader::readPointCloud(const std::string filename, std::vector<Vector3f> &points)
+{
+  MappedFile file;
+  PcdHeader header;
+  if (!file.open(filename) || !parseHeader(file.getData(), file.getSize(), filename, header))
+  {
+    return false;
+  }
+
+  // locate the coordinates within a point
+  const char* cNAMES[3] = { "x", "y", "z" };
+  uint32_t coordinate_fields[3];
+  uint32_t coordinate_tokens[3];
+  uint32_t num_tokens = 0;
+  std::vector<uint64_t> field_offsets(header.fields.size() + 1, 0);
+  for (uint32_t c = 0; c < 3; ++c)
+  {
+    coordinate_fields[c] = header.fields.size();
+  }
+  for (std::size_t f = 0; f < header.fields.size(); ++f)
+  {
+    const PcdField& field = header.fields[f];
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+      if (field.name == cNAMES[c])
+      {
+        if (field.type != 'F' || (field.size != sizeof(float) && field.size != sizeof(double)))
+        {
+          LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Field " << field.name << " of " << filename <<
+                        " is no float or double field!" << endl);
+          return false;
+        }
+        coordinate_fields[c] = f;
+        coordinate_tokens[c] = num_tokens;
+      }
+    }
+    field_offsets[f + 1] = field_offsets[f] + uint64_t(field.size) * field.count;
+    num_tokens += field.count;
+  }
+  for (uint32_t c = 0; c < 3; ++c)
+  {
+    if (coordinate_fields[c] == header.fields.size())
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "PCD: " << filename << " has no " << cNAMES[c] << " field!" << endl);
+      return false;
+    }
+  }
+
+  const uint64_t point_size = field_offsets[header.fields.size()];
+  const char* data = file.getData() + header.data_offset;
+  const std::size_t data_size = file.getSize() - header.data_offset;
+  const std::size_t first_point = points.size();
+  bool success = true;
+
+  if (header.data == "ascii")
+  {
+    // count the lines of each range to parse them right into place
+    const std::size_t num_parts = std::max<std::size_t>(1, std::min<std::size_t>(getNumberOfParserThreads() * 4,
+                                                                                 data_size / (64 * 1024)));
+    std::vector<std::size_t> bounds;
+    splitAtLines(data, data_size, num_parts, bounds);
+    std::vector<std::size_t> offsets(num_parts + 1, first_point);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < int(num_parts); ++i)
+    {
+      std::size_t lines = 0;
+      for (const char* pos = data + bounds[i]; pos < data + bounds[i + 1];)
+      {
+        const char* line_end = nextLine(pos, data + bounds[i + 1]);
+        lines += !isEmptyLine(pos, line_end);
+        pos = line_end;
+      }
+      offsets[i + 1] = lines;
+    }
+    for (std::size_t i = 0; i < num_parts; ++i)
+    {
+      offsets[i + 1] += offsets[i];
+    }
+    if (offsets[num_parts] - first_point != header.points)
+    {
+      LOGGING_WARNING(Gpu_voxels_helpers, "PCD: " << filename << " holds " << offsets[num_parts] - first_point <<
+                      " points instead of " << header.points << "!" << endl);
+    }
+    points.resize(offsets[num_parts]);
+#pragma omp parallel for schedule(dynamic) reduction(&&:success)
+    for (int i = 0; i < int(num_parts); ++i)
+    {
+      success = success && parseAsciiRange(data + bounds[i], data + bounds[i + 1], coordinate_tokens, num_tokens,
+                                            points.empty() ? NULL : &points[0] + offsets[i]);
+    }
+  }
+  else if (header.data == "binary")
+  {
+    if (header.points * point_size > data_size)
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Binary data of " << filename << " is truncated!" << endl);
+      return false;
+    }
+    points.resize(first_point + header.points);
+#pragma omp parallel for
+    for (int64_t i = 0; i < int64_t(header.points); ++i)
+    {
+      const char* point = data + i * point_size;
+      float values[3];
+      for (uint32_t c = 0; c < 3; ++c)
+      {
+        const uint32_t f = coordinate_fields[c];
+        values[c] = readCoordinate(point + field_offsets[f], header.fields[f].size);
+      }
+      points[first_point + i] = Vector3f(values[0], values[1], values[2]);
+    }
+  }
+  else if (header.data == "binary_compressed")
+  {
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+    if (data_size < 2 * sizeof(uint32_t))
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Compressed data of " << filename << " is truncated!" << endl);
+      return false;
+    }
+    memcpy(&compressed_size, data, sizeof(uint32_t));
+    memcpy(&uncompressed_size, data + sizeof(uint32_t), sizeof(uint32_t));
+    std::vector<char> buffer(uncompressed_size);
+    if (compressed_size > data_size - 2 * sizeof(uint32_t) || header.points * point_size != uncompressed_size
+        || (uncompressed_size > 0 &&
+            !decompressLzf(data + 2 * sizeof(uint32_t), compressed_size, &buffer[0], uncompressed_size)))
+    {
+      LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Compressed data of " << filename << " is corrupted!" << endl);
+      return false;
+    }
+
+    // the decompressed data holds all values of one field after the other
+    points.resize(first_point + header.points);
+#pragma omp parallel for
+    for (int64_t i = 0; i < int64_t(header.points); ++i)
+    {
+      float values[3];
+      for (uint32_t c = 0; c < 3; ++c)
+      {
+        const uint32_t f = coordinate_fields[c];
+        const uint64_t field_point_size = uint64_t(header.fields[f].size) * header.fields[f].count;
+        values[c] = readCoordinate(&buffer[header.points * field_offsets[f] + i * field_point_size],
+                                   header.fields[f].size);
+      }
+      points[first_point + i] = Vector3f(values[0], values[1], values[2]);
+    }
+  }
+  else
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Data format " << header.data << " of " << filename << " is not supported!" << endl);
+    return false;
+  }
+
+  if (!success)
+  {
+    LOGGING_ERROR(Gpu_voxels_helpers, "PCD: Could not parse the ascii data of " << filename << " !" << endl);
+    points.resize(first_point);
+    return false;
+  }
+
+  LOGGING_DEBUG(
+      Gpu_voxels_helpers,
+      "PCD Handler: loaded " << points.size() << " points ("<< (points.size()*sizeof(Vector3f)) * cBYTE2MBYTE << " MB on CPU) from "<< filename.c_str() << "." << endl);
+  return true;
+}
+
+} // end of namespace
+} // end of namespace
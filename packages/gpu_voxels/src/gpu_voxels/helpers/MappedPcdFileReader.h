@@ -0,0 +1,59 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parser for PCD files that does not need PCL. Supports the ascii,
+ * binary and binary_compressed data formats with float or double
+ * x, y and z fields.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_MAPPED_PCD_FILE_READER_H_INCLUDED
+#define GPU_VOXELS_HELPERS_MAPPED_PCD_FILE_READER_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <gpu_voxels/helpers/FileReaderInterface.h>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+class MappedPcdFileReader : public FileReaderInterface
+{
+public:
+  /*!
+   * \brief readPointCloud Reads the x, y and z fields of all points in parallel.
+   * Invalid (NaN) points are kept, like PCL does.
+   * \param filename Filename
+   * \param points points are appended to this vector
+   * \return true if succeeded, false otherwise
+   */
+  virtual bool readPointCloud(const std::string filename, std::vector<Vector3f> &points);
+};
+
+/*!
+ * \brief decompressLzf Decompresses LZF data, which is used by binary_compressed PCD files
+ * \return false if the data is corrupted or does not decompress to exactly \a out_size bytes
+ */
+bool decompressLzf(const char* in, const std::size_t in_size, char* out, const std::size_t out_size);
+
+}  // end of namespace
+}  // end of namespace
+#endif
@@ -0,0 +1,98 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parallel parser for XYZ files, see MappedXyzFileReader.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/helpers/MappedXyzFileReader.h>
+#include <gpu_voxels/helpers/MappedFile.h>
+#include <gpu_voxels/helpers/common_defines.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+namespace {
+
+//! Parses all lines of [pos, end), which has to start at the beginning of a line
+void parseXyzRange(const char* pos, const char* end, std::vector<Vector3f>& points)
+{
+  while (pos < end)
+  {
+    const char* line_end = nextLine(pos, end);
+    Vector3f vec;
+    while (parseFloat(pos, line_end, vec.x) && parseFloat(pos, line_end, vec.y) && parseFloat(pos, line_end, vec.z))
+    {
+      points.push_back(vec);
+    }
+    pos = line_end;
+  }
+}
+
+}
+
+bool MappedXyzFileReader::readPointCloud(const std::string filename, std::vector<Vector3f> &points)
+{
+  MappedFile file;
+  if (!file.open(filename))
+  {
+    return false;
+  }
+
+  // more ranges than threads to balance lines of different length
+  const std::size_t num_parts = std::max<std::size_t>(1, std::min<std::size_t>(getNumberOfParserThreads() * 4,
+                                                                               file.getSize() / (64 * 1024)));
+  std::vector<std::size_t> bounds;
+  splitAtLines(file.getData(), file.getSize(), num_parts, bounds);
+
+  std::vector<std::vector<Vector3f> > part_points(num_parts);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < int(num_parts); ++i)
+  {
+    // a line of three floats like "1.2345 -2.3456 3.4567" takes about 24 characters,
+    // the vector grows if the points are written shorter
+    part_points[i].reserve((bounds[i + 1] - bounds[i]) / 24 + 1);
+    parseXyzRange(file.getData() + bounds[i], file.getData() + bounds[i + 1], part_points[i]);
+  }
+
+  // allocate the exact number of points once and gather the ranges
+  std::vector<std::size_t> offsets(num_parts + 1, points.size());
+  for (std::size_t i = 0; i < num_parts; ++i)
+  {
+    offsets[i + 1] = offsets[i] + part_points[i].size();
+  }
+  points.resize(offsets[num_parts]);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < int(num_parts); ++i)
+  {
+    if (!part_points[i].empty())
+    {
+      memcpy(&points[offsets[i]], &part_points[i][0], part_points[i].size() * sizeof(Vector3f));
+    }
+  }
+
+  LOGGING_DEBUG(
+      Gpu_voxels_helpers,
+      "XYZ-FileReader: loaded " << points.size() << " points ("<< (points.size()*sizeof(Vector3f)) * cBYTE2MBYTE << " MB on CPU) from "<< filename.c_str() << "." << endl);
+  return true;
+}
+
+} // end of namespace
+} // end of namespace
@@ -0,0 +1,51 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Parser for XYZ files that memory maps the file and parses it in
+ * parallel. Accepts the same input as the XyzFileReader.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_HELPERS_MAPPED_XYZ_FILE_READER_H_INCLUDED
+#define GPU_VOXELS_HELPERS_MAPPED_XYZ_FILE_READER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <gpu_voxels/helpers/FileReaderInterface.h>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+
+namespace gpu_voxels {
+namespace file_handling {
+
+class MappedXyzFileReader : public FileReaderInterface
+{
+public:
+  /*!
+   * \brief readPointCloud Reads all triples of each line until the first token that is no number.
+   * The file is split into ranges of whole lines that are parsed in parallel.
+   * \param filename Filename
+   * \param points points are appended to this vector
+   * \return true if succeeded, false otherwise
+   */
+  virtual bool readPointCloud(const std::string filename, std::vector<Vector3f> &points);
+};
+
+}  // end of namespace
+}  // end of namespace
+#endif
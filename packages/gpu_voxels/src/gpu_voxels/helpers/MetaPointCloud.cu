@@ -17,10 +17,14 @@
 #include "gpu_voxels/helpers/kernels/HelperOperations.h"
 #include <gpu_voxels/helpers/PointcloudFileHandler.h>
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <cstdlib>
 
 namespace gpu_voxels {
 
+//! Up to this number of clouds transformSubClouds() caches the transformations in shared memory
+static const uint16_t cMAX_SHARED_TRANSFORMATIONS = 256;
+
 void MetaPointCloud::init(const std::vector<uint32_t> &_point_cloud_sizes)
 {
   m_point_cloud_sizes = _point_cloud_sizes;
@@ -32,7 +36,13 @@ void MetaPointCloud::init(const std::vector<uint32_t> &_point_cloud_sizes)
   m_dev_ptr_to_cloud_sizes = 0;
   m_dev_ptr_to_accumulated_cloud = 0;
   m_dev_ptr_to_clouds_base_addresses = 0;
+  m_dev_ptr_to_point_cloud_ids = 0;
+  m_transformations_dev = 0;
   m_point_clouds_local = 0;
+  m_staging_buffers[0] = 0;
+  m_staging_buffers[1] = 0;
+  // nothing is on the device yet
+  m_dirty_clouds.assign(m_num_clouds, true);
 
   // allocate point clouds space on host:
   m_point_clouds_local = new MetaPointCloudStruct();
@@ -95,6 +105,26 @@ void MetaPointCloud::init(const std::vector<uint32_t> &_point_cloud_sizes)
 
   //printf("Addr of m_dev_ptr_to_clouds_base_addresses: %p\n", m_dev_ptr_to_clouds_base_addresses);
 
+  // the cloud id of every point and one transformation per cloud for transformSubClouds()
+  std::vector<uint16_t> point_cloud_ids(m_accumulated_pointcloud_size);
+  std::vector<uint16_t>::iterator ids_iterator = point_cloud_ids.begin();
+  for (uint16_t i = 0; i < m_num_clouds; i++)
+  {
+    std::fill(ids_iterator, ids_iterator + _point_cloud_sizes[i], i);
+    ids_iterator += _point_cloud_sizes[i];
+  }
+  HANDLE_CUDA_ERROR(
+      cudaMalloc((void** )&m_dev_ptr_to_point_cloud_ids, m_accumulated_pointcloud_size * sizeof(uint16_t)));
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(m_dev_ptr_to_point_cloud_ids, point_cloud_ids.data(), m_accumulated_pointcloud_size * sizeof(uint16_t),
+                 cudaMemcpyHostToDevice));
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_transformations_dev, m_num_clouds * sizeof(Matrix4f)));
+
+  if (m_upload_mode == MPU_ASYNC)
+  {
+    allocateStagingBuffers();
+  }
+
   // copy the structure with the device pointers to the device
   m_dev_point_clouds_local = new MetaPointCloudStruct();
   m_dev_point_clouds_local->num_clouds = m_num_clouds;
@@ -144,6 +174,7 @@ void MetaPointCloud::addClouds(const std::vector<std::string> &_point_cloud_file
 
 
 MetaPointCloud::MetaPointCloud(const std::vector<std::string> &_point_cloud_files, bool use_model_path)
+  : m_upload_mode(MPU_SYNC)
 {
   addClouds(_point_cloud_files, use_model_path);
   // used for transformations:
@@ -152,7 +183,7 @@ MetaPointCloud::MetaPointCloud(const std::vector<std::string> &_point_cloud_file
 
 MetaPointCloud::MetaPointCloud(const std::vector<std::string> &_point_cloud_files,
                const std::vector<std::string> &_point_cloud_names, bool use_model_path)
-
+  : m_upload_mode(MPU_SYNC)
 {
   addClouds(_point_cloud_files, use_model_path);
 
@@ -172,6 +203,7 @@ MetaPointCloud::MetaPointCloud(const std::vector<std::string> &_point_cloud_file
 
 
 MetaPointCloud::MetaPointCloud()
+  : m_upload_mode(MPU_SYNC)
 {
   const std::vector<uint32_t> _point_cloud_sizes(0,0);
   init(_point_cloud_sizes);
@@ -180,6 +212,7 @@ MetaPointCloud::MetaPointCloud()
 }
 
 MetaPointCloud::MetaPointCloud(const std::vector<uint32_t> &_point_cloud_sizes)
+  : m_upload_mode(MPU_SYNC)
 {
   init(_point_cloud_sizes);
   // used for transformations:
@@ -187,6 +220,7 @@ MetaPointCloud::MetaPointCloud(const std::vector<uint32_t> &_point_cloud_sizes)
 }
 
 MetaPointCloud::MetaPointCloud(const MetaPointCloud &other)
+  : m_upload_mode(MPU_SYNC)
 {
   init(other.getPointcloudSizes());
   m_point_cloud_names = other.getCloudNames();
@@ -195,9 +229,12 @@ MetaPointCloud::MetaPointCloud(const MetaPointCloud &other)
     updatePointCloud(i, other.getPointCloud(i), other.getPointcloudSize(i), false);
   }
   // copy all clouds on the device
+  other.waitForUploads();
   HANDLE_CUDA_ERROR(
       cudaMemcpy(m_dev_ptr_to_accumulated_cloud, other.m_dev_ptr_to_accumulated_cloud,
                  sizeof(Vector3f) * other.getAccumulatedPointcloudSize(), cudaMemcpyDeviceToDevice));
+  m_dirty_clouds = other.m_dirty_clouds;
+  setUploadMode(other.m_upload_mode);
   // used for transformations:
   HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_transformation_dev, sizeof(Matrix4f)));
 }
@@ -215,9 +252,11 @@ MetaPointCloud& MetaPointCloud::operator=(const MetaPointCloud& other)
       updatePointCloud(i, other.getPointCloud(i), other.getPointcloudSize(i), false);
     }
     // copy all clouds on the device
+    other.waitForUploads();
     HANDLE_CUDA_ERROR(
         cudaMemcpy(m_dev_ptr_to_accumulated_cloud, other.m_dev_ptr_to_accumulated_cloud,
                    sizeof(Vector3f) * other.getAccumulatedPointcloudSize(), cudaMemcpyDeviceToDevice));
+    m_dirty_clouds = other.m_dirty_clouds;
   }
   return *this;
 }
@@ -287,6 +326,7 @@ bool MetaPointCloud::operator==(const MetaPointCloud& other) const
 }
 
 MetaPointCloud::MetaPointCloud(const std::vector<std::vector<Vector3f> > &point_clouds)
+  : m_upload_mode(MPU_SYNC)
 {
   std::vector<uint32_t> point_cloud_sizes(point_clouds.size());
   for (size_t i = 0; i < point_clouds.size(); i++)
@@ -383,6 +423,9 @@ int16_t MetaPointCloud::getCloudNumber(const std::string& name) const
 
 void MetaPointCloud::destruct()
 {
+  // uploads may still read from the staging buffers or write to the device clouds
+  waitForUploads();
+  freeStagingBuffers();
   if (m_dev_ptr_to_point_clouds_struct)
     HANDLE_CUDA_ERROR(cudaFree(m_dev_ptr_to_point_clouds_struct));
   if (m_dev_ptr_to_cloud_sizes)
@@ -392,6 +435,10 @@ void MetaPointCloud::destruct()
   if (m_dev_ptr_to_clouds_base_addresses)
     // No need to iteratively delete the subclouds, as the accumulated mem is deleted
     HANDLE_CUDA_ERROR(cudaFree(m_dev_ptr_to_clouds_base_addresses));
+  if (m_dev_ptr_to_point_cloud_ids)
+    HANDLE_CUDA_ERROR(cudaFree(m_dev_ptr_to_point_cloud_ids));
+  if (m_transformations_dev)
+    HANDLE_CUDA_ERROR(cudaFree(m_transformations_dev));
   if (m_accumulated_cloud)
     delete (m_accumulated_cloud);
   if (m_dev_point_clouds_local)
@@ -412,10 +459,112 @@ MetaPointCloud::~MetaPointCloud()
   destruct();
   if (m_transformation_dev)
     HANDLE_CUDA_ERROR(cudaFree(m_transformation_dev));
+  setUploadMode(MPU_SYNC);
+}
+
+void MetaPointCloud::allocateStagingBuffers()
+{
+  for (int i = 0; i < 2; i++)
+  {
+    HANDLE_CUDA_ERROR(
+        cudaMallocHost((void** )&m_staging_buffers[i], m_accumulated_pointcloud_size * sizeof(Vector3f)));
+  }
+}
+
+void MetaPointCloud::freeStagingBuffers()
+{
+  for (int i = 0; i < 2; i++)
+  {
+    if (m_staging_buffers[i])
+      HANDLE_CUDA_ERROR(cudaFreeHost(m_staging_buffers[i]));
+    m_staging_buffers[i] = 0;
+  }
+}
+
+void MetaPointCloud::setUploadMode(MetaPointCloudUploadMode mode)
+{
+  if (mode == m_upload_mode)
+  {
+    return;
+  }
+  waitForUploads();
+  if (m_upload_mode == MPU_ASYNC)
+  {
+    freeStagingBuffers();
+    for (int i = 0; i < 2; i++)
+    {
+      HANDLE_CUDA_ERROR(cudaEventDestroy(m_upload_fences[i]));
+    }
+    HANDLE_CUDA_ERROR(cudaStreamDestroy(m_upload_stream));
+  }
+  m_upload_mode = mode;
+  if (m_upload_mode == MPU_ASYNC)
+  {
+    // a blocking stream, so that kernels in the default stream wait for the uploads
+    HANDLE_CUDA_ERROR(cudaStreamCreate(&m_upload_stream));
+    for (int i = 0; i < 2; i++)
+    {
+      HANDLE_CUDA_ERROR(cudaEventCreateWithFlags(&m_upload_fences[i], cudaEventDisableTiming));
+    }
+    m_current_upload_buffer = 0;
+    allocateStagingBuffers();
+  }
+}
+
+void MetaPointCloud::waitForUploads() const
+{
+  if (m_upload_mode == MPU_ASYNC)
+  {
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(m_upload_stream));
+  }
+}
+
+void MetaPointCloud::syncToDeviceAsync()
+{
+  if (m_upload_mode == MPU_SYNC)
+  {
+    for (uint16_t i = 0; i < m_num_clouds; i++)
+    {
+      if (m_dirty_clouds[i])
+      {
+        syncToDevice(i);
+      }
+    }
+    return;
+  }
+  if (m_upload_mode == MPU_HOST)
+  {
+    m_dirty_clouds.assign(m_num_clouds, false);
+    return;
+  }
+
+  // the fence guards the upload that read from this buffer two calls ago
+  Vector3f* staging_buffer = m_staging_buffers[m_current_upload_buffer];
+  HANDLE_CUDA_ERROR(cudaEventSynchronize(m_upload_fences[m_current_upload_buffer]));
+  for (uint16_t i = 0; i < m_num_clouds; i++)
+  {
+    if (m_dirty_clouds[i] && m_point_clouds_local->cloud_sizes[i] > 0)
+    {
+      const size_t offset = m_point_clouds_local->clouds_base_addresses[i] - m_accumulated_cloud;
+      const size_t size = sizeof(Vector3f) * m_point_clouds_local->cloud_sizes[i];
+      memcpy(staging_buffer + offset, m_point_clouds_local->clouds_base_addresses[i], size);
+      HANDLE_CUDA_ERROR(
+          cudaMemcpyAsync(m_dev_ptrs_to_addrs[i], staging_buffer + offset, size, cudaMemcpyHostToDevice,
+                          m_upload_stream));
+    }
+    m_dirty_clouds[i] = false;
+  }
+  HANDLE_CUDA_ERROR(cudaEventRecord(m_upload_fences[m_current_upload_buffer], m_upload_stream));
+  m_current_upload_buffer ^= 1;
 }
 
 void MetaPointCloud::syncToDevice()
 {
+  m_dirty_clouds.assign(m_num_clouds, false);
+  if (m_upload_mode == MPU_HOST)
+  {
+    return;
+  }
   // copy all clouds to the device
   HANDLE_CUDA_ERROR(
       cudaMemcpy(m_dev_ptrs_to_addrs[0], m_point_clouds_local->clouds_base_addresses[0],
@@ -424,6 +573,12 @@ void MetaPointCloud::syncToDevice()
 
 void MetaPointCloud::syncToHost()
 {
+  // the device clouds are the current ones now
+  m_dirty_clouds.assign(m_num_clouds, false);
+  if (m_upload_mode == MPU_HOST)
+  {
+    return;
+  }
   // copy all clouds to the host
   HANDLE_CUDA_ERROR(
       cudaMemcpy(m_point_clouds_local->clouds_base_addresses[0], m_dev_ptrs_to_addrs[0],
@@ -434,6 +589,11 @@ void MetaPointCloud::syncToDevice(uint16_t cloud)
 {
   if (cloud < m_num_clouds)
   {
+    m_dirty_clouds[cloud] = false;
+    if (m_upload_mode == MPU_HOST)
+    {
+      return;
+    }
     // copy only the indicated cloud
     HANDLE_CUDA_ERROR(
         cudaMemcpy(m_dev_ptrs_to_addrs[cloud], m_point_clouds_local->clouds_base_addresses[cloud],
@@ -519,9 +679,17 @@ void MetaPointCloud::updatePointCloud(uint16_t cloud, const Vector3f* pointcloud
       delete tmp_clouds.at(i);
     }
   }
+  m_dirty_clouds[cloud] = true;
   if (sync)
   {
-    syncToDevice(cloud);
+    if (m_upload_mode == MPU_SYNC)
+    {
+      syncToDevice(cloud);
+    }
+    else
+    {
+      syncToDeviceAsync();
+    }
   }
 }
 
@@ -648,4 +816,73 @@ void MetaPointCloud::transformSubCloud(uint8_t subcloud_to_transform, const Matr
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 }
 
+void MetaPointCloud::transformSubClouds(const std::vector<Matrix4f>& transformations, MetaPointCloud* transformed_cloud) const
+{
+  if((m_accumulated_pointcloud_size != transformed_cloud->m_accumulated_pointcloud_size) ||
+     (m_num_clouds != transformed_cloud->m_num_clouds) ||
+     (transformations.size() != m_num_clouds))
+  {
+    LOGGING_ERROR_C(Gpu_voxels_helpers, MetaPointCloud,
+                    "Size of target pointcloud or number of transformations does not match local pointcloud. Not transforming!" << icl_core::logging::endl);
+    return;
+  }
+  if (getAccumulatedPointcloudSize() == 0)
+  {
+    return;
+  }
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(m_transformations_dev, transformations.data(), m_num_clouds * sizeof(Matrix4f), cudaMemcpyHostToDevice));
+
+  const bool cache_transformations = m_num_clouds <= cMAX_SHARED_TRANSFORMATIONS;
+  const size_t shared_mem_size = cache_transformations ? m_num_clouds * sizeof(Matrix4f) : 0;
+  computeLinearLoad(getAccumulatedPointcloudSize(), &m_blocks, &m_threads_per_block);
+  // transform all clouds via one Kernel.
+  kernelTransformSubClouds<<< m_blocks, m_threads_per_block, shared_mem_size >>>
+      (m_transformations_dev,
+      m_num_clouds,
+      cache_transformations,
+      m_dev_ptr_to_point_cloud_ids,
+      m_dev_ptrs_to_addrs[0],
+      transformed_cloud->m_dev_ptrs_to_addrs[0],
+      m_accumulated_pointcloud_size);
+  CHECK_CUDA_ERROR();
+
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+}
+
+void MetaPointCloud::transformSubCloudsOnHost(const std::vector<Matrix4f>& transformations, MetaPointCloud* transformed_cloud) const
+{
+  if((m_accumulated_pointcloud_size != transformed_cloud->m_accumulated_pointcloud_size) ||
+     (m_num_clouds != transformed_cloud->m_num_clouds) ||
+     (transformations.size() != m_num_clouds))
+  {
+    LOGGING_ERROR_C(Gpu_voxels_helpers, MetaPointCloud,
+                    "Size of target pointcloud or number of transformations does not match local pointcloud. Not transforming!" << icl_core::logging::endl);
+    return;
+  }
+  if (getAccumulatedPointcloudSize() == 0)
+  {
+    return;
+  }
+
+  // Every thread transforms its share of each cloud. The transformation is constant within
+  // the inner loop, so the compiler can vectorize it.
+#pragma omp parallel
+  {
+    for (uint16_t c = 0; c < m_num_clouds; c++)
+    {
+      const Matrix4f transformation = transformations[c];
+      const Vector3f* input = m_point_clouds_local->clouds_base_addresses[c];
+      Vector3f* output = transformed_cloud->m_point_clouds_local->clouds_base_addresses[c];
+      const int32_t cloud_size = int32_t(m_point_clouds_local->cloud_sizes[c]);
+#pragma omp for schedule(static) nowait
+      for (int32_t i = 0; i < cloud_size; i++)
+      {
+        output[i] = transformPoint(transformation, input[i]);
+      }
+    }
+  }
+  transformed_cloud->syncToDevice();
+}
+
 } // end of ns gpu_voxels
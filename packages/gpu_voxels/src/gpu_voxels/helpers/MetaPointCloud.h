@@ -38,6 +38,16 @@
 
 namespace gpu_voxels {
 
+/*!
+ * \brief The MetaPointCloudUploadMode enum determines how host changes reach the device.
+ */
+enum MetaPointCloudUploadMode
+{
+  MPU_SYNC,   // Synchronous copies from the host clouds
+  MPU_ASYNC,  // Copies through two pinned staging buffers, issued asynchronously in an upload stream
+  MPU_HOST    // No copies: The clouds are only read on the host, e.g. by maps of the host backend
+};
+
 class MetaPointCloud
 {
 public:
@@ -83,10 +93,46 @@ public:
 
   void syncToHost();
 
+  /*!
+   * \brief syncToDeviceAsync Uploads all clouds that were changed on the host since their last upload.
+   * With MPU_ASYNC the changed clouds are copied into a pinned staging buffer and uploaded
+   * asynchronously, so the call returns before the transfer is done and the host clouds may be changed
+   * again right away. The two staging buffers alternate, so a new upload can be prepared while the
+   * previous one is still in flight. Kernels in the default stream wait for the uploads.
+   * With MPU_SYNC the changed clouds are copied synchronously, with MPU_HOST nothing is copied.
+   */
+  void syncToDeviceAsync();
+
+  /*!
+   * \brief waitForUploads Blocks until all asynchronous uploads are done.
+   */
+  void waitForUploads() const;
+
+  /*!
+   * \brief getUploadFence
+   * \return An event that completes with the last asynchronous upload. Other streams
+   * can wait for it with cudaStreamWaitEvent(). Only valid with MPU_ASYNC.
+   */
+  cudaEvent_t getUploadFence() const { return m_upload_fences[m_current_upload_buffer ^ 1]; }
+
+  /*!
+   * \brief setUploadMode Changes how host changes are transferred to the device.
+   * Pending uploads are finished first.
+   */
+  void setUploadMode(MetaPointCloudUploadMode mode);
+  MetaPointCloudUploadMode getUploadMode() const { return m_upload_mode; }
+
+  /*!
+   * \brief isDirty
+   * \return true if the cloud was changed on the host since its last upload
+   */
+  bool isDirty(uint16_t cloud) const { return m_dirty_clouds[cloud]; }
+
   /*!
    * \brief updatePointCloud This updates a specific cloud on the host.
    * Call syncToDevice() after updating all clouds or set sync to true
    * to only sync this current cloud to the GPU.
+   * Without MPU_SYNC, sync uploads all changed clouds through syncToDeviceAsync().
    * \param cloud Id of the cloud to update
    * \param pointcloud The new cloud. May differ in size.
    * \param sync If set to true, only this modified cloud is synced to the GPU.
@@ -204,6 +250,26 @@ public:
   void transformSelfSubCloud(uint8_t subcloud_to_transform, const Matrix4f* transformation);
 
 
+  /*!
+   * \brief transformSubClouds transforms every subcloud of this MetaPointCloud with its own transformation
+   * and writes it into the output MetaPointCloud. All transformations are uploaded at once and all points
+   * are transformed by a single kernel launch, which looks up the transformation by the cloud id of the point.
+   * \param transformations One transformation per subcloud
+   * \param transformed_cloud The transformed cloud. Has to be of the same size as this cloud!
+   */
+  void transformSubClouds(const std::vector<Matrix4f>& transformations, MetaPointCloud* transformed_cloud) const;
+
+
+  /*!
+   * \brief transformSubCloudsOnHost Same as transformSubClouds(), evaluated by the CPU threads on the host clouds.
+   * The result is written to the host memory of the output MetaPointCloud and synced to its device memory.
+   * Both variants round every operation the same way and deliver identical points.
+   * \param transformations One transformation per subcloud
+   * \param transformed_cloud The transformed cloud. Has to be of the same size as this cloud!
+   */
+  void transformSubCloudsOnHost(const std::vector<Matrix4f>& transformations, MetaPointCloud* transformed_cloud) const;
+
+
 private:
 
   /*!
@@ -218,6 +284,10 @@ private:
    */
   void destruct();
 
+  //! Allocates and frees the pinned staging buffers of MPU_ASYNC
+  void allocateStagingBuffers();
+  void freeStagingBuffers();
+
   std::vector<uint32_t> m_point_cloud_sizes; //basically only needed for copy constructor
   std::map<uint16_t, std::string> m_point_cloud_names;
 
@@ -233,9 +303,20 @@ private:
   Vector3f** m_dev_ptrs_to_addrs;
   uint32_t *m_dev_ptr_to_cloud_sizes;
   Vector3f** m_dev_ptr_to_clouds_base_addresses;
+  uint16_t* m_dev_ptr_to_point_cloud_ids; //!< cloud id of every point, used by transformSubClouds()
 
   // used for const transformation calls:
   mutable Matrix4f* m_transformation_dev;
+  mutable Matrix4f* m_transformations_dev; //!< one transformation per cloud
+
+  // used for uploads:
+  MetaPointCloudUploadMode m_upload_mode;
+  std::vector<bool> m_dirty_clouds;     //!< clouds that were changed on the host since their last upload
+  Vector3f* m_staging_buffers[2];       //!< pinned memory of the size of the accumulated cloud
+  cudaEvent_t m_upload_fences[2];       //!< completes when the upload from the staging buffer is done
+  cudaStream_t m_upload_stream;
+  uint8_t m_current_upload_buffer;
+
   mutable uint32_t m_blocks;
   mutable uint32_t m_threads_per_block;
 };
@@ -25,11 +25,13 @@
 #include <gpu_voxels/logging/logging_gpu_voxels.h>
 #include <gpu_voxels/helpers/kernels/HelperOperations.h>
 #include <gpu_voxels/helpers/PointcloudFileHandler.h>
+#include <cstring>
 
 namespace gpu_voxels
 {
 
 PointCloud::PointCloud()
+  : m_points_host_valid(true)
 {
   m_points_dev = NULL;
   m_points_size = 0;
@@ -38,6 +40,8 @@ PointCloud::PointCloud()
 }
 
 PointCloud::PointCloud(const std::vector<Vector3f> &points)
+  : m_points_host(points),
+    m_points_host_valid(true)
 {
   m_points_size = points.size();
 
@@ -53,6 +57,8 @@ PointCloud::PointCloud(const std::vector<Vector3f> &points)
 }
 
 PointCloud::PointCloud(const Vector3f *points, uint32_t size)
+  : m_points_host(points, points + size),
+    m_points_host_valid(true)
 {
   HANDLE_CUDA_ERROR(
       cudaMalloc((void** ) &m_points_dev, size * sizeof(Vector3f)));
@@ -67,6 +73,8 @@ PointCloud::PointCloud(const Vector3f *points, uint32_t size)
 }
 
 PointCloud::PointCloud(const PointCloud &other)
+  : m_points_host(other.m_points_host),
+    m_points_host_valid(other.m_points_host_valid)
 {
   m_points_size = other.getPointCloudSize();
 
@@ -82,8 +90,9 @@ PointCloud::PointCloud(const PointCloud &other)
 }
 
 PointCloud::PointCloud(const std::string &path_to_file, bool use_model_path)
+  : m_points_host_valid(true)
 {
-  std::vector<Vector3f> host_point_cloud;
+  std::vector<Vector3f>& host_point_cloud = m_points_host;
 
   if(!file_handling::PointcloudFileHandler::Instance()->loadPointCloud(path_to_file, use_model_path, host_point_cloud))
   {
@@ -115,6 +124,8 @@ PointCloud& PointCloud::operator=(const PointCloud& other)
     HANDLE_CUDA_ERROR(
         cudaMemcpy(m_points_dev, other.getConstDevicePointer(),
                    sizeof(Vector3f) * m_points_size, cudaMemcpyDeviceToDevice));
+    m_points_host = other.m_points_host;
+    m_points_host_valid = other.m_points_host_valid;
   }
   return *this;
 }
@@ -229,6 +240,10 @@ void PointCloud::add(const Vector3f* points, uint32_t size)
   HANDLE_CUDA_ERROR(cudaFree(m_points_dev));
   m_points_dev = tmp_dev;
   m_points_size = size + m_points_size;
+  if (m_points_host_valid)
+  {
+    m_points_host.insert(m_points_host.end(), points, points + size);
+  }
 }
 
 void PointCloud::update(const PointCloud *cloud)
@@ -247,7 +262,8 @@ void PointCloud::update(const Vector3f *points, uint32_t size)
 
   HANDLE_CUDA_ERROR(
       cudaMemcpy(m_points_dev, points, sizeof(Vector3f) * size, cudaMemcpyHostToDevice));
-
+  m_points_host.assign(points, points + size);
+  m_points_host_valid = true;
 }
 
 void PointCloud::transformSelf(const Matrix4f *transform)
@@ -282,6 +298,7 @@ void PointCloud::transform(const Matrix4f *transform, PointCloud *transformed_cl
       transformed_dev,
       m_points_size);
   CHECK_CUDA_ERROR();
+  transformed_cloud->m_points_host_valid = false;
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 }
@@ -316,12 +333,14 @@ void PointCloud::scale(const Vector3f* scaling, PointCloud* transformed_cloud)
       transformed_dev,
       m_points_size);
   CHECK_CUDA_ERROR();
+  transformed_cloud->m_points_host_valid = false;
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 }
 
 Vector3f* PointCloud::getDevicePointer()
 {
+  m_points_host_valid = false;
   return m_points_dev;
 }
 
@@ -330,11 +349,22 @@ const Vector3f* PointCloud::getConstDevicePointer() const
   return m_points_dev;
 }
 
+const Vector3f* PointCloud::getConstHostPointer() const
+{
+  if (!m_points_host_valid)
+  {
+    m_points_host.resize(m_points_size);
+    HANDLE_CUDA_ERROR(
+        cudaMemcpy(m_points_host.data(), m_points_dev, m_points_size * sizeof(Vector3f), cudaMemcpyDeviceToHost));
+    m_points_host_valid = true;
+  }
+  return m_points_host.data();
+}
+
 Vector3f* PointCloud::getPoints() const
 {
   Vector3f* tmp_h = (Vector3f*)malloc(m_points_size * sizeof(Vector3f));
-  HANDLE_CUDA_ERROR(
-      cudaMemcpy(tmp_h, m_points_dev, m_points_size * sizeof(Vector3f), cudaMemcpyDeviceToHost));
+  memcpy(tmp_h, getConstHostPointer(), m_points_size * sizeof(Vector3f));
 
   return tmp_h;
 }
@@ -133,9 +133,18 @@ public:
    */
   void scale(const Vector3f* scaling, PointCloud* scaled_cloud);
 
+  //! The caller may write the points through this pointer, so the host copy is downloaded again on the next access
   Vector3f* getDevicePointer();
   const Vector3f *getConstDevicePointer() const;
   size_t getPointCloudSize() const;
+
+  /*!
+   * \brief getConstHostPointer Host copy of the points, which is kept for points that were given on the host.
+   * It is only downloaded from the device after the points were changed there, e.g. by transformSelf().
+   */
+  const Vector3f* getConstHostPointer() const;
+
+  //! Copy of the points in host memory that has to be freed by the caller
   Vector3f* getPoints() const;
 
   //for testing
@@ -149,6 +158,10 @@ private:
   Vector3f* m_points_dev;
   uint32_t m_points_size;
 
+  //! host copy of the points, only valid if m_points_host_valid is set
+  mutable std::vector<Vector3f> m_points_host;
+  mutable bool m_points_host_valid;
+
   mutable Matrix4f* m_transformation_dev;
   mutable uint32_t m_blocks;
   mutable uint32_t m_threads_per_block;
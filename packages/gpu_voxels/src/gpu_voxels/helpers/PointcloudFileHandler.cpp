@@ -24,11 +24,9 @@
 #include "gpu_voxels/helpers/common_defines.h"
 #include "gpu_voxels/helpers/PointcloudFileHandler.h"
 
-#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
-  #include "gpu_voxels/helpers/PcdFileReader.h"
-#endif
-#include "gpu_voxels/helpers/BinvoxFileReader.h"
-#include "gpu_voxels/helpers/XyzFileReader.h"
+#include "gpu_voxels/helpers/MappedPcdFileReader.h"
+#include "gpu_voxels/helpers/MappedBinvoxFileReader.h"
+#include "gpu_voxels/helpers/MappedXyzFileReader.h"
 
 namespace gpu_voxels {
 namespace file_handling {
@@ -42,20 +40,18 @@ PointcloudFileHandler* PointcloudFileHandler::Instance()
 
 PointcloudFileHandler::PointcloudFileHandler()
 {
-  xyz_reader = new XyzFileReader();
-  binvox_reader = new BinvoxFileReader();
-#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
-  pcd_reader = new PcdFileReader();
-#endif
+  // The memory mapped readers parse in parallel and do not need PCL.
+  // The stream based readers are kept for comparison, see the FileReaderBenchmark example.
+  xyz_reader = new MappedXyzFileReader();
+  binvox_reader = new MappedBinvoxFileReader();
+  pcd_reader = new MappedPcdFileReader();
 }
 
 PointcloudFileHandler::~PointcloudFileHandler()
 {
   if(xyz_reader) delete xyz_reader;
   if(binvox_reader) delete binvox_reader;
-#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
   if(pcd_reader) delete pcd_reader;
-#endif
 }
 
 /*!
@@ -92,18 +88,10 @@ bool PointcloudFileHandler::loadPointCloud(const std::string _path, const bool u
     std::size_t found = path.find(std::string("pcd"));
     if (found!=std::string::npos)
     {
-#ifdef _BUILD_GVL_WITH_PCL_SUPPORT_
       if (!pcd_reader->readPointCloud(path, points))
       {
         return false;
       }
-#else
-      LOGGING_ERROR_C(
-          Gpu_voxels_helpers,
-          GpuVoxelsMap,
-          "Your GPU-Voxels was built without PCD support!" << endl);
-      return false;
-#endif
     }else{
       // is the file a binvox file?
       std::size_t found = path.find(std::string("binvox"));
@@ -128,7 +116,8 @@ bool PointcloudFileHandler::loadPointCloud(const std::string _path, const bool u
     shiftPointCloudToZero(points);
   }
 
-  for (size_t i = 0; i < points.size(); i++)
+#pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(points.size()); i++)
   {
     points[i].x = (scaling * points[i].x) + offset_XYZ.x;
     points[i].y = (scaling * points[i].y) + offset_XYZ.y;
@@ -37,9 +37,7 @@ namespace gpu_voxels {
 namespace file_handling {
 
 // Forward declaration for the specific readers:
-class PcdFileReader;
-class XyzFileReader;
-class BinvoxFileReader;
+class FileReaderInterface;
 
 class PointcloudFileHandler
 {
@@ -92,9 +90,9 @@ private:
    */
   void shiftPointCloudToZero(std::vector<Vector3f> &points);
 
-  XyzFileReader* xyz_reader;
-  PcdFileReader* pcd_reader;
-  BinvoxFileReader* binvox_reader;
+  FileReaderInterface* xyz_reader;
+  FileReaderInterface* pcd_reader;
+  FileReaderInterface* binvox_reader;
 
 };
 
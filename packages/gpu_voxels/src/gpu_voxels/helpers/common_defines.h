@@ -73,12 +73,18 @@ enum MapType {
   MT_DISTANCE_VOXELMAP           // 3D-Array of deterministic Voxels (identified by their Voxelmap-like Pointer adress) that hold a distance and obstacle vector
 };
 
+enum MapBackend {
+  MB_DEVICE,                     // Voxel data lives in GPU memory, operations are executed by CUDA kernels
+  MB_HOST                        // Voxel data lives in host memory, operations are executed by (OpenMP parallel) CPU loops
+};
+
 static const std::string GPU_VOXELS_MAP_TYPE_NOT_IMPLEMENTED = "THIS TYPE OF DATA STRUCTURE IS NOT YET IMPLEMENTED!";
 static const std::string GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED = "THIS OPERATION IS NOT SUPPORTED BY THE DATA STRUCTURE!";
 static const std::string GPU_VOXELS_MAP_ONLY_SUPPORTS_BVM_OCCUPIED = "THIS DATA STRUCTURE ONLY SUPPORTS BITVOXEL MEANING eBVM_OCCUPIED!";
 static const std::string GPU_VOXELS_MAP_OPERATION_NOT_YET_SUPPORTED = "THIS OPERATION IS NOT YET SUPPORTED BY THE DATA STRUCTURE!";
 static const std::string GPU_VOXELS_MAP_SWAP_FOR_COLLIDE = "TRY TO SWAP BOTH DATA STRUCTURES TO COLLIDE.";
 static const std::string GPU_VOXELS_MAP_OFFSET_ON_WRONG_DATA_STRUCTURE = "OFFSET ADDITION ONLY POSSIBLE WHEN COLLIDING WITH VOXELMAP/VOXELLIST";
+static const std::string GPU_VOXELS_MAP_BACKEND_MISMATCH = "BOTH DATA STRUCTURES HAVE TO USE THE SAME BACKEND (HOST OR DEVICE)!";
 
 // ################ Definition of the data structures build into the gpu_voxels library  #######################
 // Also have a look at
@@ -106,6 +112,7 @@ static const int32_t DISTANCE_UNINITIALISED = 0; //0 == uninitialized;
 static const int32_t PBA_OBSTACLE_DISTANCE = 0;
 
 static const int32_t PBA_UNINITIALISED_10 = 1023; // (1 << 10) - 1
+static const int32_t PBA_UNINITIALISED_21 = 2097151; // (1 << 21) - 1
 static const int32_t PBA_UNINITIALISED_16 = 32767; //SHRT_MAX
 static const int32_t PBA_UNINITIALISED_32 = 2147483647; //INT_MAX
 
@@ -115,13 +122,20 @@ static const int MANHATTAN_DISTANCE_TOO_CLOSE = MANHATTAN_DISTANCE_UNINITIALIZED
 
 //check: if PBA_UNINITIALISED_FORW_PTR != PBA_UNINITIALISED_COORD PBA phase2 needs additional checks!
 //static const int32_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_32;
-static const int32_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_10;
 //static const int16_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_16;
 //static const int16_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_16;
-static const int32_t PBA_UNINITIALISED_FORW_PTR = PBA_UNINITIALISED_COORD;
-
-//typedef int32_t pba_fw_ptr_t;
+#ifdef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
+// DistanceVoxels store their obstacle as 3x 21 bit in 64 bits, maps may have up to 2097151 voxels per axis
+static const int32_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_21;
+static const uint32_t PBA_COORD_BITS = 21;
+typedef int32_t pba_fw_ptr_t;
+#else
+// DistanceVoxels store their obstacle as 3x 10 bit in 32 bits, maps may have up to 1023 voxels per axis
+static const int32_t PBA_UNINITIALISED_COORD = PBA_UNINITIALISED_10;
+static const uint32_t PBA_COORD_BITS = 10;
 typedef int16_t pba_fw_ptr_t;
+#endif
+static const int32_t PBA_UNINITIALISED_FORW_PTR = PBA_UNINITIALISED_COORD;
 
 static const int32_t MAX_OBSTACLE_DISTANCE = 2147483647; //INT_MAX
 
@@ -90,6 +90,34 @@ void kernelTransformCloud(const Matrix4f *transformation, const Vector3f *startA
   }
 }
 
+__global__
+void kernelTransformSubClouds(const Matrix4f* transformations, uint16_t numberOfTransformations, bool cacheTransformations,
+                              const uint16_t* cloudIds, const Vector3f* startAddress, Vector3f* transformedAddress,
+                              uint32_t numberOfPoints)
+{
+  // Matrix4f has a constructor, which is not allowed in shared memory, so the cache is declared as floats
+  extern __shared__ float shared_transformations[];
+  const Matrix4f* transforms = transformations;
+  if (cacheTransformations)
+  {
+    const float* source = reinterpret_cast<const float*>(transformations);
+    for (uint32_t j = threadIdx.x; j < uint32_t(numberOfTransformations) * 16; j += blockDim.x)
+    {
+      shared_transformations[j] = source[j];
+    }
+    __syncthreads();
+    transforms = reinterpret_cast<const Matrix4f*>(shared_transformations);
+  }
+
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+
+  while(i < numberOfPoints)
+  {
+    transformedAddress[i] = transformPoint(transforms[cloudIds[i]], startAddress[i]);
+    i += blockDim.x * gridDim.x;
+  }
+}
+
 __global__
 void kernelScaleCloud(const Vector3f scaling, const Vector3f* startAddress, Vector3f* transformedAddress, uint32_t numberOfPoints)
 {
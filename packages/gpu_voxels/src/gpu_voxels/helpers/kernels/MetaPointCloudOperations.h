@@ -41,6 +41,40 @@ void kernelDebugMetaPointCloud(MetaPointCloudStruct* meta_point_clouds_struct);
 __global__
 void kernelTransformCloud(const Matrix4f* transformation, const Vector3f* startAddress, Vector3f* transformedAddress, uint32_t numberOfPoints);
 
+/*!
+ * \brief transformPoint applies the transformation to the point. On the device the products and sums are
+ * rounded one by one in the order of the host code, so that no fused multiply-adds change the result
+ * and host and device deliver identical points.
+ */
+__host__ __device__ inline
+Vector3f transformPoint(const Matrix4f& m, const Vector3f& v)
+{
+#ifdef __CUDA_ARCH__
+  return Vector3f(__fadd_rn(__fadd_rn(__fadd_rn(__fmul_rn(m.a11, v.x), __fmul_rn(m.a12, v.y)), __fmul_rn(m.a13, v.z)), m.a14),
+                  __fadd_rn(__fadd_rn(__fadd_rn(__fmul_rn(m.a21, v.x), __fmul_rn(m.a22, v.y)), __fmul_rn(m.a23, v.z)), m.a24),
+                  __fadd_rn(__fadd_rn(__fadd_rn(__fmul_rn(m.a31, v.x), __fmul_rn(m.a32, v.y)), __fmul_rn(m.a33, v.z)), m.a34));
+#else
+  return m * v;
+#endif
+}
+
+/*!
+ * \brief kernelTransformSubClouds transforms numberOfPoints Points starting at startAddress,
+ * every point by the transformation of its cloud
+ * \param transformations One transformation per cloud
+ * \param numberOfTransformations Number of transformations
+ * \param cacheTransformations If true, the transformations are copied to shared memory first.
+ * The kernel has to be launched with numberOfTransformations * sizeof(Matrix4f) bytes of shared memory then.
+ * \param cloudIds The cloud id of every point
+ * \param startAddress address of the points to be transformed
+ * \param transformedAddress address where to store the transformed points. Can be the same as the input_cloud
+ * \param numberOfPoints number of points to be transformed
+*/
+__global__
+void kernelTransformSubClouds(const Matrix4f* transformations, uint16_t numberOfTransformations, bool cacheTransformations,
+                              const uint16_t* cloudIds, const Vector3f* startAddress, Vector3f* transformedAddress,
+                              uint32_t numberOfPoints);
+
 /*!
  * \brief kernelScaleCloud scaled numberOfPoints Points starting at startAddress
  * \param scaling The scaling factors to be applied
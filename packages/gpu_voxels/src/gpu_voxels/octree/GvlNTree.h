@@ -27,6 +27,7 @@
 #include <gpu_voxels/octree/NTree.h>
 #include <gpu_voxels/voxel/BitVoxel.h>
 #include <gpu_voxels/octree/Sensor.h>
+#include <gpu_voxels/helpers/FreeSpaceRayCaster.h>
 
 namespace gpu_voxels {
 namespace NTree {
@@ -110,6 +111,14 @@ public:
   void insertPointCloudWithFreespaceCalculation(const std::vector<Vector3f> &point_cloud_in_sensor_coords, const Matrix4f &sensor_pose,
                                                 uint32_t free_space_resolution, uint32_t occupied_space_resolution);
 
+  /*!
+   * \brief insertRayCasterResults Inserts the free and occupied voxels of the last FreeSpaceRayCaster::castRays().
+   * Each voxel is updated once per frame, no matter how many rays touched it.
+   * \param ray_caster Has to use the resolution of the tree and a volume inside of it. The tree is much larger
+   * than a sensor frame, so a volume around the sensor keeps the bitmaps of the ray caster small.
+   */
+  void insertRayCasterResults(const FreeSpaceRayCaster& ray_caster);
+
 
   /*!
    * \brief collideWithTypesConsideringUnknownCells This does a collision check with 'other' and delivers the voxel meanings that are in collision.
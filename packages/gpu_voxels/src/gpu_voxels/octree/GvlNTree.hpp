@@ -132,6 +132,45 @@ void GvlNTree<branching_factor, level_count, InnerNode, LeafNode>::insertPointCl
   //CAUTION: Check for needs_rebuild after inserting new data!
 }
 
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+void GvlNTree<branching_factor, level_count, InnerNode, LeafNode>::insertRayCasterResults(
+    const FreeSpaceRayCaster& ray_caster)
+{
+  lock_guard guard(this->m_mutex);
+  const Vector3ui& offset = ray_caster.getOffset();
+  const Vector3ui& dim = ray_caster.getDimensions();
+  if (!(offset <= getDimensions()) || !(dim <= getDimensions() - offset)
+      || uint32_t(ray_caster.getVoxelSideLength() * 1000.0f + 0.5f) != this->m_resolution)
+  {
+    LOGGING_ERROR_C(OctreeLog, NTree, "The ray caster does not fit to the tree!" << endl);
+    return;
+  }
+
+  const std::vector<uint64_t>& free_voxels = ray_caster.getFreeVoxels();
+  const std::vector<uint64_t>& occupied_voxels = ray_caster.getOccupiedVoxels();
+  thrust::host_vector<Voxel> h_free_space_voxel(free_voxels.size());
+  thrust::host_vector<Voxel> h_object_voxel(occupied_voxels.size());
+  for (std::size_t i = 0; i < free_voxels.size(); ++i)
+  {
+    const Vector3ui coordinates = ray_caster.getVoxelCoordinates(free_voxels[i]);
+    h_free_space_voxel[i] = Voxel(morton_code60(coordinates), coordinates, FREE_UPDATE_PROBABILITY);
+  }
+  for (std::size_t i = 0; i < occupied_voxels.size(); ++i)
+  {
+    const Vector3ui coordinates = ray_caster.getVoxelCoordinates(occupied_voxels[i]);
+    h_object_voxel[i] = Voxel(morton_code60(coordinates), coordinates, OCCUPIED_UPDATE_PROBABILITY);
+  }
+  // the ray caster delivers the voxels in the order of its volume, the coordinates are already the ones of the tree
+  thrust::sort(h_free_space_voxel.begin(), h_free_space_voxel.end());
+  thrust::sort(h_object_voxel.begin(), h_object_voxel.end());
+
+  thrust::device_vector<Voxel> d_free_space_voxel = h_free_space_voxel;
+  thrust::device_vector<Voxel> d_object_voxel = h_object_voxel;
+  this->insertUniqueVoxel(d_free_space_voxel, d_object_voxel);
+
+  //CAUTION: Check for needs_rebuild after inserting new data!
+}
+
 //Collision Interface Implementation
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
 size_t GvlNTree<branching_factor, level_count, InnerNode, LeafNode>::collideWith(
@@ -0,0 +1,241 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Host implementation of the NTree as pointerless linear octree. The
+ * tree only stores its childless nodes with their Morton code, level
+ * and status, sorted by Morton code. Since the nodes are disjoint and
+ * each node covers a contiguous range of Morton codes, queries are
+ * binary searches and merges of sorted arrays. All operations run in
+ * parallel on a WorkStealingScheduler and neither the class nor its
+ * includes need CUDA, so the tree can be used on machines without a
+ * GPU. It only distinguishes free and occupied nodes, like the
+ * deterministic NTree; nodes which are not stored are unknown.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_OCTREE_LINEAR_NTREE_H_INCLUDED
+#define GPU_VOXELS_OCTREE_LINEAR_NTREE_H_INCLUDED
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <boost/atomic.hpp>
+
+#include <gpu_voxels/octree/LinearOctreeFile.h>
+#include <gpu_voxels/octree/WorkStealingScheduler.h>
+
+namespace gpu_voxels {
+namespace NTree {
+
+// Same values as ns_FREE, ns_UNKNOWN and ns_OCCUPIED of Nodes.h, which needs CUDA
+static const uint8_t cLINEAR_NODE_FREE = 1;
+static const uint8_t cLINEAR_NODE_UNKNOWN = 2;
+static const uint8_t cLINEAR_NODE_OCCUPIED = 4;
+
+//! Ranges of the parallel loops are not split below this number of elements
+static const std::size_t cLINEAR_NTREE_GRAIN_SIZE = 4096;
+//! Morton code of voxels outside of the tree, sorted behind all valid codes
+static const uint64_t cLINEAR_NTREE_INVALID_ID = ~uint64_t(0);
+
+struct LinearNTreeNode
+{
+  uint64_t voxel_id;          //!< Morton code of the first voxel of the node
+  uint8_t level;
+  uint8_t status;
+};
+
+//! Voxel coordinates of the tree
+struct LinearNTreeVoxel
+{
+  LinearNTreeVoxel() :
+      x(0), y(0), z(0)
+  {
+  }
+
+  LinearNTreeVoxel(const uint32_t x_, const uint32_t y_, const uint32_t z_) :
+      x(x_), y(y_), z(z_)
+  {
+  }
+
+  uint32_t x;
+  uint32_t y;
+  uint32_t z;
+};
+
+struct LinearNTreeFindResult
+{
+  uint8_t status;             //!< cLINEAR_NODE_UNKNOWN if no node holds the voxel
+  uint8_t level;              //!< Level of the node holding the voxel
+};
+
+struct LinearNTreeCube
+{
+  LinearNTreeVoxel position;  //!< Voxel coordinates of the lower corner
+  uint32_t side_length;       //!< In voxels
+  uint8_t status;
+};
+
+/*!
+ * \brief The LinearNTree class is the host counterpart of NTree<branching_factor, level_count, ...>.
+ *
+ * The branching factor has to be a power of 8, so the nodes of each level are cubes. Like the NTree
+ * the tree covers pow(branching_factor, level_count - 1) voxels and level_count - 1 is the root.
+ */
+template<std::size_t branching_factor, std::size_t level_count>
+class LinearNTree
+{
+public:
+  /*!
+   * \param num_threads Threads of the scheduler, 0 uses one thread per core
+   * \param resolution Voxel side length in mm
+   */
+  explicit LinearNTree(const uint32_t num_threads = 0, const uint32_t resolution = 10);
+
+  /**
+   * Voxel side length in mm
+   */
+  uint32_t m_resolution;
+
+  /**
+   * @brief Replaces the content of the tree by the given occupied voxels and merges them.
+   * Voxels outside of the tree are ignored.
+   */
+  void build(const std::vector<LinearNTreeVoxel>& voxels);
+
+  /**
+   * @brief Sets the nodes of the given level with the given Morton codes to \a status.
+   * The codes don't have to be sorted and are rounded down to the first voxel of their node.
+   * Nodes of other levels that overlap them are split or removed. cLINEAR_NODE_UNKNOWN removes
+   * the nodes. Call propagate() afterwards to merge the new nodes.
+   */
+  void insertVoxel(const std::vector<uint64_t>& voxel_ids, const uint8_t status, const uint32_t level = 0);
+
+  /**
+   * Merges all groups of branching_factor sibling nodes with the same status into their parent.
+   */
+  void propagate();
+
+  /**
+   * @brief Looks up the node holding each of the given voxels.
+   */
+  void find(const std::vector<LinearNTreeVoxel>& voxels, std::vector<LinearNTreeFindResult>& results);
+
+  /**
+   * @brief Intersects two trees.
+   * @return Number of voxels occupied in both trees
+   */
+  uint64_t intersect(const LinearNTree& other);
+
+  /**
+   * @brief Intersects the tree with a voxel map of the given dimensions in voxels of the tree.
+   * @param occupied Functor with bool operator()(uint32_t x, uint32_t y, uint32_t z) const, which
+   * tells whether a voxel of the map is occupied
+   * @return Number of voxels occupied in the tree and in the map
+   */
+  template<typename OccupancyFunctor>
+  uint64_t intersectVoxelMap(const LinearNTreeVoxel& map_dim, const OccupancyFunctor& occupied);
+
+  /**
+   * @brief Intersects the tree with a list of occupied voxels.
+   * @return Number of distinct voxels of the list, which are occupied in the tree
+   */
+  uint64_t intersectVoxelList(const std::vector<LinearNTreeVoxel>& voxels);
+
+  /**
+   * @brief Delivers the nodes whose status shares a bit with \a status_selection as cubes.
+   * Nodes below \a min_level are combined to one cube of \a min_level, whose status is the
+   * combination of them.
+   * @return Number of cubes
+   */
+  uint32_t extractCubes(std::vector<LinearNTreeCube>& cubes,
+                        const uint8_t status_selection = cLINEAR_NODE_FREE | cLINEAR_NODE_OCCUPIED,
+                        const uint32_t min_level = 0);
+
+  const std::vector<LinearNTreeNode>& getNodes() const
+  {
+    return m_nodes;
+  }
+
+  std::size_t getMemUsage() const
+  {
+    return m_nodes.capacity() * sizeof(LinearNTreeNode);
+  }
+
+  WorkStealingScheduler& getScheduler()
+  {
+    return m_scheduler;
+  }
+
+  //! Number of voxels of a node of the given level
+  static uint64_t getNumVoxels(const uint32_t level);
+
+  //! Side length of a node of the given level in voxels
+  static uint32_t getSideLength(const uint32_t level);
+
+private:
+  //! Number of Morton code bits of one level
+  static uint32_t getLevelBits();
+
+  //! Sorts the codes and removes duplicates
+  void sortUnique(std::vector<uint64_t>& voxel_ids);
+
+  //! Appends \a node to \a nodes and merges complete groups of siblings up to \a max_level
+  static void appendNode(std::vector<LinearNTreeNode>& nodes, const LinearNTreeNode& node, const uint32_t max_level);
+
+  //! Appends the children of \a node, which don't hold any of the new nodes in [ids_begin, ids_end)
+  static void splitNode(const LinearNTreeNode& node, const uint64_t* ids_begin, const uint64_t* ids_end,
+                        const uint32_t level, std::vector<LinearNTreeNode>& nodes);
+
+  //! Index of the first node that ends behind \a voxel_id
+  static std::size_t lowerNode(const std::vector<LinearNTreeNode>& nodes, const uint64_t voxel_id);
+
+  //! Splits [0, size) into about one range per task
+  std::vector<std::size_t> splitRange(const std::size_t size) const;
+
+  // loop bodies for the scheduler
+  void computeIds(const std::vector<LinearNTreeVoxel>* voxels, std::vector<uint64_t>* ids, std::size_t begin,
+                  std::size_t end) const;
+  void sortChunks(std::vector<uint64_t>* ids, const std::vector<std::size_t>* bounds, std::size_t begin,
+                  std::size_t end) const;
+  void mergeChunks(std::vector<uint64_t>* ids, const std::vector<std::size_t>* bounds, std::size_t width,
+                   std::size_t begin, std::size_t end) const;
+  void propagateRanges(const std::vector<std::size_t>* bounds, const uint32_t max_level,
+                       std::vector<std::vector<LinearNTreeNode> >* result, std::size_t begin, std::size_t end) const;
+  void insertRanges(const std::vector<std::size_t>* bounds, const std::vector<uint64_t>* ids, const uint8_t status,
+                    const uint32_t level, std::vector<std::vector<LinearNTreeNode> >* result, std::size_t begin,
+                    std::size_t end) const;
+  void findRange(const std::vector<LinearNTreeVoxel>* voxels, std::vector<LinearNTreeFindResult>* results,
+                 std::size_t begin, std::size_t end) const;
+  void intersectRange(const std::vector<LinearNTreeNode>* other, boost::atomic<uint64_t>* collisions,
+                      std::size_t begin, std::size_t end) const;
+  template<typename OccupancyFunctor>
+  void intersectVoxelMapRange(const LinearNTreeVoxel* map_dim, const OccupancyFunctor* occupied,
+                              boost::atomic<uint64_t>* collisions, std::size_t begin, std::size_t end) const;
+  void intersectVoxelListRange(const std::vector<uint64_t>* ids, boost::atomic<uint64_t>* collisions,
+                               std::size_t begin, std::size_t end) const;
+  void extractCubesRange(const std::vector<std::size_t>* bounds, const uint8_t status_selection,
+                         const uint32_t min_level, std::vector<std::vector<LinearNTreeCube> >* result,
+                         std::size_t begin, std::size_t end) const;
+
+  std::vector<LinearNTreeNode> m_nodes;
+  WorkStealingScheduler m_scheduler;
+};
+
+} // end of ns
+} // end of ns
+
+#endif
@@ -0,0 +1,729 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the host linear octree.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_OCTREE_LINEAR_NTREE_HPP_INCLUDED
+#define GPU_VOXELS_OCTREE_LINEAR_NTREE_HPP_INCLUDED
+
+#include <gpu_voxels/octree/LinearNTree.h>
+#include <gpu_voxels/logging/logging_octree.h>
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+
+template<std::size_t branching_factor, std::size_t level_count>
+LinearNTree<branching_factor, level_count>::LinearNTree(const uint32_t num_threads, const uint32_t resolution) :
+    m_resolution(resolution),
+    m_scheduler(num_threads)
+{
+  const uint32_t bits = getLevelBits();
+  if ((std::size_t(1) << bits) != branching_factor || bits % 3 != 0 || (level_count - 1) * bits > 60)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearNTree,
+                    "The branching factor has to be a power of 8 and the voxels have to fit into 60 bit Morton codes!" << endl);
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint64_t LinearNTree<branching_factor, level_count>::getNumVoxels(const uint32_t level)
+{
+  return uint64_t(1) << (level * getLevelBits());
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint32_t LinearNTree<branching_factor, level_count>::getSideLength(const uint32_t level)
+{
+  return uint32_t(1) << (level * getLevelBits() / 3);
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint32_t LinearNTree<branching_factor, level_count>::getLevelBits()
+{
+  uint32_t bits = 0;
+  while ((std::size_t(1) << bits) < branching_factor)
+  {
+    ++bits;
+  }
+  return bits;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::build(const std::vector<LinearNTreeVoxel>& voxels)
+{
+  std::vector<uint64_t> ids(voxels.size());
+  m_scheduler.parallelFor(0, voxels.size(), cLINEAR_NTREE_GRAIN_SIZE,
+                          boost::bind(&LinearNTree::computeIds, this, &voxels, &ids, _1, _2));
+  sortUnique(ids);
+  while (!ids.empty() && ids.back() == cLINEAR_NTREE_INVALID_ID)
+  {
+    ids.pop_back();
+  }
+
+  m_nodes.resize(ids.size());
+  for (std::size_t i = 0; i < ids.size(); ++i)
+  {
+    m_nodes[i].voxel_id = ids[i];
+    m_nodes[i].level = 0;
+    m_nodes[i].status = cLINEAR_NODE_OCCUPIED;
+  }
+  propagate();
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::insertVoxel(const std::vector<uint64_t>& voxel_ids,
+                                                             const uint8_t status, const uint32_t level)
+{
+  if (level >= level_count)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearNTree, "Level " << level << " exceeds the tree!" << endl);
+    return;
+  }
+
+  const uint64_t span = getNumVoxels(level);
+  const uint64_t num_voxels = getNumVoxels(level_count - 1);
+  std::vector<uint64_t> ids(voxel_ids.size());
+  for (std::size_t i = 0; i < voxel_ids.size(); ++i)
+  {
+    ids[i] = voxel_ids[i] < num_voxels ? voxel_ids[i] - voxel_ids[i] % span : cLINEAR_NTREE_INVALID_ID;
+  }
+  sortUnique(ids);
+  while (!ids.empty() && ids.back() == cLINEAR_NTREE_INVALID_ID)
+  {
+    ids.pop_back();
+  }
+  if (ids.empty())
+  {
+    return;
+  }
+
+  if (m_nodes.empty())
+  {
+    if (status != cLINEAR_NODE_UNKNOWN)
+    {
+      m_nodes.resize(ids.size());
+      for (std::size_t i = 0; i < ids.size(); ++i)
+      {
+        m_nodes[i].voxel_id = ids[i];
+        m_nodes[i].level = uint8_t(level);
+        m_nodes[i].status = status;
+      }
+    }
+    return;
+  }
+
+  const std::vector<std::size_t> bounds = splitRange(m_nodes.size());
+  std::vector<std::vector<LinearNTreeNode> > result(bounds.size() - 1);
+  m_scheduler.parallelFor(0, result.size(), 1,
+                          boost::bind(&LinearNTree::insertRanges, this, &bounds, &ids, status, level, &result, _1,
+                                      _2));
+
+  std::size_t num_nodes = 0;
+  for (std::size_t r = 0; r < result.size(); ++r)
+  {
+    num_nodes += result[r].size();
+  }
+  std::vector<LinearNTreeNode> nodes;
+  nodes.reserve(num_nodes);
+  for (std::size_t r = 0; r < result.size(); ++r)
+  {
+    nodes.insert(nodes.end(), result[r].begin(), result[r].end());
+  }
+  m_nodes.swap(nodes);
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::propagate()
+{
+  if (m_nodes.size() < branching_factor)
+  {
+    return;
+  }
+
+  // The ranges are cut between cells of the partition level, so every range can merge its nodes
+  // up to that level on its own. Only the few nodes at and above it are merged afterwards.
+  const uint32_t root_level = level_count - 1;
+  const uint32_t bits = getLevelBits();
+  uint32_t partition_level = root_level;
+  const uint64_t min_cells = 8 * m_scheduler.getNumThreads();
+  while (partition_level > 1 && (uint64_t(1) << ((root_level - partition_level) * bits)) < min_cells)
+  {
+    --partition_level;
+  }
+  const uint32_t cell_shift = partition_level * bits;
+
+  std::vector<std::size_t> bounds = splitRange(m_nodes.size());
+  for (std::size_t r = 1; r + 1 < bounds.size(); ++r)
+  {
+    std::size_t b = std::max(bounds[r], bounds[r - 1]);
+    while (b < m_nodes.size() && (m_nodes[b - 1].voxel_id >> cell_shift) == (m_nodes[b].voxel_id >> cell_shift))
+    {
+      ++b;
+    }
+    bounds[r] = b;
+  }
+
+  std::vector<std::vector<LinearNTreeNode> > result(bounds.size() - 1);
+  m_scheduler.parallelFor(0, result.size(), 1,
+                          boost::bind(&LinearNTree::propagateRanges, this, &bounds, partition_level, &result, _1, _2));
+
+  std::size_t num_nodes = 0;
+  for (std::size_t r = 0; r < result.size(); ++r)
+  {
+    num_nodes += result[r].size();
+  }
+  std::vector<LinearNTreeNode> nodes;
+  nodes.reserve(num_nodes);
+  for (std::size_t r = 0; r < result.size(); ++r)
+  {
+    for (std::size_t i = 0; i < result[r].size(); ++i)
+    {
+      if (result[r][i].level >= partition_level)
+      {
+        appendNode(nodes, result[r][i], root_level);
+      }
+      else
+      {
+        nodes.push_back(result[r][i]);
+      }
+    }
+  }
+  m_nodes.swap(nodes);
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::find(const std::vector<LinearNTreeVoxel>& voxels,
+                                                      std::vector<LinearNTreeFindResult>& results)
+{
+  results.resize(voxels.size());
+  m_scheduler.parallelFor(0, voxels.size(), cLINEAR_NTREE_GRAIN_SIZE,
+                          boost::bind(&LinearNTree::findRange, this, &voxels, &results, _1, _2));
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint64_t LinearNTree<branching_factor, level_count>::intersect(const LinearNTree& other)
+{
+  boost::atomic<uint64_t> collisions(0);
+  if (!other.m_nodes.empty())
+  {
+    m_scheduler.parallelFor(0, m_nodes.size(), cLINEAR_NTREE_GRAIN_SIZE,
+                            boost::bind(&LinearNTree::intersectRange, this, &other.m_nodes, &collisions, _1, _2));
+  }
+  return collisions;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+template<typename OccupancyFunctor>
+uint64_t LinearNTree<branching_factor, level_count>::intersectVoxelMap(const LinearNTreeVoxel& map_dim,
+                                                                       const OccupancyFunctor& occupied)
+{
+  // the work per node grows with its level, so the ranges are split much finer
+  boost::atomic<uint64_t> collisions(0);
+  m_scheduler.parallelFor(0, m_nodes.size(), 64,
+                          boost::bind(&LinearNTree::template intersectVoxelMapRange<OccupancyFunctor>, this,
+                                      &map_dim, &occupied, &collisions, _1, _2));
+  return collisions;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint64_t LinearNTree<branching_factor, level_count>::intersectVoxelList(const std::vector<LinearNTreeVoxel>& voxels)
+{
+  std::vector<uint64_t> ids(voxels.size());
+  m_scheduler.parallelFor(0, voxels.size(), cLINEAR_NTREE_GRAIN_SIZE,
+                          boost::bind(&LinearNTree::computeIds, this, &voxels, &ids, _1, _2));
+  sortUnique(ids);
+  while (!ids.empty() && ids.back() == cLINEAR_NTREE_INVALID_ID)
+  {
+    ids.pop_back();
+  }
+
+  boost::atomic<uint64_t> collisions(0);
+  if (!m_nodes.empty())
+  {
+    m_scheduler.parallelFor(0, ids.size(), cLINEAR_NTREE_GRAIN_SIZE,
+                            boost::bind(&LinearNTree::intersectVoxelListRange, this, &ids, &collisions, _1, _2));
+  }
+  return collisions;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+uint32_t LinearNTree<branching_factor, level_count>::extractCubes(std::vector<LinearNTreeCube>& cubes,
+                                                                  const uint8_t status_selection,
+                                                                  const uint32_t min_level)
+{
+  cubes.clear();
+  if (m_nodes.empty())
+  {
+    return 0;
+  }
+
+  const std::vector<std::size_t> bounds = splitRange(m_nodes.size());
+  std::vector<std::vector<LinearNTreeCube> > result(bounds.size() - 1);
+  m_scheduler.parallelFor(0, result.size(), 1,
+                          boost::bind(&LinearNTree::extractCubesRange, this, &bounds, status_selection,
+                                      std::min(min_level, uint32_t(level_count - 1)), &result, _1, _2));
+
+  // nodes of the same cell of min_level may end up in neighbouring ranges
+  for (std::size_t r = 0; r < result.size(); ++r)
+  {
+    for (std::size_t i = 0; i < result[r].size(); ++i)
+    {
+      const LinearNTreeCube& cube = result[r][i];
+      if (!cubes.empty() && cubes.back().side_length == cube.side_length && cubes.back().position.x == cube.position.x
+          && cubes.back().position.y == cube.position.y && cubes.back().position.z == cube.position.z)
+      {
+        cubes.back().status |= cube.status;
+      }
+      else
+      {
+        cubes.push_back(cube);
+      }
+    }
+  }
+  return uint32_t(cubes.size());
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::sortUnique(std::vector<uint64_t>& voxel_ids)
+{
+  // sort chunks in parallel and merge them pairwise in rounds
+  const std::vector<std::size_t> bounds = splitRange(voxel_ids.size());
+  const std::size_t num_chunks = bounds.size() - 1;
+  m_scheduler.parallelFor(0, num_chunks, 1,
+                          boost::bind(&LinearNTree::sortChunks, this, &voxel_ids, &bounds, _1, _2));
+  for (std::size_t width = 1; width < num_chunks; width *= 2)
+  {
+    m_scheduler.parallelFor(0, (num_chunks + 2 * width - 1) / (2 * width), 1,
+                            boost::bind(&LinearNTree::mergeChunks, this, &voxel_ids, &bounds, width, _1, _2));
+  }
+  voxel_ids.erase(std::unique(voxel_ids.begin(), voxel_ids.end()), voxel_ids.end());
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::appendNode(std::vector<LinearNTreeNode>& nodes,
+                                                            const LinearNTreeNode& node, const uint32_t max_level)
+{
+  nodes.push_back(node);
+  while (nodes.size() >= branching_factor)
+  {
+    const LinearNTreeNode last = nodes.back();
+    const uint64_t span = getNumVoxels(last.level);
+    // cheap test first: the last node has to be the last child of its parent
+    if (last.level >= max_level || last.voxel_id % (span * branching_factor) != (branching_factor - 1) * span)
+    {
+      return;
+    }
+
+    // disjoint nodes of the same level, which end at the last child, are all siblings
+    const std::size_t first = nodes.size() - branching_factor;
+    for (std::size_t i = first; i < nodes.size() - 1; ++i)
+    {
+      if (nodes[i].level != last.level || nodes[i].status != last.status)
+      {
+        return;
+      }
+    }
+    if (nodes[first].voxel_id + (branching_factor - 1) * span != last.voxel_id)
+    {
+      return;
+    }
+
+    LinearNTreeNode parent;
+    parent.voxel_id = nodes[first].voxel_id;
+    parent.level = last.level + 1;
+    parent.status = last.status;
+    nodes.resize(first);
+    nodes.push_back(parent);
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::splitNode(const LinearNTreeNode& node, const uint64_t* ids_begin,
+                                                           const uint64_t* ids_end, const uint32_t level,
+                                                           std::vector<LinearNTreeNode>& nodes)
+{
+  LinearNTreeNode child;
+  child.level = node.level - 1;
+  child.status = node.status;
+  const uint64_t child_span = getNumVoxels(child.level);
+  const uint64_t* cursor = ids_begin;
+  for (std::size_t c = 0; c < branching_factor; ++c)
+  {
+    child.voxel_id = node.voxel_id + c * child_span;
+    const uint64_t* child_begin = cursor;
+    while (cursor != ids_end && *cursor < child.voxel_id + child_span)
+    {
+      ++cursor;
+    }
+
+    if (child_begin == cursor)
+    {
+      nodes.push_back(child);
+    }
+    else if (child.level > level)
+    {
+      splitNode(child, child_begin, cursor, level, nodes);
+    }
+    // otherwise the child is replaced by a new node
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+std::size_t LinearNTree<branching_factor, level_count>::lowerNode(const std::vector<LinearNTreeNode>& nodes,
+                                                                  const uint64_t voxel_id)
+{
+  std::size_t low = 0;
+  std::size_t high = nodes.size();
+  while (low < high)
+  {
+    const std::size_t middle = low + (high - low) / 2;
+    if (nodes[middle].voxel_id <= voxel_id)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  if (low > 0 && nodes[low - 1].voxel_id + getNumVoxels(nodes[low - 1].level) > voxel_id)
+  {
+    return low - 1;
+  }
+  return low;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+std::vector<std::size_t> LinearNTree<branching_factor, level_count>::splitRange(const std::size_t size) const
+{
+  std::size_t num_ranges = std::min((size + cLINEAR_NTREE_GRAIN_SIZE - 1) / cLINEAR_NTREE_GRAIN_SIZE,
+                                    std::size_t(4 * m_scheduler.getNumThreads()));
+  num_ranges = std::max(num_ranges, std::size_t(1));
+
+  std::vector<std::size_t> bounds(num_ranges + 1);
+  for (std::size_t r = 0; r <= num_ranges; ++r)
+  {
+    bounds[r] = size * r / num_ranges;
+  }
+  return bounds;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::computeIds(const std::vector<LinearNTreeVoxel>* voxels,
+                                                            std::vector<uint64_t>* ids, std::size_t begin,
+                                                            std::size_t end) const
+{
+  const uint32_t side = getSideLength(level_count - 1);
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const LinearNTreeVoxel& v = (*voxels)[i];
+    (*ids)[i] = (v.x < side && v.y < side && v.z < side) ?
+        linearOctreeMortonCode(v.x, v.y, v.z) : cLINEAR_NTREE_INVALID_ID;
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::sortChunks(std::vector<uint64_t>* ids,
+                                                            const std::vector<std::size_t>* bounds,
+                                                            std::size_t begin, std::size_t end) const
+{
+  for (std::size_t c = begin; c < end; ++c)
+  {
+    std::sort(ids->begin() + (*bounds)[c], ids->begin() + (*bounds)[c + 1]);
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::mergeChunks(std::vector<uint64_t>* ids,
+                                                             const std::vector<std::size_t>* bounds,
+                                                             std::size_t width, std::size_t begin,
+                                                             std::size_t end) const
+{
+  const std::size_t num_chunks = bounds->size() - 1;
+  for (std::size_t m = begin; m < end; ++m)
+  {
+    const std::size_t first = (*bounds)[2 * m * width];
+    const std::size_t middle = (*bounds)[std::min((2 * m + 1) * width, num_chunks)];
+    const std::size_t last = (*bounds)[std::min((2 * m + 2) * width, num_chunks)];
+    std::inplace_merge(ids->begin() + first, ids->begin() + middle, ids->begin() + last);
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::propagateRanges(
+    const std::vector<std::size_t>* bounds, const uint32_t max_level,
+    std::vector<std::vector<LinearNTreeNode> >* result, std::size_t begin, std::size_t end) const
+{
+  for (std::size_t r = begin; r < end; ++r)
+  {
+    std::vector<LinearNTreeNode>& nodes = (*result)[r];
+    nodes.reserve((*bounds)[r + 1] - (*bounds)[r]);
+    for (std::size_t i = (*bounds)[r]; i < (*bounds)[r + 1]; ++i)
+    {
+      appendNode(nodes, m_nodes[i], max_level);
+    }
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::insertRanges(const std::vector<std::size_t>* bounds,
+                                                              const std::vector<uint64_t>* ids, const uint8_t status,
+                                                              const uint32_t level,
+                                                              std::vector<std::vector<LinearNTreeNode> >* result,
+                                                              std::size_t begin, std::size_t end) const
+{
+  const uint64_t span = getNumVoxels(level);
+  const uint64_t* ids_begin = &(*ids)[0];
+  const uint64_t* ids_end = ids_begin + ids->size();
+  const std::size_t num_ranges = bounds->size() - 1;
+  std::vector<LinearNTreeNode> pieces;
+
+  for (std::size_t r = begin; r < end; ++r)
+  {
+    const std::size_t first_node = (*bounds)[r];
+    const std::size_t last_node = (*bounds)[r + 1];
+
+    // remove or split the old nodes, which overlap new ones
+    pieces.clear();
+    const uint64_t* cursor = std::lower_bound(ids_begin, ids_end, m_nodes[first_node].voxel_id);
+    for (std::size_t i = first_node; i < last_node; ++i)
+    {
+      const LinearNTreeNode& node = m_nodes[i];
+      const uint64_t node_end = node.voxel_id + getNumVoxels(node.level);
+      while (cursor != ids_end && *cursor < node.voxel_id)
+      {
+        ++cursor;
+      }
+
+      if (node.level <= level)
+      {
+        // the node lies in a new node, which either starts with it or in front of it
+        if ((cursor != ids_end && *cursor == node.voxel_id)
+            || (cursor != ids_begin && *(cursor - 1) + span > node.voxel_id))
+        {
+          continue;
+        }
+      }
+
+      const uint64_t* inside_end = cursor;
+      while (inside_end != ids_end && *inside_end < node_end)
+      {
+        ++inside_end;
+      }
+      if (inside_end == cursor)
+      {
+        pieces.push_back(node);
+      }
+      else
+      {
+        splitNode(node, cursor, inside_end, level, pieces);
+      }
+    }
+
+    // merge the new nodes in front of the next range into the remaining ones
+    std::vector<LinearNTreeNode>& nodes = (*result)[r];
+    const uint64_t* new_begin = r == 0 ? ids_begin : std::lower_bound(ids_begin, ids_end, m_nodes[first_node].voxel_id);
+    const uint64_t* new_end =
+        r + 1 == num_ranges ? ids_end : std::lower_bound(ids_begin, ids_end, m_nodes[last_node].voxel_id);
+    if (status == cLINEAR_NODE_UNKNOWN)
+    {
+      new_end = new_begin;
+    }
+    nodes.reserve(pieces.size() + (new_end - new_begin));
+
+    LinearNTreeNode new_node;
+    new_node.level = uint8_t(level);
+    new_node.status = status;
+    std::size_t p = 0;
+    for (const uint64_t* n = new_begin; n != new_end; ++n)
+    {
+      while (p < pieces.size() && pieces[p].voxel_id < *n)
+      {
+        nodes.push_back(pieces[p++]);
+      }
+      new_node.voxel_id = *n;
+      nodes.push_back(new_node);
+    }
+    nodes.insert(nodes.end(), pieces.begin() + p, pieces.end());
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::findRange(const std::vector<LinearNTreeVoxel>* voxels,
+                                                           std::vector<LinearNTreeFindResult>* results,
+                                                           std::size_t begin, std::size_t end) const
+{
+  const uint32_t side = getSideLength(level_count - 1);
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const LinearNTreeVoxel& v = (*voxels)[i];
+    LinearNTreeFindResult& result = (*results)[i];
+    result.status = cLINEAR_NODE_UNKNOWN;
+    result.level = 0;
+    if (v.x < side && v.y < side && v.z < side)
+    {
+      const uint64_t voxel_id = linearOctreeMortonCode(v.x, v.y, v.z);
+      const std::size_t n = lowerNode(m_nodes, voxel_id);
+      if (n < m_nodes.size() && m_nodes[n].voxel_id <= voxel_id)
+      {
+        result.status = m_nodes[n].status;
+        result.level = m_nodes[n].level;
+      }
+    }
+  }
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::intersectRange(const std::vector<LinearNTreeNode>* other,
+                                                                boost::atomic<uint64_t>* collisions,
+                                                                std::size_t begin, std::size_t end) const
+{
+  // both arrays are sorted and disjoint, so a merge visits every overlap once
+  uint64_t sum = 0;
+  std::size_t i = begin;
+  std::size_t j = lowerNode(*other, m_nodes[begin].voxel_id);
+  while (i < end && j < other->size())
+  {
+    const LinearNTreeNode& a = m_nodes[i];
+    const LinearNTreeNode& b = (*other)[j];
+    const uint64_t a_end = a.voxel_id + getNumVoxels(a.level);
+    const uint64_t b_end = b.voxel_id + getNumVoxels(b.level);
+    const uint64_t overlap_begin = std::max(a.voxel_id, b.voxel_id);
+    const uint64_t overlap_end = std::min(a_end, b_end);
+    if (overlap_begin < overlap_end && (a.status & cLINEAR_NODE_OCCUPIED) && (b.status & cLINEAR_NODE_OCCUPIED))
+    {
+      sum += overlap_end - overlap_begin;
+    }
+
+    if (a_end <= b_end)
+    {
+      ++i;
+    }
+    else
+    {
+      ++j;
+    }
+  }
+  *collisions += sum;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+template<typename OccupancyFunctor>
+void LinearNTree<branching_factor, level_count>::intersectVoxelMapRange(const LinearNTreeVoxel* map_dim,
+                                                                        const OccupancyFunctor* occupied,
+                                                                        boost::atomic<uint64_t>* collisions,
+                                                                        std::size_t begin, std::size_t end) const
+{
+  uint64_t sum = 0;
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const LinearNTreeNode& node = m_nodes[i];
+    if (!(node.status & cLINEAR_NODE_OCCUPIED))
+    {
+      continue;
+    }
+
+    LinearNTreeVoxel lower;
+    linearOctreeVoxelCoordinates(node.voxel_id, lower.x, lower.y, lower.z);
+    const uint32_t side = getSideLength(node.level);
+    const LinearNTreeVoxel upper(std::min(lower.x + side, map_dim->x), std::min(lower.y + side, map_dim->y),
+                                 std::min(lower.z + side, map_dim->z));
+    for (uint32_t z = lower.z; z < upper.z; ++z)
+    {
+      for (uint32_t y = lower.y; y < upper.y; ++y)
+      {
+        for (uint32_t x = lower.x; x < upper.x; ++x)
+        {
+          if ((*occupied)(x, y, z))
+          {
+            ++sum;
+          }
+        }
+      }
+    }
+  }
+  *collisions += sum;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::intersectVoxelListRange(const std::vector<uint64_t>* ids,
+                                                                         boost::atomic<uint64_t>* collisions,
+                                                                         std::size_t begin, std::size_t end) const
+{
+  uint64_t sum = 0;
+  std::size_t n = lowerNode(m_nodes, (*ids)[begin]);
+  for (std::size_t i = begin; i < end && n < m_nodes.size(); ++i)
+  {
+    const uint64_t voxel_id = (*ids)[i];
+    while (n < m_nodes.size() && m_nodes[n].voxel_id + getNumVoxels(m_nodes[n].level) <= voxel_id)
+    {
+      ++n;
+    }
+    if (n < m_nodes.size() && m_nodes[n].voxel_id <= voxel_id && (m_nodes[n].status & cLINEAR_NODE_OCCUPIED))
+    {
+      ++sum;
+    }
+  }
+  *collisions += sum;
+}
+
+template<std::size_t branching_factor, std::size_t level_count>
+void LinearNTree<branching_factor, level_count>::extractCubesRange(const std::vector<std::size_t>* bounds,
+                                                                   const uint8_t status_selection,
+                                                                   const uint32_t min_level,
+                                                                   std::vector<std::vector<LinearNTreeCube> >* result,
+                                                                   std::size_t begin, std::size_t end) const
+{
+  for (std::size_t r = begin; r < end; ++r)
+  {
+    std::vector<LinearNTreeCube>& cubes = (*result)[r];
+    uint64_t last_id = cLINEAR_NTREE_INVALID_ID;
+    for (std::size_t i = (*bounds)[r]; i < (*bounds)[r + 1]; ++i)
+    {
+      const LinearNTreeNode& node = m_nodes[i];
+      if (!(node.status & status_selection))
+      {
+        continue;
+      }
+
+      const uint32_t level = std::max(uint32_t(node.level), min_level);
+      const uint64_t voxel_id = node.voxel_id - node.voxel_id % getNumVoxels(level);
+      if (voxel_id == last_id)
+      {
+        cubes.back().status |= node.status;
+        continue;
+      }
+
+      LinearNTreeCube cube;
+      linearOctreeVoxelCoordinates(voxel_id, cube.position.x, cube.position.y, cube.position.z);
+      cube.side_length = getSideLength(level);
+      cube.status = node.status;
+      cubes.push_back(cube);
+      last_id = voxel_id;
+    }
+  }
+}
+
+} // end of ns
+} // end of ns
+
+#endif
@@ -0,0 +1,364 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Host implementation of the linear octree file writer and reader.
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/octree/LinearOctreeFile.h>
+#include <gpu_voxels/logging/logging_octree.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace gpu_voxels {
+namespace NTree {
+
+static const char cLINEAR_OCTREE_MAGIC[4] = { 'G', 'V', 'L', 'O' };
+static const uint32_t cMORTON_BITS_PER_AXIS = 20;
+
+uint64_t linearOctreeMortonCode(const uint32_t x, const uint32_t y, const uint32_t z)
+{
+  uint64_t code = 0;
+  for (uint32_t i = 0; i < cMORTON_BITS_PER_AXIS; ++i)
+  {
+    code |= uint64_t((x >> i) & 1) << (3 * i);
+    code |= uint64_t((y >> i) & 1) << (3 * i + 1);
+    code |= uint64_t((z >> i) & 1) << (3 * i + 2);
+  }
+  return code;
+}
+
+void linearOctreeVoxelCoordinates(const uint64_t voxel_id, uint32_t& x, uint32_t& y, uint32_t& z)
+{
+  x = y = z = 0;
+  for (uint32_t i = 0; i < cMORTON_BITS_PER_AXIS; ++i)
+  {
+    x |= uint32_t((voxel_id >> (3 * i)) & 1) << i;
+    y |= uint32_t((voxel_id >> (3 * i + 1)) & 1) << i;
+    z |= uint32_t((voxel_id >> (3 * i + 2)) & 1) << i;
+  }
+}
+
+LinearOctreeWriter::LinearOctreeWriter(std::ostream& out, const uint32_t branching_factor,
+                                       const uint32_t level_count, const uint32_t resolution,
+                                       const uint32_t data_size, const uint32_t records_per_chunk)
+  : m_out(out),
+    m_num_written(0),
+    m_last_level(0),
+    m_last_voxel_id(0),
+    m_good(true),
+    m_finished(false)
+{
+  memset(&m_header, 0, sizeof(LinearOctreeHeader));
+  memcpy(m_header.magic, cLINEAR_OCTREE_MAGIC, sizeof(cLINEAR_OCTREE_MAGIC));
+  m_header.version = cLINEAR_OCTREE_VERSION;
+  m_header.branching_factor = branching_factor;
+  m_header.level_count = level_count;
+  m_header.resolution = resolution;
+  m_header.data_size = data_size;
+  m_header.records_per_chunk = std::max(records_per_chunk, uint32_t(1));
+  memset(&m_chunk, 0, sizeof(LinearOctreeChunk));
+
+  if (level_count > cLINEAR_OCTREE_MAX_LEVELS)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeWriter,
+                    "A linear octree file holds at most " << cLINEAR_OCTREE_MAX_LEVELS << " levels!" << endl);
+    m_good = false;
+  }
+
+  // the header is written again by finish()
+  m_start = m_out.tellp();
+  m_out.write((const char*) &m_header, sizeof(LinearOctreeHeader));
+  m_buffer.reserve(std::size_t(m_header.records_per_chunk) * (sizeof(uint64_t) + data_size));
+}
+
+bool LinearOctreeWriter::write(const uint32_t level, const uint64_t* voxel_ids, const void* data,
+                               const std::size_t num)
+{
+  const char* record_data = (const char*) data;
+  for (std::size_t i = 0; i < num && m_good; ++i)
+  {
+    if (level >= m_header.level_count
+        || (m_num_written > 0 && (level < m_last_level || (level == m_last_level && voxel_ids[i] <= m_last_voxel_id))))
+    {
+      LOGGING_ERROR_C(OctreeLog, LinearOctreeWriter,
+                      "Record " << voxel_ids[i] << " of level " << level << " is out of order!" << endl);
+      m_good = false;
+      break;
+    }
+
+    if ((m_chunk.num_records > 0 && level != m_chunk.level) || m_chunk.num_records == m_header.records_per_chunk)
+      m_good = flushChunk();
+
+    if (m_chunk.num_records == 0)
+    {
+      m_chunk.level = level;
+      m_chunk.first_voxel_id = voxel_ids[i];
+    }
+    m_chunk.last_voxel_id = voxel_ids[i];
+    ++m_chunk.num_records;
+    ++m_num_written;
+    m_last_level = level;
+    m_last_voxel_id = voxel_ids[i];
+    m_buffer.insert(m_buffer.end(), (const char*) &voxel_ids[i], (const char*) &voxel_ids[i] + sizeof(uint64_t));
+    m_buffer.insert(m_buffer.end(), record_data + i * m_header.data_size,
+                    record_data + (i + 1) * m_header.data_size);
+  }
+  return m_good;
+}
+
+bool LinearOctreeWriter::flushChunk()
+{
+  if (m_chunk.num_records == 0)
+    return true;
+
+  m_chunk.offset = uint64_t(m_out.tellp() - m_start);
+  m_out.write(&m_buffer[0], m_buffer.size());
+  m_index.push_back(m_chunk);
+  m_header.level_offsets[m_chunk.level + 1] += m_chunk.num_records;
+
+  m_buffer.clear();
+  m_chunk.num_records = 0;
+  return m_out.good();
+}
+
+bool LinearOctreeWriter::finish()
+{
+  if (m_finished)
+    return m_good;
+  m_finished = true;
+  m_good = m_good && flushChunk();
+  if (!m_good)
+    return false;
+
+  m_header.index_offset = uint64_t(m_out.tellp() - m_start);
+  m_header.num_chunks = uint32_t(m_index.size());
+  if (!m_index.empty())
+    m_out.write((const char*) &m_index[0], m_index.size() * sizeof(LinearOctreeChunk));
+
+  // level_offsets holds the number of records per level so far
+  for (uint32_t l = 0; l < m_header.level_count; ++l)
+    m_header.level_offsets[l + 1] += m_header.level_offsets[l];
+  m_header.num_records = m_header.level_offsets[m_header.level_count];
+
+  const std::streampos end = m_out.tellp();
+  m_out.seekp(m_start);
+  m_out.write((const char*) &m_header, sizeof(LinearOctreeHeader));
+  m_out.seekp(end);
+  m_good = m_out.good();
+  return m_good;
+}
+
+LinearOctreeReader::LinearOctreeReader(std::istream& in)
+  : m_in(in),
+    m_cube_side(0),
+    m_valid(false)
+{
+  m_start = m_in.tellg();
+  m_in.read((char*) &m_header, sizeof(LinearOctreeHeader));
+  if (!m_in.good() || memcmp(m_header.magic, cLINEAR_OCTREE_MAGIC, sizeof(cLINEAR_OCTREE_MAGIC)) != 0)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader, "The stream holds no linear octree file!" << endl);
+    return;
+  }
+  if (m_header.version != cLINEAR_OCTREE_VERSION || m_header.level_count > cLINEAR_OCTREE_MAX_LEVELS)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader,
+                    "Unsupported linear octree file of version " << m_header.version << "!" << endl);
+    return;
+  }
+
+  // the nodes are cubes, so the branching factor is the third power of their number per axis
+  uint64_t cube_side = 0;
+  while (cube_side * cube_side * cube_side < m_header.branching_factor)
+    ++cube_side;
+  if (m_header.branching_factor < 2 || cube_side * cube_side * cube_side != m_header.branching_factor)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader,
+                    "Invalid branching factor " << m_header.branching_factor << "!" << endl);
+    return;
+  }
+  m_cube_side = uint32_t(cube_side);
+
+  // the top level nodes have to fit into the coordinates of the Morton codes
+  uint64_t top_side = 1;
+  for (uint32_t l = 1; l < m_header.level_count && top_side <= (uint64_t(1) << cMORTON_BITS_PER_AXIS); ++l)
+    top_side *= m_cube_side;
+  if (m_header.level_count == 0 || top_side > (uint64_t(1) << cMORTON_BITS_PER_AXIS) || m_header.records_per_chunk == 0)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader,
+                    "Invalid tree of " << m_header.level_count << " levels or chunks of "
+                    << m_header.records_per_chunk << " records!" << endl);
+    return;
+  }
+
+  // everything the header points to has to lie inside of the stream
+  m_in.seekg(0, std::ios::end);
+  const uint64_t length = uint64_t(m_in.tellg() - m_start);
+  const uint64_t record_size = sizeof(uint64_t) + uint64_t(m_header.data_size);
+  if (!m_in.good() || m_header.index_offset < sizeof(LinearOctreeHeader) || m_header.index_offset > length
+      || m_header.num_chunks > (length - m_header.index_offset) / sizeof(LinearOctreeChunk)
+      || record_size > length)
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader,
+                    "The chunk index of " << m_header.num_chunks << " chunks at " << m_header.index_offset
+                    << " does not fit into the stream of " << length << " bytes!" << endl);
+    return;
+  }
+
+  m_index.resize(m_header.num_chunks);
+  m_in.seekg(m_start + std::streamoff(m_header.index_offset));
+  if (!m_index.empty())
+    m_in.read((char*) &m_index[0], m_index.size() * sizeof(LinearOctreeChunk));
+  if (!m_in.good())
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader, "Reading the chunk index failed!" << endl);
+    return;
+  }
+
+  // the chunks lie between the header and the index
+  for (std::size_t i = 0; i < m_index.size(); ++i)
+  {
+    const LinearOctreeChunk& c = m_index[i];
+    if (c.level >= m_header.level_count || c.num_records > m_header.records_per_chunk
+        || c.offset < sizeof(LinearOctreeHeader) || c.offset > m_header.index_offset
+        || c.num_records > (m_header.index_offset - c.offset) / record_size)
+    {
+      LOGGING_ERROR_C(OctreeLog, LinearOctreeReader,
+                      "Chunk " << i << " of level " << c.level << " with " << c.num_records << " records at "
+                      << c.offset << " is invalid!" << endl);
+      return;
+    }
+  }
+  m_valid = true;
+}
+
+uint32_t LinearOctreeReader::getSideLength(const uint32_t level) const
+{
+  uint32_t side = 1;
+  for (uint32_t l = 0; l < level; ++l)
+    side *= m_cube_side;
+  return side;
+}
+
+bool LinearOctreeReader::intersects(const uint32_t level, const uint64_t voxel_id, const LinearOctreeBox& box) const
+{
+  uint32_t coordinates[3];
+  linearOctreeVoxelCoordinates(voxel_id, coordinates[0], coordinates[1], coordinates[2]);
+  const uint64_t side = getSideLength(level);
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    if (coordinates[i] > box.max[i] || coordinates[i] + side - 1 < box.min[i])
+      return false;
+  }
+  return true;
+}
+
+bool LinearOctreeReader::mayIntersect(const std::size_t chunk, const LinearOctreeBox& box) const
+{
+  // all voxels of the box have Morton codes between the ones of its corners
+  // and a node covers the codes of all its voxels
+  const LinearOctreeChunk& c = m_index[chunk];
+  uint64_t span = 1;
+  for (uint32_t l = 0; l < c.level; ++l)
+    span *= m_header.branching_factor;
+  const uint64_t box_first = linearOctreeMortonCode(box.min[0], box.min[1], box.min[2]);
+  const uint64_t box_last = linearOctreeMortonCode(box.max[0], box.max[1], box.max[2]);
+  return c.first_voxel_id <= box_last && c.last_voxel_id + span - 1 >= box_first;
+}
+
+bool LinearOctreeReader::readChunk(const std::size_t chunk, std::vector<uint64_t>& voxel_ids,
+                                   std::vector<char>& data)
+{
+  voxel_ids.clear();
+  data.clear();
+  if (!m_valid || chunk >= m_index.size())
+    return false;
+
+  const LinearOctreeChunk& c = m_index[chunk];
+  if (c.num_records == 0)
+    return true;
+  const std::size_t record_size = sizeof(uint64_t) + m_header.data_size;
+  m_buffer.resize(std::size_t(c.num_records) * record_size);
+  m_in.seekg(m_start + std::streamoff(c.offset));
+  m_in.read(&m_buffer[0], m_buffer.size());
+  if (!m_in.good())
+  {
+    LOGGING_ERROR_C(OctreeLog, LinearOctreeReader, "Reading chunk " << chunk << " failed!" << endl);
+    return false;
+  }
+
+  voxel_ids.resize(c.num_records);
+  data.resize(std::size_t(c.num_records) * m_header.data_size);
+  for (uint32_t i = 0; i < c.num_records; ++i)
+  {
+    const char* record = &m_buffer[i * record_size];
+    memcpy(&voxel_ids[i], record, sizeof(uint64_t));
+    memcpy(&data[std::size_t(i) * m_header.data_size], record + sizeof(uint64_t), m_header.data_size);
+  }
+  return true;
+}
+
+bool LinearOctreeReader::readChunk(const std::size_t chunk, const LinearOctreeBox& box,
+                                   std::vector<uint64_t>& voxel_ids, std::vector<char>& data)
+{
+  if (!readChunk(chunk, voxel_ids, data))
+    return false;
+
+  // compact the records inside the box in place
+  const uint32_t level = m_index[chunk].level;
+  const std::size_t data_size = m_header.data_size;
+  std::size_t num_inside = 0;
+  for (std::size_t i = 0; i < voxel_ids.size(); ++i)
+  {
+    if (intersects(level, voxel_ids[i], box))
+    {
+      voxel_ids[num_inside] = voxel_ids[i];
+      std::copy(data.begin() + i * data_size, data.begin() + (i + 1) * data_size,
+                data.begin() + num_inside * data_size);
+      ++num_inside;
+    }
+  }
+  voxel_ids.resize(num_inside);
+  data.resize(num_inside * data_size);
+  return true;
+}
+
+bool LinearOctreeReader::readBoundingBox(const LinearOctreeBox& box, std::vector<uint32_t>& levels,
+                                         std::vector<uint64_t>& voxel_ids, std::vector<char>& data)
+{
+  levels.clear();
+  voxel_ids.clear();
+  data.clear();
+  std::vector<uint64_t> chunk_ids;
+  std::vector<char> chunk_data;
+  for (std::size_t c = 0; c < m_index.size(); ++c)
+  {
+    if (!mayIntersect(c, box))
+      continue;
+    if (!readChunk(c, box, chunk_ids, chunk_data))
+      return false;
+    levels.insert(levels.end(), chunk_ids.size(), m_index[c].level);
+    voxel_ids.insert(voxel_ids.end(), chunk_ids.begin(), chunk_ids.end());
+    data.insert(data.end(), chunk_data.begin(), chunk_data.end());
+  }
+  return true;
+}
+
+} // end of ns
+} // end of ns
@@ -0,0 +1,214 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * File format for NTrees as pointerless linear octrees. The file holds
+ * the leaves of the tree, i.e. all nodes without children, as records
+ * of a Morton code and the node data. The records are grouped by level
+ * and sorted by Morton code within each level. They are written in
+ * chunks of a fixed number of records and an index with the Morton
+ * range of each chunk follows the last chunk. So a reader can load a
+ * sub-volume by reading only the chunks that may intersect it, and both
+ * writer and reader only hold one chunk in memory.
+ *
+ * The writer and reader do not depend on CUDA.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_OCTREE_LINEAR_OCTREE_FILE_H_INCLUDED
+#define GPU_VOXELS_OCTREE_LINEAR_OCTREE_FILE_H_INCLUDED
+
+#include <stdint.h>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace gpu_voxels {
+namespace NTree {
+
+static const uint32_t cLINEAR_OCTREE_VERSION = 1;
+//! Largest number of levels a file can hold
+static const uint32_t cLINEAR_OCTREE_MAX_LEVELS = 32;
+static const uint32_t cLINEAR_OCTREE_DEFAULT_CHUNK_SIZE = 65536;
+
+/*!
+ * \brief Header at the beginning of a linear octree file. All values are stored in host byte order.
+ */
+struct LinearOctreeHeader
+{
+  char magic[4];              //!< "GVLO"
+  uint32_t version;
+  uint32_t branching_factor;
+  uint32_t level_count;
+  uint32_t resolution;        //!< Voxel side length in mm
+  uint32_t data_size;         //!< Bytes of node data of each record, which follow the Morton code
+  uint32_t records_per_chunk;
+  uint32_t num_chunks;
+  uint64_t num_records;
+  uint64_t index_offset;      //!< Position of the chunk index relative to the header
+  //! Number of the first record of each level, level_offsets[level_count] is num_records
+  uint64_t level_offsets[cLINEAR_OCTREE_MAX_LEVELS + 1];
+};
+
+/*!
+ * \brief Entry of the chunk index. A chunk only holds records of a single level.
+ */
+struct LinearOctreeChunk
+{
+  uint32_t level;
+  uint32_t num_records;
+  uint64_t first_voxel_id;
+  uint64_t last_voxel_id;
+  uint64_t offset;            //!< Position of the first record relative to the header
+};
+
+/*!
+ * \brief Axis aligned box of voxel coordinates, both corners are included.
+ */
+struct LinearOctreeBox
+{
+  LinearOctreeBox(const uint32_t min_x, const uint32_t min_y, const uint32_t min_z,
+                  const uint32_t max_x, const uint32_t max_y, const uint32_t max_z)
+  {
+    min[0] = min_x;
+    min[1] = min_y;
+    min[2] = min_z;
+    max[0] = max_x;
+    max[1] = max_y;
+    max[2] = max_z;
+  }
+
+  uint32_t min[3];
+  uint32_t max[3];
+};
+
+//! Morton code of voxel coordinates with 20 bits each, the same as morton_code60()
+uint64_t linearOctreeMortonCode(const uint32_t x, const uint32_t y, const uint32_t z);
+
+//! Inverse of linearOctreeMortonCode()
+void linearOctreeVoxelCoordinates(const uint64_t voxel_id, uint32_t& x, uint32_t& y, uint32_t& z);
+
+/*!
+ * \brief The LinearOctreeWriter class streams the records of a tree into a linear octree file.
+ *
+ * Levels have to be written in ascending order and the records of a level in ascending Morton
+ * order. Only the current chunk is buffered. The stream has to be seekable, since finish()
+ * writes the header again once the index is known.
+ */
+class LinearOctreeWriter
+{
+public:
+  LinearOctreeWriter(std::ostream& out, const uint32_t branching_factor, const uint32_t level_count,
+                     const uint32_t resolution, const uint32_t data_size,
+                     const uint32_t records_per_chunk = cLINEAR_OCTREE_DEFAULT_CHUNK_SIZE);
+
+  /*!
+   * \brief write Appends \a num records of the given level.
+   * \param voxel_ids Morton codes of the nodes
+   * \param data data_size bytes of node data per record
+   * \return false if the order is violated or the stream failed
+   */
+  bool write(const uint32_t level, const uint64_t* voxel_ids, const void* data, const std::size_t num);
+
+  //! Writes the last chunk, the index and the final header. Returns false if the stream failed.
+  bool finish();
+
+private:
+  bool flushChunk();
+
+  std::ostream& m_out;
+  std::streampos m_start;
+  LinearOctreeHeader m_header;
+  std::vector<LinearOctreeChunk> m_index;
+  std::vector<char> m_buffer;
+  LinearOctreeChunk m_chunk;
+  uint64_t m_num_written;
+  uint32_t m_last_level;
+  uint64_t m_last_voxel_id;
+  bool m_good;
+  bool m_finished;
+};
+
+/*!
+ * \brief The LinearOctreeReader class reads linear octree files chunk by chunk.
+ *
+ * The constructor reads the header and the index and checks that the chunks lie inside of the
+ * stream, otherwise isValid() is false. The chunks are read on demand by seeking to their
+ * position, so a query only touches the chunks it needs.
+ */
+class LinearOctreeReader
+{
+public:
+  explicit LinearOctreeReader(std::istream& in);
+
+  //! False if the stream holds no valid linear octree file
+  bool isValid() const
+  {
+    return m_valid;
+  }
+
+  const LinearOctreeHeader& getHeader() const
+  {
+    return m_header;
+  }
+
+  const std::vector<LinearOctreeChunk>& getIndex() const
+  {
+    return m_index;
+  }
+
+  //! Side length of the nodes of a level in voxels
+  uint32_t getSideLength(const uint32_t level) const;
+
+  //! True if a node of the given level and Morton code intersects the box
+  bool intersects(const uint32_t level, const uint64_t voxel_id, const LinearOctreeBox& box) const;
+
+  //! False if the Morton range of the chunk rules out any node intersecting the box
+  bool mayIntersect(const std::size_t chunk, const LinearOctreeBox& box) const;
+
+  /*!
+   * \brief readChunk Replaces the content of \a voxel_ids and \a data by the records of a chunk.
+   * \return false if the chunk could not be read
+   */
+  bool readChunk(const std::size_t chunk, std::vector<uint64_t>& voxel_ids, std::vector<char>& data);
+
+  //! Only keeps the records of the chunk which intersect the box
+  bool readChunk(const std::size_t chunk, const LinearOctreeBox& box, std::vector<uint64_t>& voxel_ids,
+                 std::vector<char>& data);
+
+  /*!
+   * \brief readBoundingBox Reads all records intersecting the box, skipping all other chunks.
+   * Nodes that only partly lie inside the box are returned as a whole. The records are ordered
+   * by level and Morton code, \a levels holds the level of each record.
+   */
+  bool readBoundingBox(const LinearOctreeBox& box, std::vector<uint32_t>& levels,
+                       std::vector<uint64_t>& voxel_ids, std::vector<char>& data);
+
+private:
+  std::istream& m_in;
+  std::streampos m_start;
+  LinearOctreeHeader m_header;
+  std::vector<LinearOctreeChunk> m_index;
+  std::vector<char> m_buffer;
+  uint32_t m_cube_side;
+  bool m_valid;
+};
+
+} // end of ns
+} // end of ns
+
+#endif
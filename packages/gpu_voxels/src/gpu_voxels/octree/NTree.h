@@ -24,6 +24,7 @@
 #define GPU_VOXELS_OCTREE_NTREE_H_INCLUDED
 
 #include <limits.h>
+#include <vector>
 
 // thrust
 #include <thrust/device_vector.h>
@@ -37,6 +38,8 @@
 #include <gpu_voxels/octree/EnvironmentNodes.h>
 #include <gpu_voxels/octree/EnvNodesProbabilistic.h>
 #include <gpu_voxels/octree/DefaultCollider.h>
+#include <gpu_voxels/octree/LinearOctreeFile.h>
+#include <gpu_voxels/octree/load_balancer/AutoTuner.h>
 
 #include <gpu_voxels/helpers/cuda_datatypes.h>
 #include <gpu_voxels/helpers/BitVector.h>
@@ -75,12 +78,36 @@ struct FindResult
     }
   };
 
+/**
+ * Entry of the frontier of the incremental free block collection. Either a node of the tree or a block of nodes
+ * which is no longer linked into the tree.
+ */
+struct FreeBlockTask
+{
+  void* m_ptr;
+  bool m_detached;
+
+  __host__ __device__
+  FreeBlockTask()
+  {
+
+  }
+
+  __host__ __device__
+  FreeBlockTask(void* ptr, bool detached)
+  {
+    m_ptr = ptr;
+    m_detached = detached;
+  }
+};
+
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
 class NTree
 {
 protected:
   static const uint32_t INITIAL_REBUILD_BUFFER_SIZE = 4000000;
   static const uint32_t INITIAL_EXTRACT_BUFFER_SIZE = 100000;
+  static const uint32_t DEFAULT_FREE_BLOCK_SLICE_SIZE = 16384;
   //static const std::size_t MAX_MEM_USAGE = 512 * std::size_t(1024 * 1024);
   uint32_t m_extract_buffer_size;
   uint32_t m_rebuild_buffer_size;
@@ -104,6 +131,26 @@ public:
   std::size_t m_max_memory_usage;
   uint32_t m_rebuild_counter;
 
+  /**
+   * Blocks of branching_factor nodes which are no longer part of the tree, one list per level of the nodes.
+   * insertVoxel() takes its nodes from here before allocating new memory.
+   */
+  std::vector<std::vector<void*> > m_free_blocks;
+
+  /**
+   * State of the incremental free block collection, which walks the tree level by level
+   */
+  thrust::device_vector<FreeBlockTask> m_collect_frontier;
+  thrust::device_vector<FreeBlockTask> m_collect_next_frontier;
+  uint32_t m_collect_level;
+  std::size_t m_collect_cursor;
+  uint32_t m_collect_slice_size;
+
+  /**
+   * Chooses the number of tasks and the idle threshold of the load balancers. Not owned, may be NULL.
+   */
+  LoadBalancer::AutoTuner* m_load_balancer_tuner;
+
   /**
    * Voxel side length measured in mm
    */
@@ -255,6 +302,12 @@ public:
    */
   void insertVoxel(thrust::device_vector<Voxel>& d_voxel_vector, bool set_free, bool propagate_up);
 
+  /*
+   * Inserts free and occupied voxel, whose free space is already computed, e.g. by the FreeSpaceRayCaster.
+   * Each voxel is updated once with its occupancy. The voxel of both vectors have to be unique and sorted by their id.
+   */
+  void insertUniqueVoxel(thrust::device_vector<Voxel>& d_free_space_voxel, thrust::device_vector<Voxel>& d_object_voxel);
+
   void propagate_bottom_up(thrust::device_vector<Voxel>& d_voxel_vector, uint32_t level = 0);
 
   void propagate_bottom_up(OctreeVoxelID* d_voxel_id, voxel_count num_voxel, uint32_t level = 0);
@@ -282,6 +335,46 @@ public:
 
   std::size_t getMemUsage() const;
 
+  /**
+   * Returns the memory of the allocated nodes which are ready to be recycled.
+   */
+  std::size_t getFreeMemUsage() const;
+
+  /**
+   * Runs one slice of the incremental collection of nodes cut off by pruning. Each call processes at most
+   * \p max_nodes nodes of the current tree level and moves the blocks of unlinked nodes into the free lists,
+   * so the pause stays bounded. A whole pass over the tree takes several calls and restarts at the root.
+   * Returns the number of collected blocks.
+   */
+  uint32_t collectFreeBlocks(const uint32_t max_nodes);
+
+  /**
+   * Maximum number of nodes processed by the collection slice which runs after each propagate(). 0 disables it.
+   */
+  uint32_t getFreeBlockSliceSize() const
+  {
+    return m_collect_slice_size;
+  }
+
+  void setFreeBlockSliceSize(const uint32_t slice_size)
+  {
+    m_collect_slice_size = slice_size;
+  }
+
+  LoadBalancer::AutoTuner* getLoadBalancerTuner() const
+  {
+    return m_load_balancer_tuner;
+  }
+
+  /**
+   * Lets \p tuner choose the parameters of intersect_load_balance() and extractCubes(). The tuner has
+   * to outlive the tree or be reset. NULL uses the default parameters.
+   */
+  void setLoadBalancerTuner(LoadBalancer::AutoTuner* tuner)
+  {
+    m_load_balancer_tuner = tuner;
+  }
+
   /**
    * Copy data of NTree into new one. Used for memory cleanup.
    * Returns a pointer to the new NTree.
@@ -304,6 +397,24 @@ public:
 
   bool deserialize(std::istream& in, const bool bin_mode = true);
 
+  /**
+   * Writes the tree as linear octree file, see LinearOctreeFile.h. The nodes are sorted on the device and copied
+   * to the host one chunk at a time, so the host memory stays bounded. The stream has to be seekable.
+   */
+  bool exportLinearOctree(std::ostream& out, const uint32_t records_per_chunk = cLINEAR_OCTREE_DEFAULT_CHUNK_SIZE);
+
+  /**
+   * Replaces the content of the tree by a linear octree file, which is read and inserted one chunk at a time.
+   */
+  bool importLinearOctree(std::istream& in);
+
+  /**
+   * Replaces the content of the tree by the nodes of a linear octree file which intersect the box of the given
+   * voxel coordinates. Nodes which only partly lie inside the box are loaded as a whole. Chunks outside of the
+   * box are skipped without reading them.
+   */
+  bool importLinearOctree(std::istream& in, const Vector3ui& min_voxel, const Vector3ui& max_voxel);
+
   void clear();
 
   /*
@@ -540,6 +651,13 @@ protected:
   void toVoxelCoordinates(thrust::host_vector<Vector3f>& h_points, thrust::device_vector<Vector3ui>& d_voxels);
 
   void internal_rebuild(thrust::device_vector<NodeData>& d_node_data, const uint32_t num_cubes);
+
+  /**
+   * Forgets all free blocks and restarts the collection. Used when the node memory is released.
+   */
+  void resetFreeBlocks();
+
+  bool importLinearOctree(std::istream& in, const LinearOctreeBox* box);
 };
 
 #ifndef NTREE_PRECOMPILE
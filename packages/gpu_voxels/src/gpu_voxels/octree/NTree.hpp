@@ -321,6 +321,9 @@ NTree<branching_factor, level_count, InnerNode, LeafNode>::NTree(uint32_t numBlo
   this->m_max_memory_usage = 200 * cMBYTE2BYTE; // 200 MB
   this->m_rebuild_counter = 0;
   this->m_has_data = false;
+  this->m_collect_slice_size = DEFAULT_FREE_BLOCK_SLICE_SIZE;
+  this->m_load_balancer_tuner = NULL;
+  resetFreeBlocks();
 
   InnerNode* r = new InnerNode();
   initRoot(*r);
@@ -839,7 +842,7 @@ voxel_count NTree<branching_factor, level_count, InnerNode, LeafNode>::intersect
   VoxelType>
   <<<numBlocks, numThreadsPerBlock, numThreadsPerBlock*sizeof(VoxelType)>>>
       (m_root,
-      voxel_map.getDeviceDataPtr(),
+      voxel_map.getConstDeviceDataPtr(),
       voxel_map.getVoxelMapSize(),
       voxel_map.getDimensions(),
       D_PTR(d_num_collisions),
@@ -1019,14 +1022,22 @@ voxel_count NTree<branching_factor, level_count, InnerNode, LeafNode>::intersect
       compute_voxelTypeFlags,
       VoxelType> MyLoadBalancer;
 
+  LoadBalancer::AutoTuner::Trial trial(
+      m_load_balancer_tuner,
+      "intersect_vmap",
+      LoadBalancer::AutoTuner::getShapeClass("intersect_vmap", branching_factor, level_count,
+                                             allocInnerNodes + allocLeafNodes));
+
   MyLoadBalancer load_balancer(
       this,
-      (VoxelType*) voxel_map.getVoidDeviceDataPtr(),
+      (const VoxelType*) voxel_map.getConstVoidDeviceDataPtr(),
       voxel_map.getDimensions(),
       offset,
-      min_level);
+      min_level,
+      trial.getParameters());
 
   load_balancer.run();
+  trial.finish();
 
   PERF_MON_PRINT_INFO_P(prefix, "", prefix);
   PERF_MON_ADD_DATA_NONTIME_P("NumCollisions", load_balancer.m_num_collisions, prefix);
@@ -1144,6 +1155,13 @@ OctreeVoxelID NTree<branching_factor, level_count, InnerNode, LeafNode>::interse
   PERF_MON_START(prefix);
 
   std::size_t num_collisions = 0;
+  LoadBalancer::AutoTuner::Trial trial(
+      m_load_balancer_tuner,
+      "intersect",
+      LoadBalancer::AutoTuner::getShapeClass(
+          "intersect", branching_factor, level_count,
+          allocInnerNodes + allocLeafNodes + other->allocInnerNodes + other->allocLeafNodes));
+
   // mark_collisions is not a template parameter, to be able to omit the template parameters for using this function (see GvlNTree.hpp)
   if(mark_collisions)
   {
@@ -1161,7 +1179,8 @@ OctreeVoxelID NTree<branching_factor, level_count, InnerNode, LeafNode>::interse
          this,
          other,
          min_level,
-         collider);
+         collider,
+         trial.getParameters());
      load_balancer.run();
      num_collisions = load_balancer.m_num_collisions;
   }
@@ -1181,10 +1200,12 @@ OctreeVoxelID NTree<branching_factor, level_count, InnerNode, LeafNode>::interse
          this,
          other,
          min_level,
-         collider);
+         collider,
+         trial.getParameters());
      load_balancer.run();
      num_collisions = load_balancer.m_num_collisions;
   }
+  trial.finish();
 
   PERF_MON_PRINT_INFO_P(prefix, "", prefix);
 //  PERF_MON_ADD_DATA_NONTIME_P("BalanceOverhead", *balance_overhead, prefix);
@@ -2114,7 +2135,7 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(Octr
 #endif
   time = getCPUTime();
 
-  thrust::device_vector<voxel_count> neededNodesPerLevel_h = d_neededNodesPerLevel;
+  thrust::host_vector<voxel_count> neededNodesPerLevel_h = d_neededNodesPerLevel;
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize()); // sync just like for plain kernel calls
   const voxel_count nLeafNodes = neededNodesPerLevel_h[numBlocks];
   const voxel_count nInnerNodes = neededNodesPerLevel_h.back() - nLeafNodes;
@@ -2122,14 +2143,41 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(Octr
   LOGGING_DEBUG(OctreeInsertLog, "new leaf nodes: " << nLeafNodes << endl << "new inner nodes: " <<  nInnerNodes << endl);
 #endif
 
+// take as many blocks as possible from the free lists
+  InsertNodeBlocks<level_count> node_blocks;
+  thrust::host_vector<void*> h_recycled_blocks;
+  voxel_count numNodes[level_count];
+  voxel_count nNewLeafNodes = 0, nNewInnerNodes = 0;
+  for (uint32_t i = 0; i < level_count; ++i)
+  {
+    numNodes[i] = neededNodesPerLevel_h[numBlocks * (i + 1)] - neededNodesPerLevel_h[numBlocks * i];
+    std::vector<void*>& free_blocks = m_free_blocks[i];
+    const std::size_t num_recycled = std::min(free_blocks.size(), std::size_t(numNodes[i] / branching_factor));
+    node_blocks.level_start[i] = (i == 0) ? 0 : neededNodesPerLevel_h[numBlocks * i] - nLeafNodes;
+    node_blocks.num_recycled[i] = voxel_count(num_recycled * branching_factor);
+    node_blocks.recycled_offset[i] = voxel_count(h_recycled_blocks.size());
+    h_recycled_blocks.insert(h_recycled_blocks.end(), free_blocks.end() - num_recycled, free_blocks.end());
+    free_blocks.resize(free_blocks.size() - num_recycled);
+    if (i == 0)
+      nNewLeafNodes = numNodes[i] - node_blocks.num_recycled[i];
+    else
+      nNewInnerNodes += numNodes[i] - node_blocks.num_recycled[i];
+  }
+  thrust::device_vector<void*> d_recycled_blocks = h_recycled_blocks;
+  node_blocks.recycled_blocks = D_PTR(d_recycled_blocks);
+
   void* d_newNodes = NULL;
-  const size_t leafLevel_size = size_t(nLeafNodes) * sizeof(LeafNode);
+  const size_t leafLevel_size = size_t(nNewLeafNodes) * sizeof(LeafNode);
   const uint32_t off = (leafLevel_size % 128);
   const uint32_t alignment = (off == 0) ? 0 : 128 - off;
-  size_t nSize = leafLevel_size + alignment + size_t(nInnerNodes) * sizeof(InnerNode);
-  HANDLE_CUDA_ERROR(cudaMalloc(&d_newNodes, nSize));
-  m_allocation_list.push_back(d_newNodes);
+  size_t nSize = leafLevel_size + alignment + size_t(nNewInnerNodes) * sizeof(InnerNode);
+  if (nSize > 0)
+  {
+    HANDLE_CUDA_ERROR(cudaMalloc(&d_newNodes, nSize));
+    m_allocation_list.push_back(d_newNodes);
+  }
 #ifdef INSERT_MESSAGES
+  LOGGING_DEBUG(OctreeInsertLog, "recycled blocks: " << h_recycled_blocks.size() << endl);
   LOGGING_DEBUG(OctreeInsertLog, "cudaMalloc() for " << nSize * cBYTE2MBYTE << " MB" << endl);
   LOGGING_DEBUG(OctreeInsertLog, "cudaMalloc(): " << timeDiff(time, getCPUTime()) << " ms" << endl);
 #endif
@@ -2138,46 +2186,50 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(Octr
 // init nodes
   LeafNode* leafNodes = (LeafNode*) d_newNodes;
 //  printf("leafNodes: %p\n", leafNodes);
-  InnerNode* const innerNodes = (InnerNode*) (((char*) d_newNodes) + leafLevel_size + alignment);
-  InnerNode* innerNodes_ptr = innerNodes;
-  //  printf("innerNodes: %p\n", innerNodes);
-  voxel_count numNodes = neededNodesPerLevel_h[2 * numBlocks] - neededNodesPerLevel_h[numBlocks];
-//printf("init level 0\n");
-
-//level 0
-  kernel_insert_initNeededNodes<branching_factor, level_count, LeafNode, false> <<<numBlocks,
-                                                                                   numThreadsPerBlock>>>(
-      leafNodes, nLeafNodes);
-  CHECK_CUDA_ERROR();
-  HANDLE_CUDA_ERROR(cudaDeviceSynchronize()); //TODO: safe to remove synchronization?
-  //HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-//printf("init level 1\n");
-
-//level 1
-  kernel_insert_initNeededNodes<branching_factor, level_count, InnerNode, true> <<<numBlocks,
-                                                                                   numThreadsPerBlock>>>(
-      innerNodes_ptr, numNodes);
-  CHECK_CUDA_ERROR();
-  HANDLE_CUDA_ERROR(cudaDeviceSynchronize()); //TODO: safe to remove synchronization?
-  //HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-  innerNodes_ptr += numNodes;
+  InnerNode* innerNodes_ptr = (InnerNode*) (((char*) d_newNodes) + leafLevel_size + alignment);
 
-//level 2-n
-  for (uint32_t i = 2; i < level_count; ++i)
+  for (uint32_t i = 0; i < level_count; ++i)
   {
-    //    printf("init level %i\n", i);
-    numNodes = neededNodesPerLevel_h[numBlocks * (i + 1)] - neededNodesPerLevel_h[numBlocks * i];
-    if (numNodes > 0)
+    const voxel_count numNewNodes = numNodes[i] - node_blocks.num_recycled[i];
+    const voxel_count numRecycledBlocks = node_blocks.num_recycled[i] / branching_factor;
+    void* const * const recycled = node_blocks.recycled_blocks + node_blocks.recycled_offset[i];
+    if (i == 0)
+    {
+      node_blocks.new_nodes[i] = leafNodes;
+      if (numNewNodes > 0)
+        kernel_insert_initNeededNodes<branching_factor, level_count, LeafNode, false> <<<numBlocks,
+                                                                                         numThreadsPerBlock>>>(
+            leafNodes, numNewNodes);
+      if (numRecycledBlocks > 0)
+        kernel_insert_initRecycledNodes<branching_factor, LeafNode, false> <<<numBlocks, numThreadsPerBlock>>>(
+            recycled, numRecycledBlocks);
+    }
+    else
     {
-//printf("init level %u numNodes %u\n", i, numNodes);
-      kernel_insert_initNeededNodes<branching_factor, level_count, InnerNode, false> <<<numBlocks,
-                                                                                        numThreadsPerBlock>>>(
-          innerNodes_ptr, numNodes);
-      CHECK_CUDA_ERROR();
-      HANDLE_CUDA_ERROR(cudaDeviceSynchronize()); //TODO: safe to remove synchronization?
-      //HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+      node_blocks.new_nodes[i] = innerNodes_ptr;
+      if (i == 1)
+      {
+        if (numNewNodes > 0)
+          kernel_insert_initNeededNodes<branching_factor, level_count, InnerNode, true> <<<numBlocks,
+                                                                                           numThreadsPerBlock>>>(
+              innerNodes_ptr, numNewNodes);
+        if (numRecycledBlocks > 0)
+          kernel_insert_initRecycledNodes<branching_factor, InnerNode, true> <<<numBlocks, numThreadsPerBlock>>>(
+              recycled, numRecycledBlocks);
+      }
+      else
+      {
+        if (numNewNodes > 0)
+          kernel_insert_initNeededNodes<branching_factor, level_count, InnerNode, false> <<<numBlocks,
+                                                                                            numThreadsPerBlock>>>(
+              innerNodes_ptr, numNewNodes);
+        if (numRecycledBlocks > 0)
+          kernel_insert_initRecycledNodes<branching_factor, InnerNode, false> <<<numBlocks, numThreadsPerBlock>>>(
+              recycled, numRecycledBlocks);
+      }
+      innerNodes_ptr += numNewNodes;
     }
-    innerNodes_ptr = (InnerNode*) &innerNodes_ptr[numNodes];
+    CHECK_CUDA_ERROR();
   }
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 
@@ -2191,17 +2243,16 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(Octr
       Iterator2, BasicData, SET_UPDATE_FLAG> <<<numBlocks, NUM_THREADS_PER_BLOCK>>>(
       this->m_root, d_voxel_vector, d_set_basic_data, d_reset_basic_data, num_voxel,
       D_PTR(d_neededNodesPerLevel),
-      leafNodes,
-      innerNodes,
+      node_blocks,
       D_PTR(d_traversalNodes),
       D_PTR(d_traversalLevels),
       target_level);
   CHECK_CUDA_ERROR();
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 
-// update counter
-  allocLeafNodes += nLeafNodes;
-  allocInnerNodes += nInnerNodes;
+// update counter, recycled nodes are already counted
+  allocLeafNodes += nNewLeafNodes;
+  allocInnerNodes += nNewInnerNodes;
   m_has_data = true; // indicate that the NTree holds some data
 
 #ifdef INSERT_MESSAGES
@@ -2281,6 +2332,67 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(
   }
 }
 
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertUniqueVoxel(
+    thrust::device_vector<Voxel>& d_free_space_voxel, thrust::device_vector<Voxel>& d_object_voxel)
+{
+  typedef typename NodeData::BasicData BasicData;
+
+  const std::string prefix = __FUNCTION__;
+  const std::string temp_timer = prefix + "_temp";
+  PERF_MON_START(prefix);
+  PERF_MON_START(temp_timer);
+
+#ifdef LOAD_BALANCING_PROPAGATE
+  const bool update_Flag = true;
+  unused(update_Flag);
+#else
+  const bool update_Flag = false;
+  unused(update_Flag);
+#endif
+
+  BasicData tmp;
+  getHardInsertResetData(tmp);
+  thrust::constant_iterator<BasicData> reset_data(tmp);
+
+  // insert the free space before the occupied voxel, like the insertion with ray casting does
+  thrust::device_vector<Voxel>* d_voxel[2] = { &d_free_space_voxel, &d_object_voxel };
+  thrust::device_vector<OctreeVoxelID> d_voxel_id[2];
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    const voxel_count num_voxel = d_voxel[i]->size();
+    if (num_voxel == 0)
+      continue;
+
+    d_voxel_id[i].resize(num_voxel);
+    thrust::device_vector<Probability> d_occupancy(num_voxel);
+    kernel_split_voxel_vector<true, true, false, false> <<<numBlocks, numThreadsPerBlock>>>(
+        D_PTR(*d_voxel[i]), num_voxel, D_PTR(d_voxel_id[i]), D_PTR(d_occupancy), NULL, NULL, NULL, NULL);
+    CHECK_CUDA_ERROR();
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+
+    thrust::device_vector<BasicData> set_data;
+    getBasicData(*d_voxel[i], set_data);
+    insertVoxel<update_Flag, BasicData>(D_PTR(d_voxel_id[i]), D_PTR(set_data), reset_data, num_voxel, 0);
+  }
+
+  const voxel_count num_new_voxel = d_free_space_voxel.size() + d_object_voxel.size();
+  PERF_MON_ADD_DATA_NONTIME_P("NewVoxel", num_new_voxel, prefix);
+  PERF_MON_PRINT_AND_RESET_INFO_P(temp_timer, "InsertVoxel", prefix);
+
+#ifdef LOAD_BALANCING_PROPAGATE
+  propagate(num_new_voxel);
+#else
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    if (d_voxel_id[i].size() > 0)
+      propagate_bottom_up(D_PTR(d_voxel_id[i]), d_voxel_id[i].size(), 0);
+  }
+#endif
+
+  PERF_MON_PRINT_INFO_P(temp_timer, "Propagate", prefix);
+}
+
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
 void NTree<branching_factor, level_count, InnerNode, LeafNode>::insertVoxel(
     thrust::device_vector<Voxel>& d_free_space_voxel, thrust::device_vector<Voxel>& d_object_voxel,
@@ -2712,13 +2824,20 @@ uint32_t NTree<branching_factor, level_count, InnerNode, LeafNode>::extractCubes
         LeafNode,
         true,
         false> MyLoadBalancer;
+  LoadBalancer::AutoTuner::Trial trial(
+        m_load_balancer_tuner,
+        "extract",
+        LoadBalancer::AutoTuner::getShapeClass("extract", branching_factor, level_count,
+                                               allocInnerNodes + allocLeafNodes));
   MyLoadBalancer load_balancer(
         this,
         D_PTR(d_node_data),
         needed_size,
         d_status_selection,
-        min_level);
+        min_level,
+        trial.getParameters());
   load_balancer.run();
+  trial.finish();
   uint32_t used_size = load_balancer.m_num_elements;
 
   //LOGGING_INFO(OctreeLog, "needed size " << used_size << endl);
@@ -2734,7 +2853,8 @@ uint32_t NTree<branching_factor, level_count, InnerNode, LeafNode>::extractCubes
           D_PTR(d_node_data),
           used_size,
           d_status_selection,
-          min_level);
+          min_level,
+          trial.getParameters());
     load_balancer.run();
     uint32_t used_size = load_balancer.m_num_elements;
 
@@ -2923,6 +3043,7 @@ void NTree<branching_factor, level_count, InnerNode,
 
   PERF_MON_PRINT_AND_RESET_INFO_P(temp_timer, "Propagate", prefix);
   PERF_MON_PRINT_INFO_P(prefix, "", prefix);
+  PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P(prefix, "Pause", prefix);
 
 #ifdef REBUILD_MESSAGES
   LOGGING_DEBUG(OctreeRebuildLog, "insertVoxel(): " <<  timeDiff(time, getCPUTime()) << " ms" << endl);
@@ -3046,10 +3167,84 @@ std::size_t NTree<branching_factor, level_count, InnerNode, LeafNode>::getMemUsa
   return allocLeafNodes * sizeof(LeafNode) + allocInnerNodes * sizeof(InnerNode);
 }
 
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+std::size_t NTree<branching_factor, level_count, InnerNode, LeafNode>::getFreeMemUsage() const
+{
+  std::size_t free_mem = m_free_blocks[0].size() * branching_factor * sizeof(LeafNode);
+  for (uint32_t l = 1; l < level_count; ++l)
+    free_mem += m_free_blocks[l].size() * branching_factor * sizeof(InnerNode);
+  return free_mem;
+}
+
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
 bool NTree<branching_factor, level_count, InnerNode, LeafNode>::needsRebuild() const
 {
-  return m_max_memory_usage != 0 && getMemUsage() >= m_max_memory_usage;
+  // free nodes are reused by the next insertions, so only the nodes in use count
+  return m_max_memory_usage != 0 && getMemUsage() - getFreeMemUsage() >= m_max_memory_usage;
+}
+
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+uint32_t NTree<branching_factor, level_count, InnerNode, LeafNode>::collectFreeBlocks(const uint32_t max_nodes)
+{
+  const std::string prefix = __FUNCTION__;
+  const std::string temp_timer = prefix + "_temp";
+  PERF_MON_START(temp_timer);
+
+  if (m_collect_cursor >= m_collect_frontier.size())
+  {
+    if (m_collect_next_frontier.empty())
+    {
+      // start the next pass at the root
+      m_collect_frontier.assign(1, FreeBlockTask(m_root, false));
+      m_collect_level = level_count - 1;
+    }
+    else
+    {
+      m_collect_frontier.swap(m_collect_next_frontier);
+      m_collect_next_frontier.clear();
+      --m_collect_level;
+    }
+    m_collect_cursor = 0;
+  }
+
+  const uint32_t num_tasks = uint32_t(std::min(std::size_t(max_nodes), m_collect_frontier.size() - m_collect_cursor));
+  if (num_tasks == 0)
+    return 0;
+
+  thrust::device_vector<FreeBlockTask> d_next_tasks(num_tasks * branching_factor);
+  thrust::device_vector<void*> d_free_blocks(num_tasks * (branching_factor + 1));
+  thrust::device_vector<uint32_t> d_free_block_levels(d_free_blocks.size());
+  thrust::device_vector<uint32_t> d_counter(2, 0);
+  kernel_collectFreeBlocks<branching_factor, InnerNode> <<<numBlocks, numThreadsPerBlock>>>(
+      D_PTR(m_collect_frontier) + m_collect_cursor, num_tasks, m_collect_level,
+      D_PTR(d_next_tasks), D_PTR(d_counter),
+      D_PTR(d_free_blocks), D_PTR(d_free_block_levels), D_PTR(d_counter) + 1);
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  m_collect_cursor += num_tasks;
+
+  const thrust::host_vector<uint32_t> h_counter = d_counter;
+  m_collect_next_frontier.insert(m_collect_next_frontier.end(), d_next_tasks.begin(),
+                                 d_next_tasks.begin() + h_counter[0]);
+  const thrust::host_vector<void*> h_free_blocks(d_free_blocks.begin(), d_free_blocks.begin() + h_counter[1]);
+  const thrust::host_vector<uint32_t> h_free_block_levels(d_free_block_levels.begin(),
+                                                          d_free_block_levels.begin() + h_counter[1]);
+  for (uint32_t i = 0; i < h_counter[1]; ++i)
+    m_free_blocks[h_free_block_levels[i]].push_back(h_free_blocks[i]);
+
+  PERF_MON_ADD_DATA_NONTIME_P("FreeBlocks", h_counter[1], prefix);
+  PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P(temp_timer, "Pause", prefix);
+  return h_counter[1];
+}
+
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+void NTree<branching_factor, level_count, InnerNode, LeafNode>::resetFreeBlocks()
+{
+  m_free_blocks.assign(level_count, std::vector<void*>());
+  m_collect_frontier.clear();
+  m_collect_next_frontier.clear();
+  m_collect_level = level_count - 1;
+  m_collect_cursor = 0;
 }
 
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
@@ -3098,6 +3293,10 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::propagate(const
       blocks);
   load_balancer.run();
   PERF_MON_PRINT_INFO_P(temp_timer, "", prefix);
+
+  // pick up the nodes which were just pruned, so the next insertion can reuse them
+  if (m_collect_slice_size != 0)
+    collectFreeBlocks(m_collect_slice_size);
 }
 
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
@@ -3389,6 +3588,158 @@ bool NTree<branching_factor, level_count, InnerNode, LeafNode>::deserialize(std:
   return true;
 }
 
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+bool NTree<branching_factor, level_count, InnerNode, LeafNode>::exportLinearOctree(std::ostream& out,
+                                                                                   const uint32_t records_per_chunk)
+{
+  LOGGING_DEBUG(OctreeDebugLog, "Export linear octree..." << endl);
+  typedef LoadBalancer::Extract<
+          branching_factor,
+          level_count,
+          InnerNode,
+          LeafNode,
+          false,
+          true> MyLBCounter;
+  typedef LoadBalancer::Extract<
+          branching_factor,
+          level_count,
+          InnerNode,
+          LeafNode,
+          false,
+          false> MyLoadBalancer;
+  MyLBCounter load_balancer_counter(
+          this,
+          NULL,
+          0,
+          m_extract_status_selection,
+          0);
+  load_balancer_counter.run();
+  const uint32_t needed_size = load_balancer_counter.m_num_elements;
+
+  thrust::device_vector<NodeData> d_node_data(needed_size);
+  MyLoadBalancer load_balancer(
+          this,
+          D_PTR(d_node_data),
+          needed_size,
+          m_extract_status_selection,
+          0);
+  load_balancer.run();
+  const uint32_t num_cubes = load_balancer.m_num_elements;
+  const uint32_t chunk_size = std::max(records_per_chunk, uint32_t(1));
+
+  LinearOctreeWriter writer(out, branching_factor, level_count, m_resolution, sizeof(BasicData), chunk_size);
+  thrust::device_vector<NodeData> d_level_data(num_cubes);
+  thrust::device_vector<OctreeVoxelID> d_voxel_id(num_cubes);
+  thrust::device_vector<BasicData> d_basic_data(num_cubes);
+  thrust::host_vector<OctreeVoxelID> h_voxel_id(chunk_size);
+  thrust::host_vector<BasicData> h_basic_data(chunk_size);
+  bool good = true;
+  for (uint32_t l = 0; l < level_count - 1 && good; ++l)
+  {
+    const voxel_count num_items = voxel_count(
+        thrust::copy_if(d_node_data.begin(), d_node_data.begin() + num_cubes, d_level_data.begin(),
+                        Comp_has_level(l)) - d_level_data.begin());
+    thrust::transform(d_level_data.begin(), d_level_data.begin() + num_items, d_voxel_id.begin(),
+                      Trafo_NodeData_to_OctreeVoxelID());
+    thrust::transform(d_level_data.begin(), d_level_data.begin() + num_items, d_basic_data.begin(),
+                      Trafo_to_BasicData());
+    thrust::sort_by_key(d_voxel_id.begin(), d_voxel_id.begin() + num_items, d_basic_data.begin());
+
+    for (voxel_count i = 0; i < num_items && good; i += chunk_size)
+    {
+      const voxel_count num = std::min(chunk_size, num_items - i);
+      thrust::copy(d_voxel_id.begin() + i, d_voxel_id.begin() + i + num, h_voxel_id.begin());
+      thrust::copy(d_basic_data.begin() + i, d_basic_data.begin() + i + num, h_basic_data.begin());
+      good = writer.write(l, &h_voxel_id[0], &h_basic_data[0], num);
+    }
+  }
+  good = writer.finish() && good;
+
+  LOGGING_DEBUG(OctreeDebugLog, "Export linear octree done: " << num_cubes << " Voxels" << endl);
+  return good;
+}
+
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+bool NTree<branching_factor, level_count, InnerNode, LeafNode>::importLinearOctree(std::istream& in)
+{
+  return importLinearOctree(in, NULL);
+}
+
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+bool NTree<branching_factor, level_count, InnerNode, LeafNode>::importLinearOctree(std::istream& in,
+                                                                                   const Vector3ui& min_voxel,
+                                                                                   const Vector3ui& max_voxel)
+{
+  const LinearOctreeBox box(min_voxel.x, min_voxel.y, min_voxel.z, max_voxel.x, max_voxel.y, max_voxel.z);
+  return importLinearOctree(in, &box);
+}
+
+template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
+bool NTree<branching_factor, level_count, InnerNode, LeafNode>::importLinearOctree(std::istream& in,
+                                                                                   const LinearOctreeBox* box)
+{
+// This throws a -Wunsused-variable at compile time, since this is only used as template parameter.
+#ifdef LOAD_BALANCING_PROPAGATE
+  const bool update_Flag = true;
+  unused(update_Flag);
+#else
+  const bool update_Flag = false;
+  unused(update_Flag);
+#endif
+
+  LOGGING_DEBUG(OctreeDebugLog, "Import linear octree..." << endl);
+  LinearOctreeReader reader(in);
+  if (!reader.isValid())
+    return false;
+  const LinearOctreeHeader& header = reader.getHeader();
+  if (header.branching_factor != branching_factor || header.level_count != level_count
+      || header.data_size != sizeof(BasicData))
+  {
+    LOGGING_ERROR_C(OctreeLog, NTree, "The linear octree file does not fit this tree type!" << endl);
+    return false;
+  }
+
+  clear();
+  m_resolution = header.resolution;
+
+  BasicData tmp;
+  getRebuildResetData(tmp);
+  thrust::constant_iterator<BasicData> reset_data(tmp);
+
+  // the chunks are ordered by level as needed by insertVoxel()
+  std::vector<uint64_t> h_voxel_id;
+  std::vector<char> h_data;
+  thrust::device_vector<OctreeVoxelID> d_voxel_id;
+  thrust::device_vector<BasicData> d_basic_data;
+  const std::vector<LinearOctreeChunk>& index = reader.getIndex();
+  voxel_count num_nodes = 0;
+  for (std::size_t c = 0; c < index.size(); ++c)
+  {
+    if (box != NULL && !reader.mayIntersect(c, *box))
+      continue;
+    if (!(box != NULL ? reader.readChunk(c, *box, h_voxel_id, h_data) : reader.readChunk(c, h_voxel_id, h_data)))
+      return false;
+    const voxel_count num = voxel_count(h_voxel_id.size());
+    if (num == 0)
+      continue;
+
+    d_voxel_id.assign(h_voxel_id.begin(), h_voxel_id.end());
+    d_basic_data.assign((const BasicData*) &h_data[0], (const BasicData*) &h_data[0] + num);
+    insertVoxel<update_Flag, BasicData>(D_PTR(d_voxel_id), D_PTR(d_basic_data), reset_data, num, index[c].level);
+#ifndef LOAD_BALANCING_PROPAGATE
+    propagate_bottom_up(D_PTR(d_voxel_id), num, index[c].level);
+#endif
+    num_nodes += num;
+  }
+
+#ifdef LOAD_BALANCING_PROPAGATE
+  propagate();
+#endif
+
+  LOGGING_DEBUG(OctreeDebugLog, "Import linear octree done. Loaded " << num_nodes << " Voxels" << endl);
+  return true;
+}
+
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode>
 void NTree<branching_factor, level_count, InnerNode, LeafNode>::clear()
 {
@@ -3406,6 +3757,7 @@ void NTree<branching_factor, level_count, InnerNode, LeafNode>::clear()
 
   allocInnerNodes = 1;
   allocLeafNodes = 0;
+  resetFreeBlocks();
 }
 
 } // end of ns
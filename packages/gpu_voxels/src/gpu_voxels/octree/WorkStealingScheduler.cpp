@@ -0,0 +1,183 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the work stealing scheduler.
+ *
+ */
+//----------------------------------------------------------------------
+#include "WorkStealingScheduler.h"
+
+#include <boost/bind.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+
+WorkStealingScheduler::WorkStealingScheduler(const uint32_t num_threads) :
+    m_generation(0),
+    m_shutdown(false),
+    m_function(NULL),
+    m_grain_size(1),
+    m_remaining(0),
+    m_num_steals(0)
+{
+  uint32_t threads = num_threads;
+  if (threads == 0)
+  {
+    threads = boost::thread::hardware_concurrency();
+  }
+  if (threads == 0)
+  {
+    threads = 1;
+  }
+
+  for (uint32_t i = 0; i < threads; ++i)
+  {
+    m_queues.push_back(new WorkerQueue());
+  }
+  for (uint32_t i = 1; i < threads; ++i)
+  {
+    m_threads.create_thread(boost::bind(&WorkStealingScheduler::workerLoop, this, i));
+  }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_start_condition.notify_all();
+  m_threads.join_all();
+
+  for (size_t i = 0; i < m_queues.size(); ++i)
+  {
+    delete m_queues[i];
+  }
+}
+
+void WorkStealingScheduler::parallelFor(const std::size_t begin, const std::size_t end,
+                                        const std::size_t grain_size, const RangeFunction& function)
+{
+  if (end <= begin)
+  {
+    return;
+  }
+
+  boost::lock_guard<boost::mutex> parallel_for_lock(m_parallel_for_mutex);
+  m_function = &function;
+  m_grain_size = grain_size == 0 ? 1 : grain_size;
+  m_remaining = end - begin;
+  {
+    boost::lock_guard<boost::mutex> lock(m_queues[0]->mutex);
+    m_queues[0]->ranges.push_back(Range(begin, end));
+  }
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    ++m_generation;
+  }
+  m_start_condition.notify_all();
+
+  work(0);
+  m_function = NULL;
+}
+
+void WorkStealingScheduler::workerLoop(const uint32_t index)
+{
+  uint64_t generation = 0;
+  while (true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      while (!m_shutdown && m_generation == generation)
+      {
+        m_start_condition.wait(lock);
+      }
+      if (m_shutdown)
+      {
+        return;
+      }
+      generation = m_generation;
+    }
+    work(index);
+  }
+}
+
+void WorkStealingScheduler::work(const uint32_t index)
+{
+  Range range;
+  while (m_remaining > 0)
+  {
+    if (popRange(index, range))
+    {
+      processRange(index, range);
+    }
+    else
+    {
+      // the remaining ranges are in progress, but may still be split
+      boost::this_thread::yield();
+    }
+  }
+}
+
+bool WorkStealingScheduler::popRange(const uint32_t index, Range& range)
+{
+  {
+    WorkerQueue& own = *m_queues[index];
+    boost::lock_guard<boost::mutex> lock(own.mutex);
+    if (!own.ranges.empty())
+    {
+      range = own.ranges.back();
+      own.ranges.pop_back();
+      return true;
+    }
+  }
+
+  const uint32_t num_queues = getNumThreads();
+  for (uint32_t i = 1; i < num_queues; ++i)
+  {
+    WorkerQueue& victim = *m_queues[(index + i) % num_queues];
+    boost::lock_guard<boost::mutex> lock(victim.mutex);
+    if (!victim.ranges.empty())
+    {
+      range = victim.ranges.front();
+      victim.ranges.pop_front();
+      ++m_num_steals;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingScheduler::processRange(const uint32_t index, Range range)
+{
+  while (range.end - range.begin > m_grain_size)
+  {
+    const std::size_t middle = range.begin + (range.end - range.begin) / 2;
+    {
+      WorkerQueue& own = *m_queues[index];
+      boost::lock_guard<boost::mutex> lock(own.mutex);
+      own.ranges.push_back(Range(middle, range.end));
+    }
+    range.end = middle;
+  }
+
+  (*m_function)(range.begin, range.end);
+  m_remaining -= range.end - range.begin;
+}
+
+} // end of ns
+} // end of ns
@@ -0,0 +1,129 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Small work stealing scheduler for the host implementation of the
+ * NTree. A parallel loop starts as a single index range. Each worker
+ * splits the range it works on in halves, keeps the lower half and
+ * pushes the upper half to the back of its own queue. Idle workers
+ * steal from the front of the other queues, where the largest ranges
+ * are, so the load balances itself like the load balancer of the GPU
+ * NTree, without a central work queue.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_OCTREE_WORK_STEALING_SCHEDULER_H_INCLUDED
+#define GPU_VOXELS_OCTREE_WORK_STEALING_SCHEDULER_H_INCLUDED
+
+#include <stdint.h>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+
+class WorkStealingScheduler
+{
+public:
+  //! Processes the indices [begin, end)
+  typedef boost::function<void(std::size_t begin, std::size_t end)> RangeFunction;
+
+  /*!
+   * \param num_threads Number of threads working on a loop, including the calling thread.
+   * 0 uses one thread per core.
+   */
+  explicit WorkStealingScheduler(const uint32_t num_threads = 0);
+
+  ~WorkStealingScheduler();
+
+  uint32_t getNumThreads() const
+  {
+    return uint32_t(m_queues.size());
+  }
+
+  /*!
+   * \brief parallelFor Calls \a function for disjoint sub-ranges of [begin, end), which together
+   * cover the whole range, and returns when all of them are processed. The calling thread works
+   * on the loop as well. Ranges are only split as long as they are larger than \a grain_size.
+   * Loops of the same scheduler are serialized and \a function must neither throw nor start
+   * another loop of this scheduler.
+   */
+  void parallelFor(const std::size_t begin, const std::size_t end, const std::size_t grain_size,
+                   const RangeFunction& function);
+
+  //! Number of ranges taken from the queue of another worker since the construction
+  uint64_t getNumSteals() const
+  {
+    return m_num_steals;
+  }
+
+private:
+  struct Range
+  {
+    Range() :
+        begin(0), end(0)
+    {
+    }
+
+    Range(const std::size_t begin_, const std::size_t end_) :
+        begin(begin_), end(end_)
+    {
+    }
+
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct WorkerQueue
+  {
+    boost::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  void workerLoop(const uint32_t index);
+
+  //! Works on the current loop until all of its indices are processed
+  void work(const uint32_t index);
+
+  //! Takes the last range of the own queue or steals the first one of another queue
+  bool popRange(const uint32_t index, Range& range);
+
+  void processRange(const uint32_t index, Range range);
+
+  //! Queue 0 belongs to the thread calling parallelFor()
+  std::vector<WorkerQueue*> m_queues;
+  boost::thread_group m_threads;
+
+  boost::mutex m_parallel_for_mutex;
+  boost::mutex m_mutex;
+  boost::condition_variable m_start_condition;
+  uint64_t m_generation;
+  bool m_shutdown;
+
+  const RangeFunction* m_function;
+  std::size_t m_grain_size;
+  boost::atomic<std::size_t> m_remaining;
+  boost::atomic<uint64_t> m_num_steals;
+};
+
+} // end of ns
+} // end of ns
+
+#endif
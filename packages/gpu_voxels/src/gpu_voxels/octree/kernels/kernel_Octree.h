@@ -538,7 +538,7 @@ void kernel_intersect(InnerNode* root, OctreeVoxelID* voxel, VoxelFlags* voxelFl
  */
 template<std::size_t branching_factor, std::size_t level_count, typename InnerNode, typename LeafNode,
     bool set_collision_flag, bool compute_voxelTypeFlags, bool compute_collsWithUnknown, typename VoxelType>
-__global__ void kernel_intersect_VoxelMap(InnerNode* root, VoxelType* voxels, uint32_t voxelmap_size,
+__global__ void kernel_intersect_VoxelMap(InnerNode* root, const VoxelType* voxels, uint32_t voxelmap_size,
                                           gpu_voxels::Vector3ui dimensions, voxel_count* num_collisions, voxel_count* num_collisions_w_unknown,
                                           VoxelType* d_result_voxels, const uint32_t min_level,
                                           const Vector3i voxelmap_offset = Vector3i(0))
@@ -1482,6 +1482,50 @@ static void kernel_insert_initNeededNodes(T* newNodes, voxel_count numNodes)
   }
 }
 
+/*
+ * Memory of the nodes needed by kernel_insert_setNodes(). The blocks of each level are numbered consecutively as
+ * counted by kernel_insert_countNeededNodes(). The first blocks of a level are recycled blocks of the free lists,
+ * the remaining ones lie in newly allocated memory.
+ */
+template<std::size_t level_count>
+struct InsertNodeBlocks
+{
+  void* new_nodes[level_count];              // first node of the new memory of each level
+  voxel_count level_start[level_count];      // index of the first node of each level
+  voxel_count num_recycled[level_count];     // number of recycled nodes of each level
+  voxel_count recycled_offset[level_count];  // index of the first recycled block of each level
+  void* const * recycled_blocks;
+};
+
+template<typename T, std::size_t branching_factor, std::size_t level_count>
+__device__ __forceinline__
+T* getInsertNodeBlock(const InsertNodeBlocks<level_count>& node_blocks, const uint32_t level,
+                      const voxel_count index)
+{
+  const voxel_count i = index - node_blocks.level_start[level];
+  if (i < node_blocks.num_recycled[level])
+    return (T*) node_blocks.recycled_blocks[node_blocks.recycled_offset[level] + i / branching_factor];
+  return &((T*) node_blocks.new_nodes[level])[i - node_blocks.num_recycled[level]];
+}
+
+template<std::size_t branching_factor, typename T, bool isLastLevel>
+__global__
+static void kernel_insert_initRecycledNodes(void* const * blocks, voxel_count numBlocks)
+{
+  const uint32_t num_threads = blockDim.x * gridDim.x;
+  const uint32_t thread_id = blockIdx.x * blockDim.x + threadIdx.x;
+
+  for (voxel_count i = thread_id; i < numBlocks * branching_factor; i += num_threads)
+  {
+    T* const node = &((T*) blocks[i / branching_factor])[i % branching_factor];
+    *node = T();
+    if (isLastLevel)
+      insertNodeLastLevel(node);
+    else
+      insertNode(node);
+  }
+}
+
 template<typename InnerNode, bool SET_STATUS, bool SET_UPDATE_FLAG>
 __device__ __forceinline__
 void insert_setInnerNodeStatus(InnerNode* innerNode, const NodeStatus node_status, const uint32_t level,
@@ -1511,8 +1555,7 @@ static void kernel_insert_setNodes(InnerNode* const root,
                                    Iterator2 d_reset_basic_data,
                                    const voxel_count numVoxel,
                                    voxel_count* const prefixSum,
-                                   LeafNode* const leafNodes,
-                                   InnerNode* const innerNodes,
+                                   const InsertNodeBlocks<level_count> node_blocks,
                                    void** const traversalNodes,
                                    uint32_t* const traversalLevels,
                                    const uint32_t target_level)
@@ -1601,7 +1644,8 @@ static void kernel_insert_setNodes(InnerNode* const root,
       {
         const uint32_t myIndex = getThreadPrefix_Inclusive(shared_prefix_sum, allVotes, thread_id);
         assert(myIndex > 0 || offset >= branching_factor);
-        child = (void*) &leafNodes[(offset + myIndex * branching_factor) - branching_factor];
+        child = (void*) getInsertNodeBlock<LeafNode, branching_factor>(
+            node_blocks, 0, (offset + myIndex * branching_factor) - branching_factor);
         LeafNode* const l = &((LeafNode*) child)[getZOrderNodeId<branching_factor>(my_voxel_id, 0)];
 
         setNode(l, my_set_basic_data, my_reset_basic_data);
@@ -1637,7 +1681,8 @@ static void kernel_insert_setNodes(InnerNode* const root,
       {
         const uint32_t myIndex = getThreadPrefix_Inclusive(shared_prefix_sum, allVotes, thread_id);
         assert(myIndex > 0 || offset >= branching_factor);
-        InnerNode* const iNode = &innerNodes[(offset + myIndex * branching_factor) - branching_factor];
+        InnerNode* const iNode = getInsertNodeBlock<InnerNode, branching_factor>(
+            node_blocks, l, (offset + myIndex * branching_factor) - branching_factor);
         InnerNode* const tmp = &iNode[getZOrderNodeId<branching_factor>(my_voxel_id, l)];
 
         setNode(tmp, child, my_set_basic_data, my_reset_basic_data);
@@ -1683,6 +1728,86 @@ static void kernel_insert_setNodes(InnerNode* const root,
 //    printf("setNodes() finished!\n");
 }
 
+/*
+ * Processes the given tasks of the incremental free block collection, which all belong to the given level.
+ * Nodes cut off by pruning keep their child pointer, but are no longer marked as ns_PART. Their blocks of
+ * children are unlinked and handed out as free blocks together with all blocks below them.
+ * Each task adds at most branching_factor tasks of the next level and branching_factor + 1 free blocks.
+ */
+template<std::size_t branching_factor, typename InnerNode>
+__global__
+static void kernel_collectFreeBlocks(const FreeBlockTask* const tasks,
+                                     const uint32_t num_tasks,
+                                     const uint32_t level,
+                                     FreeBlockTask* const next_tasks,
+                                     uint32_t* const num_next_tasks,
+                                     void** const free_blocks,
+                                     uint32_t* const free_block_levels,
+                                     uint32_t* const num_free_blocks)
+{
+  const uint32_t num_threads = blockDim.x * gridDim.x;
+  const uint32_t thread_id = blockIdx.x * blockDim.x + threadIdx.x;
+
+  for (uint32_t t = thread_id; t < num_tasks; t += num_threads)
+  {
+    const FreeBlockTask task = tasks[t];
+    if (task.m_detached)
+    {
+      // all blocks below an unlinked block are unlinked too
+      InnerNode* const block = (InnerNode*) task.m_ptr;
+      for (uint32_t c = 0; c < branching_factor; ++c)
+      {
+        void* const child = block[c].getChildPtr();
+        if (child != NULL)
+        {
+          if (level > 1)
+            next_tasks[atomicAdd(num_next_tasks, 1)] = FreeBlockTask(child, true);
+          else
+          {
+            const uint32_t i = atomicAdd(num_free_blocks, 1);
+            free_blocks[i] = child;
+            free_block_levels[i] = 0;
+          }
+        }
+      }
+      const uint32_t i = atomicAdd(num_free_blocks, 1);
+      free_blocks[i] = block;
+      free_block_levels[i] = level;
+    }
+    else
+    {
+      InnerNode* const node = (InnerNode*) task.m_ptr;
+      void* const child = node->getChildPtr();
+      if (child == NULL)
+        continue;
+
+      if (node->hasStatus(ns_PART))
+      {
+        if (level > 1)
+        {
+          InnerNode* const children = (InnerNode*) child;
+          for (uint32_t c = 0; c < branching_factor; ++c)
+            if (children[c].getChildPtr() != NULL)
+              next_tasks[atomicAdd(num_next_tasks, 1)] = FreeBlockTask(&children[c], false);
+        }
+      }
+      else
+      {
+        // pruned node, unlink its children
+        node->setChildPtr(NULL);
+        if (level > 1)
+          next_tasks[atomicAdd(num_next_tasks, 1)] = FreeBlockTask(child, true);
+        else
+        {
+          const uint32_t i = atomicAdd(num_free_blocks, 1);
+          free_blocks[i] = child;
+          free_block_levels[i] = 0;
+        }
+      }
+    }
+  }
+}
+
 struct BitMapProperties
 {
   enum Status
@@ -68,7 +68,7 @@ public:
    * @param idle_threshold Defines when to do a load balancing step by the percentage of idle tasks.
    * @param num_tasks Number of tasks to use.
    */
-  AbstractLoadBalancer(const float idle_threshold = DEFAULT_IDLE_THESHOLD, const uint32_t num_tasks = 2688);
+  AbstractLoadBalancer(const float idle_threshold = DEFAULT_IDLE_THESHOLD, const uint32_t num_tasks = cDEFAULT_NUM_TASKS);
 
   virtual ~AbstractLoadBalancer();
 
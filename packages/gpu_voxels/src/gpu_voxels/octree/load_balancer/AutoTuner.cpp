@@ -0,0 +1,308 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the load balancer tuning, see AutoTuner.h
+ *
+ */
+//----------------------------------------------------------------------
+#include <gpu_voxels/octree/load_balancer/AutoTuner.h>
+#include <gpu_voxels/logging/logging_octree.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+namespace LoadBalancer {
+
+namespace {
+
+const char* const cCACHE_FILE_HEADER = "# shape_class num_tasks idle_threshold time_ms";
+
+timespec getMonotonicTime()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t;
+}
+
+double timeDiffMs(const timespec& start, const timespec& end)
+{
+  return double(end.tv_sec - start.tv_sec) * 1000.0 + double(end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+} // end of anonymous namespace
+
+AutoTuner::Trial::Trial(AutoTuner* tuner, const std::string& kernel, const std::string& shape_class,
+                        const TuningParameters& defaults) :
+    m_tuner(tuner),
+    m_shape_class(shape_class),
+    m_parameters(defaults),
+    m_measuring(false)
+{
+  if (m_tuner != NULL)
+  {
+    m_parameters = m_tuner->select(kernel, shape_class, defaults, m_measuring);
+  }
+  m_start = getMonotonicTime();
+}
+
+AutoTuner::Trial::~Trial()
+{
+  finish();
+}
+
+void AutoTuner::Trial::finish()
+{
+  if (m_measuring)
+  {
+    m_measuring = false;
+    m_tuner->addMeasurement(m_shape_class, m_parameters, timeDiffMs(m_start, getMonotonicTime()));
+  }
+}
+
+AutoTuner::AutoTuner(const std::string& cache_file, const uint32_t num_trials) :
+    m_cache_file(cache_file),
+    m_num_trials(std::max(num_trials, uint32_t(1)))
+{
+  if (!m_cache_file.empty())
+  {
+    load();
+  }
+}
+
+std::string AutoTuner::getShapeClass(const std::string& kernel, const std::size_t branching_factor,
+                                     const std::size_t level_count, const std::size_t num_nodes)
+{
+  uint32_t size_class = 0;
+  for (std::size_t n = num_nodes; n > 1; n >>= 1)
+  {
+    ++size_class;
+  }
+
+  std::ostringstream stream;
+  stream << kernel << ":" << branching_factor << ":" << level_count << ":" << size_class;
+  return stream.str();
+}
+
+std::vector<TuningParameters> AutoTuner::getDefaultCandidates(const TuningParameters& defaults)
+{
+  const uint32_t num_tasks[] = { std::max(defaults.num_tasks / 4, uint32_t(1)),
+                                 std::max(defaults.num_tasks / 2, uint32_t(1)),
+                                 defaults.num_tasks,
+                                 defaults.num_tasks * 2 };
+  const float idle_thresholds[] = { defaults.idle_threshold * 0.75f,
+                                    defaults.idle_threshold,
+                                    std::min(defaults.idle_threshold * 1.25f, 1.0f) };
+
+  std::vector<TuningParameters> candidates;
+  for (std::size_t t = 0; t < sizeof(num_tasks) / sizeof(num_tasks[0]); ++t)
+  {
+    for (std::size_t i = 0; i < sizeof(idle_thresholds) / sizeof(idle_thresholds[0]); ++i)
+    {
+      const TuningParameters candidate(num_tasks[t], idle_thresholds[i]);
+      if (std::find(candidates.begin(), candidates.end(), candidate) == candidates.end())
+      {
+        candidates.push_back(candidate);
+      }
+    }
+  }
+  return candidates;
+}
+
+void AutoTuner::setCandidates(const std::string& kernel, const std::vector<TuningParameters>& candidates)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  m_candidates[kernel] = candidates;
+}
+
+TuningParameters AutoTuner::select(const std::string& kernel, const std::string& shape_class,
+                                   const TuningParameters& defaults, bool& measure)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  measure = false;
+
+  std::map<std::string, Winner>::const_iterator winner = m_winners.find(shape_class);
+  if (winner != m_winners.end())
+  {
+    return winner->second.parameters;
+  }
+
+  std::map<std::string, Session>::iterator it = m_sessions.find(shape_class);
+  if (it == m_sessions.end())
+  {
+    Session session;
+    std::map<std::string, std::vector<TuningParameters> >::const_iterator candidates = m_candidates.find(kernel);
+    if (candidates != m_candidates.end() && !candidates->second.empty())
+    {
+      session.candidates = candidates->second;
+    }
+    else
+    {
+      session.candidates = getDefaultCandidates(defaults);
+    }
+    session.times.resize(session.candidates.size());
+    session.num_selected.resize(session.candidates.size(), 0);
+    it = m_sessions.insert(std::make_pair(shape_class, session)).first;
+  }
+
+  // the candidates take turns, so a warm up of the GPU doesn't favor the first ones
+  Session& session = it->second;
+  const std::size_t index = std::min_element(session.num_selected.begin(), session.num_selected.end())
+      - session.num_selected.begin();
+  ++session.num_selected[index];
+  measure = true;
+  return session.candidates[index];
+}
+
+void AutoTuner::addMeasurement(const std::string& shape_class, const TuningParameters& parameters,
+                               const double time_ms)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+
+  std::map<std::string, Session>::iterator it = m_sessions.find(shape_class);
+  if (it == m_sessions.end())
+  {
+    return;
+  }
+  Session& session = it->second;
+  const std::size_t index = std::find(session.candidates.begin(), session.candidates.end(), parameters)
+      - session.candidates.begin();
+  if (index == session.candidates.size())
+  {
+    return;
+  }
+  session.times[index].push_back(time_ms);
+
+  for (std::size_t i = 0; i < session.times.size(); ++i)
+  {
+    if (session.times[i].size() < m_num_trials)
+    {
+      return;
+    }
+  }
+
+  Winner winner;
+  winner.time_ms = -1.0;
+  for (std::size_t i = 0; i < session.candidates.size(); ++i)
+  {
+    const double time = median(session.times[i]);
+    if (winner.time_ms < 0.0 || time < winner.time_ms)
+    {
+      winner.parameters = session.candidates[i];
+      winner.time_ms = time;
+    }
+  }
+  m_winners[shape_class] = winner;
+  m_sessions.erase(it);
+
+  LOGGING_INFO_C(OctreeLog, AutoTuner,
+                 "Tuned " << shape_class << ": " << winner.parameters.num_tasks << " tasks, idle threshold "
+                 << winner.parameters.idle_threshold << ", " << winner.time_ms << " ms" << endl);
+
+  if (!m_cache_file.empty())
+  {
+    saveLocked();
+  }
+}
+
+bool AutoTuner::getWinner(const std::string& shape_class, TuningParameters& parameters) const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  std::map<std::string, Winner>::const_iterator it = m_winners.find(shape_class);
+  if (it == m_winners.end())
+  {
+    return false;
+  }
+  parameters = it->second.parameters;
+  return true;
+}
+
+std::size_t AutoTuner::getNumWinners() const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  return m_winners.size();
+}
+
+bool AutoTuner::load()
+{
+  std::ifstream in(m_cache_file.c_str());
+  if (!in.is_open())
+  {
+    return false;
+  }
+
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    std::istringstream stream(line);
+    std::string shape_class;
+    Winner winner;
+    if (!(stream >> shape_class >> winner.parameters.num_tasks >> winner.parameters.idle_threshold
+        >> winner.time_ms) || winner.parameters.num_tasks == 0)
+    {
+      LOGGING_WARNING_C(OctreeLog, AutoTuner,
+                        "Skipping invalid line \"" << line << "\" of " << m_cache_file << endl);
+      continue;
+    }
+    m_winners[shape_class] = winner;
+    m_sessions.erase(shape_class);
+  }
+  return true;
+}
+
+bool AutoTuner::save() const
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  return saveLocked();
+}
+
+bool AutoTuner::saveLocked() const
+{
+  std::ofstream out(m_cache_file.c_str());
+  if (!out.is_open())
+  {
+    LOGGING_ERROR_C(OctreeLog, AutoTuner, "Could not write the tuning cache " << m_cache_file << endl);
+    return false;
+  }
+
+  out << cCACHE_FILE_HEADER << "\n";
+  for (std::map<std::string, Winner>::const_iterator it = m_winners.begin(); it != m_winners.end(); ++it)
+  {
+    out << it->first << " " << it->second.parameters.num_tasks << " " << it->second.parameters.idle_threshold
+        << " " << it->second.time_ms << "\n";
+  }
+  return out.good();
+}
+
+double AutoTuner::median(std::vector<double> times)
+{
+  std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+  return times[times.size() / 2];
+}
+
+}
+}
+}
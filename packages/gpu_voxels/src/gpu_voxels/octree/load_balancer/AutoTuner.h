@@ -0,0 +1,213 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Runtime tuning of the load balancers. The best number of tasks and
+ * idle threshold depend on the shape of the tree, so the tuner groups
+ * the runs into shape classes. The first runs of a class try each
+ * candidate configuration a few times, the one with the smallest
+ * median time wins and is stored in a cache file, which later runs
+ * read to use the winner right away. The tuner only does the
+ * bookkeeping and timing on the host, so it needs no CUDA.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_OCTREE_LOAD_BALANCER_AUTO_TUNER_H_INCLUDED
+#define GPU_VOXELS_OCTREE_LOAD_BALANCER_AUTO_TUNER_H_INCLUDED
+
+#include <stdint.h>
+#include <time.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+namespace LoadBalancer {
+
+//! Number of tasks the load balancers use if nothing else is given
+static const uint32_t cDEFAULT_NUM_TASKS = 2688;
+//! Fraction of idle tasks which triggers a balance step if nothing else is given
+static const float cDEFAULT_IDLE_THRESHOLD = 2.0f / 3.0f;
+
+/**
+ * @brief Runtime parameters of a load balancer. The number of threads and the stack size are
+ * template parameters of the kernels and can't be tuned at runtime.
+ */
+struct TuningParameters
+{
+  TuningParameters(const uint32_t num_tasks_ = cDEFAULT_NUM_TASKS,
+                   const float idle_threshold_ = cDEFAULT_IDLE_THRESHOLD) :
+      num_tasks(num_tasks_), idle_threshold(idle_threshold_)
+  {
+  }
+
+  bool operator==(const TuningParameters& other) const
+  {
+    return num_tasks == other.num_tasks && idle_threshold == other.idle_threshold;
+  }
+
+  uint32_t num_tasks;
+  float idle_threshold;
+};
+
+class AutoTuner
+{
+public:
+  /**
+   * @brief Measures the time of one load balancer run with the parameters chosen by the tuner.
+   * Without a tuner or for a tuned shape class nothing is measured.
+   */
+  class Trial
+  {
+  public:
+    /**
+     * @param tuner May be NULL, then \a defaults are used
+     * @param kernel Name of the load balancer, selects the candidates
+     * @param shape_class See getShapeClass()
+     * @param defaults Parameters used without a tuner and as base of the default candidates
+     */
+    Trial(AutoTuner* tuner, const std::string& kernel, const std::string& shape_class,
+          const TuningParameters& defaults = TuningParameters());
+
+    //! Calls finish() if it wasn't done yet
+    ~Trial();
+
+    const TuningParameters& getParameters() const
+    {
+      return m_parameters;
+    }
+
+    /**
+     * @brief Stops the time and hands it to the tuner. Call it after the results of the run are
+     * available on the host.
+     */
+    void finish();
+
+  private:
+    AutoTuner* m_tuner;
+    std::string m_shape_class;
+    TuningParameters m_parameters;
+    bool m_measuring;
+    timespec m_start;
+  };
+
+  /**
+   * @param cache_file Winners are read from and written to this file, no file is used if empty
+   * @param num_trials Runs of each candidate before the winner is chosen
+   */
+  explicit AutoTuner(const std::string& cache_file = "", const uint32_t num_trials = 3);
+
+  /**
+   * @brief Key of the class of trees which share their best parameters. Trees with the same
+   * branching factor and level count fall into the same class if their number of nodes has the
+   * same binary logarithm.
+   */
+  static std::string getShapeClass(const std::string& kernel, const std::size_t branching_factor,
+                                   const std::size_t level_count, const std::size_t num_nodes);
+
+  /**
+   * @brief Candidates around the given defaults: a quarter up to twice the number of tasks,
+   * each with a lower, the default and a higher idle threshold.
+   */
+  static std::vector<TuningParameters> getDefaultCandidates(const TuningParameters& defaults);
+
+  /**
+   * @brief Sets the candidates of all shape classes of \a kernel which are not tuned so far.
+   * Without it getDefaultCandidates() is used.
+   */
+  void setCandidates(const std::string& kernel, const std::vector<TuningParameters>& candidates);
+
+  /**
+   * @brief Returns the parameters for the next run of \a shape_class. While tuning, this is the
+   * candidate which was handed out least often, so runs which overlap get different candidates.
+   * @param measure Set to true if the run is part of the tuning and its time has to be passed to
+   * addMeasurement()
+   */
+  TuningParameters select(const std::string& kernel, const std::string& shape_class,
+                          const TuningParameters& defaults, bool& measure);
+
+  /**
+   * @brief Adds the time of one run. Once each candidate of \a shape_class has num_trials
+   * measurements, the one with the smallest median time becomes the winner and the cache file is
+   * written.
+   */
+  void addMeasurement(const std::string& shape_class, const TuningParameters& parameters, const double time_ms);
+
+  /**
+   * @brief Delivers the winner of \a shape_class.
+   * @return false if the class isn't tuned yet
+   */
+  bool getWinner(const std::string& shape_class, TuningParameters& parameters) const;
+
+  //! Number of tuned shape classes
+  std::size_t getNumWinners() const;
+
+  /**
+   * @brief Reads the winners of the cache file, lines which can't be parsed are skipped.
+   * @return false if the file can't be opened
+   */
+  bool load();
+
+  //! Writes all winners to the cache file
+  bool save() const;
+
+  const std::string& getCacheFile() const
+  {
+    return m_cache_file;
+  }
+
+  uint32_t getNumTrials() const
+  {
+    return m_num_trials;
+  }
+
+private:
+  struct Winner
+  {
+    TuningParameters parameters;
+    double time_ms;
+  };
+
+  //! Measurements of a shape class which isn't tuned yet
+  struct Session
+  {
+    std::vector<TuningParameters> candidates;
+    std::vector<std::vector<double> > times;
+    //! Number of runs handed out per candidate, including the ones which aren't measured yet
+    std::vector<uint32_t> num_selected;
+  };
+
+  //! Median of a non empty list of times
+  static double median(std::vector<double> times);
+
+  bool saveLocked() const;
+
+  std::string m_cache_file;
+  uint32_t m_num_trials;
+  std::map<std::string, std::vector<TuningParameters> > m_candidates;
+  std::map<std::string, Session> m_sessions;
+  std::map<std::string, Winner> m_winners;
+  mutable boost::mutex m_mutex;
+};
+
+}
+}
+}
+
+#endif
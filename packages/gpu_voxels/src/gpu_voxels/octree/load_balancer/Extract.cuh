@@ -37,8 +37,9 @@ Extract<branching_factor, level_count, InnerNode, LeafNode, clear_collision_flag
         NodeData* dev_node_data,
         const uint32_t node_data_size,
         uint8_t* dev_status_selection,
-        const uint32_t min_level) :
-    Base(),
+        const uint32_t min_level,
+        const TuningParameters& tuning) :
+    Base(tuning.idle_threshold, tuning.num_tasks),
     m_ntree(ntree),
     m_dev_node_data(dev_node_data),
     m_node_data_size(node_data_size),
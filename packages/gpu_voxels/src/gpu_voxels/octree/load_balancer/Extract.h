@@ -62,13 +62,15 @@ public:
    * @param m_node_data_size The size of \code dev_node_data \endcode
    * @param dev_status_selection Device array of size \code extract_selection_size \endcode where each entry (0 or 1) defines whether data with this status should be extracted (1) or not (0).
    * @param min_level The minimal level of \code ntree \endcode to extract data from
+   * @param tuning Number of tasks and idle threshold of the load balancer, see AutoTuner
    */
   Extract(
       NTree<branching_factor, level_count, InnerNode, LeafNode>* ntree,
       NodeData* dev_node_data,
       const uint32_t m_node_data_size,
       uint8_t* dev_status_selection,
-      const uint32_t min_level = 0);
+      const uint32_t min_level = 0,
+      const TuningParameters& tuning = TuningParameters());
 
   virtual ~Extract();
 
@@ -36,9 +36,9 @@ template<std::size_t branching_factor, std::size_t level_count, class InnerNode,
 Intersect<branching_factor, level_count, InnerNode, LeafNode, InnerNode2, LeafNode2, Collider, mark_collisions>::Intersect(
     NTree<branching_factor, level_count, InnerNode, LeafNode>* ntree_a,
     NTree<branching_factor, level_count, InnerNode2, LeafNode2>* ntree_b,
-    const uint32_t min_level, Collider collider)
+    const uint32_t min_level, Collider collider, const TuningParameters& tuning)
     :
-    Base(),
+    Base(tuning.idle_threshold, tuning.num_tasks),
     m_dev_num_collisions(NULL),
     m_num_collisions(SSIZE_MAX),
     m_collider(collider),
@@ -63,12 +63,14 @@ public:
    * @param ntree_b Second \code NTree \endcode to collide with.
    * @param min_level Traverse the tree down to this level for collision checking if necessary. Defines the resolution of this collision check.
    * @param collider Collider object which defines what is a collision.
+   * @param tuning Number of tasks and idle threshold of the load balancer, see AutoTuner
    */
   Intersect(
       NTree<branching_factor, level_count, InnerNode, LeafNode>* ntree_a,
       NTree<branching_factor, level_count, InnerNode2, LeafNode2>* ntree_b,
       const uint32_t min_level = 0,
-      Collider collider = DefaultCollider());
+      Collider collider = DefaultCollider(),
+      const TuningParameters& tuning = TuningParameters());
   virtual ~Intersect();
 
 protected:
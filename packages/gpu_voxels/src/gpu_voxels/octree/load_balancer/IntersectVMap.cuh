@@ -39,9 +39,10 @@ IntersectVMap<branching_factor, level_count, InnerNode, LeafNode, vft_size, set_
         const VoxelType* voxel_map,
         const gpu_voxels::Vector3ui voxel_map_dim,
         const gpu_voxels::Vector3i offset,
-        const uint32_t min_level)
+        const uint32_t min_level,
+        const TuningParameters& tuning)
     :
-    Base(),
+    Base(tuning.idle_threshold, tuning.num_tasks),
     m_dev_num_collisions(NULL),
     m_dev_result_voxelTypeFlags(NULL),
     m_ntree(ntree),
@@ -71,12 +71,14 @@ public:
    * @param voxel_map_dim Dimensions of the \code VoxelMap \endcode in voxel.
    * @param offset An offset to shift the voxelmap in relation to the \code NTree \endcode
    * @param min_level Traverse the tree down to this level for collision checking if necessary. Defines the resolution of this collision check.
+   * @param tuning Number of tasks and idle threshold of the load balancer, see AutoTuner
    */
   IntersectVMap(NTree<branching_factor, level_count, InnerNode, LeafNode>* ntree,
                 const VoxelType* voxel_map,
                 const gpu_voxels::Vector3ui voxel_map_dim,
                 const gpu_voxels::Vector3i offset = gpu_voxels::Vector3i(0, 0, 0),
-                const uint32_t min_level = 0);
+                const uint32_t min_level = 0,
+                const TuningParameters& tuning = TuningParameters());
   virtual ~IntersectVMap();
 
 protected:
@@ -186,6 +186,11 @@ bool parseArguments(vector<Provider_Parameter>& parameter, int argc, char **argv
         argv[i] = deleted_argument;
         parameter.back().type = Provider_Parameter::TYPE_OCTOMAP;
       }
+      else if (a.compare("-lin") == 0)
+      {
+        argv[i] = deleted_argument;
+        parameter.back().type = Provider_Parameter::TYPE_LINEAR_OCTREE;
+      }
       else if (a.compare("-mem") == 0)
       {
         if (i + 1 < argc)
@@ -209,6 +214,15 @@ bool parseArguments(vector<Provider_Parameter>& parameter, int argc, char **argv
           argv[i] = deleted_argument;
         }
       }
+      else if (a.compare("-tune") == 0)
+      {
+        if (i + 1 < argc)
+        {
+          argv[i] = deleted_argument;
+          parameter.back().tuning_cache = argv[++i];
+          argv[i] = deleted_argument;
+        }
+      }
       else if (a.compare("-id") == 0)
       {
         if (i + 1 < argc)
@@ -440,6 +454,8 @@ bool parseArguments(Bech_Parameter& parameter, int argc, char **argv, bool repor
             parameter.mode = Bech_Parameter::MODE_COLLIDE_LIVE;
           else if (a.compare("collide") == 0)
             parameter.mode = Bech_Parameter::MODE_COLLIDE;
+          else if (a.compare("cpu") == 0)
+            parameter.mode = Bech_Parameter::MODE_CPU;
           else
             argv[i] = tmp;
         }
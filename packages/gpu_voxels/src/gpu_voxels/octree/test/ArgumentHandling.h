@@ -110,7 +110,7 @@ struct Provider_Parameter
 
   enum Type
   {
-    TYPE_OCTREE, TYPE_VOXEL_MAP, TYPE_OCTOMAP
+    TYPE_OCTREE, TYPE_VOXEL_MAP, TYPE_OCTOMAP, TYPE_LINEAR_OCTREE
   };
 
   enum ModelType
@@ -150,6 +150,7 @@ struct Provider_Parameter
   Vector3i offset;
   bool serialize;
   ModelType model_type;
+  std::string tuning_cache;
 
   Provider_Parameter()
   {
@@ -185,6 +186,7 @@ struct Provider_Parameter
     offset = Vector3i(0, 0, 0);
     serialize = false;
     model_type = eMT_Probabilistic;
+    tuning_cache.clear();
   }
 
   __host__
@@ -210,6 +212,7 @@ struct Provider_Parameter
         "   -resOcc #: (1-x) Voxel side length in mm for the smallest voxel for occupied kinect data. Default 10 mm\n");
     printf(
         "   -resFree #: (1-x) Voxel side length in mm for the smallest voxel for free space kinect data. Default 40 mm\n");
+    printf("   -lin: Use the linear octree on the host. In benchmarks -threadsFrom/-threadsTo set its threads.\n");
     printf("   -c: Collide this data structure with the one of the next 'shm' number.\n");
     printf(
         "   -mem #: (0-x) Max. memory in MB for the VoxelMap, Octree. Default is 0 MB and means no limit.\n");
@@ -226,6 +229,7 @@ struct Provider_Parameter
     printf("   -sz #: Map dimensions of robot plan in meter. Default 10.0 m\n");
     printf("   -lb: Use load balancing for NTree and VoxelMap intersection. Default no load balancing\n");
     printf("   -serialize: Write the data into a file on exit of application with STRG+c and $exit\n");
+    printf("   -tune #: (file name) Tune the load balancers of the NTree and keep the best parameters in this file.\n");
     //printf("   -noFreeSpacePacking: Disables the feature of packing the free space before inserting it into the octree.\n");
     printf("\n\n");
   }
@@ -244,7 +248,7 @@ struct Bech_Parameter
 
   enum Mode
   {
-    MODE_NONE, MODE_BUILD, MODE_INSERT, MODE_COLLIDE_LIVE, MODE_COLLIDE
+    MODE_NONE, MODE_BUILD, MODE_INSERT, MODE_COLLIDE_LIVE, MODE_COLLIDE, MODE_CPU
   };
 
   std::vector<Provider::Provider_Parameter> provider_parameter;
@@ -368,7 +368,8 @@ void Kinect::run()
   //new pcl::ONIGrabber("./Recordings/Captured_0.oni", true, true);
 
   if (m_parameter->type == Provider::Provider_Parameter::TYPE_OCTOMAP
-      || m_parameter->type == Provider::Provider_Parameter::TYPE_VOXEL_MAP)
+      || m_parameter->type == Provider::Provider_Parameter::TYPE_VOXEL_MAP
+      || m_parameter->type == Provider::Provider_Parameter::TYPE_LINEAR_OCTREE)
   {
     boost::function<void(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr&)> f_cb = boost::bind(
         &Kinect::cloud_callback, this, _1);
@@ -0,0 +1,180 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the provider for the host linear octree.
+ *
+ */
+//----------------------------------------------------------------------
+
+#include "LinearNTreeProvider.h"
+
+#include <icl_core_performance_monitor/PerformanceMonitor.h>
+
+using namespace std;
+
+namespace gpu_voxels {
+namespace NTree {
+namespace Provider {
+
+LinearNTreeProvider::LinearNTreeProvider() :
+    Provider(),
+    m_tree(NULL)
+{
+  m_segment_name = "LinearNTreeProvider";
+}
+
+LinearNTreeProvider::~LinearNTreeProvider()
+{
+  delete m_tree;
+}
+
+void LinearNTreeProvider::visualize()
+{
+  // the visualizer only shows device data
+}
+
+void LinearNTreeProvider::init(Provider_Parameter& parameter)
+{
+  const string prefix = "LinearNTree::" + string(__FUNCTION__);
+  const string temp_timer = prefix + "_temp";
+
+  m_mutex.lock();
+
+  Provider::init(parameter);
+
+  m_tree = new Tree(parameter.num_threads > 0 ? parameter.num_threads : 0, parameter.resolution_tree);
+  printf("LinearNTree with %u threads\n", m_tree->getScheduler().getNumThreads());
+
+  std::vector<LinearNTreeVoxel> voxels;
+  if (!parameter.points.empty())
+  {
+    toVoxels(&parameter.points[0], parameter.points.size(), voxels);
+  }
+
+  PERF_MON_START(temp_timer);
+
+  m_tree->build(voxels);
+
+  PERF_MON_PRINT_INFO_P(temp_timer, "Build", prefix);
+
+  PERF_MON_ADD_STATIC_DATA_P("Mem", m_tree->getMemUsage(), prefix);
+  PERF_MON_ADD_STATIC_DATA_P("Nodes", m_tree->getNodes().size(), prefix);
+  PERF_MON_ADD_STATIC_DATA_P("Threads", m_tree->getScheduler().getNumThreads(), prefix);
+
+  m_mutex.unlock();
+}
+
+void LinearNTreeProvider::toVoxels(const gpu_voxels::Vector3f* h_point_cloud, const uint32_t num_points,
+                                   std::vector<LinearNTreeVoxel>& voxels) const
+{
+  const float scaling = 1000.0f / m_tree->m_resolution;
+  const float side = float(Tree::getSideLength(cLEVEL_COUNT - 1));
+  const float center = side / 2;
+  voxels.clear();
+  voxels.reserve(num_points);
+  for (uint32_t i = 0; i < num_points; ++i)
+  {
+    const gpu_voxels::Vector3f point = h_point_cloud[i];
+    const float x = floor(point.x * scaling + center);
+    const float y = floor(point.y * scaling + center);
+    const float z = floor(point.z * scaling + center);
+    // converting values outside of [0, side) to uint32_t is undefined, NaN fails the comparisons as well
+    if (x >= 0.0f && x < side && y >= 0.0f && y < side && z >= 0.0f && z < side)
+    {
+      voxels.push_back(LinearNTreeVoxel(uint32_t(x), uint32_t(y), uint32_t(z)));
+    }
+  }
+}
+
+void LinearNTreeProvider::newSensorData(gpu_voxels::Vector3f* h_point_cloud, const uint32_t num_points,
+                                        const uint32_t width, const uint32_t height)
+{
+  const string prefix = "LinearNTree::" + string(__FUNCTION__);
+  const string temp_timer = prefix + "_temp";
+
+  m_mutex.lock();
+
+  std::vector<LinearNTreeVoxel> voxels;
+  toVoxels(h_point_cloud, num_points, voxels);
+
+  PERF_MON_START(temp_timer);
+
+  std::vector<uint64_t> voxel_ids(voxels.size());
+  for (size_t i = 0; i < voxels.size(); ++i)
+  {
+    voxel_ids[i] = linearOctreeMortonCode(voxels[i].x, voxels[i].y, voxels[i].z);
+  }
+  m_tree->insertVoxel(voxel_ids, cLINEAR_NODE_OCCUPIED, 0);
+  m_tree->propagate();
+
+  PERF_MON_PRINT_INFO_P(temp_timer, "LinearNTreeInsert", prefix);
+  PERF_MON_ADD_DATA_NONTIME_P("UsedMemLinearNTree", m_tree->getMemUsage(), prefix);
+
+  m_changed = true;
+  m_mutex.unlock();
+}
+
+void LinearNTreeProvider::newSensorData(const DepthData* h_depth_data, const uint32_t width, const uint32_t height)
+{
+  // not yet implemented
+}
+
+void LinearNTreeProvider::collide()
+{
+  const string prefix = "LinearNTree::" + string(__FUNCTION__);
+  const string temp_timer = prefix + "_temp";
+
+  LinearNTreeProvider* other = dynamic_cast<LinearNTreeProvider*>(m_collide_with);
+  if (other == NULL)
+  {
+    // collisions are only supported with other host trees
+    return;
+  }
+
+  m_mutex.lock();
+  if (other != this)
+  {
+    other->lock();
+  }
+
+  PERF_MON_START(temp_timer);
+
+  const uint64_t num_collisions = m_tree->intersect(*other->getTree());
+
+  PERF_MON_PRINT_INFO_P(temp_timer, "Collide", prefix);
+  PERF_MON_ADD_DATA_NONTIME_P("NumCollisions", num_collisions, prefix);
+
+  if (other != this)
+  {
+    other->unlock();
+  }
+  m_mutex.unlock();
+}
+
+bool LinearNTreeProvider::waitForNewData(volatile bool* stop)
+{
+  // wait till new data is required
+  while (!*stop && !m_changed)
+  {
+    usleep(buffer_watch_delay);
+  }
+  return !*stop;
+}
+
+}
+}
+}
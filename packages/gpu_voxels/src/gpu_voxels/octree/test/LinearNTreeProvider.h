@@ -0,0 +1,76 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Provider for the host linear octree, used to compare it with the
+ * NTree and Octomap. Sensor data is inserted as occupied voxels only,
+ * there is no free space computation.
+ *
+ */
+//----------------------------------------------------------------------
+
+#ifndef GPU_VOXELS_OCTREE_TEST_LINEAR_NTREE_PROVIDER_H_INCLUDED
+#define GPU_VOXELS_OCTREE_TEST_LINEAR_NTREE_PROVIDER_H_INCLUDED
+
+#include <gpu_voxels/octree/test/Provider.h>
+#include <gpu_voxels/octree/LinearNTree.hpp>
+
+namespace gpu_voxels {
+namespace NTree {
+namespace Provider {
+
+class LinearNTreeProvider: public Provider
+{
+public:
+  // same dimensions as the NTreeProvider
+  static const uint32_t cLEVEL_COUNT = 15;
+  typedef LinearNTree<8, cLEVEL_COUNT> Tree;
+
+  LinearNTreeProvider();
+
+  virtual ~LinearNTreeProvider();
+
+  virtual void visualize();
+
+  virtual void init(Provider_Parameter& parameter);
+
+  virtual void newSensorData(const DepthData* h_depth_data, const uint32_t width, const uint32_t height);
+
+  virtual void newSensorData(gpu_voxels::Vector3f* h_point_cloud, const uint32_t num_points, const uint32_t width,
+                             const uint32_t height);
+
+  virtual void collide();
+
+  virtual bool waitForNewData(volatile bool* stop);
+
+  Tree* getTree()
+  {
+    return m_tree;
+  }
+
+protected:
+  //! Points in meter to voxels of the tree. The origin is the center of the tree, points outside of it are dropped.
+  void toVoxels(const gpu_voxels::Vector3f* h_point_cloud, const uint32_t num_points,
+                std::vector<LinearNTreeVoxel>& voxels) const;
+
+  Tree* m_tree;
+};
+
+}
+}
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include "NTreeProvider.h"
 #include "VoxelMapProvider.h"
 #include "OctomapProvider.h"
+#include "LinearNTreeProvider.h"
 
 #include <icl_core_performance_monitor/PerformanceMonitor.h>
 #include "Helper.h"
@@ -40,8 +41,26 @@ using namespace gpu_voxels::NTree::Provider;
 Bech_Parameter parameter;
 std::vector<gpu_voxels::NTree::Provider::Provider*> provider;
 const int num_names = 1000, num_events = 1000;
+//! Every summary is also appended to this JSON Lines file for further processing
+std::string perf_mon_json_file;
 SensorData* sensor_data = NULL;
 
+gpu_voxels::NTree::Provider::Provider* createProvider(const Provider_Parameter::Type type)
+{
+  switch (type)
+  {
+    case Provider_Parameter::TYPE_OCTREE:
+      return new NTreeProvider();
+    case Provider_Parameter::TYPE_VOXEL_MAP:
+      return new VoxelMapProvider();
+    case Provider_Parameter::TYPE_OCTOMAP:
+      return new OctomapProvider();
+    case Provider_Parameter::TYPE_LINEAR_OCTREE:
+      return new LinearNTreeProvider();
+  }
+  return NULL;
+}
+
 void build()
 {
   bool build_mode = false;
@@ -71,24 +90,12 @@ void build()
             for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
             {
               Provider_Parameter* my_parameter = &parameter.provider_parameter[i];
-              gpu_voxels::NTree::Provider::Provider* m_provider = NULL;
 
               // free data of last iteration
               if (provider[i] != NULL)
                 delete provider[i];
 
-              switch (my_parameter->type)
-              {
-                case Provider_Parameter::TYPE_OCTREE:
-                  m_provider = new NTreeProvider();
-                  break;
-                case Provider_Parameter::TYPE_VOXEL_MAP:
-                  m_provider = new VoxelMapProvider();
-                  break;
-                case Provider_Parameter::TYPE_OCTOMAP:
-                  m_provider = new OctomapProvider();
-              }
-              provider[i] = m_provider;
+              provider[i] = createProvider(my_parameter->type);
             }
 
             // init
@@ -118,6 +125,7 @@ void build()
             // performance logging
 
             PERF_MON_SUMMARY_ALL_INFO;
+            PERF_MON_APPEND_JSON(perf_mon_json_file);
             PERF_MON_INITIALIZE(num_names, num_events);
           }
           else
@@ -140,7 +148,6 @@ void collideRun()
   for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
   {
     Provider_Parameter* my_parameter = &parameter.provider_parameter[i];
-    gpu_voxels::NTree::Provider::Provider* m_provider = NULL;
 
     if (my_parameter->mode == Provider_Parameter::MODE_RANDOM_PLAN)
     {
@@ -148,18 +155,7 @@ void collideRun()
       if (provider[i] != NULL)
         delete provider[i];
 
-      switch (my_parameter->type)
-      {
-        case Provider_Parameter::TYPE_OCTREE:
-          m_provider = new NTreeProvider();
-          break;
-        case Provider_Parameter::TYPE_VOXEL_MAP:
-          m_provider = new VoxelMapProvider();
-          break;
-        case Provider_Parameter::TYPE_OCTOMAP:
-          m_provider = new OctomapProvider();
-      }
-      provider[i] = m_provider;
+      provider[i] = createProvider(my_parameter->type);
 
       std::vector<gpu_voxels::Vector3f> rand_plan;
       Test::getRandomPlan(my_parameter->points, rand_plan, 5, my_parameter->plan_size);
@@ -257,24 +253,12 @@ void insert_collide()
           for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
           {
             Provider_Parameter* my_parameter = &parameter.provider_parameter[i];
-            gpu_voxels::NTree::Provider::Provider* m_provider = NULL;
 
             // free data of last iteration
             if (provider[i] != NULL)
               delete provider[i];
 
-            switch (my_parameter->type)
-            {
-              case Provider_Parameter::TYPE_OCTREE:
-                m_provider = new NTreeProvider();
-                break;
-              case Provider_Parameter::TYPE_VOXEL_MAP:
-                m_provider = new VoxelMapProvider();
-                break;
-              case Provider_Parameter::TYPE_OCTOMAP:
-                m_provider = new OctomapProvider();
-            }
-            provider[i] = m_provider;
+            provider[i] = createProvider(my_parameter->type);
 
             // set resolution for this iteration
             my_parameter->resolution_tree = my_parameter->resolution_free =
@@ -348,6 +332,7 @@ void insert_collide()
               {
                 // performance logging
                 PERF_MON_SUMMARY_ALL_INFO;
+                PERF_MON_APPEND_JSON(perf_mon_json_file);
                 PERF_MON_INITIALIZE(num_names, num_events);
                 printf("Interation done\n");
               }
@@ -361,6 +346,77 @@ void insert_collide()
   }
 }
 
+/*!
+ * Compares the host linear octree with Octomap. Every provider builds its map out of the loaded
+ * point cloud and then inserts the cloud once more as sensor data seen from the origin. The thread
+ * range gives the number of threads of the linear octree. Octomap is single threaded and also
+ * computes the free space of the sensor data, the linear octree only inserts the end points.
+ */
+void cpu()
+{
+  if (parameter.mode != Bech_Parameter::MODE_CPU)
+    return;
+
+  PERF_MON_ENABLE("LinearNTree::init");
+  PERF_MON_ENABLE("LinearNTree::newSensorData");
+  PERF_MON_ENABLE("LinearNTree::collide");
+  PERF_MON_ENABLE("Octomap::init");
+  PERF_MON_ENABLE("Octomap::newSensorData");
+
+  for (int res = parameter.resolution_from; res <= parameter.resolution_to;
+      res = ceil(res * parameter.resolution_scaling))
+  {
+    for (int t = parameter.threads_from; t <= parameter.threads_to; t += parameter.threads_step)
+    {
+      PERF_MON_ADD_STATIC_DATA_P("THREADS", t, "LinearNTree::init");
+      PERF_MON_ADD_STATIC_DATA_P("RESOLUTION", res, "LinearNTree::init");
+      PERF_MON_ADD_STATIC_DATA_P("RESOLUTION", res, "Octomap::init");
+
+      for (int r = 0; r < parameter.runs; ++r)
+      {
+        for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
+        {
+          Provider_Parameter* my_parameter = &parameter.provider_parameter[i];
+
+          // free data of last iteration
+          if (provider[i] != NULL)
+            delete provider[i];
+
+          provider[i] = createProvider(my_parameter->type);
+          my_parameter->resolution_tree = res;
+          my_parameter->num_threads = t;
+          provider[i]->init(*my_parameter);
+        }
+
+        for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
+        {
+          Provider_Parameter* my_parameter = &parameter.provider_parameter[i];
+          if (!my_parameter->points.empty())
+            provider[i]->newSensorData(&my_parameter->points[0], my_parameter->points.size(),
+                                       my_parameter->points.size(), 1);
+        }
+
+        for (size_t i = 0; i < parameter.provider_parameter.size(); ++i)
+        {
+          if (parameter.provider_parameter[i].collide)
+          {
+            provider[i]->setCollideWith(provider[i + 1]);
+            provider[i]->collide();
+          }
+        }
+
+        // log every run or only after last one
+        if (parameter.log_runs || r == parameter.runs - 1)
+        {
+          PERF_MON_SUMMARY_ALL_INFO;
+          PERF_MON_APPEND_JSON(perf_mon_json_file);
+          PERF_MON_INITIALIZE(num_names, num_events);
+        }
+      }
+    }
+  }
+}
+
 void run()
 {
   provider = std::vector<gpu_voxels::NTree::Provider::Provider*>(parameter.provider_parameter.size(), NULL);
@@ -376,6 +432,8 @@ void run()
     m = "COLLIDE_LIVE";
   else if (parameter.mode == Bech_Parameter::MODE_COLLIDE)
     m = "COLLIDE";
+  else if (parameter.mode == Bech_Parameter::MODE_CPU)
+    m = "CPU";
   std::string t = getTime_str();
   std::string tree_type;
 #ifdef PROBABILISTIC_TREE
@@ -383,8 +441,10 @@ void run()
 #else
   tree_type = "DET";
 #endif
-  std::string filename = "./Benchmarks/" + m + "/" + getUname().nodename + "_" + tree_type + "_" + t + ".log";
+  std::string filename_base = "./Benchmarks/" + m + "/" + getUname().nodename + "_" + tree_type + "_" + t;
+  std::string filename = filename_base + ".log";
   printf("Log file: %s\n", filename.c_str());
+  perf_mon_json_file = filename_base + ".json";
   ofstream log(filename.c_str());
 
   utsname uname = getUname();
@@ -401,11 +461,16 @@ void run()
   log << std::endl;
 
   PERF_MON_INITIALIZE(num_names, num_events);
+  PERF_MON_START_TRACE(filename_base + ".trace.json");
 
   build();
 
   insert_collide();
 
+  cpu();
+
+  PERF_MON_STOP_TRACE;
+
   log.close();
 }
 
@@ -441,7 +506,9 @@ int main(int argc, char **argv)
     return 0;
   }
 
-  Test::testAndInitDevice();
+  // the CPU benchmark also runs on machines without a GPU
+  if (parameter.mode != Bech_Parameter::MODE_CPU)
+    Test::testAndInitDevice();
 
   run();
 
@@ -35,6 +35,7 @@
 #include <gpu_voxels/octree/EnvironmentNodes.h>
 #include <gpu_voxels/octree/EnvNodesProbabilistic.h>
 #include <gpu_voxels/octree/test/OctomapProvider.h>
+#include <gpu_voxels/octree/test/LinearNTreeProvider.h>
 
 #include <icl_core_performance_monitor/PerformanceMonitor.h>
 
@@ -123,6 +124,9 @@ void thread_handleProvider(Provider_Parameter& parameter, uint32_t id)
       break;
     case Provider_Parameter::TYPE_OCTOMAP:
       *provider = new OctomapProvider();
+      break;
+    case Provider_Parameter::TYPE_LINEAR_OCTREE:
+      *provider = new LinearNTreeProvider();
   }
 
   (**provider).init(parameter);
@@ -55,7 +55,7 @@ string ros_point_cloud_types[2] =
 boost::mutex NTreeProvider::m_shared_mutex;
 
 NTreeProvider::NTreeProvider() :
-    Provider(), m_ntree(NULL), m_min_level(0), m_shm_superVoxelSize(NULL), m_shm_memHandle(NULL),
+    Provider(), m_ntree(NULL), m_load_balancer_tuner(NULL), m_min_level(0), m_shm_superVoxelSize(NULL), m_shm_memHandle(NULL),
         m_shm_numCubes(NULL), m_shm_bufferSwapped(NULL), m_fps_rebuild(0), map_data_offset(0),
         m_spinner(NULL), m_node_handle(NULL), m_subscriber_front(NULL), m_subscriber_back(NULL),
         m_tf_listener(NULL), d_free_space_voxel(NULL), d_object_voxel(NULL),
@@ -119,6 +119,7 @@ NTreeProvider::~NTreeProvider()
 
   printf("delete ntree\n");
   delete m_ntree;
+  delete m_load_balancer_tuner;
 
   m_mutex.unlock();
   printf("NTreeProvider deconstructor finished!\n");
@@ -241,6 +242,11 @@ void NTreeProvider::init(Provider_Parameter& parameter)
 
   m_ntree = new NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode>(blocks, threads,
                                                                           parameter.resolution_tree);
+  if (!parameter.tuning_cache.empty())
+  {
+    m_load_balancer_tuner = new LoadBalancer::AutoTuner(parameter.tuning_cache);
+    m_ntree->setLoadBalancerTuner(m_load_balancer_tuner);
+  }
 
   if (parameter.mode == Provider_Parameter::MODE_DESERIALIZE)
   {
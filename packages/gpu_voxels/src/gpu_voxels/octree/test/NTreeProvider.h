@@ -87,6 +87,7 @@ protected:
 
 protected:
   NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode>* m_ntree;
+  LoadBalancer::AutoTuner* m_load_balancer_tuner;
   uint32_t m_min_level;
   uint32_t* m_shm_superVoxelSize;
   cudaIpcMemHandle_t* m_shm_memHandle;
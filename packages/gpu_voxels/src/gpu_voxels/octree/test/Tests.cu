@@ -22,10 +22,19 @@
 #include <cuda_runtime.h>
 
 #include <gpu_voxels/octree/NTree.h>
+#include <gpu_voxels/octree/LinearNTree.hpp>
+#include <gpu_voxels/octree/LinearOctreeFile.h>
 #include <gpu_voxels/octree/PointCloud.h>
 #include <gpu_voxels/helpers/cuda_handling.h>
 #include <cuda_profiler_api.h>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <math.h>
 #include "Helper.h"
 #include <gpu_voxels/octree/EnvironmentNodes.h>
@@ -643,6 +652,560 @@ bool insertTest(OctreeVoxelID num_points, OctreeVoxelID num_inserts, bool set_fr
   return !error;
 }
 
+bool recycleTest(uint32_t num_cubes)
+{
+  typedef NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode> NTREE;
+
+  bool error = false;
+
+  printf("\n\nrecycleTest()\n");
+
+  NTREE* o = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel(1, gpu_voxels::Vector3ui(0, 0, 0));
+  o->build(hVoxel);
+
+  // each cube fills a whole node of level 2, which the propagate of insertVoxel() prunes again
+  voxel_count allocLeafNodes = 0;
+  for (uint32_t c = 0; c < num_cubes && !error; ++c)
+  {
+    thrust::host_vector<Voxel> h_insertVoxel;
+    thrust::host_vector<gpu_voxels::Vector3ui> cubeVoxel;
+    for (uint32_t x = 0; x < 4; ++x)
+      for (uint32_t y = 0; y < 4; ++y)
+        for (uint32_t z = 0; z < 4; ++z)
+        {
+          const gpu_voxels::Vector3ui v(16 + 4 * c + x, 16 + y, 16 + z);
+          cubeVoxel.push_back(v);
+          h_insertVoxel.push_back(Voxel(morton_code60(v), v, MAX_PROBABILITY));
+        }
+    thrust::sort(h_insertVoxel.begin(), h_insertVoxel.end());
+    thrust::device_vector<Voxel> d_insertVoxel = h_insertVoxel;
+    o->insertVoxel(d_insertVoxel, false, true);
+
+    // complete a pass of the collection over all levels
+    for (uint32_t l = 0; l < LEVEL_COUNT; ++l)
+      o->collectFreeBlocks(NUM_VOXEL);
+
+    if (o->getFreeMemUsage() == 0)
+    {
+      error = true;
+      printf("Error! No free nodes collected after inserting cube %u.\n", c);
+    }
+
+    // the leaf nodes of all following cubes are recycled
+    if (c == 0)
+      allocLeafNodes = o->allocLeafNodes;
+    else if (o->allocLeafNodes != allocLeafNodes)
+    {
+      error = true;
+      printf("Error! Leaf nodes allocated for cube %u although free nodes were available.\n", c);
+    }
+
+    thrust::host_vector<FindResult<LeafNode> > resultNode(cubeVoxel.size());
+    o->find(cubeVoxel, resultNode);
+    for (uint32_t i = 0; i < cubeVoxel.size(); ++i)
+    {
+      if (!resultNode[i].m_node_data.isOccupied())
+      {
+        error = true;
+        printf("Error! Occupied voxel with ID %lu of cube %u not found in octree.\n",
+               (OctreeVoxelID) morton_code60(cubeVoxel[i]), c);
+        break;
+      }
+    }
+  }
+
+  delete o;
+
+  if (error)
+    printf("##### recycleTest() finished with ERRORS #####\n\n\n");
+  else
+    printf("recycleTest() finished\n\n\n");
+  return !error;
+}
+
+//! True if the reader accepts \a file after \a value was written to it at \a position
+template<typename T>
+bool isValidAfterPatch(const std::string& file, const std::size_t position, const T value)
+{
+  std::string patched = file;
+  memcpy(&patched[position], &value, sizeof(T));
+  std::stringstream stream(patched);
+  return LinearOctreeReader(stream).isValid();
+}
+
+bool linearOctreeTest(voxel_count num_points)
+{
+  typedef NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode> NTREE;
+
+  bool error = false;
+
+  printf("\n\nlinearOctreeTest()\n");
+
+  srand(TEST_RAND_SEED);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel = randomPoints(num_points, NUM_VOXEL);
+  NTREE* o = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  o->build(hVoxel);
+
+  // small chunks, so the file has many of them
+  std::stringstream file;
+  if (!o->exportLinearOctree(file, 1000))
+  {
+    error = true;
+    printf("Error! Export of the linear octree failed.\n");
+  }
+  delete o;
+
+  // load the whole file
+  NTREE* loaded = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  file.seekg(0);
+  if (!loaded->importLinearOctree(file))
+  {
+    error = true;
+    printf("Error! Import of the linear octree failed.\n");
+  }
+  thrust::host_vector<FindResult<LeafNode> > resultNode(hVoxel.size());
+  loaded->find(hVoxel, resultNode);
+  for (voxel_count i = 0; i < hVoxel.size(); ++i)
+  {
+    LeafNode n = (LeafNode) resultNode[i].m_node_data;
+    if (!n.isOccupied())
+    {
+      error = true;
+      printf("Error! Occupied voxel with ID %lu not found in imported octree.\n",
+             (OctreeVoxelID) morton_code60(hVoxel[i]));
+      break;
+    }
+  }
+  delete loaded;
+
+  // load one half of the map, which no node of the file overlaps partly
+  const uint32_t side = (uint32_t) ceil(pow(NUM_VOXEL, 1.0 / 3));
+  const gpu_voxels::Vector3ui min_voxel(0, 0, 0);
+  const gpu_voxels::Vector3ui max_voxel(side / 2 - 1, side - 1, side - 1);
+  NTREE* part = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  file.clear();
+  file.seekg(0);
+  if (!part->importLinearOctree(file, min_voxel, max_voxel))
+  {
+    error = true;
+    printf("Error! Import of a part of the linear octree failed.\n");
+  }
+  part->find(hVoxel, resultNode);
+  for (voxel_count i = 0; i < hVoxel.size(); ++i)
+  {
+    LeafNode n = (LeafNode) resultNode[i].m_node_data;
+    const bool inside = hVoxel[i].x <= max_voxel.x;
+    if (inside != n.isOccupied())
+    {
+      error = true;
+      printf("Error! Voxel with ID %lu %s the box.\n", (OctreeVoxelID) morton_code60(hVoxel[i]),
+             inside ? "missing inside of" : "loaded outside of");
+      break;
+    }
+  }
+  delete part;
+
+  // corrupted files are rejected instead of being read outside of their bounds
+  const std::string valid_file = file.str();
+  std::stringstream valid_stream(valid_file);
+  LinearOctreeReader reader(valid_stream);
+  const LinearOctreeHeader header = reader.getHeader();
+  const std::size_t first_chunk = header.index_offset;
+  std::stringstream truncated_stream(valid_file.substr(0, valid_file.size() - 1));
+  if (!reader.isValid() || header.num_chunks == 0
+      || LinearOctreeReader(truncated_stream).isValid()
+      || isValidAfterPatch(valid_file, offsetof(LinearOctreeHeader, num_chunks), uint32_t(0xffffffff))
+      || isValidAfterPatch(valid_file, offsetof(LinearOctreeHeader, index_offset), uint64_t(valid_file.size()))
+      || isValidAfterPatch(valid_file, first_chunk + offsetof(LinearOctreeChunk, level), header.level_count)
+      || isValidAfterPatch(valid_file, first_chunk + offsetof(LinearOctreeChunk, num_records),
+                           header.records_per_chunk + 1)
+      || isValidAfterPatch(valid_file, first_chunk + offsetof(LinearOctreeChunk, offset), header.index_offset))
+  {
+    error = true;
+    printf("Error! A corrupted linear octree file was accepted.\n");
+  }
+
+  // an empty chunk is valid and not read
+  std::string empty_chunk_file = valid_file;
+  const uint32_t no_records = 0;
+  memcpy(&empty_chunk_file[first_chunk + offsetof(LinearOctreeChunk, num_records)], &no_records, sizeof(uint32_t));
+  std::stringstream empty_chunk_stream(empty_chunk_file);
+  LinearOctreeReader empty_chunk_reader(empty_chunk_stream);
+  std::vector<uint64_t> chunk_ids(1);
+  std::vector<char> chunk_data(1);
+  if (!empty_chunk_reader.isValid() || !empty_chunk_reader.readChunk(0, chunk_ids, chunk_data) || !chunk_ids.empty())
+  {
+    error = true;
+    printf("Error! Reading an empty chunk failed.\n");
+  }
+
+  if (error)
+    printf("##### linearOctreeTest() finished with ERRORS #####\n\n\n");
+  else
+    printf("linearOctreeTest() finished\n\n\n");
+  return !error;
+}
+
+//! Occupancy of a dense voxel map for LinearNTree::intersectVoxelMap()
+struct DenseOccupancy
+{
+  DenseOccupancy(const std::vector<uint8_t>& occupied_, const uint32_t side_) :
+      occupied(occupied_), side(side_)
+  {
+  }
+
+  bool operator()(const uint32_t x, const uint32_t y, const uint32_t z) const
+  {
+    return occupied[(uint64_t(z) * side + y) * side + x] != 0;
+  }
+
+  const std::vector<uint8_t>& occupied;
+  const uint32_t side;
+};
+
+//! True if the linear tree holds exactly the states of the dense map of the lower corner of the tree
+template<typename LINEAR_NTREE>
+bool equalsDenseMap(LINEAR_NTREE& tree, const std::vector<uint8_t>& dense, const uint32_t side, const char* name)
+{
+  std::vector<LinearNTreeVoxel> query(dense.size());
+  for (uint32_t z = 0; z < side; ++z)
+    for (uint32_t y = 0; y < side; ++y)
+      for (uint32_t x = 0; x < side; ++x)
+        query[(uint64_t(z) * side + y) * side + x] = LinearNTreeVoxel(x, y, z);
+  std::vector<LinearNTreeFindResult> result;
+  tree.find(query, result);
+  uint64_t num_known = 0;
+  for (std::size_t i = 0; i < query.size(); ++i)
+  {
+    if (result[i].status != dense[i])
+    {
+      printf("Error! Voxel (%u, %u, %u) of the %s linear NTree has status %u instead of %u.\n", query[i].x,
+             query[i].y, query[i].z, name, result[i].status, dense[i]);
+      return false;
+    }
+    if (dense[i] != cLINEAR_NODE_UNKNOWN)
+      ++num_known;
+  }
+
+  // nodes outside of the dense map would add to the volume of the cubes
+  std::vector<LinearNTreeCube> cubes;
+  tree.extractCubes(cubes);
+  uint64_t volume = 0;
+  for (size_t i = 0; i < cubes.size(); ++i)
+    volume += uint64_t(cubes[i].side_length) * cubes[i].side_length * cubes[i].side_length;
+  if (volume != num_known)
+  {
+    printf("Error! Cubes of the %s linear NTree cover %lu voxels instead of %lu.\n", name, volume, num_known);
+    return false;
+  }
+  return true;
+}
+
+bool linearNTreeTest(voxel_count num_points)
+{
+  typedef NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode> NTREE;
+  typedef LinearNTree<BRANCHING_FACTOR, LEVEL_COUNT> LINEAR_NTREE;
+
+  bool error = false;
+
+  printf("\n\nlinearNTreeTest()\n");
+
+  srand(TEST_RAND_SEED);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel = randomPoints(num_points, NUM_VOXEL);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel2 = randomPoints(num_points, NUM_VOXEL);
+  std::vector<LinearNTreeVoxel> voxel(hVoxel.size());
+  std::vector<LinearNTreeVoxel> voxel2(hVoxel2.size());
+  std::set<OctreeVoxelID> ids, ids2;
+  for (voxel_count i = 0; i < hVoxel.size(); ++i)
+  {
+    voxel[i] = LinearNTreeVoxel(hVoxel[i].x, hVoxel[i].y, hVoxel[i].z);
+    ids.insert(morton_code60(hVoxel[i]));
+  }
+  for (voxel_count i = 0; i < hVoxel2.size(); ++i)
+  {
+    voxel2[i] = LinearNTreeVoxel(hVoxel2[i].x, hVoxel2[i].y, hVoxel2[i].z);
+    ids2.insert(morton_code60(hVoxel2[i]));
+  }
+
+  NTREE* o = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  o->build(hVoxel);
+  LINEAR_NTREE linear(0);
+  linear.build(voxel);
+  LINEAR_NTREE linear2(0);
+  linear2.build(voxel2);
+
+  // both trees have to agree on the occupancy of the voxels of both sets
+  thrust::host_vector<gpu_voxels::Vector3ui> hQuery = hVoxel;
+  hQuery.insert(hQuery.end(), hVoxel2.begin(), hVoxel2.end());
+  std::vector<LinearNTreeVoxel> query = voxel;
+  query.insert(query.end(), voxel2.begin(), voxel2.end());
+  thrust::host_vector<FindResult<LeafNode> > resultNode(hQuery.size());
+  o->find(hQuery, resultNode);
+  std::vector<LinearNTreeFindResult> linearResult;
+  linear.find(query, linearResult);
+  for (voxel_count i = 0; i < hQuery.size(); ++i)
+  {
+    LeafNode n = (LeafNode) resultNode[i].m_node_data;
+    if (n.isOccupied() != (linearResult[i].status == cLINEAR_NODE_OCCUPIED))
+    {
+      error = true;
+      printf("Error! Occupancy of voxel with ID %lu differs between NTree and linear NTree.\n",
+             (OctreeVoxelID) morton_code60(hQuery[i]));
+      break;
+    }
+  }
+  delete o;
+
+  std::vector<OctreeVoxelID> common;
+  std::set_intersection(ids.begin(), ids.end(), ids2.begin(), ids2.end(), std::back_inserter(common));
+  const uint64_t num_collisions = linear.intersect(linear2);
+  const uint64_t num_list_collisions = linear.intersectVoxelList(voxel2);
+  if (num_collisions != common.size() || num_list_collisions != common.size())
+  {
+    error = true;
+    printf("Error! Intersection found %lu and %lu instead of %lu collisions.\n", num_collisions,
+           num_list_collisions, common.size());
+  }
+
+  std::vector<LinearNTreeCube> cubes;
+  linear.extractCubes(cubes);
+  uint64_t volume = 0;
+  for (size_t i = 0; i < cubes.size(); ++i)
+    volume += uint64_t(cubes[i].side_length) * cubes[i].side_length * cubes[i].side_length;
+  if (volume != ids.size())
+  {
+    error = true;
+    printf("Error! Cubes cover %lu voxels instead of %lu.\n", volume, ids.size());
+  }
+
+  // Random nodes of several levels and states are inserted into a dense map of the lower corner of the tree,
+  // one tree is propagated after each insert and the other one only at the end.
+  const uint32_t dense_side = 64;
+  uint32_t max_level = 0;
+  while (LINEAR_NTREE::getSideLength(max_level + 1) <= dense_side / 4)
+    ++max_level;
+  const uint8_t states[3] = { cLINEAR_NODE_FREE, cLINEAR_NODE_UNKNOWN, cLINEAR_NODE_OCCUPIED };
+  std::vector<uint8_t> dense(uint64_t(dense_side) * dense_side * dense_side, cLINEAR_NODE_UNKNOWN);
+  LINEAR_NTREE propagated(0);
+  LINEAR_NTREE unpropagated(0);
+  for (uint32_t r = 0; r < 200; ++r)
+  {
+    const uint32_t level = rand() % (max_level + 1);
+    const uint8_t status = states[rand() % 3];
+    const uint32_t side = LINEAR_NTREE::getSideLength(level);
+    std::vector<uint64_t> voxel_ids(1 + rand() % 32);
+    for (size_t i = 0; i < voxel_ids.size(); ++i)
+    {
+      const uint32_t x = rand() % dense_side, y = rand() % dense_side, z = rand() % dense_side;
+      voxel_ids[i] = linearOctreeMortonCode(x, y, z);
+      for (uint32_t c = z - z % side; c < z - z % side + side; ++c)
+        for (uint32_t b = y - y % side; b < y - y % side + side; ++b)
+          for (uint32_t a = x - x % side; a < x - x % side + side; ++a)
+            dense[(uint64_t(c) * dense_side + b) * dense_side + a] = status;
+    }
+    propagated.insertVoxel(voxel_ids, status, level);
+    propagated.propagate();
+    unpropagated.insertVoxel(voxel_ids, status, level);
+  }
+  if (!equalsDenseMap(propagated, dense, dense_side, "propagated")
+      || !equalsDenseMap(unpropagated, dense, dense_side, "unpropagated"))
+  {
+    error = true;
+  }
+
+  // merging is independent of the order of the inserts
+  unpropagated.propagate();
+  const std::vector<LinearNTreeNode>& nodes = propagated.getNodes();
+  const std::vector<LinearNTreeNode>& nodes2 = unpropagated.getNodes();
+  bool equal_nodes = nodes.size() == nodes2.size();
+  for (size_t i = 0; equal_nodes && i < nodes.size(); ++i)
+  {
+    equal_nodes = nodes[i].voxel_id == nodes2[i].voxel_id && nodes[i].level == nodes2[i].level
+        && nodes[i].status == nodes2[i].status;
+  }
+  if (!equal_nodes)
+  {
+    error = true;
+    printf("Error! Propagation results in %lu instead of %lu nodes or different ones.\n", nodes2.size(),
+           nodes.size());
+  }
+
+  // the map is cut in y, so only part of the nodes at its border are in it
+  std::vector<uint8_t> map_occupied(dense.size());
+  const LinearNTreeVoxel map_dim(dense_side, dense_side - 5, dense_side);
+  uint64_t expected_map_collisions = 0;
+  for (uint32_t z = 0; z < dense_side; ++z)
+    for (uint32_t y = 0; y < dense_side; ++y)
+      for (uint32_t x = 0; x < dense_side; ++x)
+      {
+        const uint64_t i = (uint64_t(z) * dense_side + y) * dense_side + x;
+        map_occupied[i] = rand() % 3 == 0;
+        if (map_occupied[i] && y < map_dim.y && dense[i] == cLINEAR_NODE_OCCUPIED)
+          ++expected_map_collisions;
+      }
+  const uint64_t map_collisions = propagated.intersectVoxelMap(map_dim, DenseOccupancy(map_occupied, dense_side));
+  if (map_collisions != expected_map_collisions)
+  {
+    error = true;
+    printf("Error! Intersection with the voxel map found %lu instead of %lu collisions.\n", map_collisions,
+           expected_map_collisions);
+  }
+
+  if (error)
+    printf("##### linearNTreeTest() finished with ERRORS #####\n\n\n");
+  else
+    printf("linearNTreeTest() finished\n\n\n");
+  return !error;
+}
+
+bool loadBalancerTuningTest(voxel_count num_points)
+{
+  typedef NTree<BRANCHING_FACTOR, LEVEL_COUNT, InnerNode, LeafNode> NTREE;
+  using LoadBalancer::AutoTuner;
+  using LoadBalancer::TuningParameters;
+
+  bool error = false;
+  const std::string cache_file = "./load_balancer_tuning_test.cache";
+  std::remove(cache_file.c_str());
+
+  printf("\n\nloadBalancerTuningTest()\n");
+
+  // trees with about the same number of nodes share their parameters
+  if (AutoTuner::getShapeClass("intersect", 8, 15, 1000) != AutoTuner::getShapeClass("intersect", 8, 15, 1023)
+      || AutoTuner::getShapeClass("intersect", 8, 15, 1023) == AutoTuner::getShapeClass("intersect", 8, 15, 1024)
+      || AutoTuner::getShapeClass("intersect", 8, 15, 1000) == AutoTuner::getShapeClass("extract", 8, 15, 1000))
+  {
+    error = true;
+    printf("Error! Wrong shape classes.\n");
+  }
+
+  // the candidate with the smallest median wins, a single slow run of it doesn't matter
+  std::vector<TuningParameters> candidates;
+  candidates.push_back(TuningParameters(672, 0.5f));
+  candidates.push_back(TuningParameters(1344, 0.75f));
+  candidates.push_back(TuningParameters(2688, 0.5f));
+  const double times[3][3] = { { 5.0, 5.0, 5.0 }, { 4.0, 100.0, 4.0 }, { 6.0, 6.0, 6.0 } };
+  const std::string shape_class = AutoTuner::getShapeClass("test", 8, 15, 1000);
+  {
+    AutoTuner tuner(cache_file, 3);
+    tuner.setCandidates("test", candidates);
+    std::vector<uint32_t> trials(candidates.size(), 0);
+    for (uint32_t i = 0; i < candidates.size() * tuner.getNumTrials(); ++i)
+    {
+      bool measure = false;
+      const TuningParameters p = tuner.select("test", shape_class, TuningParameters(), measure);
+      const std::size_t c = std::find(candidates.begin(), candidates.end(), p) - candidates.begin();
+      if (!measure || c == candidates.size() || trials[c] >= tuner.getNumTrials())
+      {
+        error = true;
+        printf("Error! Unexpected selection %u, %f in run %u.\n", p.num_tasks, p.idle_threshold, i);
+        break;
+      }
+      tuner.addMeasurement(shape_class, p, times[c][trials[c]++]);
+    }
+
+    TuningParameters winner;
+    if (!tuner.getWinner(shape_class, winner) || !(winner == candidates[1]))
+    {
+      error = true;
+      printf("Error! Wrong winner after tuning.\n");
+    }
+  }
+
+  // overlapping runs get different candidates and the tuning only ends once each candidate was measured
+  {
+    AutoTuner tuner("", 1);
+    tuner.setCandidates("test", candidates);
+    std::vector<TuningParameters> selected;
+    for (uint32_t i = 0; i < candidates.size(); ++i)
+    {
+      bool measure = false;
+      selected.push_back(tuner.select("test", shape_class, TuningParameters(), measure));
+      if (!measure || std::find(selected.begin(), selected.end() - 1, selected.back()) != selected.end() - 1)
+      {
+        error = true;
+        printf("Error! Overlapping run %u got %u, %f.\n", i, selected.back().num_tasks, selected.back().idle_threshold);
+      }
+    }
+
+    TuningParameters winner;
+    for (uint32_t i = 0; i < candidates.size(); ++i)
+    {
+      tuner.addMeasurement(shape_class, selected[0], 5.0);
+    }
+    if (tuner.getWinner(shape_class, winner))
+    {
+      error = true;
+      printf("Error! Tuning finished before all candidates were measured.\n");
+    }
+    for (uint32_t i = 1; i < selected.size(); ++i)
+    {
+      tuner.addMeasurement(shape_class, selected[i], 3.0 + i);
+    }
+    if (!tuner.getWinner(shape_class, winner) || !(winner == selected[1]))
+    {
+      error = true;
+      printf("Error! Wrong winner after overlapping runs.\n");
+    }
+  }
+
+  // the winner is read from the cache and used without measuring
+  {
+    AutoTuner tuner(cache_file);
+    bool measure = true;
+    const TuningParameters p = tuner.select("test", shape_class, TuningParameters(), measure);
+    if (measure || tuner.getNumWinners() != 1 || p.num_tasks != candidates[1].num_tasks
+        || fabs(p.idle_threshold - candidates[1].idle_threshold) > 1e-5f)
+    {
+      error = true;
+      printf("Error! Winner not loaded from the cache.\n");
+    }
+  }
+  std::remove(cache_file.c_str());
+
+  // tuned intersections have to find the same collisions as the default ones
+  srand(TEST_RAND_SEED);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel = randomPoints(num_points, NUM_VOXEL);
+  thrust::host_vector<gpu_voxels::Vector3ui> hVoxel2 = randomPoints(num_points, NUM_VOXEL);
+  NTREE* o = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  o->build(hVoxel);
+  NTREE* o2 = new NTREE(NUM_BLOCKS, NUM_THREADS_PER_BLOCK);
+  o2->build(hVoxel2);
+  const OctreeVoxelID expected = o->intersect_load_balance(o2, 0, DefaultCollider(), false);
+
+  AutoTuner tuner("", 2);
+  std::vector<TuningParameters> intersect_candidates;
+  intersect_candidates.push_back(TuningParameters(64, 0.5f));
+  intersect_candidates.push_back(TuningParameters());
+  tuner.setCandidates("intersect", intersect_candidates);
+  o->setLoadBalancerTuner(&tuner);
+  for (uint32_t i = 0; i < intersect_candidates.size() * tuner.getNumTrials() + 1; ++i)
+  {
+    const OctreeVoxelID num_collisions = o->intersect_load_balance(o2, 0, DefaultCollider(), false);
+    if (num_collisions != expected)
+    {
+      error = true;
+      printf("Error! Tuned intersection %u found %lu instead of %lu collisions.\n", i, num_collisions, expected);
+      break;
+    }
+  }
+  if (tuner.getNumWinners() != 1)
+  {
+    error = true;
+    printf("Error! Intersection wasn't tuned.\n");
+  }
+  o->setLoadBalancerTuner(NULL);
+  delete o2;
+  delete o;
+
+  if (error)
+    printf("##### loadBalancerTuningTest() finished with ERRORS #####\n\n\n");
+  else
+    printf("loadBalancerTuningTest() finished\n\n\n");
+  return !error;
+}
+
 bool mortonTest(uint32_t num_runs)
 {
   //printf("\n\nmortonTest()\n");
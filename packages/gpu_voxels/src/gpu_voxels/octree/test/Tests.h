@@ -58,6 +58,26 @@ bool mortonTest(uint32_t num_runs);
 
 bool insertTest(OctreeVoxelID num_points, OctreeVoxelID num_inserts, bool set_free, bool propergate_up);
 
+/*
+ * Inserts cubes which are pruned right away and checks that their nodes are recycled.
+ */
+bool recycleTest(uint32_t num_cubes);
+
+/*
+ * Exports a tree as linear octree file and imports all of it and a half of it again.
+ */
+bool linearOctreeTest(voxel_count num_points);
+
+/*
+ * Compares the host linear NTree with the NTree and with brute force results.
+ */
+bool linearNTreeTest(voxel_count num_points);
+
+/*
+ * Checks the selection and cache of the load balancer tuning and that tuned intersections find the same collisions.
+ */
+bool loadBalancerTuningTest(voxel_count num_points);
+
 bool buildTest(std::vector<Vector3f>& points, uint32_t num_points, double & time, bool rebuildTest);
 
 //bool intersectionTest(OctreeVoxelID num_points, Intersection_Type insect_type, double & time);
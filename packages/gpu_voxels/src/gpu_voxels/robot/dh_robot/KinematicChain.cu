@@ -102,17 +102,19 @@ void KinematicChain::setConfiguration(const JointValueMap &jointmap)
   }
 
   Matrix4f transformation = gpu_voxels::Matrix4f::createIdentity();
+  // clouds without a link keep their points
+  m_link_transformations.assign(m_links_meta_cloud->getNumberOfPointclouds(), transformation);
 
-  // Iterate over all links and transform pointclouds with the according name
-  // if no pointcloud was found, still the transformation has to be calculated and copied to the device
+  // Iterate over all links and collect the transformations of the pointclouds with the according name
+  // if no pointcloud was found, still the transformation has to be calculated
   // for the next link.
   for(size_t i = 0; i < m_linknames.size(); i++)
   {
     std::string linkname = m_linknames[i];
     int16_t pc_num = m_links_meta_cloud->getCloudNumber(linkname);
     if(pc_num != -1)
-    {      
-      m_links_meta_cloud->transformSubCloud(pc_num, &transformation, m_transformed_links_meta_cloud);
+    {
+      m_link_transformations[pc_num] = transformation;
     }
     // Sending the actual transformation for this link to the GPU.
     // This means the DH Transformation i is not applied to link-pointcloud i,
@@ -122,7 +124,8 @@ void KinematicChain::setConfiguration(const JointValueMap &jointmap)
     //std::cout << "Trafo Matrix ["<< linkname <<"] = " << m_dh_transformation  << std::endl;
     //std::cout << "Accumulated Trafo Matrix ["<< linkname <<"] = " << transformation << std::endl;
   }
-  cudaDeviceSynchronize();
+  // transform all clouds at once
+  m_links_meta_cloud->transformSubClouds(m_link_transformations, m_transformed_links_meta_cloud);
 }
 
 
@@ -158,6 +158,8 @@ private:
   cudaEvent_t m_stop;
 
   Matrix4f m_dh_transformation;
+  //! One transformation per cloud, all clouds are transformed at once
+  std::vector<Matrix4f> m_link_transformations;
 };
 
 } // end of namespace
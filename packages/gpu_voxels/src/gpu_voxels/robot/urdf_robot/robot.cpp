@@ -57,9 +57,102 @@
 #include "gpu_voxels/robot/urdf_robot/robot.h"
 #include "gpu_voxels/logging/logging_robot.h"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+#include <urdf_model/link.h>
+#include <urdf_model/joint.h>
+
 namespace gpu_voxels {
 namespace robot {
 
+namespace {
+
+//! Number of configurations that computeLinkPosesBatch() processes together.
+const size_t cFK_BATCH_BLOCK_SIZE = 64;
+
+Matrix4f toMatrix4f(const KDL::Frame &frame)
+{
+  return Matrix4f(frame.M.data[0], frame.M.data[1], frame.M.data[2], frame.p.x(),
+                  frame.M.data[3], frame.M.data[4], frame.M.data[5], frame.p.y(),
+                  frame.M.data[6], frame.M.data[7], frame.M.data[8], frame.p.z(),
+                  0.0,             0.0,             0.0,             1.0);
+}
+
+//! Multiplies two rigid transformations, whose last rows are (0 0 0 1).
+inline Matrix4f multiplyRigid(const Matrix4f &a, const Matrix4f &b)
+{
+  return Matrix4f(a.a11 * b.a11 + a.a12 * b.a21 + a.a13 * b.a31,
+                  a.a11 * b.a12 + a.a12 * b.a22 + a.a13 * b.a32,
+                  a.a11 * b.a13 + a.a12 * b.a23 + a.a13 * b.a33,
+                  a.a11 * b.a14 + a.a12 * b.a24 + a.a13 * b.a34 + a.a14,
+                  a.a21 * b.a11 + a.a22 * b.a21 + a.a23 * b.a31,
+                  a.a21 * b.a12 + a.a22 * b.a22 + a.a23 * b.a32,
+                  a.a21 * b.a13 + a.a22 * b.a23 + a.a23 * b.a33,
+                  a.a21 * b.a14 + a.a22 * b.a24 + a.a23 * b.a34 + a.a24,
+                  a.a31 * b.a11 + a.a32 * b.a21 + a.a33 * b.a31,
+                  a.a31 * b.a12 + a.a32 * b.a22 + a.a33 * b.a32,
+                  a.a31 * b.a13 + a.a32 * b.a23 + a.a33 * b.a33,
+                  a.a31 * b.a14 + a.a32 * b.a24 + a.a33 * b.a34 + a.a34,
+                  0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+//! Pose of the link in the frame of its parent link for the value \a value of a revolute joint.
+inline Matrix4f revolutePose(const CompiledJoint &joint, const float value)
+{
+  // rotation about the joint axis (Rodrigues)
+  const float c = std::cos(value);
+  const float s = std::sin(value);
+  const float t = 1.0f - c;
+  const Vector3f &a = joint.axis;
+  const Matrix4f rotation(t * a.x * a.x + c,       t * a.x * a.y - s * a.z, t * a.x * a.z + s * a.y, 0.0f,
+                          t * a.x * a.y + s * a.z, t * a.y * a.y + c,       t * a.y * a.z - s * a.x, 0.0f,
+                          t * a.x * a.z - s * a.y, t * a.y * a.z + s * a.x, t * a.z * a.z + c,       0.0f,
+                          0.0f,                    0.0f,                    0.0f,                    1.0f);
+  return multiplyRigid(joint.origin, rotation);
+}
+
+//! Pose of the link in the frame of its parent link for the value \a value of a prismatic joint.
+inline Matrix4f prismaticPose(const CompiledJoint &joint, const float value)
+{
+  Matrix4f pose = joint.origin;
+  pose.a14 += value * (joint.origin.a11 * joint.axis.x + joint.origin.a12 * joint.axis.y + joint.origin.a13 * joint.axis.z);
+  pose.a24 += value * (joint.origin.a21 * joint.axis.x + joint.origin.a22 * joint.axis.y + joint.origin.a23 * joint.axis.z);
+  pose.a34 += value * (joint.origin.a31 * joint.axis.x + joint.origin.a32 * joint.axis.y + joint.origin.a33 * joint.axis.z);
+  return pose;
+}
+
+//! Pose of the link in the frame of its parent link for the joint value \a value.
+inline Matrix4f localPose(const CompiledJoint &joint, const float value)
+{
+  switch (joint.type)
+  {
+    case CompiledJoint::REVOLUTE:
+      return revolutePose(joint, value);
+    case CompiledJoint::PRISMATIC:
+      return prismaticPose(joint, value);
+    default:
+      return joint.origin;
+  }
+}
+
+//! Double precision version of localPose(), which calculates like KDL::Segment::pose().
+inline KDL::Frame localFrame(const CompiledJoint &joint, const double value)
+{
+  switch (joint.type)
+  {
+    case CompiledJoint::REVOLUTE:
+      return joint.kdl_origin * KDL::Frame(KDL::Rotation::Rot2(joint.kdl_axis, value));
+    case CompiledJoint::PRISMATIC:
+      return joint.kdl_origin * KDL::Frame(joint.kdl_axis * value);
+    default:
+      return joint.kdl_origin;
+  }
+}
+
+}
+
 Robot::Robot()
 {
   root_visual_node_    = new node;
@@ -93,6 +186,12 @@ void Robot::clear()
   links_.clear();
   joints_.clear();
 
+  compiled_joints_.clear();
+  compiled_link_names_.clear();
+  compiled_links_.clear();
+  compiled_parent_joints_.clear();
+  configuration_joints_.clear();
+
 }
 
 void Robot::load( const urdf::ModelInterface &urdf, const boost::filesystem::path &path_to_pointclouds,
@@ -146,6 +245,8 @@ void Robot::load( const urdf::ModelInterface &urdf, const boost::filesystem::pat
     }
   }
 
+  compileKinematics(urdf);
+
   link_pointclouds_.syncToDevice(); // after all links have been created, we sync them to the GPU
 
   // finally create a KDL representation of the kinematic tree:
@@ -161,6 +262,182 @@ void Robot::load( const urdf::ModelInterface &urdf, const boost::filesystem::pat
 
 }
 
+void Robot::compileKinematics(const urdf::ModelInterface &urdf)
+{
+  // the configuration vector holds the joints in the order of getJointNames()
+  std::map<std::string, int32_t> value_indices;
+  for (M_NameToJoint::const_iterator joint=joints_.begin(); joint != joints_.end(); joint++)
+  {
+    value_indices[joint->first] = configuration_joints_.size();
+    configuration_joints_.push_back(joint->second);
+  }
+
+  // a breadth first traversal visits the parents before their children
+  std::map<std::string, int32_t> link_indices;
+  std::deque<boost::shared_ptr<const urdf::Link> > open_links;
+  open_links.push_back(urdf.getRoot());
+  while (!open_links.empty())
+  {
+    const boost::shared_ptr<const urdf::Link> urdf_link = open_links.front();
+    open_links.pop_front();
+
+    CompiledJoint compiled;
+    compiled.parent = -1;
+    compiled.value_index = -1;
+    compiled.type = CompiledJoint::FIXED;
+    compiled.origin = Matrix4f::createIdentity();
+    compiled.axis = Vector3f(1.0f, 0.0f, 0.0f);
+    compiled.kdl_origin = KDL::Frame::Identity();
+    compiled.kdl_axis = KDL::Vector(1.0, 0.0, 0.0);
+    RobotJoint* parent_joint = NULL;
+
+    if (urdf_link != urdf.getRoot() && urdf_link->parent_joint)
+    {
+      const urdf::Joint &urdf_joint = *urdf_link->parent_joint;
+      const urdf::Pose &origin = urdf_joint.parent_to_joint_origin_transform;
+      compiled.parent = link_indices[urdf_joint.parent_link_name];
+      compiled.kdl_origin = KDL::Frame(KDL::Rotation::Quaternion(origin.rotation.x, origin.rotation.y,
+                                                                 origin.rotation.z, origin.rotation.w),
+                                       KDL::Vector(origin.position.x, origin.position.y, origin.position.z));
+      compiled.origin = toMatrix4f(compiled.kdl_origin);
+      compiled.kdl_axis = KDL::Vector(urdf_joint.axis.x, urdf_joint.axis.y, urdf_joint.axis.z);
+      compiled.kdl_axis.Normalize();
+      compiled.axis = Vector3f(compiled.kdl_axis.x(), compiled.kdl_axis.y(), compiled.kdl_axis.z());
+
+      switch (urdf_joint.type)
+      {
+        case urdf::Joint::REVOLUTE:
+        case urdf::Joint::CONTINUOUS:
+          compiled.type = CompiledJoint::REVOLUTE;
+          break;
+        case urdf::Joint::PRISMATIC:
+          compiled.type = CompiledJoint::PRISMATIC;
+          break;
+        default:
+          // like in the KDL tree, all other joints are fixed
+          compiled.type = CompiledJoint::FIXED;
+          break;
+      }
+      if (compiled.type != CompiledJoint::FIXED)
+      {
+        compiled.value_index = value_indices[urdf_joint.name];
+      }
+      parent_joint = getJoint(urdf_joint.name);
+    }
+
+    link_indices[urdf_link->name] = compiled_joints_.size();
+    compiled_joints_.push_back(compiled);
+    compiled_link_names_.push_back(urdf_link->name);
+    compiled_links_.push_back(getLink(urdf_link->name));
+    compiled_parent_joints_.push_back(parent_joint);
+
+    open_links.insert(open_links.end(), urdf_link->child_links.begin(), urdf_link->child_links.end());
+  }
+
+  LOGGING_DEBUG_C(RobotLog, Robot,
+                  "Compiled the kinematic tree of " << compiled_joints_.size() << " links and "
+                  << configuration_joints_.size() << " joints." << endl);
+}
+
+void Robot::computeLinkPoses(const std::vector<float> &joint_values, std::vector<Matrix4f> &link_poses) const
+{
+  if (joint_values.size() < configuration_joints_.size())
+  {
+    LOGGING_ERROR_C(RobotLog, Robot,
+                    "Expected " << configuration_joints_.size() << " joint values but got "
+                    << joint_values.size() << "!" << endl);
+    return;
+  }
+
+  const Matrix4f base = toMatrix4f(root_visual_node_->getPose());
+  link_poses.resize(compiled_joints_.size());
+  for (size_t i = 0; i < compiled_joints_.size(); i++)
+  {
+    const CompiledJoint &joint = compiled_joints_[i];
+    const float value = joint.value_index < 0 ? 0.0f : joint_values[joint.value_index];
+    link_poses[i] = multiplyRigid(joint.parent < 0 ? base : link_poses[joint.parent], localPose(joint, value));
+  }
+}
+
+void Robot::computeLinkPosesBatch(const std::vector<float> &joint_values, size_t num_configurations,
+                                  std::vector<Matrix4f> &link_poses) const
+{
+  const size_t num_joints = configuration_joints_.size();
+  const size_t num_links = compiled_joints_.size();
+  if (joint_values.size() < num_configurations * num_joints)
+  {
+    LOGGING_ERROR_C(RobotLog, Robot,
+                    "Expected " << num_configurations * num_joints << " joint values but got "
+                    << joint_values.size() << "!" << endl);
+    return;
+  }
+
+  const Matrix4f base = toMatrix4f(root_visual_node_->getPose());
+  link_poses.resize(num_configurations * num_links);
+  const int64_t num_blocks = (num_configurations + cFK_BATCH_BLOCK_SIZE - 1) / cFK_BATCH_BLOCK_SIZE;
+
+#pragma omp parallel for schedule(static)
+  for (int64_t block = 0; block < num_blocks; block++)
+  {
+    const size_t begin = block * cFK_BATCH_BLOCK_SIZE;
+    const size_t count = std::min(begin + cFK_BATCH_BLOCK_SIZE, num_configurations) - begin;
+    for (size_t i = 0; i < num_links; i++)
+    {
+      const CompiledJoint &joint = compiled_joints_[i];
+      // all configurations of the root link share the base pose
+      const Matrix4f *parent_poses = joint.parent < 0 ? &base : &link_poses[begin * num_links + joint.parent];
+      const size_t parent_stride = joint.parent < 0 ? 0 : num_links;
+      const float *values = joint.value_index < 0 ? NULL : &joint_values[begin * num_joints + joint.value_index];
+      Matrix4f *poses = &link_poses[begin * num_links + i];
+
+      // the joint type is the same for all configurations
+      switch (joint.type)
+      {
+        case CompiledJoint::REVOLUTE:
+          for (size_t c = 0; c < count; c++)
+          {
+            poses[c * num_links] = multiplyRigid(parent_poses[c * parent_stride], revolutePose(joint, values[c * num_joints]));
+          }
+          break;
+        case CompiledJoint::PRISMATIC:
+          for (size_t c = 0; c < count; c++)
+          {
+            poses[c * num_links] = multiplyRigid(parent_poses[c * parent_stride], prismaticPose(joint, values[c * num_joints]));
+          }
+          break;
+        default:
+          for (size_t c = 0; c < count; c++)
+          {
+            poses[c * num_links] = multiplyRigid(parent_poses[c * parent_stride], joint.origin);
+          }
+          break;
+      }
+    }
+  }
+}
+
+void Robot::updateLinkPoses()
+{
+  const KDL::Frame base = root_visual_node_->getPose();
+  link_frames_.resize(compiled_joints_.size());
+  for (size_t i = 0; i < compiled_joints_.size(); i++)
+  {
+    const CompiledJoint &joint = compiled_joints_[i];
+    const double value = joint.value_index < 0 ? 0.0 : configuration_joints_[joint.value_index]->getJointValue();
+    link_frames_[i] = (joint.parent < 0 ? base : link_frames_[joint.parent]) * localFrame(joint, value);
+
+    if (compiled_links_[i])
+    {
+      compiled_links_[i]->setPose(link_frames_[i]);
+    }
+    // joints are located at the origin of their parent link
+    if (compiled_parent_joints_[i])
+    {
+      compiled_parent_joints_[i]->setPose(link_frames_[joint.parent]);
+    }
+  }
+}
+
 RobotLink* Robot::getLink( const std::string& name )
 {
   M_NameToLink::iterator it = links_.find( name );
@@ -207,17 +484,6 @@ void Robot::getJointNames(std::vector<std::string> &jointnames)
 
 void Robot::setConfiguration(const JointValueMap &joint_values)
 {
-  // Reset all calculation flags.
-  for (M_NameToLink::const_iterator link=links_.begin(); link != links_.end(); link++)
-  {
-    link->second->resetPoseCalculated();
-  }
-
-  for (M_NameToJoint::const_iterator joint=joints_.begin(); joint != joints_.end(); joint++)
-  {
-    joint->second->resetPoseCalculated();
-  }
-
   for (JointValueMap::const_iterator joint=joint_values.begin(); joint != joint_values.end(); joint++)
   {
     RobotJoint* rob_joint = getJoint(joint->first);
@@ -229,6 +495,9 @@ void Robot::setConfiguration(const JointValueMap &joint_values)
                       "Joint " << joint->first << " not found and not updated." << endl);
     }
   }
+
+  // the compiled kinematic tree calculates all link poses in one pass
+  updateLinkPoses();
 }
 
 void Robot::getConfiguration(JointValueMap &jointmap)
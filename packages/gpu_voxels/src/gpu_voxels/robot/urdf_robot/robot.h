@@ -64,6 +64,7 @@
 #include "gpu_voxels/helpers/MetaPointCloud.h"
 #include <string>
 #include <map>
+#include <vector>
 #if __CUDACC_VER_MAJOR__ >= 9
 #undef __CUDACC_VER__
 #define __CUDACC_VER__ 90000
@@ -86,6 +87,29 @@ namespace robot {
 typedef std::map< std::string, RobotLink* > M_NameToLink;
 typedef std::map< std::string, RobotJoint* > M_NameToJoint;
 
+/**
+ * \struct CompiledJoint
+ * \brief One entry of the compiled kinematic tree: the joint that connects a link
+ * to its parent link, referenced by indices instead of names.
+ */
+struct CompiledJoint
+{
+  enum Type
+  {
+    FIXED,
+    REVOLUTE,
+    PRISMATIC
+  };
+
+  int32_t parent;      ///< Index of the parent link, -1 for the root link
+  int32_t value_index; ///< Index of the joint value in the configuration vector, -1 for fixed joints
+  Type type;
+  Matrix4f origin;     ///< Pose of the joint frame in the parent link frame
+  Vector3f axis;       ///< Normalized joint axis in the joint frame
+  KDL::Frame kdl_origin; ///< \a origin in double precision, used by setConfiguration()
+  KDL::Vector kdl_axis;  ///< \a axis in double precision, used by setConfiguration()
+};
+
 /**
  * \class Robot
  *
@@ -128,6 +152,35 @@ public:
    */
   void setConfiguration(const JointValueMap &joint_values);
 
+  /**
+   * @brief computeLinkPoses Evaluates the forward kinematics of the compiled kinematic tree in float
+   * precision. This neither changes the configuration nor the poses of the links.
+   * @param joint_values One value per joint, in the order of getJointNames()
+   * @param link_poses Receives the pose of every link, in the order of getCompiledLinkNames()
+   */
+  void computeLinkPoses(const std::vector<float> &joint_values, std::vector<Matrix4f> &link_poses) const;
+
+  /**
+   * @brief computeLinkPosesBatch Evaluates the forward kinematics of many configurations at once.
+   * The configurations are processed in blocks by all host threads. Within a block the joints are
+   * the outer loop and the joint type is dispatched once per joint, so the inner loop over the
+   * configurations applies the same transformation to all of them. The poses of a configuration
+   * are stored next to each other, so the gain comes from the threads, not from vectorization.
+   * @param joint_values The values of \a num_configurations configurations, one after another,
+   * each in the order of getJointNames()
+   * @param num_configurations Number of configurations
+   * @param link_poses Receives the link poses of all configurations, one configuration after another,
+   * each in the order of getCompiledLinkNames()
+   */
+  void computeLinkPosesBatch(const std::vector<float> &joint_values, size_t num_configurations,
+                             std::vector<Matrix4f> &link_poses) const;
+
+  /**
+   * @brief getCompiledLinkNames
+   * @return The names of the links in the order of the compiled kinematic tree, parents before children.
+   */
+  const std::vector<std::string>& getCompiledLinkNames() const { return compiled_link_names_; }
+
   /**
    * @brief getConfiguration Gets the robot configuration
    * @param joint_values Map of jointnames and values.
@@ -208,6 +261,26 @@ protected:
   node* root_other_node_;
 
   std::string name_;
+
+private:
+  /**
+   * \brief Compiles the kinematic tree of \a urdf into compiled_joints_, parents before children.
+   */
+  void compileKinematics(const urdf::ModelInterface &urdf);
+
+  /**
+   * \brief Computes the poses of all links with the compiled kinematic tree in double precision,
+   * like KDL, and stores them in the links and joints, so that they do not have to be calculated
+   * recursively.
+   */
+  void updateLinkPoses();
+
+  std::vector<CompiledJoint> compiled_joints_;     ///< One entry per link, parents before children.
+  std::vector<std::string> compiled_link_names_;   ///< Link names in the order of compiled_joints_.
+  std::vector<RobotLink*> compiled_links_;         ///< Links in the order of compiled_joints_.
+  std::vector<RobotJoint*> compiled_parent_joints_; ///< Parent joints in the order of compiled_joints_, NULL for the root link.
+  std::vector<RobotJoint*> configuration_joints_;  ///< Joints in the order of the configuration vector.
+  std::vector<KDL::Frame> link_frames_;           ///< Buffer of updateLinkPoses()
 };
 
 } // namespace robot
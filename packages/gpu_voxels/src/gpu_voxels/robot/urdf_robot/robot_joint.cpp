@@ -124,6 +124,7 @@ void RobotJoint::setJointValue(float joint_value)
 void RobotJoint::setPose(const KDL::Frame &parent_link_pose)
 {
   pose_property_ = parent_link_pose;
+  pose_calculated_ = true;
 }
 
 /*!
@@ -120,6 +120,8 @@ public:
 
   bool hasGeometry() const;
 
+  //! Sets the pose of the link, which is then not calculated recursively by getPose()
+  void setPose(const KDL::Frame& pose) { pose_property_ = pose; pose_calculated_ = true; }
   void resetPoseCalculated() { pose_calculated_ = false; }
   bool poseCalculated() { return pose_calculated_; }
 
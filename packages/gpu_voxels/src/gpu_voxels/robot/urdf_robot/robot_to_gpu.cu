@@ -54,6 +54,14 @@ RobotToGPU::RobotToGPU(const float voxel_side_length, const std::string &_path,
   // allocate a copy of the pointcloud, which will hold the transformed version
   m_link_pointclouds_transformed = new MetaPointCloud(*Robot::getLinkPointclouds());
 
+  // look up the links of the clouds once, instead of on every new configuration
+  const MetaPointCloud* link_pointclouds = Robot::getLinkPointclouds();
+  m_cloud_links.resize(link_pointclouds->getNumberOfPointclouds());
+  m_link_transformations.resize(link_pointclouds->getNumberOfPointclouds());
+  for (uint16_t i = 0; i < link_pointclouds->getNumberOfPointclouds(); i++)
+  {
+    m_cloud_links[i] = Robot::getLink(link_pointclouds->getCloudName(i));
+  }
 }
 
 RobotToGPU::~RobotToGPU()
@@ -72,18 +80,14 @@ void RobotToGPU::setConfiguration(const JointValueMap &jointmap)
   Robot::setConfiguration(jointmap);
 
 
-  // iterate over all joints that own a pointcloud.
-  for(uint16_t i = 0; i < Robot::getLinkPointclouds()->getNumberOfPointclouds(); i++)
+  // collect the trafos of all URDF links that own a pointcloud.
+  for(size_t i = 0; i < m_cloud_links.size(); i++)
   {
-    // get the trafo of the according URDF link
-    m_transformation = Robot::getLink( Robot::getLinkPointclouds()->getCloudName(i) )->getPoseAsGpuMat4f();
-
-//    std::cout << "RobotToGPU::update() transform of " << Robot::getLinkPointclouds()->getCloudName(i)
-//              << " = " << m_transformation << std::endl;
-
-    Robot::getLinkPointclouds()->transformSubCloud(i, &m_transformation, m_link_pointclouds_transformed);
-
+    m_link_transformations[i] = m_cloud_links[i]->getPoseAsGpuMat4f();
   }
+
+  // and transform all clouds at once.
+  Robot::getLinkPointclouds()->transformSubClouds(m_link_transformations, m_link_pointclouds_transformed);
 }
 
 const MetaPointCloud* RobotToGPU::getTransformedClouds()
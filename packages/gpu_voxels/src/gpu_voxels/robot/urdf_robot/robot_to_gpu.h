@@ -45,7 +45,8 @@ public:
 
   /**
    * @brief Updates the robot with new joint angles
-   * and triggers the transformation kernel.
+   * and triggers the transformation kernel, which
+   * transforms the clouds of all links in one pass.
    * @param jointmap Map of jointnames and values
    */
   void setConfiguration(const JointValueMap &jointmap);
@@ -66,7 +67,10 @@ public:
 
 private:
   MetaPointCloud* m_link_pointclouds_transformed;
-  Matrix4f m_transformation;
+  //! The links that own the clouds, in the order of the clouds
+  std::vector<RobotLink*> m_cloud_links;
+  //! One transformation per cloud, all clouds are transformed at once
+  std::vector<Matrix4f> m_link_transformations;
 };
 
 } // namespace robot
@@ -33,6 +33,34 @@ using namespace gpu_voxels;
 using boost::shared_ptr;
 typedef boost::shared_ptr<voxelmap::DistanceVoxelMap> DistMapSharedPtr;
 
+namespace {
+
+//! Appends \a obstacle to \a obstacles unless its voxel is occupied already
+bool addUniqueObstacle(const Vector3ui& obstacle, int dim, std::vector<bool>& occupied, std::vector<Vector3ui>& obstacles)
+{
+  const size_t index = obstacle.x + dim * (obstacle.y + dim * obstacle.z);
+  if (occupied[index])
+  {
+    return false;
+  }
+  occupied[index] = true;
+  obstacles.push_back(obstacle);
+  return true;
+}
+
+//! Metric centers of the voxels with side length 1
+std::vector<Vector3f> voxelCenters(const std::vector<Vector3ui>& voxels)
+{
+  std::vector<Vector3f> points;
+  for (size_t i = 0; i < voxels.size(); ++i)
+  {
+    points.push_back(Vector3f(voxels[i].x + 0.5, voxels[i].y + 0.5, voxels[i].z + 0.5));
+  }
+  return points;
+}
+
+}
+
 BOOST_FIXTURE_TEST_SUITE(distance, ArgsFixture)
 
 BOOST_AUTO_TEST_CASE(distance_correctness)
@@ -127,6 +155,225 @@ BOOST_AUTO_TEST_CASE(distance_correctness)
 
 
 
+//! Batched queries deliver the single voxel distances, the device and the host mirror agree.
+BOOST_AUTO_TEST_CASE(distance_batch_queries)
+{
+  float side_length = 1.f;
+  int dim = 64;
+  voxelmap::DistanceVoxelMap dist_map(Vector3ui(dim, dim, dim), side_length, MT_DISTANCE_VOXELMAP);
+
+  std::vector<Vector3f> obstacles(1, Vector3f(10.5, 20.5, 30.5));
+  dist_map.insertPointCloud(obstacles, eBVM_OCCUPIED);
+  dist_map.parallelBanding3D();
+
+  // voxel centers, random points and points outside of the map
+  std::vector<Vector3f> points;
+  for (int i = 0; i < 1000; ++i)
+  {
+    points.push_back(Vector3f(rand() % dim + 0.5, rand() % dim + 0.5, rand() % dim + 0.5));
+    points.push_back(Vector3f(dim * (rand() / (RAND_MAX + 1.0)), dim * (rand() / (RAND_MAX + 1.0)),
+                              dim * (rand() / (RAND_MAX + 1.0))));
+  }
+  points.push_back(Vector3f(-3.0, 20.5, 30.5));
+  points.push_back(Vector3f(dim + 3.0, dim + 3.0, dim + 3.0));
+
+  std::vector<float> distances, host_distances;
+  std::vector<float> interpolated, host_interpolated;
+  std::vector<Vector3f> gradients, host_gradients;
+  dist_map.queryObstacleDistances(points, &distances, &interpolated, &gradients);
+  dist_map.queryObstacleDistancesOnHost(points, &host_distances, &host_interpolated, &host_gradients);
+  BOOST_REQUIRE(distances.size() == points.size() && interpolated.size() == points.size()
+                && gradients.size() == points.size());
+
+  bool single_equal = true;
+  bool host_equal = host_distances.size() == distances.size();
+  bool centers_equal = true;
+  bool gradients_valid = true;
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    const Vector3ui voxel(std::min(std::max(int(floor(points[i].x)), 0), dim - 1),
+                          std::min(std::max(int(floor(points[i].y)), 0), dim - 1),
+                          std::min(std::max(int(floor(points[i].z)), 0), dim - 1));
+    single_equal = single_equal && fabs(distances[i] - sqrt(float(dist_map.getSquaredObstacleDistance(voxel)))) < 1e-4;
+    host_equal = host_equal && fabs(host_distances[i] - distances[i]) < 1e-4
+        && fabs(host_interpolated[i] - interpolated[i]) < 1e-4
+        && fabs(host_gradients[i].x - gradients[i].x) < 1e-4 && fabs(host_gradients[i].y - gradients[i].y) < 1e-4
+        && fabs(host_gradients[i].z - gradients[i].z) < 1e-4;
+    if (i % 2 == 0 && i < 2000)
+    {
+      // at the voxel centers the interpolation hits the voxel distance
+      centers_equal = centers_equal && fabs(interpolated[i] - distances[i]) < 1e-4;
+      // the gradient points away from the obstacle
+      const Vector3f direction = points[i] - obstacles[0];
+      gradients_valid = gradients_valid
+          && direction.x * gradients[i].x + direction.y * gradients[i].y + direction.z * gradients[i].z >= 0.0;
+    }
+  }
+  BOOST_CHECK_MESSAGE(single_equal, "Batched distances match the single voxel queries.");
+  BOOST_CHECK_MESSAGE(host_equal, "Host mirror results match the device results.");
+  BOOST_CHECK_MESSAGE(centers_equal, "Interpolated distances at voxel centers match the voxel distances.");
+  BOOST_CHECK_MESSAGE(gradients_valid, "Gradients point away from the obstacle.");
+  BOOST_CHECK_MESSAGE(distances[points.size() - 2] == 10.0, "Points outside of the map are clamped to the border.");
+}
+
+//! Incremental updates of the distance field deliver the distances of a recomputation.
+BOOST_AUTO_TEST_CASE(distance_incremental_update)
+{
+  float side_length = 1.f;
+  int dim = 64;
+  DistMapSharedPtr incremental_map(new voxelmap::DistanceVoxelMap(Vector3ui(dim, dim, dim), side_length, MT_DISTANCE_VOXELMAP));
+  voxelmap::DistanceVoxelMap exact_map(Vector3ui(dim, dim, dim), side_length, MT_DISTANCE_VOXELMAP);
+
+  // every voxel is listed once, so a removal really frees the voxel
+  srand(1);
+  std::vector<bool> occupied(dim * dim * dim, false);
+  std::vector<Vector3ui> obstacles;
+  while (obstacles.size() < 200)
+  {
+    addUniqueObstacle(Vector3ui(rand() % dim, rand() % dim, rand() % dim), dim, occupied, obstacles);
+  }
+  const size_t num_random_obstacles = obstacles.size();
+  // a wall, whose removal changes the distances of a large region
+  for (int y = 0; y < dim / 2; ++y)
+  {
+    for (int z = 0; z < dim / 2; ++z)
+    {
+      addUniqueObstacle(Vector3ui(dim / 2, y, z), dim, occupied, obstacles);
+    }
+  }
+
+  std::vector<Vector3f> points;
+  for (size_t i = 0; i < obstacles.size(); ++i)
+  {
+    points.push_back(Vector3f(obstacles[i].x + 0.5, obstacles[i].y + 0.5, obstacles[i].z + 0.5));
+  }
+  incremental_map->insertPointCloud(points, eBVM_OCCUPIED);
+  incremental_map->parallelBanding3D();
+
+  for (int update = 0; update < 3; ++update)
+  {
+    std::vector<Vector3ui> removed;
+    std::vector<Vector3ui> added;
+    if (update == 1)
+    {
+      for (size_t i = num_random_obstacles; i < obstacles.size(); ++i)
+      {
+        removed.push_back(obstacles[i]);
+      }
+      obstacles.resize(num_random_obstacles);
+    }
+    for (int i = 0; i < 20; ++i)
+    {
+      const size_t index = rand() % obstacles.size();
+      removed.push_back(obstacles[index]);
+      obstacles.erase(obstacles.begin() + index);
+    }
+    for (size_t i = 0; i < removed.size(); ++i)
+    {
+      occupied[removed[i].x + dim * (removed[i].y + dim * removed[i].z)] = false;
+    }
+    while (added.size() < 20)
+    {
+      if (addUniqueObstacle(Vector3ui(rand() % dim, rand() % dim, rand() % dim), dim, occupied, obstacles))
+      {
+        added.push_back(obstacles.back());
+      }
+    }
+    incremental_map->updateDistances(added, removed);
+
+    points.clear();
+    for (size_t i = 0; i < obstacles.size(); ++i)
+    {
+      points.push_back(Vector3f(obstacles[i].x + 0.5, obstacles[i].y + 0.5, obstacles[i].z + 0.5));
+    }
+    exact_map.clearMap();
+    exact_map.insertPointCloud(points, eBVM_OCCUPIED);
+    exact_map.exactDistances3D(points);
+
+    DistanceVoxel::accumulated_diff diff_result = exact_map.differences3D(incremental_map, false);
+    BOOST_CHECK_MESSAGE(diff_result.maxerr < 1.0, "Incremental update matches the exact distances.");
+    if (!(diff_result.maxerr < 1.0))
+    {
+      std::cout << diff_result.str() << std::endl;
+    }
+  }
+}
+
+//! Incremental updates notice that the map was rewritten by other operations since the last update.
+BOOST_AUTO_TEST_CASE(distance_incremental_update_after_rewrite)
+{
+  float side_length = 1.f;
+  int dim = 64;
+  DistMapSharedPtr incremental_map(new voxelmap::DistanceVoxelMap(Vector3ui(dim, dim, dim), side_length, MT_DISTANCE_VOXELMAP));
+  voxelmap::DistanceVoxelMap exact_map(Vector3ui(dim, dim, dim), side_length, MT_DISTANCE_VOXELMAP);
+
+  std::vector<Vector3ui> obstacles;
+  obstacles.push_back(Vector3ui(0, 0, 0));
+  std::vector<Vector3f> points = voxelCenters(obstacles);
+  incremental_map->insertPointCloud(points, eBVM_OCCUPIED);
+  incremental_map->parallelBanding3D();
+
+  // downloads the host mirror
+  std::vector<Vector3ui> added(1, Vector3ui(10, 10, 10));
+  incremental_map->updateDistances(added, std::vector<Vector3ui>());
+  obstacles.push_back(added[0]);
+
+  // an obstacle that only reaches the device voxels
+  obstacles.push_back(Vector3ui(40, 40, 40));
+  points = voxelCenters(obstacles);
+  incremental_map->clearMap();
+  incremental_map->insertPointCloud(points, eBVM_OCCUPIED);
+  incremental_map->parallelBanding3D();
+
+  std::vector<Vector3f> query(1, points.back());
+  std::vector<float> distances;
+  incremental_map->queryObstacleDistancesOnHost(query, &distances);
+  BOOST_CHECK_MESSAGE(distances[0] == 0.f, "Host queries see the rewritten map.");
+
+  // would claim the voxels around the device only obstacle with an outdated mirror
+  added[0] = Vector3ui(44, 40, 40);
+  incremental_map->updateDistances(added, std::vector<Vector3ui>());
+  obstacles.push_back(added[0]);
+
+  points = voxelCenters(obstacles);
+  exact_map.insertPointCloud(points, eBVM_OCCUPIED);
+  exact_map.exactDistances3D(points);
+
+  DistanceVoxel::accumulated_diff diff_result = exact_map.differences3D(incremental_map, false);
+  BOOST_CHECK_MESSAGE(diff_result.maxerr < 1.0, "Incremental update after a rewrite matches the exact distances.");
+  if (!(diff_result.maxerr < 1.0))
+  {
+    std::cout << diff_result.str() << std::endl;
+  }
+}
+
+//! Obstacle coordinates up to the largest supported map dimension survive the encoding.
+BOOST_AUTO_TEST_CASE(distance_voxel_encoding)
+{
+  const uint32_t max_coord = uint32_t(PBA_UNINITIALISED_COORD) - 1;
+  BOOST_CHECK_MESSAGE(sizeof(DistanceVoxel) == sizeof(DistanceVoxel::pba_voxel_t), "Voxel holds only the obstacle.");
+
+  const Vector3ui coords[] = { Vector3ui(0, 0, 0), Vector3ui(max_coord, 0, 0), Vector3ui(0, max_coord, 0),
+                               Vector3ui(0, 0, max_coord), Vector3ui(max_coord, max_coord, max_coord),
+                               Vector3ui(max_coord / 3, max_coord / 2, max_coord - 1) };
+  for (size_t i = 0; i < sizeof(coords) / sizeof(coords[0]); ++i)
+  {
+    const Vector3ui obstacle = DistanceVoxel(coords[i]).getObstacle();
+    BOOST_CHECK_MESSAGE(obstacle.x == coords[i].x && obstacle.y == coords[i].y && obstacle.z == coords[i].z,
+                        "Obstacle coordinates survive the encoding.");
+    BOOST_CHECK_MESSAGE(DistanceVoxel(coords[i]).squaredObstacleDistance(Vector3i(coords[i])) == PBA_OBSTACLE_DISTANCE,
+                        "Obstacles have distance zero.");
+  }
+
+  DistanceVoxel uninitialised;
+  uninitialised.setPBAUninitialised();
+  BOOST_CHECK_MESSAGE(uninitialised.getObstacle().x == uint32_t(PBA_UNINITIALISED_COORD)
+                      && uninitialised.getObstacle().z == uint32_t(PBA_UNINITIALISED_COORD),
+                      "Uninitialised voxels are marked.");
+  BOOST_CHECK_MESSAGE(uninitialised.squaredObstacleDistance(Vector3i(1, 2, 3)) == MAX_OBSTACLE_DISTANCE,
+                      "Uninitialised voxels have no obstacle.");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -22,13 +22,30 @@
 //----------------------------------------------------------------------
 
 #include <gpu_voxels/octree/test/Tests.h>
+#include <gpu_voxels/octree/GvlNTree.h>
 #include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/helpers/FreeSpaceRayCaster.h>
 #include "gpu_voxels/helpers/PointcloudFileHandler.h"
 #include <gpu_voxels/test/testing_fixtures.hpp>
 #include <boost/test/unit_test.hpp>
+#include <thrust/sort.h>
 
 using namespace gpu_voxels;
 
+namespace {
+
+typedef NTree::Environment::LeafNodeProb LeafNodeProb;
+
+//! Delivers the data of the node holding \a voxel, inner nodes are converted to leaf nodes
+LeafNodeProb findNode(NTree::NTreeProb& tree, const Vector3ui& voxel)
+{
+  thrust::host_vector<Vector3ui> h_voxel(1, voxel);
+  thrust::host_vector<NTree::FindResult<LeafNodeProb> > result(1);
+  tree.find(h_voxel, result);
+  return result[0].m_node_data;
+}
+
+}
 
 
 BOOST_FIXTURE_TEST_SUITE(octree_selftest, ArgsFixture)
@@ -64,6 +81,138 @@ BOOST_AUTO_TEST_CASE(insert_voxels)
 
 
 
+BOOST_AUTO_TEST_CASE(recycle_pruned_nodes)
+{
+  PERF_MON_START("recycle_pruned_nodes");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    BOOST_CHECK_MESSAGE(NTree::Test::recycleTest(20), "Recycle nodes of pruned subtrees");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("recycle_pruned_nodes", "recycle_pruned_nodes", "octree_selftest");
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(linear_octree_export_import)
+{
+  PERF_MON_START("linear_octree_export_import");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    BOOST_CHECK_MESSAGE(NTree::Test::linearOctreeTest(16541), "Export and import of linear octree files");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("linear_octree_export_import", "linear_octree_export_import", "octree_selftest");
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(linear_ntree_on_host)
+{
+  PERF_MON_START("linear_ntree_on_host");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    BOOST_CHECK_MESSAGE(NTree::Test::linearNTreeTest(16541), "Host linear NTree");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("linear_ntree_on_host", "linear_ntree_on_host", "octree_selftest");
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(load_balancer_tuning)
+{
+  PERF_MON_START("load_balancer_tuning");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    BOOST_CHECK_MESSAGE(NTree::Test::loadBalancerTuningTest(16541), "Load balancer tuning");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("load_balancer_tuning", "load_balancer_tuning", "octree_selftest");
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(insert_unique_voxel)
+{
+  PERF_MON_START("insert_unique_voxel");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    NTree::NTreeProb tree(NUM_BLOCKS, NUM_THREADS_PER_BLOCK, 10);
+
+    const Vector3ui free_voxel(100, 200, 300);
+    const Vector3ui free_voxel2(101, 200, 300);
+    const Vector3ui occupied_voxel(102, 200, 300);
+    thrust::host_vector<NTree::Voxel> h_free_space_voxel;
+    h_free_space_voxel.push_back(
+        NTree::Voxel(NTree::morton_code60(free_voxel), free_voxel, FREE_UPDATE_PROBABILITY));
+    h_free_space_voxel.push_back(
+        NTree::Voxel(NTree::morton_code60(free_voxel2), free_voxel2, FREE_UPDATE_PROBABILITY));
+    // the voxels have to be sorted by their Morton code
+    thrust::sort(h_free_space_voxel.begin(), h_free_space_voxel.end());
+    thrust::host_vector<NTree::Voxel> h_object_voxel(
+        1, NTree::Voxel(NTree::morton_code60(occupied_voxel), occupied_voxel, OCCUPIED_UPDATE_PROBABILITY));
+    thrust::device_vector<NTree::Voxel> d_free_space_voxel = h_free_space_voxel;
+    thrust::device_vector<NTree::Voxel> d_object_voxel = h_object_voxel;
+    tree.insertUniqueVoxel(d_free_space_voxel, d_object_voxel);
+
+    BOOST_CHECK_MESSAGE(findNode(tree, free_voxel).isFree(), "Free voxel is free.");
+    BOOST_CHECK_MESSAGE(findNode(tree, free_voxel2).isFree(), "Second free voxel is free.");
+    BOOST_CHECK_MESSAGE(findNode(tree, occupied_voxel).isOccupied(), "Occupied voxel is occupied.");
+    BOOST_CHECK_MESSAGE(findNode(tree, Vector3ui(103, 200, 300)).isUnknown(), "Other voxels stay unknown.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("insert_unique_voxel", "insert_unique_voxel", "octree_selftest");
+  }
+}
+
+
+//! The ray caster covers a small volume far from the origin of the tree, whose linear indices exceed 32 bit.
+BOOST_AUTO_TEST_CASE(insert_ray_caster_results)
+{
+  PERF_MON_START("insert_ray_caster_results");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    const float side_length = 0.01f;
+    const Vector3ui offset(5000, 9000, 12000);
+    const Vector3f origin = Vector3f(offset.x + 2.5f, offset.y + 16.5f, offset.z + 16.5f) * side_length;
+    std::vector<Vector3f> points;
+    points.push_back(Vector3f(offset.x + 40.5f, offset.y + 16.5f, offset.z + 16.5f) * side_length);
+    points.push_back(Vector3f(offset.x + 40.5f, offset.y + 20.5f, offset.z + 16.5f) * side_length);
+
+    // two sensors at the same position see the same points, each voxel has to be updated once anyway
+    FreeSpaceRayCaster single_ray_caster(Vector3ui(64, 32, 32), side_length, 0.0f, offset);
+    single_ray_caster.addRays(origin, &points[0], points.size());
+    single_ray_caster.castRays();
+    FreeSpaceRayCaster ray_caster(Vector3ui(64, 32, 32), side_length, 0.0f, offset);
+    ray_caster.addRays(origin, &points[0], points.size());
+    ray_caster.addRays(origin, &points[0], points.size());
+    ray_caster.castRays();
+    BOOST_CHECK_MESSAGE(ray_caster.getOccupiedVoxels().size() == 2, "End points are occupied.");
+
+    NTree::GvlNTreeProb single_tree(side_length, MT_PROBAB_OCTREE);
+    single_tree.insertRayCasterResults(single_ray_caster);
+    NTree::GvlNTreeProb tree(side_length, MT_PROBAB_OCTREE);
+    tree.insertRayCasterResults(ray_caster);
+
+    const Vector3ui end_point(offset.x + 40, offset.y + 16, offset.z + 16);
+    const Vector3ui in_front(offset.x + 39, offset.y + 16, offset.z + 16);
+    BOOST_CHECK_MESSAGE(findNode(tree, end_point).isOccupied(), "End points are occupied.");
+    BOOST_CHECK_MESSAGE(findNode(tree, Vector3ui(offset.x + 2, offset.y + 16, offset.z + 16)).isFree(),
+                        "The origin is free.");
+    BOOST_CHECK_MESSAGE(findNode(tree, in_front).isFree(), "Voxels in front of the end points are free.");
+    BOOST_CHECK_MESSAGE(findNode(tree, Vector3ui(offset.x + 41, offset.y + 16, offset.z + 16)).isUnknown(),
+                        "Voxels behind the end points are unknown.");
+    BOOST_CHECK_MESSAGE(findNode(tree, Vector3ui(39, 16, 16)).isUnknown(),
+                        "Voxels are inserted at the tree coordinates, not at the ones of the volume.");
+    BOOST_CHECK_MESSAGE(findNode(tree, in_front).getOccupancy() == findNode(single_tree, in_front).getOccupancy()
+                        && findNode(tree, end_point).getOccupancy() == findNode(single_tree, end_point).getOccupancy(),
+                        "Voxels touched by several rays are updated once.");
+
+    // volumes reaching out of the tree are rejected
+    const Vector3ui tree_dim = tree.getDimensions();
+    FreeSpaceRayCaster outside_ray_caster(Vector3ui(64, 32, 32), side_length, 0.0f,
+                                          Vector3ui(tree_dim.x - 32, 0, 0));
+    outside_ray_caster.addRays(Vector3f(tree_dim.x - 16.5f, 16.5f, 16.5f) * side_length, &points[0], 1);
+    outside_ray_caster.castRays();
+    tree.insertRayCasterResults(outside_ray_caster);
+    BOOST_CHECK_MESSAGE(findNode(tree, Vector3ui(tree_dim.x - 17, 16, 16)).isUnknown(),
+                        "Ray caster reaching out of the tree is ignored.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("insert_ray_caster_results", "insert_ray_caster_results", "octree_selftest");
+  }
+}
+
+
 BOOST_AUTO_TEST_CASE(build_and_rebuild)
 {
   PERF_MON_START("build_and_rebuild");
@@ -23,11 +23,58 @@
 //----------------------------------------------------------------------
 #include <gpu_voxels/helpers/MetaPointCloud.h>
 #include <gpu_voxels/helpers/PointCloud.h>
+#include <gpu_voxels/helpers/BinvoxFileReader.h>
+#include <gpu_voxels/helpers/XyzFileReader.h>
+#include <gpu_voxels/helpers/MappedBinvoxFileReader.h>
+#include <gpu_voxels/helpers/MappedPcdFileReader.h>
+#include <gpu_voxels/helpers/MappedXyzFileReader.h>
 #include <gpu_voxels/test/testing_fixtures.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+
 using namespace gpu_voxels;
 
+namespace {
+
+bool equalPoints(const std::vector<Vector3f>& a, const std::vector<Vector3f>& b)
+{
+  if (a.size() != b.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void writePcdHeader(std::ofstream& file, const std::string& fields, const std::string& sizes,
+                    const std::string& types, const size_t num_points, const std::string& data)
+{
+  // every field holds a single element
+  std::istringstream field_stream(fields);
+  std::string field;
+  std::string counts;
+  while (field_stream >> field)
+  {
+    counts += counts.empty() ? "1" : " 1";
+  }
+
+  file << "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS " << fields << "\nSIZE " << sizes
+       << "\nTYPE " << types << "\nCOUNT " << counts << "\nWIDTH " << num_points << "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS "
+       << num_points << "\nDATA " << data << "\n";
+}
+
+}
 
 
 BOOST_FIXTURE_TEST_SUITE(pointclouds, ArgsFixture)
@@ -77,6 +124,106 @@ BOOST_AUTO_TEST_CASE(meta_pointcloud_equality)
   }
 }
 
+BOOST_AUTO_TEST_CASE(meta_pointcloud_transform_subclouds)
+{
+  PERF_MON_START("meta_pointcloud_transform_subclouds");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    // clouds of different sizes, including an empty one
+    MetaPointCloud orig;
+    std::vector<Matrix4f> transformations;
+    for(size_t c = 0; c < 12; c++)
+    {
+      std::vector<Vector3f> testdata;
+      for(size_t j = 0; j < (c == 5 ? 0 : 100 * c + 17); j++)
+      {
+        testdata.push_back(Vector3f(j * 0.01f, c * 0.1f, 1.0f / (j + 1)));
+      }
+      orig.addCloud(testdata);
+      transformations.push_back(gpu_voxels::Matrix4f::createFromRotationAndTranslation(
+          gpu_voxels::Matrix3f::createFromRPY(Vector3f(0.1f * c, 0.2f, -0.3f * c)), Vector3f(0.5f * c, 1.1f, -2.0f)));
+    }
+    orig.syncToDevice();
+
+    MetaPointCloud single(orig);
+    MetaPointCloud fused(orig);
+    MetaPointCloud host(orig);
+    for(uint16_t c = 0; c < orig.getNumberOfPointclouds(); c++)
+    {
+      orig.transformSubCloud(c, &transformations[c], &single);
+    }
+    orig.transformSubClouds(transformations, &fused);
+    orig.transformSubCloudsOnHost(transformations, &host);
+    single.syncToHost();
+    fused.syncToHost();
+
+    BOOST_CHECK_MESSAGE(fused == host, "Device and host transformations are equal.");
+    bool close = true;
+    for(uint16_t c = 0; c < orig.getNumberOfPointclouds(); c++)
+    {
+      for(uint32_t j = 0; j < orig.getPointcloudSize(c); j++)
+      {
+        Vector3f diff = fused.getPointCloud(c)[j];
+        diff -= single.getPointCloud(c)[j];
+        close &= fabs(diff.x) < 1e-5f && fabs(diff.y) < 1e-5f && fabs(diff.z) < 1e-5f;
+      }
+    }
+    BOOST_CHECK_MESSAGE(close, "Fused transformation equals the transformation of the single clouds.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("meta_pointcloud_transform_subclouds", "meta_pointcloud_transform_subclouds", "pointclouds");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(meta_pointcloud_async_upload)
+{
+  PERF_MON_START("meta_pointcloud_async_upload");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    std::vector<std::vector<Vector3f> > clouds(6);
+    for(size_t c = 0; c < clouds.size(); c++)
+    {
+      for(size_t j = 0; j < 50 * c + 13; j++)
+      {
+        clouds[c].push_back(Vector3f(j * 0.01f, c * 0.1f, 1.0f / (j + 1)));
+      }
+    }
+    MetaPointCloud sync_cloud(clouds);
+    MetaPointCloud async_cloud(clouds);
+    async_cloud.setUploadMode(MPU_ASYNC);
+
+    // more updates than staging buffers, the last one changes the size of a cloud
+    for(size_t u = 0; u < 5; u++)
+    {
+      const uint16_t c = u % clouds.size();
+      for(size_t j = 0; j < clouds[c].size(); j++)
+      {
+        clouds[c][j].z += 0.5f;
+      }
+      if(u == 4)
+      {
+        clouds[c].push_back(Vector3f(1.0f, 2.0f, 3.0f));
+      }
+      sync_cloud.updatePointCloud(c, clouds[c], true);
+      async_cloud.updatePointCloud(c, clouds[c], false);
+      BOOST_CHECK_MESSAGE(async_cloud.isDirty(c), "Updated cloud is dirty.");
+      async_cloud.syncToDeviceAsync();
+      BOOST_CHECK_MESSAGE(!async_cloud.isDirty(c), "Uploaded cloud is clean.");
+    }
+    async_cloud.waitForUploads();
+    BOOST_CHECK_MESSAGE(sync_cloud == async_cloud, "Asynchronous uploads equal the synchronous ones.");
+
+    // the host mode keeps the clouds on the host only
+    MetaPointCloud host_cloud(sync_cloud);
+    host_cloud.setUploadMode(MPU_HOST);
+    clouds[0][0].x += 1.0f;
+    host_cloud.updatePointCloud(0, clouds[0], true);
+    BOOST_CHECK_MESSAGE(!host_cloud.isDirty(0), "Host mode clears the dirty flag.");
+    BOOST_CHECK_MESSAGE(host_cloud.getPointCloud(0)[0].x == clouds[0][0].x, "Host mode updates the host cloud.");
+    // operator== compares the device clouds, which still hold the copied data
+    BOOST_CHECK_MESSAGE(host_cloud == sync_cloud, "Host mode does not upload the cloud.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("meta_pointcloud_async_upload", "meta_pointcloud_async_upload", "pointclouds");
+  }
+}
+
 BOOST_AUTO_TEST_CASE(pointcloud_equality)
 {
   PERF_MON_START("pointcloud_equality");
@@ -149,5 +296,184 @@ BOOST_AUTO_TEST_CASE(pointcloud_rotation)
   }
 }
 
+//! The host copy follows the points that were given on the host and the ones that were changed on the device.
+BOOST_AUTO_TEST_CASE(pointcloud_host_copy)
+{
+  PERF_MON_START("pointcloud_host_copy");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    std::vector<Vector3f> testdata;
+    for(size_t i = 0; i < (size_t)numberOfPoints; i++)
+    {
+      testdata.push_back(Vector3f(i, 2 * i, 3));
+    }
+    PointCloud cloud(testdata);
+    cloud.add(testdata);
+    BOOST_CHECK_MESSAGE(cloud.getPointCloudSize() == 2 * testdata.size(), "Points were added.");
+
+    const Vector3f* host_points = cloud.getConstHostPointer();
+    bool host_equal = true;
+    for(size_t k = 0; k < cloud.getPointCloudSize(); k++)
+    {
+      host_equal &= host_points[k] == testdata[k % testdata.size()];
+    }
+    BOOST_CHECK_MESSAGE(host_equal, "Host copy holds the given points.");
+
+    gpu_voxels::Matrix4f translation = gpu_voxels::Matrix4f::createFromRotationAndTranslation(
+          gpu_voxels::Matrix3f::createIdentity(), Vector3f(1, 2, 3));
+    cloud.transformSelf(&translation);
+    PointCloud copy(cloud);
+
+    host_points = cloud.getConstHostPointer();
+    const Vector3f* copy_points = copy.getConstHostPointer();
+    bool transformed_equal = true;
+    for(size_t k = 0; k < cloud.getPointCloudSize(); k++)
+    {
+      const Vector3f expected = testdata[k % testdata.size()] + Vector3f(1, 2, 3);
+      transformed_equal &= host_points[k] == expected && copy_points[k] == expected;
+    }
+    BOOST_CHECK_MESSAGE(transformed_equal, "Host copy holds the transformed points.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("pointcloud_host_copy", "pointcloud_host_copy", "pointclouds");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pointcloud_file_readers)
+{
+  PERF_MON_START("pointcloud_file_readers");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    std::vector<Vector3f> testdata;
+    for(size_t j = 0; j < (size_t)numberOfPoints; j++)
+    {
+      testdata.push_back(Vector3f(j * 0.25f, -1.0f / (j + 1), 1000.0f - j * 0.125f));
+    }
+
+    std::ofstream xyz_file("temp_cloud.xyz");
+    xyz_file.precision(9);
+    for(size_t j = 0; j < testdata.size(); j++)
+    {
+      xyz_file << testdata[j].x << " " << testdata[j].y << " " << testdata[j].z << "\n";
+    }
+    xyz_file.close();
+
+    std::vector<Vector3f> points;
+    std::vector<Vector3f> mapped_points;
+    file_handling::XyzFileReader xyz_reader;
+    file_handling::MappedXyzFileReader mapped_xyz_reader;
+    BOOST_CHECK_MESSAGE(xyz_reader.readPointCloud("temp_cloud.xyz", points), "XYZ file read.");
+    BOOST_CHECK_MESSAGE(mapped_xyz_reader.readPointCloud("temp_cloud.xyz", mapped_points), "XYZ file mapped.");
+    BOOST_CHECK_MESSAGE(equalPoints(testdata, mapped_points), "Mapped XYZ reader returns the written points.");
+    BOOST_CHECK_MESSAGE(equalPoints(points, mapped_points), "Both XYZ readers return the same points.");
+
+    // runs of up to 255 voxels, alternating between free and occupied
+    std::ofstream binvox_file("temp_cloud.binvox", std::ios::binary);
+    binvox_file << "#binvox 1\ndim 40 30 20\ntranslate 0.5 -1 2\nscale 3\ndata\n";
+    const int num_voxels = 40 * 30 * 20;
+    unsigned char value = 0;
+    for(int index = 0, run = 0; index < num_voxels; index += run, value = !value)
+    {
+      run = std::min(num_voxels - index, (index * 7) % 255 + 1);
+      binvox_file.put(value);
+      binvox_file.put((unsigned char)run);
+    }
+    binvox_file.close();
+
+    points.clear();
+    mapped_points.clear();
+    file_handling::BinvoxFileReader binvox_reader;
+    file_handling::MappedBinvoxFileReader mapped_binvox_reader;
+    BOOST_CHECK_MESSAGE(binvox_reader.readPointCloud("temp_cloud.binvox", points), "Binvox file read.");
+    BOOST_CHECK_MESSAGE(mapped_binvox_reader.readPointCloud("temp_cloud.binvox", mapped_points), "Binvox file mapped.");
+    BOOST_CHECK_MESSAGE(!mapped_points.empty() && equalPoints(points, mapped_points), "Both Binvox readers return the same points.");
+
+    remove("temp_cloud.xyz");
+    remove("temp_cloud.binvox");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("pointcloud_file_readers", "pointcloud_file_readers", "pointclouds");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pointcloud_pcd_reader)
+{
+  PERF_MON_START("pointcloud_pcd_reader");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    std::vector<Vector3f> testdata;
+    for(size_t j = 0; j < (size_t)numberOfPoints; j++)
+    {
+      testdata.push_back(Vector3f(j * 0.25f, -1.0f / (j + 1), 1000.0f - j * 0.125f));
+    }
+    file_handling::MappedPcdFileReader reader;
+    std::vector<Vector3f> points;
+
+    // ascii with an additional field in front of the coordinates
+    std::ofstream ascii_file("temp_cloud_ascii.pcd");
+    writePcdHeader(ascii_file, "rgb x y z", "4 4 4 4", "U F F F", testdata.size(), "ascii");
+    ascii_file.precision(9);
+    for(size_t j = 0; j < testdata.size(); j++)
+    {
+      ascii_file << j << " " << testdata[j].x << " " << testdata[j].y << " " << testdata[j].z << "\n";
+    }
+    ascii_file.close();
+    BOOST_CHECK_MESSAGE(reader.readPointCloud("temp_cloud_ascii.pcd", points), "Ascii PCD file read.");
+    BOOST_CHECK_MESSAGE(equalPoints(testdata, points), "Ascii PCD points are equal.");
+
+    // binary with double precision x and padding after the coordinates
+    std::ofstream binary_file("temp_cloud_binary.pcd", std::ios::binary);
+    writePcdHeader(binary_file, "x y z pad", "8 4 4 2", "F F F U", testdata.size(), "binary");
+    for(size_t j = 0; j < testdata.size(); j++)
+    {
+      const double x = testdata[j].x;
+      const uint16_t pad = 0;
+      binary_file.write((const char*)&x, sizeof(x));
+      binary_file.write((const char*)&testdata[j].y, sizeof(float));
+      binary_file.write((const char*)&testdata[j].z, sizeof(float));
+      binary_file.write((const char*)&pad, sizeof(pad));
+    }
+    binary_file.close();
+    points.clear();
+    BOOST_CHECK_MESSAGE(reader.readPointCloud("temp_cloud_binary.pcd", points), "Binary PCD file read.");
+    BOOST_CHECK_MESSAGE(equalPoints(testdata, points), "Binary PCD points are equal.");
+
+    // binary_compressed stores the fields one after the other as LZF literal runs of at most 32 bytes
+    std::vector<char> raw;
+    for(size_t c = 0; c < 3; c++)
+    {
+      for(size_t j = 0; j < testdata.size(); j++)
+      {
+        const float value = c == 0 ? testdata[j].x : (c == 1 ? testdata[j].y : testdata[j].z);
+        raw.insert(raw.end(), (const char*)&value, (const char*)&value + sizeof(float));
+      }
+    }
+    std::vector<char> compressed;
+    for(size_t pos = 0; pos < raw.size(); pos += 32)
+    {
+      const size_t length = std::min<size_t>(32, raw.size() - pos);
+      compressed.push_back(char(length - 1));
+      compressed.insert(compressed.end(), raw.begin() + pos, raw.begin() + pos + length);
+    }
+    std::ofstream compressed_file("temp_cloud_compressed.pcd", std::ios::binary);
+    writePcdHeader(compressed_file, "x y z", "4 4 4", "F F F", testdata.size(), "binary_compressed");
+    const uint32_t sizes[2] = { uint32_t(compressed.size()), uint32_t(raw.size()) };
+    compressed_file.write((const char*)sizes, sizeof(sizes));
+    compressed_file.write(&compressed[0], compressed.size());
+    compressed_file.close();
+    points.clear();
+    BOOST_CHECK_MESSAGE(reader.readPointCloud("temp_cloud_compressed.pcd", points), "Compressed PCD file read.");
+    BOOST_CHECK_MESSAGE(equalPoints(testdata, points), "Compressed PCD points are equal.");
+
+    // a back reference that overlaps with its own output
+    const char lzf[] = { 2, 'a', 'b', 'c', char(7 << 5), 3, 2 };
+    char decompressed[15];
+    BOOST_CHECK_MESSAGE(file_handling::decompressLzf(lzf, sizeof(lzf), decompressed, sizeof(decompressed)) &&
+                        std::string(decompressed, sizeof(decompressed)) == "abcabcabcabcabc", "LZF back reference decompressed.");
+    BOOST_CHECK_MESSAGE(!file_handling::decompressLzf(lzf, sizeof(lzf), decompressed, 10), "LZF overflow detected.");
+
+    remove("temp_cloud_ascii.pcd");
+    remove("temp_cloud_binary.pcd");
+    remove("temp_cloud_compressed.pcd");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("pointcloud_pcd_reader", "pointcloud_pcd_reader", "pointclouds");
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,190 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2018 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Compares the forward kinematics of the compiled kinematic tree of
+ * the URDF robot with the recursive KDL solver.
+ *
+ */
+//----------------------------------------------------------------------
+
+#include <boost/test/unit_test.hpp>
+
+#include <gpu_voxels/robot/urdf_robot/robot.h>
+#include <gpu_voxels/test/testing_fixtures.hpp>
+
+#include <kdl/jntarray.hpp>
+#include <kdl/treefksolverpos_recursive.hpp>
+#include <urdf_model/model.h>
+#include <urdf_parser/urdf_parser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace gpu_voxels;
+
+namespace {
+
+//! A tree with a branch and all supported joint types, with tilted origins and unnormalized axes
+const char* const cTEST_URDF =
+    "<robot name=\"fk_test\">"
+    "  <link name=\"base\"><collision><geometry><box size=\"0.1 0.1 0.1\"/></geometry></collision></link>"
+    "  <link name=\"upper_arm\"><collision><geometry><box size=\"0.1 0.1 0.3\"/></geometry></collision></link>"
+    "  <link name=\"forearm\"><collision><geometry><box size=\"0.1 0.1 0.3\"/></geometry></collision></link>"
+    "  <link name=\"slider\"><collision><geometry><box size=\"0.05 0.05 0.05\"/></geometry></collision></link>"
+    "  <link name=\"tool\"><collision><geometry><sphere radius=\"0.04\"/></geometry></collision></link>"
+    "  <link name=\"camera\"><collision><geometry><box size=\"0.05 0.1 0.05\"/></geometry></collision></link>"
+    "  <joint name=\"shoulder\" type=\"revolute\">"
+    "    <parent link=\"base\"/><child link=\"upper_arm\"/>"
+    "    <origin xyz=\"0.1 -0.2 0.3\" rpy=\"0.3 -0.5 1.1\"/><axis xyz=\"0.2 1 -0.4\"/>"
+    "    <limit lower=\"-3\" upper=\"3\" effort=\"1\" velocity=\"1\"/>"
+    "  </joint>"
+    "  <joint name=\"elbow\" type=\"continuous\">"
+    "    <parent link=\"upper_arm\"/><child link=\"forearm\"/>"
+    "    <origin xyz=\"0 0.05 0.3\" rpy=\"-1.2 0.1 0\"/><axis xyz=\"1 0 1\"/>"
+    "  </joint>"
+    "  <joint name=\"extension\" type=\"prismatic\">"
+    "    <parent link=\"forearm\"/><child link=\"slider\"/>"
+    "    <origin xyz=\"0.02 0 0.25\" rpy=\"0 0.7 -0.2\"/><axis xyz=\"0 0 2\"/>"
+    "    <limit lower=\"-0.2\" upper=\"0.2\" effort=\"1\" velocity=\"1\"/>"
+    "  </joint>"
+    "  <joint name=\"flange\" type=\"fixed\">"
+    "    <parent link=\"slider\"/><child link=\"tool\"/>"
+    "    <origin xyz=\"0 0.01 0.08\" rpy=\"0.4 0 0.9\"/>"
+    "  </joint>"
+    "  <joint name=\"pan\" type=\"revolute\">"
+    "    <parent link=\"base\"/><child link=\"camera\"/>"
+    "    <origin xyz=\"-0.1 0.1 0.05\" rpy=\"0 0 2.5\"/><axis xyz=\"0 0 -1\"/>"
+    "    <limit lower=\"-3\" upper=\"3\" effort=\"1\" velocity=\"1\"/>"
+    "  </joint>"
+    "</robot>";
+
+//! Largest difference between the rotations and translations of two frames
+double maxDifference(const KDL::Frame &a, const KDL::Frame &b)
+{
+  double difference = 0.0;
+  for (int i = 0; i < 9; i++)
+  {
+    difference = std::max(difference, std::fabs(a.M.data[i] - b.M.data[i]));
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    difference = std::max(difference, std::fabs(a.p[i] - b.p[i]));
+  }
+  return difference;
+}
+
+KDL::Frame toFrame(const Matrix4f &m)
+{
+  return KDL::Frame(KDL::Rotation(m.a11, m.a12, m.a13,
+                                  m.a21, m.a22, m.a23,
+                                  m.a31, m.a32, m.a33),
+                    KDL::Vector(m.a14, m.a24, m.a34));
+}
+
+float randomValue(const float range)
+{
+  return range * (2.0f * float(rand()) / float(RAND_MAX) - 1.0f);
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(urdf_robot, ArgsFixture)
+
+//! The compiled kinematic tree delivers the link poses of the recursive KDL solver.
+BOOST_AUTO_TEST_CASE(robot_forward_kinematics)
+{
+  boost::shared_ptr<urdf::ModelInterface> model = urdf::parseURDF(cTEST_URDF);
+  BOOST_REQUIRE(model);
+
+  robot::Robot rob;
+  rob.load(*model, boost::filesystem::path("."), 0.02f, false, true);
+  rob.setPose(KDL::Frame(KDL::Rotation::RPY(0.1, -0.2, 0.3), KDL::Vector(1.0, 2.0, -0.5)));
+
+  std::vector<std::string> joint_names;
+  rob.getJointNames(joint_names);
+  const std::vector<std::string> &link_names = rob.getCompiledLinkNames();
+  BOOST_REQUIRE_EQUAL(link_names.size(), model->links_.size());
+
+  const KDL::Tree &tree = rob.getTree();
+  KDL::TreeFkSolverPos_recursive reference_solver(tree);
+
+  srand(1);
+  const size_t num_configurations = 200;
+  std::vector<float> all_values;
+  std::vector<Matrix4f> single_poses;
+  std::vector<std::vector<Matrix4f> > all_single_poses;
+  double max_state_error = 0.0;
+  double max_float_error = 0.0;
+  for (size_t c = 0; c < num_configurations; c++)
+  {
+    robot::JointValueMap joint_values;
+    std::vector<float> values;
+    KDL::JntArray q(tree.getNrOfJoints());
+    for (size_t j = 0; j < joint_names.size(); j++)
+    {
+      const float value = randomValue(joint_names[j] == "extension" ? 0.2f : 3.0f);
+      joint_values[joint_names[j]] = value;
+      values.push_back(value);
+    }
+    for (KDL::SegmentMap::const_iterator it = tree.getSegments().begin(); it != tree.getSegments().end(); ++it)
+    {
+      const KDL::Joint &joint = it->second.segment.getJoint();
+      if (joint.getType() != KDL::Joint::None)
+      {
+        q(it->second.q_nr) = joint_values[joint.getName()];
+      }
+    }
+    all_values.insert(all_values.end(), values.begin(), values.end());
+
+    rob.setConfiguration(joint_values);
+    rob.computeLinkPoses(values, single_poses);
+    all_single_poses.push_back(single_poses);
+    BOOST_REQUIRE_EQUAL(single_poses.size(), link_names.size());
+
+    for (size_t i = 0; i < link_names.size(); i++)
+    {
+      KDL::Frame reference;
+      BOOST_REQUIRE(reference_solver.JntToCart(q, reference, link_names[i]) >= 0);
+      reference = rob.getPose() * reference;
+
+      max_state_error = std::max(max_state_error, maxDifference(rob.getLink(link_names[i])->getPose(), reference));
+      max_float_error = std::max(max_float_error, maxDifference(toFrame(single_poses[i]), reference));
+    }
+  }
+  BOOST_CHECK_MESSAGE(max_state_error < 1e-9, "Link poses of setConfiguration() match KDL in double precision, error "
+                      << max_state_error);
+  BOOST_CHECK_MESSAGE(max_float_error < 1e-4, "computeLinkPoses() matches KDL in float precision, error "
+                      << max_float_error);
+
+  std::vector<Matrix4f> batch_poses;
+  rob.computeLinkPosesBatch(all_values, num_configurations, batch_poses);
+  BOOST_REQUIRE_EQUAL(batch_poses.size(), num_configurations * link_names.size());
+  double max_batch_error = 0.0;
+  for (size_t c = 0; c < num_configurations; c++)
+  {
+    for (size_t i = 0; i < link_names.size(); i++)
+    {
+      max_batch_error = std::max(max_batch_error, maxDifference(toFrame(batch_poses[c * link_names.size() + i]),
+                                                                toFrame(all_single_poses[c][i])));
+    }
+  }
+  BOOST_CHECK_MESSAGE(max_batch_error < 1e-5, "computeLinkPosesBatch() matches computeLinkPoses(), error "
+                      << max_batch_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,8 @@
  *
  */
 //----------------------------------------------------------------------
+#include <algorithm>
+#include <cstdlib>
 #include <sstream>
 #include <gpu_voxels/voxellist/BitVoxelList.h>
 #include <gpu_voxels/voxellist/CountingVoxelList.h>
@@ -279,6 +281,81 @@ BOOST_AUTO_TEST_CASE(collide_bitvoxellist_with_prob_voxelmap_shifting)
 }
 
 
+BOOST_AUTO_TEST_CASE(collide_bitvoxellist_with_bitvoxellist_shifting)
+{
+  PERF_MON_START("collide_bitvoxellist_with_bitvoxellist_shifting");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    // an L in the xy plane and a bar along y at x = 3, so a mirrored offset gives different results
+    std::vector<Vector3f> l_cloud;
+    for(int x = 2; x <= 5; x++)
+    {
+      l_cloud.push_back(Vector3f(x + 0.5, 2.5, 2.5));
+    }
+    for(int y = 3; y <= 5; y++)
+    {
+      l_cloud.push_back(Vector3f(2.5, y + 0.5, 2.5));
+    }
+    std::vector<Vector3f> bar_cloud;
+    for(int y = 2; y <= 5; y++)
+    {
+      bar_cloud.push_back(Vector3f(3.5, y + 0.5, 2.5));
+    }
+
+    BitVectorVoxelList list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList list_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList host_list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    BitVectorVoxelList host_list_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    BitVectorMortonVoxelList morton_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_MORTON_VOXELLIST);
+    ProbVoxelMap map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    list_1.insertPointCloud(l_cloud, eBVM_OCCUPIED);
+    list_2.insertPointCloud(bar_cloud, eBVM_OCCUPIED);
+    host_list_1.insertPointCloud(l_cloud, eBVM_OCCUPIED);
+    host_list_2.insertPointCloud(bar_cloud, eBVM_OCCUPIED);
+    morton_list.insertPointCloud(bar_cloud, eBVM_OCCUPIED);
+    map.insertPointCloud(bar_cloud, eBVM_OCCUPIED);
+
+    // the voxel at c of list_1 meets the voxel at c + offset of list_2, which hits
+    // the arm voxel at x = 3, then the whole column of the L at x = 2, then nothing
+    const size_t expected[] = { 1, 4, 0, 0 };
+    for(int shift = 0; shift < 4; shift++)
+    {
+      const Vector3i offset(shift, 0, 0);
+      size_t num_colls = list_1.collideWith(&list_2, 1.0, offset);
+      BOOST_CHECK_MESSAGE(num_colls == expected[shift], "Number of shifted list collisions == " << expected[shift]);
+      BOOST_CHECK_MESSAGE(host_list_1.collideWith(&host_list_2, 1.0, offset) == num_colls,
+                          "Host and device list collisions match.");
+      // morton lists can only be collided with morton lists by subtracting them
+      BitVectorMortonVoxelList morton_remainder(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_MORTON_VOXELLIST);
+      morton_remainder.insertPointCloud(l_cloud, eBVM_OCCUPIED);
+      morton_remainder.subtract(&morton_list, offset);
+      BOOST_CHECK_MESSAGE(l_cloud.size() - morton_remainder.getDimensions().x == num_colls, "Morton and linear list collisions match.");
+      BOOST_CHECK_MESSAGE(list_1.collideWith(&map, 1.0, offset) == num_colls, "List and map collisions match.");
+
+      // the offset equals inserting the other list shifted the other way
+      BitVectorVoxelList shifted(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+      std::vector<Vector3f> shifted_cloud(bar_cloud);
+      for(size_t j = 0; j < shifted_cloud.size(); j++)
+      {
+        shifted_cloud[j].x -= shift;
+      }
+      shifted.insertPointCloud(shifted_cloud, eBVM_OCCUPIED);
+      BOOST_CHECK_MESSAGE(list_1.collideWith(&shifted) == num_colls, "Offset equals re-insertion.");
+    }
+
+    // with an offset of +1 the upper end of the L's column collides, the end of its arm doesn't
+    BitVectorVoxelList colliding_voxel(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList free_voxel(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    colliding_voxel.insertPointCloud(std::vector<Vector3f>(1, Vector3f(2.5, 5.5, 2.5)), eBVM_OCCUPIED);
+    free_voxel.insertPointCloud(std::vector<Vector3f>(1, Vector3f(4.5, 2.5, 2.5)), eBVM_OCCUPIED);
+    BOOST_CHECK_MESSAGE(colliding_voxel.collideWith(&list_2, 1.0, Vector3i(1, 0, 0)) == 1, "Voxel (2, 5, 2) collides.");
+    BOOST_CHECK_MESSAGE(free_voxel.collideWith(&list_2, 1.0, Vector3i(1, 0, 0)) == 0, "Voxel (4, 2, 2) does not collide.");
+    BOOST_CHECK_MESSAGE(free_voxel.collideWith(&list_2, 1.0, Vector3i(-1, 0, 0)) == 1, "Voxel (4, 2, 2) collides the other way.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("collide_bitvoxellist_with_bitvoxellist_shifting", "collide_bitvoxellist_with_bitvoxellist_shifting", "voxellists");
+  }
+}
+
 BOOST_AUTO_TEST_CASE(bitvoxellist_insert_metapointcloud)
 {
   PERF_MON_START("bitvoxellist_insert_metapointcloud");
@@ -534,6 +611,11 @@ BOOST_AUTO_TEST_CASE(voxellist_disk_io)
     list2.readFromDisk("temp_list.lst");
 
     BOOST_CHECK_MESSAGE(list.equals(list2), "List from Disk equals original list.");
+
+    list.writeToDisk("temp_list_rle.lst", file_handling::eMFE_RUN_LENGTH);
+    BitVectorVoxelList list3(Vector3ui(dimX, dimY, dimZ), 1, MT_BITVECTOR_VOXELLIST);
+    list3.readFromDisk("temp_list_rle.lst");
+    BOOST_CHECK_MESSAGE(list.equals(list3), "Encoded list from Disk equals original list.");
     PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("voxellist_disk_io", "voxellist_disk_io", "voxellists");
   }
 }
@@ -909,6 +991,214 @@ BOOST_AUTO_TEST_CASE(countingvoxellist_remove_underpopulated)
 }
 
 
+BOOST_AUTO_TEST_CASE(bitvoxellist_sorted_intersection)
+{
+  PERF_MON_START("bitvoxellist_sorted_intersection");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    srand(i);
+    // the lists hold voxels of random points, with size ratios from 1:1 to 1:1000
+    std::vector<Vector3f> big_cloud;
+    for(size_t j = 0; j < 20000; j++)
+    {
+      big_cloud.push_back(Vector3f(rand() % dimX, rand() % dimY, rand() % dimZ) + Vector3f(0.5, 0.5, 0.5));
+    }
+    for(size_t ratio = 1; ratio <= 1000; ratio *= 10)
+    {
+      std::vector<Vector3f> small_cloud;
+      for(size_t j = 0; j < big_cloud.size() / ratio; j++)
+      {
+        small_cloud.push_back(Vector3f(rand() % dimX, rand() % dimY, rand() % dimZ) + Vector3f(0.5, 0.5, 0.5));
+      }
+      BitVectorVoxelList big_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+      BitVectorVoxelList small_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+      BitVectorVoxelList host_big_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+      BitVectorVoxelList host_small_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+      big_list.insertPointCloud(big_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      small_list.insertPointCloud(small_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+      host_big_list.insertPointCloud(big_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      host_small_list.insertPointCloud(small_cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+
+      // reference: a voxel of the small list collides if its coordinates are in the big list
+      thrust::host_vector<MapVoxelID> big_ids = big_list.m_dev_id_list;
+      thrust::host_vector<MapVoxelID> small_ids = small_list.m_dev_id_list;
+      size_t expected = 0;
+      for(size_t j = 0; j < small_ids.size(); j++)
+      {
+        expected += std::binary_search(big_ids.begin(), big_ids.end(), small_ids[j]) ? 1 : 0;
+      }
+
+      BOOST_CHECK_MESSAGE(big_list.collideWith(&small_list) == expected, "Big list collisions match the reference.");
+      BOOST_CHECK_MESSAGE(small_list.collideWith(&big_list) == expected, "Small list collisions match the reference.");
+      BOOST_CHECK_MESSAGE(host_small_list.collideWith(&host_big_list) == expected, "Host list collisions match the reference.");
+
+      BitVectorVoxel types;
+      BitVectorVoxel host_types;
+      BOOST_CHECK_MESSAGE(small_list.collideWithTypes(&big_list, types) == expected, "Collisions with types match the reference.");
+      BOOST_CHECK_MESSAGE(host_big_list.collideWithTypes(&host_small_list, host_types) == expected,
+                          "Host collisions with types match the reference.");
+      BOOST_CHECK_MESSAGE(types.bitVector() == host_types.bitVector(), "Host and device colliding types match.");
+      BOOST_CHECK_MESSAGE(types.bitVector().getBit(eBVM_SWEPT_VOLUME_START + 1) == (expected > 0)
+                          && types.bitVector().getBit(eBVM_SWEPT_VOLUME_START + 2) == (expected > 0),
+                          "The types of both lists are in collision.");
+    }
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("bitvoxellist_sorted_intersection", "bitvoxellist_sorted_intersection", "voxellists");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(host_backend_voxellist)
+{
+  PERF_MON_START("host_backend_voxellist");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    BitVectorVoxelList dev_list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList dev_list_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList host_list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    BitVectorVoxelList host_list_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    ProbVoxelMap host_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, MB_HOST);
+
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(4.1, 4.1, 4.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(3.1, 3.1, 3.1), Vector3f(5.1, 5.1, 5.1), 0.5);
+
+    dev_list_1.insertPointCloud(box_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    dev_list_2.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+    host_list_1.insertPointCloud(box_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    host_list_2.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+    host_map.insertPointCloud(box_2, eBVM_OCCUPIED);
+
+    BOOST_CHECK_MESSAGE(host_list_1.equals(dev_list_1), "Host and device lists are equal after insertion.");
+    BOOST_CHECK_MESSAGE(host_list_1.collideWith(&host_list_2) == dev_list_1.collideWith(&dev_list_2),
+                        "Host and device list collisions match.");
+
+    BitVectorVoxel host_types;
+    BitVectorVoxel dev_types;
+    size_t host_collisions = host_list_1.collideWithTypes(&host_list_2, host_types);
+    size_t dev_collisions = dev_list_1.collideWithTypes(&dev_list_2, dev_types);
+    BOOST_CHECK_MESSAGE(host_collisions == dev_collisions, "Host and device collisions with types match.");
+    BOOST_CHECK_MESSAGE(host_types.bitVector() == dev_types.bitVector(), "Host and device colliding types match.");
+
+    BOOST_CHECK_MESSAGE(host_list_1.collideWith(&host_map, 0.1) == dev_collisions, "Host list collides with host map.");
+
+    host_list_1.subtract(&host_list_2);
+    dev_list_1.subtract(&dev_list_2);
+    BOOST_CHECK_MESSAGE(host_list_1.equals(dev_list_1), "Host and device lists are equal after subtraction.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("host_backend_voxellist", "host_backend_voxellist", "voxellists");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(host_backend_voxellist_bitchecks)
+{
+  PERF_MON_START("host_backend_voxellist_bitchecks");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    BitVectorVoxelList dev_list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList host_list_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    GpuVoxelsMapSharedPtr dev_list_2(new BitVectorVoxelList(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST));
+    GpuVoxelsMapSharedPtr host_list_2(new BitVectorVoxelList(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST));
+    ProbVoxelMap dev_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    ProbVoxelMap host_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, MB_HOST);
+
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(4.1, 4.1, 4.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(3.1, 3.1, 3.1), Vector3f(5.1, 5.1, 5.1), 0.5);
+    std::vector<Vector3f> box_3 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(3.1, 3.1, 3.1), 0.5);
+
+    // the first list holds two meanings, so the type mask and the meaning counts have something to select
+    dev_list_1.insertPointCloud(box_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    dev_list_1.insertPointCloud(box_3, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 3));
+    host_list_1.insertPointCloud(box_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    host_list_1.insertPointCloud(box_3, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 3));
+    dev_list_2->insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    host_list_2->insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    dev_map.insertPointCloud(box_3, eBVM_OCCUPIED);
+    host_map.insertPointCloud(box_3, eBVM_OCCUPIED);
+
+    BitVectorVoxel mask;
+    mask.bitVector().setBit(eBVM_SWEPT_VOLUME_START + 3);
+    size_t dev_collisions = dev_list_1.collideWithTypeMask(&dev_map, mask, 0.1);
+    size_t host_collisions = host_list_1.collideWithTypeMask(&host_map, mask, 0.1);
+    BOOST_CHECK_MESSAGE(dev_collisions > 0, "Device type mask collisions found.");
+    BOOST_CHECK_MESSAGE(host_collisions == dev_collisions, "Host and device type mask collisions match.");
+
+    dev_collisions = dev_list_1.collideWithBitcheck(dev_list_2->as<BitVectorVoxelList>(), 0);
+    host_collisions = host_list_1.collideWithBitcheck(host_list_2->as<BitVectorVoxelList>(), 0);
+    BOOST_CHECK_MESSAGE(dev_collisions > 0, "Device bitcheck collisions found.");
+    BOOST_CHECK_MESSAGE(host_collisions == dev_collisions, "Host and device bitcheck collisions match.");
+    dev_collisions = dev_list_1.collideWithBitcheck(dev_list_2->as<BitVectorVoxelList>(), 2);
+    host_collisions = host_list_1.collideWithBitcheck(host_list_2->as<BitVectorVoxelList>(), 2);
+    BOOST_CHECK_MESSAGE(host_collisions == dev_collisions, "Host and device bitcheck collisions with margin match.");
+
+    std::vector<size_t> dev_per_meaning(BIT_VECTOR_LENGTH, 0);
+    std::vector<size_t> host_per_meaning(BIT_VECTOR_LENGTH, 0);
+    dev_collisions = dev_list_1.collideCountingPerMeaning(dev_list_2, dev_per_meaning);
+    host_collisions = host_list_1.collideCountingPerMeaning(host_list_2, host_per_meaning);
+    BOOST_CHECK_MESSAGE(dev_collisions > 0, "Device collisions per meaning found.");
+    BOOST_CHECK_MESSAGE(host_collisions == dev_collisions, "Host and device collisions per meaning match.");
+    BOOST_CHECK_MESSAGE(host_per_meaning == dev_per_meaning, "Host and device counts per meaning match.");
+
+    BOOST_CHECK_MESSAGE(host_list_1.collideCountingPerMeaning(dev_list_2, host_per_meaning) == SSIZE_MAX,
+                        "Lists of different backends are rejected.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("host_backend_voxellist_bitchecks", "host_backend_voxellist_bitchecks", "voxellists");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(downsampled_pointcloud_insertion)
+{
+  PERF_MON_START("downsampled_pointcloud_insertion");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    srand(i);
+    // up to five points per voxel, the downsampled cloud also contains points outside the map
+    std::vector<Vector3f> cloud;
+    for(size_t j = 0; j < 2000; j++)
+    {
+      const Vector3f voxel(rand() % dimX, rand() % dimY, rand() % dimZ);
+      for(size_t k = 0; k <= j % 5; k++)
+      {
+        cloud.push_back(voxel + Vector3f(0.1 + 0.2 * k, 0.9 - 0.2 * k, 0.5));
+      }
+    }
+    std::vector<Vector3f> cloud_with_outliers = cloud;
+    cloud_with_outliers.push_back(Vector3f(-2.5, 1.5, 1.5));
+    cloud_with_outliers.push_back(Vector3f(1.5, dimY + 2.5, 1.5));
+
+    BitVectorVoxelList list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList downsampled_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST);
+    BitVectorVoxelList host_downsampled_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELLIST, MB_HOST);
+    list.insertPointCloud(cloud, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    downsampled_list.insertDownsampledPointCloud(cloud_with_outliers, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    host_downsampled_list.insertDownsampledPointCloud(cloud_with_outliers, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    BOOST_CHECK_MESSAGE(downsampled_list.equals(list), "Downsampled list equals the list of all points.");
+    BOOST_CHECK_MESSAGE(host_downsampled_list.equals(list), "Downsampled host list equals the list of all points.");
+
+    // counting lists keep the number of points per voxel
+    CountingVoxelList counting_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_COUNTING_VOXELLIST);
+    CountingVoxelList downsampled_counting_list(Vector3ui(dimX, dimY, dimZ), side_length, MT_COUNTING_VOXELLIST);
+    counting_list.insertPointCloud(cloud, eBVM_OCCUPIED);
+    downsampled_counting_list.insertDownsampledPointCloud(cloud_with_outliers, eBVM_OCCUPIED);
+    thrust::host_vector<MapVoxelID> ids = counting_list.m_dev_id_list;
+    thrust::host_vector<MapVoxelID> downsampled_ids = downsampled_counting_list.m_dev_id_list;
+    thrust::host_vector<CountingVoxel> counts = counting_list.m_dev_list;
+    thrust::host_vector<CountingVoxel> downsampled_counts = downsampled_counting_list.m_dev_list;
+    bool counts_equal = ids == downsampled_ids && counts.size() == downsampled_counts.size();
+    for(size_t j = 0; counts_equal && j < counts.size(); j++)
+    {
+      counts_equal = counts[j].getCount() == downsampled_counts[j].getCount();
+    }
+    BOOST_CHECK_MESSAGE(counts_equal, "Downsampled counting list has the point counts of all points.");
+
+    // maps contain the same voxels
+    ProbVoxelMap downsampled_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    downsampled_map.insertDownsampledPointCloud(cloud_with_outliers, eBVM_OCCUPIED);
+    BOOST_CHECK_MESSAGE(list.collideWith(&downsampled_map, 0.1) == list.m_dev_id_list.size(),
+                        "Downsampled map contains all voxels of the list.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("downsampled_pointcloud_insertion", "downsampled_pointcloud_insertion", "voxellists");
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -22,13 +22,22 @@
 //----------------------------------------------------------------------
 #include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.h>
 #include <gpu_voxels/voxelmap/VoxelMap.h>
+#include <gpu_voxels/voxelmap/SensorIntegrationPipeline.h>
 #include <gpu_voxels/voxelmap/Tests.h>
 #include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/helpers/cuda_handling.h>
 #include <gpu_voxels/voxel/SVCollider.hpp>
 #include <gpu_voxels/voxel/BitVoxel.hpp>
 #include <gpu_voxels/helpers/GeometryGeneration.h>
+#include <gpu_voxels/helpers/FreeSpaceRayCaster.h>
 #include <gpu_voxels/test/testing_fixtures.hpp>
+#include <boost/bind.hpp>
 #include <boost/mpl/vector.hpp>
+#include <boost/thread.hpp>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iterator>
 #include <boost/test/unit_test.hpp>
 #include "icl_core_performance_monitor/PerformanceMonitor.h"
 
@@ -361,6 +370,483 @@ BOOST_AUTO_TEST_CASE(collision_with_types_probab)
 
 
 
+//! Both backends have to find the same collisions, with and without offset.
+BOOST_AUTO_TEST_CASE(host_backend_collision)
+{
+  PERF_MON_START("host_backend_collision");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    ProbVoxelMap dev_map_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    BitVectorVoxelMap dev_map_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    ProbVoxelMap host_map_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, MB_HOST);
+    BitVectorVoxelMap host_map_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, MB_HOST);
+
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(4.1, 4.1, 4.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(3.1, 3.1, 3.1), Vector3f(5.1, 5.1, 5.1), 0.5);
+
+    dev_map_1.insertPointCloud(box_1, eBVM_OCCUPIED);
+    dev_map_2.insertPointCloud(box_2, eBVM_OCCUPIED);
+    host_map_1.insertPointCloud(box_1, eBVM_OCCUPIED);
+    host_map_2.insertPointCloud(box_2, eBVM_OCCUPIED);
+
+    BOOST_CHECK_MESSAGE(host_map_1.getBackend() == MB_HOST, "Host map uses host backend.");
+    BOOST_CHECK_MESSAGE(host_map_1.collideWith(&host_map_2, 0.1) == dev_map_1.collideWith(&dev_map_2, 0.1),
+                        "Host and device collisions match.");
+    BOOST_CHECK_MESSAGE(host_map_1.collideWith(&host_map_2, 0.1, Vector3i(1, 1, 1)) == dev_map_1.collideWith(&dev_map_2, 0.1, Vector3i(1, 1, 1)),
+                        "Host and device collisions with offset match.");
+    BOOST_CHECK_MESSAGE(host_map_1.collideWith(&dev_map_2, 0.1) == 0, "Mixed backends are rejected.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("host_backend_collision", "host_backend_collision", "voxelmap");
+  }
+}
+
+//! Collisions that only visit the bricks occupied in both maps have to match a full scan.
+BOOST_AUTO_TEST_CASE(brick_index_collision)
+{
+  PERF_MON_START("brick_index_collision");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    ProbVoxelMap map_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    BitVectorVoxelMap map_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    ProbVoxelMap full_map_1(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    BitVectorVoxelMap full_map_2(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+
+    // the boxes cross brick borders, the second pair lies in the partial bricks at the map border
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(5.1, 5.1, 5.1), Vector3f(12.1, 12.1, 12.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(10.1, 10.1, 10.1), Vector3f(20.1, 20.1, 20.1), 0.5);
+    std::vector<Vector3f> box_3 = createBoxOfPoints(Vector3f(dimX - 4.9, dimY - 4.9, dimZ - 4.9),
+                                                    Vector3f(dimX - 0.9, dimY - 0.9, dimZ - 0.9), 0.5);
+    std::vector<Vector3f> box_4 = createBoxOfPoints(Vector3f(dimX - 2.9, dimY - 2.9, dimZ - 2.9),
+                                                    Vector3f(dimX - 0.9, dimY - 0.9, dimZ - 0.9), 0.5);
+
+    map_1.insertPointCloud(box_1, eBVM_OCCUPIED);
+    map_1.insertPointCloud(box_3, eBVM_OCCUPIED);
+    map_2.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    map_2.insertPointCloud(box_4, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+    full_map_1.insertPointCloud(box_1, eBVM_OCCUPIED);
+    full_map_1.insertPointCloud(box_3, eBVM_OCCUPIED);
+    full_map_2.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+    full_map_2.insertPointCloud(box_4, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+
+    // without index the collision checks visit all voxels
+    full_map_2.invalidateBrickIndex();
+    BOOST_CHECK_MESSAGE(map_1.getConstBrickOccupancyPtr() != NULL, "Brick index is valid after inserting points.");
+    BOOST_CHECK_MESSAGE(full_map_2.getConstBrickOccupancyPtr() == NULL, "Brick index is invalid.");
+
+    BitVectorVoxel types_bricks;
+    BitVectorVoxel types_full;
+    size_t coll_bricks = map_2.collideWithTypes(&map_1, types_bricks, 0.1);
+    size_t coll_full = full_map_2.collideWithTypes(&full_map_1, types_full, 0.1);
+    size_t count_bricks = map_1.collideWith(&map_2, 0.1);
+    size_t count_full = full_map_1.collideWith(&full_map_2, 0.1);
+
+    BOOST_CHECK_MESSAGE(coll_bricks == 27 + 27, "Number of collisions with types.");
+    BOOST_CHECK_MESSAGE(coll_bricks == coll_full, "Collisions with types match the full scan.");
+    BOOST_CHECK_MESSAGE(types_bricks.bitVector() == types_full.bitVector(), "Colliding types match the full scan.");
+    BOOST_CHECK_MESSAGE(count_bricks == count_full, "Collision counts match the full scan.");
+
+    // clearing the map makes the index valid again
+    map_2.clearMap();
+    map_2.insertPointCloud(box_4, eBVM_OCCUPIED);
+    BOOST_CHECK_MESSAGE(map_2.getConstBrickOccupancyPtr() != NULL, "Brick index is valid after clearing.");
+    BOOST_CHECK_MESSAGE(map_1.collideWith(&map_2, 0.1) == 27, "Only the border boxes collide.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("brick_index_collision", "brick_index_collision", "voxelmap");
+  }
+}
+
+//! A multi map query delivers the same results as one collision check per map.
+BOOST_AUTO_TEST_CASE(multi_map_collision)
+{
+  PERF_MON_START("multi_map_collision");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    for (int b = 0; b < 2; ++b)
+    {
+      const MapBackend backend = (b == 0) ? MB_DEVICE : MB_HOST;
+      BitVectorVoxelMap robot(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, backend);
+      BitVectorVoxelMap robot_single(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, backend);
+      BitVectorVoxelMap swept_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, backend);
+      ProbVoxelMap obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, backend);
+      ProbVoxelMap empty_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, backend);
+      ProbVoxelMap small_obstacle(Vector3ui(dimX / 2, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, backend);
+
+      std::vector<Vector3f> robot_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(6.1, 6.1, 6.1), 0.5);
+      std::vector<Vector3f> robot_2 = createBoxOfPoints(Vector3f(8.1, 8.1, 8.1), Vector3f(10.1, 10.1, 10.1), 0.5);
+      robot.insertPointCloud(robot_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      robot.insertPointCloud(robot_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+      robot_single.insertPointCloud(robot_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      robot_single.insertPointCloud(robot_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+
+      // 2^3 voxels collide with every swept volume, 3^3 + 1 voxels with the probabilistic map
+      swept_obstacle.insertPointCloud(createBoxOfPoints(Vector3f(5.1, 5.1, 5.1), Vector3f(9.1, 9.1, 9.1), 0.5),
+                                      BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      swept_obstacle.insertPointCloud(createBoxOfPoints(Vector3f(9.1, 9.1, 9.1), Vector3f(12.1, 12.1, 12.1), 0.5),
+                                      BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+      obstacle.insertPointCloud(createBoxOfPoints(Vector3f(4.1, 4.1, 4.1), Vector3f(8.1, 8.1, 8.1), 0.5),
+                                eBVM_OCCUPIED);
+
+      std::vector<GpuVoxelsMap*> maps;
+      maps.push_back(&swept_obstacle);
+      maps.push_back(&obstacle);
+      maps.push_back(&empty_obstacle);
+      std::vector<CollisionQueryResult> results;
+      BOOST_CHECK_MESSAGE(robot.collideWithMaps(maps, results, 0.1), "All maps were checked.");
+      BOOST_CHECK_MESSAGE(results.size() == maps.size(), "One result per map.");
+
+      for (size_t m = 0; m < maps.size() && m < results.size(); ++m)
+      {
+        BitVectorVoxel types;
+        size_t collisions = maps[m]->getMapType() == MT_BITVECTOR_VOXELMAP
+            ? robot_single.collideWithTypes(&swept_obstacle, types, 0.1)
+            : robot_single.collideWithTypes(maps[m]->as<ProbVoxelMap>(), types, 0.1);
+        // the single checks see the collision flags of the previous checks
+        types.bitVector().clearBit(eBVM_COLLISION);
+        results[m].types_in_collision.bitVector().clearBit(eBVM_COLLISION);
+        BOOST_CHECK_MESSAGE(results[m].num_collisions == collisions, "Collisions match the single check.");
+        BOOST_CHECK_MESSAGE(results[m].types_in_collision.bitVector() == types.bitVector(),
+                            "Colliding types match the single check.");
+      }
+      BOOST_CHECK_MESSAGE(results.size() == 3 && results[0].num_collisions == 8 + 8
+                          && results[1].num_collisions == 27 + 1 && results[2].num_collisions == 0,
+                          "Number of collisions per map.");
+
+      // maps of other dimensions are reported, the others are checked nevertheless
+      maps.push_back(&small_obstacle);
+      BOOST_CHECK_MESSAGE(!robot.collideWithMaps(maps, results, 0.1), "Map of other dimensions is reported.");
+      BOOST_CHECK_MESSAGE(results.size() == 4 && results[3].num_collisions == SSIZE_MAX
+                          && results[1].num_collisions == 27 + 1, "Other maps are checked.");
+
+      // more maps than fit into one traversal are processed in batches
+      std::vector<GpuVoxelsMap*> many_maps(2 * cMAX_COLLISION_QUERY_MAPS + 1, &obstacle);
+      BOOST_CHECK_MESSAGE(robot.collideWithMaps(many_maps, results, 0.1), "All batches were checked.");
+      bool all_equal = results.size() == many_maps.size();
+      for (size_t m = 0; m < results.size(); ++m)
+      {
+        all_equal = all_equal && results[m].num_collisions == 27 + 1;
+      }
+      BOOST_CHECK_MESSAGE(all_equal, "All batches deliver the same result.");
+    }
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("multi_map_collision", "multi_map_collision", "voxelmap");
+  }
+}
+
+//! Map files written by one backend can be read by the other one, host maps use the mapped file as storage.
+BOOST_AUTO_TEST_CASE(voxelmap_disk_io)
+{
+  PERF_MON_START("voxelmap_disk_io");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    ProbVoxelMap dev_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    ProbVoxelMap host_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP, MB_HOST);
+    BitVectorVoxelMap dev_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    BitVectorVoxelMap host_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, MB_HOST);
+
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(4.1, 4.1, 4.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(3.1, 3.1, 3.1), Vector3f(5.1, 5.1, 5.1), 0.5);
+    dev_map.insertPointCloud(box_1, eBVM_OCCUPIED);
+    dev_obstacle.insertPointCloud(box_2, eBVM_OCCUPIED);
+    host_obstacle.insertPointCloud(box_2, eBVM_OCCUPIED);
+
+    BOOST_CHECK_MESSAGE(dev_map.writeToDisk("temp_map.gvm"), "Device map written to disk.");
+    BOOST_CHECK_MESSAGE(host_map.readFromDisk("temp_map.gvm"), "Host map read from disk.");
+    BOOST_CHECK_MESSAGE(host_map.collideWith(&host_obstacle, 0.1) == 8, "Host map from disk collides.");
+
+    // the mapping is private, so modifying the map leaves the file untouched
+    host_map.insertPointCloud(box_2, eBVM_OCCUPIED);
+    BOOST_CHECK_MESSAGE(host_map.collideWith(&host_obstacle, 0.1) == 27, "Mapped host map can be modified.");
+    BOOST_CHECK_MESSAGE(host_map.writeToDisk("temp_map_2.gvm"), "Host map written to disk.");
+
+    dev_map.clearMap();
+    BOOST_CHECK_MESSAGE(dev_map.readFromDisk("temp_map.gvm"), "Device map read from disk.");
+    BOOST_CHECK_MESSAGE(dev_map.collideWith(&dev_obstacle, 0.1) == 8, "Device map equals written map.");
+    BOOST_CHECK_MESSAGE(dev_map.readFromDisk("temp_map_2.gvm"), "Device map read from host map file.");
+    BOOST_CHECK_MESSAGE(dev_map.collideWith(&dev_obstacle, 0.1) == 27, "Device map equals modified host map.");
+
+    // the mapping is only used as storage if the voxel data matches its checksums
+    std::ifstream original("temp_map.gvm", std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(original)), std::istreambuf_iterator<char>());
+    content[content.size() - 1] ^= 0x01;
+    std::ofstream corrupted("temp_map_corrupted.gvm", std::ios::binary);
+    corrupted << content;
+    corrupted.close();
+    BOOST_CHECK_MESSAGE(!host_map.readFromDisk("temp_map_corrupted.gvm"), "Corrupted voxel data is rejected.");
+    BOOST_CHECK_MESSAGE(host_map.collideWith(&host_obstacle, 0.1) == 27, "Host map keeps its voxels.");
+
+    ProbVoxelMap wrong_dim(Vector3ui(dimX + 1, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    BOOST_CHECK_MESSAGE(!wrong_dim.readFromDisk("temp_map.gvm"), "Dimension mismatch is rejected.");
+    BOOST_CHECK_MESSAGE(!dev_obstacle.readFromDisk("temp_map.gvm"), "Voxel type mismatch is rejected.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("voxelmap_disk_io", "voxelmap_disk_io", "voxelmap");
+  }
+}
+
+//! Run length encoded map files have to decode to exactly the voxels of the raw files.
+BOOST_AUTO_TEST_CASE(voxelmap_encoded_disk_io)
+{
+  PERF_MON_START("voxelmap_encoded_disk_io");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    BitVectorVoxelMap dev_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    BitVectorVoxelMap host_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP, MB_HOST);
+
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(2.1, 2.1, 2.1), Vector3f(4.1, 4.1, 4.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(3.1, 3.1, 3.1), Vector3f(9.1, 9.1, 9.1), 0.5);
+    dev_map.insertPointCloud(box_1, eBVM_OCCUPIED);
+    dev_map.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 3));
+
+    BOOST_CHECK_MESSAGE(dev_map.writeToDisk("temp_map_raw.gvm"), "Raw map written to disk.");
+    BOOST_CHECK_MESSAGE(dev_map.writeToDisk("temp_map_rle.gvm", file_handling::eMFE_RUN_LENGTH), "Encoded map written to disk.");
+    BOOST_CHECK_MESSAGE(host_map.readFromDisk("temp_map_rle.gvm"), "Host map read from encoded file.");
+    BOOST_CHECK_MESSAGE(host_map.writeToDisk("temp_map_raw_2.gvm"), "Decoded host map written to disk.");
+    dev_map.clearMap();
+    BOOST_CHECK_MESSAGE(dev_map.readFromDisk("temp_map_rle.gvm"), "Device map read from encoded file.");
+    BOOST_CHECK_MESSAGE(dev_map.writeToDisk("temp_map_raw_3.gvm"), "Decoded device map written to disk.");
+
+    std::ifstream raw("temp_map_raw.gvm", std::ios::binary);
+    std::ifstream raw_2("temp_map_raw_2.gvm", std::ios::binary);
+    std::ifstream raw_3("temp_map_raw_3.gvm", std::ios::binary);
+    std::ifstream rle("temp_map_rle.gvm", std::ios::binary | std::ios::ate);
+    std::string raw_content((std::istreambuf_iterator<char>(raw)), std::istreambuf_iterator<char>());
+    std::string raw_content_2((std::istreambuf_iterator<char>(raw_2)), std::istreambuf_iterator<char>());
+    std::string raw_content_3((std::istreambuf_iterator<char>(raw_3)), std::istreambuf_iterator<char>());
+
+    BOOST_CHECK_MESSAGE(raw_content == raw_content_2, "Host map decodes bit exactly.");
+    BOOST_CHECK_MESSAGE(raw_content == raw_content_3, "Device map decodes bit exactly.");
+    BOOST_CHECK_MESSAGE(std::size_t(rle.tellg()) * 100 < raw_content.size(), "Mostly empty map is compressed.");
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("voxelmap_encoded_disk_io", "voxelmap_encoded_disk_io", "voxelmap");
+  }
+}
+
+void pushSensorFrames(SensorIntegrationPipeline* pipeline, const Sensor* sensor, const std::vector<Vector3f>* points,
+                      const int num_frames)
+{
+  for (int f = 0; f < num_frames; ++f)
+  {
+    pipeline->pushFrame(*sensor, *points);
+  }
+}
+
+//! Frames of several producers pass the pipeline, points out of range are cut and the others end up in the map.
+BOOST_AUTO_TEST_CASE(sensor_integration_pipeline)
+{
+  PERF_MON_START("sensor_integration_pipeline");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    const Sensor sensor(Vector3f(5.5, 40.5, 30.5), Matrix3f::createIdentity(), 121 + 121 + 1, 1);
+    BitVectorVoxelMap near_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    BitVectorVoxelMap far_obstacle(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+
+    // a wall of points in front of the sensor, a second one out of range and an invalid point
+    std::vector<Vector3f> points;
+    std::vector<Vector3f> near_points;
+    std::vector<Vector3f> far_points;
+    for (int y = -10; y <= 10; y += 2)
+    {
+      for (int z = -10; z <= 10; z += 2)
+      {
+        points.push_back(Vector3f(30, y, z));
+        near_points.push_back(Vector3f(35.5, 40.5 + y, 30.5 + z));
+        far_points.push_back(Vector3f(65.5, 40.5 + y, 30.5 + z));
+      }
+    }
+    for (int y = -10; y <= 10; y += 2)
+    {
+      for (int z = -10; z <= 10; z += 2)
+      {
+        points.push_back(Vector3f(60, y, z));
+      }
+    }
+    points.push_back(Vector3f(NAN, 0, 0));
+    near_obstacle.insertPointCloud(near_points, eBVM_OCCUPIED);
+    far_obstacle.insertPointCloud(far_points, eBVM_OCCUPIED);
+
+    SensorPipelineParameters parameters;
+    parameters.max_points = points.size();
+    parameters.back_pressure = eSBP_BLOCK;
+    parameters.max_range = 50;
+    {
+      ProbVoxelMap map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+      SensorIntegrationPipeline pipeline(&map, parameters);
+      boost::thread_group producers;
+      producers.create_thread(boost::bind(&pushSensorFrames, &pipeline, &sensor, &points, 20));
+      producers.create_thread(boost::bind(&pushSensorFrames, &pipeline, &sensor, &points, 20));
+      producers.join_all();
+      pipeline.flush();
+
+      SensorPipelineStatistics statistics = pipeline.getStatistics();
+      BOOST_CHECK_MESSAGE(statistics.frames_pushed == 40 && statistics.frames_integrated == 40
+                          && statistics.frames_dropped == 0, "Blocking producers lose no frames.");
+      BOOST_CHECK_MESSAGE(statistics.total.frames == 40 && statistics.total.max_ms >= statistics.integration.max_ms,
+                          "Latencies are measured.");
+      BOOST_CHECK_MESSAGE(map.collideWith(&near_obstacle, 0.9) == 121, "Points in range are occupied.");
+      BOOST_CHECK_MESSAGE(map.collideWith(&far_obstacle, 0.1) == 0, "Points out of range are cut.");
+
+      std::vector<Vector3f> too_many_points(points.size() + 1);
+      BOOST_CHECK_MESSAGE(!pipeline.pushFrame(sensor, too_many_points), "Too big frames are rejected.");
+    }
+    {
+      ProbVoxelMap map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+      parameters.decimation = 2;
+      SensorIntegrationPipeline pipeline(&map, parameters);
+      pushSensorFrames(&pipeline, &sensor, &points, 10);
+      pipeline.flush();
+      BOOST_CHECK_MESSAGE(map.collideWith(&near_obstacle, 0.9) == 61, "Every second point is kept.");
+    }
+    {
+      ProbVoxelMap map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+      parameters.decimation = 1;
+      parameters.back_pressure = eSBP_DROP_OLDEST;
+      parameters.queue_capacity = 1;
+      parameters.device_buffers = 1;
+      SensorIntegrationPipeline pipeline(&map, parameters);
+      boost::thread_group producers;
+      for (int p = 0; p < 3; ++p)
+      {
+        producers.create_thread(boost::bind(&pushSensorFrames, &pipeline, &sensor, &points, 50));
+      }
+      producers.join_all();
+      pipeline.flush();
+
+      SensorPipelineStatistics statistics = pipeline.getStatistics();
+      BOOST_CHECK_MESSAGE(statistics.frames_pushed == 150 && statistics.frames_integrated > 0
+                          && statistics.frames_integrated + statistics.frames_dropped == 150,
+                          "Every frame is either integrated or dropped.");
+    }
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("sensor_integration_pipeline", "sensor_integration_pipeline", "voxelmap");
+  }
+}
+
+Probability readOccupancy(const ProbVoxelMap& map, const Vector3ui& coordinates)
+{
+  const uint32_t index = getVoxelIndexUnsigned(map.getDimensions(), coordinates.x, coordinates.y, coordinates.z);
+  ProbabilisticVoxel voxel;
+  if (map.getBackend() == MB_HOST)
+  {
+    voxel = map.getConstDeviceDataPtr()[index];
+  }
+  else
+  {
+    HANDLE_CUDA_ERROR(cudaMemcpy(&voxel, map.getConstDeviceDataPtr() + index, sizeof(ProbabilisticVoxel),
+                                 cudaMemcpyDeviceToHost));
+  }
+  return voxel.getOccupancy();
+}
+
+//! Voxels touched by several rays of a frame are updated once, rays out of range are cut.
+BOOST_AUTO_TEST_CASE(free_space_ray_caster)
+{
+  PERF_MON_START("free_space_ray_caster");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    const Vector3ui dim(dimX, dimY, dimZ);
+    const Vector3f origin(5.5, 40.5, 30.5);
+    std::vector<Vector3f> points;
+    for (int y = -10; y <= 10; y += 2)
+    {
+      for (int z = -10; z <= 10; z += 2)
+      {
+        points.push_back(Vector3f(35.5, 40.5 + y, 30.5 + z));
+      }
+    }
+    points.push_back(Vector3f(65.5, 40.5, 30.5));
+    points.push_back(Vector3f(NAN, 0, 0));
+
+    // two sensors at the same position see the same points
+    FreeSpaceRayCaster ray_caster(dim, side_length, 50);
+    ray_caster.addRays(origin, &points[0], points.size());
+    ray_caster.addRays(origin, &points[0], points.size());
+    ray_caster.castRays();
+    BOOST_CHECK_MESSAGE(ray_caster.getOccupiedVoxels().size() == 121, "End points in range are occupied.");
+    BOOST_CHECK_MESSAGE(ray_caster.getNumTraversedVoxels() > 2 * ray_caster.getFreeVoxels().size(),
+                        "Free voxels are deduplicated.");
+
+    for (int b = 0; b < 2; ++b)
+    {
+      const MapBackend backend = (b == 0) ? MB_DEVICE : MB_HOST;
+      ProbVoxelMap map(dim, side_length, MT_PROBAB_VOXELMAP, backend);
+      map.insertRayCasterResults(ray_caster);
+
+      const Probability occupied = UNKNOWN_PROBABILITY + cSENSOR_MODEL_OCCUPIED;
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(35, 40, 30)) == occupied, "End points are updated once.");
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(5, 40, 30)) == MIN_PROBABILITY, "The origin is free.");
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(34, 40, 30)) == MIN_PROBABILITY, "Voxels in front of the end points are free.");
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(54, 40, 30)) == MIN_PROBABILITY, "Cut rays are free up to the maximum range.");
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(56, 40, 30)) == UNKNOWN_PROBABILITY, "Rays are cut at the maximum range.");
+      BOOST_CHECK_MESSAGE(readOccupancy(map, Vector3ui(36, 42, 30)) == UNKNOWN_PROBABILITY, "Voxels behind the end points are unknown.");
+
+      // a ray caster of a part of the map updates the same voxels
+      FreeSpaceRayCaster volume_ray_caster(Vector3ui(60, 40, 40), side_length, 50, Vector3ui(0, 20, 10));
+      volume_ray_caster.addRays(origin, &points[0], points.size());
+      volume_ray_caster.castRays();
+      ProbVoxelMap volume_map(dim, side_length, MT_PROBAB_VOXELMAP, backend);
+      volume_map.insertRayCasterResults(volume_ray_caster);
+      BOOST_CHECK_MESSAGE(readOccupancy(volume_map, Vector3ui(35, 40, 30)) == occupied, "End points of a volume are updated.");
+      BOOST_CHECK_MESSAGE(readOccupancy(volume_map, Vector3ui(34, 40, 30)) == MIN_PROBABILITY, "Voxels of a volume are free.");
+      BOOST_CHECK_MESSAGE(readOccupancy(volume_map, Vector3ui(34, 20, 20)) == UNKNOWN_PROBABILITY, "Volumes are placed at their offset.");
+    }
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("free_space_ray_caster", "free_space_ray_caster", "voxelmap");
+  }
+}
+
+//! clearMap() only resets the flagged bricks, the rest of the map has to be cleared anyway.
+BOOST_AUTO_TEST_CASE(brick_index_clear)
+{
+  PERF_MON_START("brick_index_clear");
+  for(int i = 0; i < iterationCount; i++)
+  {
+    float side_length = 1.f;
+    ProbVoxelMap prob_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_PROBAB_VOXELMAP);
+    BitVectorVoxelMap bit_map(Vector3ui(dimX, dimY, dimZ), side_length, MT_BITVECTOR_VOXELMAP);
+    const uint32_t map_size = prob_map.getVoxelMapSize();
+
+    // one box crosses brick borders, the other one lies in the partial bricks at the map border
+    std::vector<Vector3f> box_1 = createBoxOfPoints(Vector3f(5.1, 5.1, 5.1), Vector3f(12.1, 12.1, 12.1), 0.5);
+    std::vector<Vector3f> box_2 = createBoxOfPoints(Vector3f(dimX - 4.9, dimY - 4.9, dimZ - 4.9),
+                                                    Vector3f(dimX - 0.9, dimY - 0.9, dimZ - 0.9), 0.5);
+
+    for (int invalidate = 0; invalidate < 2; ++invalidate)
+    {
+      prob_map.insertPointCloud(box_1, eBVM_OCCUPIED);
+      prob_map.insertPointCloud(box_2, eBVM_OCCUPIED);
+      bit_map.insertPointCloud(box_1, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 1));
+      bit_map.insertPointCloud(box_2, BitVoxelMeaning(eBVM_SWEPT_VOLUME_START + 2));
+      if (invalidate)
+      {
+        // writes through the pointer are not tracked, so the whole map has to be cleared
+        HANDLE_CUDA_ERROR(cudaMemset(prob_map.getDeviceDataPtr(), MAX_PROBABILITY, sizeof(ProbabilisticVoxel)));
+        HANDLE_CUDA_ERROR(cudaMemset(bit_map.getDeviceDataPtr(), 0xff, sizeof(BitVectorVoxel)));
+      }
+
+      prob_map.clearMap();
+      bit_map.clearMap();
+      BOOST_CHECK_MESSAGE(prob_map.getConstBrickOccupancyPtr() != NULL, "Brick index is valid after clearing.");
+      BOOST_CHECK_MESSAGE(bit_map.getConstBrickOccupancyPtr() != NULL, "Brick index is valid after clearing.");
+
+      std::vector<ProbabilisticVoxel> prob_voxels(map_size);
+      std::vector<BitVectorVoxel> bit_voxels(map_size);
+      HANDLE_CUDA_ERROR(cudaMemcpy(&prob_voxels[0], prob_map.getConstDeviceDataPtr(), map_size * sizeof(ProbabilisticVoxel),
+                                   cudaMemcpyDeviceToHost));
+      HANDLE_CUDA_ERROR(cudaMemcpy(&bit_voxels[0], bit_map.getConstDeviceDataPtr(), map_size * sizeof(BitVectorVoxel),
+                                   cudaMemcpyDeviceToHost));
+      uint32_t num_prob_leftovers = 0;
+      uint32_t num_bit_leftovers = 0;
+      for (uint32_t v = 0; v < map_size; ++v)
+      {
+        num_prob_leftovers += prob_voxels[v].getOccupancy() != UNKNOWN_PROBABILITY ? 1 : 0;
+        num_bit_leftovers += bit_voxels[v].bitVector().isZero() ? 0 : 1;
+      }
+      BOOST_CHECK_MESSAGE(num_prob_leftovers == 0, "All probabilistic voxels are cleared.");
+      BOOST_CHECK_MESSAGE(num_bit_leftovers == 0, "All bitvector voxels are cleared.");
+    }
+    PERF_MON_SILENT_MEASURE_AND_RESET_INFO_P("brick_index_clear", "brick_index_clear", "voxelmap");
+  }
+}
+
 BOOST_AUTO_TEST_CASE(iostream_bitvoxel)
 {
   PERF_MON_START("iostream_bitvoxel");
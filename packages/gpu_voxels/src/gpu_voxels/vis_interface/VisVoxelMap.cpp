@@ -83,7 +83,8 @@ bool VisVoxelMap::visualize(const bool force_repaint)
 
     }
     // first open or create and the set the values
-    HANDLE_CUDA_ERROR(cudaIpcGetMemHandle(m_shm_memHandle, m_voxelmap->getVoidDeviceDataPtr()));
+    // the visualizer only reads the map, so the brick occupancy index stays valid
+    HANDLE_CUDA_ERROR(cudaIpcGetMemHandle(m_shm_memHandle, const_cast<void*>(m_voxelmap->getConstVoidDeviceDataPtr())));
     *m_shm_mapDim = m_voxelmap->getDimensions();
     *m_shm_VoxelSize = m_voxelmap->getVoxelSideLength();
     *m_shm_voxelmap_changed = true;
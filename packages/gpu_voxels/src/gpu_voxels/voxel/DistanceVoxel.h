@@ -66,7 +66,11 @@ class DistanceVoxel //: public AbstractVoxel
 public:
 
   typedef int32_t pba_dist_t;
-  typedef uint32_t pba_voxel_t; // This stores the xyz-postiton as 3x 9Bit interger (+ x3 1Bit as "uninitialized" marker)
+#ifdef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
+  typedef uint64_t pba_voxel_t; // This stores the xyz-position as 3x PBA_COORD_BITS integer, all bits set mark "uninitialized"
+#else
+  typedef uint32_t pba_voxel_t; // This stores the xyz-position as 3x PBA_COORD_BITS integer, all bits set mark "uninitialized"
+#endif
 
   __host__ __device__
   const Vector3ui getObstacle() const;
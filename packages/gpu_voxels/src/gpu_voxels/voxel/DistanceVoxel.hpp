@@ -30,9 +30,10 @@ namespace gpu_voxels {
 
 __host__ __device__
 const Vector3ui DistanceVoxel::getObstacle() const {
-  uint x = m_obstacle & 0x3ff; //1023
-  uint y = (m_obstacle >> 10) & 0x3ff;
-  uint z = m_obstacle >> 20;
+  const pba_voxel_t mask = (pba_voxel_t(1) << PBA_COORD_BITS) - 1;
+  uint x = m_obstacle & mask;
+  uint y = (m_obstacle >> PBA_COORD_BITS) & mask;
+  uint z = (m_obstacle >> (2 * PBA_COORD_BITS)) & mask;
   return Vector3ui(x, y, z);
 }
 
@@ -59,9 +60,9 @@ DistanceVoxel::DistanceVoxel() {} //default-initialise
 
 __host__ __device__
 DistanceVoxel::DistanceVoxel(const Vector3ui& o) {
-  m_obstacle = o.x;
-  m_obstacle |= o.y << 10;
-  m_obstacle |= o.z << 20;
+  m_obstacle = pba_voxel_t(o.x);
+  m_obstacle |= pba_voxel_t(o.y) << PBA_COORD_BITS;
+  m_obstacle |= pba_voxel_t(o.z) << (2 * PBA_COORD_BITS);
 }
 
 __host__ __device__
@@ -71,30 +72,30 @@ DistanceVoxel::DistanceVoxel(const pba_voxel_t o) {
 
 __host__ __device__
 DistanceVoxel::DistanceVoxel(const uint x, const uint y, const uint z) {
-  m_obstacle = x;
-  m_obstacle |= y << 10;
-  m_obstacle |= z << 20;
+  m_obstacle = pba_voxel_t(x);
+  m_obstacle |= pba_voxel_t(y) << PBA_COORD_BITS;
+  m_obstacle |= pba_voxel_t(z) << (2 * PBA_COORD_BITS);
 }
 
 __host__ __device__
 DistanceVoxel::DistanceVoxel(const uint3& o) {
-  m_obstacle = o.x;
-  m_obstacle |= o.y << 10;
-  m_obstacle |= o.z << 20;
+  m_obstacle = pba_voxel_t(o.x);
+  m_obstacle |= pba_voxel_t(o.y) << PBA_COORD_BITS;
+  m_obstacle |= pba_voxel_t(o.z) << (2 * PBA_COORD_BITS);
 }
 
 __host__ __device__
 void DistanceVoxel::setObstacle(const Vector3ui& o) {
-  m_obstacle = o.x;
-  m_obstacle |= o.y << 10;
-  m_obstacle |= o.z << 20;
+  m_obstacle = pba_voxel_t(o.x);
+  m_obstacle |= pba_voxel_t(o.y) << PBA_COORD_BITS;
+  m_obstacle |= pba_voxel_t(o.z) << (2 * PBA_COORD_BITS);
 }
 
 __host__ __device__
 void DistanceVoxel::setObstacle(const Vector3i& o) {
-  m_obstacle = o.x;
-  m_obstacle |= o.y << 10;
-  m_obstacle |= o.z << 20;
+  m_obstacle = pba_voxel_t(o.x);
+  m_obstacle |= pba_voxel_t(o.y) << PBA_COORD_BITS;
+  m_obstacle |= pba_voxel_t(o.z) << (2 * PBA_COORD_BITS);
 }
 
 __host__ __device__
@@ -130,9 +131,10 @@ void DistanceVoxel::insert(const Vector3ui& voxel_position, const uint32_t voxel
 __host__ __device__
 DistanceVoxel::operator uint3() const {
   uint3 t;
-  t.x =  m_obstacle & 1023;
-  t.y = (m_obstacle >> 10) & 1023;
-  t.z =  m_obstacle >> 20;
+  const Vector3ui obstacle = getObstacle();
+  t.x = obstacle.x;
+  t.y = obstacle.y;
+  t.z = obstacle.z;
   return t;
 }
 
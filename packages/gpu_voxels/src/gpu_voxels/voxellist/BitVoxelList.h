@@ -26,6 +26,7 @@
 
 #include <gpu_voxels/voxel/BitVoxel.h>
 #include <gpu_voxels/voxel/SVCollider.h>
+#include <gpu_voxels/helpers/CollisionQuery.h>
 #include <gpu_voxels/voxellist/TemplateVoxelList.h>
 #include <gpu_voxels/voxellist/CountingVoxelList.h>
 #include <cstddef>
@@ -111,14 +112,15 @@ class BitVoxelList : public TemplateVoxelList<BitVectorVoxel, VoxelIDType>,
     public CollidableWithBitVectorVoxelMap, public CollidableWithBitVectorVoxelList, public CollidableWithProbVoxelMap,
     public CollidableWithTypesBitVectorVoxelList, public CollidableWithTypesProbVoxelMap,
     public CollidableWithTypesBitVectorVoxelMap,
-    public CollidableWithBitcheckBitVectorVoxelList
+    public CollidableWithBitcheckBitVectorVoxelList, public CollidableWithMultipleMaps
 {
 public:
 
   // This can either represent a MORTON or Voxelmap Bitvector Voxel List:
   typedef BitVoxelList<BIT_VECTOR_LENGTH, VoxelIDType> TemplatedBitVectorVoxelList;
 
-  BitVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type);
+  BitVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type,
+               const MapBackend backend = MB_DEVICE);
 
   virtual ~BitVoxelList();
 
@@ -142,6 +144,7 @@ public:
   size_t collideWithTypes(const voxelmap::ProbVoxelMap* map, BitVectorVoxel& types_in_collision, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
   size_t collideWithTypes(const voxellist::BitVectorVoxelList* map, BitVectorVoxel& types_in_collision, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
   size_t collideWithTypes(const voxelmap::BitVectorVoxelMap *map, BitVectorVoxel &types_in_collision, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
+  bool collideWithMaps(const std::vector<GpuVoxelsMap*>& maps, std::vector<CollisionQueryResult>& results, float coll_threshold = 1.0);
   template< class Voxel>
   size_t collideWithTypeMask(const voxelmap::TemplateVoxelMap<Voxel> *map, const BitVectorVoxel& types_to_check, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
   size_t collideWithBitcheck(const voxellist::BitVectorVoxelList* map, const u_int8_t margin = 0, const Vector3i &offset = Vector3i());
@@ -183,6 +186,16 @@ private:
   void findMatchingVoxels(const TemplatedBitVectorVoxelList *list1, const CountingVoxelList *list2,
                           const Vector3i &offset, TemplatedBitVectorVoxelList* matching_voxels_list1) const;
 
+  /**
+   * @brief collisionCheckMaps Collides the list with all \a targets in one pass.
+   * Assure to lock the list and all maps before calling this function.
+   * \param targets Voxel maps of the dimensions of the reference map
+   * \param num_collisions Number of colliding voxels per target
+   * \param colliding_meanings OR of the bitvectors of the colliding list voxels per target
+   */
+  void collisionCheckMaps(const CollisionQueryTargets<BIT_VECTOR_LENGTH>& targets, float coll_threshold,
+                          uint32_t* num_collisions, BitVector<BIT_VECTOR_LENGTH>* colliding_meanings);
+
   thrust::device_vector< BitVectorVoxel > m_dev_colliding_bits_result_list;
   thrust::host_vector< BitVectorVoxel > m_colliding_bits_result_list;
   BitVectorVoxel* m_dev_bitmask;
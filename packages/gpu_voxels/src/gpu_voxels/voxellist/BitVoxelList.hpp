@@ -29,6 +29,7 @@
 //#include <gpu_voxels/voxelmap/ProbVoxelMap.hpp>
 #include <gpu_voxels/logging/logging_voxellist.h>
 #include <thrust/system_error.h>
+#include <algorithm>
 
 
 namespace gpu_voxels{
@@ -37,9 +38,17 @@ using namespace gpu_voxels::voxelmap;
 
 
 template<std::size_t length, class VoxelIDType>
-BitVoxelList<length, VoxelIDType>::BitVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type)
-  : TemplateVoxelList<BitVectorVoxel, VoxelIDType>(ref_map_dim, voxel_sidelength, map_type)
+BitVoxelList<length, VoxelIDType>::BitVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type,
+                                                const MapBackend backend)
+  : TemplateVoxelList<BitVectorVoxel, VoxelIDType>(ref_map_dim, voxel_sidelength, map_type, backend),
+    m_dev_bitmask(NULL)
 {
+  if (backend == MB_HOST)
+  {
+    // host lists reduce their collision results directly
+    return;
+  }
+
   // We already resize the result vector for Bitvector Checks
   m_dev_colliding_bits_result_list.resize(cMAX_NR_OF_BLOCKS);
   m_colliding_bits_result_list.resize(cMAX_NR_OF_BLOCKS);
@@ -92,8 +101,14 @@ size_t BitVoxelList<length, VoxelIDType>::collideWith(const BitVectorVoxelList *
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
-  thrust::device_vector<bool> collision_stencil(this->m_dev_id_list.size()); // Temporary data structure
-  collisions = this->collideVoxellists((TemplateVoxelList<BitVectorVoxel, VoxelIDType>*)other, offset, collision_stencil);
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return collisions;
+  }
+
+  // only the number of collisions is needed, so no stencil is written
+  collisions = this->intersectVoxellists((TemplateVoxelList<BitVectorVoxel, VoxelIDType>*)other, offset, NULL, false, NULL, NULL);
 
   return collisions;
 }
@@ -107,21 +122,15 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypes(const BitVectorVoxelL
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
-  //========== Search for Voxels at the same spot in both lists: ==============
-  TemplatedBitVectorVoxelList matching_voxels_list1(this->m_ref_map_dim, this->m_voxel_side_length, this->m_map_type);
-  TemplatedBitVectorVoxelList matching_voxels_list2(this->m_ref_map_dim, this->m_voxel_side_length, this->m_map_type);
-  findMatchingVoxels(this, other, 0, offset, &matching_voxels_list1, &matching_voxels_list2);
-
-  //========== Now iterate over both shortened lists and inspect the Bitvectors =============
-  thrust::device_vector< BitVectorVoxel> dev_merged_voxel_list(matching_voxels_list1.m_dev_id_list.size());
-  thrust::transform(matching_voxels_list1.m_dev_list.begin(), matching_voxels_list1.m_dev_list.end(),
-                    matching_voxels_list2.m_dev_list.begin(),
-                    dev_merged_voxel_list.begin(), BitVectorVoxel::reduce_op());
-
-
-  types_in_collision = thrust::reduce(dev_merged_voxel_list.begin(), dev_merged_voxel_list.end(),
-                                         BitVectorVoxel(), BitVectorVoxel::reduce_op());
-  return matching_voxels_list1.m_dev_id_list.size();
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  // Search for Voxels at the same spot in both lists and OR their bitvectors in the same pass
+  const BitVectorVoxel* this_voxel_list = this->m_backend == MB_HOST ? thrust::raw_pointer_cast(this->m_host_list.data())
+                                                                     : thrust::raw_pointer_cast(this->m_dev_list.data());
+  return this->intersectVoxellists(other, offset, NULL, false, this_voxel_list, &types_in_collision);
 }
 
 template<std::size_t length, class VoxelIDType>
@@ -138,6 +147,20 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypes(const BitVectorVoxelM
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    types_in_collision.bitVector().clear();
+    return hostCollideWithVoxelMapTypes(thrust::raw_pointer_cast(this->m_host_id_list.data()),
+                                        thrust::raw_pointer_cast(this->m_host_list.data()), (uint32_t)this->m_host_list.size(),
+                                        other->getConstDeviceDataPtr(), this->m_ref_map_dim, coll_threshold,
+                                        offset, types_in_collision);
+  }
+
   // get raw pointers to the thrust vectors data:
   BitVectorVoxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(this->m_dev_list.data());
   VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(this->m_dev_id_list.data());
@@ -186,6 +209,20 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypes(const ProbVoxelMap *m
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    types_in_collision.bitVector().clear();
+    return hostCollideWithVoxelMapTypes(thrust::raw_pointer_cast(this->m_host_id_list.data()),
+                                        thrust::raw_pointer_cast(this->m_host_list.data()), (uint32_t)this->m_host_list.size(),
+                                        other->getConstDeviceDataPtr(), this->m_ref_map_dim, coll_threshold,
+                                        offset, types_in_collision);
+  }
+
   // get raw pointers to the thrust vectors data:
   BitVectorVoxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(this->m_dev_list.data());
   VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(this->m_dev_id_list.data());
@@ -196,7 +233,7 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypes(const ProbVoxelMap *m
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
   size_t dynamic_shared_mem_size = sizeof(BitVectorVoxel) * cMAX_THREADS_PER_BLOCK;
   kernelCollideWithVoxelMap<<<num_blocks, threads_per_block, dynamic_shared_mem_size>>>(dev_id_list_ptr, dev_voxel_list_ptr, (uint32_t)this->m_dev_list.size(),
-                                                                  other->getDeviceDataPtr(), this->m_ref_map_dim, coll_threshold,
+                                                                  other->getConstDeviceDataPtr(), this->m_ref_map_dim, coll_threshold,
                                                                   offset, this->m_dev_collision_check_results_counter, m_dev_colliding_bits_result_list_ptr);
   CHECK_CUDA_ERROR();
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
@@ -217,6 +254,135 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypes(const ProbVoxelMap *m
   return number_of_collisions;
 }
 
+template<std::size_t length, class VoxelIDType>
+bool BitVoxelList<length, VoxelIDType>::collideWithMaps(const std::vector<GpuVoxelsMap*>& maps,
+                                                        std::vector<CollisionQueryResult>& results, float coll_threshold)
+{
+  results.assign(maps.size(), CollisionQueryResult());
+  bool all_checked = true;
+
+  // Voxel maps are checked in one pass over this list, all other maps one after another.
+  std::vector<size_t> fused_maps;
+  for (size_t i = 0; i < maps.size(); ++i)
+  {
+    GpuVoxelsMap* map = maps[i];
+    CollisionQueryResult& result = results[i];
+    if (map != NULL && (map->is<BitVectorVoxelMap>() || map->is<ProbVoxelMap>())
+        && this->m_map_type == MT_BITVECTOR_VOXELLIST)
+    {
+      // Map Dims have to be equal to be able to compare pointer adresses!
+      if (map->getDimensions() != this->m_ref_map_dim || map->getBackend() != this->m_backend)
+      {
+        LOGGING_ERROR_C(VoxellistLog, BitVoxelList, "Map " << i << " differs in dimensions or backend. Not checking collisions!" << endl);
+        result.num_collisions = SSIZE_MAX;
+        all_checked = false;
+      }
+      else
+      {
+        fused_maps.push_back(i);
+      }
+    }
+    else if (map != NULL && map->is<BitVectorVoxelList>())
+    {
+      result.num_collisions = collideWithTypes(map->as<BitVectorVoxelList>(), result.types_in_collision, coll_threshold);
+    }
+    else if (CollidableWithTypesBitVectorVoxelList* other = dynamic_cast<CollidableWithTypesBitVectorVoxelList*>(map))
+    {
+      if (this->m_map_type == MT_BITVECTOR_VOXELLIST)
+      {
+        result.num_collisions = other->collideWithTypes((BitVectorVoxelList*)this, result.types_in_collision, coll_threshold);
+      }
+      else
+      {
+        LOGGING_ERROR_C(VoxellistLog, BitVoxelList, "Map " << i << " can not be collided with a Morton list. " << GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+        result.num_collisions = SSIZE_MAX;
+        all_checked = false;
+      }
+    }
+    else
+    {
+      LOGGING_ERROR_C(VoxellistLog, BitVoxelList, "Map " << i << " can not be collided with a BitVoxelList. " << GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+      result.num_collisions = SSIZE_MAX;
+      all_checked = false;
+    }
+  }
+
+  for (size_t first = 0; first < fused_maps.size(); first += cMAX_COLLISION_QUERY_MAPS)
+  {
+    CollisionQueryTargets<BIT_VECTOR_LENGTH> targets;
+    targets.num_maps = std::min<size_t>(cMAX_COLLISION_QUERY_MAPS, fused_maps.size() - first);
+    std::vector<const GpuVoxelsMap*> locked_maps(1, this);
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      GpuVoxelsMap* map = maps[fused_maps[first + m]];
+      targets.bit_maps[m] = map->is<BitVectorVoxelMap>() ? map->as<BitVectorVoxelMap>()->getConstDeviceDataPtr() : NULL;
+      targets.prob_maps[m] = map->is<ProbVoxelMap>() ? map->as<ProbVoxelMap>()->getConstDeviceDataPtr() : NULL;
+      locked_maps.push_back(map);
+    }
+
+    std::vector<uint32_t> num_collisions(targets.num_maps, 0);
+    std::vector<BitVector<BIT_VECTOR_LENGTH> > colliding_meanings(targets.num_maps);
+    {
+      MultiMapLock lock(locked_maps);
+      collisionCheckMaps(targets, coll_threshold, &num_collisions[0], &colliding_meanings[0]);
+    }
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      CollisionQueryResult& result = results[fused_maps[first + m]];
+      result.num_collisions = num_collisions[m];
+      result.types_in_collision.bitVector() = colliding_meanings[m];
+    }
+  }
+  return all_checked;
+}
+
+template<std::size_t length, class VoxelIDType>
+void BitVoxelList<length, VoxelIDType>::collisionCheckMaps(const CollisionQueryTargets<BIT_VECTOR_LENGTH>& targets, float coll_threshold,
+                                                           uint32_t* num_collisions, BitVector<BIT_VECTOR_LENGTH>* colliding_meanings)
+{
+  if (this->m_backend == MB_HOST)
+  {
+    hostCollideWithVoxelMaps(thrust::raw_pointer_cast(this->m_host_id_list.data()),
+                             thrust::raw_pointer_cast(this->m_host_list.data()), (uint32_t)this->m_host_list.size(),
+                             targets, coll_threshold, num_collisions, colliding_meanings);
+    return;
+  }
+  if (this->m_dev_list.empty())
+  {
+    return;
+  }
+
+  const uint32_t list_size = this->m_dev_list.size();
+  const uint32_t threads_per_block = cCOLLISION_QUERY_THREADS_PER_BLOCK;
+  const uint32_t num_blocks = std::min((list_size + threads_per_block - 1) / threads_per_block,
+                                       cCOLLISION_QUERY_MAX_BLOCKS);
+  const uint32_t num_results = num_blocks * cMAX_COLLISION_QUERY_MAPS;
+
+  thrust::device_vector<uint32_t> dev_num_collisions(num_results);
+  thrust::device_vector<BitVector<BIT_VECTOR_LENGTH> > dev_colliding_meanings(num_results);
+
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  size_t dynamic_shared_mem_size = sizeof(BitVector<BIT_VECTOR_LENGTH>) * threads_per_block;
+  kernelCollideWithVoxelMaps<<<num_blocks, threads_per_block, dynamic_shared_mem_size>>>(
+      thrust::raw_pointer_cast(this->m_dev_id_list.data()), thrust::raw_pointer_cast(this->m_dev_list.data()),
+      list_size, targets, coll_threshold, thrust::raw_pointer_cast(dev_num_collisions.data()),
+      thrust::raw_pointer_cast(dev_colliding_meanings.data()));
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+
+  // Copy back the results and reduce the block results:
+  thrust::host_vector<uint32_t> block_num_collisions = dev_num_collisions;
+  thrust::host_vector<BitVector<BIT_VECTOR_LENGTH> > block_colliding_meanings = dev_colliding_meanings;
+  for (uint32_t b = 0; b < num_blocks; ++b)
+  {
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      num_collisions[m] += block_num_collisions[b * cMAX_COLLISION_QUERY_MAPS + m];
+      colliding_meanings[m] |= block_colliding_meanings[b * cMAX_COLLISION_QUERY_MAPS + m];
+    }
+  }
+}
+
 template<std::size_t length, class VoxelIDType>
 template<class Voxel>
 size_t BitVoxelList<length, VoxelIDType>::collideWithTypeMask(const TemplateVoxelMap<Voxel> *map,
@@ -233,6 +399,19 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithTypeMask(const TemplateVoxe
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(map->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != map->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return hostCollideWithVoxelMapBitMask(thrust::raw_pointer_cast(this->m_host_id_list.data()),
+                                          thrust::raw_pointer_cast(this->m_host_list.data()), (uint32_t)this->m_host_list.size(),
+                                          map->getConstDeviceDataPtr(), this->m_ref_map_dim, coll_threshold,
+                                          offset, types_to_check);
+  }
+
   // get raw pointers to the thrust vectors data:
   BitVectorVoxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(this->m_dev_list.data());
   VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(this->m_dev_id_list.data());
@@ -273,6 +452,33 @@ size_t BitVoxelList<length, VoxelIDType>::collideWithBitcheck(const BitVectorVox
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    if(offset != Vector3i(0))
+    {
+      LOGGING_ERROR_C(VoxellistLog, BitVoxelList, "Offset for VoxelList operation not supported! Result is undefined." << endl);
+      return SSIZE_MAX;
+    }
+    const VoxelIDType* this_ids = thrust::raw_pointer_cast(this->m_host_id_list.data());
+    const BitVectorVoxel* this_voxels = thrust::raw_pointer_cast(this->m_host_list.data());
+    const VoxelIDType* other_ids = thrust::raw_pointer_cast(other->m_host_id_list.data());
+    const BitVectorVoxel* other_voxels = thrust::raw_pointer_cast(other->m_host_list.data());
+    // only use the slower collision comperator, if a bitmarking was set!
+    if(margin == 0)
+    {
+      return hostCollideMatchingVoxels(this_ids, this_voxels, (uint32_t)this->m_host_id_list.size(),
+                                       other_ids, other_voxels, (uint32_t)other->m_host_id_list.size(), BitvectorCollision());
+    }
+    return hostCollideMatchingVoxels(this_ids, this_voxels, (uint32_t)this->m_host_id_list.size(),
+                                     other_ids, other_voxels, (uint32_t)other->m_host_id_list.size(),
+                                     BitvectorCollisionWithBitshift(margin, 0));
+  }
+
   //========== Search for Voxels at the same spot in both lists: ==============
   TemplatedBitVectorVoxelList matching_voxels_list1(this->m_ref_map_dim, this->m_voxel_side_length, this->m_map_type);
   TemplatedBitVectorVoxelList matching_voxels_list2(this->m_ref_map_dim, this->m_voxel_side_length, this->m_map_type);
@@ -302,6 +508,32 @@ size_t BitVoxelList<length, VoxelIDType>::collideCountingPerMeaning(const GpuVox
                                                            std::vector<size_t>&  collisions_per_meaning,
                                                            const Vector3i &offset_)
 {
+  if (this->m_backend != other_->getBackend())
+  {
+    // Counting lists only exist on the device, so they always end up here for host lists.
+    LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    if (other_->getMapType() != MT_BITVECTOR_VOXELLIST || offset_ != Vector3i(0))
+    {
+      LOGGING_ERROR_C(VoxellistLog, BitVoxelList, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+      return SSIZE_MAX;
+    }
+    TemplatedBitVectorVoxelList* other = dynamic_cast<TemplatedBitVectorVoxelList*>(other_.get());
+
+    boost::lock(this->m_mutex, other->m_mutex);
+    lock_guard guard(this->m_mutex, boost::adopt_lock);
+    lock_guard guard2(other->m_mutex, boost::adopt_lock);
+
+    assert(collisions_per_meaning.size() == BIT_VECTOR_LENGTH);
+    return hostCountMatchingMeanings(thrust::raw_pointer_cast(this->m_host_id_list.data()),
+                                     thrust::raw_pointer_cast(this->m_host_list.data()), (uint32_t)this->m_host_id_list.size(),
+                                     thrust::raw_pointer_cast(other->m_host_id_list.data()),
+                                     (uint32_t)other->m_host_id_list.size(), collisions_per_meaning);
+  }
+
   try
   {
     switch (other_->getMapType())
@@ -568,6 +800,14 @@ void BitVoxelList<length, VoxelIDType>::shiftLeftSweptVolumeIDs(uint8_t shift_si
 
   lock_guard guard(this->m_mutex);
 
+  if (this->m_backend == MB_HOST)
+  {
+    thrust::transform(this->m_host_list.begin(), this->m_host_list.end(),
+                      this->m_host_list.begin(),
+                      ShiftBitvector(shift_size));
+    return;
+  }
+
   try
   {
     thrust::transform(this->m_dev_list.begin(), this->m_dev_list.end(),
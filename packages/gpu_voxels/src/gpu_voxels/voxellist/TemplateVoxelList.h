@@ -28,6 +28,7 @@
 
 #include <gpu_voxels/voxellist/AbstractVoxelList.h>
 #include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/helpers/MapFile.h>
 #include <gpu_voxels/vis_interface/VisualizerInterface.h>
 
 #include <gpu_voxels/voxel/DefaultCollider.h>
@@ -35,6 +36,7 @@
 #include <gpu_voxels/voxelmap/ProbVoxelMap.h>
 
 #include <thrust/device_vector.h>
+#include <thrust/host_vector.h>
 #include <thrust/device_ptr.h>
 
 
@@ -63,7 +65,17 @@ public:
   typedef thrust::tuple<keyIterator, coordIterator, voxelIterator> keyCoordVoxelIteratorTriple;
   typedef thrust::zip_iterator<keyCoordVoxelIteratorTriple> keyCoordVoxelZipIterator;
 
-  TemplateVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type);
+  typedef thrust::tuple<typename thrust::host_vector<VoxelIDType>::iterator,
+                        typename thrust::host_vector<Vector3ui>::iterator,
+                        typename thrust::host_vector<Voxel>::iterator> keyCoordVoxelHostIteratorTriple;
+  typedef thrust::zip_iterator<keyCoordVoxelHostIteratorTriple> keyCoordVoxelHostZipIterator;
+
+  /*!
+   * \param backend Where the list lives. With MB_HOST the list content is kept in
+   * the m_host_* vectors and all operations are carried out on the CPU.
+   */
+  TemplateVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type,
+                    const MapBackend backend = MB_DEVICE);
 
   //! Destructor
   virtual ~TemplateVoxelList();
@@ -122,6 +134,15 @@ public:
 
   virtual void insertPointCloud(const Vector3f* points_d, uint32_t size, const BitVoxelMeaning voxel_meaning);
 
+  /**
+   * @brief insertDownsampledPointCloud Inserts one voxel per occupied voxel of the cloud instead of one per point.
+   * Counting voxel lists get the number of points per voxel, saturated at the maximum count.
+   * Points outside the reference map are dropped.
+   */
+  virtual void insertDownsampledPointCloud(const std::vector<Vector3f> &points, const BitVoxelMeaning voxel_meaning);
+
+  virtual void insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning);
+
   /**
    * @brief insertMetaPointCloud Inserts a MetaPointCloud into the map.
    * @param meta_point_cloud The MetaPointCloud to insert
@@ -157,8 +178,15 @@ public:
   virtual void clearMap();
   //! set voxel occupancies for a specific voxelmeaning to zero
 
+  //! Writes the list as raw map file, see helpers/MapFile.h
   virtual bool writeToDisk(const std::string path);
 
+  /*! Writes the list with the given encoding. The file holds the voxels, followed
+   *  by their ids and coordinates. Run length encoding shrinks lists whose voxels
+   *  hold equal values. */
+  virtual bool writeToDisk(const std::string path, const file_handling::MapFileEncoding encoding);
+
+  //! Reads map files as well as files of the legacy unversioned format
   virtual bool readFromDisk(const std::string path);
 
   virtual Vector3ui getDimensions() const;
@@ -176,7 +204,9 @@ public:
   /**
    * @brief collideVoxellists Internal binary search between voxellists
    * @param other Other Voxellist
-   * @param offset Offset of other map to this map
+   * @param offset Offset of other map to this map. Like in the voxelmap collisions, the voxel
+   * at coordinates c of this list is checked against the voxel at c + offset of the other list.
+   * Voxels that are shifted out of the reference map do not collide.
    * @param collision_stencil Binary vector storing the collisions. Has to be the size of 'this'
    * @return Number of collisions
    */
@@ -250,10 +280,64 @@ public:
   thrust::device_vector<VoxelIDType> m_dev_id_list;  // contains the voxel adresses / morton codes (This can not be a Voxel*, as Thrust can not sort pointers)
   thrust::device_vector<Vector3ui> m_dev_coord_list; // contains the voxel metric coordinates
   thrust::device_vector<Voxel> m_dev_list;           // contains the actual data: bitvector or probability
+
+  /* ======== Variables with content on host (only used with MB_HOST backend) ======== */
+  thrust::host_vector<VoxelIDType> m_host_id_list;
+  thrust::host_vector<Vector3ui> m_host_coord_list;
+  thrust::host_vector<Voxel> m_host_list;
 protected:
 
   virtual void make_unique();
 
+  //! Sorts the given vectors by their keys, merges voxels with equal keys and drops the duplicates
+  template<class IdVector, class CoordVector, class VoxelVector>
+  void makeUnique(IdVector& id_list, CoordVector& coord_list, VoxelVector& voxel_list);
+
+  /*! Appends one voxel per point behind the current entries without making the list unique.
+   *  Returns the index of the first new entry. The list has to be locked by the caller. */
+  uint32_t appendPointCloud(const Vector3f* points_d, uint32_t size, const BitVoxelMeaning voxel_meaning);
+
+  /*! Reduces \a points to one point per voxel and inserts them. All vectors are thrust vectors in the memory
+   *  of the backend, \a voxel_list is the voxel vector of this list. The list has to be locked by the caller. */
+  template<class PointVector, class KeyVector, class VoxelVector>
+  void insertVoxelizedPoints(PointVector& points, KeyVector& voxel_keys, KeyVector& point_counts,
+                             VoxelVector& voxel_list, const BitVoxelMeaning voxel_meaning);
+
+  //! Host version of collideVoxellists() for lists with the MB_HOST backend
+  size_t collideVoxellistsHost(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other,
+                               thrust::host_vector<bool>& collision_stencil,
+                               const Vector3i &offset = Vector3i()) const;
+
+  /**
+   * @brief intersectVoxellists Intersects the sorted keys of this list with the keys of \a other in one pass
+   * on the backend of the lists. Assure to lock both lists before calling this function.
+   * @param offset Offset of other map to this map, see collideVoxellists()
+   * @param stencil Optional, marks the voxels of this list that are contained in \a other.
+   * Has to be the size of 'this' and lie in the memory of the backend.
+   * @param stencil_is_mask If true, only voxels with a true \a stencil entry are counted
+   * @param this_voxel_list Optional bitvectors of this list in the memory of the backend. If given,
+   * the bitvectors of the colliding voxels of both lists are ORed into \a types_in_collision.
+   * @return Number of collisions
+   */
+  size_t intersectVoxellists(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other, const Vector3i &offset,
+                             bool* stencil, bool stencil_is_mask, const BitVectorVoxel* this_voxel_list,
+                             BitVectorVoxel* types_in_collision) const;
+
+  //! intersectVoxellists() with the keys of this list delivered by \a key_operator
+  template<class KeyOperator>
+  size_t intersectVoxellists(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other, const KeyOperator &key_operator,
+                             bool* stencil, bool stencil_is_mask, const BitVectorVoxel* this_voxel_list,
+                             BitVectorVoxel* types_in_collision) const;
+
+  //! Host version of insertMetaPointCloud() that works on the host copies of the clouds
+  void insertMetaPointCloudHost(const MetaPointCloud &meta_point_cloud, const std::vector<BitVoxelMeaning>& voxel_meanings);
+
+  //! Loads a file in the legacy format, the list has to be locked by the caller
+  bool readLegacyFile(const std::string& path);
+
+  //! Removes all entries of the host vectors that are marked in \a stencil
+  void removeFromHostList(const thrust::host_vector<bool>& stencil);
+
   /* ======== Variables with content on host ======== */
   float m_voxel_side_length;
   Vector3ui m_ref_map_dim;
@@ -272,6 +356,10 @@ protected:
 
   //! result array for collision check with counter on device
   uint16_t* m_dev_collision_check_results_counter;
+
+  //! block results of the sorted list intersection on device
+  uint32_t* m_dev_intersection_results_counter;
+  BitVectorVoxel* m_dev_intersection_results_types;
 };
 
 } // end of namespace voxellist
@@ -22,10 +22,17 @@
 //----------------------------------------------------------------------
 
 #include "TemplateVoxelList.h"
+#include <algorithm>
 #include <fstream>
+#include <cstring>
 #include <gpu_voxels/logging/logging_voxellist.h>
 #include <gpu_voxels/voxellist/kernels/VoxelListOperations.hpp>
+#include <gpu_voxels/voxellist/kernels/VoxelListOperationsHost.hpp>
+#include <gpu_voxels/voxelmap/kernels/PointCloudVoxelization.hpp>
+#include <gpu_voxels/voxel/CountingVoxel.h>
 #include <thrust/execution_policy.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/zip_iterator.h>
 #include <thrust/unique.h>
 #include <thrust/pair.h>
 #include <thrust/tuple.h>
@@ -33,6 +40,7 @@
 #include <thrust/sort.h>
 #include <thrust/remove.h>
 #include <thrust/binary_search.h>
+#include <thrust/host_vector.h>
 #include <thrust/system_error.h>
 
 namespace gpu_voxels {
@@ -89,13 +97,116 @@ struct applyOffsetOperator : public thrust::unary_function<thrust::tuple<Vector3
   }
 };
 
+//! Linear addresses are shifted arithmetically, which keeps their order. Voxels outside of the map would alias.
+__host__ __device__ inline
+bool offsetVoxelID(MapVoxelID &id, const Vector3ui &ref_map_dim, const Vector3i &shifted_coords, const int32_t addr_offset)
+{
+  if (shifted_coords.x < 0 || shifted_coords.y < 0 || shifted_coords.z < 0
+      || shifted_coords.x >= int32_t(ref_map_dim.x) || shifted_coords.y >= int32_t(ref_map_dim.y)
+      || shifted_coords.z >= int32_t(ref_map_dim.z))
+  {
+    return false;
+  }
+  id += addr_offset;
+  return true;
+}
+
+//! Morton codes interleave the coordinate bits, so they have to be encoded again.
+__host__ __device__ inline
+bool offsetVoxelID(OctreeVoxelID &id, const Vector3ui &ref_map_dim, const Vector3i &shifted_coords, const int32_t addr_offset)
+{
+  if (shifted_coords.x < 0 || shifted_coords.y < 0 || shifted_coords.z < 0)
+  {
+    return false;
+  }
+  id = NTree::morton_code60(uint32_t(shifted_coords.x), uint32_t(shifted_coords.y), uint32_t(shifted_coords.z));
+  return true;
+}
+
+// Sets the number of points of a downsampled cloud that fell into a voxel.
+// Only counting voxels store it, all other voxel types stay unchanged.
+template<class Voxel>
+__host__ __device__
+void setPointCount(Voxel &voxel, const uint32_t count)
+{
+}
+
+__host__ __device__
+inline void setPointCount(CountingVoxel &voxel, const uint32_t count)
+{
+  // saturate instead of wrapping around the int8_t counter
+  voxel.count() = int8_t(count < 127 ? count : 127);
+}
+
+// Thrust operator applyPointCountOperator:
+// Applies setPointCount() to tuples of a voxel and its point count.
+template<class Voxel>
+struct applyPointCountOperator
+{
+  template<class Tuple>
+  __host__ __device__
+  void operator()(Tuple t) const
+  {
+    Voxel voxel = thrust::get<0>(t);
+    setPointCount(voxel, thrust::get<1>(t));
+    thrust::get<0>(t) = voxel;
+  }
+};
+
+// Key operator idKeyOperator for intersectSortedRange():
+// Delivers the key of the voxel itself.
+template<class VoxelIDType>
+struct idKeyOperator
+{
+  __host__ __device__
+  VoxelIDType operator()(const Vector3ui &coords, const VoxelIDType id) const
+  {
+    return id;
+  }
+};
+
+// Key operator offsetKeyOperator for intersectSortedRange():
+// Delivers the key of the voxel at coordinates + offset. Voxels that are shifted out
+// of the map get an invalid key, which is not contained in any list.
+template<class VoxelIDType>
+struct offsetKeyOperator
+{
+  Vector3ui ref_map_dim;
+  Vector3i coord_offset;
+  int32_t addr_offset;
+  offsetKeyOperator(const Vector3ui &ref_map_dim_, const Vector3i &offset)
+  {
+    ref_map_dim = ref_map_dim_;
+    coord_offset = offset;
+    addr_offset = voxelmap::getVoxelIndexSigned(ref_map_dim_, offset);
+  }
+
+  __host__ __device__
+  VoxelIDType operator()(const Vector3ui &coords, VoxelIDType id) const
+  {
+    const Vector3i shifted_coords(int32_t(coords.x) + coord_offset.x, int32_t(coords.y) + coord_offset.y,
+                                  int32_t(coords.z) + coord_offset.z);
+    if (!offsetVoxelID(id, ref_map_dim, shifted_coords, addr_offset))
+    {
+      return ~VoxelIDType(0);
+    }
+    return id;
+  }
+};
+
 
 template<class Voxel, class VoxelIDType>
-TemplateVoxelList<Voxel, VoxelIDType>::TemplateVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type)
+TemplateVoxelList<Voxel, VoxelIDType>::TemplateVoxelList(const Vector3ui ref_map_dim, const float voxel_sidelength, const MapType map_type,
+                                                         const MapBackend backend)
   : m_voxel_side_length(voxel_sidelength),
-    m_ref_map_dim(ref_map_dim)
+    m_ref_map_dim(ref_map_dim),
+    m_dev_collision_check_results(NULL),
+    m_dev_collision_check_results_counter(NULL),
+    m_dev_intersection_results_counter(NULL),
+    m_dev_intersection_results_types(NULL)
 {
   this->m_map_type = map_type;
+  this->m_backend = backend;
 
   m_collision_check_results = new bool[cMAX_NR_OF_BLOCKS];
   m_collision_check_results_counter = new uint16_t[cMAX_NR_OF_BLOCKS];
@@ -107,9 +218,19 @@ TemplateVoxelList<Voxel, VoxelIDType>::TemplateVoxelList(const Vector3ui ref_map
     m_collision_check_results_counter[i] = 0;
   }
 
+  if (this->m_backend == MB_HOST)
+  {
+    // host lists evaluate collisions without block wise result arrays
+    return;
+  }
+
   HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_dev_collision_check_results, cMAX_NR_OF_BLOCKS * sizeof(bool)));
   HANDLE_CUDA_ERROR(
       cudaMalloc((void** )&m_dev_collision_check_results_counter, cMAX_NR_OF_BLOCKS * sizeof(uint16_t)));
+  HANDLE_CUDA_ERROR(
+      cudaMalloc((void** )&m_dev_intersection_results_counter, cINTERSECTION_MAX_BLOCKS * sizeof(uint32_t)));
+  HANDLE_CUDA_ERROR(
+      cudaMalloc((void** )&m_dev_intersection_results_types, cINTERSECTION_MAX_BLOCKS * sizeof(BitVectorVoxel)));
 
   // copy initialized arrays to device
   HANDLE_CUDA_ERROR(
@@ -125,8 +246,14 @@ TemplateVoxelList<Voxel, VoxelIDType>::~TemplateVoxelList()
 {
   delete[] m_collision_check_results;
   delete[] m_collision_check_results_counter;
+  if (this->m_backend == MB_HOST)
+  {
+    return;
+  }
   HANDLE_CUDA_ERROR(cudaFree(m_dev_collision_check_results));
   HANDLE_CUDA_ERROR(cudaFree(m_dev_collision_check_results_counter));
+  HANDLE_CUDA_ERROR(cudaFree(m_dev_intersection_results_counter));
+  HANDLE_CUDA_ERROR(cudaFree(m_dev_intersection_results_types));
 }
 
 
@@ -140,30 +267,33 @@ TemplateVoxelList<Voxel, VoxelIDType>::~TemplateVoxelList()
  */
 template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::make_unique()
+{
+  if (this->m_backend == MB_HOST)
+  {
+    makeUnique(m_host_id_list, m_host_coord_list, m_host_list);
+  }
+  else
+  {
+    makeUnique(m_dev_id_list, m_dev_coord_list, m_dev_list);
+  }
+}
+
+/*!
+ * The thrust algorithms dispatch on the vector types, so this runs on the GPU
+ * for device_vectors and on the CPU for host_vectors.
+ */
+template<class Voxel, class VoxelIDType>
+template<class IdVector, class CoordVector, class VoxelVector>
+void TemplateVoxelList<Voxel, VoxelIDType>::makeUnique(IdVector& id_list, CoordVector& coord_list, VoxelVector& voxel_list)
 {
   // Sort all entries by key.
   try
   {
-    LOGGING_DEBUG_C(VoxellistLog, TemplateVoxelList, "List size before make_unique: " << m_dev_list.size() << endl);
-
-
-//    thrust::host_vector<VoxelIDType> dev_id_list_h(m_dev_id_list);
-//    thrust::host_vector<Vector3ui> dev_coord_list_h(m_dev_coord_list);
-
+    LOGGING_DEBUG_C(VoxellistLog, TemplateVoxelList, "List size before make_unique: " << voxel_list.size() << endl);
 
-//    for(uint i = 0; i < dev_id_list_h.size(); i++)
-//    {
-//        if(i%10 == 0)
-//        {
-//            std::cout << "ID: " << dev_id_list_h[i] << std::endl <<
-//                         "Coord List: [" << dev_coord_list_h[i].x << ", " << dev_coord_list_h[i].y << ", " << dev_coord_list_h[i].z << "]" << std::endl;
-//        }
-//    }
-
-
-    // the ZipIterator represents the data that is sorted by the keys in m_dev_id_list
-    thrust::sort_by_key(m_dev_id_list.begin(), m_dev_id_list.end(),
-                        thrust::make_zip_iterator( thrust::make_tuple(m_dev_coord_list.begin(),m_dev_list.begin()) ),
+    // the ZipIterator represents the data that is sorted by the keys in id_list
+    thrust::sort_by_key(id_list.begin(), id_list.end(),
+                        thrust::make_zip_iterator( thrust::make_tuple(coord_list.begin(), voxel_list.begin()) ),
                         thrust::less<VoxelIDType>());
 
   }
@@ -178,9 +308,9 @@ void TemplateVoxelList<Voxel, VoxelIDType>::make_unique()
   {
     // Reverse iterate over sorted entries and merge successive voxel-bitvectors into the predecessor
     // of voxels with the same key. We dont touch the coordinates as they are the same either.
-    thrust::inclusive_scan( thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(m_dev_id_list.end(), m_dev_list.end()) ) ),
-                            thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(m_dev_id_list.begin(), m_dev_list.begin()) ) ),
-                            thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(m_dev_id_list.end(), m_dev_list.end()) ) ),
+    thrust::inclusive_scan( thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(id_list.end(), voxel_list.end()) ) ),
+                            thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(id_list.begin(), voxel_list.begin()) ) ),
+                            thrust::make_reverse_iterator( thrust::make_zip_iterator( thrust::make_tuple(id_list.end(), voxel_list.end()) ) ),
                             Merge<Voxel, VoxelIDType>() );
   }
   catch(thrust::system_error &e)
@@ -192,11 +322,9 @@ void TemplateVoxelList<Voxel, VoxelIDType>::make_unique()
   // This will remove successors and keep the first entry with the merged bitvectors.
   try
   {
-    thrust::pair< keyIterator, zipValuesIterator > new_end;
-    new_end = thrust::unique_by_key(m_dev_id_list.begin(), m_dev_id_list.end(),
-                                    thrust::make_zip_iterator( thrust::make_tuple(m_dev_coord_list.begin(),m_dev_list.begin()) ) );
-
-    size_t new_length = thrust::distance(m_dev_id_list.begin(), new_end.first);
+    size_t new_length = thrust::distance(id_list.begin(),
+                                         thrust::unique_by_key(id_list.begin(), id_list.end(),
+                                                               thrust::make_zip_iterator( thrust::make_tuple(coord_list.begin(), voxel_list.begin()) ) ).first);
     this->resize(new_length);
   }
   catch(thrust::system_error &e)
@@ -204,7 +332,7 @@ void TemplateVoxelList<Voxel, VoxelIDType>::make_unique()
     LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Caught Thrust exception while dropping duplicates: " << e.what() << endl);
     exit(-1);
   }
-  LOGGING_DEBUG_C(VoxellistLog, TemplateVoxelList, "List size after make_unique: " << m_dev_list.size() << endl);
+  LOGGING_DEBUG_C(VoxellistLog, TemplateVoxelList, "List size after make_unique: " << voxel_list.size() << endl);
 }
 
 template<class Voxel, class VoxelIDType>
@@ -215,15 +343,6 @@ size_t TemplateVoxelList<Voxel, VoxelIDType>::collideVoxellists(const TemplateVo
   return 0;
 }
 
-struct logicalAND{
-
-  __host__ __device__
-  bool operator()(bool a, bool b)
-  {
-    return a && b;
-  }
-};
-
 template<class Voxel, class VoxelIDType>
 size_t TemplateVoxelList<Voxel, VoxelIDType>::collideVoxellists(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other,
                                                                 const Vector3i &offset, thrust::device_vector<bool>& collision_stencil) const
@@ -232,58 +351,139 @@ size_t TemplateVoxelList<Voxel, VoxelIDType>::collideVoxellists(const TemplateVo
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
-  // searching for the elements of "other" in "this". Therefore stencil has to be the size of "this"
-  try
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return 0;
+  }
+  if (this->m_backend == MB_HOST)
   {
-    //will contain a stencil of elements that should be considered for collision checking
-    //TODO: initialise to empty if not CVL
-    thrust::device_vector<bool> filtermask_device(collision_stencil.size());
+    thrust::host_vector<bool> host_stencil(collision_stencil.size());
+    size_t num_collisions = collideVoxellistsHost(other, host_stencil, offset);
+    collision_stencil = host_stencil;
+    return num_collisions;
+  }
 
-    // if offset is given, we need our own comparison opperator which is a lot slower than the comparison on built in datatypes!
-    // See: http://stackoverflow.com/questions/9037906/fast-cuda-thrust-custom-comparison-operator
-    if(offset != Vector3i(0))
-    {
-      LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Offset for VoxelList collision not supported! Not performing collision check." << endl);
-      return 0;
-    }else{
+  // Searching for the elements of "this" in "other". Therefore stencil has to be the size of "this".
+  // Only the counting voxellist uses the collision_stencil as a filter mask for the counted collisions,
+  // the stencil itself marks all voxels in collision, because it is used in the subtract methods.
+  return intersectVoxellists(other, offset, thrust::raw_pointer_cast(collision_stencil.data()),
+                             this->m_map_type == MT_COUNTING_VOXELLIST, NULL, NULL);
+}
 
-      //only the counting voxellist implements the collision_stencil as a filter mask
-      if (this->m_map_type == MT_COUNTING_VOXELLIST)
-      //if the collision_stencil contains a true value it will be treated as a filter mask
-      {
-        thrust::copy(collision_stencil.begin(), collision_stencil.end(), filtermask_device.begin());
-      }
+template<class Voxel, class VoxelIDType>
+size_t TemplateVoxelList<Voxel, VoxelIDType>::collideVoxellistsHost(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other,
+                                                                    thrust::host_vector<bool>& collision_stencil,
+                                                                    const Vector3i &offset) const
+{
+  // The filtermask of CountingVoxelLists is not needed here, as they are only available on the device.
+  return intersectVoxellists(other, offset, thrust::raw_pointer_cast(collision_stencil.data()), false, NULL, NULL);
+}
 
-      thrust::binary_search(thrust::device,
-                            other->m_dev_id_list.begin(), other->m_dev_id_list.end(),
-                            m_dev_id_list.begin(), m_dev_id_list.end(),
-                            collision_stencil.begin());
-    }
+template<class Voxel, class VoxelIDType>
+size_t TemplateVoxelList<Voxel, VoxelIDType>::intersectVoxellists(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other,
+                                                                  const Vector3i &offset, bool* stencil, bool stencil_is_mask,
+                                                                  const BitVectorVoxel* this_voxel_list,
+                                                                  BitVectorVoxel* types_in_collision) const
+{
+  if (offset != Vector3i(0))
+  {
+    return intersectVoxellists(other, offsetKeyOperator<VoxelIDType>(m_ref_map_dim, offset), stencil, stencil_is_mask,
+                               this_voxel_list, types_in_collision);
+  }
+  return intersectVoxellists(other, idKeyOperator<VoxelIDType>(), stencil, stencil_is_mask,
+                             this_voxel_list, types_in_collision);
+}
 
-    if (this->m_map_type == MT_COUNTING_VOXELLIST)
-    { // is used to count the collisions, without overriding the collision_stencil, because it is used in the subtract methods
-      thrust::device_vector<bool> count_device(collision_stencil.size());
+template<class Voxel, class VoxelIDType>
+template<class KeyOperator>
+size_t TemplateVoxelList<Voxel, VoxelIDType>::intersectVoxellists(const TemplateVoxelList<BitVectorVoxel, VoxelIDType> *other,
+                                                                  const KeyOperator &key_operator, bool* stencil, bool stencil_is_mask,
+                                                                  const BitVectorVoxel* this_voxel_list,
+                                                                  BitVectorVoxel* types_in_collision) const
+{
+  if (types_in_collision != NULL)
+  {
+    types_in_collision->bitVector().clear();
+  }
 
-      //TODO: why does this not zero out all collisions in case of CVL.subtractFromCVL(BVL)?
-      thrust::transform(collision_stencil.begin(), collision_stencil.end(), filtermask_device.begin(), count_device.begin(), logicalAND());
+  if (this->m_backend == MB_HOST)
+  {
+    return hostIntersectSortedLists(thrust::raw_pointer_cast(m_host_coord_list.data()),
+                                    thrust::raw_pointer_cast(m_host_id_list.data()), this_voxel_list,
+                                    (uint32_t)m_host_id_list.size(),
+                                    thrust::raw_pointer_cast(other->m_host_id_list.data()),
+                                    this_voxel_list != NULL ? thrust::raw_pointer_cast(other->m_host_list.data()) : NULL,
+                                    (uint32_t)other->m_host_id_list.size(),
+                                    key_operator, stencil_is_mask, stencil, types_in_collision);
+  }
 
-      return thrust::count(count_device.begin(), count_device.end(), true);
-    }
-    else
-    {
-      return thrust::count(collision_stencil.begin(), collision_stencil.end(), true);
-    }
+  const uint32_t list_size = m_dev_id_list.size();
+  if (list_size == 0)
+  {
+    return 0;
   }
-  catch(thrust::system_error &e)
+  const uint32_t items_per_block = cINTERSECTION_THREADS_PER_BLOCK * cINTERSECTION_CHUNK_SIZE;
+  const uint32_t num_blocks = std::min((list_size + items_per_block - 1) / items_per_block, cINTERSECTION_MAX_BLOCKS);
+  BitVectorVoxel* dev_types = types_in_collision != NULL ? m_dev_intersection_results_types : NULL;
+
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  size_t dynamic_shared_mem_size = sizeof(BitVectorVoxel) * cINTERSECTION_THREADS_PER_BLOCK;
+  kernelIntersectSortedLists<<<num_blocks, cINTERSECTION_THREADS_PER_BLOCK, dynamic_shared_mem_size>>>(
+      thrust::raw_pointer_cast(m_dev_coord_list.data()), thrust::raw_pointer_cast(m_dev_id_list.data()), this_voxel_list,
+      list_size, thrust::raw_pointer_cast(other->m_dev_id_list.data()),
+      this_voxel_list != NULL ? thrust::raw_pointer_cast(other->m_dev_list.data()) : NULL,
+      (uint32_t)other->m_dev_id_list.size(), key_operator, stencil_is_mask, stencil,
+      m_dev_intersection_results_counter, dev_types);
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+
+  // Copy back the results and reduce the block results:
+  uint32_t block_num_collisions[cINTERSECTION_MAX_BLOCKS];
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(block_num_collisions, m_dev_intersection_results_counter, num_blocks * sizeof(uint32_t),
+                 cudaMemcpyDeviceToHost));
+  size_t num_collisions = 0;
+  for (uint32_t i = 0; i < num_blocks; i++)
   {
-    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Caught Thrust exception " << e.what() << endl);
-    exit(-1);
+    num_collisions += block_num_collisions[i];
+  }
+  if (types_in_collision != NULL)
+  {
+    thrust::host_vector<BitVectorVoxel> block_types(num_blocks);
+    HANDLE_CUDA_ERROR(
+        cudaMemcpy(thrust::raw_pointer_cast(block_types.data()), dev_types, num_blocks * sizeof(BitVectorVoxel),
+                   cudaMemcpyDeviceToHost));
+    for (uint32_t i = 0; i < num_blocks; i++)
+    {
+      types_in_collision->bitVector() |= block_types[i].bitVector();
+    }
   }
+  return num_collisions;
+}
+
+template<class Voxel, class VoxelIDType>
+void TemplateVoxelList<Voxel, VoxelIDType>::removeFromHostList(const thrust::host_vector<bool>& stencil)
+{
+  keyCoordVoxelHostZipIterator new_end;
+  new_end = thrust::remove_if(thrust::make_zip_iterator( thrust::make_tuple(m_host_id_list.begin(), m_host_coord_list.begin(), m_host_list.begin()) ),
+                              thrust::make_zip_iterator( thrust::make_tuple(m_host_id_list.end(), m_host_coord_list.end(), m_host_list.end()) ),
+                              stencil.begin(),
+                              thrust::identity<bool>());
+
+  size_t new_length = thrust::distance(m_host_id_list.begin(), thrust::get<0>(new_end.get_iterator_tuple()));
+  this->resize(new_length);
 }
 
 template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::insertPointCloud(const std::vector<Vector3f> &points, const BitVoxelMeaning voxel_meaning)
 {
+  if (this->m_backend == MB_HOST)
+  {
+    insertPointCloud(&points[0], points.size(), voxel_meaning);
+    return;
+  }
+
   Vector3f* d_points;
   HANDLE_CUDA_ERROR(cudaMalloc(&d_points, points.size() * sizeof(Vector3f)));
   HANDLE_CUDA_ERROR(
@@ -297,6 +497,11 @@ void TemplateVoxelList<Voxel, VoxelIDType>::insertPointCloud(const std::vector<V
 template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::insertPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning)
 {
+  if (this->m_backend == MB_HOST)
+  {
+    insertPointCloud(pointcloud.getConstHostPointer(), pointcloud.getPointCloudSize(), voxel_meaning);
+    return;
+  }
   insertPointCloud(pointcloud.getConstDevicePointer(), pointcloud.getPointCloudSize(), voxel_meaning);
 }
 
@@ -307,28 +512,109 @@ void TemplateVoxelList<Voxel, VoxelIDType>::insertPointCloud(const Vector3f *poi
   {
     lock_guard guard(this->m_mutex);
 
-    uint32_t offset_new_entries = m_dev_list.size();
+    appendPointCloud(points_d, size, voxel_meaning);
+    make_unique();
+  }
+}
 
-    // resize capacity
-    this->resize(offset_new_entries + size);
+template<class Voxel, class VoxelIDType>
+uint32_t TemplateVoxelList<Voxel, VoxelIDType>::appendPointCloud(const Vector3f *points_d, uint32_t size, const BitVoxelMeaning voxel_meaning)
+{
+  uint32_t offset_new_entries = getDimensions().x;
 
-    // get raw pointers to the thrust vectors data:
-    Voxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(m_dev_list.data());
-    Vector3ui* dev_coord_list_ptr = thrust::raw_pointer_cast(m_dev_coord_list.data());
-    VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(m_dev_id_list.data());
+  // resize capacity
+  this->resize(offset_new_entries + size);
 
-    // copy points to the gpu
-    uint32_t num_blocks, threads_per_block;
-    computeLinearLoad(size, &num_blocks, &threads_per_block);
-    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-    kernelInsertGlobalPointCloud<<<num_blocks, threads_per_block>>>(dev_id_list_ptr, dev_coord_list_ptr, dev_voxel_list_ptr,
-                                                                    m_ref_map_dim, m_voxel_side_length,
-                                                                    points_d, size, offset_new_entries, voxel_meaning);
-    CHECK_CUDA_ERROR();
-    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  if (this->m_backend == MB_HOST)
+  {
+    hostInsertGlobalPointCloud(thrust::raw_pointer_cast(m_host_id_list.data()),
+                               thrust::raw_pointer_cast(m_host_coord_list.data()),
+                               thrust::raw_pointer_cast(m_host_list.data()),
+                               m_ref_map_dim, m_voxel_side_length,
+                               points_d, size, offset_new_entries, voxel_meaning);
+    return offset_new_entries;
+  }
 
-    make_unique();
+  // get raw pointers to the thrust vectors data:
+  Voxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(m_dev_list.data());
+  Vector3ui* dev_coord_list_ptr = thrust::raw_pointer_cast(m_dev_coord_list.data());
+  VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(m_dev_id_list.data());
+
+  // copy points to the gpu
+  uint32_t num_blocks, threads_per_block;
+  computeLinearLoad(size, &num_blocks, &threads_per_block);
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  kernelInsertGlobalPointCloud<<<num_blocks, threads_per_block>>>(dev_id_list_ptr, dev_coord_list_ptr, dev_voxel_list_ptr,
+                                                                  m_ref_map_dim, m_voxel_side_length,
+                                                                  points_d, size, offset_new_entries, voxel_meaning);
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+
+  return offset_new_entries;
+}
+
+template<class Voxel, class VoxelIDType>
+void TemplateVoxelList<Voxel, VoxelIDType>::insertDownsampledPointCloud(const std::vector<Vector3f> &points, const BitVoxelMeaning voxel_meaning)
+{
+  lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    thrust::host_vector<Vector3f> voxel_points(points.begin(), points.end());
+    thrust::host_vector<uint32_t> voxel_keys;
+    thrust::host_vector<uint32_t> point_counts;
+    insertVoxelizedPoints(voxel_points, voxel_keys, point_counts, m_host_list, voxel_meaning);
+    return;
   }
+
+  thrust::device_vector<Vector3f> voxel_points(points.begin(), points.end());
+  thrust::device_vector<uint32_t> voxel_keys;
+  thrust::device_vector<uint32_t> point_counts;
+  insertVoxelizedPoints(voxel_points, voxel_keys, point_counts, m_dev_list, voxel_meaning);
+}
+
+template<class Voxel, class VoxelIDType>
+void TemplateVoxelList<Voxel, VoxelIDType>::insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning)
+{
+  lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    const Vector3f* points = pointcloud.getConstHostPointer();
+    thrust::host_vector<Vector3f> voxel_points(points, points + pointcloud.getPointCloudSize());
+    thrust::host_vector<uint32_t> voxel_keys;
+    thrust::host_vector<uint32_t> point_counts;
+    insertVoxelizedPoints(voxel_points, voxel_keys, point_counts, m_host_list, voxel_meaning);
+    return;
+  }
+
+  thrust::device_ptr<const Vector3f> points_d = thrust::device_pointer_cast(pointcloud.getConstDevicePointer());
+  thrust::device_vector<Vector3f> voxel_points(points_d, points_d + pointcloud.getPointCloudSize());
+  thrust::device_vector<uint32_t> voxel_keys;
+  thrust::device_vector<uint32_t> point_counts;
+  insertVoxelizedPoints(voxel_points, voxel_keys, point_counts, m_dev_list, voxel_meaning);
+}
+
+template<class Voxel, class VoxelIDType>
+template<class PointVector, class KeyVector, class VoxelVector>
+void TemplateVoxelList<Voxel, VoxelIDType>::insertVoxelizedPoints(PointVector& points, KeyVector& voxel_keys,
+                                                                  KeyVector& point_counts, VoxelVector& voxel_list,
+                                                                  const BitVoxelMeaning voxel_meaning)
+{
+  const bool count_points = this->m_map_type == MT_COUNTING_VOXELLIST;
+  voxelmap::voxelizePointCloud(m_ref_map_dim, m_voxel_side_length, points, voxel_keys, point_counts, count_points);
+  if (points.empty())
+  {
+    return;
+  }
+
+  const uint32_t offset_new_entries = appendPointCloud(thrust::raw_pointer_cast(points.data()), points.size(), voxel_meaning);
+  if (count_points)
+  {
+    // the new entries still have the order of the voxelized points
+    thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(voxel_list.begin() + offset_new_entries, point_counts.begin())),
+                     thrust::make_zip_iterator(thrust::make_tuple(voxel_list.end(), point_counts.end())),
+                     applyPointCountOperator<Voxel>());
+  }
+  make_unique();
 }
 
 
@@ -341,6 +627,11 @@ void TemplateVoxelList<Voxel, VoxelIDType>::insertMetaPointCloud(const MetaPoint
 
     if (total_points > 0)
     {
+        if (this->m_backend == MB_HOST)
+        {
+          insertMetaPointCloudHost(meta_point_cloud, std::vector<BitVoxelMeaning>(meta_point_cloud.getNumberOfPointclouds(), voxel_meaning));
+          return;
+        }
 
         uint32_t offset_new_entries = m_dev_list.size();
         // resize capacity
@@ -373,6 +664,12 @@ void TemplateVoxelList<Voxel, VoxelIDType>::insertMetaPointCloud(const MetaPoint
   }
 
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    insertMetaPointCloudHost(meta_point_cloud, voxel_meanings);
+    return;
+  }
+
   uint32_t total_points = meta_point_cloud.getAccumulatedPointcloudSize();
 
   uint32_t offset_new_entries = m_dev_list.size();
@@ -403,10 +700,40 @@ void TemplateVoxelList<Voxel, VoxelIDType>::insertMetaPointCloud(const MetaPoint
 }
 
 
+template<class Voxel, class VoxelIDType>
+void TemplateVoxelList<Voxel, VoxelIDType>::insertMetaPointCloudHost(const MetaPointCloud &meta_point_cloud,
+                                                                    const std::vector<BitVoxelMeaning>& voxel_meanings)
+{
+  lock_guard guard(this->m_mutex);
+
+  // The host copies of the clouds are used, so they have to be synced after device side transformations.
+  uint32_t offset_new_entries = getDimensions().x;
+  this->resize(offset_new_entries + meta_point_cloud.getAccumulatedPointcloudSize());
+
+  for (uint16_t cloud = 0; cloud < meta_point_cloud.getNumberOfPointclouds(); ++cloud)
+  {
+    hostInsertGlobalPointCloud(thrust::raw_pointer_cast(m_host_id_list.data()),
+                               thrust::raw_pointer_cast(m_host_coord_list.data()),
+                               thrust::raw_pointer_cast(m_host_list.data()),
+                               m_ref_map_dim, m_voxel_side_length,
+                               meta_point_cloud.getPointCloud(cloud), meta_point_cloud.getPointcloudSize(cloud),
+                               offset_new_entries, voxel_meanings[cloud]);
+    offset_new_entries += meta_point_cloud.getPointcloudSize(cloud);
+  }
+  make_unique();
+}
+
 template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::resize(size_t new_size)
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    m_host_list.resize(new_size);
+    m_host_coord_list.resize(new_size);
+    m_host_id_list.resize(new_size);
+    return;
+  }
   m_dev_list.resize(new_size);
   m_dev_coord_list.resize(new_size);
   m_dev_id_list.resize(new_size);
@@ -416,6 +743,13 @@ template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::shrinkToFit()
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    m_host_list.shrink_to_fit();
+    m_host_coord_list.shrink_to_fit();
+    m_host_id_list.shrink_to_fit();
+    return;
+  }
   m_dev_list.shrink_to_fit();
   m_dev_coord_list.shrink_to_fit();
   m_dev_id_list.shrink_to_fit();
@@ -426,6 +760,10 @@ size_t TemplateVoxelList<Voxel, VoxelIDType>::getMemoryUsage() const
 {
   size_t ret;
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    return m_host_list.size() * (sizeof(Voxel) + sizeof(Vector3ui) + sizeof(VoxelIDType));
+  }
   ret = (m_dev_list.size() * sizeof(Voxel) +
          m_dev_coord_list.size() * sizeof(Vector3ui) +
          m_dev_id_list.size() * sizeof(VoxelIDType));
@@ -436,6 +774,9 @@ template<class Voxel, class VoxelIDType>
 void TemplateVoxelList<Voxel, VoxelIDType>::clearMap()
 {
   lock_guard guard(this->m_mutex);
+  m_host_list.clear();
+  m_host_coord_list.clear();
+  m_host_id_list.clear();
   m_dev_list.clear();
   m_dev_coord_list.clear();
   m_dev_id_list.clear();
@@ -443,35 +784,57 @@ void TemplateVoxelList<Voxel, VoxelIDType>::clearMap()
 
 template<class Voxel, class VoxelIDType>
 bool TemplateVoxelList<Voxel, VoxelIDType>::writeToDisk(const std::string path)
+{
+  return writeToDisk(path, file_handling::eMFE_RAW);
+}
+
+template<class Voxel, class VoxelIDType>
+bool TemplateVoxelList<Voxel, VoxelIDType>::writeToDisk(const std::string path, const file_handling::MapFileEncoding encoding)
 {
 
   LOGGING_INFO_C(VoxellistLog, TemplateVoxelList, "Dumping VoxelList to disk: " <<
                  getDimensions().x << " Voxels ==> " << (getMemoryUsage() * cBYTE2MBYTE) << " MB. ..." << endl);
 
   lock_guard guard(this->m_mutex);
-  std::ofstream out(path.c_str());
+  const bool on_host = (this->m_backend == MB_HOST);
+  thrust::host_vector<VoxelIDType> host_id_list;
+  thrust::host_vector<Vector3ui> host_coord_list;
+  thrust::host_vector<Voxel> host_list;
+  if (!on_host)
+  {
+    host_id_list = m_dev_id_list;
+    host_coord_list = m_dev_coord_list;
+    host_list = m_dev_list;
+  }
+  const thrust::host_vector<VoxelIDType>& out_id_list = on_host ? m_host_id_list : host_id_list;
+  const thrust::host_vector<Vector3ui>& out_coord_list = on_host ? m_host_coord_list : host_coord_list;
+  const thrust::host_vector<Voxel>& out_list = on_host ? m_host_list : host_list;
+
+  // voxels first, so that the run length encoding works on whole voxels
+  const uint64_t num_voxels = out_list.size();
+  const uint64_t voxels_size = num_voxels * sizeof(Voxel);
+  const uint64_t ids_size = num_voxels * sizeof(VoxelIDType);
+  const uint64_t coords_size = num_voxels * sizeof(Vector3ui);
+  std::vector<char> buffer(voxels_size + ids_size + coords_size);
+  if (num_voxels > 0)
+  {
+    memcpy(&buffer[0], &out_list[0], voxels_size);
+    memcpy(&buffer[voxels_size], &out_id_list[0], ids_size);
+    memcpy(&buffer[voxels_size + ids_size], &out_coord_list[0], coords_size);
+  }
 
-  if(!out.is_open())
+  file_handling::MapFileWriter writer;
+  bool success = writer.open(path, m_map_type, sizeof(Voxel), m_voxel_side_length, m_ref_map_dim, buffer.size(), encoding);
+  if (success && num_voxels > 0)
+  {
+    success = writer.writeChunks(&buffer[0], writer.getNumberOfChunks());
+  }
+  success = success && writer.close();
+  if (!success)
   {
     LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Write to file " << path << " failed!" << endl);
     return false;
   }
-  thrust::host_vector<VoxelIDType> host_id_list = m_dev_id_list;
-  thrust::host_vector<Vector3ui> host_coord_list = m_dev_coord_list;
-  thrust::host_vector<Voxel> host_list = m_dev_list;
-
-  uint32_t num_voxels = host_list.size();
-  int32_t map_type = m_map_type;
-
-  out.write((char*) &map_type, sizeof(int32_t));
-  out.write((char*) &m_ref_map_dim, sizeof(Vector3ui));
-  out.write((char*) &m_voxel_side_length, sizeof(float));
-  out.write((char*) &num_voxels, sizeof(uint32_t));
-  out.write((char*) &host_id_list[0], num_voxels * sizeof(VoxelIDType));
-  out.write((char*) &host_coord_list[0], num_voxels * sizeof(Vector3ui));
-  out.write((char*) &host_list[0], num_voxels * sizeof(Voxel));
-
-  out.close();
   LOGGING_INFO_C(VoxellistLog, TemplateVoxelList, "Write to disk done: Extracted "<< num_voxels << " Voxels." << endl);
   return true;
 }
@@ -480,6 +843,64 @@ template<class Voxel, class VoxelIDType>
 bool TemplateVoxelList<Voxel, VoxelIDType>::readFromDisk(const std::string path)
 {
   lock_guard guard(this->m_mutex);
+  if (!file_handling::MapFileReader::isMapFile(path))
+  {
+    LOGGING_INFO_C(VoxellistLog, TemplateVoxelList, path << " is no versioned map file, trying the legacy format." << endl);
+    return readLegacyFile(path);
+  }
+
+  file_handling::MapFileReader reader;
+  if (!reader.open(path) ||
+      !reader.checkMetaData(m_map_type, sizeof(Voxel), m_voxel_side_length, m_ref_map_dim))
+  {
+    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Read from file " << path << " failed!"<< endl);
+    return false;
+  }
+  const file_handling::MapFileHeader& header = reader.getHeader();
+  const uint64_t bytes_per_voxel = sizeof(Voxel) + sizeof(VoxelIDType) + sizeof(Vector3ui);
+  if (header.data_size % bytes_per_voxel != 0)
+  {
+    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Read from file failed: Data size of " << path <<
+                    " does not match the voxel list type!" << endl);
+    return false;
+  }
+  const uint64_t num_voxels = header.data_size / bytes_per_voxel;
+  std::vector<char> buffer(header.data_size);
+  if (num_voxels > 0 && !reader.readChunks(&buffer[0], 0, header.num_chunks))
+  {
+    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, "Read from file " << path << " failed!"<< endl);
+    return false;
+  }
+
+  thrust::host_vector<VoxelIDType> host_id_list(num_voxels);
+  thrust::host_vector<Vector3ui> host_coord_list(num_voxels);
+  thrust::host_vector<Voxel> host_list(num_voxels);
+  if (num_voxels > 0)
+  {
+    const uint64_t voxels_size = num_voxels * sizeof(Voxel);
+    const uint64_t ids_size = num_voxels * sizeof(VoxelIDType);
+    memcpy(&host_list[0], &buffer[0], voxels_size);
+    memcpy(&host_id_list[0], &buffer[voxels_size], ids_size);
+    memcpy(&host_coord_list[0], &buffer[voxels_size + ids_size], num_voxels * sizeof(Vector3ui));
+  }
+  LOGGING_INFO_C(VoxellistLog, TemplateVoxelList, "Read "<< num_voxels << " Voxels from file." << endl;);
+
+  if (this->m_backend == MB_HOST)
+  {
+    m_host_id_list.swap(host_id_list);
+    m_host_coord_list.swap(host_coord_list);
+    m_host_list.swap(host_list);
+    return true;
+  }
+  m_dev_id_list = host_id_list;
+  m_dev_coord_list = host_coord_list;
+  m_dev_list = host_list;
+  return true;
+}
+
+template<class Voxel, class VoxelIDType>
+bool TemplateVoxelList<Voxel, VoxelIDType>::readLegacyFile(const std::string& path)
+{
   thrust::host_vector<VoxelIDType> host_id_list;
   thrust::host_vector<Vector3ui> host_coord_list;
   thrust::host_vector<Voxel> host_list;
@@ -527,6 +948,13 @@ bool TemplateVoxelList<Voxel, VoxelIDType>::readFromDisk(const std::string path)
   LOGGING_INFO_C(VoxellistLog, TemplateVoxelList, "Read "<< num_voxels << " Voxels from file." << endl;);
 
 
+  if (this->m_backend == MB_HOST)
+  {
+    m_host_id_list.swap(host_id_list);
+    m_host_coord_list.swap(host_coord_list);
+    m_host_list.swap(host_list);
+    return true;
+  }
   m_dev_id_list = host_id_list;
   m_dev_coord_list = host_coord_list;
   m_dev_list = host_list;
@@ -558,8 +986,40 @@ bool TemplateVoxelList<BitVoxel<BIT_VECTOR_LENGTH>, MapVoxelID>::merge(const Gpu
       lock_guard guard(this->m_mutex, boost::adopt_lock);
       lock_guard guard2(m->m_mutex, boost::adopt_lock);
 
+      if (this->m_backend != m->getBackend())
+      {
+        LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+        return false;
+      }
+
       uint32_t num_new_voxels = m->getDimensions().x;
-      uint32_t offset_new_entries = m_dev_list.size();
+      uint32_t offset_new_entries = getDimensions().x;
+
+      if (this->m_backend == MB_HOST)
+      {
+        this->resize(offset_new_entries + num_new_voxels);
+        thrust::copy(m->m_host_id_list.begin(), m->m_host_id_list.end(), m_host_id_list.begin() + offset_new_entries);
+        thrust::copy(m->m_host_coord_list.begin(), m->m_host_coord_list.end(), m_host_coord_list.begin() + offset_new_entries);
+        thrust::copy(m->m_host_list.begin(), m->m_host_list.end(), m_host_list.begin() + offset_new_entries);
+
+        if (voxel_offset != Vector3i())
+        {
+          const ptrdiff_t addr_offset = voxelmap::getVoxelIndexSigned(m_ref_map_dim, voxel_offset);
+          for (size_t i = offset_new_entries; i < m_host_id_list.size(); ++i)
+          {
+            m_host_coord_list[i] = m_host_coord_list[i] + voxel_offset;
+            m_host_id_list[i] += addr_offset;
+          }
+        }
+        if (new_meaning)
+        {
+          BitVectorVoxel fillVoxel;
+          fillVoxel.bitVector().setBit(*new_meaning);
+          thrust::fill(m_host_list.begin() + offset_new_entries, m_host_list.end(), fillVoxel);
+        }
+        make_unique();
+        return true;
+      }
       // resize capacity
       this->resize(offset_new_entries + num_new_voxels);
 
@@ -613,6 +1073,14 @@ bool TemplateVoxelList<Voxel, VoxelIDType>::subtract(const TemplateVoxelList<Vox
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend == MB_HOST && other->getBackend() == MB_HOST)
+  {
+    thrust::host_vector<bool> overlap_stencil(m_host_id_list.size());
+    collideVoxellistsHost(other, overlap_stencil, voxel_offset);
+    removeFromHostList(overlap_stencil);
+    return true;
+  }
+
   // find the overlapping voxels:
   thrust::device_vector<bool> overlap_stencil(m_dev_id_list.size()); // A stencil of the voxels in collision
   collideVoxellists(other, voxel_offset, overlap_stencil);
@@ -647,6 +1115,14 @@ bool TemplateVoxelList<Voxel, VoxelIDType>::subtractFromCountingVoxelList(const
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend == MB_HOST && other->getBackend() == MB_HOST)
+  {
+    thrust::host_vector<bool> overlap_stencil(m_host_id_list.size());
+    collideVoxellistsHost(other, overlap_stencil, voxel_offset);
+    removeFromHostList(overlap_stencil);
+    return true;
+  }
+
   // find the overlapping voxels:
   thrust::device_vector<bool> overlap_stencil(m_dev_id_list.size()); // A stencil of the voxels in collision
   collideVoxellists(other, voxel_offset, overlap_stencil);
@@ -678,6 +1154,10 @@ template<class Voxel, class VoxelIDType>
 Vector3ui TemplateVoxelList<Voxel, VoxelIDType>::getDimensions() const
 {
   //LOGGING_WARNING_C(VoxellistLog, TemplateVoxelList, "This is not the xyz dimension! The x value contains the number of voxels in the list." << endl);
+  if (this->m_backend == MB_HOST)
+  {
+    return Vector3ui(m_host_list.size(), 0, 0);
+  }
   return Vector3ui(m_dev_list.size(), 0, 0);
 }
 
@@ -705,6 +1185,23 @@ void TemplateVoxelList<Voxel, VoxelIDType>::extractCubes(thrust::device_vector<C
 {
   lock_guard guard(this->m_mutex);
 
+  if (this->m_backend == MB_HOST)
+  {
+    // the visualizer expects the cubes in device memory
+    thrust::host_vector<Cube> host_cubes(m_host_list.size());
+    thrust::transform(m_host_coord_list.begin(), m_host_coord_list.end(), m_host_list.begin(), host_cubes.begin(),
+                      VoxelToCube());
+    if (*output_vector == NULL)
+    {
+      *output_vector = new thrust::device_vector<Cube>(host_cubes);
+    }
+    else
+    {
+      **output_vector = host_cubes;
+    }
+    return;
+  }
+
   try
   {
     if (*output_vector == NULL)
@@ -747,6 +1244,18 @@ size_t TemplateVoxelList<Voxel, VoxelIDType>::collisionCheckWithCollider(const v
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxellistLog, TemplateVoxelList, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return SSIZE_MAX;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return hostCollideWithVoxelMap(thrust::raw_pointer_cast(m_host_id_list.data()),
+                                   thrust::raw_pointer_cast(m_host_list.data()), getDimensions().x,
+                                   other->getConstDeviceDataPtr(), m_ref_map_dim, collider, offset);
+  }
+
   // get raw pointers to the thrust vectors data:
   Voxel* dev_voxel_list_ptr = thrust::raw_pointer_cast(m_dev_list.data());
   VoxelIDType* dev_id_list_ptr = thrust::raw_pointer_cast(m_dev_id_list.data());
@@ -781,9 +1290,15 @@ void TemplateVoxelList<Voxel, VoxelIDType>::screendump(bool with_voxel_content)
 
   lock_guard guard(this->m_mutex);
 
-  thrust::host_vector<VoxelIDType> host_id_list = m_dev_id_list;
-  thrust::host_vector<Vector3ui> host_coord_list = m_dev_coord_list;
-  thrust::host_vector<Voxel> host_list = m_dev_list;
+  thrust::host_vector<VoxelIDType> host_id_list = m_host_id_list;
+  thrust::host_vector<Vector3ui> host_coord_list = m_host_coord_list;
+  thrust::host_vector<Voxel> host_list = m_host_list;
+  if (this->m_backend == MB_DEVICE)
+  {
+    host_id_list = m_dev_id_list;
+    host_coord_list = m_dev_coord_list;
+    host_list = m_dev_list;
+  }
 
   if(with_voxel_content)
   {
@@ -817,6 +1332,32 @@ bool TemplateVoxelList<Voxel, VoxelIDType>::equals(const TemplateVoxelList<Other
   lock_guard guard2(other.m_mutex, boost::adopt_lock);
 
   bool equal = true;
+  if (this->m_backend == MB_HOST || other.getBackend() == MB_HOST)
+  {
+    // compare on the host, as at least one of the lists has no device data
+    thrust::host_vector<Voxel> this_list = m_host_list;
+    thrust::host_vector<VoxelIDType> this_id_list = m_host_id_list;
+    thrust::host_vector<Vector3ui> this_coord_list = m_host_coord_list;
+    if (this->m_backend == MB_DEVICE)
+    {
+      this_list = m_dev_list;
+      this_id_list = m_dev_id_list;
+      this_coord_list = m_dev_coord_list;
+    }
+    thrust::host_vector<OtherVoxel> other_list = other.m_host_list;
+    thrust::host_vector<OtherVoxelIDType> other_id_list = other.m_host_id_list;
+    thrust::host_vector<Vector3ui> other_coord_list = other.m_host_coord_list;
+    if (other.getBackend() == MB_DEVICE)
+    {
+      other_list = other.m_dev_list;
+      other_id_list = other.m_dev_id_list;
+      other_coord_list = other.m_dev_coord_list;
+    }
+    equal &= thrust::equal(this_list.begin(), this_list.end(), other_list.begin());
+    equal &= thrust::equal(this_id_list.begin(), this_id_list.end(), other_id_list.begin());
+    equal &= thrust::equal(this_coord_list.begin(), this_coord_list.end(), other_coord_list.begin());
+    return equal;
+  }
   equal &= thrust::equal(m_dev_list.begin(), m_dev_list.end(), other.m_dev_list.begin());
   equal &= thrust::equal(m_dev_id_list.begin(), m_dev_id_list.end(), other.m_dev_id_list.begin());
   equal &= thrust::equal(m_dev_coord_list.begin(), m_dev_coord_list.end(), other.m_dev_coord_list.begin());
@@ -27,6 +27,7 @@
 #include <cuda_runtime.h>
 #include <gpu_voxels/helpers/cuda_datatypes.h>
 #include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/helpers/CollisionQuery.h>
 #include <gpu_voxels/voxel/BitVoxel.h>
 
 namespace gpu_voxels {
@@ -124,6 +125,159 @@ void kernelCollideWithVoxelMap(const OctreeVoxelID* this_id_list, BitVectorVoxel
                                const VoxelType *other_map, Vector3ui other_map_dim, float col_threshold,
                                Vector3i offset, uint16_t* coll_counter_results, BitVectorVoxel* bitvoxel_results);
 
+/**
+ * @brief occupiedInTargets Checks the voxels at \a voxel_index of all \a targets for occupancy
+ * and accumulates the meanings of \a voxel per occupied target.
+ * @return true if the voxel is occupied in any target
+ */
+template<std::size_t length>
+__host__ __device__ inline
+bool occupiedInTargets(const BitVoxel<length>& voxel, const MapVoxelID voxel_index,
+                       const CollisionQueryTargets<length>& targets, const float col_threshold,
+                       uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+  bool collision = false;
+  for (uint32_t m = 0; m < targets.num_maps; ++m)
+  {
+    const bool occupied = targets.bit_maps[m] != NULL
+        ? targets.bit_maps[m][voxel_index].isOccupied(col_threshold)
+        : targets.prob_maps[m][voxel_index].isOccupied(col_threshold);
+    if (occupied)
+    {
+      num_collisions[m]++;
+      colliding_meanings[m] |= voxel.bitVector();
+      collision = true;
+    }
+  }
+  return collision;
+}
+
+//! Launch configuration of the sorted list intersection, every thread merges chunks of cINTERSECTION_CHUNK_SIZE voxels
+static const uint32_t cINTERSECTION_THREADS_PER_BLOCK = 256;
+static const uint32_t cINTERSECTION_MAX_BLOCKS = 1024;
+static const uint32_t cINTERSECTION_CHUNK_SIZE = 16;
+
+/**
+ * @brief gallopingLowerBound Finds the first of the sorted \a keys that is not less than \a key.
+ * The search gallops forward from \a start, so looking up ascending keys one after another costs
+ * O(log distance) instead of O(log size) per key. If \a key is less than the key before \a start,
+ * the whole list is searched.
+ */
+template<class VoxelIDType>
+__host__ __device__ inline
+uint32_t gallopingLowerBound(const VoxelIDType* keys, const uint32_t size, uint32_t start, const VoxelIDType key)
+{
+  if (start > size || (start > 0 && !(keys[start - 1] < key)))
+  {
+    start = 0;
+  }
+  // all keys before low are less than key
+  uint32_t low = start;
+  uint32_t high = start;
+  uint32_t step = 1;
+  while (high < size && keys[high] < key)
+  {
+    low = high + 1;
+    high = (size - high > step) ? high + step : size;
+    step *= 2;
+  }
+  while (low < high)
+  {
+    const uint32_t middle = low + (high - low) / 2;
+    if (keys[middle] < key)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief intersectSortedRange Looks up the voxels [begin, end) of this list in the sorted keys of the other list.
+ * Their keys are delivered by \a key_operator from the coordinates and IDs of this list.
+ * @param [in] this_voxel_list Optional, together with \a other_voxel_list the bitvectors of both lists
+ * are ORed into \a types_in_collision for every collision
+ * @param [in] stencil_is_mask If true, only voxels with a true \a stencil entry are counted
+ * @param [in,out] stencil Optional, set to true for every voxel that is contained in the other list
+ * @param [in,out] num_collisions Is increased by the number of collisions
+ */
+template<class VoxelIDType, class KeyOperator>
+__host__ __device__ inline
+void intersectSortedRange(const Vector3ui* this_coord_list, const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list,
+                          const uint32_t begin, const uint32_t end,
+                          const VoxelIDType* other_id_list, const BitVectorVoxel* other_voxel_list, const uint32_t other_list_size,
+                          const KeyOperator& key_operator, const bool stencil_is_mask, bool* stencil,
+                          uint32_t& num_collisions, BitVectorVoxel& types_in_collision)
+{
+  uint32_t cursor = 0;
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    const VoxelIDType key = key_operator(this_coord_list[i], this_id_list[i]);
+    cursor = gallopingLowerBound(other_id_list, other_list_size, cursor, key);
+    const bool found = cursor < other_list_size && other_id_list[cursor] == key;
+    bool counted = found;
+    if (stencil != NULL)
+    {
+      counted = found && (!stencil_is_mask || stencil[i]);
+      stencil[i] = found;
+    }
+    if (counted)
+    {
+      num_collisions++;
+      if (this_voxel_list != NULL && other_voxel_list != NULL)
+      {
+        types_in_collision.bitVector() |= this_voxel_list[i].bitVector();
+        types_in_collision.bitVector() |= other_voxel_list[cursor].bitVector();
+      }
+    }
+  }
+}
+
+/**
+ * @brief kernelIntersectSortedLists Intersects the keys of this list with the sorted keys of the other list
+ * in one pass. Every thread gallops through the other list for chunks of cINTERSECTION_CHUNK_SIZE voxels,
+ * so the count, the stencil and the colliding types need no temporary arrays.
+ * Needs cINTERSECTION_THREADS_PER_BLOCK threads per block.
+ * See intersectSortedRange() for the parameters.
+ * @param [out] coll_counter_results Number of collisions (one entry for each block)
+ * @param [out] bitvoxel_results Optional, bits in collision (one entry for each block)
+ */
+template<class VoxelIDType, class KeyOperator>
+__global__
+void kernelIntersectSortedLists(const Vector3ui* this_coord_list, const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list,
+                                const uint32_t this_list_size,
+                                const VoxelIDType* other_id_list, const BitVectorVoxel* other_voxel_list, const uint32_t other_list_size,
+                                const KeyOperator key_operator, const bool stencil_is_mask, bool* stencil,
+                                uint32_t* coll_counter_results, BitVectorVoxel* bitvoxel_results);
+
+/**
+ * @brief kernelCollideWithVoxelMaps Collision check kernel between a voxellist and several voxelmaps
+ * of the dimensions of the lists reference map. Every list voxel is loaded once for all maps.
+ * Needs a power of two number of threads per block.
+ * @param [in] this_id_list Device pointer to this lists IDs
+ * @param [in] this_voxel_list Device pointer to this lists Bitvoxels
+ * @param [in] this_list_size Number of voxels in this list
+ * @param [in] targets Device pointers to the maps
+ * @param [in] col_threshold When to inspect a occupied Voxel
+ * @param [out] coll_counter_results Number of collisions, cMAX_COLLISION_QUERY_MAPS entries for each block
+ * @param [out] bitvector_results Bits in collision, cMAX_COLLISION_QUERY_MAPS entries for each block
+ */
+template<std::size_t length>
+__global__
+void kernelCollideWithVoxelMaps(const MapVoxelID* this_id_list, BitVoxel<length> *this_voxel_list, uint32_t this_list_size,
+                                const CollisionQueryTargets<length> targets, float col_threshold,
+                                uint32_t* coll_counter_results, BitVector<length>* bitvector_results);
+
+template<std::size_t length>
+__global__
+void kernelCollideWithVoxelMaps(const OctreeVoxelID* this_id_list, BitVoxel<length> *this_voxel_list, uint32_t this_list_size,
+                                const CollisionQueryTargets<length> targets, float col_threshold,
+                                uint32_t* coll_counter_results, BitVector<length>* bitvector_results);
+
 /**
  * @brief kernelCollideWithVoxelMapBitMask Collision check kernel between a voxellist and a probabilistic voxelmap
  * that only detects and counts collisions for specific BitVoxelMeanings
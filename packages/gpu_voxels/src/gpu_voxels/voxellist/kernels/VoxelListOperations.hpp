@@ -246,6 +246,122 @@ void kernelCollideWithVoxelMap(const OctreeVoxelID* this_id_list, BitVectorVoxel
                                Vector3i offset, uint16_t* coll_counter_results, BitVectorVoxel* bitvoxel_results)
 {}
 
+template<std::size_t length>
+__global__
+void kernelCollideWithVoxelMaps(const MapVoxelID* this_id_list, BitVoxel<length> *this_voxel_list, uint32_t this_list_size,
+                                const CollisionQueryTargets<length> targets, float col_threshold,
+                                uint32_t* coll_counter_results, BitVector<length>* bitvector_results)
+{
+  __shared__ uint32_t coll_counter_cache[cMAX_THREADS_PER_BLOCK];
+
+  // points to dynamic shared memory; memory is uninitialised
+  BitVector<length>* bitvector_cache = (BitVector<length>*)dynamic_shared_mem; //size: blockDim.x
+  uint32_t cache_index = threadIdx.x;
+
+  // every thread accumulates its own results of all targets
+  uint32_t thread_num_collisions[cMAX_COLLISION_QUERY_MAPS];
+  BitVector<length> thread_meanings[cMAX_COLLISION_QUERY_MAPS];
+  for (uint32_t m = 0; m < cMAX_COLLISION_QUERY_MAPS; ++m)
+  {
+    thread_num_collisions[m] = 0;
+  }
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < this_list_size; i += blockDim.x * gridDim.x)
+  {
+    if (occupiedInTargets(this_voxel_list[i], this_id_list[i], targets, col_threshold,
+                          thread_num_collisions, thread_meanings))
+    {
+      // Mark the Voxel as colliding.
+      this_voxel_list[i].insert(eBVM_COLLISION);
+    }
+  }
+
+  // reduce the results of one target after another
+  for (uint32_t m = 0; m < targets.num_maps; ++m)
+  {
+    coll_counter_cache[cache_index] = thread_num_collisions[m];
+    bitvector_cache[cache_index] = thread_meanings[m];
+    __syncthreads();
+
+    uint32_t j = blockDim.x / 2;
+    while (j != 0)
+    {
+      if (cache_index < j)
+      {
+        coll_counter_cache[cache_index] = coll_counter_cache[cache_index] + coll_counter_cache[cache_index + j];
+        bitvector_cache[cache_index] = bitvector_cache[cache_index] | bitvector_cache[cache_index + j];
+      }
+      __syncthreads();
+      j /= 2;
+    }
+
+    if (cache_index == 0)
+    {
+      coll_counter_results[blockIdx.x * cMAX_COLLISION_QUERY_MAPS + m] = coll_counter_cache[0];
+      bitvector_results[blockIdx.x * cMAX_COLLISION_QUERY_MAPS + m] = bitvector_cache[0];
+    }
+    __syncthreads();
+  }
+}
+
+template<std::size_t length>
+__global__
+void kernelCollideWithVoxelMaps(const OctreeVoxelID* this_id_list, BitVoxel<length> *this_voxel_list, uint32_t this_list_size,
+                                const CollisionQueryTargets<length> targets, float col_threshold,
+                                uint32_t* coll_counter_results, BitVector<length>* bitvector_results)
+{}
+
+template<class VoxelIDType, class KeyOperator>
+__global__
+void kernelIntersectSortedLists(const Vector3ui* this_coord_list, const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list,
+                                const uint32_t this_list_size,
+                                const VoxelIDType* other_id_list, const BitVectorVoxel* other_voxel_list, const uint32_t other_list_size,
+                                const KeyOperator key_operator, const bool stencil_is_mask, bool* stencil,
+                                uint32_t* coll_counter_results, BitVectorVoxel* bitvoxel_results)
+{
+  __shared__ uint32_t coll_counter_cache[cINTERSECTION_THREADS_PER_BLOCK];
+
+  // points to dynamic shared memory; memory is uninitialised
+  BitVectorVoxel* bitvoxel_cache = (BitVectorVoxel*)dynamic_shared_mem; //size: cINTERSECTION_THREADS_PER_BLOCK
+  uint32_t cache_index = threadIdx.x;
+
+  uint32_t num_collisions = 0;
+  BitVectorVoxel types_in_collision;
+  for (uint32_t begin = (blockIdx.x * blockDim.x + threadIdx.x) * cINTERSECTION_CHUNK_SIZE; begin < this_list_size;
+       begin += blockDim.x * gridDim.x * cINTERSECTION_CHUNK_SIZE)
+  {
+    const uint32_t end = min(begin + cINTERSECTION_CHUNK_SIZE, this_list_size);
+    intersectSortedRange(this_coord_list, this_id_list, this_voxel_list, begin, end,
+                         other_id_list, other_voxel_list, other_list_size,
+                         key_operator, stencil_is_mask, stencil, num_collisions, types_in_collision);
+  }
+  coll_counter_cache[cache_index] = num_collisions;
+  bitvoxel_cache[cache_index] = types_in_collision;
+  __syncthreads();
+
+  uint32_t j = blockDim.x / 2;
+  while (j != 0)
+  {
+    if (cache_index < j)
+    {
+      coll_counter_cache[cache_index] = coll_counter_cache[cache_index] + coll_counter_cache[cache_index + j];
+      bitvoxel_cache[cache_index].bitVector() |= bitvoxel_cache[cache_index + j].bitVector();
+    }
+    __syncthreads();
+    j /= 2;
+  }
+
+  // copy results from this block to global memory
+  if (cache_index == 0)
+  {
+    coll_counter_results[blockIdx.x] = coll_counter_cache[0];
+    if (bitvoxel_results != NULL)
+    {
+      bitvoxel_results[blockIdx.x] = bitvoxel_cache[0];
+    }
+  }
+}
+
 template<class VoxelType>
 __global__
 void kernelCollideWithVoxelMapBitMask(const OctreeVoxelID* this_id_list, BitVectorVoxel *this_voxel_list, uint32_t this_list_size,
@@ -0,0 +1,348 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Host counterparts of the voxellist kernels in VoxelListOperations.hpp.
+ * They work on the host side vectors of voxellists that were created
+ * with the MB_HOST backend and are parallelized with OpenMP if available.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_VOXELLIST_KERNELS_VOXELLIST_OPERATIONS_HOST_HPP_INCLUDED
+#define GPU_VOXELS_VOXELLIST_KERNELS_VOXELLIST_OPERATIONS_HOST_HPP_INCLUDED
+
+#include <algorithm>
+#include <vector>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+#include <gpu_voxels/helpers/common_defines.h>
+#include <gpu_voxels/voxel/BitVoxel.h>
+#include <gpu_voxels/voxellist/kernels/VoxelListOperations.h>
+#include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.h>
+#include <gpu_voxels/octree/Morton.h>
+
+namespace gpu_voxels {
+namespace voxellist {
+
+//! Voxels of voxelmap-like lists are identified by their linear address in the reference map
+inline void hostComputeVoxelID(MapVoxelID& id, const Vector3ui& ref_map_dim, const Vector3ui& coords)
+{
+  id = voxelmap::getVoxelIndexUnsigned(ref_map_dim, coords);
+}
+
+//! Voxels of morton lists are identified by their morton code
+inline void hostComputeVoxelID(OctreeVoxelID& id, const Vector3ui& ref_map_dim, const Vector3ui& coords)
+{
+  id = NTree::morton_code60(coords);
+}
+
+/*!
+ * Host version of kernelInsertGlobalPointCloud().
+ * Writes one entry per point starting at \a offset_new_points.
+ * The list has to be made unique afterwards.
+ */
+template<class Voxel, class VoxelIDType>
+void hostInsertGlobalPointCloud(VoxelIDType* id_list, Vector3ui* coord_list, Voxel* voxel_list,
+                                const Vector3ui ref_map_dim, const float voxel_side_length,
+                                const Vector3f* points, const std::size_t num_points,
+                                const uint32_t offset_new_points, const BitVoxelMeaning voxel_meaning)
+{
+  Voxel new_voxel = Voxel();
+  new_voxel.insert(voxel_meaning);
+
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(num_points); ++i)
+  {
+    const Vector3ui uint_coords = voxelmap::mapToVoxels(voxel_side_length, points[i]);
+    coord_list[i + offset_new_points] = uint_coords;
+    voxel_list[i + offset_new_points] = new_voxel;
+    hostComputeVoxelID(id_list[i + offset_new_points], ref_map_dim, uint_coords);
+  }
+}
+
+/*!
+ * Host version of the counting kernelCollideWithVoxelMap().
+ * Voxels that are shifted out of the map by \a offset are ignored.
+ * Colliding list voxels are marked with eBVM_COLLISION.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+size_t hostCollideWithVoxelMap(const MapVoxelID* this_id_list, Voxel* this_voxel_list, const uint32_t this_list_size,
+                               const OtherVoxel* other_map, const Vector3ui other_map_dim, Collider collider,
+                               const Vector3i offset)
+{
+  const int64_t map_size = int64_t(other_map_dim.x) * other_map_dim.y * other_map_dim.z;
+  const int64_t addr_offset = voxelmap::getVoxelIndexSigned(other_map_dim, offset);
+  size_t num_collisions = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:num_collisions)
+  for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+  {
+    const int64_t other_index = int64_t(this_id_list[i]) + addr_offset;
+    if (other_index >= 0 && other_index < map_size)
+    {
+      if (collider.collide(this_voxel_list[i], other_map[other_index]))
+      {
+        this_voxel_list[i].insert(eBVM_COLLISION);
+        num_collisions++;
+      }
+    }
+  }
+  return num_collisions;
+}
+
+/*!
+ * Host version of the bitvector kernelCollideWithVoxelMap().
+ * Returns the number of collisions and ORs the meanings of all colliding
+ * list voxels into \a types_in_collision.
+ */
+template<class OtherVoxel>
+size_t hostCollideWithVoxelMapTypes(const MapVoxelID* this_id_list, BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                    const OtherVoxel* other_map, const Vector3ui other_map_dim, const float col_threshold,
+                                    const Vector3i offset, BitVectorVoxel& types_in_collision)
+{
+  const int64_t map_size = int64_t(other_map_dim.x) * other_map_dim.y * other_map_dim.z;
+  const int64_t addr_offset = voxelmap::getVoxelIndexSigned(other_map_dim, offset);
+  size_t num_collisions = 0;
+
+#pragma omp parallel reduction(+:num_collisions)
+  {
+    BitVectorVoxel thread_types;
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+    {
+      const int64_t other_index = int64_t(this_id_list[i]) + addr_offset;
+      if (other_index >= 0 && other_index < map_size && other_map[other_index].isOccupied(col_threshold))
+      {
+        thread_types.bitVector() |= this_voxel_list[i].bitVector();
+        this_voxel_list[i].insert(eBVM_COLLISION);
+        num_collisions++;
+      }
+    }
+
+#pragma omp critical
+    types_in_collision.bitVector() |= thread_types.bitVector();
+  }
+  return num_collisions;
+}
+
+//! Morton lists can not be collided with voxelmaps, see kernelCollideWithVoxelMap()
+template<class OtherVoxel>
+size_t hostCollideWithVoxelMapTypes(const OctreeVoxelID* this_id_list, BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                    const OtherVoxel* other_map, const Vector3ui other_map_dim, const float col_threshold,
+                                    const Vector3i offset, BitVectorVoxel& types_in_collision)
+{
+  return 0;
+}
+
+/*!
+ * Host version of kernelCollideWithVoxelMapBitMask().
+ * Only list voxels sharing a bit with \a bitvoxel_mask are counted and marked with eBVM_COLLISION.
+ */
+template<class OtherVoxel>
+size_t hostCollideWithVoxelMapBitMask(const MapVoxelID* this_id_list, BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                      const OtherVoxel* other_map, const Vector3ui other_map_dim, const float col_threshold,
+                                      const Vector3i offset, const BitVectorVoxel& bitvoxel_mask)
+{
+  const int64_t map_size = int64_t(other_map_dim.x) * other_map_dim.y * other_map_dim.z;
+  const int64_t addr_offset = voxelmap::getVoxelIndexSigned(other_map_dim, offset);
+  size_t num_collisions = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:num_collisions)
+  for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+  {
+    const int64_t other_index = int64_t(this_id_list[i]) + addr_offset;
+    if (other_index >= 0 && other_index < map_size && other_map[other_index].isOccupied(col_threshold)
+        && !(bitvoxel_mask.bitVector() & this_voxel_list[i].bitVector()).isZero())
+    {
+      this_voxel_list[i].insert(eBVM_COLLISION);
+      num_collisions++;
+    }
+  }
+  return num_collisions;
+}
+
+//! Morton lists can not be collided with voxelmaps, see kernelCollideWithVoxelMapBitMask()
+template<class OtherVoxel>
+size_t hostCollideWithVoxelMapBitMask(const OctreeVoxelID* this_id_list, BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                      const OtherVoxel* other_map, const Vector3ui other_map_dim, const float col_threshold,
+                                      const Vector3i offset, const BitVectorVoxel& bitvoxel_mask)
+{
+  return 0;
+}
+
+/*!
+ * Host version of BitVoxelList::findMatchingVoxels() followed by the bit check of
+ * collideWithBitcheck(). Both lists have to be sorted and unique.
+ * Returns the number of voxels at the same spot whose bitvectors collide according to \a bit_collision.
+ */
+template<class VoxelIDType, class BitCollision>
+size_t hostCollideMatchingVoxels(const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                 const VoxelIDType* other_id_list, const BitVectorVoxel* other_voxel_list, const uint32_t other_list_size,
+                                 const BitCollision& bit_collision)
+{
+  size_t num_collisions = 0;
+
+#pragma omp parallel reduction(+:num_collisions)
+  {
+    // the bitshift collision has a non const operator()
+    BitCollision collision = bit_collision;
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+    {
+      const VoxelIDType* match = std::lower_bound(other_id_list, other_id_list + other_list_size, this_id_list[i]);
+      if (match != other_id_list + other_list_size && *match == this_id_list[i]
+          && collision(this_voxel_list[i], other_voxel_list[match - other_id_list]))
+      {
+        num_collisions++;
+      }
+    }
+  }
+  return num_collisions;
+}
+
+/*!
+ * Host version of the meaning count of BitVoxelList::collideCountingPerMeaning().
+ * Every set bit of a voxel of this list, which also lies in the other list, increments
+ * its entry of \a collisions_per_meaning. Both lists have to be sorted and unique.
+ * Returns the sum of all increments.
+ */
+template<class VoxelIDType>
+size_t hostCountMatchingMeanings(const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list, const uint32_t this_list_size,
+                                 const VoxelIDType* other_id_list, const uint32_t other_list_size,
+                                 std::vector<size_t>& collisions_per_meaning)
+{
+  size_t summed_colls = 0;
+
+#pragma omp parallel reduction(+:summed_colls)
+  {
+    std::vector<size_t> thread_per_meaning(BIT_VECTOR_LENGTH, 0);
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+    {
+      if (std::binary_search(other_id_list, other_id_list + other_list_size, this_id_list[i]))
+      {
+        for (size_t j = 0; j < BIT_VECTOR_LENGTH; j++)
+        {
+          if (this_voxel_list[i].bitVector().getBit(j))
+          {
+            thread_per_meaning[j]++;
+            summed_colls++;
+          }
+        }
+      }
+    }
+
+#pragma omp critical
+    for (size_t j = 0; j < BIT_VECTOR_LENGTH; j++)
+    {
+      collisions_per_meaning[j] += thread_per_meaning[j];
+    }
+  }
+  return summed_colls;
+}
+
+/*!
+ * Host version of kernelIntersectSortedLists().
+ * Every OpenMP thread gallops through the other list for contiguous
+ * chunks of this list. The bits in collision are ORed into
+ * \a types_in_collision if it is given.
+ * Returns the number of collisions.
+ */
+template<class VoxelIDType, class KeyOperator>
+size_t hostIntersectSortedLists(const Vector3ui* this_coord_list, const VoxelIDType* this_id_list, const BitVectorVoxel* this_voxel_list,
+                                const uint32_t this_list_size,
+                                const VoxelIDType* other_id_list, const BitVectorVoxel* other_voxel_list, const uint32_t other_list_size,
+                                const KeyOperator& key_operator, const bool stencil_is_mask, bool* stencil,
+                                BitVectorVoxel* types_in_collision)
+{
+  // larger chunks than on the device, as the galloping cursor restarts with every chunk
+  const uint32_t chunk_size = 64 * cINTERSECTION_CHUNK_SIZE;
+  const int64_t num_chunks = (int64_t(this_list_size) + chunk_size - 1) / chunk_size;
+  size_t num_collisions = 0;
+
+#pragma omp parallel reduction(+:num_collisions)
+  {
+    uint32_t thread_num_collisions = 0;
+    BitVectorVoxel thread_types;
+
+#pragma omp for schedule(static)
+    for (int64_t c = 0; c < num_chunks; ++c)
+    {
+      const uint32_t begin = uint32_t(c * chunk_size);
+      const uint32_t end = std::min(begin + chunk_size, this_list_size);
+      intersectSortedRange(this_coord_list, this_id_list, this_voxel_list, begin, end,
+                           other_id_list, other_voxel_list, other_list_size,
+                           key_operator, stencil_is_mask, stencil, thread_num_collisions, thread_types);
+    }
+    num_collisions += thread_num_collisions;
+
+    if (types_in_collision != NULL)
+    {
+#pragma omp critical
+      types_in_collision->bitVector() |= thread_types.bitVector();
+    }
+  }
+  return num_collisions;
+}
+
+/*!
+ * Host version of kernelCollideWithVoxelMaps().
+ * \a num_collisions and \a colliding_meanings have to hold targets.num_maps entries.
+ */
+template<std::size_t length>
+void hostCollideWithVoxelMaps(const MapVoxelID* this_id_list, BitVoxel<length>* this_voxel_list, const uint32_t this_list_size,
+                              const CollisionQueryTargets<length>& targets, const float col_threshold,
+                              uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+#pragma omp parallel
+  {
+    // every thread accumulates its own results, they get merged at the end
+    uint32_t thread_num_collisions[cMAX_COLLISION_QUERY_MAPS] = { 0 };
+    BitVector<length> thread_meanings[cMAX_COLLISION_QUERY_MAPS];
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(this_list_size); ++i)
+    {
+      if (occupiedInTargets(this_voxel_list[i], this_id_list[i], targets, col_threshold,
+                            thread_num_collisions, thread_meanings))
+      {
+        this_voxel_list[i].insert(eBVM_COLLISION);
+      }
+    }
+
+#pragma omp critical
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      num_collisions[m] += thread_num_collisions[m];
+      colliding_meanings[m] |= thread_meanings[m];
+    }
+  }
+}
+
+//! Morton lists can not be collided with voxelmaps, see kernelCollideWithVoxelMaps()
+template<std::size_t length>
+void hostCollideWithVoxelMaps(const OctreeVoxelID* this_id_list, BitVoxel<length>* this_voxel_list, const uint32_t this_list_size,
+                              const CollisionQueryTargets<length>& targets, const float col_threshold,
+                              uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+}
+
+} // end of namespace voxellist
+} // end of namespace gpu_voxels
+
+#endif
@@ -45,6 +45,9 @@ public:
   //! get pointer to data array on device
   virtual void* getVoidDeviceDataPtr() = 0;
 
+  //! get read only pointer to data array on device
+  virtual const void* getConstVoidDeviceDataPtr() const = 0;
+
   //! get the side length of the voxels.
   virtual float getVoxelSideLength() const = 0;
 
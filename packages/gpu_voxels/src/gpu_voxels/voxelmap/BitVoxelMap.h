@@ -28,6 +28,7 @@
 #include <gpu_voxels/voxel/ProbabilisticVoxel.h>
 #include <gpu_voxels/voxelmap/ProbVoxelMap.h>
 #include <gpu_voxels/helpers/CollisionInterfaces.h>
+#include <gpu_voxels/helpers/CollisionQuery.h>
 #include <cstddef>
 
 namespace gpu_voxels {
@@ -35,13 +36,15 @@ namespace voxelmap {
 
 template<std::size_t length>
 class BitVoxelMap: public TemplateVoxelMap<BitVoxel<length> >,
-    public CollidableWithBitVectorVoxelMap, public CollidableWithProbVoxelMap, public CollidableWithTypesBitVectorVoxelMap, public CollidableWithTypesProbVoxelMap
+    public CollidableWithBitVectorVoxelMap, public CollidableWithProbVoxelMap, public CollidableWithTypesBitVectorVoxelMap, public CollidableWithTypesProbVoxelMap,
+    public CollidableWithMultipleMaps
 {
 public:
   typedef BitVoxel<length> Voxel;
   typedef TemplateVoxelMap<Voxel> Base;
 
-  BitVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type);
+  BitVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type,
+              const MapBackend backend = MB_DEVICE);
   BitVoxelMap(Voxel* dev_data, const Vector3ui dim, const float voxel_side_length, const MapType map_type);
 
   virtual ~BitVoxelMap();
@@ -92,9 +95,28 @@ public:
   size_t collideWith(const voxelmap::ProbVoxelMap* map, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
   size_t collideWithTypes(const voxelmap::BitVectorVoxelMap* map, BitVectorVoxel& types_in_collision, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
   size_t collideWithTypes(const voxelmap::ProbVoxelMap* map, BitVectorVoxel& types_in_collision, float coll_threshold = 1.0, const Vector3i &offset = Vector3i());
+  bool collideWithMaps(const std::vector<GpuVoxelsMap*>& maps, std::vector<CollisionQueryResult>& results, float coll_threshold = 1.0);
 
 protected:
   virtual void clearVoxelMapRemoteLock(const uint32_t bit_index);
+
+  /**
+   * @brief Same as collisionCheckBitvector() but only visits the bricks that
+   * were collected by collectCommonBricks() before. The maps have to be locked.
+   */
+  template<class OtherVoxel, class Collider>
+  uint32_t collisionCheckBitvectorBricks(const OtherVoxel* other_data, const uint32_t num_common_bricks,
+                                         Collider collider, BitVector<length>& colliding_meanings,
+                                         const uint16_t sv_offset);
+
+  /**
+   * @brief Collides the map with all \a targets in one pass, only visiting the occupied
+   * bricks if the brick index is valid. The results are accumulated per target.
+   * All maps have to be locked by the caller.
+   */
+  template<class Collider>
+  void collisionCheckMaps(const CollisionQueryTargets<length>& targets, Collider collider,
+                          uint32_t* num_collisions, BitVector<length>* colliding_meanings);
 };
 
 } // end of namespace
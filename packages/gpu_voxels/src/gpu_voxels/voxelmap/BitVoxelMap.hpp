@@ -28,6 +28,8 @@
 #include <gpu_voxels/voxel/BitVoxel.hpp>
 #include <gpu_voxels/voxelmap/ProbVoxelMap.hpp>
 
+#include <algorithm>
+#include <climits>
 #include <thrust/device_vector.h>
 #include <thrust/device_ptr.h>
 
@@ -35,8 +37,9 @@ namespace gpu_voxels {
 namespace voxelmap {
 
 template<std::size_t length>
-BitVoxelMap<length>::BitVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type) :
-    Base(dim, voxel_side_length, map_type)
+BitVoxelMap<length>::BitVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type,
+                                 const MapBackend backend) :
+    Base(dim, voxel_side_length, map_type, backend)
 {
 
 }
@@ -64,6 +67,11 @@ void BitVoxelMap<length>::clearBit(const uint32_t bit_index)
 template<std::size_t length>
 void BitVoxelMap<length>::clearVoxelMapRemoteLock(const uint32_t bit_index)
 {
+  if (this->m_backend == MB_HOST)
+  {
+    hostClearVoxelMap(this->m_dev_data, this->m_voxelmap_size, bit_index);
+    return;
+  }
   kernelClearVoxelMap<<<this->m_blocks, this->m_threads>>>(this->m_dev_data, this->m_voxelmap_size,
                                                            bit_index);
   CHECK_CUDA_ERROR();
@@ -75,6 +83,12 @@ void BitVoxelMap<length>::clearBits(BitVector<length> bits)
 {
   lock_guard guard(this->m_mutex);
 
+  if (this->m_backend == MB_HOST)
+  {
+    hostClearVoxelMap(this->m_dev_data, this->m_voxelmap_size, bits);
+    return;
+  }
+
   kernelClearVoxelMap<<<this->m_blocks, this->m_threads>>>(this->m_dev_data, this->m_voxelmap_size, bits);
   CHECK_CUDA_ERROR();
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
@@ -90,6 +104,23 @@ uint32_t BitVoxelMap<length>::collisionCheckBitvector(const BitVoxelMap<length>*
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxelmapLog, BitVoxelMap, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return 0;
+  }
+  uint32_t num_common_bricks;
+  if (this->collectCommonBricks(other, num_common_bricks))
+  {
+    return collisionCheckBitvectorBricks(other->getConstDeviceDataPtr(), num_common_bricks, collider,
+                                         colliding_meanings, sv_offset);
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return hostCollideVoxelMapsBitvector(this->m_dev_data, this->m_voxelmap_size, other->getConstDeviceDataPtr(),
+                                         collider, colliding_meanings, sv_offset);
+  }
+
   uint32_t threads_per_block = 1024;
   //calculate number of blocks
   uint32_t number_of_blocks;
@@ -144,6 +175,23 @@ uint32_t BitVoxelMap<length>::collisionCheckBitvector(const voxelmap::ProbVoxelM
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxelmapLog, BitVoxelMap, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return 0;
+  }
+  uint32_t num_common_bricks;
+  if (this->collectCommonBricks(other, num_common_bricks))
+  {
+    return collisionCheckBitvectorBricks(other->getConstDeviceDataPtr(), num_common_bricks, collider,
+                                         colliding_meanings, sv_offset);
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return hostCollideVoxelMapsBitvector(this->m_dev_data, this->m_voxelmap_size, other->getConstDeviceDataPtr(),
+                                         collider, colliding_meanings, sv_offset);
+  }
+
   uint32_t threads_per_block = 1024;
   //calculate number of blocks
   uint32_t number_of_blocks;
@@ -187,6 +235,59 @@ uint32_t BitVoxelMap<length>::collisionCheckBitvector(const voxelmap::ProbVoxelM
   return result_num_collisions;
 }
 
+template<std::size_t length>
+template<class OtherVoxel, class Collider>
+uint32_t BitVoxelMap<length>::collisionCheckBitvectorBricks(const OtherVoxel* other_data, const uint32_t num_common_bricks,
+                                                            Collider collider, BitVector<length>& colliding_meanings,
+                                                            const uint16_t sv_offset)
+{
+  if (num_common_bricks == 0)
+  {
+    return 0;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return hostCollideVoxelMapsBitvectorBricks(this->m_dev_data, this->m_dim, other_data, this->m_dev_active_bricks,
+                                               num_common_bricks, collider, colliding_meanings, sv_offset);
+  }
+
+  uint32_t number_of_blocks, threads_per_block;
+  computeLinearLoad(num_common_bricks * cVOXELS_PER_BRICK, &number_of_blocks, &threads_per_block);
+
+  BitVector<length>* result_ptr_dev;
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&result_ptr_dev, sizeof(BitVector<length> ) * number_of_blocks));
+
+  uint16_t* num_collisions_dev;
+  HANDLE_CUDA_ERROR(
+      cudaMalloc((void** )&num_collisions_dev, number_of_blocks * sizeof(uint16_t)));
+
+  kernelCollideVoxelMapsBitvectorBricks<<<number_of_blocks, threads_per_block,
+                                          sizeof(BitVector<length> ) * threads_per_block>>>(
+      this->m_dev_data, this->m_dim, other_data, this->m_dev_active_bricks, num_common_bricks,
+      collider, result_ptr_dev, num_collisions_dev, sv_offset);
+  CHECK_CUDA_ERROR();
+
+  //copying result from device
+  std::vector<uint16_t> num_collisions_h(number_of_blocks);
+  std::vector<BitVector<length> > result_array(number_of_blocks);
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(&(result_array[0]), result_ptr_dev, sizeof(BitVector<length> ) * number_of_blocks,
+                 cudaMemcpyDeviceToHost));
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(&(num_collisions_h[0]), num_collisions_dev, sizeof(uint16_t) * number_of_blocks,
+                 cudaMemcpyDeviceToHost));
+  uint32_t result_num_collisions = 0;
+  for (uint32_t i = 0; i < number_of_blocks; ++i)
+  {
+    colliding_meanings |= result_array[i];
+    result_num_collisions += num_collisions_h[i];
+  }
+
+  HANDLE_CUDA_ERROR(cudaFree(result_ptr_dev));
+  HANDLE_CUDA_ERROR(cudaFree(num_collisions_dev));
+  return result_num_collisions;
+}
 
 template<std::size_t length>
 size_t BitVoxelMap<length>::collideWith(const BitVectorVoxelMap *map, float coll_threshold, const Vector3i &offset)
@@ -216,6 +317,133 @@ size_t BitVoxelMap<length>::collideWithTypes(const voxelmap::ProbVoxelMap* map,
   return this->collisionCheckBitvector(map, collider, types_in_collision.bitVector());
 }
 
+template<std::size_t length>
+bool BitVoxelMap<length>::collideWithMaps(const std::vector<GpuVoxelsMap*>& maps,
+                                          std::vector<CollisionQueryResult>& results, float coll_threshold)
+{
+  results.assign(maps.size(), CollisionQueryResult());
+  bool all_checked = true;
+
+  // Voxel maps are checked in one pass over this map, all other maps one after another.
+  std::vector<size_t> fused_maps;
+  for (size_t i = 0; i < maps.size(); ++i)
+  {
+    GpuVoxelsMap* map = maps[i];
+    CollisionQueryResult& result = results[i];
+    if (map != NULL && (map->is<BitVectorVoxelMap>() || map->is<ProbVoxelMap>()))
+    {
+      if (map->getDimensions() != this->m_dim || map->getBackend() != this->m_backend)
+      {
+        LOGGING_ERROR_C(VoxelmapLog, BitVoxelMap, "Map " << i << " differs in dimensions or backend. Not checking collisions!" << endl);
+        result.num_collisions = SSIZE_MAX;
+        all_checked = false;
+      }
+      else
+      {
+        fused_maps.push_back(i);
+      }
+    }
+    else if (CollidableWithTypesBitVectorVoxelMap* other = dynamic_cast<CollidableWithTypesBitVectorVoxelMap*>(map))
+    {
+      result.num_collisions = other->collideWithTypes((BitVectorVoxelMap*)this, result.types_in_collision, coll_threshold);
+    }
+    else
+    {
+      LOGGING_ERROR_C(VoxelmapLog, BitVoxelMap, "Map " << i << " can not be collided with a BitVoxelMap. " << GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+      result.num_collisions = SSIZE_MAX;
+      all_checked = false;
+    }
+  }
+
+  SVCollider collider(coll_threshold);
+  for (size_t first = 0; first < fused_maps.size(); first += cMAX_COLLISION_QUERY_MAPS)
+  {
+    CollisionQueryTargets<length> targets;
+    targets.num_maps = std::min<size_t>(cMAX_COLLISION_QUERY_MAPS, fused_maps.size() - first);
+    std::vector<const GpuVoxelsMap*> locked_maps(1, this);
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      GpuVoxelsMap* map = maps[fused_maps[first + m]];
+      targets.bit_maps[m] = map->is<BitVectorVoxelMap>()
+          ? (const BitVoxel<length>*)map->as<BitVectorVoxelMap>()->getConstDeviceDataPtr() : NULL;
+      targets.prob_maps[m] = map->is<ProbVoxelMap>() ? map->as<ProbVoxelMap>()->getConstDeviceDataPtr() : NULL;
+      locked_maps.push_back(map);
+    }
+
+    std::vector<uint32_t> num_collisions(targets.num_maps, 0);
+    std::vector<BitVector<length> > colliding_meanings(targets.num_maps);
+    {
+      MultiMapLock lock(locked_maps);
+      collisionCheckMaps(targets, collider, &num_collisions[0], &colliding_meanings[0]);
+    }
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      CollisionQueryResult& result = results[fused_maps[first + m]];
+      result.num_collisions = num_collisions[m];
+      result.types_in_collision.bitVector() = colliding_meanings[m];
+    }
+  }
+  return all_checked;
+}
+
+template<std::size_t length>
+template<class Collider>
+void BitVoxelMap<length>::collisionCheckMaps(const CollisionQueryTargets<length>& targets, Collider collider,
+                                             uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+  uint32_t num_bricks;
+  const bool use_bricks = this->collectOccupiedBricks(num_bricks);
+  const uint32_t* bricks = use_bricks ? this->m_dev_active_bricks : NULL;
+  const uint32_t num_voxels = use_bricks ? num_bricks * cVOXELS_PER_BRICK : this->m_voxelmap_size;
+  if (num_voxels == 0)
+  {
+    return;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    hostCollideVoxelMapWithMaps(this->m_dev_data, this->m_dim, num_voxels, bricks, targets, collider,
+                                num_collisions, colliding_meanings);
+    return;
+  }
+
+  const uint32_t threads_per_block = cCOLLISION_QUERY_THREADS_PER_BLOCK;
+  const uint32_t number_of_blocks = std::min((num_voxels + threads_per_block - 1) / threads_per_block,
+                                             cCOLLISION_QUERY_MAX_BLOCKS);
+  const uint32_t number_of_results = number_of_blocks * cMAX_COLLISION_QUERY_MAPS;
+
+  BitVector<length>* result_ptr_dev;
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&result_ptr_dev, sizeof(BitVector<length> ) * number_of_results));
+
+  uint32_t* num_collisions_dev;
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&num_collisions_dev, sizeof(uint32_t) * number_of_results));
+
+  kernelCollideVoxelMapWithMaps<<<number_of_blocks, threads_per_block,
+                                  sizeof(BitVector<length> ) * threads_per_block>>>(
+      this->m_dev_data, this->m_dim, num_voxels, bricks, targets, collider, result_ptr_dev, num_collisions_dev);
+  CHECK_CUDA_ERROR();
+
+  //copying result from device
+  std::vector<BitVector<length> > result_array(number_of_results);
+  std::vector<uint32_t> num_collisions_h(number_of_results);
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(&(result_array[0]), result_ptr_dev, sizeof(BitVector<length> ) * number_of_results,
+                 cudaMemcpyDeviceToHost));
+  HANDLE_CUDA_ERROR(
+      cudaMemcpy(&(num_collisions_h[0]), num_collisions_dev, sizeof(uint32_t) * number_of_results,
+                 cudaMemcpyDeviceToHost));
+  for (uint32_t b = 0; b < number_of_blocks; ++b)
+  {
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      colliding_meanings[m] |= result_array[b * cMAX_COLLISION_QUERY_MAPS + m];
+      num_collisions[m] += num_collisions_h[b * cMAX_COLLISION_QUERY_MAPS + m];
+    }
+  }
+
+  HANDLE_CUDA_ERROR(cudaFree(result_ptr_dev));
+  HANDLE_CUDA_ERROR(cudaFree(num_collisions_dev));
+}
 
 template<std::size_t length>
 bool BitVoxelMap<length>::insertRobotConfiguration(const MetaPointCloud *robot_links,
@@ -240,6 +468,11 @@ void BitVoxelMap<length>::shiftLeftSweptVolumeIDs(uint8_t shift_size)
     return;
   }
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    hostShiftBitVector(this->m_dev_data, this->m_voxelmap_size, shift_size);
+    return;
+  }
   kernelShiftBitVector<<<this->m_blocks, this->m_threads>>>(this->m_dev_data, this->m_voxelmap_size, shift_size);
   CHECK_CUDA_ERROR();
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
@@ -27,6 +27,7 @@
 #include <gpu_voxels/voxel/DistanceVoxel.h>
 
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
 using namespace gpu_voxels;
 
@@ -77,10 +78,67 @@ public:
   DistanceVoxel::pba_dist_t getObstacleDistance(const Vector3ui& pos);
   DistanceVoxel::pba_dist_t getObstacleDistance(uint x, uint y, uint z);
 
+  /**
+   * @brief queryObstacleDistances Evaluates the distance field at many metric points
+   * with one transfer in each direction. Points outside of the map are clamped to the map border,
+   * voxels without any obstacle in the map have a distance of sqrt(MAX_OBSTACLE_DISTANCE) voxels.
+   * @param points Metric query points
+   * @param distances If not NULL: metric distance of the voxel that contains the point
+   * @param interpolated_distances If not NULL: trilinear interpolation between the centers of the surrounding voxels
+   * @param gradients If not NULL: central difference gradient of the distances at the voxel that contains the point
+   */
+  void queryObstacleDistances(const std::vector<Vector3f>& points, std::vector<float>* distances,
+                              std::vector<float>* interpolated_distances = NULL,
+                              std::vector<Vector3f>* gradients = NULL);
+
+  //! Same as queryObstacleDistances() with points and results in device memory. The result pointers may be NULL.
+  void queryObstacleDistancesOnDevice(const Vector3f* dev_points, uint32_t num_points, float* dev_distances,
+                                      float* dev_interpolated_distances = NULL, Vector3f* dev_gradients = NULL);
+
+  //! Copies the distances into the host mirror that serves queryObstacleDistancesOnHost() and updateDistances().
+  void updateHostMirror();
+
+  /**
+   * @brief queryObstacleDistancesOnHost Same as queryObstacleDistances(), evaluated by the CPU on the host mirror.
+   * The mirror is downloaded on the first call and again whenever the map was written since the last download.
+   */
+  void queryObstacleDistancesOnHost(const std::vector<Vector3f>& points, std::vector<float>* distances,
+                                    std::vector<float>* interpolated_distances = NULL,
+                                    std::vector<Vector3f>* gradients = NULL);
+
   void extract_distances(free_space_t* dev_distances, int robot_radius) const;
   void init_floodfill(free_space_t* distances, manhattan_dist_t* manhattan_distances, uint robot_radius);
 
+  /**
+   * @brief updateDistances Incrementally repairs the distance field after obstacles were added or removed,
+   * instead of recomputing the whole map. Only the voxels whose closest obstacle changes are visited,
+   * so the cost depends on the changed region and not on the map volume. The repair runs on the host mirror
+   * and uploads the modified voxels. The map has to hold a complete distance field, e.g. from parallelBanding3D().
+   * The host mirror is downloaded again if the map was written by other means, e.g. by insertPointCloud() or clearMap().
+   * Writes through a device pointer that was obtained before the last update are not detected.
+   * The propagation may deviate from the exact distances by a fraction of a voxel, like jumpFlood3D().
+   * @param new_obstacles Voxel coordinates of newly occupied voxels
+   * @param removed_obstacles Voxel coordinates of freed voxels. Only list voxels that hold no obstacle anymore,
+   * the map keeps no count of the obstacles per voxel.
+   */
+  void updateDistances(const std::vector<Vector3ui>& new_obstacles, const std::vector<Vector3ui>& removed_obstacles);
+
   DistanceVoxel::accumulated_diff differences3D(const boost::shared_ptr<DistanceVoxelMap> other_map, int debug = 0, bool logging_reinit = true);
+
+protected:
+  //! Reports maps whose coordinates can not be encoded in the obstacle field of the DistanceVoxels
+  void checkDimensions() const;
+
+  //! True if the host mirror holds the current voxels
+  bool isHostMirrorValid() const;
+
+  //! Host copy of the distances for queryObstacleDistancesOnHost() and updateDistances()
+  std::vector<DistanceVoxel> m_host_mirror;
+  //! value of m_generation when the host mirror was downloaded
+  uint64_t m_host_mirror_generation;
+
+  //! Per voxel state of updateDistances(), all flags are zero between the updates
+  std::vector<uint8_t> m_raise_flags;
 };
 
 struct mergeOccupiedOperator
@@ -37,6 +37,8 @@
 #include <thrust/inner_product.h>
 #include <thrust/fill.h>
 #include <thrust/count.h>
+#include <thrust/copy.h>
+#include <thrust/scatter.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/tuple.h>
@@ -48,6 +50,7 @@
 #endif
 
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 
 namespace gpu_voxels {
 namespace voxelmap {
@@ -69,15 +72,25 @@ struct uninitialized_allocator : thrust::device_malloc_allocator<T>
 };
 
 DistanceVoxelMap::DistanceVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type) :
-    Base(dim, voxel_side_length, map_type)
+    Base(dim, voxel_side_length, map_type), m_host_mirror_generation(0)
 {
-
+  checkDimensions();
 }
 
 DistanceVoxelMap::DistanceVoxelMap(Voxel* dev_data, const Vector3ui dim, const float voxel_side_length, const MapType map_type) :
-    Base(dev_data, dim, voxel_side_length, map_type)
+    Base(dev_data, dim, voxel_side_length, map_type), m_host_mirror_generation(0)
 {
+  checkDimensions();
+}
 
+void DistanceVoxelMap::checkDimensions() const
+{
+  const uint32_t max_dim = uint32_t(PBA_UNINITIALISED_COORD);
+  if (m_dim.x > max_dim || m_dim.y > max_dim || m_dim.z > max_dim)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, DistanceVoxelMap, "DistanceVoxels can only encode " << max_dim
+                    << " voxels per axis, the map has " << m_dim << ". Build with GVL_DISTANCE_VOXEL_64BIT to support larger maps." << endl);
+  }
 }
 
 size_t DistanceVoxelMap::collideWithTypes(const GpuVoxelsMapSharedPtr other, BitVectorVoxel&  meanings_in_collision, float coll_threshold, const Vector3ui &offset) {
@@ -114,10 +127,10 @@ bool DistanceVoxelMap::mergeOccupied(const boost::shared_ptr<ProbVoxelMap> other
   thrust::transform_if(
         thrust::device_system_tag(),
 
-        thrust::make_zip_iterator( thrust::make_tuple(other->getDeviceDataPtr(),
+        thrust::make_zip_iterator( thrust::make_tuple(other->getConstDeviceDataPtr(),
                                                       thrust::counting_iterator<uint>(0) )),
 
-        thrust::make_zip_iterator( thrust::make_tuple(other->getDeviceDataPtr() + this->getVoxelMapSize(),
+        thrust::make_zip_iterator( thrust::make_tuple(other->getConstDeviceDataPtr() + this->getVoxelMapSize(),
                                                       thrust::counting_iterator<uint>(this->getVoxelMapSize()) )),
 
         this->getDeviceDataPtr(),
@@ -147,6 +160,7 @@ void DistanceVoxelMap::jumpFlood3D(int block_size, int debug, bool logging_reini
 #endif
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  ++m_generation;
 
   DistanceVoxel* temp_buffer;
   HANDLE_CUDA_ERROR(cudaMalloc(&temp_buffer, this->getMemoryUsage()));
@@ -218,6 +232,7 @@ void DistanceVoxelMap::exactDistances3D(std::vector<Vector3f>& points) {
       cudaMemcpy(d_points, &points[0], points.size() * sizeof(Vector3f), cudaMemcpyHostToDevice));
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  ++m_generation;
 
   dim3 blocks(this->m_blocks);
   uint total_threads = cMAX_THREADS_PER_BLOCK * cMAX_NR_OF_BLOCKS;
@@ -286,6 +301,7 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
 
   bool sync_always = detailtimer;
   if (sync_always); //ifndef IC_PERFORMANCE_MONITOR there would be a compiler warning otherwise
+  ++m_generation;
 
   //optimise m1,m2,m3; m3 is especially detrimental? (increases divergence)
   // m2, m3 works on dim.y first, then dim.x after transpose
@@ -491,7 +507,8 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
   // TODO: benchmark and/or delete texture usage: (initialResDesc, texDesc and initialTexObj)
   //TODO: use template specialisation to implement; run once with and without textures
 
-  // Specify texture
+#ifndef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
+  // Specify texture, the fetches read 32 bit voxels
   struct cudaResourceDesc initialResDesc;
   memset(&initialResDesc, 0, sizeof(initialResDesc));
   initialResDesc.resType = cudaResourceTypeLinear;
@@ -512,6 +529,7 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
   // Create texture object
   cudaTextureObject_t initialTexObj = 0;
   cudaCreateTextureObject(&initialTexObj, &initialResDesc, &texDesc, NULL);
+#endif
 
 
 
@@ -525,11 +543,16 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
     LOGGING_ERROR_C(VoxelmapLog, DistanceVoxelMap, "ERROR: PBA requires dimensions.x and .y >= arg_m2_blocksize (" << arg_m2_blocksize << ")" << endl);
   }
   //distance map is write-only during phase3
+#ifndef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
   kernelPBAphase3Distances
       <<< m3_grid_size, m3_block_size >>>
         (initialTexObj, distance_map_begin, this->m_dim);
+#else
+  kernelPBAphase3Distances
+      <<< m3_grid_size, m3_block_size >>>
+        (initial_map.begin(), distance_map_begin, this->m_dim);
+#endif
   CHECK_CUDA_ERROR();
-      //  (initial_map.begin(), distance_map_begin, this->m_dim);
   // phase 3 done: distance_map contains final result
 
 #ifdef IC_PERFORMANCE_MONITOR
@@ -603,10 +626,15 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
   // end of phase 2: initial_ contains P_i information; y coordinates were replaced by back-pointers; y coordinate is implicitly equal to voxel position.y
   // phase 3: read from input_, write to distance_map
   //optimise: scale PBA_M3_BLOCKX to m3; PBA_M3_BLOCKX*m3 should not be too small
+#ifndef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
   kernelPBAphase3Distances
       <<< m3_grid_size, m3_block_size >>>
-//      (initial_map.begin(), distance_map_begin, this->m_dim);
-      (initialTexObj, distance_map_begin, this->m_dim);
+        (initialTexObj, distance_map_begin, this->m_dim);
+#else
+  kernelPBAphase3Distances
+      <<< m3_grid_size, m3_block_size >>>
+        (initial_map.begin(), distance_map_begin, this->m_dim);
+#endif
   CHECK_CUDA_ERROR();
   // phase 3 done: distance_map contains final result
 
@@ -628,8 +656,10 @@ void DistanceVoxelMap::parallelBanding3D(uint32_t m1, uint32_t m2, uint32_t m3,
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 
+#ifndef _BUILD_GVL_WITH_64BIT_DISTANCE_VOXELS_
   // Destroy texture object
   cudaDestroyTextureObject(initialTexObj);
+#endif
 
 #ifdef IC_PERFORMANCE_MONITOR
   if (detailtimer) PERF_MON_PRINT_AND_RESET_INFO("detailtimer", "parallelBanding3D second transpose done");
@@ -649,6 +679,7 @@ void DistanceVoxelMap::clone(DistanceVoxelMap& other) {
   thrust::device_ptr<DistanceVoxel> this_begin(this->m_dev_data);
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  ++m_generation;
   thrust::copy(other_begin, other_end, this_begin);
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 }
@@ -662,6 +693,7 @@ void DistanceVoxelMap::fill_pba_uninit(DistanceVoxelMap& out) {
   thrust::device_ptr<DistanceVoxel> original_end(original_begin + out.getVoxelMapSize());
   DistanceVoxel dv_uninit;
   dv_uninit.setPBAUninitialised();
+  ++out.m_generation;
   thrust::fill(original_begin, original_end, dv_uninit);
 }
 
@@ -715,6 +747,142 @@ DistanceVoxel::pba_dist_t DistanceVoxelMap::getObstacleDistance(uint x, uint y,
   return sqrt(this->getSquaredObstacleDistance(x, y, z));
 }
 
+void DistanceVoxelMap::queryObstacleDistances(const std::vector<Vector3f>& points, std::vector<float>* distances,
+                                              std::vector<float>* interpolated_distances,
+                                              std::vector<Vector3f>* gradients)
+{
+  const uint32_t num_points = points.size();
+  if (num_points == 0)
+  {
+    if (distances) distances->clear();
+    if (interpolated_distances) interpolated_distances->clear();
+    if (gradients) gradients->clear();
+    return;
+  }
+
+  // one upload of the points and one download per requested result
+  thrust::device_vector<Vector3f> dev_points(points.begin(), points.end());
+  thrust::device_vector<float> dev_distances(distances ? num_points : 0);
+  thrust::device_vector<float> dev_interpolated_distances(interpolated_distances ? num_points : 0);
+  thrust::device_vector<Vector3f> dev_gradients(gradients ? num_points : 0);
+
+  queryObstacleDistancesOnDevice(thrust::raw_pointer_cast(dev_points.data()), num_points,
+                                 distances ? thrust::raw_pointer_cast(dev_distances.data()) : NULL,
+                                 interpolated_distances ? thrust::raw_pointer_cast(dev_interpolated_distances.data()) : NULL,
+                                 gradients ? thrust::raw_pointer_cast(dev_gradients.data()) : NULL);
+
+  if (distances)
+  {
+    distances->resize(num_points);
+    thrust::copy(dev_distances.begin(), dev_distances.end(), distances->begin());
+  }
+  if (interpolated_distances)
+  {
+    interpolated_distances->resize(num_points);
+    thrust::copy(dev_interpolated_distances.begin(), dev_interpolated_distances.end(), interpolated_distances->begin());
+  }
+  if (gradients)
+  {
+    gradients->resize(num_points);
+    thrust::copy(dev_gradients.begin(), dev_gradients.end(), gradients->begin());
+  }
+}
+
+void DistanceVoxelMap::queryObstacleDistancesOnDevice(const Vector3f* dev_points, uint32_t num_points,
+                                                      float* dev_distances, float* dev_interpolated_distances,
+                                                      Vector3f* dev_gradients)
+{
+  if (num_points == 0)
+  {
+    return;
+  }
+  uint32_t num_blocks;
+  uint32_t threads_per_block;
+  computeLinearLoad(num_points, &num_blocks, &threads_per_block);
+  kernelQueryObstacleDistances<<<num_blocks, threads_per_block>>>(m_dev_data, m_dim, m_voxel_side_length, dev_points,
+                                                                  num_points, dev_distances,
+                                                                  dev_interpolated_distances, dev_gradients);
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+}
+
+void DistanceVoxelMap::updateHostMirror()
+{
+  m_host_mirror.resize(m_voxelmap_size);
+  HANDLE_CUDA_ERROR(cudaMemcpy(&m_host_mirror[0], m_dev_data, m_voxelmap_size * sizeof(DistanceVoxel),
+                               cudaMemcpyDeviceToHost));
+  m_host_mirror_generation = m_generation;
+}
+
+bool DistanceVoxelMap::isHostMirrorValid() const
+{
+  return m_host_mirror.size() == m_voxelmap_size && m_host_mirror_generation == m_generation;
+}
+
+void DistanceVoxelMap::updateDistances(const std::vector<Vector3ui>& new_obstacles,
+                                       const std::vector<Vector3ui>& removed_obstacles)
+{
+  if (!isHostMirrorValid())
+  {
+    updateHostMirror();
+  }
+  if (m_raise_flags.size() != m_voxelmap_size)
+  {
+    m_raise_flags.assign(m_voxelmap_size, 0);
+  }
+
+  std::vector<uint32_t> changed_voxels;
+  hostUpdateDistances(&m_host_mirror[0], &m_raise_flags[0], m_dim, new_obstacles, removed_obstacles, changed_voxels);
+  if (changed_voxels.empty())
+  {
+    return;
+  }
+
+  // upload only the modified voxels
+  std::sort(changed_voxels.begin(), changed_voxels.end());
+  changed_voxels.erase(std::unique(changed_voxels.begin(), changed_voxels.end()), changed_voxels.end());
+  std::vector<DistanceVoxel> changed_values(changed_voxels.size());
+  for (size_t i = 0; i < changed_voxels.size(); ++i)
+  {
+    changed_values[i] = m_host_mirror[changed_voxels[i]];
+  }
+  thrust::device_vector<uint32_t> dev_indices(changed_voxels.begin(), changed_voxels.end());
+  thrust::device_vector<DistanceVoxel> dev_values(changed_values.begin(), changed_values.end());
+  thrust::scatter(dev_values.begin(), dev_values.end(), dev_indices.begin(),
+                  thrust::device_ptr<DistanceVoxel>(m_dev_data));
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  // the mirror already holds the uploaded voxels
+  ++m_generation;
+  m_host_mirror_generation = m_generation;
+
+  LOGGING_DEBUG(VoxelmapLog, "updateDistances: " << new_obstacles.size() << " new and " << removed_obstacles.size()
+                << " removed obstacles changed " << changed_voxels.size() << " voxels" << endl);
+}
+
+void DistanceVoxelMap::queryObstacleDistancesOnHost(const std::vector<Vector3f>& points, std::vector<float>* distances,
+                                                    std::vector<float>* interpolated_distances,
+                                                    std::vector<Vector3f>* gradients)
+{
+  if (!isHostMirrorValid())
+  {
+    updateHostMirror();
+  }
+  const int64_t num_points = points.size();
+  if (distances) distances->resize(num_points);
+  if (interpolated_distances) interpolated_distances->resize(num_points);
+  if (gradients) gradients->resize(num_points);
+
+  const DistanceVoxel* voxels = &m_host_mirror[0];
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < num_points; ++i)
+  {
+    queryObstacleDistance(voxels, m_dim, m_voxel_side_length, points[i],
+                          distances ? &(*distances)[i] : NULL,
+                          interpolated_distances ? &(*interpolated_distances)[i] : NULL,
+                          gradients ? &(*gradients)[i] : NULL);
+  }
+}
+
 /**
  * @brief DistanceVoxelMap::differences3D
  * @param other
@@ -29,6 +29,7 @@
 #include <gpu_voxels/helpers/common_defines.h>
 #include <gpu_voxels/helpers/cuda_datatypes.h>
 #include <gpu_voxels/helpers/CollisionInterfaces.h>
+#include <gpu_voxels/helpers/FreeSpaceRayCaster.h>
 
 namespace gpu_voxels {
 namespace voxelmap {
@@ -40,7 +41,8 @@ public:
   typedef ProbabilisticVoxel Voxel;
   typedef TemplateVoxelMap<Voxel> Base;
 
-  ProbVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type);
+  ProbVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type,
+               const MapBackend backend = MB_DEVICE);
   ProbVoxelMap(Voxel* dev_data, const Vector3ui dim, const float voxel_side_length, const MapType map_type);
   virtual ~ProbVoxelMap();
 
@@ -48,6 +50,28 @@ public:
   void insertSensorData(const Vector3f* points, const bool enable_raycasting, const bool cut_real_robot,
                         const BitVoxelMeaning voxel_meaning, BitVoxel<length>* robot_map = NULL);
 
+  /*!
+   * \brief insertSensorDataOnDevice Inserts sensor points, which are already transformed into
+   * the map frame and copied to the device. The sensor does not have to be set with
+   * initSensorSettings(), so several sensors can insert into the same map.
+   * The insertion runs in \a stream and the call returns when it is done.
+   * \param dev_sensor Device copy of the sensor, its data_size has to be \a num_points
+   * \param dev_points Device array of \a num_points transformed points
+   */
+  template<std::size_t length>
+  void insertSensorDataOnDevice(const Sensor* dev_sensor, const Vector3f* dev_points, const uint32_t num_points,
+                                const bool enable_raycasting, const bool cut_real_robot,
+                                const BitVoxelMeaning voxel_meaning, BitVoxel<length>* robot_map = NULL,
+                                cudaStream_t stream = 0);
+
+  /*!
+   * \brief insertRayCasterResults Updates the free and occupied voxels of the last
+   * FreeSpaceRayCaster::castRays() once each, no matter how many rays touched them.
+   * The volume of the ray caster has to lie inside of this map and use its voxel side length.
+   * Works with both backends.
+   */
+  void insertRayCasterResults(const FreeSpaceRayCaster& ray_caster);
+
   virtual bool insertRobotConfiguration(const MetaPointCloud *robot_links, bool with_self_collision_test);
 
   virtual void clearBitVoxelMeaning(BitVoxelMeaning voxel_meaning);
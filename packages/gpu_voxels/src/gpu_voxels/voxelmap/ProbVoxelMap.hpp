@@ -32,8 +32,9 @@
 namespace gpu_voxels {
 namespace voxelmap {
 
-ProbVoxelMap::ProbVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type) :
-    Base(dim, voxel_side_length, map_type)
+ProbVoxelMap::ProbVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type,
+                           const MapBackend backend) :
+    Base(dim, voxel_side_length, map_type, backend)
 {
 
 }
@@ -55,6 +56,11 @@ void ProbVoxelMap::insertSensorData(const Vector3f* points, const bool enable_ra
                                     BitVoxel<length>* robot_map)
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, ProbVoxelMap, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+    return;
+  }
   //  printf("got lock ----------------------------------------------------\n");
   //  if (enable_raycasting)
   //  {
@@ -69,6 +75,9 @@ void ProbVoxelMap::insertSensorData(const Vector3f* points, const bool enable_ra
 
   copySensorDataToDevice(points);
   transformSensorData();
+  // ray casting writes free space along the rays, which is not tracked by the brick index
+  m_brick_index_valid = false;
+  ++m_generation;
   if (enable_raycasting)
   {
     // for debugging ray casting:
@@ -101,6 +110,97 @@ void ProbVoxelMap::insertSensorData(const Vector3f* points, const bool enable_ra
 //  printf("update counter: %u\n", m_update_counter);
 }
 
+template<std::size_t length>
+void ProbVoxelMap::insertSensorDataOnDevice(const Sensor* dev_sensor, const Vector3f* dev_points,
+                                            const uint32_t num_points, const bool enable_raycasting,
+                                            const bool cut_real_robot, const BitVoxelMeaning voxel_meaning,
+                                            BitVoxel<length>* robot_map, cudaStream_t stream)
+{
+  lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, ProbVoxelMap, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+    return;
+  }
+  if (num_points == 0)
+  {
+    return;
+  }
+  m_brick_index_valid = false;
+  ++m_generation;
+
+  uint32_t blocks, threads;
+  computeLinearLoad(num_points, &blocks, &threads);
+  if (enable_raycasting)
+  {
+    kernelInsertSensorData<<<blocks, threads, 0, stream>>>(
+        m_dev_data, m_voxelmap_size, m_dim, m_voxel_side_length, const_cast<Sensor*>(dev_sensor),
+        dev_points, cut_real_robot, robot_map, voxel_meaning, RayCaster());
+  }
+  else
+  {
+    kernelInsertSensorData<<<blocks, threads, 0, stream>>>(
+        m_dev_data, m_voxelmap_size, m_dim, m_voxel_side_length, const_cast<Sensor*>(dev_sensor),
+        dev_points, cut_real_robot, robot_map, voxel_meaning, DummyRayCaster());
+  }
+  CHECK_CUDA_ERROR();
+  HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+}
+
+void ProbVoxelMap::insertRayCasterResults(const FreeSpaceRayCaster& ray_caster)
+{
+  lock_guard guard(this->m_mutex);
+  const Vector3ui& offset = ray_caster.getOffset();
+  const Vector3ui& dim = ray_caster.getDimensions();
+  if (!(offset <= m_dim) || !(dim <= m_dim - offset) || ray_caster.getVoxelSideLength() != m_voxel_side_length)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, ProbVoxelMap, "The ray caster does not fit to the map!" << endl);
+    return;
+  }
+  // the free space is not tracked by the brick index
+  m_brick_index_valid = false;
+  ++m_generation;
+
+  // the indices of the ray caster are relative to its volume
+  std::vector<uint32_t> free_voxels(ray_caster.getFreeVoxels().size());
+  std::vector<uint32_t> occupied_voxels(ray_caster.getOccupiedVoxels().size());
+  for (size_t i = 0; i < free_voxels.size(); ++i)
+  {
+    free_voxels[i] = getVoxelIndexUnsigned(m_dim, ray_caster.getVoxelCoordinates(ray_caster.getFreeVoxels()[i]));
+  }
+  for (size_t i = 0; i < occupied_voxels.size(); ++i)
+  {
+    occupied_voxels[i] = getVoxelIndexUnsigned(m_dim,
+                                               ray_caster.getVoxelCoordinates(ray_caster.getOccupiedVoxels()[i]));
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    hostUpdateOccupancy(m_dev_data, free_voxels.data(), free_voxels.size(), cSENSOR_MODEL_FREE);
+    hostUpdateOccupancy(m_dev_data, occupied_voxels.data(), occupied_voxels.size(), cSENSOR_MODEL_OCCUPIED);
+    return;
+  }
+
+  uint32_t blocks, threads;
+  if (!free_voxels.empty())
+  {
+    thrust::device_vector<uint32_t> dev_free_voxels(free_voxels.begin(), free_voxels.end());
+    computeLinearLoad(free_voxels.size(), &blocks, &threads);
+    kernelUpdateOccupancy<<<blocks, threads>>>(m_dev_data, thrust::raw_pointer_cast(dev_free_voxels.data()),
+                                               free_voxels.size(), cSENSOR_MODEL_FREE);
+    CHECK_CUDA_ERROR();
+  }
+  if (!occupied_voxels.empty())
+  {
+    thrust::device_vector<uint32_t> dev_occupied_voxels(occupied_voxels.begin(), occupied_voxels.end());
+    computeLinearLoad(occupied_voxels.size(), &blocks, &threads);
+    kernelUpdateOccupancy<<<blocks, threads>>>(m_dev_data, thrust::raw_pointer_cast(dev_occupied_voxels.data()),
+                                               occupied_voxels.size(), cSENSOR_MODEL_OCCUPIED);
+    CHECK_CUDA_ERROR();
+  }
+  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+}
+
 bool ProbVoxelMap::insertRobotConfiguration(const MetaPointCloud *robot_links, bool with_self_collision_test)
 {
   LOGGING_ERROR_C(VoxelmapLog, ProbVoxelMap, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
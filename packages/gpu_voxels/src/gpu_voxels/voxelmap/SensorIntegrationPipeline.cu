@@ -0,0 +1,421 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Implementation of the streaming sensor integration pipeline.
+ *
+ */
+//----------------------------------------------------------------------
+#include "SensorIntegrationPipeline.h"
+
+#include <cmath>
+#include <cstring>
+#include <boost/bind.hpp>
+#include <gpu_voxels/helpers/cuda_handling.h>
+#include <gpu_voxels/logging/logging_voxelmap.h>
+
+namespace gpu_voxels {
+namespace voxelmap {
+
+namespace {
+
+double elapsedMs(const icl_core::TimeStamp& start, const icl_core::TimeStamp& end)
+{
+  return (end - start).toNSec() * 1e-6;
+}
+
+void idle()
+{
+  boost::this_thread::sleep_for(boost::chrono::microseconds(cSENSOR_PIPELINE_IDLE_SLEEP_US));
+}
+
+} // end of anonymous namespace
+
+// The queue follows the bounded MPMC queue of Dmitry Vyukov: every cell carries a sequence
+// number, which tells producers and consumers whether the cell is theirs in the current lap.
+SensorFrameQueue::SensorFrameQueue(const uint32_t capacity)
+  : m_enqueue_position(0),
+    m_dequeue_position(0)
+{
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+  m_cells = new Cell[size];
+  for (size_t i = 0; i < size; ++i)
+  {
+    m_cells[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+  m_mask = size - 1;
+}
+
+SensorFrameQueue::~SensorFrameQueue()
+{
+  delete[] m_cells;
+}
+
+bool SensorFrameQueue::push(const uint32_t index)
+{
+  Cell* cell;
+  size_t position = m_enqueue_position.load(boost::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[position & m_mask];
+    const size_t sequence = cell->sequence.load(boost::memory_order_acquire);
+    const ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position);
+    if (difference == 0)
+    {
+      if (m_enqueue_position.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;
+    }
+    else
+    {
+      position = m_enqueue_position.load(boost::memory_order_relaxed);
+    }
+  }
+  cell->index = index;
+  cell->sequence.store(position + 1, boost::memory_order_release);
+  return true;
+}
+
+bool SensorFrameQueue::pop(uint32_t& index)
+{
+  Cell* cell;
+  size_t position = m_dequeue_position.load(boost::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[position & m_mask];
+    const size_t sequence = cell->sequence.load(boost::memory_order_acquire);
+    const ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position + 1);
+    if (difference == 0)
+    {
+      if (m_dequeue_position.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;
+    }
+    else
+    {
+      position = m_dequeue_position.load(boost::memory_order_relaxed);
+    }
+  }
+  index = cell->index;
+  cell->sequence.store(position + m_mask + 1, boost::memory_order_release);
+  return true;
+}
+
+
+// Every queue can hold all buffers, so pushing an index never fails.
+SensorIntegrationPipeline::SensorIntegrationPipeline(ProbVoxelMap* map, const SensorPipelineParameters& parameters)
+  : m_map(map),
+    m_parameters(parameters),
+    m_device(0),
+    m_host_sensors(NULL),
+    m_dev_sensors(NULL),
+    m_upload_stream(0),
+    m_integration_stream(0),
+    m_free_frames(std::max(parameters.queue_capacity, 1u) + 2),
+    m_input_frames(std::max(parameters.queue_capacity, 1u) + 2),
+    m_preprocessed_frames(std::max(parameters.queue_capacity, 1u) + 2),
+    m_free_device_frames(std::max(parameters.device_buffers, 1u)),
+    m_uploaded_frames(std::max(parameters.device_buffers, 1u)),
+    m_running(false),
+    m_preprocessing_running(false),
+    m_upload_running(false),
+    m_preprocessing_thread(NULL),
+    m_upload_thread(NULL),
+    m_integration_thread(NULL),
+    m_frames_pushed(0),
+    m_frames_finished(0)
+{
+  m_parameters.queue_capacity = std::max(m_parameters.queue_capacity, 1u);
+  m_parameters.device_buffers = std::max(m_parameters.device_buffers, 1u);
+  m_parameters.decimation = std::max(m_parameters.decimation, 1u);
+  if (m_map->getBackend() == MB_HOST)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, SensorIntegrationPipeline, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+    return;
+  }
+
+  HANDLE_CUDA_ERROR(cudaGetDevice(&m_device));
+  // the upload stream does not touch the map, the integration stream is ordered with the map operations
+  // in the default stream
+  HANDLE_CUDA_ERROR(cudaStreamCreateWithFlags(&m_upload_stream, cudaStreamNonBlocking));
+  HANDLE_CUDA_ERROR(cudaStreamCreate(&m_integration_stream));
+
+  m_host_frames.resize(m_parameters.queue_capacity + 2);
+  HANDLE_CUDA_ERROR(cudaMallocHost((void**)&m_host_sensors, m_host_frames.size() * sizeof(Sensor)));
+  for (uint32_t i = 0; i < m_host_frames.size(); ++i)
+  {
+    HANDLE_CUDA_ERROR(cudaMallocHost((void**)&m_host_frames[i].points, m_parameters.max_points * sizeof(Vector3f)));
+    m_host_frames[i].num_points = 0;
+    m_free_frames.push(i);
+  }
+  m_device_frames.resize(m_parameters.device_buffers);
+  HANDLE_CUDA_ERROR(cudaMalloc((void**)&m_dev_sensors, m_device_frames.size() * sizeof(Sensor)));
+  for (uint32_t i = 0; i < m_device_frames.size(); ++i)
+  {
+    HANDLE_CUDA_ERROR(cudaMalloc((void**)&m_device_frames[i].dev_points, m_parameters.max_points * sizeof(Vector3f)));
+    m_device_frames[i].num_points = 0;
+    m_free_device_frames.push(i);
+  }
+
+  m_running.store(true, boost::memory_order_release);
+  m_preprocessing_running.store(true, boost::memory_order_release);
+  m_upload_running.store(true, boost::memory_order_release);
+  m_preprocessing_thread = m_stage_threads.create_thread(boost::bind(&SensorIntegrationPipeline::preprocessingLoop, this));
+  m_upload_thread = m_stage_threads.create_thread(boost::bind(&SensorIntegrationPipeline::uploadLoop, this));
+  m_integration_thread = m_stage_threads.create_thread(boost::bind(&SensorIntegrationPipeline::integrationLoop, this));
+}
+
+SensorIntegrationPipeline::~SensorIntegrationPipeline()
+{
+  stop();
+  for (size_t i = 0; i < m_host_frames.size(); ++i)
+  {
+    HANDLE_CUDA_ERROR(cudaFreeHost(m_host_frames[i].points));
+  }
+  for (size_t i = 0; i < m_device_frames.size(); ++i)
+  {
+    HANDLE_CUDA_ERROR(cudaFree(m_device_frames[i].dev_points));
+  }
+  if (m_host_sensors)
+  {
+    HANDLE_CUDA_ERROR(cudaFreeHost(m_host_sensors));
+    HANDLE_CUDA_ERROR(cudaFree(m_dev_sensors));
+    HANDLE_CUDA_ERROR(cudaStreamDestroy(m_upload_stream));
+    HANDLE_CUDA_ERROR(cudaStreamDestroy(m_integration_stream));
+  }
+}
+
+bool SensorIntegrationPipeline::pushFrame(const Sensor& sensor, const Vector3f* points, const uint32_t num_points)
+{
+  if (!m_running.load(boost::memory_order_acquire))
+  {
+    return false;
+  }
+  if (num_points > m_parameters.max_points)
+  {
+    LOGGING_WARNING_C(VoxelmapLog, SensorIntegrationPipeline, "Rejected a frame of " << num_points <<
+                      " points, the pipeline was set up for " << m_parameters.max_points << " points." << endl);
+    boost::mutex::scoped_lock lock(m_statistics_mutex);
+    ++m_statistics.frames_rejected;
+    return false;
+  }
+
+  uint32_t frame;
+  while (!m_free_frames.pop(frame))
+  {
+    // the frames that wait for the upload are older than the ones that wait for the preprocessing
+    if (m_parameters.back_pressure == eSBP_DROP_OLDEST
+        && (m_preprocessed_frames.pop(frame) || m_input_frames.pop(frame)))
+    {
+      {
+        boost::mutex::scoped_lock lock(m_statistics_mutex);
+        ++m_statistics.frames_dropped;
+      }
+      m_frames_finished.fetch_add(1, boost::memory_order_release);
+      break;
+    }
+    if (!m_running.load(boost::memory_order_acquire))
+    {
+      return false;
+    }
+    idle();
+  }
+
+  HostFrame& host_frame = m_host_frames[frame];
+  memcpy(host_frame.points, points, num_points * sizeof(Vector3f));
+  host_frame.num_points = num_points;
+  host_frame.push_time = icl_core::TimeStamp::now();
+  m_host_sensors[frame] = sensor;
+  {
+    boost::mutex::scoped_lock lock(m_statistics_mutex);
+    ++m_statistics.frames_pushed;
+  }
+  m_frames_pushed.fetch_add(1, boost::memory_order_release);
+  m_input_frames.push(frame);
+  return true;
+}
+
+bool SensorIntegrationPipeline::pushFrame(const Sensor& sensor, const std::vector<Vector3f>& points)
+{
+  return pushFrame(sensor, points.empty() ? NULL : &points[0], uint32_t(points.size()));
+}
+
+void SensorIntegrationPipeline::flush()
+{
+  while (m_frames_finished.load(boost::memory_order_acquire) < m_frames_pushed.load(boost::memory_order_acquire))
+  {
+    idle();
+  }
+}
+
+void SensorIntegrationPipeline::stop()
+{
+  if (!m_running.exchange(false, boost::memory_order_acq_rel))
+  {
+    return;
+  }
+  // every stage finishes the frames of its input queue before the next stage is told to stop
+  m_preprocessing_thread->join();
+  m_preprocessing_running.store(false, boost::memory_order_release);
+  m_upload_thread->join();
+  m_upload_running.store(false, boost::memory_order_release);
+  m_integration_thread->join();
+}
+
+SensorPipelineStatistics SensorIntegrationPipeline::getStatistics() const
+{
+  boost::mutex::scoped_lock lock(m_statistics_mutex);
+  return m_statistics;
+}
+
+void SensorIntegrationPipeline::resetStatistics()
+{
+  boost::mutex::scoped_lock lock(m_statistics_mutex);
+  m_statistics = SensorPipelineStatistics();
+}
+
+bool SensorIntegrationPipeline::waitForIndex(SensorFrameQueue& queue, const boost::atomic<bool>& upstream_running,
+                                             uint32_t& index)
+{
+  while (!queue.pop(index))
+  {
+    if (!upstream_running.load(boost::memory_order_acquire))
+    {
+      // the upstream stage may have pushed its last frame right before it stopped
+      return queue.pop(index);
+    }
+    idle();
+  }
+  return true;
+}
+
+void SensorIntegrationPipeline::preprocess(const uint32_t frame)
+{
+  HostFrame& host_frame = m_host_frames[frame];
+  Sensor& sensor = m_host_sensors[frame];
+  const float min_range_squared = m_parameters.min_range * m_parameters.min_range;
+  const float max_range_squared = m_parameters.max_range * m_parameters.max_range;
+
+  // the points are compacted in place, a point is never written behind the one that is read
+  uint32_t num_points = 0;
+  for (uint32_t i = 0; i < host_frame.num_points; i += m_parameters.decimation)
+  {
+    const Vector3f point = host_frame.points[i];
+    if (std::isnan(point.x) || std::isnan(point.y) || std::isnan(point.z))
+    {
+      continue;
+    }
+    const float range_squared = point.x * point.x + point.y * point.y + point.z * point.z;
+    if (range_squared < min_range_squared || range_squared > max_range_squared)
+    {
+      continue;
+    }
+    host_frame.points[num_points++] = sensor.orientation * point + sensor.position;
+  }
+  host_frame.num_points = num_points;
+  sensor.data_width = num_points;
+  sensor.data_height = 1;
+  sensor.data_size = num_points;
+}
+
+void SensorIntegrationPipeline::preprocessingLoop()
+{
+  uint32_t frame;
+  while (waitForIndex(m_input_frames, m_running, frame))
+  {
+    const icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    const icl_core::TimeStamp push_time = m_host_frames[frame].push_time;
+    preprocess(frame);
+    const icl_core::TimeStamp end = icl_core::TimeStamp::now();
+    {
+      boost::mutex::scoped_lock lock(m_statistics_mutex);
+      m_statistics.waiting.add(elapsedMs(push_time, start));
+      m_statistics.preprocessing.add(elapsedMs(start, end));
+    }
+    m_preprocessed_frames.push(frame);
+  }
+}
+
+void SensorIntegrationPipeline::uploadLoop()
+{
+  HANDLE_CUDA_ERROR(cudaSetDevice(m_device));
+  uint32_t frame;
+  while (waitForIndex(m_preprocessed_frames, m_preprocessing_running, frame))
+  {
+    const icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    uint32_t device_frame;
+    while (!m_free_device_frames.pop(device_frame))
+    {
+      idle();
+    }
+    const HostFrame& host_frame = m_host_frames[frame];
+    DeviceFrame& dev_frame = m_device_frames[device_frame];
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(m_dev_sensors + device_frame, m_host_sensors + frame, sizeof(Sensor),
+                                      cudaMemcpyHostToDevice, m_upload_stream));
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(dev_frame.dev_points, host_frame.points, host_frame.num_points * sizeof(Vector3f),
+                                      cudaMemcpyHostToDevice, m_upload_stream));
+    dev_frame.num_points = host_frame.num_points;
+    dev_frame.push_time = host_frame.push_time;
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(m_upload_stream));
+    m_free_frames.push(frame);
+    {
+      boost::mutex::scoped_lock lock(m_statistics_mutex);
+      m_statistics.upload.add(elapsedMs(start, icl_core::TimeStamp::now()));
+    }
+    m_uploaded_frames.push(device_frame);
+  }
+}
+
+void SensorIntegrationPipeline::integrationLoop()
+{
+  HANDLE_CUDA_ERROR(cudaSetDevice(m_device));
+  uint32_t device_frame;
+  while (waitForIndex(m_uploaded_frames, m_upload_running, device_frame))
+  {
+    const icl_core::TimeStamp start = icl_core::TimeStamp::now();
+    const DeviceFrame& dev_frame = m_device_frames[device_frame];
+    const icl_core::TimeStamp push_time = dev_frame.push_time;
+    m_map->insertSensorDataOnDevice<BIT_VECTOR_LENGTH>(m_dev_sensors + device_frame, dev_frame.dev_points,
+                                                       dev_frame.num_points, m_parameters.enable_raycasting, false,
+                                                       eBVM_OCCUPIED, NULL, m_integration_stream);
+    const icl_core::TimeStamp end = icl_core::TimeStamp::now();
+    m_free_device_frames.push(device_frame);
+    {
+      boost::mutex::scoped_lock lock(m_statistics_mutex);
+      ++m_statistics.frames_integrated;
+      m_statistics.integration.add(elapsedMs(start, end));
+      m_statistics.total.add(elapsedMs(push_time, end));
+    }
+    m_frames_finished.fetch_add(1, boost::memory_order_release);
+  }
+}
+
+} // end of namespace
+} // end of namespace
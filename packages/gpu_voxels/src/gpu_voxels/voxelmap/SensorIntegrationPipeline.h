@@ -0,0 +1,285 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Streaming integration of sensor frames into a ProbVoxelMap. Frames
+ * of any number of producer threads pass through three stages, each
+ * running in its own thread: preprocessing on the host (range cut,
+ * decimation and transformation into the map frame), the upload to the
+ * device and the ray casting and map update. The stages are connected
+ * by bounded lock-free queues and all memory is allocated up front, so
+ * a stalling stage can only hold back a fixed number of frames.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_VOXELMAP_SENSOR_INTEGRATION_PIPELINE_H_INCLUDED
+#define GPU_VOXELS_VOXELMAP_SENSOR_INTEGRATION_PIPELINE_H_INCLUDED
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <cuda_runtime.h>
+
+#include <icl_core/TimeStamp.h>
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+#include <gpu_voxels/voxelmap/ProbVoxelMap.h>
+
+namespace gpu_voxels {
+namespace voxelmap {
+
+//! Sleep time of idle pipeline stages and waiting producers
+static const uint32_t cSENSOR_PIPELINE_IDLE_SLEEP_US = 100;
+
+/*!
+ * \brief The SensorBackPressure enum determines what pushFrame() does when all frame buffers are in use.
+ */
+enum SensorBackPressure
+{
+  eSBP_DROP_OLDEST, // The oldest frame that was not uploaded yet is dropped
+  eSBP_BLOCK        // The producer waits until a frame buffer is free
+};
+
+/*!
+ * \brief The SensorPipelineParameters struct configures a SensorIntegrationPipeline.
+ */
+struct SensorPipelineParameters
+{
+  SensorPipelineParameters()
+    : max_points(640 * 480),
+      queue_capacity(4),
+      device_buffers(2),
+      back_pressure(eSBP_DROP_OLDEST),
+      min_range(0.0f),
+      max_range(std::numeric_limits<float>::max()),
+      decimation(1),
+      enable_raycasting(true)
+  {
+  }
+
+  uint32_t max_points;         //!< Maximum number of points per frame, larger frames are rejected
+  uint32_t queue_capacity;     //!< Number of frames that may wait for preprocessing
+  uint32_t device_buffers;     //!< Number of frames that may be on the device at once
+  SensorBackPressure back_pressure;
+  float min_range;             //!< Points closer to the sensor are removed
+  float max_range;             //!< Points farther from the sensor are removed
+  uint32_t decimation;         //!< Only every n-th point of a frame is kept
+  bool enable_raycasting;      //!< Decreases the occupancy along the rays to the points
+};
+
+/*!
+ * \brief The SensorPipelineStageStatistics struct holds the latencies of one stage.
+ */
+struct SensorPipelineStageStatistics
+{
+  SensorPipelineStageStatistics()
+    : frames(0),
+      total_ms(0.0),
+      max_ms(0.0)
+  {
+  }
+
+  void add(const double ms)
+  {
+    ++frames;
+    total_ms += ms;
+    max_ms = std::max(max_ms, ms);
+  }
+
+  double averageMs() const { return frames ? total_ms / frames : 0.0; }
+
+  size_t frames;
+  double total_ms;
+  double max_ms;
+};
+
+/*!
+ * \brief The SensorPipelineStatistics struct holds the frame counters and the latencies of all stages.
+ */
+struct SensorPipelineStatistics
+{
+  SensorPipelineStatistics()
+    : frames_pushed(0),
+      frames_rejected(0),
+      frames_dropped(0),
+      frames_integrated(0)
+  {
+  }
+
+  size_t frames_pushed;
+  size_t frames_rejected;   //!< Frames with more than max_points points
+  size_t frames_dropped;    //!< Frames that were dropped by eSBP_DROP_OLDEST
+  size_t frames_integrated;
+
+  SensorPipelineStageStatistics waiting;       //!< From pushFrame() until the preprocessing starts
+  SensorPipelineStageStatistics preprocessing;
+  SensorPipelineStageStatistics upload;        //!< Including the wait for a free device buffer
+  SensorPipelineStageStatistics integration;   //!< Ray casting and map update
+  SensorPipelineStageStatistics total;         //!< From pushFrame() until the map is updated
+};
+
+/*!
+ * \brief The SensorFrameQueue class is a bounded lock-free queue of frame buffer indices,
+ * which may be used by several producer and consumer threads.
+ */
+class SensorFrameQueue
+{
+public:
+  //! The capacity is rounded up to the next power of two
+  explicit SensorFrameQueue(const uint32_t capacity);
+  ~SensorFrameQueue();
+
+  //! Returns false if the queue is full
+  bool push(const uint32_t index);
+
+  //! Returns false if the queue is empty
+  bool pop(uint32_t& index);
+
+private:
+  struct Cell
+  {
+    boost::atomic<size_t> sequence;
+    uint32_t index;
+  };
+
+  SensorFrameQueue(const SensorFrameQueue&);
+  SensorFrameQueue& operator=(const SensorFrameQueue&);
+
+  Cell* m_cells;
+  size_t m_mask;
+  boost::atomic<size_t> m_enqueue_position;
+  //! Keeps both positions on different cache lines.
+  char m_padding[64];
+  boost::atomic<size_t> m_dequeue_position;
+};
+
+/*!
+ * \brief The SensorIntegrationPipeline class integrates sensor frames of several producer
+ * threads into a ProbVoxelMap of the device backend.
+ *
+ * pushFrame() copies a frame into a free frame buffer and returns. The preprocessing thread
+ * removes invalid points and points out of range, decimates the frame and transforms it into
+ * the map frame. The upload thread copies the frame into a free device buffer in its own
+ * stream, which frees the frame buffer again. The integration thread casts the rays and updates
+ * the map, which is locked only during this stage.
+ * There are queue_capacity + 2 frame buffers and device_buffers device buffers. When all frame
+ * buffers are in use, the back pressure policy decides whether the producer waits or the oldest
+ * frame that was not uploaded yet is replaced.
+ */
+class SensorIntegrationPipeline
+{
+public:
+  //! Allocates all buffers and starts the stage threads
+  SensorIntegrationPipeline(ProbVoxelMap* map, const SensorPipelineParameters& parameters = SensorPipelineParameters());
+
+  //! Integrates all pushed frames and stops the stage threads
+  ~SensorIntegrationPipeline();
+
+  /*!
+   * \brief pushFrame Passes a frame to the pipeline. May be called by several threads at once.
+   * \param sensor The pose of the sensor in the map frame
+   * \param points The points in the sensor frame, NaN points are removed
+   * \return false if the frame has too many points or the pipeline was stopped
+   */
+  bool pushFrame(const Sensor& sensor, const Vector3f* points, const uint32_t num_points);
+  bool pushFrame(const Sensor& sensor, const std::vector<Vector3f>& points);
+
+  //! Blocks until all frames pushed so far are integrated or dropped
+  void flush();
+
+  /*!
+   * \brief stop Integrates all pushed frames and stops the stage threads. Afterwards
+   * pushFrame() rejects all frames. Must not be called while other threads push frames.
+   */
+  void stop();
+
+  SensorPipelineStatistics getStatistics() const;
+  void resetStatistics();
+
+  const SensorPipelineParameters& getParameters() const { return m_parameters; }
+
+private:
+  //! A frame buffer in pinned host memory
+  struct HostFrame
+  {
+    Vector3f* points;
+    uint32_t num_points;
+    icl_core::TimeStamp push_time;
+  };
+
+  //! A frame buffer on the device, the sensor of buffer i is m_dev_sensors[i]
+  struct DeviceFrame
+  {
+    Vector3f* dev_points;
+    uint32_t num_points;
+    icl_core::TimeStamp push_time;
+  };
+
+  SensorIntegrationPipeline(const SensorIntegrationPipeline&);
+  SensorIntegrationPipeline& operator=(const SensorIntegrationPipeline&);
+
+  void preprocessingLoop();
+  void uploadLoop();
+  void integrationLoop();
+
+  //! Removes the points that are not used and transforms the others into the map frame
+  void preprocess(const uint32_t frame);
+
+  /*!
+   * Pops the next index of \a queue and waits while it is empty.
+   * Returns false if the queue is empty and \a upstream_running is false.
+   */
+  bool waitForIndex(SensorFrameQueue& queue, const boost::atomic<bool>& upstream_running, uint32_t& index);
+
+  ProbVoxelMap* m_map;
+  SensorPipelineParameters m_parameters;
+  int m_device;
+
+  std::vector<HostFrame> m_host_frames;
+  Sensor* m_host_sensors;                   //!< pinned, one per frame buffer
+  std::vector<DeviceFrame> m_device_frames;
+  Sensor* m_dev_sensors;                    //!< one per device buffer
+  cudaStream_t m_upload_stream;
+  cudaStream_t m_integration_stream;
+
+  SensorFrameQueue m_free_frames;
+  SensorFrameQueue m_input_frames;          //!< frames that wait for the preprocessing
+  SensorFrameQueue m_preprocessed_frames;
+  SensorFrameQueue m_free_device_frames;
+  SensorFrameQueue m_uploaded_frames;
+
+  boost::atomic<bool> m_running;
+  boost::atomic<bool> m_preprocessing_running;
+  boost::atomic<bool> m_upload_running;
+  boost::thread_group m_stage_threads;
+  boost::thread* m_preprocessing_thread;
+  boost::thread* m_upload_thread;
+  boost::thread* m_integration_thread;
+
+  //! flush() waits until all pushed frames are finished, i.e. integrated or dropped
+  boost::atomic<size_t> m_frames_pushed;
+  boost::atomic<size_t> m_frames_finished;
+
+  //! Protects m_statistics
+  mutable boost::mutex m_statistics_mutex;
+  SensorPipelineStatistics m_statistics;
+};
+
+} // end of namespace
+} // end of namespace
+
+#endif
@@ -31,6 +31,7 @@
 #include <gpu_voxels/helpers/cuda_datatypes.h>
 #include <gpu_voxels/helpers/common_defines.h>
 #include <gpu_voxels/helpers/MetaPointCloud.h>
+#include <gpu_voxels/helpers/MapFile.h>
 #include <gpu_voxels/voxelmap/AbstractVoxelMap.h>
 #include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.h>
 #include <gpu_voxels/voxel/DefaultCollider.h>
@@ -48,8 +49,12 @@ class TemplateVoxelMap : public AbstractVoxelMap
 {
 public:
   /*! Create a voxelmap that holds dim.x * dim.y * dim.z voxels.
-   *  A voxel is treated as cube with side length voxel_side_length. */
-  TemplateVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type);
+   *  A voxel is treated as cube with side length voxel_side_length.
+   *  With \a backend MB_HOST the voxels are allocated in host memory and all
+   *  operations run on the CPU. In that case the "device" data pointers
+   *  returned by this class point to host memory. */
+  TemplateVoxelMap(const Vector3ui dim, const float voxel_side_length, const MapType map_type,
+                   const MapBackend backend = MB_DEVICE);
 
   /*!
    * This constructor does NOT create a new voxel map on the GPU.
@@ -63,9 +68,13 @@ public:
 
   /* ======== getter functions ======== */
 
-  //! get pointer to data array on device
+  /*! get pointer to data array on device.
+   *  As the caller may write to the map through this pointer, the brick
+   *  occupancy index is invalidated. Use getConstDeviceDataPtr() for reading. */
   Voxel* getDeviceDataPtr()
   {
+    m_brick_index_valid = false;
+    ++m_generation;
     return m_dev_data;
   }
 
@@ -76,6 +85,8 @@ public:
 
   inline virtual void* getVoidDeviceDataPtr()
   {
+    m_brick_index_valid = false;
+    ++m_generation;
     return (void*) m_dev_data;
   }
 
@@ -84,6 +95,24 @@ public:
     return (const void*) m_dev_data;
   }
 
+  /*! Get the brick occupancy index on the device (host memory for MB_HOST maps).
+   *  It holds one flag per brick of cBRICK_SIDE_LENGTH^3 voxels, see getBrickDimensions().
+   *  A flag is set as soon as a voxel of the brick was written by insertPointCloud()
+   *  or insertMetaPointCloud(). Returns NULL if the index is not valid, which happens
+   *  if the map was modified by other operations since the last clearMap(). */
+  const uint8_t* getConstBrickOccupancyPtr() const
+  {
+    return m_brick_index_valid ? m_dev_brick_occupancy : NULL;
+  }
+
+  /*! Has to be called after writing to the map through a data pointer
+   *  that was obtained before the last clearMap().
+   *  Collision checks fall back to visiting all voxels until the next clearMap(). */
+  void invalidateBrickIndex()
+  {
+    m_brick_index_valid = false;
+  }
+
   //! get the number of voxels held in the voxelmap
   inline uint32_t getVoxelMapSize() const
   {
@@ -138,10 +167,20 @@ public:
 
   virtual void insertPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning);
 
+  /**
+   * @brief insertPointCloud Inserts an array of points into the map.
+   * @param points_d The points. Device memory for MB_DEVICE maps, host memory for MB_HOST maps.
+   */
   virtual void insertPointCloud(const Vector3f* points_d, uint32_t size, const BitVoxelMeaning voxel_meaning);
 
+  virtual void insertDownsampledPointCloud(const std::vector<Vector3f> &point_cloud, const BitVoxelMeaning voxel_meaning);
+
+  virtual void insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning);
+
   /**
    * @brief insertMetaPointCloud Inserts a MetaPointCloud into the map.
+   * MB_HOST maps read the host side copy of the clouds, so call
+   * MetaPointCloud::syncToHost() after transforming the clouds on the device.
    * @param meta_point_cloud The MetaPointCloud to insert
    * @param voxel_meaning Voxel meaning of all voxels
    */
@@ -168,8 +207,19 @@ public:
   virtual void clearMap();
   //! set voxel occupancies for a specific voxelmeaning to zero
 
+  /*! Writes the map in the versioned map file format, see helpers/MapFile.h.
+   *  Device maps are transferred through a host buffer of some chunks. */
   virtual bool writeToDisk(const std::string path);
 
+  /*! Writes the map with the given encoding. Run length encoding stores runs of equal
+   *  voxels only once, which shrinks mostly empty maps to a small fraction of their size,
+   *  but the file can not be used in place by host maps. */
+  virtual bool writeToDisk(const std::string path, const file_handling::MapFileEncoding encoding);
+
+  /*! Reads map files as well as files of the legacy unversioned format.
+   *  Host maps memory map a raw map file and use it as voxel storage without copying,
+   *  after the checksums of all chunks were verified on the mapping. Otherwise the chunks
+   *  are decoded in parallel, streamed to the device and their checksums are verified on the way. */
   virtual bool readFromDisk(const std::string path);
 
   virtual Vector3ui getDimensions() const;
@@ -226,6 +276,39 @@ public:
 
 protected:
 
+  /*! Collects the bricks that are flagged in this map and in \a other into m_dev_active_bricks.
+   *  Returns false if the brick index can not be used for this pair of maps.
+   *  Both maps have to be locked by the caller. */
+  template<class OtherVoxel>
+  bool collectCommonBricks(const TemplateVoxelMap<OtherVoxel>* other, uint32_t& num_common_bricks);
+
+  /*! Collects the bricks that are flagged in this map into m_dev_active_bricks.
+   *  Returns false if the brick index is not valid. The map has to be locked by the caller. */
+  bool collectOccupiedBricks(uint32_t& num_bricks);
+
+  /*! Reduces \a points to one point per voxel and inserts them. \a points and \a voxel_keys are
+   *  thrust vectors in the memory of the backend. The map has to be locked by the caller. */
+  template<class PointVector, class KeyVector>
+  void insertVoxelizedPoints(PointVector& points, KeyVector& voxel_keys, const BitVoxelMeaning voxel_meaning);
+
+  //! Flags the bricks of all points in the brick occupancy index
+  void markBricks(const Vector3f* points, uint32_t size);
+  void markBricks(const MetaPointCloud& meta_point_cloud);
+
+  //! Clears all flags of the brick occupancy index and marks it as valid
+  void resetBrickIndex();
+
+  /*! Sets the voxels of all flagged bricks to \a cleared_voxel and resets the brick occupancy index.
+   *  Returns false if the index is not valid or most bricks are flagged,
+   *  then the caller has to clear the whole map. The map has to be locked by the caller. */
+  bool clearOccupiedBricks(const Voxel& cleared_voxel);
+
+  //! Loads a file in the map file format, the map has to be locked by the caller
+  bool readMapFile(const std::string& path);
+
+  //! Loads a file in the legacy format, the map has to be locked by the caller
+  bool readLegacyFile(const std::string& path);
+
   /* ======== Variables with content on host ======== */
   const Vector3ui m_dim;
   const Vector3f m_limits;
@@ -245,6 +328,17 @@ protected:
   //! result array for collision check with counter
   uint16_t* m_collision_check_results_counter;
 
+  //! number of bricks of the brick occupancy index
+  uint32_t m_num_bricks;
+  //! false if the map was written without updating the brick occupancy index
+  bool m_brick_index_valid;
+  //! incremented whenever the voxels are written, so that copies of them can detect that they are outdated
+  uint64_t m_generation;
+
+  //! mapping of a map file that is used as voxel storage of a host map, NULL otherwise
+  void* m_mapped_file;
+  std::size_t m_mapped_file_size;
+
   //! performance measurement start time
   cudaEvent_t m_start;
   //! performance measurement stop time
@@ -272,6 +366,12 @@ protected:
   //! result array for collision check with counter on device
   uint16_t* m_dev_collision_check_results_counter;
 
+  //! brick occupancy index on device, see getConstBrickOccupancyPtr()
+  uint8_t* m_dev_brick_occupancy;
+
+  //! linear indices of the bricks visited by a collision check
+  uint32_t* m_dev_active_bricks;
+
   // ------------------- BEGIN Env Map specific: -------------------
   /* ======== Variables with content on host ======== */
 
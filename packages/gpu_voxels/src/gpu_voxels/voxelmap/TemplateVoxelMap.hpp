@@ -26,12 +26,23 @@
 #include "TemplateVoxelMap.h"
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.hpp>
+#include <gpu_voxels/voxelmap/kernels/VoxelMapOperationsHost.hpp>
+#include <gpu_voxels/voxelmap/kernels/PointCloudVoxelization.hpp>
 #include <gpu_voxels/voxel/DefaultCollider.hpp>
 #include <gpu_voxels/voxel/SVCollider.hpp>
 
 #include <thrust/fill.h>
+#include <thrust/copy.h>
 #include <thrust/device_ptr.h>
+#include <thrust/device_vector.h>
+#include <thrust/host_vector.h>
+#include <thrust/functional.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/system_error.h>
 
 // temp:
 #include <time.h>
@@ -52,16 +63,23 @@ namespace voxelmap {
 
 template<class Voxel>
 TemplateVoxelMap<Voxel>::TemplateVoxelMap(const Vector3ui dim,
-                                          const float voxel_side_length, const MapType map_type) :
+                                          const float voxel_side_length, const MapType map_type,
+                                          const MapBackend backend) :
                                           m_dim(dim),
                                           m_limits(dim.x * voxel_side_length, dim.y * voxel_side_length, dim.z * voxel_side_length),
-                                          m_voxel_side_length(voxel_side_length), m_voxelmap_size(getVoxelMapSize()), m_dev_data(NULL),
+                                          m_voxel_side_length(voxel_side_length), m_voxelmap_size(getVoxelMapSize()),
+                                          m_mapped_file(NULL), m_mapped_file_size(0), m_dev_data(NULL),
                                           m_dev_points_outside_map(NULL),
                                           m_collision_check_results(NULL),
+                                          m_collision_check_results_counter(NULL),
+                                          m_dev_collision_check_results(NULL),
+                                          m_dev_collision_check_results_counter(NULL),
+                                          m_dev_brick_occupancy(NULL), m_dev_active_bricks(NULL),
                                           // Env Map specific stuff
                                           m_init_sensor(false), m_dev_raw_sensor_data(NULL), m_dev_sensor(NULL), m_dev_transformed_sensor_data(NULL)
 {
   this->m_map_type = map_type;
+  this->m_backend = backend;
   if (dim.x * dim.y * dim.z * sizeof(Voxel) > (pow(2, 32) - 1))
   {
     LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Map size limited to 32 bit addressing!" << endl);
@@ -73,6 +91,25 @@ TemplateVoxelMap<Voxel>::TemplateVoxelMap(const Vector3ui dim,
     LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Memory size is limited to 32 bit!" << endl);
     exit(-1);
   }
+
+  const Vector3ui brick_dim = getBrickDimensions(m_dim);
+  m_num_bricks = brick_dim.x * brick_dim.y * brick_dim.z;
+  m_brick_index_valid = false;
+  m_generation = 0;
+
+  if (backend == MB_HOST)
+  {
+    // no device resources are needed, the voxels live in host memory
+    m_dev_data = new Voxel[m_voxelmap_size];
+    m_dev_brick_occupancy = new uint8_t[m_num_bricks];
+    m_dev_active_bricks = new uint32_t[m_num_bricks];
+    LOGGING_DEBUG_C(VoxelmapLog, VoxelMap, "Host voxelmap base address is " << (void*) m_dev_data << endl);
+    m_blocks = m_threads = 0;
+    m_result_array_size = 0;
+    clearMap();
+    return;
+  }
+
   HANDLE_CUDA_ERROR(cudaEventCreate(&m_start));
   HANDLE_CUDA_ERROR(cudaEventCreate(&m_stop));
 
@@ -82,6 +119,9 @@ TemplateVoxelMap<Voxel>::TemplateVoxelMap(const Vector3ui dim,
 
   HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_dev_points_outside_map, sizeof(bool)));
 
+  // the brick occupancy index
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_dev_brick_occupancy, m_num_bricks * sizeof(uint8_t)));
+  HANDLE_CUDA_ERROR(cudaMalloc((void** )&m_dev_active_bricks, m_num_bricks * sizeof(uint32_t)));
 
   computeLinearLoad(m_voxelmap_size, &m_blocks, &m_threads);
 #ifdef ALTERNATIVE_CHECK
@@ -140,7 +180,9 @@ template<class Voxel>
 TemplateVoxelMap<Voxel>::TemplateVoxelMap(Voxel* dev_data, const Vector3ui dim, const float voxel_side_length, const MapType map_type) :
   m_dim(dim), m_limits(dim.x * voxel_side_length, dim.y * voxel_side_length,
                                                  dim.z * voxel_side_length), m_voxel_side_length(
-        voxel_side_length), m_voxelmap_size(getVoxelMapSize()), m_dev_data(dev_data), m_collision_check_results(NULL)
+        voxel_side_length), m_voxelmap_size(getVoxelMapSize()), m_dev_data(dev_data), m_collision_check_results(NULL),
+  m_num_bricks(0), m_brick_index_valid(false), m_generation(0), m_mapped_file(NULL), m_mapped_file_size(0),
+  m_dev_brick_occupancy(NULL), m_dev_active_bricks(NULL)
 {
   this->m_map_type = map_type;
 
@@ -150,6 +192,21 @@ TemplateVoxelMap<Voxel>::TemplateVoxelMap(Voxel* dev_data, const Vector3ui dim,
 template<class Voxel>
 TemplateVoxelMap<Voxel>::~TemplateVoxelMap()
 {
+  if (this->m_backend == MB_HOST)
+  {
+    if (m_mapped_file)
+    {
+      file_handling::unmapMapFile(m_mapped_file, m_mapped_file_size);
+    }
+    else
+    {
+      delete[] m_dev_data;
+    }
+    delete[] m_dev_brick_occupancy;
+    delete[] m_dev_active_bricks;
+    return;
+  }
+
   if (m_dev_collision_check_results_counter)
   {
     HANDLE_CUDA_ERROR(cudaFree(m_dev_collision_check_results_counter));
@@ -174,6 +231,14 @@ TemplateVoxelMap<Voxel>::~TemplateVoxelMap()
   {
     HANDLE_CUDA_ERROR(cudaFree(m_dev_points_outside_map));
   }
+  if (m_dev_brick_occupancy)
+  {
+    HANDLE_CUDA_ERROR(cudaFree(m_dev_brick_occupancy));
+  }
+  if (m_dev_active_bricks)
+  {
+    HANDLE_CUDA_ERROR(cudaFree(m_dev_active_bricks));
+  }
 
   HANDLE_CUDA_ERROR(cudaEventDestroy(m_start));
   HANDLE_CUDA_ERROR(cudaEventDestroy(m_stop));
@@ -206,10 +271,28 @@ template<>
 void TemplateVoxelMap<BitVectorVoxel>::clearMap()
 {
   lock_guard guard(this->m_mutex);
-  // Clear occupancies
-  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-  HANDLE_CUDA_ERROR(
-    cudaMemset(m_dev_data, 0, m_voxelmap_size*sizeof(gpu_voxels::BitVectorVoxel)));
+  ++m_generation;
+  if (clearOccupiedBricks(BitVectorVoxel()))
+  {
+    // only the flagged bricks were written since the last clear
+  }
+  else if (this->m_backend == MB_HOST)
+  {
+    hostClearVoxelMap(m_dev_data, m_voxelmap_size, BitVectorVoxel());
+    resetBrickIndex();
+  }
+  else
+  {
+    // Clear occupancies
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    HANDLE_CUDA_ERROR(
+      cudaMemset(m_dev_data, 0, m_voxelmap_size*sizeof(gpu_voxels::BitVectorVoxel)));
+    resetBrickIndex();
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return;
+  }
 
   // Clear result array
   for (uint32_t i = 0; i < cMAX_NR_OF_BLOCKS; i++)
@@ -230,10 +313,29 @@ template<>
 void TemplateVoxelMap<ProbabilisticVoxel>::clearMap()
 {
   lock_guard guard(this->m_mutex);
-  // Clear occupancies
-  HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-  HANDLE_CUDA_ERROR(
-    cudaMemset(m_dev_data, UNKNOWN_PROBABILITY, m_voxelmap_size*sizeof(gpu_voxels::ProbabilisticVoxel)));
+  ++m_generation;
+  // a default constructed ProbabilisticVoxel holds UNKNOWN_PROBABILITY
+  if (clearOccupiedBricks(ProbabilisticVoxel()))
+  {
+    // only the flagged bricks were written since the last clear
+  }
+  else if (this->m_backend == MB_HOST)
+  {
+    hostClearVoxelMap(m_dev_data, m_voxelmap_size, ProbabilisticVoxel());
+    resetBrickIndex();
+  }
+  else
+  {
+    // Clear occupancies
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    HANDLE_CUDA_ERROR(
+      cudaMemset(m_dev_data, UNKNOWN_PROBABILITY, m_voxelmap_size*sizeof(gpu_voxels::ProbabilisticVoxel)));
+    resetBrickIndex();
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    return;
+  }
 
   // Clear result array
   for (uint32_t i = 0; i < cMAX_NR_OF_BLOCKS; i++)
@@ -253,17 +355,29 @@ template<>
 void TemplateVoxelMap<DistanceVoxel>::clearMap()
 {
   lock_guard guard(this->m_mutex);
+  ++m_generation;
+
+  // Clear contents: distance of PBA_UNINITIALISED indicates uninitialized voxel
+  DistanceVoxel pba_uninitialised_voxel;
+  pba_uninitialised_voxel.setPBAUninitialised();
+
+  // no brick clearing here, the distance transforms write every voxel without flagging the bricks
+  if (this->m_backend == MB_HOST)
+  {
+    hostClearVoxelMap(m_dev_data, m_voxelmap_size, pba_uninitialised_voxel);
+    resetBrickIndex();
+    return;
+  }
+
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 
   //  //deprecated: initialising voxels to all zero
   //  HANDLE_CUDA_ERROR(cudaMemset(m_dev_data, 0, m_voxelmap_size*sizeof(DistanceVoxel)));
 
-  // Clear contents: distance of PBA_UNINITIALISED indicates uninitialized voxel
-  DistanceVoxel pba_uninitialised_voxel;
-  pba_uninitialised_voxel.setPBAUninitialised();
   thrust::device_ptr<DistanceVoxel> first(m_dev_data);
 
   thrust::fill(first, first+m_voxelmap_size, pba_uninitialised_voxel);
+  resetBrickIndex();
 
 //  //TODO: adapt for distanceVoxel? eliminate?
 //  // Clear result array
@@ -282,9 +396,200 @@ template<class Voxel>
 void TemplateVoxelMap<Voxel>::printVoxelMapData()
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    std::cout << "VoxelMap dump: ";
+    for (uint32_t i = 0; i < m_voxelmap_size; ++i)
+    {
+      std::cout << m_dev_data[i] << " ";
+    }
+    std::cout << std::endl;
+    return;
+  }
   HANDLE_CUDA_ERROR(cuPrintDeviceArray(m_dev_data, m_voxelmap_size, "VoxelMap dump: "));
 }
 
+/* ======== Brick occupancy index  ======== */
+
+/*!
+ * Thrust predicate that selects bricks which are flagged in both maps.
+ */
+struct BrickOccupiedInBoth
+{
+  __host__ __device__
+  bool operator()(const thrust::tuple<uint8_t, uint8_t>& flags) const
+  {
+    return thrust::get<0>(flags) && thrust::get<1>(flags);
+  }
+};
+
+template<class Voxel>
+void TemplateVoxelMap<Voxel>::resetBrickIndex()
+{
+  if (m_dev_brick_occupancy == NULL)
+  {
+    return;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    memset(m_dev_brick_occupancy, 0, m_num_bricks * sizeof(uint8_t));
+  }
+  else
+  {
+    HANDLE_CUDA_ERROR(cudaMemset(m_dev_brick_occupancy, 0, m_num_bricks * sizeof(uint8_t)));
+  }
+  m_brick_index_valid = true;
+}
+
+template<class Voxel>
+void TemplateVoxelMap<Voxel>::markBricks(const Vector3f* points, uint32_t size)
+{
+  if (!m_brick_index_valid || size == 0)
+  {
+    return;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    hostMarkBricks(m_dim, m_voxel_side_length, points, size, m_dev_brick_occupancy);
+    return;
+  }
+
+  uint32_t num_blocks, threads_per_block;
+  computeLinearLoad(size, &num_blocks, &threads_per_block);
+  kernelMarkBricks<<<num_blocks, threads_per_block>>>(m_dim, m_voxel_side_length, points, size,
+                                                      m_dev_brick_occupancy);
+  CHECK_CUDA_ERROR();
+}
+
+template<class Voxel>
+void TemplateVoxelMap<Voxel>::markBricks(const MetaPointCloud& meta_point_cloud)
+{
+  if (!m_brick_index_valid || meta_point_cloud.getAccumulatedPointcloudSize() == 0)
+  {
+    return;
+  }
+  if (this->m_backend == MB_HOST)
+  {
+    hostMarkBricks(m_dim, m_voxel_side_length, meta_point_cloud, m_dev_brick_occupancy);
+    return;
+  }
+
+  uint32_t num_blocks, threads_per_block;
+  computeLinearLoad(meta_point_cloud.getAccumulatedPointcloudSize(), &num_blocks, &threads_per_block);
+  kernelMarkBricks<<<num_blocks, threads_per_block>>>(m_dim, m_voxel_side_length,
+                                                      meta_point_cloud.getDeviceConstPointer(),
+                                                      m_dev_brick_occupancy);
+  CHECK_CUDA_ERROR();
+}
+
+template<class Voxel>
+template<class OtherVoxel>
+bool TemplateVoxelMap<Voxel>::collectCommonBricks(const TemplateVoxelMap<OtherVoxel>* other,
+                                                  uint32_t& num_common_bricks)
+{
+  const uint8_t* other_brick_occupancy = other->getConstBrickOccupancyPtr();
+  if (!m_brick_index_valid || other_brick_occupancy == NULL || other->getDimensions() != m_dim)
+  {
+    return false;
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    num_common_bricks = 0;
+    for (uint32_t i = 0; i < m_num_bricks; ++i)
+    {
+      if (m_dev_brick_occupancy[i] && other_brick_occupancy[i])
+      {
+        m_dev_active_bricks[num_common_bricks++] = i;
+      }
+    }
+    return true;
+  }
+
+  thrust::device_ptr<const uint8_t> this_flags(m_dev_brick_occupancy);
+  thrust::device_ptr<const uint8_t> other_flags(other_brick_occupancy);
+  thrust::device_ptr<uint32_t> active_bricks(m_dev_active_bricks);
+  try
+  {
+    thrust::device_ptr<uint32_t> active_bricks_end = thrust::copy_if(
+          thrust::counting_iterator<uint32_t>(0), thrust::counting_iterator<uint32_t>(m_num_bricks),
+          thrust::make_zip_iterator(thrust::make_tuple(this_flags, other_flags)),
+          active_bricks, BrickOccupiedInBoth());
+    num_common_bricks = active_bricks_end - active_bricks;
+  }
+  catch(thrust::system_error &e)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, TemplateVoxelMap, "Caught Thrust exception while collecting bricks: " << e.what() << endl);
+    exit(-1);
+  }
+  return true;
+}
+
+template<class Voxel>
+bool TemplateVoxelMap<Voxel>::collectOccupiedBricks(uint32_t& num_bricks)
+{
+  if (!m_brick_index_valid)
+  {
+    return false;
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    num_bricks = 0;
+    for (uint32_t i = 0; i < m_num_bricks; ++i)
+    {
+      if (m_dev_brick_occupancy[i])
+      {
+        m_dev_active_bricks[num_bricks++] = i;
+      }
+    }
+    return true;
+  }
+
+  thrust::device_ptr<const uint8_t> flags(m_dev_brick_occupancy);
+  thrust::device_ptr<uint32_t> active_bricks(m_dev_active_bricks);
+  try
+  {
+    thrust::device_ptr<uint32_t> active_bricks_end = thrust::copy_if(
+          thrust::counting_iterator<uint32_t>(0), thrust::counting_iterator<uint32_t>(m_num_bricks),
+          flags, active_bricks, thrust::identity<uint8_t>());
+    num_bricks = active_bricks_end - active_bricks;
+  }
+  catch(thrust::system_error &e)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, TemplateVoxelMap, "Caught Thrust exception while collecting bricks: " << e.what() << endl);
+    exit(-1);
+  }
+  return true;
+}
+
+template<class Voxel>
+bool TemplateVoxelMap<Voxel>::clearOccupiedBricks(const Voxel& cleared_voxel)
+{
+  uint32_t num_bricks;
+  // visiting most of the bricks one by one is slower than clearing the whole map
+  if (!collectOccupiedBricks(num_bricks) || num_bricks > m_num_bricks / 2)
+  {
+    return false;
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    hostClearBricks(m_dev_data, m_dim, m_dev_active_bricks, num_bricks, cleared_voxel);
+  }
+  else if (num_bricks > 0)
+  {
+    uint32_t num_blocks, threads_per_block;
+    computeLinearLoad(num_bricks * cVOXELS_PER_BRICK, &num_blocks, &threads_per_block);
+    kernelClearBricks<<<num_blocks, threads_per_block>>>(m_dev_data, m_dim, m_dev_active_bricks, num_bricks,
+                                                         cleared_voxel);
+    CHECK_CUDA_ERROR();
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+  }
+  resetBrickIndex();
+  return true;
+}
+
 //template<class Voxel>
 //bool TemplateVoxelMap<Voxel>::collisionCheckAlternative(const uint8_t threshold, VoxelMap* other,
 //                                         const uint8_t other_threshold, uint32_t loop_size)
@@ -335,13 +640,61 @@ bool TemplateVoxelMap<Voxel>::collisionCheck(TemplateVoxelMap<OtherVoxel>* other
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
   //printf("collision check... ");
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxelmapLog, TemplateVoxelMap, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return false;
+  }
+  // only visit the bricks that were written in both maps
+  uint32_t num_common_bricks;
+  const bool use_bricks = collectCommonBricks(other, num_common_bricks);
+  if (use_bricks && num_common_bricks == 0)
+  {
+    return false;
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    if (use_bricks)
+    {
+      return hostCollideVoxelMapsBricks(m_dev_data, m_dim, other->getConstDeviceDataPtr(),
+                                        m_dev_active_bricks, num_common_bricks, collider);
+    }
+    return hostCollideVoxelMaps(m_dev_data, m_voxelmap_size, other->getConstDeviceDataPtr(), collider);
+  }
+
+  if (use_bricks)
+  {
+    uint32_t num_blocks, threads_per_block;
+    computeLinearLoad(num_common_bricks * cVOXELS_PER_BRICK, &num_blocks, &threads_per_block);
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    kernelCollideVoxelMapsBricks<<<num_blocks, threads_per_block>>>(m_dev_data, m_dim, other->getConstDeviceDataPtr(),
+                                                                    m_dev_active_bricks, num_common_bricks,
+                                                                    collider, m_dev_collision_check_results);
+    CHECK_CUDA_ERROR();
+
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    HANDLE_CUDA_ERROR(
+        cudaMemcpy(m_collision_check_results, m_dev_collision_check_results, num_blocks * sizeof(bool),
+                   cudaMemcpyDeviceToHost));
+
+    for (uint32_t i = 0; i < num_blocks; i++)
+    {
+      if (m_collision_check_results[i])
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
 #ifndef ALTERNATIVE_CHECK
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
 //  m_elapsed_time = 0;
 //  HANDLE_CUDA_ERROR(cudaEventRecord(m_start, 0));
 //  printf("TemplateVoxelMap<Voxel>::collisionCheck\n");
 
-  kernelCollideVoxelMaps<<<m_blocks, m_threads>>>(m_dev_data, m_voxelmap_size, other->getDeviceDataPtr(),
+  kernelCollideVoxelMaps<<<m_blocks, m_threads>>>(m_dev_data, m_voxelmap_size, other->getConstDeviceDataPtr(),
                                                   collider, m_dev_collision_check_results);
   CHECK_CUDA_ERROR();
 
@@ -492,6 +845,52 @@ uint32_t TemplateVoxelMap<Voxel>::collisionCheckWithCounterRelativeTransform(Tem
   lock_guard guard(this->m_mutex, boost::adopt_lock);
   lock_guard guard2(other->m_mutex, boost::adopt_lock);
 
+  if (this->m_backend != other->getBackend())
+  {
+    LOGGING_ERROR_C(VoxelmapLog, TemplateVoxelMap, GPU_VOXELS_MAP_BACKEND_MISMATCH << endl);
+    return 0;
+  }
+  // the brick index is only used for collisions without offset
+  uint32_t num_common_bricks;
+  const bool use_bricks = (offset == Vector3i()) && collectCommonBricks(other, num_common_bricks);
+  if (use_bricks && num_common_bricks == 0)
+  {
+    return 0;
+  }
+
+  if (this->m_backend == MB_HOST)
+  {
+    if (use_bricks)
+    {
+      return hostCollideVoxelMapsDebugBricks(m_dev_data, m_dim, other->getConstDeviceDataPtr(),
+                                             m_dev_active_bricks, num_common_bricks, collider);
+    }
+    return hostCollideVoxelMapsDebug(m_dev_data, m_voxelmap_size, getVoxelIndexSigned(m_dim, offset),
+                                     other->getConstDeviceDataPtr(), collider);
+  }
+
+  if (use_bricks)
+  {
+    uint32_t num_blocks, threads_per_block;
+    computeLinearLoad(num_common_bricks * cVOXELS_PER_BRICK, &num_blocks, &threads_per_block);
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    kernelCollideVoxelMapsDebugBricks<<<num_blocks, threads_per_block>>>(m_dev_data, m_dim, other->getConstDeviceDataPtr(),
+                                                                         m_dev_active_bricks, num_common_bricks,
+                                                                         collider, m_dev_collision_check_results_counter);
+    CHECK_CUDA_ERROR();
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    HANDLE_CUDA_ERROR(
+        cudaMemcpy(m_collision_check_results_counter, m_dev_collision_check_results_counter,
+                   num_blocks * sizeof(uint16_t), cudaMemcpyDeviceToHost));
+
+    uint32_t number_of_collisions = 0;
+    for (uint32_t i = 0; i < num_blocks; i++)
+    {
+      number_of_collisions += m_collision_check_results_counter[i];
+    }
+    return number_of_collisions;
+  }
+
   Voxel* dev_data_with_offset = NULL;
   if(offset != Vector3i())
   {
@@ -501,7 +900,7 @@ uint32_t TemplateVoxelMap<Voxel>::collisionCheckWithCounterRelativeTransform(Tem
     dev_data_with_offset = m_dev_data;
   }
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
-  kernelCollideVoxelMapsDebug<<<m_blocks, m_threads>>>(dev_data_with_offset, m_voxelmap_size, other->getDeviceDataPtr(),
+  kernelCollideVoxelMapsDebug<<<m_blocks, m_threads>>>(dev_data_with_offset, m_voxelmap_size, other->getConstDeviceDataPtr(),
                                                        collider, m_dev_collision_check_results_counter);
   CHECK_CUDA_ERROR();
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
@@ -563,8 +962,14 @@ uint32_t TemplateVoxelMap<Voxel>::collisionCheckWithCounterRelativeTransform(Tem
 template<class Voxel>
 void TemplateVoxelMap<Voxel>::insertPointCloud(const std::vector<Vector3f> &points, const BitVoxelMeaning voxel_meaning)
 {
-// copy points to the gpu
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    insertPointCloud(points.data(), points.size(), voxel_meaning);
+    return;
+  }
+
+// copy points to the gpu
   Vector3f* d_points;
   HANDLE_CUDA_ERROR(cudaMalloc(&d_points, points.size() * sizeof(Vector3f)));
   HANDLE_CUDA_ERROR(
@@ -579,6 +984,12 @@ template<class Voxel>
 void TemplateVoxelMap<Voxel>::insertPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning)
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    // the host copy of the cloud is only downloaded if the points were changed on the device
+    insertPointCloud(pointcloud.getConstHostPointer(), pointcloud.getPointCloudSize(), voxel_meaning);
+    return;
+  }
 
   insertPointCloud(pointcloud.getConstDevicePointer(), pointcloud.getPointCloudSize(), voxel_meaning);
 
@@ -587,6 +998,17 @@ void TemplateVoxelMap<Voxel>::insertPointCloud(const PointCloud &pointcloud, con
 template<class Voxel>
 void TemplateVoxelMap<Voxel>::insertPointCloud(const Vector3f* points_d, uint32_t size, const BitVoxelMeaning voxel_meaning)
 {
+  ++m_generation;
+  if (this->m_backend == MB_HOST)
+  {
+    if(hostInsertPointCloud(m_dev_data, m_dim, m_voxel_side_length, points_d, size, voxel_meaning))
+    {
+      LOGGING_WARNING_C(VoxelmapLog, VoxelMap, "You tried to insert points that lie outside the map dimensions!" << endl);
+    }
+    markBricks(points_d, size);
+    return;
+  }
+
   // reset warning indicator:
   HANDLE_CUDA_ERROR(cudaMemset((void*)m_dev_points_outside_map, 0, sizeof(bool)));
   bool points_outside_map;
@@ -597,6 +1019,7 @@ void TemplateVoxelMap<Voxel>::insertPointCloud(const Vector3f* points_d, uint32_
   kernelInsertGlobalPointCloud<<<num_blocks, threads_per_block>>>(m_dev_data, m_dim, m_voxel_side_length,
                                                                   points_d, size, voxel_meaning, m_dev_points_outside_map);
   CHECK_CUDA_ERROR();
+  markBricks(points_d, size);
 
   HANDLE_CUDA_ERROR(cudaMemcpy(&points_outside_map, m_dev_points_outside_map, sizeof(bool), cudaMemcpyDeviceToHost));
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
@@ -606,11 +1029,73 @@ void TemplateVoxelMap<Voxel>::insertPointCloud(const Vector3f* points_d, uint32_
   }
 }
 
+template<class Voxel>
+void TemplateVoxelMap<Voxel>::insertDownsampledPointCloud(const std::vector<Vector3f> &points, const BitVoxelMeaning voxel_meaning)
+{
+  lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    thrust::host_vector<Vector3f> voxel_points(points.begin(), points.end());
+    thrust::host_vector<uint32_t> voxel_keys;
+    insertVoxelizedPoints(voxel_points, voxel_keys, voxel_meaning);
+    return;
+  }
+
+  thrust::device_vector<Vector3f> voxel_points(points.begin(), points.end());
+  thrust::device_vector<uint32_t> voxel_keys;
+  insertVoxelizedPoints(voxel_points, voxel_keys, voxel_meaning);
+}
+
+template<class Voxel>
+void TemplateVoxelMap<Voxel>::insertDownsampledPointCloud(const PointCloud &pointcloud, const BitVoxelMeaning voxel_meaning)
+{
+  lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    const Vector3f* points_h = pointcloud.getConstHostPointer();
+    thrust::host_vector<Vector3f> voxel_points(points_h, points_h + pointcloud.getPointCloudSize());
+    thrust::host_vector<uint32_t> voxel_keys;
+    insertVoxelizedPoints(voxel_points, voxel_keys, voxel_meaning);
+    return;
+  }
+
+  thrust::device_ptr<const Vector3f> points_d = thrust::device_pointer_cast(pointcloud.getConstDevicePointer());
+  thrust::device_vector<Vector3f> voxel_points(points_d, points_d + pointcloud.getPointCloudSize());
+  thrust::device_vector<uint32_t> voxel_keys;
+  insertVoxelizedPoints(voxel_points, voxel_keys, voxel_meaning);
+}
+
+template<class Voxel>
+template<class PointVector, class KeyVector>
+void TemplateVoxelMap<Voxel>::insertVoxelizedPoints(PointVector& points, KeyVector& voxel_keys,
+                                                    const BitVoxelMeaning voxel_meaning)
+{
+  // every voxel is written only once, so the number of points per voxel is not needed
+  if (voxelizePointCloud(m_dim, m_voxel_side_length, points, voxel_keys, voxel_keys, false))
+  {
+    LOGGING_WARNING_C(VoxelmapLog, VoxelMap, "You tried to insert points that lie outside the map dimensions!" << endl);
+  }
+  if (!points.empty())
+  {
+    insertPointCloud(thrust::raw_pointer_cast(points.data()), points.size(), voxel_meaning);
+  }
+}
+
 template<class Voxel>
 void TemplateVoxelMap<Voxel>::insertMetaPointCloud(const MetaPointCloud &meta_point_cloud,
                                                    BitVoxelMeaning voxel_meaning)
 {
   lock_guard guard(this->m_mutex);
+  ++m_generation;
+  if (this->m_backend == MB_HOST)
+  {
+    if(hostInsertMetaPointCloud(m_dev_data, m_dim, m_voxel_side_length, meta_point_cloud, &voxel_meaning, false))
+    {
+      LOGGING_WARNING_C(VoxelmapLog, VoxelMap, "You tried to insert points that lie outside the map dimensions!" << endl);
+    }
+    markBricks(meta_point_cloud);
+    return;
+  }
 
   // reset warning indicator:
   HANDLE_CUDA_ERROR(cudaMemset((void*)m_dev_points_outside_map, 0, sizeof(bool)));
@@ -622,6 +1107,7 @@ void TemplateVoxelMap<Voxel>::insertMetaPointCloud(const MetaPointCloud &meta_po
       m_dev_data, meta_point_cloud.getDeviceConstPointer(), voxel_meaning, m_dim, m_voxel_side_length,
       m_dev_points_outside_map);
   CHECK_CUDA_ERROR();
+  markBricks(meta_point_cloud);
 
   HANDLE_CUDA_ERROR(cudaMemcpy(&points_outside_map, m_dev_points_outside_map, sizeof(bool), cudaMemcpyDeviceToHost));
   if(points_outside_map)
@@ -635,8 +1121,19 @@ void TemplateVoxelMap<Voxel>::insertMetaPointCloud(const MetaPointCloud& meta_po
                                                    const std::vector<BitVoxelMeaning>& voxel_meanings)
 {
   lock_guard guard(this->m_mutex);
+  ++m_generation;
   assert(meta_point_cloud.getNumberOfPointclouds() == voxel_meanings.size());
 
+  if (this->m_backend == MB_HOST)
+  {
+    if(hostInsertMetaPointCloud(m_dev_data, m_dim, m_voxel_side_length, meta_point_cloud, &voxel_meanings[0], true))
+    {
+      LOGGING_WARNING_C(VoxelmapLog, VoxelMap, "You tried to insert points that lie outside the map dimensions!" << endl);
+    }
+    markBricks(meta_point_cloud);
+    return;
+  }
+
   // reset warning indicator:
   HANDLE_CUDA_ERROR(cudaMemset((void*)m_dev_points_outside_map, 0, sizeof(bool)));
   bool points_outside_map;
@@ -653,6 +1150,7 @@ void TemplateVoxelMap<Voxel>::insertMetaPointCloud(const MetaPointCloud& meta_po
       m_dev_data, meta_point_cloud.getDeviceConstPointer(), voxel_meanings_d, m_dim, m_voxel_side_length,
       m_dev_points_outside_map);
   CHECK_CUDA_ERROR();
+  markBricks(meta_point_cloud);
 
   HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
   HANDLE_CUDA_ERROR(cudaMemcpy(&points_outside_map, m_dev_points_outside_map, sizeof(bool), cudaMemcpyDeviceToHost));
@@ -665,58 +1163,180 @@ void TemplateVoxelMap<Voxel>::insertMetaPointCloud(const MetaPointCloud& meta_po
 
 template<class Voxel>
 bool TemplateVoxelMap<Voxel>::writeToDisk(const std::string path)
+{
+  return writeToDisk(path, file_handling::eMFE_RAW);
+}
+
+template<class Voxel>
+bool TemplateVoxelMap<Voxel>::writeToDisk(const std::string path, const file_handling::MapFileEncoding encoding)
 {
   lock_guard guard(this->m_mutex);
-  std::ofstream out(path.c_str());
-  if(!out.is_open())
+  file_handling::MapFileWriter writer;
+  if (!writer.open(path, this->getTemplateType(), sizeof(Voxel), m_voxel_side_length, m_dim, getMemoryUsage(), encoding))
   {
     LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Write to file " << path << " failed!" << endl);
     return false;
   }
 
-  MapType map_type = this->getTemplateType();
-  uint32_t buffer_size = this->getMemoryUsage();
-  char* buffer = new char[buffer_size];
-
   LOGGING_INFO_C(VoxelmapLog, VoxelMap, "Dumping Voxelmap to disk: " <<
-                 getVoxelMapSize() << " Voxels ==> " << (buffer_size * cBYTE2MBYTE) << " MB. ..." << endl);
-
-  HANDLE_CUDA_ERROR(cudaMemcpy((void*)buffer, this->getConstVoidDeviceDataPtr(), buffer_size, cudaMemcpyDeviceToHost));
+                 getVoxelMapSize() << " Voxels ==> " << (getMemoryUsage() * cBYTE2MBYTE) << " MB. ..." << endl);
 
-  bool bin_mode = true;
-  // Write meta data and actual data
-  if (bin_mode)
+  bool success = true;
+  const uint32_t num_chunks = writer.getNumberOfChunks();
+  if (this->m_backend == MB_HOST)
   {
-    out.write((char*) &map_type, sizeof(MapType));
-    out.write((char*) &m_voxel_side_length, sizeof(float));
-    out.write((char*) &m_dim.x, sizeof(uint32_t));
-    out.write((char*) &m_dim.y, sizeof(uint32_t));
-    out.write((char*) &m_dim.z, sizeof(uint32_t));
-    out.write((char*) &buffer[0], buffer_size);
+    success = writer.writeChunks((const char*) m_dev_data, num_chunks);
   }
-  else
+  else if (num_chunks > 0)
   {
-    out << map_type << "\n";
-    out << m_voxel_side_length << "\n";
-    out << m_dim.x << "\n";
-    out << m_dim.y << "\n";
-    out << m_dim.z << "\n";
-    for (uint32_t i = 0; i < buffer_size; ++i)
-      out << buffer[i] << "\n";
+    // stage as many chunks as fit into cMAP_FILE_CHUNK_SIZE, the first chunk is the largest one
+    const uint32_t chunks_per_batch = std::max<uint64_t>(1, file_handling::cMAP_FILE_CHUNK_SIZE / writer.getChunkRawSize(0));
+    char* buffer;
+    HANDLE_CUDA_ERROR(cudaMallocHost((void**) &buffer, chunks_per_batch * writer.getChunkRawSize(0)));
+    for (uint32_t first = 0; success && first < num_chunks; first += chunks_per_batch)
+    {
+      const uint32_t count = std::min(chunks_per_batch, num_chunks - first);
+      const uint64_t offset = writer.getChunkRawOffset(first);
+      const uint64_t size = writer.getChunkRawOffset(first + count - 1) + writer.getChunkRawSize(first + count - 1) - offset;
+      HANDLE_CUDA_ERROR(cudaMemcpy((void*) buffer, (const char*) m_dev_data + offset, size, cudaMemcpyDeviceToHost));
+      success = writer.writeChunks(buffer, count);
+    }
+    HANDLE_CUDA_ERROR(cudaFreeHost(buffer));
   }
+  success = writer.close() && success;
 
-  out.close();
-  delete buffer;
-
+  if (!success)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Write to file " << path << " failed!" << endl);
+    return false;
+  }
   LOGGING_INFO_C(VoxelmapLog, VoxelMap, "... writing to disk is done." << endl);
   return true;
 }
 
-
 template<class Voxel>
 bool TemplateVoxelMap<Voxel>::readFromDisk(const std::string path)
 {
   lock_guard guard(this->m_mutex);
+  if (file_handling::MapFileReader::isMapFile(path))
+  {
+    return readMapFile(path);
+  }
+  LOGGING_INFO_C(VoxelmapLog, VoxelMap, path << " is no versioned map file, trying the legacy format." << endl);
+  return readLegacyFile(path);
+}
+
+template<class Voxel>
+bool TemplateVoxelMap<Voxel>::readMapFile(const std::string& path)
+{
+  file_handling::MapFileReader reader;
+  if (!reader.open(path) ||
+      !reader.checkMetaData(this->getTemplateType(), sizeof(Voxel), m_voxel_side_length, m_dim))
+  {
+    LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Error in reading file " << path << endl);
+    return false;
+  }
+  const file_handling::MapFileHeader& header = reader.getHeader();
+  if (header.data_size != getMemoryUsage())
+  {
+    LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Read from file failed: Data size of " << path << " (" << header.data_size <<
+                    " Bytes) does not match current object (" << getMemoryUsage() << " Bytes)!" << endl);
+    return false;
+  }
+
+  LOGGING_INFO_C(VoxelmapLog, VoxelMap, "Reading Voxelmap from disk: " <<
+                 getVoxelMapSize() << " Voxels ==> " << (getMemoryUsage() * cBYTE2MBYTE) << " MB. ..." << endl);
+
+  // the flags of the brick index do not describe the loaded voxels
+  m_brick_index_valid = false;
+  ++m_generation;
+
+  if (this->m_backend == MB_HOST && header.encoding == file_handling::eMFE_RAW)
+  {
+    // use the mapping as voxel storage, the checksum pass reads the pages in sequentially
+    if (!reader.verifyChecksums())
+    {
+      LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Error in reading file " << path << endl);
+      return false;
+    }
+    Voxel* mapped_data = (Voxel*) reader.getData();
+    if (m_mapped_file)
+    {
+      file_handling::unmapMapFile(m_mapped_file, m_mapped_file_size);
+    }
+    else
+    {
+      delete[] m_dev_data;
+    }
+    m_mapped_file = reader.releaseMapping(m_mapped_file_size);
+    m_dev_data = mapped_data;
+  }
+  else if (this->m_backend == MB_HOST)
+  {
+    // encoded data is decoded into memory that is owned by the map
+    if (m_mapped_file)
+    {
+      file_handling::unmapMapFile(m_mapped_file, m_mapped_file_size);
+      m_mapped_file = NULL;
+      m_mapped_file_size = 0;
+      m_dev_data = new Voxel[m_voxelmap_size];
+    }
+    if (!reader.readChunks((char*) m_dev_data, 0, header.num_chunks))
+    {
+      LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Error in reading file " << path << endl);
+      return false;
+    }
+  }
+  else if (header.encoding == file_handling::eMFE_RAW)
+  {
+    const char* data = reader.getData();
+    for (uint32_t i = 0; i < header.num_chunks; ++i)
+    {
+      const file_handling::MapFileChunk& chunk = reader.getChunk(i);
+      if (file_handling::computeChecksum(data + chunk.offset, chunk.size) != chunk.checksum)
+      {
+        LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Checksum of chunk " << i << " in " << path << " does not match!" << endl);
+        return false;
+      }
+      HANDLE_CUDA_ERROR(cudaMemcpy((char*) m_dev_data + chunk.raw_offset, data + chunk.offset, chunk.size,
+                                   cudaMemcpyHostToDevice));
+    }
+  }
+  else if (header.num_chunks > 0)
+  {
+    // decode batches of chunks in parallel and upload them
+    const uint64_t max_chunk_size = reader.getChunk(0).raw_size;
+    const uint32_t chunks_per_batch = std::max<uint64_t>(1, file_handling::cMAP_FILE_CHUNK_SIZE / max_chunk_size);
+    char* buffer;
+    HANDLE_CUDA_ERROR(cudaMallocHost((void**) &buffer, chunks_per_batch * max_chunk_size));
+    bool success = true;
+    for (uint32_t first = 0; success && first < header.num_chunks; first += chunks_per_batch)
+    {
+      const uint32_t count = std::min(chunks_per_batch, header.num_chunks - first);
+      const file_handling::MapFileChunk& last = reader.getChunk(first + count - 1);
+      const uint64_t offset = reader.getChunk(first).raw_offset;
+      success = reader.readChunks(buffer, first, count);
+      if (success)
+      {
+        HANDLE_CUDA_ERROR(cudaMemcpy((char*) m_dev_data + offset, buffer, last.raw_offset + last.raw_size - offset,
+                                     cudaMemcpyHostToDevice));
+      }
+    }
+    HANDLE_CUDA_ERROR(cudaFreeHost(buffer));
+    if (!success)
+    {
+      LOGGING_ERROR_C(VoxelmapLog, VoxelMap, "Error in reading file " << path << endl);
+      return false;
+    }
+  }
+
+  LOGGING_INFO_C(VoxelmapLog, VoxelMap, "... reading from disk is done." << endl);
+  return true;
+}
+
+template<class Voxel>
+bool TemplateVoxelMap<Voxel>::readLegacyFile(const std::string& path)
+{
   MapType map_type;
   float voxel_side_length;
   uint32_t dim_x, dim_y, dim_z;
@@ -790,10 +1410,19 @@ bool TemplateVoxelMap<Voxel>::readFromDisk(const std::string path)
   }
 
   // Copy data to device
-  HANDLE_CUDA_ERROR(cudaMemcpy(this->getVoidDeviceDataPtr(), (void*)buffer, getMemoryUsage(), cudaMemcpyHostToDevice));
+  m_brick_index_valid = false;
+  ++m_generation;
+  if (this->m_backend == MB_HOST)
+  {
+    memcpy((void*) m_dev_data, (void*)buffer, getMemoryUsage());
+  }
+  else
+  {
+    HANDLE_CUDA_ERROR(cudaMemcpy((void*) m_dev_data, (void*)buffer, getMemoryUsage(), cudaMemcpyHostToDevice));
+  }
 
   in.close();
-  delete buffer;
+  delete[] buffer;
   LOGGING_INFO_C(VoxelmapLog, VoxelMap, "... reading from disk is done." << endl);
   return true;
 }
@@ -836,6 +1465,11 @@ template<class Voxel>
 void TemplateVoxelMap<Voxel>::initSensorSettings(const Sensor& sensor)
 {
   lock_guard guard(this->m_mutex);
+  if (this->m_backend == MB_HOST)
+  {
+    LOGGING_ERROR_C(VoxelmapLog, VoxelMap, GPU_VOXELS_MAP_OPERATION_NOT_SUPPORTED << endl);
+    return;
+  }
   m_sensor = sensor;
 
   if (m_dev_raw_sensor_data)
@@ -34,6 +34,9 @@ template uint32_t TemplateVoxelMap<ProbabilisticVoxel>::collisionCheckWithCounte
 // Explicitly instantiate template methods to enable GCC to link agains NVCC compiled objects
 template void ProbVoxelMap::insertSensorData<BIT_VECTOR_LENGTH>(const Vector3f*, const bool, const bool,
                                                                 const BitVoxelMeaning, BitVoxel<BIT_VECTOR_LENGTH>*);
+template void ProbVoxelMap::insertSensorDataOnDevice<BIT_VECTOR_LENGTH>(const Sensor*, const Vector3f*, const uint32_t,
+                                                                        const bool, const bool, const BitVoxelMeaning,
+                                                                        BitVoxel<BIT_VECTOR_LENGTH>*, cudaStream_t);
 
 
 // ##################################################################################
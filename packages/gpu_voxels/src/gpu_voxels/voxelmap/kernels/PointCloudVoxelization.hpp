@@ -0,0 +1,120 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Voxel grid downsampling of point clouds before they are inserted into
+ * a map or list. The points are sorted by the linear index of their
+ * voxel and only one point per voxel is kept, optionally together with
+ * the number of points that fell into the voxel. The same code runs on
+ * thrust device vectors and host vectors, so both backends share it.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_VOXELMAP_KERNELS_POINT_CLOUD_VOXELIZATION_HPP_INCLUDED
+#define GPU_VOXELS_VOXELMAP_KERNELS_POINT_CLOUD_VOXELIZATION_HPP_INCLUDED
+
+#include <gpu_voxels/helpers/cuda_datatypes.h>
+#include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.h>
+#include <thrust/binary_search.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+
+namespace gpu_voxels {
+namespace voxelmap {
+
+//! Key of the points that lie outside the map. It is larger than all valid keys.
+static const uint32_t cINVALID_VOXEL_KEY = 0xFFFFFFFF;
+
+/*!
+ * Thrust operator voxelKeyOperator: Delivers the linear index of the voxel of
+ * a point within a map of the given dimensions or cINVALID_VOXEL_KEY.
+ */
+struct voxelKeyOperator
+{
+  Vector3ui map_dim;
+  float voxel_side_length;
+  voxelKeyOperator(const Vector3ui &map_dim_, const float voxel_side_length_)
+  {
+    map_dim = map_dim_;
+    voxel_side_length = voxel_side_length_;
+  }
+
+  __host__ __device__
+  uint32_t operator()(const Vector3f &point) const
+  {
+    // negative coordinates wrap around and fail the check as well
+    const Vector3ui coords = mapToVoxels(voxel_side_length, point);
+    if (coords.x >= map_dim.x || coords.y >= map_dim.y || coords.z >= map_dim.z)
+    {
+      return cINVALID_VOXEL_KEY;
+    }
+    return getVoxelIndexUnsigned(map_dim, coords);
+  }
+};
+
+/*!
+ * \brief voxelizePointCloud Reduces a point cloud to one point per occupied voxel.
+ *
+ * Works in place on \a points, which may be a thrust::device_vector or a thrust::host_vector.
+ * The key, point and count vectors have to live in the same memory.
+ * Afterwards \a points holds the first point of each voxel, ordered by the voxel index,
+ * \a voxel_keys the linear voxel indices and, if \a count_points is set, \a point_counts
+ * the number of points of each voxel. Points outside the map are removed.
+ *
+ * \return true if points outside the map were removed
+ */
+template<class PointVector, class KeyVector, class CountVector>
+bool voxelizePointCloud(const Vector3ui &map_dim, const float voxel_side_length, PointVector &points,
+                        KeyVector &voxel_keys, CountVector &point_counts, const bool count_points)
+{
+  const size_t num_points = points.size();
+  voxel_keys.resize(num_points);
+  thrust::transform(points.begin(), points.end(), voxel_keys.begin(), voxelKeyOperator(map_dim, voxel_side_length));
+
+  // thrust sorts integer keys with a stable radix sort, so the first point of each voxel stays first
+  thrust::sort_by_key(voxel_keys.begin(), voxel_keys.end(), points.begin());
+
+  // the invalid keys are sorted to the end
+  const size_t num_inside = thrust::lower_bound(voxel_keys.begin(), voxel_keys.end(), cINVALID_VOXEL_KEY)
+      - voxel_keys.begin();
+
+  if (count_points)
+  {
+    point_counts.resize(num_inside);
+    thrust::reduce_by_key(voxel_keys.begin(), voxel_keys.begin() + num_inside,
+                          thrust::make_constant_iterator(uint32_t(1)),
+                          thrust::make_discard_iterator(), point_counts.begin());
+  }
+
+  const size_t num_voxels = thrust::unique_by_key(voxel_keys.begin(), voxel_keys.begin() + num_inside,
+                                                  points.begin()).first - voxel_keys.begin();
+  points.resize(num_voxels);
+  voxel_keys.resize(num_voxels);
+  if (count_points)
+  {
+    point_counts.resize(num_voxels);
+  }
+  return num_inside < num_points;
+}
+
+} // end of namespace voxelmap
+} // end of namespace gpu_voxels
+
+#endif
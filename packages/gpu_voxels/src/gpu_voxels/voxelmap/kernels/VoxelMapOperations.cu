@@ -70,6 +70,38 @@ void kernelTransformSensorData(Sensor* sensor, Vector3f* raw_sensor_data, Vector
   }
 }
 
+__global__
+void kernelMarkBricks(const Vector3ui dimensions, const float voxel_side_length,
+                      const Vector3f* points, const std::size_t sizePoints, uint8_t* brick_occupancy)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < sizePoints; i += gridDim.x * blockDim.x)
+  {
+    const Vector3ui uint_coords = mapToVoxels(voxel_side_length, points[i]);
+    if ((uint_coords.x < dimensions.x) && (uint_coords.y < dimensions.y) && (uint_coords.z < dimensions.z))
+    {
+      // all threads write the same value, so no atomics are needed
+      brick_occupancy[getBrickIndex(brick_dimensions, uint_coords)] = 1;
+    }
+  }
+}
+
+__global__
+void kernelMarkBricks(const Vector3ui dimensions, const float voxel_side_length,
+                      const MetaPointCloudStruct* meta_point_cloud, uint8_t* brick_occupancy)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < meta_point_cloud->accumulated_cloud_size;
+      i += gridDim.x * blockDim.x)
+  {
+    const Vector3ui uint_coords = mapToVoxels(voxel_side_length, meta_point_cloud->clouds_base_addresses[0][i]);
+    if ((uint_coords.x < dimensions.x) && (uint_coords.y < dimensions.y) && (uint_coords.z < dimensions.z))
+    {
+      brick_occupancy[getBrickIndex(brick_dimensions, uint_coords)] = 1;
+    }
+  }
+}
+
 
 //
 //void kernelCalculateBoundingBox(Voxel* voxelmap, const uint32_t voxelmap_size, )
@@ -25,6 +25,7 @@
 
 #include <cuda_runtime.h>
 #include <gpu_voxels/helpers/cuda_datatypes.h>
+#include <gpu_voxels/helpers/CollisionQuery.h>
 #include <gpu_voxels/voxel/BitVoxel.h>
 #include <gpu_voxels/voxel/ProbabilisticVoxel.h>
 #include <gpu_voxels/voxel/DistanceVoxel.h>
@@ -162,6 +163,178 @@ Vector3f getVoxelCenter(float voxel_side_length, const Vector3ui &voxel_coords)
                   voxel_coords.z * voxel_side_length + voxel_side_length / 2.0);
 }
 
+/* ------------------ Brick occupancy index ------------ */
+/* The map is partitioned into bricks of cBRICK_SIDE_LENGTH^3 voxels.
+ * A brick is flagged as soon as a voxel inside of it gets written.
+ * Unflagged bricks only hold voxels in their cleared state. */
+
+//! Number of voxels along each axis of a brick
+static const uint32_t cBRICK_SIDE_LENGTH = 8;
+//! Number of voxels in one brick
+static const uint32_t cVOXELS_PER_BRICK = cBRICK_SIDE_LENGTH * cBRICK_SIDE_LENGTH * cBRICK_SIDE_LENGTH;
+
+//! Number of bricks along each axis, border bricks may be only partially inside of the map
+__device__ __host__     __forceinline__
+Vector3ui getBrickDimensions(const Vector3ui &dimensions)
+{
+  return Vector3ui((dimensions.x + cBRICK_SIDE_LENGTH - 1) / cBRICK_SIDE_LENGTH,
+                   (dimensions.y + cBRICK_SIDE_LENGTH - 1) / cBRICK_SIDE_LENGTH,
+                   (dimensions.z + cBRICK_SIDE_LENGTH - 1) / cBRICK_SIDE_LENGTH);
+}
+
+//! Maps 3D voxel coordinates to the linear index of the brick containing the voxel
+__device__ __host__     __forceinline__
+uint32_t getBrickIndex(const Vector3ui &brick_dimensions, const Vector3ui &voxel_coords)
+{
+  return getVoxelIndexUnsigned(brick_dimensions, voxel_coords.x / cBRICK_SIDE_LENGTH,
+                               voxel_coords.y / cBRICK_SIDE_LENGTH, voxel_coords.z / cBRICK_SIDE_LENGTH);
+}
+
+/*! Maps the voxel number \a voxel_in_brick of brick \a brick to its linear voxel index.
+ *  Returns false if the voxel of a border brick lies outside of the map.
+ */
+__device__ __host__     __forceinline__
+bool getBrickVoxelIndex(const Vector3ui &dimensions, const Vector3ui &brick_dimensions,
+                        const uint32_t brick, const uint32_t voxel_in_brick, uint32_t &voxel_index)
+{
+  const uint32_t brick_plane = brick_dimensions.x * brick_dimensions.y;
+  const uint32_t x = (brick % brick_dimensions.x) * cBRICK_SIDE_LENGTH + voxel_in_brick % cBRICK_SIDE_LENGTH;
+  const uint32_t y = ((brick % brick_plane) / brick_dimensions.x) * cBRICK_SIDE_LENGTH
+                     + (voxel_in_brick / cBRICK_SIDE_LENGTH) % cBRICK_SIDE_LENGTH;
+  const uint32_t z = (brick / brick_plane) * cBRICK_SIDE_LENGTH
+                     + voxel_in_brick / (cBRICK_SIDE_LENGTH * cBRICK_SIDE_LENGTH);
+  if ((x >= dimensions.x) || (y >= dimensions.y) || (z >= dimensions.z))
+  {
+    return false;
+  }
+  voxel_index = getVoxelIndexUnsigned(dimensions, x, y, z);
+  return true;
+}
+
+/*! Collides \a voxel with the voxels at \a voxel_index of all \a targets and accumulates
+ *  the colliding voxels and meanings per target. Returns true if any target collides.
+ */
+template<std::size_t length, class Collider>
+__device__ __host__     __forceinline__
+bool collideWithTargets(const BitVoxel<length>& voxel, const uint32_t voxel_index,
+                        const CollisionQueryTargets<length>& targets, const Collider& collider,
+                        uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+  bool collision = false;
+  for (uint32_t m = 0; m < targets.num_maps; ++m)
+  {
+    BitVector<length> temp;
+    const bool map_collision = targets.bit_maps[m] != NULL
+        ? collider.collide(voxel, targets.bit_maps[m][voxel_index], &temp, 0)
+        : collider.collide(voxel, targets.prob_maps[m][voxel_index], &temp);
+    if (map_collision)
+    {
+      num_collisions[m]++;
+      colliding_meanings[m] |= temp;
+      collision = true;
+    }
+  }
+  return collision;
+}
+
+//! Clamps a voxel coordinate to the map
+__host__ __device__ __forceinline__
+int32_t clampToDimension(const int32_t coordinate, const uint32_t dimension)
+{
+  return coordinate < 0 ? 0 : (coordinate >= int32_t(dimension) ? int32_t(dimension) - 1 : coordinate);
+}
+
+//! Metric obstacle distance of a voxel, the coordinates have to lie within the map
+__host__ __device__ __forceinline__
+float obstacleDistanceAt(const DistanceVoxel* voxels, const Vector3ui& dimensions, const float voxel_side_length,
+                         const int32_t x, const int32_t y, const int32_t z)
+{
+  const DistanceVoxel& voxel = voxels[getVoxelIndexSigned(dimensions, x, y, z)];
+  return sqrtf(float(voxel.squaredObstacleDistance(Vector3i(x, y, z)))) * voxel_side_length;
+}
+
+//! Obstacle distance of a voxel after clamping its coordinates to the map
+__host__ __device__ __forceinline__
+float clampedObstacleDistanceAt(const DistanceVoxel* voxels, const Vector3ui& dimensions, const float voxel_side_length,
+                                const int32_t x, const int32_t y, const int32_t z)
+{
+  return obstacleDistanceAt(voxels, dimensions, voxel_side_length, clampToDimension(x, dimensions.x),
+                            clampToDimension(y, dimensions.y), clampToDimension(z, dimensions.z));
+}
+
+//! Central difference of the distances along one axis, one sided at the map border
+__host__ __device__ __forceinline__
+float obstacleDistanceDifference(const float lower, const float upper, const int32_t lower_coordinate,
+                                 const int32_t upper_coordinate, const float voxel_side_length)
+{
+  return upper_coordinate == lower_coordinate ?
+      0.0f : (upper - lower) / (float(upper_coordinate - lower_coordinate) * voxel_side_length);
+}
+
+/*!
+ * \brief queryObstacleDistance Evaluates the distance queries of one metric point,
+ * see DistanceVoxelMap::queryObstacleDistances(). The result pointers may be NULL.
+ */
+__host__ __device__ __forceinline__
+void queryObstacleDistance(const DistanceVoxel* voxels, const Vector3ui& dimensions, const float voxel_side_length,
+                           const Vector3f& point, float* distance, float* interpolated_distance, Vector3f* gradient)
+{
+  const float gx = point.x / voxel_side_length;
+  const float gy = point.y / voxel_side_length;
+  const float gz = point.z / voxel_side_length;
+  const int32_t x = clampToDimension(int32_t(floorf(gx)), dimensions.x);
+  const int32_t y = clampToDimension(int32_t(floorf(gy)), dimensions.y);
+  const int32_t z = clampToDimension(int32_t(floorf(gz)), dimensions.z);
+
+  if (distance)
+  {
+    *distance = obstacleDistanceAt(voxels, dimensions, voxel_side_length, x, y, z);
+  }
+
+  if (interpolated_distance)
+  {
+    // interpolate between the centers of the eight surrounding voxels
+    const int32_t x0 = int32_t(floorf(gx - 0.5f));
+    const int32_t y0 = int32_t(floorf(gy - 0.5f));
+    const int32_t z0 = int32_t(floorf(gz - 0.5f));
+    const float tx = fminf(fmaxf(gx - 0.5f - x0, 0.0f), 1.0f);
+    const float ty = fminf(fmaxf(gy - 0.5f - y0, 0.0f), 1.0f);
+    const float tz = fminf(fmaxf(gz - 0.5f - z0, 0.0f), 1.0f);
+    float corners[2][2];
+    for (int32_t dz = 0; dz < 2; ++dz)
+    {
+      for (int32_t dy = 0; dy < 2; ++dy)
+      {
+        const float d0 = clampedObstacleDistanceAt(voxels, dimensions, voxel_side_length, x0, y0 + dy, z0 + dz);
+        const float d1 = clampedObstacleDistanceAt(voxels, dimensions, voxel_side_length, x0 + 1, y0 + dy, z0 + dz);
+        corners[dz][dy] = d0 + (d1 - d0) * tx;
+      }
+    }
+    const float c0 = corners[0][0] + (corners[0][1] - corners[0][0]) * ty;
+    const float c1 = corners[1][0] + (corners[1][1] - corners[1][0]) * ty;
+    *interpolated_distance = c0 + (c1 - c0) * tz;
+  }
+
+  if (gradient)
+  {
+    const int32_t x_lo = clampToDimension(x - 1, dimensions.x);
+    const int32_t x_hi = clampToDimension(x + 1, dimensions.x);
+    const int32_t y_lo = clampToDimension(y - 1, dimensions.y);
+    const int32_t y_hi = clampToDimension(y + 1, dimensions.y);
+    const int32_t z_lo = clampToDimension(z - 1, dimensions.z);
+    const int32_t z_hi = clampToDimension(z + 1, dimensions.z);
+    gradient->x = obstacleDistanceDifference(obstacleDistanceAt(voxels, dimensions, voxel_side_length, x_lo, y, z),
+                                             obstacleDistanceAt(voxels, dimensions, voxel_side_length, x_hi, y, z),
+                                             x_lo, x_hi, voxel_side_length);
+    gradient->y = obstacleDistanceDifference(obstacleDistanceAt(voxels, dimensions, voxel_side_length, x, y_lo, z),
+                                             obstacleDistanceAt(voxels, dimensions, voxel_side_length, x, y_hi, z),
+                                             y_lo, y_hi, voxel_side_length);
+    gradient->z = obstacleDistanceDifference(obstacleDistanceAt(voxels, dimensions, voxel_side_length, x, y, z_lo),
+                                             obstacleDistanceAt(voxels, dimensions, voxel_side_length, x, y, z_hi),
+                                             z_lo, z_hi, voxel_side_length);
+  }
+}
+
 //! update min_voxel if newVoxel is valid and closer
 __device__      __forceinline__
 void updateMinVoxel(const DistanceVoxel& new_voxel, DistanceVoxel& min_voxel, const Vector3i& cur_pos)
@@ -410,6 +583,81 @@ __global__
 void kernelCollideVoxelMapsDebug(Voxel* voxelmap, const uint32_t voxelmap_size, OtherVoxel* other_map,
                                  Collider collider, uint16_t* results);
 
+/*!
+ * Same as kernelCollideVoxelMaps() but only visits the voxels of the
+ * \a num_bricks bricks listed in \a bricks.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsBricks(Voxel* voxelmap, const Vector3ui dimensions, OtherVoxel* other_map,
+                                  const uint32_t* bricks, const uint32_t num_bricks,
+                                  Collider collider, bool* results);
+
+/*!
+ * Same as kernelCollideVoxelMapsDebug() but only visits the voxels of the
+ * \a num_bricks bricks listed in \a bricks.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsDebugBricks(Voxel* voxelmap, const Vector3ui dimensions, OtherVoxel* other_map,
+                                       const uint32_t* bricks, const uint32_t num_bricks,
+                                       Collider collider, uint16_t* results);
+
+/*!
+ * Same as kernelCollideVoxelMapsBitvector() but only visits the voxels of the
+ * \a num_bricks bricks listed in \a bricks.
+ */
+template<std::size_t length, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsBitvectorBricks(BitVoxel<length>* voxelmap, const Vector3ui dimensions,
+                                           const OtherVoxel* other_map, const uint32_t* bricks,
+                                           const uint32_t num_bricks, Collider collider,
+                                           BitVector<length>* results, uint16_t* num_collisions,
+                                           const uint16_t sv_offset);
+
+/*!
+ * Collide a bit voxel map with all \a targets in one pass. \a num_voxels voxels are visited,
+ * either the whole map or, if \a bricks is not NULL, the voxels of the listed bricks.
+ * Every block writes cMAX_COLLISION_QUERY_MAPS entries to \a results and \a num_collisions.
+ * Needs a power of two number of threads per block.
+ *
+ * Collision info is stored as eBVM_COLLISION in \a voxelmap.
+ */
+template<std::size_t length, class Collider>
+__global__
+void kernelCollideVoxelMapWithMaps(BitVoxel<length>* voxelmap, const Vector3ui dimensions,
+                                   const uint32_t num_voxels, const uint32_t* bricks,
+                                   const CollisionQueryTargets<length> targets, Collider collider,
+                                   BitVector<length>* results, uint32_t* num_collisions);
+
+/*!
+ * Sets all voxels of the \a num_bricks bricks listed in \a bricks to \a cleared_voxel.
+ */
+template<class Voxel>
+__global__
+void kernelClearBricks(Voxel* voxelmap, const Vector3ui dimensions, const uint32_t* bricks,
+                       const uint32_t num_bricks, const Voxel cleared_voxel);
+
+/*!
+ * Flags the bricks of all points that lie inside of the map.
+ */
+__global__
+void kernelMarkBricks(const Vector3ui map_dim, const float voxel_side_length,
+                      const Vector3f* points, const std::size_t sizePoints, uint8_t* brick_occupancy);
+
+/*!
+ * Updates the occupancy of the voxels with the given linear indices once.
+ * The indices have to be unique.
+ */
+template<class Voxel>
+__global__
+void kernelUpdateOccupancy(Voxel* voxelmap, const uint32_t* voxel_indices, const uint32_t num_voxels,
+                           const Probability occupancy);
+
+__global__
+void kernelMarkBricks(const Vector3ui map_dim, const float voxel_side_length,
+                      const MetaPointCloudStruct* meta_point_cloud, uint8_t* brick_occupancy);
+
 /*!
  * Inserts pointcloud with global coordinates.
  *
@@ -455,6 +703,15 @@ __global__
 void kernelExactDistances3D(DistanceVoxel* voxels, const Vector3ui dims, const float voxel_side_length,
                             Vector3f* points, const std::size_t sizePoints);
 
+/**
+ * Batched distance queries of metric points, see DistanceVoxelMap::queryObstacleDistances().
+ * The result pointers may be NULL.
+ */
+__global__
+void kernelQueryObstacleDistances(const DistanceVoxel* voxels, const Vector3ui dims, const float voxel_side_length,
+                                  const Vector3f* points, const uint32_t num_points, float* distances,
+                                  float* interpolated_distances, Vector3f* gradients);
+
 } // end of namespace voxelmap
 } // end of namespace gpu_voxels
 #endif
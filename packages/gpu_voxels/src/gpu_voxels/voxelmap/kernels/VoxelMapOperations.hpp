@@ -238,6 +238,208 @@ void kernelCollideVoxelMapsBitvector(BitVoxel<length>* voxelmap, const uint32_t
   }
 }
 
+template<class Voxel, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsBricks(Voxel* voxelmap, const Vector3ui dimensions, OtherVoxel* other_map,
+                                  const uint32_t* bricks, const uint32_t num_bricks,
+                                  Collider collider, bool* results)
+{
+  __shared__ bool cache[cMAX_THREADS_PER_BLOCK];
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  const uint32_t num_voxels = num_bricks * cVOXELS_PER_BRICK;
+  uint32_t cache_index = threadIdx.x;
+  uint32_t voxel_index;
+  bool temp = false;
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += blockDim.x * gridDim.x)
+  {
+    if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index)
+        && collider.collide(voxelmap[voxel_index], other_map[voxel_index]))
+    {
+      temp = true;
+    }
+  }
+
+  cache[cache_index] = temp;
+  __syncthreads();
+
+  uint32_t j = blockDim.x / 2;
+
+  while (j != 0)
+  {
+    if (cache_index < j)
+    {
+      cache[cache_index] = cache[cache_index] || cache[cache_index + j];
+    }
+    __syncthreads();
+    j /= 2;
+  }
+
+  // copy results from this block to global memory
+  if (cache_index == 0)
+  {
+    results[blockIdx.x] = cache[0];
+  }
+}
+
+template<class Voxel, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsDebugBricks(Voxel* voxelmap, const Vector3ui dimensions, OtherVoxel* other_map,
+                                       const uint32_t* bricks, const uint32_t num_bricks,
+                                       Collider collider, uint16_t* results)
+{
+  __shared__ uint16_t cache[cMAX_THREADS_PER_BLOCK];
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  const uint32_t num_voxels = num_bricks * cVOXELS_PER_BRICK;
+  uint32_t cache_index = threadIdx.x;
+  uint32_t voxel_index;
+  cache[cache_index] = 0;
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += blockDim.x * gridDim.x)
+  {
+    if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index)
+        && collider.collide(voxelmap[voxel_index], other_map[voxel_index]))
+    {
+      voxelmap[voxel_index].insert(eBVM_COLLISION); // sets m_occupancy = MAX_PROBABILITY for prob voxels
+      cache[cache_index] += 1;
+    }
+  }
+  __syncthreads();
+
+  uint32_t j = blockDim.x / 2;
+
+  while (j != 0)
+  {
+    if (cache_index < j)
+    {
+      cache[cache_index] = cache[cache_index] + cache[cache_index + j];
+    }
+    __syncthreads();
+    j /= 2;
+  }
+
+  // copy results from this block to global memory
+  if (cache_index == 0)
+  {
+    results[blockIdx.x] = cache[0];
+  }
+}
+
+template<std::size_t length, class OtherVoxel, class Collider>
+__global__
+void kernelCollideVoxelMapsBitvectorBricks(BitVoxel<length>* voxelmap, const Vector3ui dimensions,
+                                           const OtherVoxel* other_map, const uint32_t* bricks,
+                                           const uint32_t num_bricks, Collider collider,
+                                           BitVector<length>* results, uint16_t* num_collisions,
+                                           const uint16_t sv_offset)
+{
+  extern __shared__ BitVector<length> cache[]; //[cMAX_THREADS_PER_BLOCK];
+  __shared__ uint16_t cache_num[cMAX_THREADS_PER_BLOCK];
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  const uint32_t num_voxels = num_bricks * cVOXELS_PER_BRICK;
+  uint32_t cache_index = threadIdx.x;
+  uint32_t voxel_index;
+  cache[cache_index] = BitVector<length>();
+  cache_num[cache_index] = 0;
+  BitVector<length> temp;
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += blockDim.x * gridDim.x)
+  {
+    if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index)
+        && collider.collide(voxelmap[voxel_index], other_map[voxel_index], &temp, sv_offset))
+    {
+      voxelmap[voxel_index].insert(eBVM_COLLISION);
+      cache[cache_index] = cache[cache_index] | temp;
+      cache_num[cache_index] += 1;
+    }
+  }
+  __syncthreads();
+
+  uint32_t j = blockDim.x / 2;
+
+  while (j != 0)
+  {
+    if (cache_index < j)
+    {
+      cache[cache_index] = cache[cache_index] | cache[cache_index + j];
+      cache_num[cache_index] = cache_num[cache_index] + cache_num[cache_index + j];
+    }
+    __syncthreads();
+    j /= 2;
+  }
+
+  // copy results from this block to global memory
+  if (cache_index == 0)
+  {
+    results[blockIdx.x] = cache[0];
+    num_collisions[blockIdx.x] = cache_num[0];
+  }
+}
+
+template<std::size_t length, class Collider>
+__global__
+void kernelCollideVoxelMapWithMaps(BitVoxel<length>* voxelmap, const Vector3ui dimensions,
+                                   const uint32_t num_voxels, const uint32_t* bricks,
+                                   const CollisionQueryTargets<length> targets, Collider collider,
+                                   BitVector<length>* results, uint32_t* num_collisions)
+{
+  extern __shared__ BitVector<length> cache[]; //[cMAX_THREADS_PER_BLOCK];
+  __shared__ uint32_t cache_num[cMAX_THREADS_PER_BLOCK];
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  const uint32_t cache_index = threadIdx.x;
+
+  // every thread accumulates its own results of all targets
+  uint32_t thread_num_collisions[cMAX_COLLISION_QUERY_MAPS];
+  BitVector<length> thread_meanings[cMAX_COLLISION_QUERY_MAPS];
+  for (uint32_t m = 0; m < cMAX_COLLISION_QUERY_MAPS; ++m)
+  {
+    thread_num_collisions[m] = 0;
+  }
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += blockDim.x * gridDim.x)
+  {
+    uint32_t voxel_index = i;
+    if (bricks != NULL
+        && !getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index))
+    {
+      continue;
+    }
+    BitVoxel<length>& voxel = voxelmap[voxel_index];
+    if (!voxel.bitVector().isZero()
+        && collideWithTargets(voxel, voxel_index, targets, collider, thread_num_collisions, thread_meanings))
+    {
+      voxel.insert(eBVM_COLLISION);
+    }
+  }
+
+  // reduce the results of one target after another
+  for (uint32_t m = 0; m < targets.num_maps; ++m)
+  {
+    cache[cache_index] = thread_meanings[m];
+    cache_num[cache_index] = thread_num_collisions[m];
+    __syncthreads();
+
+    uint32_t j = blockDim.x / 2;
+    while (j != 0)
+    {
+      if (cache_index < j)
+      {
+        cache[cache_index] = cache[cache_index] | cache[cache_index + j];
+        cache_num[cache_index] = cache_num[cache_index] + cache_num[cache_index + j];
+      }
+      __syncthreads();
+      j /= 2;
+    }
+
+    if (cache_index == 0)
+    {
+      results[blockIdx.x * cMAX_COLLISION_QUERY_MAPS + m] = cache[0];
+      num_collisions[blockIdx.x * cMAX_COLLISION_QUERY_MAPS + m] = cache_num[0];
+    }
+    __syncthreads();
+  }
+}
+
 template<class Voxel>
 __global__
 void kernelInsertGlobalPointCloud(Voxel* voxelmap, const Vector3ui dimensions, const float voxel_side_length,
@@ -612,6 +814,36 @@ void kernelInsertSensorData(ProbabilisticVoxel* voxelmap, const uint32_t voxelma
   }
 }
 
+template<class Voxel>
+__global__
+void kernelClearBricks(Voxel* voxelmap, const Vector3ui dimensions, const uint32_t* bricks,
+                       const uint32_t num_bricks, const Voxel cleared_voxel)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  const uint32_t num_voxels = num_bricks * cVOXELS_PER_BRICK;
+  uint32_t voxel_index;
+
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += blockDim.x * gridDim.x)
+  {
+    if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index))
+    {
+      voxelmap[voxel_index] = cleared_voxel;
+    }
+  }
+}
+
+template<class Voxel>
+__global__
+void kernelUpdateOccupancy(Voxel* voxelmap, const uint32_t* voxel_indices, const uint32_t num_voxels,
+                           const Probability occupancy)
+{
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_voxels; i += gridDim.x * blockDim.x)
+  {
+    // the indices are unique, so no atomics are needed
+    voxelmap[voxel_indices[i]].updateOccupancy(occupancy);
+  }
+}
+
 template<std::size_t length>
 __global__
 void kernelShiftBitVector(BitVoxel<length>* voxelmap,
@@ -793,6 +1025,20 @@ void kernelExactDistances3D(DistanceVoxel* voxels, const Vector3ui dims, const f
   }
 }
 
+__global__
+void kernelQueryObstacleDistances(const DistanceVoxel* voxels, const Vector3ui dims, const float voxel_side_length,
+                                  const Vector3f* points, const uint32_t num_points, float* distances,
+                                  float* interpolated_distances, Vector3f* gradients)
+{
+  for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_points; i += blockDim.x * gridDim.x)
+  {
+    queryObstacleDistance(voxels, dims, voxel_side_length, points[i],
+                          distances ? &distances[i] : NULL,
+                          interpolated_distances ? &interpolated_distances[i] : NULL,
+                          gradients ? &gradients[i] : NULL);
+  }
+}
+
 } // end of namespace voxelmap
 } // end of namespace gpu_voxels
 #endif
@@ -0,0 +1,578 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the GPU Voxels Software Library.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Host counterparts of the voxelmap kernels in VoxelMapOperations.hpp.
+ * They are used by maps that were created with the MB_HOST backend and
+ * operate on voxel arrays in host memory. The loops are parallelized
+ * with OpenMP if it is available and run serially otherwise.
+ *
+ * Semantics (including the insertion of eBVM_COLLISION into colliding
+ * voxels) mirror the device kernels, so results of both backends can
+ * be compared voxel by voxel.
+ *
+ */
+//----------------------------------------------------------------------
+#ifndef GPU_VOXELS_VOXELMAP_KERNELS_VOXELMAP_OPERATIONS_HOST_HPP_INCLUDED
+#define GPU_VOXELS_VOXELMAP_KERNELS_VOXELMAP_OPERATIONS_HOST_HPP_INCLUDED
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <gpu_voxels/helpers/MetaPointCloud.h>
+#include <gpu_voxels/voxelmap/kernels/VoxelMapOperations.h>
+#include <gpu_voxels/voxel/BitVoxel.hpp>
+#include <gpu_voxels/voxel/DistanceVoxel.hpp>
+
+namespace gpu_voxels {
+namespace voxelmap {
+
+//! Sets every voxel of the map to \a value
+template<class Voxel>
+void hostClearVoxelMap(Voxel* voxelmap, const uint32_t voxelmap_size, const Voxel& value)
+{
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+  {
+    voxelmap[i] = value;
+  }
+}
+
+//! Host version of kernelClearBricks()
+template<class Voxel>
+void hostClearBricks(Voxel* voxelmap, const Vector3ui& dimensions, const uint32_t* bricks,
+                     const uint32_t num_bricks, const Voxel& value)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+
+#pragma omp parallel for schedule(static)
+  for (int64_t b = 0; b < int64_t(num_bricks); ++b)
+  {
+    uint32_t voxel_index;
+    for (uint32_t v = 0; v < cVOXELS_PER_BRICK; ++v)
+    {
+      if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[b], v, voxel_index))
+      {
+        voxelmap[voxel_index] = value;
+      }
+    }
+  }
+}
+
+//! Clears the bit \a bit_index in all voxels of the map
+template<std::size_t bit_length>
+void hostClearVoxelMap(BitVoxel<bit_length>* voxelmap, const uint32_t voxelmap_size, const uint32_t bit_index)
+{
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+  {
+    BitVector<bit_length>& bit_vector = voxelmap[i].bitVector();
+    if (bit_vector.getBit(bit_index))
+      bit_vector.clearBit(bit_index);
+  }
+}
+
+//! Clears all \a bits in all voxels of the map
+template<std::size_t bit_length>
+void hostClearVoxelMap(BitVoxel<bit_length>* voxelmap, const uint32_t voxelmap_size,
+                       const BitVector<bit_length>& bits)
+{
+  const BitVector<bit_length> inverted_bits = ~bits;
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+  {
+    BitVector<bit_length>& bit_vector = voxelmap[i].bitVector();
+    if (!(bit_vector & bits).isZero())
+    {
+      bit_vector = bit_vector & inverted_bits;
+    }
+  }
+}
+
+//! Host version of kernelShiftBitVector()
+template<std::size_t length>
+void hostShiftBitVector(BitVoxel<length>* voxelmap, const uint32_t voxelmap_size, const uint8_t shift_size)
+{
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+  {
+    performLeftShift(voxelmap[i].bitVector(), shift_size);
+  }
+}
+
+/*! Collide two voxel maps.
+ *  Returns true if any pair of voxels collides.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+bool hostCollideVoxelMaps(const Voxel* voxelmap, const uint32_t voxelmap_size, const OtherVoxel* other_map,
+                          Collider collider)
+{
+  bool collision = false;
+#pragma omp parallel for schedule(static) reduction(||:collision)
+  for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+  {
+    collision = collision || collider.collide(voxelmap[i], other_map[i]);
+  }
+  return collision;
+}
+
+/*! Collide two voxel maps and count the colliding voxels.
+ *  The voxel other_map[i] is compared against voxelmap[i + offset], which
+ *  corresponds to the pointer arithmetic done by getVoxelPtrSignedOffset()
+ *  on the device. Voxels that are shifted outside of \a voxelmap are skipped.
+ *
+ *  Collision info is stored as eBVM_COLLISION in \a voxelmap.
+ *  Warning: Original model is modified!
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+uint32_t hostCollideVoxelMapsDebug(Voxel* voxelmap, const uint32_t voxelmap_size, const int32_t offset,
+                                   const OtherVoxel* other_map, Collider collider)
+{
+  const int64_t first = std::max<int64_t>(0, -int64_t(offset));
+  const int64_t last = std::min<int64_t>(voxelmap_size, int64_t(voxelmap_size) - int64_t(offset));
+  uint32_t num_collisions = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:num_collisions)
+  for (int64_t i = first; i < last; ++i)
+  {
+    Voxel& voxel = voxelmap[i + offset];
+    if (collider.collide(voxel, other_map[i]))
+    {
+      voxel.insert(eBVM_COLLISION);
+      num_collisions++;
+    }
+  }
+  return num_collisions;
+}
+
+/*! Collide a bit voxel map with another map and accumulate the colliding
+ *  meanings in \a colliding_meanings. Returns the number of colliding voxels.
+ */
+template<std::size_t length, class OtherVoxel, class Collider>
+uint32_t hostCollideVoxelMapsBitvector(BitVoxel<length>* voxelmap, const uint32_t voxelmap_size,
+                                       const OtherVoxel* other_map, Collider collider,
+                                       BitVector<length>& colliding_meanings, const uint16_t sv_offset)
+{
+  uint32_t num_collisions = 0;
+
+#pragma omp parallel reduction(+:num_collisions)
+  {
+    // every thread accumulates its own meanings, they get merged at the end
+    BitVector<length> thread_meanings;
+    BitVector<length> temp;
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(voxelmap_size); ++i)
+    {
+      if (collider.collide(voxelmap[i], other_map[i], &temp, sv_offset))
+      {
+        voxelmap[i].insert(eBVM_COLLISION);
+        thread_meanings |= temp;
+        num_collisions++;
+      }
+    }
+
+#pragma omp critical
+    colliding_meanings |= thread_meanings;
+  }
+  return num_collisions;
+}
+
+/*! Brick version of hostCollideVoxelMaps().
+ *  Only the voxels of the \a num_bricks bricks listed in \a bricks are compared.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+bool hostCollideVoxelMapsBricks(const Voxel* voxelmap, const Vector3ui& dimensions, const OtherVoxel* other_map,
+                                const uint32_t* bricks, const uint32_t num_bricks, Collider collider)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  bool collision = false;
+
+#pragma omp parallel for schedule(dynamic) reduction(||:collision)
+  for (int64_t b = 0; b < int64_t(num_bricks); ++b)
+  {
+    uint32_t voxel_index;
+    for (uint32_t v = 0; v < cVOXELS_PER_BRICK && !collision; ++v)
+    {
+      if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[b], v, voxel_index))
+      {
+        collision = collider.collide(voxelmap[voxel_index], other_map[voxel_index]);
+      }
+    }
+  }
+  return collision;
+}
+
+/*! Brick version of hostCollideVoxelMapsDebug() without offset.
+ *  Collision info is stored as eBVM_COLLISION in \a voxelmap.
+ */
+template<class Voxel, class OtherVoxel, class Collider>
+uint32_t hostCollideVoxelMapsDebugBricks(Voxel* voxelmap, const Vector3ui& dimensions, const OtherVoxel* other_map,
+                                         const uint32_t* bricks, const uint32_t num_bricks, Collider collider)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  uint32_t num_collisions = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+:num_collisions)
+  for (int64_t b = 0; b < int64_t(num_bricks); ++b)
+  {
+    uint32_t voxel_index;
+    for (uint32_t v = 0; v < cVOXELS_PER_BRICK; ++v)
+    {
+      if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[b], v, voxel_index)
+          && collider.collide(voxelmap[voxel_index], other_map[voxel_index]))
+      {
+        voxelmap[voxel_index].insert(eBVM_COLLISION);
+        num_collisions++;
+      }
+    }
+  }
+  return num_collisions;
+}
+
+//! Brick version of hostCollideVoxelMapsBitvector()
+template<std::size_t length, class OtherVoxel, class Collider>
+uint32_t hostCollideVoxelMapsBitvectorBricks(BitVoxel<length>* voxelmap, const Vector3ui& dimensions,
+                                             const OtherVoxel* other_map, const uint32_t* bricks,
+                                             const uint32_t num_bricks, Collider collider,
+                                             BitVector<length>& colliding_meanings, const uint16_t sv_offset)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+  uint32_t num_collisions = 0;
+
+#pragma omp parallel reduction(+:num_collisions)
+  {
+    BitVector<length> thread_meanings;
+    BitVector<length> temp;
+
+#pragma omp for schedule(dynamic)
+    for (int64_t b = 0; b < int64_t(num_bricks); ++b)
+    {
+      uint32_t voxel_index;
+      for (uint32_t v = 0; v < cVOXELS_PER_BRICK; ++v)
+      {
+        if (getBrickVoxelIndex(dimensions, brick_dimensions, bricks[b], v, voxel_index)
+            && collider.collide(voxelmap[voxel_index], other_map[voxel_index], &temp, sv_offset))
+        {
+          voxelmap[voxel_index].insert(eBVM_COLLISION);
+          thread_meanings |= temp;
+          num_collisions++;
+        }
+      }
+    }
+
+#pragma omp critical
+    colliding_meanings |= thread_meanings;
+  }
+  return num_collisions;
+}
+
+/*! Host version of kernelCollideVoxelMapWithMaps().
+ *  Every robot voxel is loaded once and checked against all \a targets. The results are
+ *  accumulated per target in \a num_collisions and \a colliding_meanings, which have to
+ *  hold targets.num_maps entries.
+ *  Collision info is stored as eBVM_COLLISION in \a voxelmap.
+ */
+template<std::size_t length, class Collider>
+void hostCollideVoxelMapWithMaps(BitVoxel<length>* voxelmap, const Vector3ui& dimensions,
+                                 const uint32_t num_voxels, const uint32_t* bricks,
+                                 const CollisionQueryTargets<length>& targets, Collider collider,
+                                 uint32_t* num_collisions, BitVector<length>* colliding_meanings)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+
+#pragma omp parallel
+  {
+    // every thread accumulates its own results, they get merged at the end
+    uint32_t thread_num_collisions[cMAX_COLLISION_QUERY_MAPS] = { 0 };
+    BitVector<length> thread_meanings[cMAX_COLLISION_QUERY_MAPS];
+
+#pragma omp for schedule(static)
+    for (int64_t i = 0; i < int64_t(num_voxels); ++i)
+    {
+      uint32_t voxel_index = uint32_t(i);
+      if (bricks != NULL
+          && !getBrickVoxelIndex(dimensions, brick_dimensions, bricks[i / cVOXELS_PER_BRICK], i % cVOXELS_PER_BRICK, voxel_index))
+      {
+        continue;
+      }
+      BitVoxel<length>& voxel = voxelmap[voxel_index];
+      if (!voxel.bitVector().isZero()
+          && collideWithTargets(voxel, voxel_index, targets, collider, thread_num_collisions, thread_meanings))
+      {
+        voxel.insert(eBVM_COLLISION);
+      }
+    }
+
+#pragma omp critical
+    for (uint32_t m = 0; m < targets.num_maps; ++m)
+    {
+      num_collisions[m] += thread_num_collisions[m];
+      colliding_meanings[m] |= thread_meanings[m];
+    }
+  }
+}
+
+//! Inserts a single voxel. Overloaded for DistanceVoxels which also store their coordinates.
+template<class Voxel>
+inline void hostInsertVoxel(Voxel* voxelmap, const Vector3ui& dimensions, const Vector3ui& coords,
+                            const BitVoxelMeaning voxel_meaning)
+{
+  voxelmap[getVoxelIndexUnsigned(dimensions, coords)].insert(voxel_meaning);
+}
+
+inline void hostInsertVoxel(DistanceVoxel* voxelmap, const Vector3ui& dimensions, const Vector3ui& coords,
+                            const BitVoxelMeaning voxel_meaning)
+{
+  voxelmap[getVoxelIndexUnsigned(dimensions, coords)].insert(coords, voxel_meaning);
+}
+
+/*! Host version of kernelInsertGlobalPointCloud().
+ *  \a points has to reside in host memory.
+ *  Returns true if points were outside of the map and could not be inserted.
+ */
+template<class Voxel>
+bool hostInsertPointCloud(Voxel* voxelmap, const Vector3ui& dimensions, const float voxel_side_length,
+                          const Vector3f* points, const std::size_t num_points, const BitVoxelMeaning voxel_meaning)
+{
+  bool points_outside_map = false;
+
+#pragma omp parallel for schedule(static) reduction(||:points_outside_map)
+  for (int64_t i = 0; i < int64_t(num_points); ++i)
+  {
+    const Vector3ui uint_coords = mapToVoxels(voxel_side_length, points[i]);
+    //check if point is in the range of the voxel map
+    if ((uint_coords.x < dimensions.x) && (uint_coords.y < dimensions.y)
+        && (uint_coords.z < dimensions.z))
+    {
+      hostInsertVoxel(voxelmap, dimensions, uint_coords, voxel_meaning);
+    }
+    else
+    {
+      points_outside_map = true;
+    }
+  }
+  return points_outside_map;
+}
+
+/*! Host version of kernelInsertMetaPointCloud().
+ *  Uses the host side copies of the clouds, so the MetaPointCloud has to be
+ *  synced to the host after transforming it on the device.
+ *  The clouds are processed one after another, so that all threads insert
+ *  the same meaning at a time.
+ *  Returns true if points were outside of the map and could not be inserted.
+ */
+template<class Voxel>
+bool hostInsertMetaPointCloud(Voxel* voxelmap, const Vector3ui& dimensions, const float voxel_side_length,
+                              const MetaPointCloud& meta_point_cloud, const BitVoxelMeaning* voxel_meanings,
+                              const bool per_cloud_meanings)
+{
+  bool points_outside_map = false;
+  for (uint16_t cloud = 0; cloud < meta_point_cloud.getNumberOfPointclouds(); ++cloud)
+  {
+    const BitVoxelMeaning meaning = per_cloud_meanings ? voxel_meanings[cloud] : voxel_meanings[0];
+    points_outside_map |= hostInsertPointCloud(voxelmap, dimensions, voxel_side_length,
+                                               meta_point_cloud.getPointCloud(cloud),
+                                               meta_point_cloud.getPointcloudSize(cloud), meaning);
+  }
+  return points_outside_map;
+}
+
+//! Host version of kernelUpdateOccupancy()
+template<class Voxel>
+void hostUpdateOccupancy(Voxel* voxelmap, const uint32_t* voxel_indices, const std::size_t num_voxels,
+                         const Probability occupancy)
+{
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(num_voxels); ++i)
+  {
+    voxelmap[voxel_indices[i]].updateOccupancy(occupancy);
+  }
+}
+
+/*! Host version of kernelMarkBricks().
+ *  \a points has to reside in host memory.
+ */
+inline void hostMarkBricks(const Vector3ui& dimensions, const float voxel_side_length,
+                           const Vector3f* points, const std::size_t num_points, uint8_t* brick_occupancy)
+{
+  const Vector3ui brick_dimensions = getBrickDimensions(dimensions);
+#pragma omp parallel for schedule(static)
+  for (int64_t i = 0; i < int64_t(num_points); ++i)
+  {
+    const Vector3ui uint_coords = mapToVoxels(voxel_side_length, points[i]);
+    if ((uint_coords.x < dimensions.x) && (uint_coords.y < dimensions.y) && (uint_coords.z < dimensions.z))
+    {
+      // points of the same brick set the same flag
+#pragma omp atomic write
+      brick_occupancy[getBrickIndex(brick_dimensions, uint_coords)] = 1;
+    }
+  }
+}
+
+//! Host version of kernelMarkBricks() for the host side copies of a MetaPointCloud
+inline void hostMarkBricks(const Vector3ui& dimensions, const float voxel_side_length,
+                           const MetaPointCloud& meta_point_cloud, uint8_t* brick_occupancy)
+{
+  for (uint16_t cloud = 0; cloud < meta_point_cloud.getNumberOfPointclouds(); ++cloud)
+  {
+    hostMarkBricks(dimensions, voxel_side_length, meta_point_cloud.getPointCloud(cloud),
+                   meta_point_cloud.getPointcloudSize(cloud), brick_occupancy);
+  }
+}
+
+//! Returns true if \a obstacle holds valid coordinates
+inline bool hostIsValidObstacle(const Vector3ui& obstacle)
+{
+  return obstacle.x != uint32_t(PBA_UNINITIALISED_COORD) && obstacle.y != uint32_t(PBA_UNINITIALISED_COORD)
+      && obstacle.z != uint32_t(PBA_UNINITIALISED_COORD);
+}
+
+//! Returns true if the voxel at \a obstacle is still an obstacle, which references itself
+inline bool hostIsObstacle(const DistanceVoxel* voxels, const Vector3ui& dimensions, const Vector3ui& obstacle)
+{
+  const Vector3ui stored = voxels[getVoxelIndexUnsigned(dimensions, obstacle)].getObstacle();
+  return stored.x == obstacle.x && stored.y == obstacle.y && stored.z == obstacle.z;
+}
+
+//! Squared distance between two voxels
+inline int32_t hostSquaredDistance(const Vector3ui& a, const Vector3ui& b)
+{
+  const int32_t dx = int32_t(a.x) - int32_t(b.x);
+  const int32_t dy = int32_t(a.y) - int32_t(b.y);
+  const int32_t dz = int32_t(a.z) - int32_t(b.z);
+  return dx * dx + dy * dy + dz * dz;
+}
+
+/*!
+ * \brief hostUpdateDistances Repairs a complete distance field after obstacles were
+ * added and removed. Removed obstacles raise a wavefront that clears all voxels
+ * referencing them, the borders of the cleared region and the new obstacles lower
+ * the distances again (dynamic brushfire, see Lau et al., "Efficient grid-based
+ * spatial representations for robot navigation in dynamic environments", 2013).
+ * Only the voxels whose closest obstacle changes are visited.
+ *
+ * \param raise_flags One flag per voxel, all flags are zero before and after the call
+ * \param changed_voxels Receives the indices of all modified voxels, which may repeat
+ */
+inline void hostUpdateDistances(DistanceVoxel* voxels, uint8_t* raise_flags, const Vector3ui& dimensions,
+                                const std::vector<Vector3ui>& new_obstacles,
+                                const std::vector<Vector3ui>& removed_obstacles,
+                                std::vector<uint32_t>& changed_voxels)
+{
+  typedef std::pair<int32_t, uint32_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > open;
+  DistanceVoxel uninitialised;
+  uninitialised.setPBAUninitialised();
+
+  for (std::size_t i = 0; i < removed_obstacles.size(); ++i)
+  {
+    const Vector3ui& coords = removed_obstacles[i];
+    if (coords.x < dimensions.x && coords.y < dimensions.y && coords.z < dimensions.z
+        && hostIsObstacle(voxels, dimensions, coords))
+    {
+      const uint32_t index = getVoxelIndexUnsigned(dimensions, coords);
+      voxels[index] = uninitialised;
+      raise_flags[index] = 1;
+      open.push(QueueEntry(0, index));
+      changed_voxels.push_back(index);
+    }
+  }
+  for (std::size_t i = 0; i < new_obstacles.size(); ++i)
+  {
+    const Vector3ui& coords = new_obstacles[i];
+    if (coords.x < dimensions.x && coords.y < dimensions.y && coords.z < dimensions.z)
+    {
+      const uint32_t index = getVoxelIndexUnsigned(dimensions, coords);
+      voxels[index] = DistanceVoxel(coords);
+      raise_flags[index] = 0;
+      open.push(QueueEntry(0, index));
+      changed_voxels.push_back(index);
+    }
+  }
+
+  while (!open.empty())
+  {
+    const uint32_t index = open.top().second;
+    open.pop();
+    const Vector3ui coords = linearIndexToCoordinatesUnsigned(index, dimensions);
+    const Vector3ui obstacle = voxels[index].getObstacle();
+    const bool raise = raise_flags[index] != 0;
+    if (!raise && !(hostIsValidObstacle(obstacle) && hostIsObstacle(voxels, dimensions, obstacle)))
+    {
+      continue;
+    }
+
+    for (int32_t dz = -1; dz <= 1; ++dz)
+    {
+      for (int32_t dy = -1; dy <= 1; ++dy)
+      {
+        for (int32_t dx = -1; dx <= 1; ++dx)
+        {
+          const Vector3ui neighbor(coords.x + dx, coords.y + dy, coords.z + dz);
+          if ((dx == 0 && dy == 0 && dz == 0) || neighbor.x >= dimensions.x || neighbor.y >= dimensions.y
+              || neighbor.z >= dimensions.z)
+          {
+            continue;
+          }
+          const uint32_t neighbor_index = getVoxelIndexUnsigned(dimensions, neighbor);
+          if (raise_flags[neighbor_index])
+          {
+            continue;
+          }
+          DistanceVoxel& neighbor_voxel = voxels[neighbor_index];
+          const Vector3ui neighbor_obstacle = neighbor_voxel.getObstacle();
+          const bool neighbor_valid = hostIsValidObstacle(neighbor_obstacle)
+              && hostIsObstacle(voxels, dimensions, neighbor_obstacle);
+
+          if (raise)
+          {
+            // clear voxels that reference removed obstacles, the others lower the cleared region again
+            if (hostIsValidObstacle(neighbor_obstacle))
+            {
+              open.push(QueueEntry(hostSquaredDistance(neighbor, neighbor_obstacle), neighbor_index));
+              if (!neighbor_valid)
+              {
+                neighbor_voxel = uninitialised;
+                raise_flags[neighbor_index] = 1;
+                changed_voxels.push_back(neighbor_index);
+              }
+            }
+          }
+          else
+          {
+            const int32_t distance = hostSquaredDistance(neighbor, obstacle);
+            const int32_t old_distance = neighbor_valid ? hostSquaredDistance(neighbor, neighbor_obstacle)
+                                                        : MAX_OBSTACLE_DISTANCE;
+            if (distance < old_distance)
+            {
+              neighbor_voxel.setObstacle(obstacle);
+              open.push(QueueEntry(distance, neighbor_index));
+              changed_voxels.push_back(neighbor_index);
+            }
+          }
+        }
+      }
+    }
+    raise_flags[index] = 0;
+  }
+}
+
+} // end of namespace voxelmap
+} // end of namespace gpu_voxels
+
+#endif
@@ -0,0 +1,373 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * \brief   Contains icl_core::logging::AsyncLogging
+ *
+ */
+//----------------------------------------------------------------------
+#include "icl_core_logging/AsyncLogging.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <boost/thread/once.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <icl_core/internal_raw_debug.h>
+#include <icl_core/os.h>
+#include "icl_core_logging/LogOutputStream.h"
+#include "icl_core_logging/LogStream.h"
+#include "icl_core_logging/Thread.h"
+
+namespace icl_core {
+namespace logging {
+
+namespace {
+
+//! Time the worker thread sleeps when all queues are empty.
+const unsigned long cASYNC_LOG_IDLE_SLEEP_US = 1000;
+
+boost::once_flag instance_once_flag = BOOST_ONCE_INIT;
+
+//! The queue of the current thread.
+boost::thread_specific_ptr<AsyncLogQueue> thread_queue(&AsyncLogging::releaseThreadQueue);
+
+//! Returns \c true if \a c ends a printf conversion specification.
+bool isConversion(char c)
+{
+  return std::strchr("diouxXeEfFgGaAcsp", c) != NULL;
+}
+
+//! Returns \c true if \a c is a printf length modifier.
+bool isLengthModifier(char c)
+{
+  return std::strchr("hlLqjzt", c) != NULL;
+}
+
+}
+
+AsyncLogging *AsyncLogging::m_instance = NULL;
+
+
+size_t AsyncLogRecord::addString(const char *text, size_t length)
+{
+  const size_t offset = std::min(strings_size, size_t(cASYNC_LOG_STRING_BUFFER_SIZE - 1));
+  length = std::min(length, cASYNC_LOG_STRING_BUFFER_SIZE - 1 - offset);
+  std::memcpy(&strings[offset], text, length);
+  strings[offset + length] = '\0';
+  strings_size = offset + length + 1;
+  return offset;
+}
+
+void AsyncLogRecord::setArgument(AsyncLogArgument& argument, const char *value)
+{
+  argument.type = eAAT_STRING;
+  argument.string_offset = addString(value, std::strlen(value));
+}
+
+void AsyncLogRecord::setArgument(AsyncLogArgument& argument, const std::string& value)
+{
+  argument.type = eAAT_STRING;
+  argument.string_offset = addString(value.c_str(), value.size());
+}
+
+size_t AsyncLogRecord::formatText(char *buffer, size_t buffer_size) const
+{
+  size_t length = 0;
+  size_t next_argument = 0;
+  const char *fmt = format;
+  while (*fmt != '\0' && length + 1 < buffer_size)
+  {
+    if (*fmt != '%')
+    {
+      buffer[length++] = *fmt++;
+      continue;
+    }
+    if (fmt[1] == '%')
+    {
+      buffer[length++] = '%';
+      fmt += 2;
+      continue;
+    }
+
+    // Collect flags, width and precision, drop the length modifiers.
+    char spec[32];
+    size_t spec_length = 0;
+    const char *spec_begin = fmt;
+    spec[spec_length++] = *fmt++;
+    while (*fmt != '\0' && !isConversion(*fmt) && spec_length < sizeof(spec) - 4)
+    {
+      if (!isLengthModifier(*fmt))
+      {
+        spec[spec_length++] = *fmt;
+      }
+      ++fmt;
+    }
+    const char conversion = *fmt;
+    if (!isConversion(conversion) || next_argument >= number_of_arguments)
+    {
+      // Invalid specification or missing argument: copy it verbatim.
+      const size_t verbatim = std::min(size_t(fmt - spec_begin) + (conversion != '\0' ? 1 : 0),
+                                       buffer_size - 1 - length);
+      std::memcpy(&buffer[length], spec_begin, verbatim);
+      length += verbatim;
+      if (conversion != '\0')
+      {
+        ++fmt;
+      }
+      continue;
+    }
+    ++fmt;
+
+    // Adapt the conversion to the type of the stored argument.
+    const AsyncLogArgument& argument = arguments[next_argument++];
+    int printed = 0;
+    char *out = &buffer[length];
+    const size_t out_size = buffer_size - length;
+    if (argument.type == eAAT_STRING)
+    {
+      spec[spec_length++] = 's';
+      spec[spec_length] = '\0';
+      printed = snprintf(out, out_size, spec, &strings[argument.string_offset]);
+    }
+    else if (argument.type == eAAT_POINTER || conversion == 'p')
+    {
+      spec[spec_length++] = 'p';
+      spec[spec_length] = '\0';
+      printed = snprintf(out, out_size, spec, argument.pointer_value);
+    }
+    else if (std::strchr("eEfFgGaA", conversion) != NULL || argument.type == eAAT_DOUBLE)
+    {
+      const double value = argument.type == eAAT_DOUBLE ? argument.double_value
+        : argument.type == eAAT_INT ? double(argument.int_value) : double(argument.uint_value);
+      spec[spec_length++] = std::strchr("eEfFgGaA", conversion) != NULL ? conversion : 'f';
+      spec[spec_length] = '\0';
+      printed = snprintf(out, out_size, spec, value);
+    }
+    else if (conversion == 'c')
+    {
+      spec[spec_length++] = 'c';
+      spec[spec_length] = '\0';
+      printed = snprintf(out, out_size, spec, int(argument.int_value));
+    }
+    else
+    {
+      // Signed and unsigned arguments share the same bits.  Other
+      // conversions, like %s for a number, print the argument as it
+      // is stored.
+      char int_conversion = conversion;
+      if (conversion == 'i')
+      {
+        int_conversion = 'd';
+      }
+      else if (std::strchr("douxX", conversion) == NULL)
+      {
+        int_conversion = argument.type == eAAT_INT ? 'd' : 'u';
+      }
+      spec[spec_length++] = 'l';
+      spec[spec_length++] = 'l';
+      spec[spec_length++] = int_conversion;
+      spec[spec_length] = '\0';
+      if (int_conversion == 'd')
+      {
+        printed = snprintf(out, out_size, spec, static_cast<long long>(argument.int_value));
+      }
+      else
+      {
+        printed = snprintf(out, out_size, spec, static_cast<unsigned long long>(argument.uint_value));
+      }
+    }
+    if (printed > 0)
+    {
+      length += std::min(size_t(printed), out_size - 1);
+    }
+  }
+  buffer[length] = '\0';
+  return length;
+}
+
+
+AsyncLogQueue::AsyncLogQueue()
+  : m_head(0),
+    m_tail(0),
+    m_abandoned(false)
+{
+}
+
+void AsyncLogQueue::waitWhileFull(size_t head)
+{
+  while (head - m_tail.load(boost::memory_order_acquire) >= cDEFAULT_ASYNC_LOG_QUEUE_SIZE)
+  {
+    boost::this_thread::yield();
+  }
+}
+
+
+class AsyncLogging::WorkerThread : public Thread
+{
+public:
+  WorkerThread(AsyncLogging *async_logging)
+    : m_async_logging(async_logging)
+  { }
+
+  virtual void run()
+  {
+    while (execute())
+    {
+      if (m_async_logging->processQueues() == 0)
+      {
+        icl_core::os::usleep(cASYNC_LOG_IDLE_SLEEP_US);
+      }
+    }
+    m_async_logging->processQueues();
+  }
+
+private:
+  AsyncLogging *m_async_logging;
+};
+
+
+AsyncLogging::AsyncLogging()
+  : m_running(false),
+    m_worker_thread(NULL)
+{
+}
+
+void AsyncLogging::createInstance()
+{
+  m_instance = new AsyncLogging();
+}
+
+AsyncLogging& AsyncLogging::instance()
+{
+  boost::call_once(instance_once_flag, &AsyncLogging::createInstance);
+  return *m_instance;
+}
+
+void AsyncLogging::start()
+{
+  if (m_worker_thread == NULL)
+  {
+    m_worker_thread = new WorkerThread(this);
+    m_running.store(true, boost::memory_order_release);
+    if (!m_worker_thread->start())
+    {
+      PRINTF("AsyncLogging::start: could not start the worker thread\n");
+      m_running.store(false, boost::memory_order_release);
+      delete m_worker_thread;
+      m_worker_thread = NULL;
+    }
+  }
+}
+
+void AsyncLogging::stop()
+{
+  if (m_worker_thread != NULL)
+  {
+    m_running.store(false, boost::memory_order_release);
+    m_worker_thread->stop();
+    m_worker_thread->join();
+    delete m_worker_thread;
+    m_worker_thread = NULL;
+  }
+}
+
+void AsyncLogging::flush()
+{
+  processQueues();
+}
+
+AsyncLogQueue& AsyncLogging::threadQueue()
+{
+  AsyncLogQueue *queue = thread_queue.get();
+  if (queue == NULL)
+  {
+    queue = new AsyncLogQueue();
+    thread_queue.reset(queue);
+    boost::mutex::scoped_lock lock(m_queues_mutex);
+    m_queues.push_back(queue);
+  }
+  return *queue;
+}
+
+void AsyncLogging::releaseThreadQueue(AsyncLogQueue *queue)
+{
+  // The queue is deleted by the worker thread after it has been emptied.
+  queue->m_abandoned.store(true, boost::memory_order_release);
+}
+
+void AsyncLogging::write(const AsyncLogRecord& record)
+{
+  char text[cDEFAULT_LOG_SIZE + 1];
+  record.formatText(text, cDEFAULT_LOG_SIZE + 1);
+
+  LogStream *stream = record.stream;
+  if (stream->m_mutex.wait())
+  {
+    for (std::set<LogOutputStream*>::const_iterator iter = stream->m_output_stream_list.begin();
+         iter != stream->m_output_stream_list.end();
+         ++iter)
+    {
+      (*iter)->push(record.timestamp, record.log_level, stream->nameCStr(), record.filename,
+                    int(record.line), record.classname, record.objectname(), record.function, text);
+    }
+    stream->m_mutex.post();
+  }
+  else
+  {
+    PRINTF("AsyncLogging(%s)::write: mutex lock failed\n", stream->nameCStr());
+  }
+}
+
+size_t AsyncLogging::processQueues()
+{
+  boost::mutex::scoped_lock process_lock(m_process_mutex);
+  boost::mutex::scoped_lock queues_lock(m_queues_mutex);
+
+  size_t records_written = 0;
+  std::vector<AsyncLogQueue*>::iterator it = m_queues.begin();
+  while (it != m_queues.end())
+  {
+    AsyncLogQueue *queue = *it;
+    // Read the flag first, so that no record can follow after the queue is empty.
+    const bool abandoned = queue->m_abandoned.load(boost::memory_order_acquire);
+    size_t tail = queue->m_tail.load(boost::memory_order_relaxed);
+    const size_t head = queue->m_head.load(boost::memory_order_acquire);
+    while (tail != head)
+    {
+      write(queue->m_records[tail & (cDEFAULT_ASYNC_LOG_QUEUE_SIZE - 1)]);
+      ++tail;
+      queue->m_tail.store(tail, boost::memory_order_release);
+      ++records_written;
+    }
+
+    if (abandoned && queue->empty())
+    {
+      delete queue;
+      it = m_queues.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  return records_written;
+}
+
+}
+}
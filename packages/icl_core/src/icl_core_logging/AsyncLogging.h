@@ -0,0 +1,421 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * \brief   Contains icl_core::logging::AsyncLogging
+ *
+ * \b icl_core::logging::AsyncLogging
+ *
+ * Asynchronous logging for hot code paths.  Instead of formatting the
+ * message text in the calling thread, the LOGGING_ASYNC_* macros only
+ * store the printf-style format string and the raw argument values in
+ * a fixed size binary record.  The records are written into a
+ * lock-free single producer / single consumer queue, which exists once
+ * per thread.  A worker thread collects the records, formats them and
+ * hands them to the log output streams.
+ *
+ * The format string must be a string literal, because only its address
+ * is stored.  String arguments and the object name are copied.
+ *
+ * Asynchronous logging is enabled with AsyncLogging::start().  As long
+ * as it is not running, the LOGGING_ASYNC_* macros format the message
+ * in the calling thread.
+ */
+//----------------------------------------------------------------------
+#ifndef ICL_CORE_LOGGING_ASYNC_LOGGING_H_INCLUDED
+#define ICL_CORE_LOGGING_ASYNC_LOGGING_H_INCLUDED
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <icl_core/BaseTypes.h>
+#include <icl_core/Noncopyable.h>
+#include <icl_core/TimeStamp.h>
+#include "icl_core_logging/Constants.h"
+#include "icl_core_logging/ImportExport.h"
+#include "icl_core_logging/LogLevel.h"
+
+namespace icl_core {
+namespace logging {
+
+class LogStream;
+
+//! Type of an argument of an asynchronous log record.
+enum AsyncLogArgumentType
+{
+  eAAT_INT,
+  eAAT_UINT,
+  eAAT_DOUBLE,
+  eAAT_STRING,
+  eAAT_POINTER
+};
+
+//! A single argument of an asynchronous log record.
+struct AsyncLogArgument
+{
+  AsyncLogArgumentType type;
+  union
+  {
+    int64_t int_value;
+    uint64_t uint_value;
+    double double_value;
+    //! Offset of the string in AsyncLogRecord::strings.
+    size_t string_offset;
+    const void *pointer_value;
+  };
+};
+
+/*! A log message, which has not been formatted yet.  The records are
+ *  stored by value in the per-thread queues, so their size is fixed.
+ */
+struct AsyncLogRecord
+{
+  icl_core::TimeStamp timestamp;
+  LogStream *stream;
+  icl_core::logging::LogLevel log_level;
+  const char *filename;
+  size_t line;
+  const char *classname;
+  const char *function;
+  const char *format;
+  size_t objectname_offset;
+  size_t number_of_arguments;
+  AsyncLogArgument arguments[cMAX_ASYNC_LOG_ARGUMENTS];
+  size_t strings_size;
+  char strings[cASYNC_LOG_STRING_BUFFER_SIZE];
+
+  //! Copies \a text into the string buffer and returns its offset.
+  size_t addString(const char *text, size_t length);
+
+  void setArgument(AsyncLogArgument& argument, char value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, signed char value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, short value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, int value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, long value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, long long value) { setInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, unsigned char value) { setUInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, unsigned short value) { setUInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, unsigned int value) { setUInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, unsigned long value) { setUInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, unsigned long long value) { setUInt(argument, value); }
+  void setArgument(AsyncLogArgument& argument, bool value) { setInt(argument, value ? 1 : 0); }
+  void setArgument(AsyncLogArgument& argument, float value) { setDouble(argument, value); }
+  void setArgument(AsyncLogArgument& argument, double value) { setDouble(argument, value); }
+  void setArgument(AsyncLogArgument& argument, const char *value);
+  void setArgument(AsyncLogArgument& argument, char *value) { setArgument(argument, const_cast<const char *>(value)); }
+  void setArgument(AsyncLogArgument& argument, const std::string& value);
+  template <typename T>
+  void setArgument(AsyncLogArgument& argument, T *value)
+  {
+    argument.type = eAAT_POINTER;
+    argument.pointer_value = value;
+  }
+
+  /*! Formats the record into \a buffer, which has room for \a
+   *  buffer_size characters including the terminating zero.
+   *  Conversion specifications are adapted to the stored argument
+   *  types, so length modifiers in the format string are ignored.
+   *  \returns the length of the formatted text.
+   */
+  size_t formatText(char *buffer, size_t buffer_size) const;
+
+  //! Returns the object name of the log message.
+  const char *objectname() const { return &strings[objectname_offset]; }
+
+private:
+  void setInt(AsyncLogArgument& argument, int64_t value)
+  {
+    argument.type = eAAT_INT;
+    argument.int_value = value;
+  }
+  void setUInt(AsyncLogArgument& argument, uint64_t value)
+  {
+    argument.type = eAAT_UINT;
+    argument.uint_value = value;
+  }
+  void setDouble(AsyncLogArgument& argument, double value)
+  {
+    argument.type = eAAT_DOUBLE;
+    argument.double_value = value;
+  }
+};
+
+/*! Lock-free queue of log records, which is written by exactly one
+ *  producer thread and read by the worker thread of AsyncLogging.
+ */
+class ICL_CORE_LOGGING_IMPORT_EXPORT AsyncLogQueue : private icl_core::Noncopyable
+{
+public:
+  AsyncLogQueue();
+
+  /*! Returns the next free record.  Waits while the queue is full.
+   *  The record is passed to the worker thread by commit().
+   */
+  AsyncLogRecord& reserve()
+  {
+    const size_t head = m_head.load(boost::memory_order_relaxed);
+    if (head - m_tail.load(boost::memory_order_acquire) >= cDEFAULT_ASYNC_LOG_QUEUE_SIZE)
+    {
+      waitWhileFull(head);
+    }
+    return m_records[head & (cDEFAULT_ASYNC_LOG_QUEUE_SIZE - 1)];
+  }
+
+  //! Passes the record returned by reserve() to the worker thread.
+  void commit()
+  {
+    m_head.store(m_head.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+  }
+
+  //! Returns \c true if the worker thread has processed all records.
+  bool empty() const
+  {
+    return m_tail.load(boost::memory_order_acquire) == m_head.load(boost::memory_order_acquire);
+  }
+
+private:
+  friend class AsyncLogging;
+
+  void waitWhileFull(size_t head);
+
+  AsyncLogRecord m_records[cDEFAULT_ASYNC_LOG_QUEUE_SIZE];
+  //! Written by the producer thread only.
+  boost::atomic<size_t> m_head;
+  //! Keeps head and tail on different cache lines.
+  char m_padding[64];
+  //! Written by the worker thread only.
+  boost::atomic<size_t> m_tail;
+  //! Set when the producer thread has terminated.
+  boost::atomic<bool> m_abandoned;
+};
+
+/*! Collects the asynchronous log records of all threads and formats
+ *  them in a worker thread.
+ */
+class ICL_CORE_LOGGING_IMPORT_EXPORT AsyncLogging : private icl_core::Noncopyable
+{
+public:
+  //! Returns the singleton instance.
+  static AsyncLogging& instance();
+
+  /*! Starts the worker thread.  From now on the LOGGING_ASYNC_* macros
+   *  pass their records to the worker thread.
+   */
+  void start();
+
+  /*! Stops the worker thread after it has written out all queued
+   *  records.  Must not be called while other threads are still using
+   *  the LOGGING_ASYNC_* macros.
+   */
+  void stop();
+
+  //! Returns \c true if the worker thread is running.
+  bool isRunning() const { return m_running.load(boost::memory_order_acquire); }
+
+  //! Waits until all records, which have been queued so far, are written out.
+  void flush();
+
+  /*! Returns the queue of the calling thread.  The queue is created on
+   *  first use.
+   */
+  AsyncLogQueue& threadQueue();
+
+  /*! Formats \a record and passes it to the log output streams of its
+   *  log stream.
+   */
+  static void write(const AsyncLogRecord& record);
+
+  //! Called when a producer thread terminates.
+  static void releaseThreadQueue(AsyncLogQueue *queue);
+
+private:
+  class WorkerThread;
+
+  AsyncLogging();
+
+  /*! Writes out the queued records of all threads and deletes the
+   *  queues of terminated threads.
+   *  \returns the number of records written.
+   */
+  size_t processQueues();
+
+  static void createInstance();
+
+  static AsyncLogging *m_instance;
+
+  boost::atomic<bool> m_running;
+  WorkerThread *m_worker_thread;
+  //! Protects m_queues.
+  boost::mutex m_queues_mutex;
+  std::vector<AsyncLogQueue*> m_queues;
+  //! Serializes processQueues() between the worker thread and flush().
+  boost::mutex m_process_mutex;
+};
+
+/*! Fills an asynchronous log record.  Used by the LOGGING_ASYNC_*
+ *  macros.  If asynchronous logging is running the record is written
+ *  directly into the queue of the calling thread, otherwise it is
+ *  formatted immediately.
+ */
+class AsyncLogWriter
+{
+public:
+  AsyncLogWriter(LogStream& stream, icl_core::logging::LogLevel log_level,
+                 const char *filename, size_t line, const char *classname,
+                 const char *objectname, const char *function)
+    : m_queue(AsyncLogging::instance().isRunning() ? &AsyncLogging::instance().threadQueue() : NULL),
+      m_record(m_queue != NULL ? m_queue->reserve() : m_local_record)
+  {
+    m_record.timestamp = icl_core::TimeStamp::now();
+    m_record.stream = &stream;
+    m_record.log_level = log_level;
+    m_record.filename = filename;
+    m_record.line = line;
+    m_record.classname = classname;
+    m_record.function = function;
+    m_record.strings_size = 0;
+    m_record.objectname_offset = m_record.addString(objectname, std::strlen(objectname));
+  }
+
+  void format(const char *format)
+  {
+    begin(format, 0);
+    commit();
+  }
+  template <typename T1>
+  void format(const char *format, const T1& a1)
+  {
+    begin(format, 1);
+    m_record.setArgument(m_record.arguments[0], a1);
+    commit();
+  }
+  template <typename T1, typename T2>
+  void format(const char *format, const T1& a1, const T2& a2)
+  {
+    begin(format, 2);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3)
+  {
+    begin(format, 3);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3, typename T4>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3, const T4& a4)
+  {
+    begin(format, 4);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    m_record.setArgument(m_record.arguments[3], a4);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3, typename T4, typename T5>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3, const T4& a4,
+              const T5& a5)
+  {
+    begin(format, 5);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    m_record.setArgument(m_record.arguments[3], a4);
+    m_record.setArgument(m_record.arguments[4], a5);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3, const T4& a4,
+              const T5& a5, const T6& a6)
+  {
+    begin(format, 6);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    m_record.setArgument(m_record.arguments[3], a4);
+    m_record.setArgument(m_record.arguments[4], a5);
+    m_record.setArgument(m_record.arguments[5], a6);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6,
+            typename T7>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3, const T4& a4,
+              const T5& a5, const T6& a6, const T7& a7)
+  {
+    begin(format, 7);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    m_record.setArgument(m_record.arguments[3], a4);
+    m_record.setArgument(m_record.arguments[4], a5);
+    m_record.setArgument(m_record.arguments[5], a6);
+    m_record.setArgument(m_record.arguments[6], a7);
+    commit();
+  }
+  template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6,
+            typename T7, typename T8>
+  void format(const char *format, const T1& a1, const T2& a2, const T3& a3, const T4& a4,
+              const T5& a5, const T6& a6, const T7& a7, const T8& a8)
+  {
+    begin(format, 8);
+    m_record.setArgument(m_record.arguments[0], a1);
+    m_record.setArgument(m_record.arguments[1], a2);
+    m_record.setArgument(m_record.arguments[2], a3);
+    m_record.setArgument(m_record.arguments[3], a4);
+    m_record.setArgument(m_record.arguments[4], a5);
+    m_record.setArgument(m_record.arguments[5], a6);
+    m_record.setArgument(m_record.arguments[6], a7);
+    m_record.setArgument(m_record.arguments[7], a8);
+    commit();
+  }
+
+private:
+  void begin(const char *format, size_t number_of_arguments)
+  {
+    m_record.format = format;
+    m_record.number_of_arguments = number_of_arguments;
+  }
+
+  void commit()
+  {
+    if (m_queue != NULL)
+    {
+      m_queue->commit();
+    }
+    else
+    {
+      AsyncLogging::write(m_record);
+    }
+  }
+
+  AsyncLogQueue *m_queue;
+  //! Only used while asynchronous logging is not running.
+  AsyncLogRecord m_local_record;
+  AsyncLogRecord& m_record;
+};
+
+}
+}
+
+#endif
@@ -66,6 +66,24 @@ const size_t cMAX_DESCRIPTION_LENGTH = 1024;
  */
 #define cDEFAULT_LOG_THREAD_STREAM_POOL_SIZE 32
 
+/*!
+ * The number of log records in the per-thread queue of the
+ * asynchronous logging.  Must be a power of two.
+ */
+#define cDEFAULT_ASYNC_LOG_QUEUE_SIZE 1024
+
+/*!
+ * The maximum number of arguments of an asynchronous log message.
+ * Surplus arguments are ignored.
+ */
+#define cMAX_ASYNC_LOG_ARGUMENTS 8
+
+/*!
+ * The buffer size for string arguments and the object name of an
+ * asynchronous log message.  Surplus characters will be truncated.
+ */
+#define cASYNC_LOG_STRING_BUFFER_SIZE 128
+
 }
 }
 
@@ -131,10 +131,19 @@ void LogOutputStream::push(icl_core::logging::LogLevel log_level,
                            const char* log_stream_description, const char *filename,
                            int line, const char *classname, const char *objectname,
                            const char *function, const char *text)
+{
+  push(icl_core::TimeStamp::now(), log_level, log_stream_description, filename, line,
+       classname, objectname, function, text);
+}
+
+void LogOutputStream::push(const icl_core::TimeStamp& timestamp, icl_core::logging::LogLevel log_level,
+                           const char* log_stream_description, const char *filename,
+                           int line, const char *classname, const char *objectname,
+                           const char *function, const char *text)
 {
   if (log_level >= getLogLevel())
   {
-    LogMessage new_entry(icl_core::TimeStamp::now(), log_level, log_stream_description,
+    LogMessage new_entry(timestamp, log_level, log_stream_description,
                          filename, line, classname, objectname, function, text);
 
     if (m_use_worker_thread)
@@ -150,6 +150,15 @@ public:
             const char *filename, int line, const char *classname, const char *objectname,
             const char *function, const char *text);
 
+  /*! Same as the push() above, but uses the given \a timestamp
+   *  instead of the current time.  Used for log messages which have
+   *  been formatted asynchronously, see AsyncLogging.
+   */
+  void push(const icl_core::TimeStamp& timestamp, icl_core::logging::LogLevel log_level,
+            const char *log_stream_description, const char *filename, int line,
+            const char *classname, const char *objectname, const char *function,
+            const char *text);
+
   //! Starts the worker thread of the log output stream.
   void start();
 
@@ -56,6 +56,7 @@ class ICL_CORE_LOGGING_IMPORT_EXPORT LogStream : private icl_core::Noncopyable
 {
   friend class LoggingManager;
   friend class ThreadStream;
+  friend class AsyncLogging;
 
 public:
   /*! Creates a new logstream which is not yet connected to any log
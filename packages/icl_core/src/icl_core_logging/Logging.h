@@ -44,6 +44,7 @@
 // -- END Deprecated compatibility headers --
 
 #include "icl_core_logging/LoggingMacros_LOGGING.h"
+#include "icl_core_logging/LoggingMacros_LOGGING_ASYNC.h"
 #include "icl_core_logging/LoggingMacros_LOGGING_FMT.h"
 #include "icl_core_logging/LoggingMacros_LLOGGING.h"
 #include "icl_core_logging/LoggingMacros_LLOGGING_FMT.h"
@@ -0,0 +1,80 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * \brief   Defines asynchronous logging macros.
+ *
+ * These logging macros take the name of a log stream, a printf-style
+ * format string literal and up to eight arguments.  The message is
+ * formatted by the worker thread of AsyncLogging, see AsyncLogging.h.
+ */
+//----------------------------------------------------------------------
+#ifndef ICL_CORE_LOGGING_LOGGING_MACROS__LOGGING__ASYNC_H_INCLUDED
+#define ICL_CORE_LOGGING_LOGGING_MACROS__LOGGING__ASYNC_H_INCLUDED
+
+#include "icl_core_logging/AsyncLogging.h"
+
+#define LOGGING_ASYNC_LOG_FLCO(streamname, level, filename, line, classname, objectname, ...) \
+  do {                                                                  \
+    ::icl_core::logging::LogStream& stream = streamname::instance();    \
+    if (stream.isActive() && stream.getLogLevel() <= level)             \
+    {                                                                   \
+      ::icl_core::logging::AsyncLogWriter(stream, level, filename, line, classname, \
+                                          objectname, __FUNCTION__).format(__VA_ARGS__); \
+    }                                                                   \
+  } while (0)
+#define LOGGING_ASYNC_LOG_CO(streamname, level, classname, objectname, ...) LOGGING_ASYNC_LOG_FLCO(streamname, level, __FILE__, __LINE__, #classname, objectname, __VA_ARGS__)
+#define LOGGING_ASYNC_LOG_C(streamname, level, classname, ...) LOGGING_ASYNC_LOG_FLCO(streamname, level, __FILE__, __LINE__, #classname, "", __VA_ARGS__)
+#define LOGGING_ASYNC_LOG(streamname, level, ...) LOGGING_ASYNC_LOG_FLCO(streamname, level, __FILE__, __LINE__, "", "", __VA_ARGS__)
+
+
+#define LOGGING_ASYNC_ERROR(streamname, ...) LOGGING_ASYNC_LOG(streamname, ::icl_core::logging::eLL_ERROR, __VA_ARGS__)
+#define LOGGING_ASYNC_WARNING(streamname, ...) LOGGING_ASYNC_LOG(streamname, ::icl_core::logging::eLL_WARNING, __VA_ARGS__)
+#define LOGGING_ASYNC_INFO(streamname, ...) LOGGING_ASYNC_LOG(streamname, ::icl_core::logging::eLL_INFO, __VA_ARGS__)
+#ifdef _IC_DEBUG_
+# define LOGGING_ASYNC_DEBUG(streamname, ...) LOGGING_ASYNC_LOG(streamname, ::icl_core::logging::eLL_DEBUG, __VA_ARGS__)
+# define LOGGING_ASYNC_TRACE(streamname, ...) LOGGING_ASYNC_LOG(streamname, ::icl_core::logging::eLL_TRACE, __VA_ARGS__)
+#else
+# define LOGGING_ASYNC_DEBUG(streamname, ...) (void)0
+# define LOGGING_ASYNC_TRACE(streamname, ...) (void)0
+#endif
+
+
+#define LOGGING_ASYNC_ERROR_C(streamname, classname, ...) LOGGING_ASYNC_LOG_C(streamname, ::icl_core::logging::eLL_ERROR, classname, __VA_ARGS__)
+#define LOGGING_ASYNC_WARNING_C(streamname, classname, ...) LOGGING_ASYNC_LOG_C(streamname, ::icl_core::logging::eLL_WARNING, classname, __VA_ARGS__)
+#define LOGGING_ASYNC_INFO_C(streamname, classname, ...) LOGGING_ASYNC_LOG_C(streamname, ::icl_core::logging::eLL_INFO,  classname, __VA_ARGS__)
+#ifdef _IC_DEBUG_
+# define LOGGING_ASYNC_DEBUG_C(streamname, classname, ...) LOGGING_ASYNC_LOG_C(streamname, ::icl_core::logging::eLL_DEBUG, classname, __VA_ARGS__)
+# define LOGGING_ASYNC_TRACE_C(streamname, classname, ...) LOGGING_ASYNC_LOG_C(streamname, ::icl_core::logging::eLL_TRACE, classname, __VA_ARGS__)
+#else
+# define LOGGING_ASYNC_DEBUG_C(streamname, classname, ...) (void)0
+# define LOGGING_ASYNC_TRACE_C(streamname, classname, ...) (void)0
+#endif
+
+
+#define LOGGING_ASYNC_ERROR_CO(streamname, classname, objectname, ...) LOGGING_ASYNC_LOG_CO(streamname, ::icl_core::logging::eLL_ERROR, classname, objectname, __VA_ARGS__)
+#define LOGGING_ASYNC_WARNING_CO(streamname, classname, objectname, ...) LOGGING_ASYNC_LOG_CO(streamname, ::icl_core::logging::eLL_WARNING, classname, objectname, __VA_ARGS__)
+#define LOGGING_ASYNC_INFO_CO(streamname, classname, objectname, ...) LOGGING_ASYNC_LOG_CO(streamname, ::icl_core::logging::eLL_INFO, classname, objectname, __VA_ARGS__)
+#ifdef _IC_DEBUG_
+# define LOGGING_ASYNC_DEBUG_CO(streamname, classname, objectname, ...) LOGGING_ASYNC_LOG_CO(streamname, ::icl_core::logging::eLL_DEBUG, classname, objectname, __VA_ARGS__)
+# define LOGGING_ASYNC_TRACE_CO(streamname, classname, objectname, ...) LOGGING_ASYNC_LOG_CO(streamname, ::icl_core::logging::eLL_TRACE, classname, objectname, __VA_ARGS__)
+#else
+# define LOGGING_ASYNC_DEBUG_CO(streamname, classname, objectname, ...) (void)0
+# define LOGGING_ASYNC_TRACE_CO(streamname, classname, objectname, ...) (void)0
+#endif
+
+#endif
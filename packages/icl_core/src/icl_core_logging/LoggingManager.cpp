@@ -19,6 +19,7 @@
 
 #include <icl_core/os_lxrt.h>
 #include <icl_core_config/Config.h>
+#include "icl_core_logging/AsyncLogging.h"
 #include "icl_core_logging/FileLogOutput.h"
 #include "icl_core_logging/LogStream.h"
 #include "icl_core_logging/StdLogOutput.h"
@@ -409,6 +410,10 @@ void LoggingManager::shutdown()
   m_initialized = false;
   m_shutdown_running = true;
 
+  // Write out the pending asynchronous log messages while the log
+  // output streams still exist.
+  AsyncLogging::instance().stop();
+
   // If the default log output stream exists then remove it from all connected
   // log streams and delete it afterwards.
   if (m_default_log_output != 0)
@@ -26,7 +26,12 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <cmath>
 #include <sstream>
+#include <iomanip>
+
+#include <boost/thread/once.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <icl_core/TimeSpan.h>
 
@@ -35,18 +40,190 @@ using namespace std;
 namespace icl_core {
 namespace perf_mon{
 
-string makeName(string prefix, string name)
+//! Number of values the ring buffer of a thread can hold before it has to be merged
+static const uint64_t cRING_BUFFER_SIZE = 1 << 14;
+
+//! Number of bins of the histograms in the summaries
+static const size_t cHISTOGRAM_BINS = 10;
+
+//! A single measurement
+struct Sample
+{
+  EventHandle event;
+  double value;
+  //! start time of a time measurement in ns, 0 for other values
+  uint64_t start_ns;
+};
+
+/*! Thread local state of the performance monitor. The ring buffer has a
+ *  single producer, the owning thread, and a single consumer at a time,
+ *  which holds the mutex of the monitor.
+ */
+struct ThreadBuffer
+{
+  ThreadBuffer()
+    : ring(cRING_BUFFER_SIZE),
+      head(0),
+      tail(0),
+      generation(0),
+      id(0)
+  { }
+
+  std::vector<Sample> ring;
+  //! next write position, only written by the owning thread
+  boost::atomic<uint64_t> head;
+  //! next read position, only written by the consumer
+  boost::atomic<uint64_t> tail;
+
+  //! start times of the timers of this thread, indexed by timer handle
+  std::vector<TimeStamp> timers;
+
+  //! handles of the names this thread has already used
+  std::map<std::string, TimerHandle> timer_cache;
+  std::map<std::string, EventHandle> event_cache;
+  std::map<std::string, EventHandle> nontime_event_cache;
+
+  //! copy of the enabled flags of the event prefixes and the generation they belong to
+  std::vector<char> event_enabled;
+  uint32_t generation;
+
+  //! number of the thread in traces
+  uint32_t id;
+};
+
+//! The buffers of the threads, which are merged and deleted when a thread exits
+static boost::thread_specific_ptr<ThreadBuffer> thread_buffer(&PerformanceMonitor::releaseThreadBuffer);
+
+string makeName(const string& prefix, const string& name)
 {
   return prefix + "::" + name;
 }
 
+//! Statistics of the values of an event
+struct Statistics
+{
+  size_t count;
+  double avg;
+  double median;
+  double min;
+  double max;
+  double p90;
+  double p99;
+  vector<size_t> histogram;
+};
+
+//! Returns the nearest rank percentile \a p of the sorted values
+static double percentile(const vector<double>& sorted, double p)
+{
+  size_t rank = size_t(ceil(p * sorted.size()));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+//! Calculates the statistics of at least one value
+static Statistics calculateStatistics(const vector<double>& values)
+{
+  vector<double> sorted = values;
+  sort(sorted.begin(), sorted.end());
+  Statistics stats;
+  stats.count = sorted.size();
+  stats.avg = 0;
+  for (size_t i = 0; i < sorted.size(); ++i)
+  {
+    stats.avg += sorted[i];
+  }
+  stats.avg = stats.avg / sorted.size();
+  stats.median = sorted[sorted.size() / 2];
+  stats.min = sorted.front();
+  stats.max = sorted.back();
+  stats.p90 = percentile(sorted, 0.9);
+  stats.p99 = percentile(sorted, 0.99);
+
+  stats.histogram.resize(cHISTOGRAM_BINS, 0);
+  // non-finite values can't be binned, they are counted in the first bin
+  const double range = stats.max - stats.min;
+  for (size_t i = 0; i < sorted.size(); ++i)
+  {
+    const double position = (sorted[i] - stats.min) / range * cHISTOGRAM_BINS;
+    size_t bin = range > 0 && std::isfinite(position) ? size_t(position) : 0;
+    stats.histogram[std::min(bin, cHISTOGRAM_BINS - 1)]++;
+  }
+  return stats;
+}
+
+//! Writes \a str as JSON string
+static void writeJsonString(ostream& os, const string& str)
+{
+  os << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    const unsigned char c = str[i];
+    if (c == '"' || c == '\\')
+    {
+      os << '\\' << c;
+    }
+    else if (c < 0x20)
+    {
+      os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+    }
+    else
+    {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+//! Writes \a value as JSON number, JSON has no representation of NaN and infinity
+static void writeJsonNumber(ostream& os, const double value)
+{
+  if (std::isfinite(value))
+  {
+    os << value;
+  }
+  else
+  {
+    os << "null";
+  }
+}
+
+//! Writes \a str as CSV field
+static void writeCsvField(ostream& os, const string& str)
+{
+  if (str.find_first_of(",\"\n") == string::npos)
+  {
+    os << str;
+    return;
+  }
+  os << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"')
+    {
+      os << '"';
+    }
+    os << str[i];
+  }
+  os << '"';
+}
+
+//! Returns the time stamp in ns
+static uint64_t toNSec(const TimeStamp& t)
+{
+  return t.tsSec() * 1000000000ull + t.tsNSec();
+}
+
 PerformanceMonitor* PerformanceMonitor::m_instance = NULL;
 
 PerformanceMonitor::PerformanceMonitor()
+  : m_generation(1)
 {
   m_enabled = true;
   m_print_stop = true;
   m_all_enabled = false;
+  m_num_events = 0;
+  m_next_thread_id = 0;
+  m_trace_start_ns = 0;
+  m_trace_first_event = true;
 }
 
 PerformanceMonitor::~PerformanceMonitor()
@@ -54,65 +231,251 @@ PerformanceMonitor::~PerformanceMonitor()
 
 }
 
+static boost::once_flag instance_flag = BOOST_ONCE_INIT;
+
+void PerformanceMonitor::createInstance()
+{
+  m_instance = new PerformanceMonitor();
+}
+
 PerformanceMonitor* PerformanceMonitor::getInstance()
 {
-  if (m_instance == NULL)
-  {
-    m_instance = new PerformanceMonitor();
-  }
+  boost::call_once(&PerformanceMonitor::createInstance, instance_flag);
   return m_instance;
 }
 
 void PerformanceMonitor::initialize(const uint32_t num_names, const uint32_t num_events)
 {
   PerformanceMonitor* monitor = getInstance();
-  monitor->m_data.clear();
-  monitor->m_data_nontime.clear();
-  monitor->m_buffer.resize(num_names);
-  for (uint32_t i = 0; i < num_names; ++i)
-    monitor->m_buffer[i].reserve(num_events);
+  {
+    boost::mutex::scoped_lock lock(monitor->m_mutex);
+    // discard the values that have not been merged yet, the handles stay valid
+    monitor->mergeAllLocked();
+    for (size_t i = 0; i < monitor->m_data.size(); ++i)
+    {
+      monitor->m_data[i].clear();
+      monitor->m_data[i].reserve(num_events);
+    }
+    monitor->m_num_events = num_events;
+    monitor->m_events.reserve(num_names);
+    monitor->m_data.reserve(num_names);
+  }
 
   monitor->enablePrefix("");
 }
 
+ThreadBuffer* PerformanceMonitor::getThreadBuffer()
+{
+  ThreadBuffer* buffer = thread_buffer.get();
+  if (buffer == NULL)
+  {
+    buffer = new ThreadBuffer();
+    thread_buffer.reset(buffer);
+    boost::mutex::scoped_lock lock(m_mutex);
+    buffer->id = m_next_thread_id++;
+    m_thread_buffers.push_back(buffer);
+  }
+  return buffer;
+}
 
-bool PerformanceMonitor::isEnabled(string prefix)
+void PerformanceMonitor::releaseThreadBuffer(ThreadBuffer* buffer)
+{
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  monitor->mergeLocked(buffer);
+  monitor->m_thread_buffers.erase(std::remove(monitor->m_thread_buffers.begin(), monitor->m_thread_buffers.end(), buffer),
+                                  monitor->m_thread_buffers.end());
+  delete buffer;
+}
+
+TimerHandle PerformanceMonitor::registerTimerLocked(const string& timer_name)
+{
+  map<string, TimerHandle>::iterator it = m_timer_handles.find(timer_name);
+  if (it != m_timer_handles.end())
+  {
+    return it->second;
+  }
+  TimerHandle handle = TimerHandle(m_timer_handles.size());
+  m_timer_handles[timer_name] = handle;
+  return handle;
+}
+
+EventHandle PerformanceMonitor::registerEventLocked(const string& prefix, const string& name, const bool time_data)
+{
+  map<string, EventHandle>& handles = time_data ? m_event_handles : m_nontime_event_handles;
+  string tmp = makeName(prefix, name);
+  map<string, EventHandle>::iterator it = handles.find(tmp);
+  if (it != handles.end())
+  {
+    return it->second;
+  }
+  EventHandle handle = EventHandle(m_events.size());
+  EventInfo info;
+  info.prefix = prefix;
+  info.name = name;
+  info.time_data = time_data;
+  m_events.push_back(info);
+  m_data.push_back(vector<double>());
+  m_data.back().reserve(m_num_events);
+  m_event_enabled.push_back(m_enabled_prefix.find(prefix) != m_enabled_prefix.end());
+  handles[tmp] = handle;
+  m_generation++;
+  return handle;
+}
+
+TimerHandle PerformanceMonitor::registerTimer(const string& timer_name)
+{
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  return monitor->registerTimerLocked(timer_name);
+}
+
+EventHandle PerformanceMonitor::registerEvent(const string& description, const string& prefix, const bool time_data)
+{
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  return monitor->registerEventLocked(prefix, description, time_data);
+}
+
+TimerHandle PerformanceMonitor::lookupTimer(ThreadBuffer* buffer, const string& timer_name)
+{
+  map<string, TimerHandle>::iterator it = buffer->timer_cache.find(timer_name);
+  if (it != buffer->timer_cache.end())
+  {
+    return it->second;
+  }
+  TimerHandle handle = registerTimer(timer_name);
+  buffer->timer_cache[timer_name] = handle;
+  return handle;
+}
+
+EventHandle PerformanceMonitor::lookupEvent(ThreadBuffer* buffer, const string& prefix, const string& name,
+                                            const bool time_data)
+{
+  map<string, EventHandle>& cache = time_data ? buffer->event_cache : buffer->nontime_event_cache;
+  string tmp = makeName(prefix, name);
+  map<string, EventHandle>::iterator it = cache.find(tmp);
+  if (it != cache.end())
+  {
+    return it->second;
+  }
+  EventHandle handle = registerEvent(name, prefix, time_data);
+  cache[tmp] = handle;
+  return handle;
+}
+
+bool PerformanceMonitor::isEnabledLocked(const string& prefix)
 {
   return (m_enabled && m_enabled_prefix.find(prefix) != m_enabled_prefix.end()) || m_all_enabled;
 }
 
-void PerformanceMonitor::start(string timer_name)
+void PerformanceMonitor::updateEnabledLocked()
 {
-  if (getInstance()->m_enabled)
+  for (size_t i = 0; i < m_events.size(); ++i)
   {
-    TimeStamp t = TimeStamp::now();
-    getInstance()->m_timer[timer_name] = t;
+    m_event_enabled[i] = m_enabled_prefix.find(m_events[i].prefix) != m_enabled_prefix.end();
   }
+  m_generation++;
 }
 
-double PerformanceMonitor::measurement(string timer_name, string description, string prefix,
-                               icl_core::logging::LogLevel level)
+bool PerformanceMonitor::isEnabled(ThreadBuffer* buffer, const EventHandle event)
+{
+  // refresh the copy of the flags only if a prefix or event has changed
+  const uint32_t generation = m_generation.load(boost::memory_order_acquire);
+  if (buffer->generation != generation)
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    buffer->event_enabled = m_event_enabled;
+    buffer->generation = m_generation.load(boost::memory_order_relaxed);
+  }
+  return (m_enabled && event < buffer->event_enabled.size() && buffer->event_enabled[event]) || m_all_enabled;
+}
+
+void PerformanceMonitor::start(const string& timer_name)
+{
+  PerformanceMonitor* monitor = getInstance();
+  if (monitor->m_enabled)
+  {
+    ThreadBuffer* buffer = monitor->getThreadBuffer();
+    start(monitor->lookupTimer(buffer, timer_name));
+  }
+}
+
+void PerformanceMonitor::start(const TimerHandle timer)
 {
   PerformanceMonitor* monitor = getInstance();
-  if (monitor->isEnabled(prefix))
+  if (monitor->m_enabled)
+  {
+    ThreadBuffer* buffer = monitor->getThreadBuffer();
+    if (timer >= buffer->timers.size())
+    {
+      buffer->timers.resize(timer + 1);
+    }
+    buffer->timers[timer] = TimeStamp::now();
+  }
+}
+
+double PerformanceMonitor::measure(const TimerHandle timer, const EventHandle event, logging::LogLevel level,
+                                   const bool silent, const bool reset)
+{
+  ThreadBuffer* buffer = getThreadBuffer();
+  if (!isEnabled(buffer, event))
+  {
+    return 0;
+  }
+  if (timer >= buffer->timers.size())
+  {
+    buffer->timers.resize(timer + 1);
+  }
+  TimeStamp& start = buffer->timers[timer];
+  if (start == TimeStamp())
+  {
+    // the timer isn't started yet
+    if (reset)
+    {
+      start = TimeStamp::now();
+      return 0;
+    }
+  }
+
+  TimeStamp end = TimeStamp::now();
+  TimeSpan d(end - start);
+  double double_ms = d.toNSec() / 1000000.0;
+  addEvent(buffer, event, double_ms, toNSec(start));
+  if (reset)
   {
-    TimeStamp end = TimeStamp::now();
-    TimeSpan d(end - monitor->m_timer[timer_name]);
-    double double_ms = d.toNSec() / 1000000.0;
-    monitor->addEvent(prefix, description, double_ms);
+    start = end;
+  }
 
-    if (getInstance()->m_print_stop)
+  if (!silent && m_print_stop)
+  {
+    std::stringstream ss;
     {
-      std::stringstream ss;
-      ss << makeName(prefix, description) << ": " << double_ms << " ms";
-      monitor->print(ss.str(), level);
+      boost::mutex::scoped_lock lock(m_mutex);
+      ss << makeName(m_events[event].prefix, m_events[event].name);
     }
-    return double_ms;
+    ss << ": " << double_ms << " ms";
+    print(ss.str(), level);
   }
-  return 0;
+  return double_ms;
+}
+
+double PerformanceMonitor::measurement(const string& timer_name, const string& description, const string& prefix,
+                               icl_core::logging::LogLevel level)
+{
+  PerformanceMonitor* monitor = getInstance();
+  ThreadBuffer* buffer = monitor->getThreadBuffer();
+  return monitor->measure(monitor->lookupTimer(buffer, timer_name), monitor->lookupEvent(buffer, prefix, description, true),
+                          level, false, false);
+}
+
+double PerformanceMonitor::measurement(const TimerHandle timer, const EventHandle event,
+                                       logging::LogLevel level, const bool silent)
+{
+  return getInstance()->measure(timer, event, level, silent, false);
 }
 
-double PerformanceMonitor::startStop(string timer_name, string description, string prefix,
+double PerformanceMonitor::startStop(const string& timer_name, const string& description, const string& prefix,
                                      logging::LogLevel level, const bool silent)
 {
   /*
@@ -122,97 +485,103 @@ double PerformanceMonitor::startStop(string timer_name, string description, stri
    * else
    *   start timer
    */
+  PerformanceMonitor* monitor = getInstance();
+  ThreadBuffer* buffer = monitor->getThreadBuffer();
+  return monitor->measure(monitor->lookupTimer(buffer, timer_name), monitor->lookupEvent(buffer, prefix, description, true),
+                          level, silent, true);
+}
 
-  if (getInstance()->isEnabled(prefix))
+double PerformanceMonitor::startStop(const TimerHandle timer, const EventHandle event,
+                                     logging::LogLevel level, const bool silent)
+{
+  return getInstance()->measure(timer, event, level, silent, true);
+}
+
+void PerformanceMonitor::addStaticData(const string& name, double data, const string& prefix)
+{
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  if (monitor->isEnabledLocked(prefix))
   {
-    PerformanceMonitor* monitor = getInstance();
-    TimeStamp start = monitor->m_timer[timer_name];
-    if (start != TimeStamp())
-    {
-      TimeStamp end = TimeStamp::now();
-      TimeSpan d(end - start);
-      double double_ms = d.toNSec() / 1000000.0;
-      monitor->addEvent(prefix, description, double_ms);
-      monitor->m_timer[timer_name] = end;
-      if (!silent && getInstance()->m_print_stop)
-      {
-        std::stringstream ss;
-        ss << makeName(prefix, description) << ": " << double_ms << " ms";
-        monitor->print(ss.str(), level);
-      }
-      return double_ms;
-    }
-    else
-    {
-      PerformanceMonitor::start(timer_name);
-    }
+    string tmp = makeName(prefix, name);
+    monitor->m_static_data[tmp] = data;
   }
-  return 0;
 }
 
-void PerformanceMonitor::addStaticData(string name, double data, string prefix)
+void PerformanceMonitor::addData(const string& name, double data, const string& prefix)
 {
-  if (getInstance()->isEnabled(prefix))
+  PerformanceMonitor* monitor = getInstance();
+  ThreadBuffer* buffer = monitor->getThreadBuffer();
+  EventHandle event = monitor->lookupEvent(buffer, prefix, name, true);
+  if (monitor->isEnabled(buffer, event))
   {
-    string tmp = makeName(prefix, name);
-    getInstance()->m_static_data[tmp] = data;
+    monitor->addEvent(buffer, event, data);
   }
 }
 
-void PerformanceMonitor::addData(string name, double data, string prefix)
+void PerformanceMonitor::addNonTimeData(const string& name, double data, const string& prefix)
 {
-  if (getInstance()->isEnabled(prefix))
+  PerformanceMonitor* monitor = getInstance();
+  ThreadBuffer* buffer = monitor->getThreadBuffer();
+  EventHandle event = monitor->lookupEvent(buffer, prefix, name, false);
+  if (monitor->isEnabled(buffer, event))
   {
-    getInstance()->addEvent(prefix, name, data);
+    monitor->addEvent(buffer, event, data);
   }
 }
 
-void PerformanceMonitor::addNonTimeData(string name, double data, string prefix)
+void PerformanceMonitor::addData(const EventHandle event, double data)
 {
-  if (getInstance()->isEnabled(prefix))
+  PerformanceMonitor* monitor = getInstance();
+  ThreadBuffer* buffer = monitor->getThreadBuffer();
+  if (monitor->isEnabled(buffer, event))
   {
-    getInstance()->addNonTimeEvent(prefix, name, data);
+    monitor->addEvent(buffer, event, data);
   }
 }
 
-void PerformanceMonitor::addEvent(string prefix, string name, double data)
+void PerformanceMonitor::addEvent(ThreadBuffer* buffer, const EventHandle event, double data, const uint64_t start_ns)
 {
-  if (getInstance()->isEnabled(prefix))
+  const uint64_t head = buffer->head.load(boost::memory_order_relaxed);
+  if (head - buffer->tail.load(boost::memory_order_acquire) == cRING_BUFFER_SIZE)
   {
-    string tmp = makeName(prefix, name);
-    if (m_data.find(tmp) == m_data.end())
-    {
-      m_data[tmp] = vector<double>();
-      if (m_buffer.size() > 0)
-      {
-        m_data[tmp].swap(m_buffer.back());
-        m_buffer.pop_back();
-      }
-    }
-    m_data[tmp].push_back(data);
+    // the ring is full, merge it ourselves
+    boost::mutex::scoped_lock lock(m_mutex);
+    mergeLocked(buffer);
   }
+  Sample& sample = buffer->ring[head & (cRING_BUFFER_SIZE - 1)];
+  sample.event = event;
+  sample.value = data;
+  sample.start_ns = start_ns;
+  buffer->head.store(head + 1, boost::memory_order_release);
 }
 
-void PerformanceMonitor::addNonTimeEvent(string prefix, string name, double data)
+void PerformanceMonitor::mergeLocked(ThreadBuffer* buffer)
 {
-  if (getInstance()->isEnabled(prefix))
+  uint64_t tail = buffer->tail.load(boost::memory_order_relaxed);
+  const uint64_t head = buffer->head.load(boost::memory_order_acquire);
+  if (m_trace.is_open())
   {
-    string tmp = makeName(prefix, name);
-    if (m_data_nontime.find(tmp) == m_data_nontime.end())
-    {
-      m_data_nontime[tmp] = vector<double>();
-      if (m_buffer.size() > 0)
-      {
-        m_data_nontime[tmp].swap(m_buffer.back());
-        m_buffer.pop_back();
-      }
-    }
-    m_data_nontime[tmp].push_back(data);
+    writeTraceLocked(buffer, tail, head);
+  }
+  for (; tail != head; ++tail)
+  {
+    const Sample& sample = buffer->ring[tail & (cRING_BUFFER_SIZE - 1)];
+    m_data[sample.event].push_back(sample.value);
+  }
+  buffer->tail.store(head, boost::memory_order_release);
+}
+
+void PerformanceMonitor::mergeAllLocked()
+{
+  for (size_t i = 0; i < m_thread_buffers.size(); ++i)
+  {
+    mergeLocked(m_thread_buffers[i]);
   }
 }
 
 
-void PerformanceMonitor::print(string message, logging::LogLevel level)
+void PerformanceMonitor::print(const string& message, logging::LogLevel level)
 {
   switch (level)
   {
@@ -239,69 +608,90 @@ void PerformanceMonitor::print(string message, logging::LogLevel level)
   }
 }
 
-void PerformanceMonitor::createStatisticSummary(stringstream& ss, string prefix, string name)
+void PerformanceMonitor::createStatisticSummary(stringstream& ss, const string& prefix, const string& name,
+                                                const bool time_data)
 {
+  // m_mutex is locked by the callers
   string tmp = makeName(prefix, name);
-  double median, min, max;
-  getMedian(tmp, median, min, max);
-
-  ss << "Summary for " << tmp << "\n" <<
-        "Called " << m_data[tmp].size() << " times\n" <<
-        name << "_avg: " << getAverage(tmp) << " ms\n" <<
-        name << "_median: " << median << " ms\n" <<
-        name << "_min: " << min << " ms\n" <<
-        name << "_max: " << max << " ms\n"<<
-        "\n";
-}
+  map<string, EventHandle>& handles = time_data ? m_event_handles : m_nontime_event_handles;
+  map<string, EventHandle>::iterator it = handles.find(tmp);
+  if (it == handles.end() || m_data[it->second].empty())
+  {
+    ss << "Summary for " << tmp << "\n" << "No data\n\n";
+    return;
+  }
 
-void PerformanceMonitor::createStatisticSummaryNonTime(stringstream& ss, string prefix, string name)
-{
-  string tmp = makeName(prefix, name);
-  double median, min, max;
-  getMedianNonTime(tmp, median, min, max);
-
-  ss << "Summary for " << tmp << "\n" <<
-        "num entries: " << m_data_nontime[tmp].size() << "\n" <<
-        name << "_avg: " << getAverageNonTime(tmp) << "\n" <<
-        name << "_median: " << median << "\n" <<
-        name << "_min: " << min << "\n" <<
-        name << "_max: " << max << "\n"<<
+  const Statistics stats = calculateStatistics(m_data[it->second]);
+
+  const char* unit = time_data ? " ms\n" : "\n";
+  ss << "Summary for " << tmp << "\n";
+  if (time_data)
+  {
+    ss << "Called " << stats.count << " times\n";
+  }
+  else
+  {
+    ss << "num entries: " << stats.count << "\n";
+  }
+  ss << name << "_avg: " << stats.avg << unit <<
+        name << "_median: " << stats.median << unit <<
+        name << "_min: " << stats.min << unit <<
+        name << "_max: " << stats.max << unit <<
+        name << "_p90: " << stats.p90 << unit <<
+        name << "_p99: " << stats.p99 << unit <<
+        name << "_histogram:";
+  for (size_t i = 0; i < cHISTOGRAM_BINS; ++i)
+  {
+    ss << " " << stats.histogram[i];
+  }
+  ss << " (" << cHISTOGRAM_BINS << " bins from min to max)\n" <<
         "\n";
 }
 
-string PerformanceMonitor::printSummary(string prefix, string name,
+string PerformanceMonitor::printSummary(const string& prefix, const string& name,
                                       icl_core::logging::LogLevel level)
 {
   PerformanceMonitor* monitor = getInstance();
 
   std::stringstream ss;
-  monitor->createStatisticSummary(ss, prefix, name);
+  {
+    boost::mutex::scoped_lock lock(monitor->m_mutex);
+    monitor->mergeAllLocked();
+    monitor->createStatisticSummary(ss, prefix, name, true);
+  }
   monitor->print(ss.str(), level);
   return ss.str();
 }
 
-void PerformanceMonitor::enablePrefix(string prefix)
+void PerformanceMonitor::enablePrefix(const string& prefix)
 {
   PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
 
   if (monitor->m_enabled_prefix.find(prefix) == monitor->m_enabled_prefix.end())
   {
     monitor->m_enabled_prefix[prefix] = true;
+    monitor->updateEnabledLocked();
   }
 }
 
 void PerformanceMonitor::enableAll(const bool& enabled)
 {
-  getInstance()->m_all_enabled = enabled;
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  monitor->m_all_enabled = enabled;
+  monitor->updateEnabledLocked();
 }
 
-void PerformanceMonitor::disablePrefix(string prefix)
+void PerformanceMonitor::disablePrefix(const string& prefix)
 {
   PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
 
   if (monitor->m_enabled_prefix.find(prefix) != monitor->m_enabled_prefix.end())
   {
     monitor->m_enabled_prefix.erase(prefix);
+    monitor->updateEnabledLocked();
   }
 }
 
@@ -309,20 +699,32 @@ string PerformanceMonitor::printSummaryAll(icl_core::logging::LogLevel level)
 {
   PerformanceMonitor* monitor = getInstance();
 
+  vector<string> prefixes;
+  {
+    boost::mutex::scoped_lock lock(monitor->m_mutex);
+    for (map<string, bool>::iterator it=monitor->m_enabled_prefix.begin();
+         it != monitor->m_enabled_prefix.end(); ++it)
+    {
+      prefixes.push_back(it->first);
+    }
+  }
+
   std::stringstream ss;
-  for (map<string, bool>::iterator it=monitor->m_enabled_prefix.begin();
-       it != monitor->m_enabled_prefix.end(); ++it)
+  for (size_t i = 0; i < prefixes.size(); ++i)
   {
-    ss << printSummaryFromPrefix(it->first, level);
+    ss << printSummaryFromPrefix(prefixes[i], level);
   }
   return ss.str();
 }
 
-string PerformanceMonitor::printSummaryFromPrefix(string prefix, icl_core::logging::LogLevel level)
+string PerformanceMonitor::printSummaryFromPrefix(const string& prefix, icl_core::logging::LogLevel level)
 {
   PerformanceMonitor* monitor = getInstance();
   bool first = true;
   std::stringstream ss;
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  monitor->mergeAllLocked();
+
   ss << "\n########## Begin of Summary for prefix " << prefix << " ##########\n";
   for (map<string, double>::iterator it = monitor->m_static_data.begin(); it != monitor->m_static_data.end(); it++)
   {
@@ -340,98 +742,236 @@ string PerformanceMonitor::printSummaryFromPrefix(string prefix, icl_core::loggi
     }
   }
 
-  first = true;
-  for (map<string, vector<double> >::iterator it = monitor->m_data.begin(); it != monitor->m_data.end(); it++)
+  for (int time_data = 1; time_data >= 0; --time_data)
+  {
+    first = true;
+    map<string, EventHandle>& handles = time_data ? monitor->m_event_handles : monitor->m_nontime_event_handles;
+    for (map<string, EventHandle>::iterator it = handles.begin(); it != handles.end(); it++)
+    {
+      const EventInfo& info = monitor->m_events[it->second];
+      if (prefix == info.prefix && !monitor->m_data[it->second].empty())
+      {
+        if (first)
+        {
+          ss << (time_data ? "#### Time data: ####\n" : "#### Non-time data: ####\n");
+          first = false;
+        }
+        monitor->createStatisticSummary(ss, prefix, info.name, time_data);
+      }
+    }
+  }
+  lock.unlock();
+
+  monitor->print(ss.str(), level);
+  return ss.str();
+}
+
+bool PerformanceMonitor::exportJson(const string& filename, const bool append)
+{
+  PerformanceMonitor* monitor = getInstance();
+  ofstream file(filename.c_str(), append ? ios::app : ios::trunc);
+  if (!file.is_open())
+  {
+    LOGGING_ERROR(Performance, "Could not open " << filename << " for the JSON export" << endl);
+    return false;
+  }
+  // enough digits to read back the same doubles
+  file.precision(17);
+
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  monitor->mergeAllLocked();
+
+  file << "{\"static\":[";
+  bool first = true;
+  for (map<string, double>::iterator it = monitor->m_static_data.begin(); it != monitor->m_static_data.end(); it++)
   {
     size_t prefix_end = it->first.find("::");
-    std::string prefix_tmp = it->first.substr(0, prefix_end);
+    file << (first ? "" : ",") << "{\"prefix\":";
+    writeJsonString(file, it->first.substr(0, prefix_end));
+    file << ",\"name\":";
+    writeJsonString(file, it->first.substr(prefix_end+2));
+    file << ",\"value\":";
+    writeJsonNumber(file, it->second);
+    file << "}";
+    first = false;
+  }
 
-    if (prefix == prefix_tmp)
+  for (int time_data = 1; time_data >= 0; --time_data)
+  {
+    file << (time_data ? "],\"time\":[" : "],\"non_time\":[");
+    first = true;
+    map<string, EventHandle>& handles = time_data ? monitor->m_event_handles : monitor->m_nontime_event_handles;
+    for (map<string, EventHandle>::iterator it = handles.begin(); it != handles.end(); it++)
     {
-      if (first)
+      const EventInfo& info = monitor->m_events[it->second];
+      const vector<double>& values = monitor->m_data[it->second];
+      if (values.empty())
       {
-        ss << "#### Time data: ####\n";
-        first = false;
+        continue;
       }
-      string name = it->first.substr(prefix_end+2);
-      monitor->createStatisticSummary(ss, prefix, name);
+      const Statistics stats = calculateStatistics(values);
+      file << (first ? "" : ",") << "{\"prefix\":";
+      writeJsonString(file, info.prefix);
+      file << ",\"name\":";
+      writeJsonString(file, info.name);
+      if (time_data)
+      {
+        file << ",\"unit\":\"ms\"";
+      }
+      file << ",\"count\":" << stats.count << ",\"avg\":";
+      writeJsonNumber(file, stats.avg);
+      file << ",\"median\":";
+      writeJsonNumber(file, stats.median);
+      file << ",\"min\":";
+      writeJsonNumber(file, stats.min);
+      file << ",\"max\":";
+      writeJsonNumber(file, stats.max);
+      file << ",\"p90\":";
+      writeJsonNumber(file, stats.p90);
+      file << ",\"p99\":";
+      writeJsonNumber(file, stats.p99);
+      file << ",\"histogram\":[";
+      for (size_t i = 0; i < stats.histogram.size(); ++i)
+      {
+        file << (i ? "," : "") << stats.histogram[i];
+      }
+      file << "],\"values\":[";
+      for (size_t i = 0; i < values.size(); ++i)
+      {
+        file << (i ? "," : "");
+        writeJsonNumber(file, values[i]);
+      }
+      file << "]}";
+      first = false;
     }
   }
+  file << "]}\n";
+  return file.good();
+}
+
+bool PerformanceMonitor::exportCsv(const string& filename)
+{
+  PerformanceMonitor* monitor = getInstance();
+  ofstream file(filename.c_str());
+  if (!file.is_open())
+  {
+    LOGGING_ERROR(Performance, "Could not open " << filename << " for the CSV export" << endl);
+    return false;
+  }
+  file.precision(17);
 
-  first = true;
-  for (map<string, vector<double> >::iterator it = monitor->m_data_nontime.begin(); it != monitor->m_data_nontime.end(); it++)
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  monitor->mergeAllLocked();
+
+  file << "type,prefix,name,index,value\n";
+  for (map<string, double>::iterator it = monitor->m_static_data.begin(); it != monitor->m_static_data.end(); it++)
   {
     size_t prefix_end = it->first.find("::");
-    std::string prefix_tmp = it->first.substr(0, prefix_end);
-
-    if (prefix == prefix_tmp)
+    file << "static,";
+    writeCsvField(file, it->first.substr(0, prefix_end));
+    file << ",";
+    writeCsvField(file, it->first.substr(prefix_end+2));
+    file << ",0," << it->second << "\n";
+  }
+  for (int time_data = 1; time_data >= 0; --time_data)
+  {
+    map<string, EventHandle>& handles = time_data ? monitor->m_event_handles : monitor->m_nontime_event_handles;
+    for (map<string, EventHandle>::iterator it = handles.begin(); it != handles.end(); it++)
     {
-      if (first)
+      const EventInfo& info = monitor->m_events[it->second];
+      const vector<double>& values = monitor->m_data[it->second];
+      for (size_t i = 0; i < values.size(); ++i)
       {
-        ss << "#### Non-time data: ####\n";
-        first = false;
+        file << (time_data ? "time," : "non_time,");
+        writeCsvField(file, info.prefix);
+        file << ",";
+        writeCsvField(file, info.name);
+        file << "," << i << "," << values[i] << "\n";
       }
-      string name = it->first.substr(prefix_end+2);
-      monitor->createStatisticSummaryNonTime(ss, prefix, name);
     }
   }
-  monitor->print(ss.str(), level);
-  return ss.str();
+  return file.good();
 }
 
-double PerformanceMonitor::getAverage(string name)
+bool PerformanceMonitor::startTrace(const string& filename)
 {
-  double avg=0;
-  vector<double>* tmp = &m_data[name];
-  int n = (int) m_data[name].size();
-  for (int i = 0; i < n; ++i)
-    avg = avg + tmp->at(i);
-  avg = avg / n;
-  return avg;
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  if (monitor->m_trace.is_open())
+  {
+    LOGGING_WARNING(Performance, "A trace is already written, ignoring " << filename << endl);
+    return false;
+  }
+  // spans that were measured before are not part of the trace
+  monitor->mergeAllLocked();
+  monitor->m_trace.open(filename.c_str());
+  if (!monitor->m_trace.is_open())
+  {
+    LOGGING_ERROR(Performance, "Could not open the trace file " << filename << endl);
+    return false;
+  }
+  monitor->m_trace << std::fixed << std::setprecision(3) << "[";
+  monitor->m_trace_start_ns = toNSec(TimeStamp::now());
+  monitor->m_trace_first_event = true;
+  return true;
 }
 
-double PerformanceMonitor::getAverageNonTime(string name)
+void PerformanceMonitor::stopTrace()
 {
-  double avg=0;
-  vector<double>* tmp = &m_data_nontime[name];
-  int n = (int) m_data_nontime[name].size();
-  for (int i = 0; i < n; ++i)
-    avg = avg + tmp->at(i);
-  avg = avg / n;
-  return avg;
+  PerformanceMonitor* monitor = getInstance();
+  boost::mutex::scoped_lock lock(monitor->m_mutex);
+  if (monitor->m_trace.is_open())
+  {
+    monitor->mergeAllLocked();
+    monitor->m_trace << "\n]\n";
+    monitor->m_trace.close();
+  }
 }
 
-void PerformanceMonitor::getMedian(string name, double& median, double& min, double& max)
+void PerformanceMonitor::writeTraceLocked(ThreadBuffer* buffer, uint64_t tail, const uint64_t head)
 {
-  vector<double> tmp = m_data[name];
-  sort(tmp.begin(), tmp.end());
-  median = tmp[tmp.size() / 2];
-  min = tmp[0];
-  max = tmp[tmp.size() - 1];
+  for (; tail != head; ++tail)
+  {
+    const Sample& sample = buffer->ring[tail & (cRING_BUFFER_SIZE - 1)];
+    if (sample.start_ns < m_trace_start_ns)
+    {
+      // no time measurement or started before the trace
+      continue;
+    }
+    const EventInfo& info = m_events[sample.event];
+    m_trace << (m_trace_first_event ? "\n" : ",\n") << "{\"name\":";
+    writeJsonString(m_trace, info.name);
+    m_trace << ",\"cat\":";
+    writeJsonString(m_trace, info.prefix);
+    // the trace event format uses microseconds
+    m_trace << ",\"ph\":\"X\",\"ts\":" << (sample.start_ns - m_trace_start_ns) / 1000.0
+            << ",\"dur\":" << sample.value * 1000.0 << ",\"pid\":0,\"tid\":" << buffer->id << "}";
+    m_trace_first_event = false;
+  }
 }
 
-void PerformanceMonitor::getMedianNonTime(string name, double& median, double& min, double& max)
+vector<double> PerformanceMonitor::getEventData(const string& prefix, const string& name, const bool time_data)
 {
-  vector<double> tmp = m_data_nontime[name];
-  sort(tmp.begin(), tmp.end());
-  if (tmp.size() > 0)
-  median = tmp[tmp.size() / 2];
-  min = tmp[0];
-  max = tmp[tmp.size() - 1];
+  boost::mutex::scoped_lock lock(m_mutex);
+  mergeAllLocked();
+  map<string, EventHandle>& handles = time_data ? m_event_handles : m_nontime_event_handles;
+  map<string, EventHandle>::iterator it = handles.find(makeName(prefix, name));
+  if (it == handles.end())
+  {
+    return vector<double>();
+  }
+  return m_data[it->second];
 }
 
-vector<double> PerformanceMonitor::getData(string name, string prefix)
+vector<double> PerformanceMonitor::getData(const string& name, const string& prefix)
 {
-  PerformanceMonitor* monitor = getInstance();
-  return monitor->m_data[ makeName(prefix, name) ];
+  return getInstance()->getEventData(prefix, name, true);
 }
 
-vector<double> PerformanceMonitor::getNonTimeData(string name, string prefix)
+vector<double> PerformanceMonitor::getNonTimeData(const string& name, const string& prefix)
 {
-  PerformanceMonitor* monitor = getInstance();
-  return monitor->m_data_nontime[ makeName(prefix, name) ];
+  return getInstance()->getEventData(prefix, name, false);
 }
 
 } // namespace timer
 } // namespace icl_core
-
@@ -30,6 +30,10 @@
 #include <vector>
 #include <map>
 #include <ostream>
+#include <fstream>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "icl_core_performance_monitor/logging_performance_monitor.h"
 #include "icl_core_performance_monitor/PerformanceMonitorMacros.h"
@@ -41,6 +45,12 @@
 namespace icl_core {
 namespace perf_mon{
 
+//! Handle of a registered timer, see PerformanceMonitor::registerTimer()
+typedef uint32_t TimerHandle;
+//! Handle of a registered event, see PerformanceMonitor::registerEvent()
+typedef uint32_t EventHandle;
+
+struct ThreadBuffer;
 
 /**
  * @brief The PerformanceMonitor class provides an easy to use tool for performance
@@ -66,6 +76,13 @@ namespace perf_mon{
  *
  * Static information such as parallel configurations can be passed to the performance
  * monitor as well, which will be printed in the summary, as well.
+ *
+ * The performance monitor may be used from several threads at once. Timers are
+ * thread local, so a timer has to be started and measured in the same thread.
+ * Measurements are written into a lock-free ring buffer of the calling thread and
+ * merged into the event log when a summary or the data is requested. For hot paths,
+ * timers and events can be registered once and then be used through their handles,
+ * which avoids looking up the names on every call.
  */
 class ICL_CORE_PERFORMANCE_MONITOR_EXPORT PerformanceMonitor
 {
@@ -92,7 +109,7 @@ public:
    * @brief start Start a timer with the given identifier
    * @param timer_name The timer's identifier
    */
-  static void start(std::string timer_name);
+  static void start(const std::string& timer_name);
 
   /**
    * @brief measurement Make a measurement from a given timer. The timer will keep running
@@ -103,7 +120,7 @@ public:
    * @param level Optional logging level. Defaults to icl_core::logging::eLL_INFO
    * @return The measurement value in ms
    */
-  static double measurement(std::string timer_name, std::string description, std::string prefix = "",
+  static double measurement(const std::string& timer_name, const std::string& description, const std::string& prefix = "",
                           logging::LogLevel level = icl_core::logging::eLL_INFO);
 
   /**
@@ -117,16 +134,58 @@ public:
    * @param silent Optional overwrite to suppress the output into the logstream
    * @return The measurement value in ms
    */
-  static double startStop(std::string timer_name, std::string description, std::string prefix = "",
+  static double startStop(const std::string& timer_name, const std::string& description, const std::string& prefix = "",
                           logging::LogLevel level = icl_core::logging::eLL_INFO, const bool silent = false);
 
+  /**
+   * @brief registerTimer Returns the handle of the timer with the given identifier.
+   * Registering the same identifier again returns the same handle.
+   * @param timer_name The timer's identifier
+   */
+  static TimerHandle registerTimer(const std::string& timer_name);
+
+  /**
+   * @brief registerEvent Returns the handle of the event with the given description and
+   * prefix. Registering the same event again returns the same handle.
+   * @param description The event description
+   * @param prefix Prefix that the event belongs to
+   * @param time_data true for time measurements, false for non-time data
+   */
+  static EventHandle registerEvent(const std::string& description, const std::string& prefix = "",
+                                   const bool time_data = true);
+
+  /**
+   * @brief start Start a registered timer
+   */
+  static void start(const TimerHandle timer);
+
+  /**
+   * @brief measurement Make a measurement from a registered timer without resetting it.
+   * @return The measurement value in ms
+   */
+  static double measurement(const TimerHandle timer, const EventHandle event,
+                            logging::LogLevel level = icl_core::logging::eLL_INFO, const bool silent = false);
+
+  /**
+   * @brief startStop Make a measurement from a registered timer and reset the timer.
+   * If the timer isn't started yet, it just will be started.
+   * @return The measurement value in ms
+   */
+  static double startStop(const TimerHandle timer, const EventHandle event,
+                          logging::LogLevel level = icl_core::logging::eLL_INFO, const bool silent = false);
+
+  /**
+   * @brief addData Adds a value to a registered event.
+   */
+  static void addData(const EventHandle event, double data);
+
   /**
    * @brief addData Manually insert a time measurement with given identifier
    * @param name Timer description
    * @param data Time
    * @param prefix Prefix that the data belongs to.
    */
-  static void addData(std::string name, double data, std::string prefix);
+  static void addData(const std::string& name, double data, const std::string& prefix);
 
   /**
    * @brief addStaticData Adds static information. You can basically put any information
@@ -135,7 +194,7 @@ public:
    * @param data The data itself
    * @param prefix Prefix that the data belongs to.
    */
-  static void addStaticData(std::string name, double data, std::string prefix);
+  static void addStaticData(const std::string& name, double data, const std::string& prefix);
 
   /**
    * @brief addNonTimeData Adds some additional arbitrary information. In contrast to addStaticData
@@ -145,27 +204,27 @@ public:
    * @param data The data itself
    * @param prefix Prefix that the data belongs to.
    */
-  static void addNonTimeData(std::string name, double data, std::string prefix);
+  static void addNonTimeData(const std::string& name, double data, const std::string& prefix);
 
   /**
    * @brief getData Returns all data added under the given prefix and name combination.
    * @param name Short data description
    * @param prefix Prefix that the data belongs to.
    */
-  static std::vector<double> getData(std::string name, std::string prefix);
+  static std::vector<double> getData(const std::string& name, const std::string& prefix);
 
   /**
    * @brief getNonTimeData Returns all nontime data added under the given prefix and name combination.
    * @param name Short data description
    * @param prefix Prefix that the data belongs to.
    */
-  static std::vector<double> getNonTimeData(std::string name, std::string prefix);
+  static std::vector<double> getNonTimeData(const std::string& name, const std::string& prefix);
 
   /**
    * @brief enablePrefix Enables a given prefix
    * @param prefix Prefix that will be enabled.
    */
-  static void enablePrefix(std::string prefix);
+  static void enablePrefix(const std::string& prefix);
 
   /**
    * @brief enableAll set whether all prefixes should be enabled or not. Overrides single
@@ -179,15 +238,17 @@ public:
    * @brief disablePrefix Disables a given prefix
    * @param prefix Prefix that will be disabled.
    */
-  static void disablePrefix(std::string prefix);
+  static void disablePrefix(const std::string& prefix);
 
   /**
-   * @brief printSummary Print a summary for a given collection of events.
+   * @brief printSummary Print a summary for a given collection of events. Besides the
+   * average, median, minimum and maximum, the summary contains the 90th and 99th percentile
+   * and a histogram of the values.
    * @param prefix The prefix in which the events lie.
    * @param name The events' description
    * @param level Optional logging level. Defaults to icl_core::logging::eLL_INFO
    */
-  static std::string printSummary(std::string prefix, std::string name,
+  static std::string printSummary(const std::string& prefix, const std::string& name,
                            icl_core::logging::LogLevel level = icl_core::logging::eLL_INFO);
 
   /**
@@ -204,7 +265,47 @@ public:
    * @param prefix Prefix for which the summary will be printed
    * @param level Optional logging level. Defaults to icl_core::logging::eLL_INFO
    */
-  static std::string printSummaryFromPrefix(std::string prefix, icl_core::logging::LogLevel level = icl_core::logging::eLL_INFO);
+  static std::string printSummaryFromPrefix(const std::string& prefix, icl_core::logging::LogLevel level = icl_core::logging::eLL_INFO);
+
+  /**
+   * @brief exportJson Writes all static data, time data and non-time data of all prefixes
+   * as one JSON object. Every event contains its statistics and all recorded values.
+   * @param filename Output file
+   * @param append If true, the object is appended as a new line, so that several exports
+   * form a JSON Lines file. Otherwise the file is overwritten.
+   * @return false if the file could not be written
+   */
+  static bool exportJson(const std::string& filename, const bool append = false);
+
+  /**
+   * @brief exportCsv Writes all recorded values as CSV with the columns
+   * type, prefix, name, index and value. The type is static, time or non_time.
+   * @param filename Output file, which is overwritten
+   * @return false if the file could not be written
+   */
+  static bool exportCsv(const std::string& filename);
+
+  /**
+   * @brief startTrace Starts writing all time measurements as spans in the Chrome trace
+   * event format, which can be opened with about:tracing or Perfetto. Each thread is
+   * shown as its own track, nested measurements are shown as nested spans. The spans are
+   * written whenever the buffers of the threads are merged, so the trace is not kept in
+   * memory.
+   * @param filename Output file, which is overwritten
+   * @return false if the file could not be opened
+   */
+  static bool startTrace(const std::string& filename);
+
+  /**
+   * @brief stopTrace Writes the remaining spans and closes the trace file.
+   */
+  static void stopTrace();
+
+  /**
+   * @brief releaseThreadBuffer Merges and deletes the buffer of a thread. This is called
+   * automatically when a thread exits.
+   */
+  static void releaseThreadBuffer(ThreadBuffer* buffer);
 
   //! if set to false, the performance monitor will be non-operational
   bool m_enabled;
@@ -217,33 +318,84 @@ protected:
   //! destructor
   ~PerformanceMonitor();
 
-  //! Create output string for summary
-  void createStatisticSummary(std::stringstream& ss, std::string prefix, std::string name);
-  void createStatisticSummaryNonTime(std::stringstream& ss, std::string prefix, std::string name);
-
-
-  //! prints the given message to the specified log level
-  void print(std::string message, icl_core::logging::LogLevel level = icl_core::logging::eLL_DEBUG);
-
-  //! add event to the event map
-  void addEvent(std::string prefix, std::string name, double data);
-  void addNonTimeEvent(std::string prefix, std::string name, double data);
-
-  //! check if prefix is enabled
-  bool isEnabled(std::string prefix);
+  //! Registered event
+  struct EventInfo
+  {
+    std::string prefix;
+    std::string name;
+    bool time_data;
+  };
 
-  //! calculate the average of all events with description name
-  double getAverage(std::string name);
-  double getAverageNonTime(std::string name);
+  //! Writes the spans of the given samples to the trace file, m_mutex has to be locked
+  void writeTraceLocked(ThreadBuffer* buffer, uint64_t tail, const uint64_t head);
 
-  //! calculate the median of all events with description name
-  void getMedian(std::string name, double& median, double& min, double& max);
-  void getMedianNonTime(std::string name, double& median, double& min, double& max);
+  //! Create output string for summary
+  void createStatisticSummary(std::stringstream& ss, const std::string& prefix, const std::string& name,
+                              const bool time_data);
 
-  std::map<std::string, std::vector<double> > m_data;
-  std::map<std::string, std::vector<double> > m_data_nontime;
-  std::map<std::string, TimeStamp> m_timer;
-  std::vector<std::vector<double> > m_buffer;
+  //! prints the given message to the specified log level
+  void print(const std::string& message, icl_core::logging::LogLevel level = icl_core::logging::eLL_DEBUG);
+
+  //! Returns the buffer of the calling thread, which is created on first use
+  ThreadBuffer* getThreadBuffer();
+
+  //! Registers a timer or event, m_mutex has to be locked
+  TimerHandle registerTimerLocked(const std::string& timer_name);
+  EventHandle registerEventLocked(const std::string& prefix, const std::string& name, const bool time_data);
+
+  //! Looks up the handles of names in the cache of the thread and registers unknown names
+  TimerHandle lookupTimer(ThreadBuffer* buffer, const std::string& timer_name);
+  EventHandle lookupEvent(ThreadBuffer* buffer, const std::string& prefix, const std::string& name,
+                          const bool time_data);
+
+  //! check if the prefix of an event is enabled, using the cached flags of the thread
+  bool isEnabled(ThreadBuffer* buffer, const EventHandle event);
+
+  //! check if prefix is enabled, m_mutex has to be locked
+  bool isEnabledLocked(const std::string& prefix);
+
+  //! Recalculates the enabled flags of all events, m_mutex has to be locked
+  void updateEnabledLocked();
+
+  //! add event to the ring buffer of the thread, \a start_ns is the start time of a time measurement
+  void addEvent(ThreadBuffer* buffer, const EventHandle event, double data, const uint64_t start_ns = 0);
+
+  //! measure a timer and add the event, resets the timer if \a reset is set
+  double measure(const TimerHandle timer, const EventHandle event, logging::LogLevel level,
+                 const bool silent, const bool reset);
+
+  //! Moves the values of the ring buffer into m_data, m_mutex has to be locked
+  void mergeLocked(ThreadBuffer* buffer);
+  //! Moves the values of all ring buffers into m_data, m_mutex has to be locked
+  void mergeAllLocked();
+
+  //! Returns a copy of the merged values of an event
+  std::vector<double> getEventData(const std::string& prefix, const std::string& name, const bool time_data);
+
+  //! Guards the registry, the merged data, the prefixes and the list of thread buffers
+  boost::mutex m_mutex;
+
+  //! Handles of the timers and events by name
+  std::map<std::string, TimerHandle> m_timer_handles;
+  std::map<std::string, EventHandle> m_event_handles;
+  std::map<std::string, EventHandle> m_nontime_event_handles;
+  std::vector<EventInfo> m_events;
+  //! Merged values of all events, indexed by event handle
+  std::vector<std::vector<double> > m_data;
+  //! Whether the prefix of an event is enabled, indexed by event handle
+  std::vector<char> m_event_enabled;
+  //! Incremented whenever the registry or the enabled prefixes change
+  boost::atomic<uint32_t> m_generation;
+  //! Number of values that are reserved for new events
+  uint32_t m_num_events;
+
+  std::vector<ThreadBuffer*> m_thread_buffers;
+  uint32_t m_next_thread_id;
+
+  //! Trace file and the time the trace was started
+  std::ofstream m_trace;
+  uint64_t m_trace_start_ns;
+  bool m_trace_first_event;
   std::map<std::string, bool> m_enabled_prefix;
   std::map<std::string, double > m_static_data;
 
@@ -251,6 +403,8 @@ protected:
 
 
 private:
+  static void createInstance();
+
   static PerformanceMonitor* m_instance;
 };
 
@@ -37,6 +37,10 @@
  * with PERF_MON_ENABLE_ALL.
  * Prefixes can be disabled with the PERF_MON_DISABLE again.
  *
+ * For hot paths, timers and events can be registered once with PerformanceMonitor::registerTimer()
+ * and PerformanceMonitor::registerEvent(). The handle macros ending on _H use these handles and
+ * avoid the name lookups.
+ *
  * The documentation in this file is very brief. If you want further information about the performance
  * monitor, please see the header for the performance monitor class.
  */
@@ -102,6 +106,16 @@
   #define PERF_MON_ADD_DATA_NONTIME_P(description, data, prefix) \
     ::icl_core::perf_mon::PerformanceMonitor::addNonTimeData(description, data, prefix);
 
+  //! start a registered timer
+  #define PERF_MON_START_H(timer_handle) \
+    ::icl_core::perf_mon::PerformanceMonitor::start(timer_handle);
+  //! Performs a time measurement of a registered timer for a registered event and resets the timer to 0
+  #define PERF_MON_SILENT_MEASURE_AND_RESET_H(timer_handle, event_handle) \
+    ::icl_core::perf_mon::PerformanceMonitor::startStop(timer_handle, event_handle, ::icl_core::logging::eLL_INFO, true);
+  //! Adds a value to a registered event
+  #define PERF_MON_ADD_DATA_H(event_handle, data) \
+    ::icl_core::perf_mon::PerformanceMonitor::addData(event_handle, data);
+
   //! Print summary of all timers from a given prefix and the given description
   #define PERF_MON_SUMMARY_INFO(prefix, description) \
     ::icl_core::perf_mon::PerformanceMonitor::printSummary(prefix, description, ::icl_core::logging::eLL_INFO);
@@ -112,6 +126,22 @@
   #define PERF_MON_SUMMARY_ALL_INFO \
     ::icl_core::perf_mon::PerformanceMonitor::printSummaryAll(::icl_core::logging::eLL_INFO);
 
+  //! Write all data as JSON object into the given file
+  #define PERF_MON_EXPORT_JSON(filename) \
+    ::icl_core::perf_mon::PerformanceMonitor::exportJson(filename);
+  //! Append all data as one line of JSON to the given file
+  #define PERF_MON_APPEND_JSON(filename) \
+    ::icl_core::perf_mon::PerformanceMonitor::exportJson(filename, true);
+  //! Write all values as CSV into the given file
+  #define PERF_MON_EXPORT_CSV(filename) \
+    ::icl_core::perf_mon::PerformanceMonitor::exportCsv(filename);
+  //! Start writing all time measurements into a Chrome trace file
+  #define PERF_MON_START_TRACE(filename) \
+    ::icl_core::perf_mon::PerformanceMonitor::startTrace(filename);
+  //! Finish the Chrome trace file
+  #define PERF_MON_STOP_TRACE \
+    ::icl_core::perf_mon::PerformanceMonitor::stopTrace();
+
 
   // The following macros are the same as above, but for the DEBUG and TRACE case.
   #ifdef _IC_DEBUG_
@@ -220,6 +250,14 @@
   #define PERF_MON_ADD_DATA_P(description, data, prefix) (void)0
   #define PERF_MON_ADD_DATA_NONTIME(description, data) (void)0
   #define PERF_MON_ADD_DATA_NONTIME_P(description, data, prefix) (void)0
+  #define PERF_MON_START_H(timer_handle) (void)0
+  #define PERF_MON_SILENT_MEASURE_AND_RESET_H(timer_handle, event_handle) (void)0
+  #define PERF_MON_ADD_DATA_H(event_handle, data) (void)0
+  #define PERF_MON_EXPORT_JSON(filename) (void)0
+  #define PERF_MON_APPEND_JSON(filename) (void)0
+  #define PERF_MON_EXPORT_CSV(filename) (void)0
+  #define PERF_MON_START_TRACE(filename) (void)0
+  #define PERF_MON_STOP_TRACE (void)0
 #endif
 
 #endif // PERFORMANCEMONITORMACROS_H
@@ -50,6 +50,15 @@ int main(int argc, char* argv[])
 
   PERF_MON_PRINT_INFO_P("all", "over", "all_prefix");
 
+  // register timers and events once for hot loops
+  const TimerHandle loop_timer = PerformanceMonitor::registerTimer("loop_timer");
+  const EventHandle loop_event = PerformanceMonitor::registerEvent("loop", "all_prefix");
+  PERF_MON_START_H(loop_timer);
+  for (size_t i=0; i < 1000; ++i)
+  {
+    PERF_MON_SILENT_MEASURE_AND_RESET_H(loop_timer, loop_event);
+  }
+
   PERF_MON_SUMMARY_ALL_INFO;
   return 0;
 }
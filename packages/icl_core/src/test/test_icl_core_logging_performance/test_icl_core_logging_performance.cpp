@@ -21,6 +21,11 @@
  *
  */
 //----------------------------------------------------------------------
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <icl_core/BaseTypes.h>
 #include <icl_core/internal_raw_debug.h>
 #include <icl_core/os_lxrt.h>
@@ -34,21 +39,95 @@ REGISTER_LOG_STREAM(PerformanceTest)
 using icl_core::logging::Default;
 using icl_core::logging::endl;
 
+/*! Logs \a message_count messages from one producer thread and
+ *  stores the time it took in \a duration.
+ */
+void logMessages(bool async, size_t thread_index, size_t message_count, icl_core::TimeSpan *duration)
+{
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  if (async)
+  {
+    for (size_t i = 0; i < message_count; ++i)
+    {
+      LOGGING_ASYNC_INFO(PerformanceTest, "Thread %u test loop %u\n", thread_index, i);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < message_count; ++i)
+    {
+      LOGGING_INFO(PerformanceTest, "Thread " << thread_index << " test loop " << i << endl);
+    }
+  }
+  *duration = icl_core::TimeStamp::now() - start;
+}
+
+/*! Logs \a message_count messages, which are evenly distributed over
+ *  \a thread_count producer threads, and reports the average time a
+ *  producer spends per message and the overall throughput.  For
+ *  asynchronous logging the throughput includes formatting all
+ *  messages in the worker thread.
+ */
+void runBenchmark(bool async, size_t thread_count, size_t message_count)
+{
+  const size_t messages_per_thread = message_count / thread_count;
+  std::vector<icl_core::TimeSpan> durations(thread_count);
+
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  boost::thread_group producers;
+  for (size_t t = 0; t < thread_count; ++t)
+  {
+    producers.create_thread(boost::bind(&logMessages, async, t, messages_per_thread, &durations[t]));
+  }
+  producers.join_all();
+  if (async)
+  {
+    icl_core::logging::AsyncLogging::instance().flush();
+  }
+  const double total_s = (icl_core::TimeStamp::now() - start).toNSec() * 1e-9;
+
+  double producer_ns = 0.;
+  for (size_t t = 0; t < thread_count; ++t)
+  {
+    producer_ns += durations[t].toNSec();
+  }
+  const size_t total_messages = messages_per_thread * thread_count;
+  LOGGING_INFO(Default, (async ? "async" : "sync ") << " logging, " << thread_count << " producer threads: "
+               << producer_ns / total_messages << " ns per message, "
+               << total_messages / total_s << " messages per second" << endl);
+}
+
 int main(int argc, char *argv[])
 {
   icl_core::os::lxrtStartup();
 
   icl_core::config::addParameter(icl_core::config::ConfigParameter("message-count:", "c", "/TestLogging/MessageCount", "Number of messages to be logged."));
+  icl_core::config::addParameter(icl_core::config::ConfigParameter("max-threads:", "t", "/TestLogging/MaxThreads", "Benchmark synchronous and asynchronous logging with 1, 2, 4, ... up to this number of producer threads (0 disables the benchmark)."));
 
   icl_core::logging::initialize(argc, argv);
 
   size_t message_count = icl_core::config::getDefault<size_t>("/TestLogging/MessageCount", 100000);
+  size_t max_threads = icl_core::config::getDefault<size_t>("/TestLogging/MaxThreads", 16);
 
   LOGGING_INFO(Default, "Running performance test with " << message_count << " iterations..." << endl);
   for (size_t i = 0; i < message_count; ++i)
   {
     LOGGING_INFO(PerformanceTest, "Test loop " << i << endl);
   }
+
+  if (max_threads > 0)
+  {
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+      runBenchmark(false, thread_count, message_count);
+    }
+    icl_core::logging::AsyncLogging::instance().start();
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+      runBenchmark(true, thread_count, message_count);
+    }
+    icl_core::logging::AsyncLogging::instance().stop();
+  }
   LOGGING_INFO(Default, "Performance test finished." << endl);
 
   icl_core::logging::tLoggingManager::instance().shutdown();
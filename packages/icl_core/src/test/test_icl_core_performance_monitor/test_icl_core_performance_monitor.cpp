@@ -0,0 +1,152 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Measures the overhead of recording samples with the
+ * PerformanceMonitor, by name and through registered handles, from one
+ * and from several threads.
+ *
+ */
+//----------------------------------------------------------------------
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <icl_core/TimeSpan.h>
+#include <icl_core/TimeStamp.h>
+#include <icl_core/os_lxrt.h>
+#include <icl_core_config/Config.h>
+#include <icl_core_logging/Logging.h>
+#include <icl_core_performance_monitor/PerformanceMonitor.h>
+
+using icl_core::logging::Default;
+using icl_core::logging::endl;
+using icl_core::perf_mon::EventHandle;
+using icl_core::perf_mon::PerformanceMonitor;
+using icl_core::perf_mon::TimerHandle;
+
+enum Operation
+{
+  eADD_DATA_BY_NAME,
+  eADD_DATA_BY_HANDLE,
+  eSTART_STOP_BY_HANDLE
+};
+
+const char* operationName(Operation operation)
+{
+  switch (operation)
+  {
+    case eADD_DATA_BY_NAME: return "addData by name     ";
+    case eADD_DATA_BY_HANDLE: return "addData by handle   ";
+    case eSTART_STOP_BY_HANDLE: return "startStop by handle ";
+  }
+  return "";
+}
+
+/*! Records \a sample_count samples from one thread and stores the
+ *  time it took in \a duration.
+ */
+void recordSamples(Operation operation, size_t sample_count, icl_core::TimeSpan *duration)
+{
+  const TimerHandle timer = PerformanceMonitor::registerTimer("benchmark_timer");
+  const EventHandle event = PerformanceMonitor::registerEvent("benchmark", "benchmark");
+  PerformanceMonitor::start(timer);
+
+  icl_core::TimeStamp start = icl_core::TimeStamp::now();
+  switch (operation)
+  {
+    case eADD_DATA_BY_NAME:
+      for (size_t i = 0; i < sample_count; ++i)
+      {
+        PerformanceMonitor::addData("benchmark", 1.0, "benchmark");
+      }
+      break;
+    case eADD_DATA_BY_HANDLE:
+      for (size_t i = 0; i < sample_count; ++i)
+      {
+        PerformanceMonitor::addData(event, 1.0);
+      }
+      break;
+    case eSTART_STOP_BY_HANDLE:
+      for (size_t i = 0; i < sample_count; ++i)
+      {
+        PerformanceMonitor::startStop(timer, event, icl_core::logging::eLL_INFO, true);
+      }
+      break;
+  }
+  *duration = icl_core::TimeStamp::now() - start;
+}
+
+/*! Records \a sample_count samples, which are evenly distributed over
+ *  \a thread_count threads, and reports the average time a thread
+ *  spends per sample. The time includes merging full ring buffers.
+ */
+void runBenchmark(Operation operation, size_t thread_count, size_t sample_count)
+{
+  // drop the samples of the previous run
+  PerformanceMonitor::initialize(10, 0);
+  PerformanceMonitor::enablePrefix("benchmark");
+
+  const size_t samples_per_thread = sample_count / thread_count;
+  std::vector<icl_core::TimeSpan> durations(thread_count);
+
+  boost::thread_group threads;
+  for (size_t t = 0; t < thread_count; ++t)
+  {
+    threads.create_thread(boost::bind(&recordSamples, operation, samples_per_thread, &durations[t]));
+  }
+  threads.join_all();
+
+  double thread_ns = 0.;
+  for (size_t t = 0; t < thread_count; ++t)
+  {
+    thread_ns += durations[t].toNSec();
+  }
+  const size_t total_samples = samples_per_thread * thread_count;
+  const size_t recorded_samples = PerformanceMonitor::getData("benchmark", "benchmark").size();
+  LOGGING_INFO(Default, operationName(operation) << thread_count << " threads: "
+               << thread_ns / total_samples << " ns per sample"
+               << (recorded_samples == total_samples ? "" : ", SAMPLES MISSING!") << endl);
+}
+
+int main(int argc, char *argv[])
+{
+  icl_core::os::lxrtStartup();
+
+  icl_core::config::addParameter(icl_core::config::ConfigParameter("sample-count:", "c", "/TestPerformanceMonitor/SampleCount", "Number of samples to be recorded per run."));
+  icl_core::config::addParameter(icl_core::config::ConfigParameter("max-threads:", "t", "/TestPerformanceMonitor/MaxThreads", "Run the benchmark with 1, 2, 4, ... up to this number of threads."));
+
+  icl_core::logging::initialize(argc, argv);
+
+  size_t sample_count = icl_core::config::getDefault<size_t>("/TestPerformanceMonitor/SampleCount", 4000000);
+  size_t max_threads = icl_core::config::getDefault<size_t>("/TestPerformanceMonitor/MaxThreads", 8);
+
+  const Operation operations[] = { eADD_DATA_BY_NAME, eADD_DATA_BY_HANDLE, eSTART_STOP_BY_HANDLE };
+  for (size_t o = 0; o < sizeof(operations) / sizeof(operations[0]); ++o)
+  {
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+      runBenchmark(operations[o], thread_count, sample_count);
+    }
+  }
+
+  icl_core::logging::tLoggingManager::instance().shutdown();
+  icl_core::os::lxrtShutdown();
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Tests the formatting of asynchronous log records, which adapts the
+ * conversion specifications to the stored argument types.
+ *
+ */
+//----------------------------------------------------------------------
+#include <icl_core_logging/AsyncLogging.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+using icl_core::logging::AsyncLogRecord;
+
+namespace {
+
+//! Records are too large for the stack of the test runner.
+class RecordFixture
+{
+public:
+  RecordFixture()
+    : record(new AsyncLogRecord)
+  {
+    record->number_of_arguments = 0;
+    record->strings_size = 0;
+    record->objectname_offset = record->addString("", 0);
+  }
+
+  template <typename T>
+  void addArgument(const T& value)
+  {
+    record->setArgument(record->arguments[record->number_of_arguments++], value);
+  }
+
+  std::string format(const char *format)
+  {
+    char buffer[256];
+    record->format = format;
+    const size_t length = record->formatText(buffer, sizeof(buffer));
+    return std::string(buffer, length);
+  }
+
+  boost::scoped_ptr<AsyncLogRecord> record;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(ts_AsyncLogging, RecordFixture)
+
+BOOST_AUTO_TEST_CASE(MatchingArguments)
+{
+  addArgument(int(-42));
+  addArgument(unsigned(42));
+  addArgument(1.5);
+  addArgument("text");
+  addArgument(std::string("string"));
+  BOOST_CHECK_EQUAL(format("%d %u %.2f %s %s"), "-42 42 1.50 text string");
+}
+
+BOOST_AUTO_TEST_CASE(LengthModifiersAreIgnored)
+{
+  addArgument(int(-1));
+  addArgument(uint64_t(12345678901ull));
+  addArgument(short(255));
+  BOOST_CHECK_EQUAL(format("%ld %llu %hx"), "-1 12345678901 ff");
+}
+
+BOOST_AUTO_TEST_CASE(MismatchedArguments)
+{
+  addArgument(int(-7));
+  addArgument(unsigned(7));
+  addArgument(2.5);
+  addArgument("text");
+  addArgument(int(3));
+  addArgument(unsigned(65));
+  BOOST_CHECK_EQUAL(format("%s %s %d %d %f %c"), "-7 7 2.500000 text 3.000000 A");
+}
+
+BOOST_AUTO_TEST_CASE(MissingArguments)
+{
+  addArgument(int(1));
+  BOOST_CHECK_EQUAL(format("%d %s %% %5"), "1 %s % %5");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
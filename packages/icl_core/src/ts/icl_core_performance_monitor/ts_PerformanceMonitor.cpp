@@ -0,0 +1,339 @@
+// this is for emacs file handling -*- mode: c++; indent-tabs-mode: nil -*-
+
+// -- BEGIN LICENSE BLOCK ----------------------------------------------
+// This file is part of the IC Workspace.
+//
+// This program is free software licensed under the CDDL
+// (COMMON DEVELOPMENT AND DISTRIBUTION LICENSE Version 1.0).
+// You can find a copy of this license in LICENSE.txt in the top
+// directory of the source code.
+//
+// © Copyright 2014 FZI Forschungszentrum Informatik, Karlsruhe, Germany
+//
+
+// -- END LICENSE BLOCK ------------------------------------------------
+
+//----------------------------------------------------------------------
+/*!\file
+ *
+ * Tests of the thread safe recording and the exports of the
+ * PerformanceMonitor. The overhead benchmark is in
+ * test/test_icl_core_performance_monitor.
+ *
+ */
+//----------------------------------------------------------------------
+#include <icl_core_performance_monitor/PerformanceMonitor.h>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using boost::property_tree::ptree;
+using icl_core::perf_mon::EventHandle;
+using icl_core::perf_mon::PerformanceMonitor;
+
+namespace {
+
+const std::string cPREFIX = "ts_performance_monitor";
+const size_t cNUM_THREADS = 8;
+// more than the ring buffer of a thread holds, so full buffers get merged while recording
+const size_t cNUM_SAMPLES = 50000;
+
+std::string threadEventName(const size_t thread)
+{
+  return "thread_" + boost::lexical_cast<std::string>(thread);
+}
+
+void recordSamples(const size_t thread, const EventHandle shared_event)
+{
+  const std::string own_name = threadEventName(thread);
+  for (size_t i = 0; i < cNUM_SAMPLES; ++i)
+  {
+    PerformanceMonitor::addData("shared", 1.0, cPREFIX);
+    PerformanceMonitor::addData(shared_event, 2.0);
+    PerformanceMonitor::addData(own_name, double(thread), cPREFIX);
+    PerformanceMonitor::addNonTimeData(own_name, double(i), cPREFIX);
+  }
+}
+
+void recordOneSample(const EventHandle event)
+{
+  PerformanceMonitor::addData(event, 1.0);
+}
+
+double sum(const std::vector<double>& values)
+{
+  return std::accumulate(values.begin(), values.end(), 0.0);
+}
+
+const std::string cEXPORT_PREFIX = "ts_performance_monitor_export";
+const size_t cNUM_EXPORT_THREADS = 2;
+const size_t cNUM_OUTER = 20;
+const size_t cNUM_INNER = 3;
+
+//! Each outer measurement encloses cNUM_INNER inner ones of the same thread
+void recordNestedTimers()
+{
+  for (size_t i = 0; i < cNUM_OUTER; ++i)
+  {
+    PerformanceMonitor::start("outer");
+    for (size_t j = 0; j < cNUM_INNER; ++j)
+    {
+      PerformanceMonitor::start("inner");
+      PerformanceMonitor::startStop("inner", "inner", cEXPORT_PREFIX, icl_core::logging::eLL_INFO, true);
+    }
+    PerformanceMonitor::startStop("outer", "outer", cEXPORT_PREFIX, icl_core::logging::eLL_INFO, true);
+  }
+}
+
+size_t countLines(const std::string& filename)
+{
+  std::ifstream file(filename.c_str());
+  return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
+}
+
+//! Finds the event of the export prefix with the given name in the "time" or "non_time" array
+const ptree* findEvent(const ptree& json, const std::string& array, const std::string& name)
+{
+  BOOST_FOREACH(const ptree::value_type& event, json.get_child(array))
+  {
+    if (event.second.get<std::string>("prefix") == cEXPORT_PREFIX && event.second.get<std::string>("name") == name)
+    {
+      return &event.second;
+    }
+  }
+  return NULL;
+}
+
+//! A span of the trace in microseconds
+struct Span
+{
+  double begin;
+  double end;
+
+  bool operator < (const Span& other) const
+  {
+    // enclosing spans first
+    return begin < other.begin || (begin == other.begin && end > other.end);
+  }
+};
+
+/*! Records nested timers from two threads with an active trace and a NaN value, which
+ *  has to be exported as null.
+ */
+class ExportFixture
+{
+public:
+  ExportFixture()
+    : json_file("ts_performance_monitor_export.json"),
+      csv_file("ts_performance_monitor_export.csv"),
+      trace_file("ts_performance_monitor_export_trace.json")
+  {
+    PerformanceMonitor::initialize(100, 1000);
+    PerformanceMonitor::enablePrefix(cEXPORT_PREFIX);
+    BOOST_REQUIRE(PerformanceMonitor::startTrace(trace_file));
+
+    boost::thread_group threads;
+    for (size_t t = 0; t < cNUM_EXPORT_THREADS; ++t)
+    {
+      threads.create_thread(&recordNestedTimers);
+    }
+    threads.join_all();
+    PerformanceMonitor::stopTrace();
+
+    PerformanceMonitor::addNonTimeData("degenerate", NAN, cEXPORT_PREFIX);
+    PerformanceMonitor::addNonTimeData("degenerate", 0.1, cEXPORT_PREFIX);
+  }
+
+  ~ExportFixture()
+  {
+    std::remove(json_file.c_str());
+    std::remove(csv_file.c_str());
+    std::remove(trace_file.c_str());
+  }
+
+  std::string json_file;
+  std::string csv_file;
+  std::string trace_file;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(ts_PerformanceMonitor)
+
+BOOST_AUTO_TEST_CASE(MultiThreadTotals)
+{
+  PerformanceMonitor::initialize(100, 1000);
+  PerformanceMonitor::enablePrefix(cPREFIX);
+  const EventHandle shared_event = PerformanceMonitor::registerEvent("shared_handle", cPREFIX);
+
+  boost::thread_group threads;
+  for (size_t t = 0; t < cNUM_THREADS; ++t)
+  {
+    threads.create_thread(boost::bind(&recordSamples, t, shared_event));
+  }
+  threads.join_all();
+
+  const std::vector<double> shared = PerformanceMonitor::getData("shared", cPREFIX);
+  BOOST_CHECK_EQUAL(shared.size(), cNUM_THREADS * cNUM_SAMPLES);
+  BOOST_CHECK_EQUAL(sum(shared), double(cNUM_THREADS * cNUM_SAMPLES));
+
+  const std::vector<double> shared_handle = PerformanceMonitor::getData("shared_handle", cPREFIX);
+  BOOST_CHECK_EQUAL(shared_handle.size(), cNUM_THREADS * cNUM_SAMPLES);
+  BOOST_CHECK_EQUAL(sum(shared_handle), 2.0 * double(cNUM_THREADS * cNUM_SAMPLES));
+
+  for (size_t t = 0; t < cNUM_THREADS; ++t)
+  {
+    const std::vector<double> own = PerformanceMonitor::getData(threadEventName(t), cPREFIX);
+    BOOST_CHECK_EQUAL(own.size(), cNUM_SAMPLES);
+    BOOST_CHECK_EQUAL(sum(own), double(t * cNUM_SAMPLES));
+
+    // the values of one thread keep their order
+    const std::vector<double> non_time = PerformanceMonitor::getNonTimeData(threadEventName(t), cPREFIX);
+    BOOST_REQUIRE_EQUAL(non_time.size(), cNUM_SAMPLES);
+    for (size_t i = 0; i < cNUM_SAMPLES; ++i)
+    {
+      if (non_time[i] != double(i))
+      {
+        BOOST_ERROR("Non-time value " << i << " of " << threadEventName(t) << " is " << non_time[i]);
+        break;
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DisabledPrefixIsNotRecorded)
+{
+  PerformanceMonitor::initialize(100, 1000);
+  PerformanceMonitor::disablePrefix("ts_performance_monitor_disabled");
+  const EventHandle event = PerformanceMonitor::registerEvent("event", "ts_performance_monitor_disabled");
+
+  boost::thread_group threads;
+  for (size_t t = 0; t < cNUM_THREADS; ++t)
+  {
+    threads.create_thread(boost::bind(&recordOneSample, event));
+  }
+  threads.join_all();
+
+  BOOST_CHECK(PerformanceMonitor::getData("event", "ts_performance_monitor_disabled").empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(ExportJson, ExportFixture)
+{
+  BOOST_REQUIRE(PerformanceMonitor::exportJson(json_file));
+  BOOST_CHECK_EQUAL(countLines(json_file), 1u);
+
+  ptree json;
+  BOOST_REQUIRE_NO_THROW(boost::property_tree::read_json(json_file, json));
+
+  const ptree* outer = findEvent(json, "time", "outer");
+  const ptree* inner = findEvent(json, "time", "inner");
+  BOOST_REQUIRE(outer != NULL && inner != NULL);
+  BOOST_CHECK_EQUAL(outer->get<size_t>("count"), cNUM_EXPORT_THREADS * cNUM_OUTER);
+  BOOST_CHECK_EQUAL(outer->get_child("values").size(), cNUM_EXPORT_THREADS * cNUM_OUTER);
+  BOOST_CHECK_EQUAL(inner->get<size_t>("count"), cNUM_EXPORT_THREADS * cNUM_OUTER * cNUM_INNER);
+  BOOST_CHECK_EQUAL(inner->get_child("values").size(), cNUM_EXPORT_THREADS * cNUM_OUTER * cNUM_INNER);
+  BOOST_CHECK_EQUAL(outer->get<std::string>("unit"), "ms");
+
+  // non-finite values are no JSON numbers
+  const ptree* degenerate = findEvent(json, "non_time", "degenerate");
+  BOOST_REQUIRE(degenerate != NULL);
+  BOOST_CHECK_EQUAL(degenerate->get<size_t>("count"), 2u);
+  BOOST_CHECK_EQUAL(degenerate->get<std::string>("avg"), "null");
+  std::vector<std::string> values;
+  BOOST_FOREACH(const ptree::value_type& value, degenerate->get_child("values"))
+  {
+    values.push_back(value.second.data());
+  }
+  BOOST_REQUIRE_EQUAL(values.size(), 2u);
+  BOOST_CHECK(std::find(values.begin(), values.end(), "null") != values.end());
+  // the values keep all digits
+  BOOST_CHECK(std::find(values.begin(), values.end(), "0.10000000000000001") != values.end());
+
+  // every append adds one object as a line
+  BOOST_REQUIRE(PerformanceMonitor::exportJson(json_file, true));
+  BOOST_CHECK_EQUAL(countLines(json_file), 2u);
+}
+
+BOOST_FIXTURE_TEST_CASE(ExportCsv, ExportFixture)
+{
+  BOOST_REQUIRE(PerformanceMonitor::exportCsv(csv_file));
+
+  std::ifstream file(csv_file.c_str());
+  std::string line;
+  std::getline(file, line);
+  BOOST_CHECK_EQUAL(line, "type,prefix,name,index,value");
+  std::map<std::string, size_t> rows;
+  while (std::getline(file, line))
+  {
+    const std::string start = "time," + cEXPORT_PREFIX + ",";
+    if (line.compare(0, start.size(), start) == 0)
+    {
+      rows[line.substr(start.size(), line.find(',', start.size()) - start.size())]++;
+    }
+  }
+  BOOST_CHECK_EQUAL(rows.size(), 2u);
+  BOOST_CHECK_EQUAL(rows["outer"], cNUM_EXPORT_THREADS * cNUM_OUTER);
+  BOOST_CHECK_EQUAL(rows["inner"], cNUM_EXPORT_THREADS * cNUM_OUTER * cNUM_INNER);
+}
+
+BOOST_FIXTURE_TEST_CASE(Trace, ExportFixture)
+{
+  ptree trace;
+  BOOST_REQUIRE_NO_THROW(boost::property_tree::read_json(trace_file, trace));
+
+  std::map<std::string, std::vector<Span> > tracks;
+  std::map<std::string, size_t> num_spans;
+  BOOST_FOREACH(const ptree::value_type& event, trace)
+  {
+    if (event.second.get<std::string>("cat") != cEXPORT_PREFIX)
+    {
+      continue;
+    }
+    BOOST_CHECK_EQUAL(event.second.get<std::string>("ph"), "X");
+    Span span;
+    span.begin = event.second.get<double>("ts");
+    span.end = span.begin + event.second.get<double>("dur");
+    tracks[event.second.get<std::string>("tid")].push_back(span);
+    num_spans[event.second.get<std::string>("name")]++;
+  }
+  BOOST_CHECK_EQUAL(num_spans["outer"], cNUM_EXPORT_THREADS * cNUM_OUTER);
+  BOOST_CHECK_EQUAL(num_spans["inner"], cNUM_EXPORT_THREADS * cNUM_OUTER * cNUM_INNER);
+
+  // one track per thread, on which the spans don't overlap partially
+  BOOST_REQUIRE_EQUAL(tracks.size(), cNUM_EXPORT_THREADS);
+  for (std::map<std::string, std::vector<Span> >::iterator it = tracks.begin(); it != tracks.end(); ++it)
+  {
+    BOOST_CHECK_EQUAL(it->second.size(), cNUM_OUTER * (1 + cNUM_INNER));
+    std::vector<Span>& spans = it->second;
+    std::sort(spans.begin(), spans.end());
+    std::vector<Span> open;
+    // the time stamps are rounded to ns
+    const double tolerance = 0.002;
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+      while (!open.empty() && open.back().end <= spans[i].begin + tolerance)
+      {
+        open.pop_back();
+      }
+      BOOST_CHECK_MESSAGE(open.empty() || spans[i].end <= open.back().end + tolerance,
+                          "Span " << i << " of track " << it->first << " overlaps its parent");
+      open.push_back(spans[i]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()